@@ -0,0 +1,39 @@
+#define UPIPE_HAVE_ATOMIC_OPS 1
+#define UPIPE_HAVE_DECL_STRERROR_R 1
+#define UPIPE_HAVE_DLFCN_H 1
+#define UPIPE_HAVE_EVENTFD 1
+#define UPIPE_HAVE_EV_H 1
+#define UPIPE_HAVE_FCNTL_H 1
+#define UPIPE_HAVE_FEATURES_H 1
+#define UPIPE_HAVE_GL_GLU_H 1
+#define UPIPE_HAVE_GL_GLX_H 1
+#define UPIPE_HAVE_GL_GL_H 1
+#define UPIPE_HAVE_ICONV 1
+#define UPIPE_HAVE_INTTYPES_H 1
+#define UPIPE_HAVE_MALLOC 1
+#define UPIPE_HAVE_MEMMOVE 1
+#define UPIPE_HAVE_MEMSET 1
+#define UPIPE_HAVE_NET_IF_H 1
+#define UPIPE_HAVE_PIPE 1
+#define UPIPE_HAVE_PTHREAD_PRIO_INHERIT 1
+#define UPIPE_HAVE_PTRDIFF_T 1
+#define UPIPE_HAVE_REALLOC 1
+#define UPIPE_HAVE_RECVMMSG 1
+#define UPIPE_HAVE_SEMAPHORE_H 1
+#define UPIPE_HAVE_SENDMMSG 1
+#define UPIPE_HAVE_STDBOOL_H 1
+#define UPIPE_HAVE_STDDEF_H 1
+#define UPIPE_HAVE_STDINT_H 1
+#define UPIPE_HAVE_STDIO_H 1
+#define UPIPE_HAVE_STDLIB_H 1
+#define UPIPE_HAVE_STRDUP 1
+#define UPIPE_HAVE_STRERROR_R 1
+#define UPIPE_HAVE_STRINGS_H 1
+#define UPIPE_HAVE_STRING_H 1
+#define UPIPE_HAVE_STRUCT_TIMESPEC 1
+#define UPIPE_HAVE_SYS_IOCTL_H 1
+#define UPIPE_HAVE_SYS_STAT_H 1
+#define UPIPE_HAVE_SYS_TYPES_H 1
+#define UPIPE_HAVE_UNISTD_H 1
+#define UPIPE_HAVE_WCHAR_H 1
+#define UPIPE_HAVE__BOOL 1
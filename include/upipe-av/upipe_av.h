@@ -32,10 +32,24 @@
 extern "C" {
 #endif
 
+#include <upipe/ubase.h>
+#include <upipe/uprobe.h>
+
 #include <stdbool.h>
 
-/** @hidden */
-struct uprobe;
+/** @This is the signature of the events thrown by the common functions of
+ * libav wrappers. */
+#define UPIPE_AV_SIGNATURE UBASE_FOURCC('u','p','a','v')
+
+/** @This extends @ref uprobe_event with specific events for the common
+ * functions of libav wrappers, thrown to the probe given to
+ * @ref upipe_av_init. */
+enum uprobe_av_event {
+    UPROBE_AV_SENTINEL = UPROBE_LOCAL,
+
+    /** the threads budget changed (unsigned int, unsigned int) */
+    UPROBE_AV_THREADS_BUDGET
+};
 
 /** @This initializes non-reentrant parts of avcodec and avformat. Call it
  * before allocating managers from this library.
@@ -52,6 +66,43 @@ bool upipe_av_init(bool init_avcodec_only, struct uprobe *uprobe);
  */
 void upipe_av_clean(void);
 
+/** @This defines the types of threading of avcodec contexts, which may be
+ * combined. */
+enum upipe_av_thread_type {
+    /** process several frames at once (adds one frame of latency per
+     * additional thread) */
+    UPIPE_AV_THREAD_FRAME = 0x1,
+    /** process several slices of a frame at once */
+    UPIPE_AV_THREAD_SLICE = 0x2
+};
+
+/** @This sets the maximum number of threads that all avcodec contexts of
+ * the process may use together. Each codec opened afterwards is given at
+ * most the budget divided by the number of codecs expected to share it (or
+ * by the number of opened codecs if it is larger), and never more than what
+ * is left of the budget. When the budget is exhausted, codecs are opened
+ * without threads and their pipes warn about it. Codecs which are already
+ * opened keep their threads until they are closed; the application may
+ * reopen them when it catches @ref UPROBE_AV_THREADS_BUDGET, which is thrown
+ * to the probe given to @ref upipe_av_init.
+ *
+ * @param threads number of threads, or 0 for no limit (default)
+ * @param codecs number of codecs expected to share the budget
+ */
+void upipe_av_set_threads_budget(unsigned int threads, unsigned int codecs);
+
+/** @This returns the maximum number of threads that all avcodec contexts of
+ * the process may use together.
+ *
+ * @param used_p filled in with the number of threads currently given to
+ * opened codecs (may be NULL)
+ * @param codecs_p filled in with the number of opened codecs holding
+ * threads from the budget (may be NULL)
+ * @return number of threads, or 0 for no limit
+ */
+unsigned int upipe_av_get_threads_budget(unsigned int *used_p,
+                                         unsigned int *codecs_p);
+
 #ifdef __cplusplus
 }
 #endif
@@ -36,6 +36,7 @@ extern "C" {
 #endif
 
 #include <upipe/upipe.h>
+#include <upipe-av/upipe_av.h>
 
 #define UPIPE_AVCDEC_SIGNATURE UBASE_FOURCC('a', 'v', 'c', 'd')
 
@@ -45,6 +46,61 @@ extern "C" {
  */
 struct upipe_mgr *upipe_avcdec_mgr_alloc(void);
 
+/** @This extends upipe_command with specific commands for avcdec. */
+enum upipe_avcdec_command {
+    UPIPE_AVCDEC_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** sets the threading of the codec (int, unsigned int) */
+    UPIPE_AVCDEC_SET_THREADS,
+    /** returns the threading of the codec (int *, unsigned int *) */
+    UPIPE_AVCDEC_GET_THREADS
+};
+
+/** @This extends @ref uprobe_event with specific events for avcdec. */
+enum uprobe_avcdec_event {
+    UPROBE_AVCDEC_SENTINEL = UPROBE_LOCAL,
+
+    /** the codec was opened with a different threading than before, or
+     * without threads because the threads budget was exhausted
+     * (int, unsigned int) */
+    UPROBE_AVCDEC_THREADS
+};
+
+/** @This sets the threading of the codec. It must be called before the
+ * codec is opened, and the number of threads may be reduced by the budget
+ * set with @ref upipe_av_set_threads_budget.
+ *
+ * @param upipe description structure of the pipe
+ * @param thread_type types of threading (@ref upipe_av_thread_type), or 0
+ * for the default of avcodec
+ * @param threads number of threads, or 0 for the default of avcodec
+ * @return an error code
+ */
+static inline int upipe_avcdec_set_threads(struct upipe *upipe,
+                                           int thread_type,
+                                           unsigned int threads)
+{
+    return upipe_control(upipe, UPIPE_AVCDEC_SET_THREADS,
+                         UPIPE_AVCDEC_SIGNATURE, thread_type, threads);
+}
+
+/** @This returns the threading of the codec, as used by avcodec once the
+ * codec is opened, or as requested before.
+ *
+ * @param upipe description structure of the pipe
+ * @param thread_type_p filled in with the types of threading
+ * (@ref upipe_av_thread_type)
+ * @param threads_p filled in with the number of threads
+ * @return an error code
+ */
+static inline int upipe_avcdec_get_threads(struct upipe *upipe,
+                                           int *thread_type_p,
+                                           unsigned int *threads_p)
+{
+    return upipe_control(upipe, UPIPE_AVCDEC_GET_THREADS,
+                         UPIPE_AVCDEC_SIGNATURE, thread_type_p, threads_p);
+}
+
 #ifdef __cplusplus
 }
 #endif
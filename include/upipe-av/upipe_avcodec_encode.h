@@ -36,6 +36,7 @@ extern "C" {
 #endif
 
 #include <upipe/upipe.h>
+#include <upipe-av/upipe_av.h>
 #include <upipe/uref_attr.h>
 
 #define UPIPE_AVCENC_SIGNATURE UBASE_FOURCC('a', 'v', 'c', 'e')
@@ -48,6 +49,61 @@ UREF_ATTR_STRING(avcenc, codec_name, "avcenc.name", avcenc codec name)
  */
 struct upipe_mgr *upipe_avcenc_mgr_alloc(void);
 
+/** @This extends upipe_command with specific commands for avcenc. */
+enum upipe_avcenc_command {
+    UPIPE_AVCENC_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** sets the threading of the codec (int, unsigned int) */
+    UPIPE_AVCENC_SET_THREADS,
+    /** returns the threading of the codec (int *, unsigned int *) */
+    UPIPE_AVCENC_GET_THREADS
+};
+
+/** @This extends @ref uprobe_event with specific events for avcenc. */
+enum uprobe_avcenc_event {
+    UPROBE_AVCENC_SENTINEL = UPROBE_LOCAL,
+
+    /** the codec was opened with a different threading than before, or
+     * without threads because the threads budget was exhausted
+     * (int, unsigned int) */
+    UPROBE_AVCENC_THREADS
+};
+
+/** @This sets the threading of the codec. It must be called before the
+ * codec is opened, and the number of threads may be reduced by the budget
+ * set with @ref upipe_av_set_threads_budget.
+ *
+ * @param upipe description structure of the pipe
+ * @param thread_type types of threading (@ref upipe_av_thread_type), or 0
+ * for the default of avcodec
+ * @param threads number of threads, or 0 for the default of avcodec
+ * @return an error code
+ */
+static inline int upipe_avcenc_set_threads(struct upipe *upipe,
+                                           int thread_type,
+                                           unsigned int threads)
+{
+    return upipe_control(upipe, UPIPE_AVCENC_SET_THREADS,
+                         UPIPE_AVCENC_SIGNATURE, thread_type, threads);
+}
+
+/** @This returns the threading of the codec, as used by avcodec once the
+ * codec is opened, or as requested before.
+ *
+ * @param upipe description structure of the pipe
+ * @param thread_type_p filled in with the types of threading
+ * (@ref upipe_av_thread_type)
+ * @param threads_p filled in with the number of threads
+ * @return an error code
+ */
+static inline int upipe_avcenc_get_threads(struct upipe *upipe,
+                                           int *thread_type_p,
+                                           unsigned int *threads_p)
+{
+    return upipe_control(upipe, UPIPE_AVCENC_GET_THREADS,
+                         UPIPE_AVCENC_SIGNATURE, thread_type_p, threads_p);
+}
+
 /** @This extends upipe_mgr_command with specific commands for avcenc. */
 enum upipe_avcenc_mgr_command {
     UPIPE_AVCENC_MGR_SENTINEL = UPIPE_MGR_CONTROL_LOCAL,
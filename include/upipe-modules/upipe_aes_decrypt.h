@@ -1,8 +1,44 @@
 #ifndef _UPIPE_MODULES_UPIPE_AES_DECRYPT_H_
 # define _UPIPE_MODULES_UPIPE_AES_DECRYPT_H_
 
+#include <stdint.h>
+#include <stddef.h>
+
 #define UPIPE_AES_DECRYPT_SIGNATURE     UBASE_FOURCC('a','e','s','d')
 
 struct upipe_mgr *upipe_aes_decrypt_mgr_alloc(void);
 
+/** @This expands an AES-128 key into the round keys of the cipher.
+ *
+ * @param key the AES key
+ * @param round_keys filled in with the round keys
+ */
+void upipe_aes_decrypt_expand_key(const uint8_t key[16],
+                                  uint8_t round_keys[11][16]);
+
+/** @This decrypts a buffer in place with AES-128 in CBC mode. AES-NI, or
+ * VAES, is used when the CPU supports it, which is detected at runtime.
+ *
+ * @param buffer the buffer to decrypt
+ * @param size size of the buffer, a multiple of 16 octets
+ * @param round_keys the round keys
+ * @param iv the initialization vector, updated with the last encrypted
+ * block of the buffer so that the next one may be decrypted
+ */
+void upipe_aes_decrypt_cbc(uint8_t *buffer, size_t size,
+                           const uint8_t round_keys[11][16], uint8_t iv[16]);
+
+/** @This is the portable implementation of @ref upipe_aes_decrypt_cbc,
+ * exported so that it can be compared to the accelerated versions.
+ *
+ * @param buffer the buffer to decrypt
+ * @param size size of the buffer, a multiple of 16 octets
+ * @param round_keys the round keys
+ * @param iv the initialization vector, updated with the last encrypted
+ * block of the buffer
+ */
+void upipe_aes_decrypt_cbc_c(uint8_t *buffer, size_t size,
+                             const uint8_t round_keys[11][16],
+                             uint8_t iv[16]);
+
 #endif /* !_UPIPE_MODULES_UPIPE_AES_DECRYPT_H_ */
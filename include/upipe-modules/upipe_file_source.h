@@ -38,12 +38,48 @@ extern "C" {
 
 #define UPIPE_FSRC_SIGNATURE UBASE_FOURCC('f','s','r','c')
 
+/** @This extends upipe_command with specific commands for file source. */
+enum upipe_fsrc_command {
+    UPIPE_FSRC_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** returns true if regular files are mapped in memory (bool *) */
+    UPIPE_FSRC_GET_MMAP,
+    /** sets whether regular files are mapped in memory (bool) */
+    UPIPE_FSRC_SET_MMAP
+};
+
 /** @This returns the management structure for all file sources.
  *
  * @return pointer to manager
  */
 struct upipe_mgr *upipe_fsrc_mgr_alloc(void);
 
+/** @This returns whether regular files are mapped in memory.
+ *
+ * @param upipe description structure of the pipe
+ * @param mmap_p filled in with true if files are mapped
+ * @return an error code
+ */
+static inline int upipe_fsrc_get_mmap(struct upipe *upipe, bool *mmap_p)
+{
+    return upipe_control(upipe, UPIPE_FSRC_GET_MMAP, UPIPE_FSRC_SIGNATURE,
+                         mmap_p);
+}
+
+/** @This sets whether regular files are mapped in memory. In that mode, the
+ * output buffers point directly to the page cache instead of being copied
+ * with read(), and they may not be written to. Other files are always read.
+ *
+ * @param upipe description structure of the pipe
+ * @param mmap true to map regular files
+ * @return an error code
+ */
+static inline int upipe_fsrc_set_mmap(struct upipe *upipe, bool mmap)
+{
+    return upipe_control(upipe, UPIPE_FSRC_SET_MMAP, UPIPE_FSRC_SIGNATURE,
+                         mmap ? 1 : 0);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -81,6 +81,10 @@ enum upipe_http_src_command {
 
     /** set the http proxy to use (const char *) */
     UPIPE_HTTP_SRC_SET_PROXY,
+    /** get the connection timeout (uint64_t *) */
+    UPIPE_HTTP_SRC_GET_CONNECT_TIMEOUT,
+    /** set the connection timeout (uint64_t) */
+    UPIPE_HTTP_SRC_SET_CONNECT_TIMEOUT,
 };
 
 /** @This converts an enum upipe_http_src_command to a string.
@@ -92,6 +96,8 @@ static inline const char *upipe_http_src_command_str(int cmd)
 {
     switch ((enum upipe_http_src_command)cmd) {
     UBASE_CASE_TO_STR(UPIPE_HTTP_SRC_SET_PROXY);
+    UBASE_CASE_TO_STR(UPIPE_HTTP_SRC_GET_CONNECT_TIMEOUT);
+    UBASE_CASE_TO_STR(UPIPE_HTTP_SRC_SET_CONNECT_TIMEOUT);
     case UPIPE_HTTP_SRC_SENTINEL: break;
     }
     return NULL;
@@ -110,6 +116,35 @@ static inline int upipe_http_src_set_proxy(struct upipe *upipe,
                          UPIPE_HTTP_SRC_SIGNATURE, proxy);
 }
 
+/** @This returns the timeout of the connection setup, including the name
+ * resolution.
+ *
+ * @param upipe description structure of the pipe
+ * @param timeout_p filled in with the timeout in units of the 27 MHz clock,
+ * or 0 if there is no timeout
+ * @return an error code
+ */
+static inline int upipe_http_src_get_connect_timeout(struct upipe *upipe,
+                                                     uint64_t *timeout_p)
+{
+    return upipe_control(upipe, UPIPE_HTTP_SRC_GET_CONNECT_TIMEOUT,
+                         UPIPE_HTTP_SRC_SIGNATURE, timeout_p);
+}
+
+/** @This sets the timeout of the connection setup, including the name
+ * resolution. It applies to the next call to @ref upipe_set_uri.
+ *
+ * @param upipe description structure of the pipe
+ * @param timeout timeout in units of the 27 MHz clock, or 0 for no timeout
+ * @return an error code
+ */
+static inline int upipe_http_src_set_connect_timeout(struct upipe *upipe,
+                                                     uint64_t timeout)
+{
+    return upipe_control(upipe, UPIPE_HTTP_SRC_SET_CONNECT_TIMEOUT,
+                         UPIPE_HTTP_SRC_SIGNATURE, timeout);
+}
+
 /** @This extends upipe_mgr_command with specific commands for http source. */
 enum upipe_http_src_mgr_command {
     UPIPE_HTTP_SRC_MGR_SENTINEL = UPIPE_MGR_CONTROL_LOCAL,
@@ -123,6 +158,12 @@ enum upipe_http_src_mgr_command {
     UPIPE_HTTP_SRC_MGR_SET_COOKIE,
     /** iterate over cookies */
     UPIPE_HTTP_SRC_MGR_ITERATE_COOKIE,
+
+    /** get the persistent connection parameters (unsigned int *,
+     * uint64_t *) */
+    UPIPE_HTTP_SRC_MGR_GET_KEEP_ALIVE,
+    /** set the persistent connection parameters (unsigned int, uint64_t) */
+    UPIPE_HTTP_SRC_MGR_SET_KEEP_ALIVE,
 };
 
 /** @This sets the proxy url to use by default for the new allocated pipes.
@@ -181,6 +222,44 @@ static inline int upipe_http_src_mgr_iterate_cookie(struct upipe_mgr *mgr,
                              UPIPE_HTTP_SRC_SIGNATURE, domain, path, uchain_p);
 }
 
+/** @This returns the parameters of the persistent connections shared by
+ * the pipes allocated by this manager.
+ *
+ * @param mgr pointer to upipe manager
+ * @param max_idle_p filled in with the maximum number of idle connections
+ * @param idle_timeout_p filled in with the time after which idle connections
+ * are closed, in units of the 27 MHz clock
+ * @return an error code
+ */
+static inline int upipe_http_src_mgr_get_keep_alive(struct upipe_mgr *mgr,
+                                                    unsigned int *max_idle_p,
+                                                    uint64_t *idle_timeout_p)
+{
+    return upipe_mgr_control(mgr, UPIPE_HTTP_SRC_MGR_GET_KEEP_ALIVE,
+                             UPIPE_HTTP_SRC_SIGNATURE, max_idle_p,
+                             idle_timeout_p);
+}
+
+/** @This sets the parameters of the persistent connections shared by the
+ * pipes allocated by this manager. When a response is complete, the
+ * connection is kept idle, and reused by the next request to the same host
+ * and port.
+ *
+ * @param mgr pointer to upipe manager
+ * @param max_idle maximum number of idle connections, or 0 to close
+ * connections after each response
+ * @param idle_timeout time after which idle connections are closed, in units
+ * of the 27 MHz clock
+ * @return an error code
+ */
+static inline int upipe_http_src_mgr_set_keep_alive(struct upipe_mgr *mgr,
+                                                    unsigned int max_idle,
+                                                    uint64_t idle_timeout)
+{
+    return upipe_mgr_control(mgr, UPIPE_HTTP_SRC_MGR_SET_KEEP_ALIVE,
+                             UPIPE_HTTP_SRC_SIGNATURE, max_idle, idle_timeout);
+}
+
 /** @This returns the management structure for all http sources.
  *
  * @return pointer to manager
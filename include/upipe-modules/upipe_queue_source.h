@@ -28,7 +28,9 @@
  *
  * Note that the allocator requires an additional parameter:
  * @table 2
- * @item queue_length @item maximum length of the queue (<= 255)
+ * @item queue_length @item maximum length of the queue (<= 255, or
+ * <= @ref UQUEUE_MPMC_MAX_LENGTH for the manager returned by
+ * @ref upipe_qsrc_mpmc_mgr_alloc)
  * @end table
  *
  * Also note that this module is exceptional in that upipe_release() may be
@@ -57,7 +59,9 @@ enum upipe_qsrc_command {
     /** returns the maximum length of the queue (unsigned int *) */
     UPIPE_QSRC_GET_MAX_LENGTH,
     /** returns the current length of the queue (unsigned int *) */
-    UPIPE_QSRC_GET_LENGTH
+    UPIPE_QSRC_GET_LENGTH,
+    /** sets the wakeup threshold and latency (unsigned int, uint64_t) */
+    UPIPE_QSRC_SET_WAKEUP
 };
 
 /** @This returns the management structure for all queue sources.
@@ -66,6 +70,15 @@ enum upipe_qsrc_command {
  */
 struct upipe_mgr *upipe_qsrc_mgr_alloc(void);
 
+/** @This returns the management structure for queue source pipes whose
+ * queue is backed by a lock-free umpmc ring, which scales better when
+ * several threads push into the queue, and allows for longer queues. Queue
+ * sinks work the same with both kinds of queue sources.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_qsrc_mpmc_mgr_alloc(void);
+
 /** @This returns the maximum length of the queue.
  *
  * @param upipe description structure of the pipe
@@ -95,6 +108,27 @@ static inline int upipe_qsrc_get_length(struct upipe *upipe,
                          UPIPE_QSRC_SIGNATURE, length_p);
 }
 
+/** @This sets the number of queued buffers from which the sink wakes up the
+ * source, and the maximum latency of buffers queued below this threshold,
+ * after which the source drains the queue anyway. This coalesces the wakeups
+ * (and the associated eventfd system calls) of bursty streams, at the
+ * expense of latency. By default, the source is woken up for every buffer
+ * queued in an empty queue.
+ *
+ * @param upipe description structure of the pipe
+ * @param threshold number of buffers, or 1 to disable coalescing
+ * @param latency maximum latency in units of the 27 MHz clock, mandatory if
+ * threshold is greater than 1
+ * @return an error code
+ */
+static inline int upipe_qsrc_set_wakeup(struct upipe *upipe,
+                                        unsigned int threshold,
+                                        uint64_t latency)
+{
+    return upipe_control(upipe, UPIPE_QSRC_SET_WAKEUP, UPIPE_QSRC_SIGNATURE,
+                         threshold, latency);
+}
+
 /** @hidden */
 #define ARGS_DECL , unsigned int queue_length
 /** @hidden */
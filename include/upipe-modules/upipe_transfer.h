@@ -50,7 +50,9 @@ enum upipe_xfer_mgr_command {
     UPIPE_XFER_MGR_SENTINEL = UPIPE_MGR_CONTROL_LOCAL,
 
     /** attach to given upump manager (struct upump_mgr *) */
-    UPIPE_XFER_MGR_ATTACH
+    UPIPE_XFER_MGR_ATTACH,
+    /** sets the wakeup threshold and latency (unsigned int, uint64_t) */
+    UPIPE_XFER_MGR_SET_WAKEUP
 };
 
 /** @This returns a management structure for xfer pipes. You would need one
@@ -65,6 +67,18 @@ enum upipe_xfer_mgr_command {
 struct upipe_mgr *upipe_xfer_mgr_alloc(uint8_t queue_length,
                                        uint16_t msg_pool_depth);
 
+/** @This returns a management structure for xfer pipes, whose internal
+ * queues are backed by lock-free umpmc rings. This scales better when many
+ * threads send messages to the same event loop.
+ *
+ * @param queue_length maximum length of the internal queues
+ * (<= @ref UQUEUE_MPMC_MAX_LENGTH)
+ * @param msg_pool_depth maximum number of messages in the pool
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_xfer_mgr_alloc_mpmc(unsigned int queue_length,
+                                            uint16_t msg_pool_depth);
+
 /** @This attaches a upipe_xfer_mgr to a given event loop. The xfer manager
  * will call upump_alloc_XXX and upump_start, so it must be done in a context
  * where it is possible, which generally means that this command is done in
@@ -86,6 +100,28 @@ static inline int upipe_xfer_mgr_attach(struct upipe_mgr *mgr,
                              upump_mgr);
 }
 
+/** @This sets the number of queued messages from which the remote upump
+ * manager is woken up, and the maximum latency of messages queued below
+ * this threshold, after which they are processed anyway. This coalesces the
+ * wakeups (and the associated eventfd system calls) of bursts of messages.
+ * By default, the remote upump manager is woken up for every message
+ * queued in an empty queue. This call is thread-safe and may be performed
+ * from any thread.
+ *
+ * @param mgr xfer_mgr structure
+ * @param threshold number of messages, or 1 to disable coalescing
+ * @param latency maximum latency in units of the 27 MHz clock, mandatory if
+ * threshold is greater than 1
+ * @return an error code
+ */
+static inline int upipe_xfer_mgr_set_wakeup(struct upipe_mgr *mgr,
+                                            unsigned int threshold,
+                                            uint64_t latency)
+{
+    return upipe_mgr_control(mgr, UPIPE_XFER_MGR_SET_WAKEUP,
+                             UPIPE_XFER_SIGNATURE, threshold, latency);
+}
+
 /** @hidden */
 #define ARGS_DECL , struct upipe *upipe_remote
 /** @hidden */
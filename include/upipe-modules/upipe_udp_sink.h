@@ -52,7 +52,13 @@ enum upipe_udpsink_command {
     /** returns the uri of the currently opened udp (const char **) */
     UPIPE_UDPSINK_GET_URI,
     /** asks to open the given uri (const char *, enum upipe_udpsink_mode) */
-    UPIPE_UDPSINK_SET_URI
+    UPIPE_UDPSINK_SET_URI,
+    /** returns the batch parameters (unsigned int *, uint64_t *) */
+    UPIPE_UDPSINK_GET_BATCH,
+    /** sets the batch parameters (unsigned int, uint64_t) */
+    UPIPE_UDPSINK_SET_BATCH,
+    /** enables or disables segmentation offload (int) */
+    UPIPE_UDPSINK_SET_GSO
 };
 
 /** @This returns the management structure for all udp sinks.
@@ -89,6 +95,51 @@ static inline int upipe_udpsink_set_uri(struct upipe *upipe,
                          uri, mode);
 }
 
+/** @This returns the batch parameters.
+ *
+ * @param upipe description structure of the pipe
+ * @param batch_p filled in with the maximum number of datagrams per system call
+ * @param window_p filled in with the batch window
+ * @return an error code
+ */
+static inline int upipe_udpsink_get_batch(struct upipe *upipe,
+                                          unsigned int *batch_p,
+                                          uint64_t *window_p)
+{
+    return upipe_control(upipe, UPIPE_UDPSINK_GET_BATCH,
+                         UPIPE_UDPSINK_SIGNATURE, batch_p, window_p);
+}
+
+/** @This sets the batch parameters. With a batch greater than 1, datagrams
+ * are queued and sent with a single system call, up to window (in 27 MHz
+ * units) ahead of their date.
+ *
+ * @param upipe description structure of the pipe
+ * @param batch maximum number of datagrams per system call (1 to disable)
+ * @param window maximum advance of a datagram on its date
+ * @return an error code
+ */
+static inline int upipe_udpsink_set_batch(struct upipe *upipe,
+                                          unsigned int batch, uint64_t window)
+{
+    return upipe_control(upipe, UPIPE_UDPSINK_SET_BATCH,
+                         UPIPE_UDPSINK_SIGNATURE, batch, window);
+}
+
+/** @This enables or disables UDP segmentation offload in batch mode, so that
+ * datagrams of the same size are handed over to the kernel as a single
+ * buffer.
+ *
+ * @param upipe description structure of the pipe
+ * @param enable true to enable segmentation offload
+ * @return an error code
+ */
+static inline int upipe_udpsink_set_gso(struct upipe *upipe, bool enable)
+{
+    return upipe_control(upipe, UPIPE_UDPSINK_SET_GSO,
+                         UPIPE_UDPSINK_SIGNATURE, enable ? 1 : 0);
+}
+
 #ifdef __cplusplus
 }
 #endif
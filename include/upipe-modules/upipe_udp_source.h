@@ -39,12 +39,53 @@ extern "C" {
 
 #define UPIPE_UDPSRC_SIGNATURE UBASE_FOURCC('u','s','r','c')
 
+/** @This extends upipe_command with specific commands for udp source. */
+enum upipe_udpsrc_command {
+    UPIPE_UDPSRC_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** returns the maximum number of datagrams read per wakeup
+     * (unsigned int *) */
+    UPIPE_UDPSRC_GET_BATCH,
+    /** sets the maximum number of datagrams read per wakeup (unsigned int) */
+    UPIPE_UDPSRC_SET_BATCH
+};
+
 /** @This returns the management structure for all udp socket sources.
  *
  * @return pointer to manager
  */
 struct upipe_mgr *upipe_udpsrc_mgr_alloc(void);
 
+/** @This returns the maximum number of datagrams read per wakeup.
+ *
+ * @param upipe description structure of the pipe
+ * @param batch_p filled in with the maximum number of datagrams
+ * @return an error code
+ */
+static inline int upipe_udpsrc_get_batch(struct upipe *upipe,
+                                         unsigned int *batch_p)
+{
+    return upipe_control(upipe, UPIPE_UDPSRC_GET_BATCH,
+                         UPIPE_UDPSRC_SIGNATURE, batch_p);
+}
+
+/** @This sets the maximum number of datagrams read per wakeup. In batch mode
+ * (batch > 1), the pipe preallocates batch buffers of the output size and
+ * drains the socket with a single recvmmsg(2) call, and the reception date
+ * of each datagram is derived from kernel timestamps. A value of 0 or 1
+ * restores the default mode (one datagram per wakeup).
+ *
+ * @param upipe description structure of the pipe
+ * @param batch maximum number of datagrams read per wakeup
+ * @return an error code
+ */
+static inline int upipe_udpsrc_set_batch(struct upipe *upipe,
+                                         unsigned int batch)
+{
+    return upipe_control(upipe, UPIPE_UDPSRC_SET_BATCH,
+                         UPIPE_UDPSRC_SIGNATURE, batch);
+}
+
 #ifdef __cplusplus
 }
 #endif
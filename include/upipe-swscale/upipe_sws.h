@@ -45,7 +45,11 @@ enum upipe_sws_command {
     /** set flags (int) */
     UPIPE_SWS_SET_FLAGS,
     /** get flags (int *) */
-    UPIPE_SWS_GET_FLAGS
+    UPIPE_SWS_GET_FLAGS,
+    /** set the number of threads (unsigned int) */
+    UPIPE_SWS_SET_THREADS,
+    /** get the number of threads (unsigned int *) */
+    UPIPE_SWS_GET_THREADS
 };
 
 /** @This gets the swscale flags.
@@ -72,6 +76,39 @@ static inline bool upipe_sws_set_flags(struct upipe *upipe, int flags)
                          flags);
 }
 
+/** @This sets the number of threads scaling pictures. With more than one
+ * thread, pictures are split into horizontal bands which are scaled in
+ * parallel by a pool of workers, each band having its own swscale contexts.
+ * Bands are not overlapped: each band clamps its edges like a whole picture,
+ * so the output lines within the filter support of a boundary between bands
+ * (a few lines, more when downscaling) may differ slightly from a
+ * single-threaded conversion, leaving faint seams. The other lines are
+ * identical.
+ *
+ * @param upipe description structure of the pipe
+ * @param threads number of threads, 1 to disable slice threading (default)
+ * @return an error code
+ */
+static inline int upipe_sws_set_threads(struct upipe *upipe,
+                                        unsigned int threads)
+{
+    return upipe_control(upipe, UPIPE_SWS_SET_THREADS, UPIPE_SWS_SIGNATURE,
+                         threads);
+}
+
+/** @This gets the number of threads scaling pictures.
+ *
+ * @param upipe description structure of the pipe
+ * @param threads_p filled in with the number of threads
+ * @return an error code
+ */
+static inline int upipe_sws_get_threads(struct upipe *upipe,
+                                        unsigned int *threads_p)
+{
+    return upipe_control(upipe, UPIPE_SWS_GET_THREADS, UPIPE_SWS_SIGNATURE,
+                         threads_p);
+}
+
 /** @This returns the management structure for sws pipes.
  *
  * @return pointer to manager
@@ -49,7 +49,12 @@ enum upipe_ts_sync_command {
     /** returns the configured number of packets to synchronize with (int *) */
     UPIPE_TS_SYNC_GET_SYNC,
     /** sets the configured number of packets to synchronize with (int) */
-    UPIPE_TS_SYNC_SET_SYNC
+    UPIPE_TS_SYNC_SET_SYNC,
+    /** returns the maximum number of packets per output uref
+     * (unsigned int *) */
+    UPIPE_TS_SYNC_GET_VECTOR,
+    /** sets the maximum number of packets per output uref (unsigned int) */
+    UPIPE_TS_SYNC_SET_VECTOR
 };
 
 /** @This returns the management structure for all ts_sync pipes.
@@ -84,6 +89,36 @@ static inline int upipe_ts_sync_set_sync(struct upipe *upipe, int sync)
                          sync);
 }
 
+/** @This returns the maximum number of packets per output uref.
+ *
+ * @param upipe description structure of the pipe
+ * @param vector_p filled in with the maximum number of packets
+ * @return an error code
+ */
+static inline int upipe_ts_sync_get_vector(struct upipe *upipe,
+                                           unsigned int *vector_p)
+{
+    return upipe_control(upipe, UPIPE_TS_SYNC_GET_VECTOR,
+                         UPIPE_TS_SYNC_SIGNATURE, vector_p);
+}
+
+/** @This sets the maximum number of packets per output uref. With a value
+ * greater than 1, consecutive TS packets are output in a single uref marked
+ * with their number (see @ref uref_ts_vector_get_packets) and an index of
+ * their PIDs (see @ref uref_ts_vector_get_pids), which must be fed to
+ * ts_split or ts_decaps.
+ *
+ * @param upipe description structure of the pipe
+ * @param vector maximum number of packets
+ * @return an error code
+ */
+static inline int upipe_ts_sync_set_vector(struct upipe *upipe,
+                                           unsigned int vector)
+{
+    return upipe_control(upipe, UPIPE_TS_SYNC_SET_VECTOR,
+                         UPIPE_TS_SYNC_SIGNATURE, vector);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe attributes for vectors of TS packets
+ *
+ * A TS packet vector is a block uref carrying several consecutive TS packets
+ * of TS_SIZE octets, as output by ts_sync in vector mode. It is marked with
+ * its number of packets, and may come with an index of the PIDs of its
+ * packets, stored as an opaque attribute of 16-bit big-endian values, which
+ * spares the receiver from mapping every TS header.
+ */
+
+#ifndef _UPIPE_TS_UREF_TS_VECTOR_H_
+/** @hidden */
+#define _UPIPE_TS_UREF_TS_VECTOR_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/uref.h>
+#include <upipe/uref_attr.h>
+
+#include <stdint.h>
+
+UREF_ATTR_UNSIGNED(ts_vector, packets, "tv.packets", number of TS packets)
+UREF_ATTR_OPAQUE(ts_vector, pids, "tv.pids", PID index)
+
+/** @This returns the PID of a packet from a PID index.
+ *
+ * @param pids PID index
+ * @param packet number of the packet in the vector
+ * @return PID of the packet
+ */
+static inline uint16_t uref_ts_vector_pid(const uint8_t *pids,
+                                          unsigned int packet)
+{
+    return (pids[2 * packet] << 8) | pids[2 * packet + 1];
+}
+
+/** @This writes the PID of a packet in a PID index.
+ *
+ * @param pids PID index
+ * @param packet number of the packet in the vector
+ * @param pid PID of the packet
+ */
+static inline void uref_ts_vector_set_pid(uint8_t *pids, unsigned int packet,
+                                          uint16_t pid)
+{
+    pids[2 * packet] = pid >> 8;
+    pids[2 * packet + 1] = pid & 0xff;
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
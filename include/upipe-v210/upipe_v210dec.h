@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/** @file
+ * @short Upipe v210dec module, unpacking v210 pictures to planar 10 bits
+ */
+
+#ifndef _UPIPE_MODULES_UPIPE_V210DEC_H_
+/** @hidden */
+#define _UPIPE_MODULES_UPIPE_V210DEC_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/upipe.h>
+
+#define UPIPE_V210DEC_SIGNATURE UBASE_FOURCC('v','2','1','d')
+
+/** @This defines a 10-bit unpacking function. */
+typedef void (*upipe_v210dec_unpack_line_10)(
+        const uint8_t *src, uint16_t *y, uint16_t *u, uint16_t *v,
+        ptrdiff_t width);
+
+/** @This extends upipe_command with specific commands for v210dec pipes. */
+enum upipe_v210dec_command {
+    UPIPE_V210DEC_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** set 10-bit unpacking function (upipe_v210dec_unpack_line_10) */
+    UPIPE_V210DEC_SET_UNPACK_LINE_10,
+    /** get 10-bit unpacking function (upipe_v210dec_unpack_line_10 *) */
+    UPIPE_V210DEC_GET_UNPACK_LINE_10
+};
+
+/** @This sets the 10-bit unpacking function.
+ *
+ * @param upipe description structure of the pipe
+ * @param unpack unpacking function
+ * @return an error code
+ */
+static inline int upipe_v210dec_set_unpack_line_10(struct upipe *upipe,
+        upipe_v210dec_unpack_line_10 unpack)
+{
+    return upipe_control(upipe, UPIPE_V210DEC_SET_UNPACK_LINE_10,
+                         UPIPE_V210DEC_SIGNATURE, unpack);
+}
+
+/** @This gets the 10-bit unpacking function.
+ *
+ * @param upipe description structure of the pipe
+ * @param unpack_p written with the unpacking function
+ * @return an error code
+ */
+static inline int upipe_v210dec_get_unpack_line_10(struct upipe *upipe,
+        upipe_v210dec_unpack_line_10 *unpack_p)
+{
+    return upipe_control(upipe, UPIPE_V210DEC_GET_UNPACK_LINE_10,
+                         UPIPE_V210DEC_SIGNATURE, unpack_p);
+}
+
+/** @This returns the fastest 10-bit unpacking function for the given CPU
+ * flags. The unpacking functions are vectorised with SSSE3 or AVX2.
+ *
+ * @param cpu_flags CPU flags, as returned by av_get_cpu_flags()
+ * @return an unpacking function
+ */
+upipe_v210dec_unpack_line_10 upipe_v210dec_select_unpack_line_10(
+        int cpu_flags);
+
+/** @This returns the management structure for v210dec pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_v210dec_mgr_alloc(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
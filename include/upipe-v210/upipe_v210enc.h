@@ -113,6 +113,22 @@ static inline int upipe_v210enc_get_pack_line_10(struct upipe *upipe,
                          UPIPE_V210ENC_SIGNATURE, pack_p);
 }
 
+/** @This returns the fastest 8-bit packing function for the given CPU
+ * flags. The packing functions are vectorised with SSSE3 or AVX2.
+ *
+ * @param cpu_flags CPU flags, as returned by av_get_cpu_flags()
+ * @return a packing function
+ */
+upipe_v210enc_pack_line_8 upipe_v210enc_select_pack_line_8(int cpu_flags);
+
+/** @This returns the fastest 10-bit packing function for the given CPU
+ * flags.
+ *
+ * @param cpu_flags CPU flags, as returned by av_get_cpu_flags()
+ * @return a packing function
+ */
+upipe_v210enc_pack_line_10 upipe_v210enc_select_pack_line_10(int cpu_flags);
+
 /** @This returns the management structure for v210 pipes.
  *
  * @return pointer to manager
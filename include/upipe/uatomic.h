@@ -53,6 +53,10 @@ extern "C" {
  * support larger atomic operations. */
 typedef volatile uint32_t uatomic_uint32_t;
 
+/** @This defines an atomic 64-bits unsigned integer, for counters. Some
+ * 32-bits platforms emulate its operations with locks. */
+typedef volatile uint64_t uatomic_uint64_t;
+
 /** @This defines an atomic pointer. */
 typedef void * volatile uatomic_ptr_t;
 
@@ -89,6 +93,26 @@ static inline ctype type##_load(atomictype *obj)                            \
     __sync_synchronize();                                                   \
     return *obj;                                                            \
 }                                                                           \
+/** @This sets the value of the uatomic variable, without ordering the      \
+ * surrounding memory accesses. This is meant for counters.                 \
+ *                                                                          \
+ * @param obj pointer to a uatomic variable                                 \
+ * @param value value to set                                                \
+ */                                                                         \
+static inline void type##_store_relaxed(atomictype *obj, ctype value)       \
+{                                                                           \
+    __atomic_store_n(obj, value, __ATOMIC_RELAXED);                         \
+}                                                                           \
+/** @This returns the value of the uatomic variable, without ordering the   \
+ * surrounding memory accesses. This is meant for counters.                 \
+ *                                                                          \
+ * @param obj pointer to a uatomic variable                                 \
+ * @return the value                                                        \
+ */                                                                         \
+static inline ctype type##_load_relaxed(atomictype *obj)                    \
+{                                                                           \
+    return __atomic_load_n(obj, __ATOMIC_RELAXED);                          \
+}                                                                           \
 /** @This atomically replaces the uatomic variable, if it contains an       \
  * expected value, with a desired value.                                    \
  *                                                                          \
@@ -115,6 +139,7 @@ static inline void type##_clean(atomictype *obj)                            \
 {                                                                           \
 }
 UATOMIC_TEMPLATE(uatomic, uint32_t, uatomic_uint32_t)
+UATOMIC_TEMPLATE(uatomic64, uint64_t, uatomic_uint64_t)
 UATOMIC_TEMPLATE(uatomic_ptr, void *, uatomic_ptr_t)
 #undef UATOMIC_TEMPLATE
 
@@ -142,6 +167,18 @@ static inline uint32_t uatomic_fetch_sub(uatomic_uint32_t *obj,
     return __sync_fetch_and_sub(obj, operand);
 }
 
+/** @This increments a 64-bits uatomic variable.
+ *
+ * @param obj pointer to a uatomic variable
+ * @param operand value to add
+ * @return value before the operation
+ */
+static inline uint64_t uatomic64_fetch_add(uatomic_uint64_t *obj,
+                                           uint64_t operand)
+{
+    return __sync_fetch_and_add(obj, operand);
+}
+
 
 #elif defined(UPIPE_HAVE_SEMAPHORE_H) /* mkdoc:skip */
 
@@ -176,6 +213,14 @@ static inline ctype type##_load(atomictype *obj)                            \
     sem_post(&obj->lock);                                                   \
     return ret;                                                             \
 }                                                                           \
+static inline void type##_store_relaxed(atomictype *obj, ctype value)       \
+{                                                                           \
+    type##_store(obj, value);                                               \
+}                                                                           \
+static inline ctype type##_load_relaxed(atomictype *obj)                    \
+{                                                                           \
+    return type##_load(obj);                                                \
+}                                                                           \
 static inline bool type##_compare_exchange(atomictype *obj,                 \
                                            ctype *expected, ctype desired)  \
 {                                                                           \
@@ -194,6 +239,7 @@ static inline void type##_clean(atomictype *obj)                            \
     sem_destroy(&obj->lock);                                                \
 }
 UATOMIC_TEMPLATE(uatomic, uint32_t, uatomic_uint32_t)
+UATOMIC_TEMPLATE(uatomic64, uint64_t, uatomic_uint64_t)
 UATOMIC_TEMPLATE(uatomic_ptr, void *, uatomic_ptr_t)
 #undef UATOMIC_TEMPLATE
 
@@ -219,6 +265,17 @@ static inline uint32_t uatomic_fetch_sub(uatomic_uint32_t *obj,
     return ret;
 }
 
+static inline uint64_t uatomic64_fetch_add(uatomic_uint64_t *obj,
+                                           uint64_t operand)
+{
+    uint64_t ret;
+    while (sem_wait(&obj->lock) == -1);
+    ret = obj->value;
+    obj->value += operand;
+    sem_post(&obj->lock);
+    return ret;
+}
+
 
 
 #else /* mkdoc:skip */
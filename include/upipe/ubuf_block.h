@@ -37,6 +37,7 @@ extern "C" {
 
 #include <upipe/ubase.h>
 #include <upipe/ubuf.h>
+#include <upipe/uscan.h>
 
 #include <stdint.h>
 #include <stdbool.h>
@@ -125,6 +126,17 @@ static inline struct ubuf *ubuf_block_get(struct ubuf *ubuf, int *offset_p,
     struct ubuf_block *head_block = block;
     int saved_offset = *offset_p;
 
+    if (likely(block->next_ubuf == NULL)) {
+        /* single segment, nothing to look up */
+        if (*offset_p < 0)
+            *offset_p += block->size;
+        if (size_p != NULL && *size_p == -1)
+            *size_p = block->size - *offset_p;
+        if (unlikely(*offset_p < 0 || *offset_p >= block->size))
+            return NULL;
+        return ubuf;
+    }
+
     if (*offset_p < 0)
         *offset_p += block->total_size;
     if (size_p != NULL && *size_p == -1)
@@ -258,7 +270,7 @@ static inline int ubuf_block_unmap(struct ubuf *ubuf, int offset)
 
     struct ubuf_block *block = ubuf_block_from_ubuf(ubuf);
     if (block->map)
-        return ubase_check(ubuf_control(ubuf, UBUF_UNMAP_BLOCK));
+        return ubuf_control(ubuf, UBUF_UNMAP_BLOCK);
     return UBASE_ERR_NONE;
 }
 
@@ -596,6 +608,200 @@ static inline int ubuf_block_peek_unmap(struct ubuf *ubuf,
     return ubuf_block_unmap(ubuf, offset);
 }
 
+/** @This stores a position in a block ubuf, allowing to walk through its
+ * segments without looking them up from the head of the chain for every
+ * access. A cursor is invalidated by any change to the segments of the ubuf
+ * (insert, delete, truncate, resize...). */
+struct ubuf_block_cursor {
+    /** segment containing the position, or NULL at the end of the block */
+    struct ubuf *ubuf;
+    /** offset of the position in the segment, in octets */
+    int offset;
+};
+
+/** @This initializes a cursor at the given offset of a block ubuf.
+ *
+ * @param cursor pointer to cursor
+ * @param ubuf pointer to ubuf
+ * @param offset offset of the position in the whole block, in octets,
+ * negative values start from the end
+ * @return an error code
+ */
+static inline int ubuf_block_cursor_init(struct ubuf_block_cursor *cursor,
+                                         struct ubuf *ubuf, int offset)
+{
+    if (unlikely(ubuf->mgr->signature != UBUF_ALLOC_BLOCK))
+        return UBASE_ERR_INVALID;
+
+    struct ubuf_block *block = ubuf_block_from_ubuf(ubuf);
+    if (offset < 0)
+        offset += block->total_size;
+    if (unlikely(offset < 0 || offset > block->total_size))
+        return UBASE_ERR_INVALID;
+
+    if (offset == block->total_size) {
+        cursor->ubuf = NULL;
+        cursor->offset = 0;
+        return UBASE_ERR_NONE;
+    }
+    if (unlikely((ubuf = ubuf_block_get(ubuf, &offset, NULL)) == NULL))
+        return UBASE_ERR_INVALID;
+    cursor->ubuf = ubuf;
+    cursor->offset = offset;
+    return UBASE_ERR_NONE;
+}
+
+/** @This checks if a cursor reached the end of the block.
+ *
+ * @param cursor pointer to cursor
+ * @return true if there is nothing left to read
+ */
+static inline bool ubuf_block_cursor_end(const struct ubuf_block_cursor *cursor)
+{
+    return cursor->ubuf == NULL;
+}
+
+/** @This moves a cursor forward, only walking through the segments between
+ * the current and the new position.
+ *
+ * @param cursor pointer to cursor
+ * @param size number of octets to skip
+ * @return an error code
+ */
+static inline int ubuf_block_cursor_skip(struct ubuf_block_cursor *cursor,
+                                         int size)
+{
+    struct ubuf *ubuf = cursor->ubuf;
+    int offset = cursor->offset + size;
+    if (unlikely(size < 0))
+        return UBASE_ERR_INVALID;
+
+    while (ubuf != NULL) {
+        struct ubuf_block *block = ubuf_block_from_ubuf(ubuf);
+        if (offset < block->size)
+            break;
+        offset -= block->size;
+        ubuf = block->next_ubuf;
+    }
+    if (unlikely(ubuf == NULL && offset))
+        return UBASE_ERR_INVALID;
+
+    cursor->ubuf = ubuf;
+    cursor->offset = offset;
+    return UBASE_ERR_NONE;
+}
+
+/** @This returns a read-only pointer to the buffer space at the position of
+ * a cursor, up to the end of the current segment. You must call
+ * @ref ubuf_block_cursor_unmap when you're done with the pointer. The cursor
+ * is not moved.
+ *
+ * @param cursor pointer to cursor
+ * @param size_p pointer to the size of the buffer space wanted, in octets,
+ * or -1 for the end of the segment, changed during execution for the actual
+ * readable size
+ * @param buffer_p reference written with a pointer to buffer space
+ * @return an error code
+ */
+static inline int ubuf_block_cursor_read(struct ubuf_block_cursor *cursor,
+                                         int *size_p,
+                                         const uint8_t **buffer_p)
+{
+    struct ubuf *ubuf = cursor->ubuf;
+    if (unlikely(ubuf == NULL))
+        return UBASE_ERR_INVALID;
+
+    struct ubuf_block *block = ubuf_block_from_ubuf(ubuf);
+    if (block->map) {
+        UBASE_RETURN(ubuf_control(ubuf, UBUF_MAP_BLOCK, buffer_p))
+    } else
+        *buffer_p = block->buffer;
+    *buffer_p += block->offset + cursor->offset;
+
+    if (*size_p == -1 || *size_p > block->size - cursor->offset)
+        *size_p = block->size - cursor->offset;
+    return UBASE_ERR_NONE;
+}
+
+/** @This unmaps the segment at the position of a cursor, previously mapped
+ * by @ref ubuf_block_cursor_read.
+ *
+ * @param cursor pointer to cursor
+ * @return an error code
+ */
+static inline int ubuf_block_cursor_unmap(struct ubuf_block_cursor *cursor)
+{
+    struct ubuf *ubuf = cursor->ubuf;
+    if (unlikely(ubuf == NULL))
+        return UBASE_ERR_INVALID;
+
+    struct ubuf_block *block = ubuf_block_from_ubuf(ubuf);
+    if (block->map)
+        return ubuf_control(ubuf, UBUF_UNMAP_BLOCK);
+    return UBASE_ERR_NONE;
+}
+
+/** @This peeks at the position of a cursor for the given amount of octets,
+ * like @ref ubuf_block_peek. The cursor is not moved.
+ *
+ * @param cursor pointer to cursor
+ * @param size size of the buffer space wanted, in octets
+ * @param buffer pointer to buffer space of at least size octets, only used
+ * if the requested area stretches across two or more segments
+ * @return pointer to buffer space, or NULL in case of error
+ */
+static inline const uint8_t *
+    ubuf_block_cursor_peek(const struct ubuf_block_cursor *cursor,
+                           int size, uint8_t *buffer)
+{
+    struct ubuf_block_cursor walk = *cursor;
+    int read_size = size;
+    const uint8_t *read_buffer;
+    if (unlikely(size < 0 ||
+                 !ubase_check(ubuf_block_cursor_read(&walk, &read_size,
+                                                     &read_buffer))))
+        return NULL;
+    if (read_size == size)
+        return read_buffer;
+
+    uint8_t *write_buffer = buffer;
+    for ( ; ; ) {
+        memcpy(write_buffer, read_buffer, read_size);
+        if (unlikely(!ubase_check(ubuf_block_cursor_unmap(&walk)) ||
+                     !ubase_check(ubuf_block_cursor_skip(&walk, read_size))))
+            return NULL;
+        size -= read_size;
+        write_buffer += read_size;
+        read_size = size;
+        if (size <= 0)
+            break;
+
+        if (unlikely(!ubase_check(ubuf_block_cursor_read(&walk, &read_size,
+                                                         &read_buffer))))
+            return NULL;
+    }
+    return buffer;
+}
+
+/** @This unmaps the segment that's been peeked into with
+ * @ref ubuf_block_cursor_peek, if necessary.
+ *
+ * @param cursor pointer to cursor
+ * @param buffer caller-supplied buffer space passed to
+ * @ref ubuf_block_cursor_peek
+ * @param read_buffer buffer returned by @ref ubuf_block_cursor_peek
+ * @return an error code
+ */
+static inline int
+    ubuf_block_cursor_peek_unmap(struct ubuf_block_cursor *cursor,
+                                 uint8_t *buffer, const uint8_t *read_buffer)
+{
+    if (buffer == read_buffer)
+        return UBASE_ERR_NONE;
+
+    return ubuf_block_cursor_unmap(cursor);
+}
+
 /** @This extracts a ubuf to an arbitrary memory space.
  *
  * @param ubuf pointer to ubuf
@@ -933,6 +1139,54 @@ static inline int ubuf_block_scan(struct ubuf *ubuf, size_t *offset_p,
     return UBASE_ERR_INVALID;
 }
 
+/** @This scans for an octet word repeated with a given period in a block
+ * ubuf, such as the sync word of transport stream packets. Each segment is
+ * scanned with @ref uscan_sync, and candidates spanning several segments
+ * are then checked octet by octet.
+ *
+ * @param ubuf pointer to ubuf
+ * @param offset_p start offset (in octets), written with the offset of the
+ * first wanted word, or first candidate if there aren't enough octets in the
+ * ubuf, or the total size of the ubuf if none was found
+ * @param word word to scan for
+ * @param stride period of the word in octets
+ * @param count number of occurrences of the word to find, including the
+ * first one
+ * @return UBASE_ERR_NONE if the word was found
+ */
+static inline int ubuf_block_scan_sync(struct ubuf *ubuf, size_t *offset_p,
+                                       uint8_t word, size_t stride,
+                                       unsigned int count)
+{
+    assert(count > 0);
+    for ( ; ; ) {
+        const uint8_t *buffer;
+        int size = -1;
+        UBASE_RETURN(ubuf_block_read(ubuf, *offset_p, &size, &buffer))
+        size_t offset = uscan_sync(buffer, size, word, stride, count);
+        ubuf_block_unmap(ubuf, *offset_p);
+        *offset_p += offset;
+        if (offset == size)
+            continue;
+        if (offset + (count - 1) * stride < size)
+            return UBASE_ERR_NONE;
+
+        /* the candidate spans several segments */
+        unsigned int i = (size - 1 - offset) / stride + 1;
+        for ( ; i < count; i++) {
+            uint8_t octet;
+            UBASE_RETURN(ubuf_block_extract(ubuf, *offset_p + i * stride, 1,
+                                            &octet))
+            if (octet != word)
+                break;
+        }
+        if (i == count)
+            return UBASE_ERR_NONE;
+        (*offset_p)++;
+    }
+    return UBASE_ERR_INVALID;
+}
+
 /** @This finds a multi-octet word in a block ubuf.
  *
  * @param ubuf pointer to ubuf
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe ubuf manager for block formats pointing to a mapped file
+ * This manager does not allocate memory: the buffers point directly to the
+ * page cache, through read-only regions (windows) of the file mapped in
+ * memory. Consecutive buffers share the same window, which is unmapped when
+ * the last buffer pointing to it is released. The buffers may not be
+ * written to, and the file must not be truncated while they are in use.
+ */
+
+#ifndef _UPIPE_UBUF_BLOCK_MMAP_H_
+/** @hidden */
+#define _UPIPE_UBUF_BLOCK_MMAP_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/ubase.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_block.h>
+
+#include <stdint.h>
+
+/** @This is a simple signature to make sure the ubuf_alloc internal API
+ * is used properly. */
+#define UBUF_ALLOC_BLOCK_MMAP UBASE_FOURCC('b','m','m','p')
+
+/** @This returns a new ubuf pointing to a part of the mapped file.
+ *
+ * @param mgr management structure for this ubuf type
+ * @param offset position of the buffer in the file, in octets
+ * @param size size of the buffer, which must not go past the end of the file
+ * @return pointer to ubuf or NULL in case of failure
+ */
+static inline struct ubuf *ubuf_block_mmap_alloc(struct ubuf_mgr *mgr,
+                                                 uint64_t offset, int size)
+{
+    return ubuf_alloc(mgr, UBUF_ALLOC_BLOCK_MMAP, offset, size);
+}
+
+/** @This allocates a new instance of the ubuf manager for block formats
+ * pointing to a mapped file.
+ *
+ * @param ubuf_pool_depth maximum number of ubuf structures in the pool
+ * @param fd file descriptor of a regular file opened for reading; the
+ * manager works on its own duplicate
+ * @param window_size size of the regions of the file mapped at once, in
+ * octets (0 for a default value)
+ * @return pointer to manager, or NULL in case of error
+ */
+struct ubuf_mgr *ubuf_block_mmap_mgr_alloc(uint16_t ubuf_pool_depth, int fd,
+                                           uint64_t window_size);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
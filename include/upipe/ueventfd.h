@@ -36,6 +36,7 @@ extern "C" {
 
 #include <upipe/config.h>
 #include <upipe/ubase.h>
+#include <upipe/uatomic.h>
 #include <upipe/upump.h>
 
 #include <assert.h>
@@ -77,8 +78,33 @@ struct ueventfd {
         /** used when pipe() is available */
         int pipe_fds[2];
     };
+    /** counter of read and write system calls, or NULL */
+    uatomic_uint32_t *syscalls;
 };
 
+/** @This sets a counter incremented on each read or write system call
+ * performed on the ueventfd, for instance to measure the cost of wakeups.
+ *
+ * @param fd pointer to a ueventfd
+ * @param syscalls pointer to an initialized counter, or NULL to stop
+ * counting
+ */
+static inline void ueventfd_set_syscalls(struct ueventfd *fd,
+                                         uatomic_uint32_t *syscalls)
+{
+    fd->syscalls = syscalls;
+}
+
+/** @internal @This increments the counter of system calls, if any.
+ *
+ * @param fd pointer to a ueventfd
+ */
+static inline void ueventfd_count_syscall(struct ueventfd *fd)
+{
+    if (unlikely(fd->syscalls != NULL))
+        uatomic_fetch_add(fd->syscalls, 1);
+}
+
 /** @This allocates a watcher triggering when the ueventfd is readable.
  *
  * @param fd pointer to a ueventfd
@@ -119,6 +145,7 @@ static inline bool ueventfd_read(struct ueventfd *fd)
     if (likely(fd->mode == UEVENTFD_MODE_EVENTFD)) {
         for ( ; ; ) {
             eventfd_t event;
+            ueventfd_count_syscall(fd);
             int ret = eventfd_read(fd->event_fd, &event);
             if (likely(ret != -1))
                 return true;
@@ -139,6 +166,7 @@ static inline bool ueventfd_read(struct ueventfd *fd)
     if (likely(fd->mode == UEVENTFD_MODE_PIPE)) {
         for ( ; ; ) {
             char buf[256];
+            ueventfd_count_syscall(fd);
             ssize_t ret = read((fd->pipe_fds)[0], buf, sizeof(buf));
             if (unlikely(ret == 0)) return true;
             if (likely(ret == -1)) {
@@ -170,6 +198,7 @@ static inline bool ueventfd_write(struct ueventfd *fd)
 #ifdef UPIPE_HAVE_EVENTFD
     if (likely(fd->mode == UEVENTFD_MODE_EVENTFD)) {
         for ( ; ; ) {
+            ueventfd_count_syscall(fd);
             int ret = eventfd_write(fd->event_fd, 1);
             if (likely(ret != -1))
                 return true;
@@ -191,6 +220,7 @@ static inline bool ueventfd_write(struct ueventfd *fd)
         for ( ; ; ) {
             char buf[1];
             buf[0] = 0;
+            ueventfd_count_syscall(fd);
             ssize_t ret = write((fd->pipe_fds)[1], buf, sizeof(buf));
             if (likely(ret == 1)) return true;
             if (likely(ret == -1)) {
@@ -221,6 +251,7 @@ static inline bool ueventfd_write(struct ueventfd *fd)
 static inline bool ueventfd_init(struct ueventfd *fd, bool readable)
 {
     int ret;
+    fd->syscalls = NULL;
 
 #ifdef UPIPE_HAVE_EVENTFD
     fd->mode = UEVENTFD_MODE_EVENTFD;
@@ -36,6 +36,9 @@ extern "C" {
 #include <upipe/ulist.h>
 #include <upipe/uprobe.h>
 
+#include <stdio.h>
+#include <stdarg.h>
+
 /** @This defines the levels of log messages. */
 enum uprobe_log_level {
     /** verbose messages, on a uref basis */
@@ -65,10 +68,15 @@ UBASE_FROM_TO(ulog_pfx, uchain, uchain, uchain);
 struct ulog {
     /** log level of the message */
     enum uprobe_log_level level;
-    /** the message to be logged */
+    /** the message to be logged, or NULL if its formatting is deferred */
     const char *msg;
     /** list of prefix tags */
     struct uchain prefixes;
+    /** printf-style format of the message if its formatting is deferred to
+     * the sink */
+    const char *format;
+    /** arguments of the format, only valid during the event */
+    va_list *args;
 };
 
 /** @This initializes an ulog structure.
@@ -84,6 +92,67 @@ static inline void ulog_init(struct ulog *ulog,
     ulog->level = level;
     ulog->msg = msg;
     ulist_init(&ulog->prefixes);
+    ulog->format = NULL;
+    ulog->args = NULL;
+}
+
+/** @This initializes an ulog structure whose formatting is deferred to the
+ * probe which eventually prints it. It may only be thrown to probe
+ * hierarchies for which @ref uprobe_log_min_level allows it.
+ *
+ * @param ulog pointer to the ulog structure to initialize
+ * @param level the level of the log
+ * @param format printf-style format of the message
+ * @param args arguments of the format
+ */
+static inline void ulog_init_va(struct ulog *ulog,
+                                enum uprobe_log_level level,
+                                const char *format, va_list *args)
+{
+    ulog_init(ulog, level, NULL);
+    ulog->format = format;
+    ulog->args = args;
+}
+
+/** @This returns the size of the buffer needed by @ref ulog_msg.
+ *
+ * @param ulog pointer to the ulog structure
+ * @return size of the buffer, including the trailing NUL
+ */
+static inline size_t ulog_msg_size(struct ulog *ulog)
+{
+    if (ulog->msg != NULL)
+        return 1;
+    va_list args;
+    va_copy(args, *ulog->args);
+    int len = vsnprintf(NULL, 0, ulog->format, args);
+    va_end(args);
+    return len > 0 ? len + 1 : 1;
+}
+
+/** @This returns the message of a log, formatting it in the given buffer if
+ * its formatting was deferred. It is typically called by sinks:
+ *
+ * @code
+ * char buffer[ulog_msg_size(ulog)];
+ * const char *msg = ulog_msg(ulog, buffer, sizeof(buffer));
+ * @endcode
+ *
+ * @param ulog pointer to the ulog structure
+ * @param buffer buffer to format the message in
+ * @param size size of the buffer, as returned by @ref ulog_msg_size
+ * @return the message
+ */
+static inline const char *ulog_msg(struct ulog *ulog, char *buffer,
+                                   size_t size)
+{
+    if (ulog->msg != NULL)
+        return ulog->msg;
+    va_list args;
+    va_copy(args, *ulog->args);
+    vsnprintf(buffer, size, ulog->format, args);
+    va_end(args);
+    return buffer;
 }
 
 #ifdef __cplusplus
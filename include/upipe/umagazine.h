@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe per-thread magazines in front of a @ref ulifo
+ * Each thread using a magazine depot keeps a small stack of elements of its
+ * own, which is accessed without atomic operations. It is refilled from, and
+ * flushed to, the shared @ref ulifo by halves, so that elements released in
+ * another thread than the one which allocated them only hit the shared
+ * structure once in a while. The magazines of all threads together never
+ * keep more than a bound given by the owner of the depot, typically the
+ * depth of the shared LIFO.
+ */
+
+#ifndef _UPIPE_UMAGAZINE_H_
+/** @hidden */
+#define _UPIPE_UMAGAZINE_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/ubase.h>
+#include <upipe/uatomic.h>
+#include <upipe/ulifo.h>
+
+#include <stdint.h>
+
+/** @This is the maximum number of elements in a per-thread magazine. */
+#define UMAGAZINE_MAX_SIZE 32
+/** @This is the maximum number of magazine depots alive at the same time;
+ * depots allocated beyond this number work without magazines. */
+#define UMAGAZINE_MAX_DEPOTS 1024
+
+/** @This is a call-back to release elements which do not fit in the shared
+ * LIFO. It may be called with an internal lock held and must not use any
+ * magazine depot. */
+typedef void (*umagazine_free_cb)(void *opaque, void *element);
+
+/** @This is the statistics of a magazine depot, summed over all threads.
+ * The counters of running threads are read with relaxed atomic loads. */
+struct umagazine_stats {
+    /** number of elements allocated from a per-thread magazine */
+    uint64_t hits;
+    /** number of allocations which found the per-thread magazine empty */
+    uint64_t misses;
+    /** number of times a full magazine was flushed to the shared LIFO, which
+     * is mostly caused by elements released in another thread than the one
+     * which allocated them */
+    uint64_t flushes;
+};
+
+/** @This is the implementation of a magazine depot. */
+struct umagazine {
+    /** shared LIFO */
+    struct ulifo *lifo;
+    /** number of elements in per-thread magazines, or 0 if disabled */
+    unsigned int size;
+    /** number of elements which may still be handed out to new per-thread
+     * magazines, protected by the global lock */
+    unsigned int available;
+    /** index of the depot in the per-thread tables */
+    unsigned int slot;
+    /** unique identifier of the depot */
+    uint64_t generation;
+    /** number of calls to @ref umagazine_vacuum, read by all threads */
+    uatomic_uint32_t vacuums;
+    /** call-back to release elements */
+    umagazine_free_cb free_cb;
+    /** opaque for the call-back */
+    void *opaque;
+    /** list of per-thread magazines */
+    struct uchain magazines;
+    /** statistics of the magazines of exited threads */
+    struct umagazine_stats stats;
+};
+
+/** @This initializes a magazine depot.
+ *
+ * @param umagazine pointer to a umagazine structure
+ * @param lifo pointer to the shared LIFO, initialized by the caller
+ * @param size number of elements in per-thread magazines, capped to
+ * @ref #UMAGAZINE_MAX_SIZE; below 2, magazines are disabled and all
+ * operations go directly to the shared LIFO
+ * @param max maximum number of elements kept in the magazines of all
+ * threads together; threads registering once it is exhausted work without
+ * magazines
+ * @param free_cb call-back to release elements
+ * @param opaque opaque for the call-back
+ */
+void umagazine_init(struct umagazine *umagazine, struct ulifo *lifo,
+                    unsigned int size, unsigned int max,
+                    umagazine_free_cb free_cb, void *opaque);
+
+/** @internal @This allocates an element from the magazine of the calling
+ * thread, refilling it from the shared LIFO if needed.
+ *
+ * @param umagazine pointer to a umagazine structure
+ * @return pointer to element, or NULL if the depot is empty
+ */
+void *umagazine_pop_internal(struct umagazine *umagazine);
+
+/** @This allocates an element with type checking.
+ *
+ * @param umagazine pointer to a umagazine structure
+ * @param type type of the opaque pointer
+ * @return pointer to element, or NULL if the depot is empty
+ */
+#define umagazine_pop(umagazine, type)                                      \
+    (type)umagazine_pop_internal(umagazine)
+
+/** @This releases an element to the magazine of the calling thread, flushing
+ * it to the shared LIFO if it is full. Elements which do not fit in the
+ * shared LIFO are released with the call-back.
+ *
+ * @param umagazine pointer to a umagazine structure
+ * @param element pointer to element (not NULL)
+ */
+void umagazine_push(struct umagazine *umagazine, void *element);
+
+/** @This releases all elements kept in the magazine of the calling thread,
+ * with the call-back. The other threads release the elements of their
+ * magazines the next time they use the depot, or when they exit.
+ *
+ * @param umagazine pointer to a umagazine structure
+ */
+void umagazine_vacuum(struct umagazine *umagazine);
+
+/** @This returns the statistics of a magazine depot. Counters of running
+ * threads are read with relaxed atomic loads, so they may lag behind.
+ *
+ * @param umagazine pointer to a umagazine structure
+ * @param stats filled in with the statistics
+ */
+void umagazine_stats(struct umagazine *umagazine,
+                     struct umagazine_stats *stats);
+
+/** @This cleans up a magazine depot, releasing the elements kept in the
+ * magazines of all threads with the call-back. No other thread may use the
+ * depot at this point. When it is the last depot alive, the per-thread
+ * table of the calling thread is also freed. Please note that it is the
+ * caller's responsibility to empty and clean the shared LIFO afterwards.
+ *
+ * @param umagazine pointer to a umagazine structure
+ */
+void umagazine_clean(struct umagazine *umagazine);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe pool-based memory allocator using a huge page arena
+ * This memory allocator carves buffers out of an arena reserved and
+ * prefaulted at allocation time, with huge pages if possible (MAP_HUGETLB,
+ * or transparent huge pages otherwise), and optionally bound to a NUMA node.
+ * Released buffers are kept in pools organized by power of 2's sizes, like
+ * @ref umem_pool_mgr_alloc; buffers of the arena are never given back to the
+ * system. It reverts to malloc() and free() if the arena is exhausted, and
+ * for buffers larger than the largest pool.
+ *
+ * It is intended for large buffers such as raw video pictures, and is a
+ * drop-in replacement for the umem manager given to @ref ubuf_pic_mem_mgr_alloc
+ * or @ref ubuf_block_mem_mgr_alloc.
+ */
+
+#ifndef _UPIPE_UMEM_HUGE_H_
+/** @hidden */
+#define _UPIPE_UMEM_HUGE_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/umem.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/** @This allocates a new instance of the umem huge manager allocating buffers
+ * from a huge page arena, using pools in power of 2's.
+ *
+ * @param arena_size size (in octets) of the arena to reserve, rounded up to
+ * the huge page size
+ * @param numa_node NUMA node to bind the arena to, or -1
+ * @param pool0_size size (in octets) of the smallest allocatable buffer; it
+ * must be a power of 2
+ * @param nb_pools number of buffer pools to maintain, with sizes in power of
+ * 2's increments, followed, for each pool, by the maximum number of buffers
+ * to keep in the pool (unsigned int); larger buffers will be directly managed
+ * with malloc() and free()
+ * @return pointer to manager, or NULL in case of error
+ */
+struct umem_mgr *umem_huge_mgr_alloc(size_t arena_size, int numa_node,
+                                     size_t pool0_size, size_t nb_pools, ...);
+
+/** @This allocates a new instance of the umem huge manager allocating buffers
+ * from a huge page arena, using pools in power of 2's from 4 KiB to 64 MiB,
+ * with a simpler API.
+ *
+ * @param arena_size size (in octets) of the arena to reserve, rounded up to
+ * the huge page size
+ * @param numa_node NUMA node to bind the arena to, or -1
+ * @param base_pools_depth number of buffers to keep in the pool for the smaller
+ * buffers; for larger buffers the same number is used, divided by 2, 4, or 8
+ * @return pointer to manager, or NULL in case of error
+ */
+struct umem_mgr *umem_huge_mgr_alloc_simple(size_t arena_size, int numa_node,
+                                            uint16_t base_pools_depth);
+
+/** @This returns whether the arena of a umem huge manager is backed by
+ * explicitly reserved huge pages (MAP_HUGETLB), as opposed to transparent
+ * huge pages or regular pages.
+ *
+ * @param mgr pointer to a umem manager allocated by @ref umem_huge_mgr_alloc
+ * @return true if the arena uses MAP_HUGETLB
+ */
+bool umem_huge_mgr_hugetlb(struct umem_mgr *mgr);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -27,7 +27,9 @@
  * @short Upipe pool-based memory allocator
  * This memory allocator keeps released memory blocks in pools organized by
  * power of 2's sizes, and reverts to malloc() and free() if the pool
- * underflows or overflows.
+ * underflows or overflows. Buffers of up to 64 KiB may also be kept in
+ * per-thread magazines in front of the pools (see @ref umagazine), if
+ * enabled with @ref umem_pool_mgr_set_magazines.
  */
 
 #ifndef _UPIPE_UMEM_POOL_H_
@@ -38,6 +40,7 @@ extern "C" {
 #endif
 
 #include <upipe/umem.h>
+#include <upipe/umagazine.h>
 
 /** @This allocates a new instance of the umem pool manager allocating buffers
  * from application memory, using pools in power of 2's.
@@ -52,6 +55,24 @@ extern "C" {
  */
 struct umem_mgr *umem_pool_mgr_alloc(size_t pool0_size, size_t nb_pools, ...);
 
+/** @This enables per-thread magazines in front of the pools of buffers of
+ * up to 64 KiB. The magazines of all threads together keep at most the
+ * depth of their pool. It must be called before the manager is used.
+ *
+ * @param mgr pointer to a umem manager allocated by @ref umem_pool_mgr_alloc
+ * @param size number of buffers in per-thread magazines (see
+ * @ref umagazine_init), or 0 to disable them
+ */
+void umem_pool_mgr_set_magazines(struct umem_mgr *mgr, unsigned int size);
+
+/** @This returns the statistics of the per-thread magazines of a umem pool
+ * manager, summed over all pools.
+ *
+ * @param mgr pointer to a umem manager allocated by @ref umem_pool_mgr_alloc
+ * @param stats filled in with the statistics
+ */
+void umem_pool_mgr_stats(struct umem_mgr *mgr, struct umagazine_stats *stats);
+
 
 /** @This allocates a new instance of the umem pool manager allocating buffers
  * from application memory, using pools in power of 2's, with a simpler API.
@@ -0,0 +1,349 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe thread-safe bounded multi-producer multi-consumer ring
+ *
+ * Each cell of the ring carries a sequence number telling whether it is
+ * ready to be pushed or popped for a given position, so that producers and
+ * consumers only contend on their own position counter. The number of cells
+ * is a power of two, and positions are 32-bit counters. When the requested
+ * length is not a power of two, producers additionally check that the
+ * element pushed length positions earlier was popped.
+ */
+
+#ifndef _UPIPE_UMPMC_H_
+/** @hidden */
+#define _UPIPE_UMPMC_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/ubase.h>
+#include <upipe/uatomic.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <sched.h>
+
+/** @This is the size of a cache line, used to separate the positions. */
+#define UMPMC_CACHE_LINE_SIZE 64
+
+/** @This is the maximum number of elements in a umpmc. */
+#define UMPMC_MAX_LENGTH (UINT32_C(1) << 31)
+
+/** @This is the number of times a thread spins on a cell reserved by another
+ * thread before yielding the CPU. */
+#define UMPMC_SPINS 64
+
+/** @This defines a cell of the ring. */
+struct umpmc_cell {
+    /** position for which the cell may be pushed, or position + 1 for which
+     * it may be popped */
+    uatomic_uint32_t sequence;
+    /** pointer to opaque structure */
+    void *opaque;
+};
+
+/** @This is the implementation of a bounded multi-producer multi-consumer
+ * ring. */
+struct umpmc {
+    /** mask to apply to a position to get the index of its cell */
+    uint32_t mask;
+    /** maximum number of elements in the ring */
+    uint32_t length;
+    /** array of cells */
+    struct umpmc_cell *cells;
+
+    /** padding so that the positions are not in the same cache line */
+    uint8_t padding1[UMPMC_CACHE_LINE_SIZE];
+    /** position of the next element to push */
+    uatomic_uint32_t push_pos;
+    /** padding so that the positions are not in the same cache line */
+    uint8_t padding2[UMPMC_CACHE_LINE_SIZE];
+    /** position of the next element to pop */
+    uatomic_uint32_t pop_pos;
+    /** padding so that the positions are not in the same cache line */
+    uint8_t padding3[UMPMC_CACHE_LINE_SIZE];
+};
+
+/** @internal @This returns the number of cells of a umpmc, which is the
+ * requested length rounded up to a power of two. At least two cells are
+ * needed so that a full cell may be told apart from an empty cell of the
+ * next lap.
+ *
+ * @param length maximum number of elements in the ring
+ * @return number of cells
+ */
+static inline uint32_t umpmc_cells(uint32_t length)
+{
+    assert(length && length <= UMPMC_MAX_LENGTH);
+    uint32_t cells = 2;
+    while (cells < length)
+        cells <<= 1;
+    return cells;
+}
+
+/** @This returns the required size of extra data space for umpmc.
+ *
+ * @param length maximum number of elements in the ring
+ * @return size in octets to allocate
+ */
+#define umpmc_sizeof(length) (umpmc_cells(length) * sizeof(struct umpmc_cell))
+
+/** @This initializes a umpmc.
+ *
+ * @param umpmc pointer to a umpmc structure
+ * @param length maximum number of elements in the ring
+ * @param extra mandatory extra space allocated by the caller, with the size
+ * returned by @ref #umpmc_sizeof
+ */
+static inline void umpmc_init(struct umpmc *umpmc, uint32_t length,
+                              void *extra)
+{
+    uint32_t cells = umpmc_cells(length);
+    umpmc->mask = cells - 1;
+    umpmc->length = length;
+    umpmc->cells = (struct umpmc_cell *)extra;
+    for (uint32_t i = 0; i < cells; i++) {
+        uatomic_init(&umpmc->cells[i].sequence, i);
+        umpmc->cells[i].opaque = NULL;
+    }
+    uatomic_init(&umpmc->push_pos, 0);
+    uatomic_init(&umpmc->pop_pos, 0);
+}
+
+/** @This returns the maximum number of elements of a umpmc.
+ *
+ * @param umpmc pointer to a umpmc structure
+ * @return maximum number of elements in the ring
+ */
+static inline uint32_t umpmc_capacity(struct umpmc *umpmc)
+{
+    return umpmc->length;
+}
+
+/** @internal @This checks whether a cell is ready for a given position.
+ *
+ * @param umpmc pointer to a umpmc structure
+ * @param pos position to push or pop
+ * @param offset 0 to check for pushing, 1 for popping
+ * @return true if the cell is ready
+ */
+static inline bool umpmc_ready(struct umpmc *umpmc, uint32_t pos,
+                               uint32_t offset)
+{
+    if (uatomic_load(&umpmc->cells[pos & umpmc->mask].sequence) !=
+            pos + offset)
+        return false;
+    if (offset || umpmc->length > umpmc->mask)
+        return true;
+    /* the element pushed length positions earlier must have been popped */
+    uint32_t prev = pos - umpmc->length;
+    return uatomic_load(&umpmc->cells[prev & umpmc->mask].sequence) ==
+           prev + umpmc->mask + 1;
+}
+
+/** @internal @This checks whether the cell for a given position, though not
+ * ready yet, was already reserved by a thread on the other side of the
+ * ring, which is about to release it.
+ *
+ * @param umpmc pointer to a umpmc structure
+ * @param pos position to push or pop
+ * @param offset 0 to check for pushing, 1 for popping
+ * @return true if the cell will be ready as soon as the other thread is done
+ */
+static inline bool umpmc_pending(struct umpmc *umpmc, uint32_t pos,
+                                 uint32_t offset)
+{
+    if (offset)
+        /* a producer reserved the position but didn't publish it yet */
+        return (int32_t)(uatomic_load(&umpmc->push_pos) - pos) > 0;
+    /* a consumer reserved the position length positions earlier but didn't
+     * release it yet */
+    return (int32_t)(pos - uatomic_load(&umpmc->pop_pos)) <
+           (int32_t)umpmc->length;
+}
+
+/** @internal @This waits for a short while, for another thread to release
+ * a cell it reserved.
+ *
+ * @param spins number of times the function was already called for the
+ * same cell
+ */
+static inline void umpmc_relax(unsigned int spins)
+{
+    if (spins >= UMPMC_SPINS) {
+        /* the other thread may have been preempted */
+        sched_yield();
+        return;
+    }
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_ia32_pause();
+#endif
+}
+
+/** @internal @This reserves consecutive cells for pushing or popping. If the
+ * first cell was reserved by a thread on the other side of the ring but not
+ * released yet, this function waits for it, so that an element counted in
+ * (or out) by the other side is never missed.
+ *
+ * @param umpmc pointer to a umpmc structure
+ * @param pos_p pointer to the position to increment
+ * @param offset 0 to reserve cells for pushing, 1 for popping
+ * @param nb maximum number of cells to reserve
+ * @param first_p filled in with the position of the first reserved cell
+ * @return number of reserved cells, or 0 if the ring is full (for pushing)
+ * or empty (for popping)
+ */
+static inline unsigned int umpmc_reserve(struct umpmc *umpmc,
+                                         uatomic_uint32_t *pos_p,
+                                         uint32_t offset, unsigned int nb,
+                                         uint32_t *first_p)
+{
+    uint32_t pos = uatomic_load(pos_p);
+    unsigned int spins = 0;
+    for ( ; ; ) {
+        unsigned int i;
+        for (i = 0; i < nb; i++)
+            if (!umpmc_ready(umpmc, pos + i, offset))
+                break;
+
+        if (unlikely(!i)) {
+            uint32_t current = uatomic_load(pos_p);
+            if (current != pos) {
+                /* another thread took the position */
+                pos = current;
+                spins = 0;
+                continue;
+            }
+            if (!umpmc_pending(umpmc, pos, offset))
+                /* the ring is full (for pushing) or empty (for popping) */
+                return 0;
+            umpmc_relax(spins++);
+            continue;
+        }
+
+        if (likely(uatomic_compare_exchange(pos_p, &pos, pos + i))) {
+            *first_p = pos;
+            return i;
+        }
+        spins = 0;
+    }
+}
+
+/** @This pushes new elements, in order, as long as there is space left.
+ *
+ * @param umpmc pointer to a umpmc structure
+ * @param opaques array of opaques to associate with elements (not NULL)
+ * @param nb number of elements in the array
+ * @return number of pushed elements
+ */
+static inline unsigned int umpmc_push_batch(struct umpmc *umpmc,
+                                            void **opaques, unsigned int nb)
+{
+    uint32_t pos;
+    unsigned int pushed = umpmc_reserve(umpmc, &umpmc->push_pos, 0, nb,
+                                        &pos);
+    for (unsigned int i = 0; i < pushed; i++) {
+        struct umpmc_cell *cell = &umpmc->cells[(pos + i) & umpmc->mask];
+        assert(opaques[i] != NULL);
+        cell->opaque = opaques[i];
+        uatomic_store(&cell->sequence, pos + i + 1);
+    }
+    return pushed;
+}
+
+/** @This pushes a new element.
+ *
+ * @param umpmc pointer to a umpmc structure
+ * @param opaque opaque to associate with element (not NULL)
+ * @return false if the maximum number of elements was reached and the
+ * element couldn't be queued
+ */
+static inline bool umpmc_push(struct umpmc *umpmc, void *opaque)
+{
+    return umpmc_push_batch(umpmc, &opaque, 1) == 1;
+}
+
+/** @This pops elements, in order, as long as there are some.
+ *
+ * @param umpmc pointer to a umpmc structure
+ * @param opaques array filled in with the popped opaques
+ * @param nb maximum number of elements to pop
+ * @return number of popped elements
+ */
+static inline unsigned int umpmc_pop_batch(struct umpmc *umpmc,
+                                           void **opaques, unsigned int nb)
+{
+    uint32_t pos;
+    unsigned int popped = umpmc_reserve(umpmc, &umpmc->pop_pos, 1, nb, &pos);
+    for (unsigned int i = 0; i < popped; i++) {
+        struct umpmc_cell *cell = &umpmc->cells[(pos + i) & umpmc->mask];
+        opaques[i] = cell->opaque;
+        cell->opaque = NULL;
+        uatomic_store(&cell->sequence, pos + i + umpmc->mask + 1);
+    }
+    return popped;
+}
+
+/** @internal @This pops an element.
+ *
+ * @param umpmc pointer to a umpmc structure
+ * @return pointer to opaque, or NULL if the ring is empty
+ */
+static inline void *umpmc_pop_internal(struct umpmc *umpmc)
+{
+    void *opaque;
+    if (!umpmc_pop_batch(umpmc, &opaque, 1))
+        return NULL;
+    return opaque;
+}
+
+/** @This pops an element with type checking.
+ *
+ * @param umpmc pointer to a umpmc structure
+ * @param type type of the opaque pointer
+ * @return pointer to opaque, or NULL if the ring is empty
+ */
+#define umpmc_pop(umpmc, type) (type)umpmc_pop_internal(umpmc)
+
+/** @This cleans up the umpmc data structure. Please note that it is the
+ * caller's responsibility to empty the ring first, and to release the
+ * extra data passed to @ref umpmc_init.
+ *
+ * @param umpmc pointer to a umpmc structure
+ */
+static inline void umpmc_clean(struct umpmc *umpmc)
+{
+    for (uint32_t i = 0; i <= umpmc->mask; i++)
+        uatomic_clean(&umpmc->cells[i].sequence);
+    uatomic_clean(&umpmc->push_pos);
+    uatomic_clean(&umpmc->pop_pos);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
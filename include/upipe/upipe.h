@@ -61,6 +61,8 @@ struct ubuf_mgr;
 struct upipe_mgr;
 /** @hidden */
 struct upump;
+/** @hidden */
+struct upipe_stats;
 
 /** @This defines standard commands which upipe modules may implement. */
 enum upipe_command {
@@ -165,6 +167,9 @@ struct upipe {
     struct uprobe *uprobe;
     /** pointer to the manager for this pipe type */
     struct upipe_mgr *mgr;
+    /** pointer to the instrumentation counters, or NULL (see
+     * @ref upipe_stats) */
+    struct upipe_stats *stats;
 };
 
 UBASE_FROM_TO(upipe, uchain, uchain, uchain)
@@ -421,6 +426,7 @@ static inline void upipe_init(struct upipe *upipe, struct upipe_mgr *mgr,
     upipe->uprobe = uprobe;
     upipe->refcount = NULL;
     upipe->mgr = mgr;
+    upipe->stats = NULL;
     upipe_mgr_use(mgr);
 }
 
@@ -578,7 +584,7 @@ static inline void upipe_log_va(struct upipe *upipe,
                                 enum uprobe_log_level level,
                                 const char *format, ...)
 {
-    UBASE_VARARG(upipe_log(upipe, level, string))
+    UPROBE_LOG_VARARG(upipe->uprobe, upipe, level)
 }
 
 /** @This throws an error event. This event is thrown whenever a pipe wants
@@ -596,7 +602,7 @@ static inline void upipe_log_va(struct upipe *upipe,
  */
 static inline void upipe_err_va(struct upipe *upipe, const char *format, ...)
 {
-    UBASE_VARARG(upipe_err(upipe, string))
+    UPROBE_LOG_VARARG(upipe->uprobe, upipe, UPROBE_LOG_ERROR)
 }
 
 /** @This throws a warning event. This event is thrown whenever a pipe wants
@@ -614,7 +620,7 @@ static inline void upipe_err_va(struct upipe *upipe, const char *format, ...)
  */
 static inline void upipe_warn_va(struct upipe *upipe, const char *format, ...)
 {
-    UBASE_VARARG(upipe_warn(upipe, string))
+    UPROBE_LOG_VARARG(upipe->uprobe, upipe, UPROBE_LOG_WARNING)
 }
 
 /** @This throws a notice statement event. This event is thrown whenever a pipe
@@ -632,7 +638,7 @@ static inline void upipe_warn_va(struct upipe *upipe, const char *format, ...)
  */
 static inline void upipe_notice_va(struct upipe *upipe, const char *format, ...)
 {
-    UBASE_VARARG(upipe_notice(upipe, string))
+    UPROBE_LOG_VARARG(upipe->uprobe, upipe, UPROBE_LOG_NOTICE)
 }
 
 /** @This throws a debug statement event. This event is thrown whenever a pipe
@@ -650,7 +656,7 @@ static inline void upipe_notice_va(struct upipe *upipe, const char *format, ...)
  */
 static inline void upipe_dbg_va(struct upipe *upipe, const char *format, ...)
 {
-    UBASE_VARARG(upipe_dbg(upipe, string))
+    UPROBE_LOG_VARARG(upipe->uprobe, upipe, UPROBE_LOG_DEBUG)
 }
 
 /** @This throws a verbose statement event. This event is thrown whenever a pipe
@@ -670,7 +676,7 @@ static inline void upipe_dbg_va(struct upipe *upipe, const char *format, ...)
 static inline void upipe_verbose_va(struct upipe *upipe,
                                     const char *format, ...)
 {
-    UBASE_VARARG(upipe_verbose(upipe, string))
+    UPROBE_LOG_VARARG(upipe->uprobe, upipe, UPROBE_LOG_VERBOSE)
 }
 
 /** @This throws a fatal error event. After this event, the behaviour
@@ -971,6 +977,27 @@ static inline int upipe_throw_proxy(struct upipe *upipe, struct upipe *inner,
     return UBASE_ERR_NONE;
 }
 
+/** @This throws an event carrying the instrumentation counters of a pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static inline int upipe_throw_stats(struct upipe *upipe)
+{
+    assert(upipe->stats != NULL);
+    return upipe_throw(upipe, UPROBE_STATS, upipe->stats);
+}
+
+/** @internal @This sends an input buffer into an instrumented pipe, and
+ * updates its counters (see @ref upipe_stats).
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure to send
+ * @param upump_p reference to the pump that generated the buffer
+ */
+void upipe_stats_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p);
+
 /** @This sends an input buffer into a pipe. Note that all inputs and control
  * commands must be executed from the same thread - no reentrancy or locking
  * is required from the pipe. Also note that uref is then owned by the callee
@@ -989,6 +1016,10 @@ static inline void upipe_input(struct upipe *upipe, struct uref *uref,
         uref_free(uref);
         return;
     }
+    if (unlikely(upipe->stats != NULL)) {
+        upipe_stats_input(upipe, uref, upump_p);
+        return;
+    }
     upipe_use(upipe);
     upipe->mgr->upipe_input(upipe, uref, upump_p);
     upipe_release(upipe);
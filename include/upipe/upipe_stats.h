@@ -0,0 +1,197 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe instrumentation counters of pipes
+ * A pipe whose stats pointer is set goes through an instrumented
+ * @ref upipe_input, which counts the urefs and octets it receives, and
+ * measures the time spent in its input function. The time spent in the input
+ * functions of other instrumented pipes called from there is accounted to
+ * them and not to the caller, so that the self times of a pipeline add up to
+ * the CPU time it takes.
+ *
+ * Each thread keeps the stack of instrumented pipes it is running, to count
+ * the urefs output by a pipe when they enter the next instrumented pipe.
+ * Counters are only written by the thread running the pipe, without locks,
+ * and accessed with relaxed atomic operations, so that they may be read from
+ * another thread; each counter is then exact, but the set of counters is not
+ * a consistent snapshot.
+ *
+ * Counters are usually attached to all pipes of a pipeline by
+ * @ref uprobe_stats_alloc.
+ */
+
+#ifndef _UPIPE_UPIPE_STATS_H_
+/** @hidden */
+#define _UPIPE_UPIPE_STATS_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/ubase.h>
+#include <upipe/uatomic.h>
+#include <upipe/upipe.h>
+
+#include <stdint.h>
+#include <stdio.h>
+
+/** @This is the number of buckets of the histogram of input times; bucket n
+ * counts the calls lasting less than 2^n nanoseconds. */
+#define UPIPE_STATS_BUCKETS 32
+
+/** @This stores the instrumentation counters of a pipe. */
+struct upipe_stats {
+    /** number of urefs received */
+    uatomic_uint64_t urefs_in;
+    /** number of urefs output to instrumented pipes */
+    uatomic_uint64_t urefs_out;
+    /** number of octets of block urefs received */
+    uatomic_uint64_t bytes_in;
+    /** number of octets of block urefs output to instrumented pipes */
+    uatomic_uint64_t bytes_out;
+    /** time spent in the input function, including downstream pipes, in
+     * nanoseconds */
+    uatomic_uint64_t total_time;
+    /** time spent in the input function, excluding other instrumented
+     * pipes, in nanoseconds */
+    uatomic_uint64_t self_time;
+    /** longest self time of a call, in nanoseconds */
+    uatomic_uint64_t max_time;
+    /** histogram of the self time of calls */
+    uatomic_uint64_t histogram[UPIPE_STATS_BUCKETS];
+    /** last reported depth of the queue of the pipe */
+    uatomic_uint64_t queue_depth;
+    /** highest reported depth of the queue of the pipe */
+    uatomic_uint64_t queue_depth_max;
+};
+
+/** @internal @This adds a value to a counter, from the thread running the
+ * pipe.
+ *
+ * @param counter pointer to the counter
+ * @param value value to add
+ */
+static inline void upipe_stats_add(uatomic_uint64_t *counter,
+                                   uint64_t value)
+{
+    uatomic64_store_relaxed(counter, uatomic64_load_relaxed(counter) + value);
+}
+
+/** @internal @This sets a counter, from the thread running the pipe.
+ *
+ * @param counter pointer to the counter
+ * @param value new value
+ */
+static inline void upipe_stats_set(uatomic_uint64_t *counter,
+                                   uint64_t value)
+{
+    uatomic64_store_relaxed(counter, value);
+}
+
+/** @internal @This raises a counter to a value if it is lower, from any
+ * thread.
+ *
+ * @param counter pointer to the counter
+ * @param value candidate maximum
+ */
+static inline void upipe_stats_max(uatomic_uint64_t *counter, uint64_t value)
+{
+    uint64_t max = uatomic64_load_relaxed(counter);
+    while (value > max && !uatomic64_compare_exchange(counter, &max, value));
+}
+
+/** @internal @This reads a counter, from any thread.
+ *
+ * @param counter pointer to the counter
+ * @return value of the counter
+ */
+static inline uint64_t upipe_stats_get(const uatomic_uint64_t *counter)
+{
+    return uatomic64_load_relaxed((uatomic_uint64_t *)counter);
+}
+
+/** @This initializes the counters of a pipe.
+ *
+ * @param stats pointer to the counters
+ */
+void upipe_stats_init(struct upipe_stats *stats);
+
+/** @This cleans up the counters of a pipe.
+ *
+ * @param stats pointer to the counters
+ */
+void upipe_stats_clean(struct upipe_stats *stats);
+
+/** @This returns the current date used by the counters.
+ *
+ * @return monotonic date in nanoseconds
+ */
+uint64_t upipe_stats_now(void);
+
+/** @This returns an upper bound of the given percentile of the self time of
+ * calls, from the histogram.
+ *
+ * @param stats pointer to the counters
+ * @param percentile percentile between 0 and 100
+ * @return duration in nanoseconds, or 0 if there was no call
+ */
+uint64_t upipe_stats_percentile(const struct upipe_stats *stats,
+                                unsigned int percentile);
+
+/** @This prints the counters of a pipe on a single line.
+ *
+ * @param stats pointer to the counters
+ * @param name name of the pipe
+ * @param elapsed duration of the measurement, in nanoseconds, to print the
+ * load of the pipe, or 0
+ * @param file file to print to
+ */
+void upipe_stats_dump(const struct upipe_stats *stats, const char *name,
+                      uint64_t elapsed, FILE *file);
+
+/** @This prints the header of the lines printed by @ref upipe_stats_dump.
+ *
+ * @param file file to print to
+ */
+void upipe_stats_dump_header(FILE *file);
+
+/** @This reports the depth of the queue of a pipe, for pipes which have
+ * one. It does nothing if the pipe is not instrumented.
+ *
+ * @param upipe description structure of the pipe
+ * @param depth number of elements in the queue
+ */
+static inline void upipe_stats_queue_depth(struct upipe *upipe,
+                                           uint64_t depth)
+{
+    struct upipe_stats *stats = upipe->stats;
+    if (likely(stats == NULL))
+        return;
+    upipe_stats_set(&stats->queue_depth, depth);
+    upipe_stats_max(&stats->queue_depth_max, depth);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -105,6 +105,9 @@ enum uprobe_event {
     /** a pipe signals that a uref contains a UTC clock reference
      * (struct uref *, uint64_t) */
     UPROBE_CLOCK_UTC,
+    /** a pipe reports its instrumentation counters
+     * (const struct upipe_stats *) */
+    UPROBE_STATS,
 
     /** non-standard events implemented by a module type can start from
      * there (first arg = signature) */
@@ -139,11 +142,26 @@ static inline const char *uprobe_event_str(int event)
     case UPROBE_CLOCK_REF: return "UPROBE_CLOCK_REF";
     case UPROBE_CLOCK_TS: return "UPROBE_CLOCK_TS";
     case UPROBE_CLOCK_UTC: return "UPROBE_CLOCK_UTC";
+    case UPROBE_STATS: return "UPROBE_STATS";
     case UPROBE_LOCAL: break;
     }
     return NULL;
 }
 
+/** @This describes how a probe handles log events, so that messages which
+ * would be dropped by the probe hierarchy are not even formatted. */
+enum uprobe_log_mode {
+    /** the probe may handle log messages of any level in any way (default) */
+    UPROBE_LOG_MODE_UNKNOWN = 0,
+    /** the probe passes log messages of at least its level to the next
+     * probe, and only looks at their level and prefixes */
+    UPROBE_LOG_MODE_FORWARD,
+    /** the probe prints log messages of at least its level, accepts
+     * deferred formatting (see @ref ulog_msg), and does not pass log
+     * messages to the next probe */
+    UPROBE_LOG_MODE_SINK
+};
+
 /** @This is the call-back type for uprobe events. */
 typedef int (*uprobe_throw_func)(struct uprobe *, struct upipe *, int, va_list);
 
@@ -156,6 +174,11 @@ struct uprobe {
     uprobe_throw_func uprobe_throw;
     /** pointer to next probe, to be used by the uprobe_throw function */
     struct uprobe *next;
+
+    /** how the probe handles log events */
+    enum uprobe_log_mode log_mode;
+    /** minimum level of log messages handled by the probe */
+    enum uprobe_log_level log_level;
 };
 
 /** @This increments the reference count of a uprobe.
@@ -222,6 +245,52 @@ static inline void uprobe_init(struct uprobe *uprobe,
     uprobe->refcount = NULL;
     uprobe->uprobe_throw = uprobe_throw;
     uprobe->next = next;
+    uprobe->log_mode = UPROBE_LOG_MODE_UNKNOWN;
+    uprobe->log_level = UPROBE_LOG_VERBOSE;
+}
+
+/** @This declares how a probe handles log events. It is typically called by
+ * the initializer of probes which forward or print log messages.
+ *
+ * @param uprobe pointer to probe
+ * @param log_mode how the probe handles log events
+ * @param log_level minimum level of log messages handled by the probe
+ */
+static inline void uprobe_set_log_mode(struct uprobe *uprobe,
+                                       enum uprobe_log_mode log_mode,
+                                       enum uprobe_log_level log_level)
+{
+    assert(uprobe != NULL);
+    uprobe->log_mode = log_mode;
+    uprobe->log_level = log_level;
+}
+
+/** @This returns the minimum level of log messages which may have an effect
+ * when thrown to a probe hierarchy. Messages of a lower level would be
+ * dropped, and need not be formatted.
+ *
+ * @param uprobe pointer to probe hierarchy
+ * @param deferred_p filled in with true if the hierarchy accepts log
+ * messages whose formatting is deferred (may be NULL)
+ * @return minimum level of log messages
+ */
+static inline enum uprobe_log_level
+    uprobe_log_min_level(struct uprobe *uprobe, bool *deferred_p)
+{
+    enum uprobe_log_level level = UPROBE_LOG_VERBOSE;
+    for ( ; uprobe != NULL; uprobe = uprobe->next) {
+        if (uprobe->log_level > level)
+            level = uprobe->log_level;
+        if (uprobe->log_mode != UPROBE_LOG_MODE_FORWARD) {
+            if (deferred_p != NULL)
+                *deferred_p = uprobe->log_mode == UPROBE_LOG_MODE_SINK;
+            return level;
+        }
+    }
+    /* nobody handles log messages */
+    if (deferred_p != NULL)
+        *deferred_p = false;
+    return UPROBE_LOG_ERROR;
 }
 
 /** @This cleans up a uprobe structure. It is typically called by the
@@ -296,11 +365,31 @@ static inline int uprobe_throw_next(struct uprobe *uprobe, struct upipe *upipe,
 static inline void uprobe_log(struct uprobe *uprobe, struct upipe *upipe,
                               enum uprobe_log_level level, const char *msg)
 {
+    if (uprobe_log_min_level(uprobe, NULL) > level)
+        return;
     struct ulog ulog;
     ulog_init(&ulog, level, msg);
     uprobe_throw(uprobe, upipe, UPROBE_LOG, &ulog);
 }
 
+/** @internal @This is a helper to simplify printf-style log functions. The
+ * message is not formatted if the probe hierarchy would drop it, and its
+ * formatting is deferred to the sink if the hierarchy accepts it. */
+#define UPROBE_LOG_VARARG(uprobe, upipe, level)                             \
+    bool deferred;                                                          \
+    if (uprobe_log_min_level(uprobe, &deferred) > (level))                  \
+        return;                                                             \
+    if (deferred) {                                                         \
+        struct ulog ulog;                                                   \
+        va_list args;                                                       \
+        va_start(args, format);                                             \
+        ulog_init_va(&ulog, level, format, &args);                          \
+        uprobe_throw(uprobe, upipe, UPROBE_LOG, &ulog);                     \
+        va_end(args);                                                       \
+        return;                                                             \
+    }                                                                       \
+    UBASE_VARARG(uprobe_log(uprobe, upipe, level, string))
+
 /** @internal @This throws a log event, with printf-style message generation.
  *
  * @param uprobe pointer to probe hierarchy
@@ -312,7 +401,7 @@ static inline void uprobe_log_va(struct uprobe *uprobe, struct upipe *upipe,
                                 enum uprobe_log_level level,
                                 const char *format, ...)
 {
-    UBASE_VARARG(uprobe_log(uprobe, upipe, level, string))
+    UPROBE_LOG_VARARG(uprobe, upipe, level)
 }
 
 /** @This throws an error event. This event is thrown whenever a pipe wants
@@ -334,7 +423,7 @@ static inline void uprobe_log_va(struct uprobe *uprobe, struct upipe *upipe,
 static inline void uprobe_err_va(struct uprobe *uprobe, struct upipe *upipe,
                                  const char *format, ...)
 {
-    UBASE_VARARG(uprobe_err(uprobe, upipe, string))
+    UPROBE_LOG_VARARG(uprobe, upipe, UPROBE_LOG_ERROR)
 }
 
 /** @This throws a warning event. This event is thrown whenever a pipe wants
@@ -356,7 +445,7 @@ static inline void uprobe_err_va(struct uprobe *uprobe, struct upipe *upipe,
 static inline void uprobe_warn_va(struct uprobe *uprobe, struct upipe *upipe,
                                   const char *format, ...)
 {
-    UBASE_VARARG(uprobe_warn(uprobe, upipe, string))
+    UPROBE_LOG_VARARG(uprobe, upipe, UPROBE_LOG_WARNING)
 }
 
 /** @This throws a notice statement event. This event is thrown whenever a pipe
@@ -378,7 +467,7 @@ static inline void uprobe_warn_va(struct uprobe *uprobe, struct upipe *upipe,
 static inline void uprobe_notice_va(struct uprobe *uprobe, struct upipe *upipe,
                                     const char *format, ...)
 {
-    UBASE_VARARG(uprobe_notice(uprobe, upipe, string))
+    UPROBE_LOG_VARARG(uprobe, upipe, UPROBE_LOG_NOTICE)
 }
 
 /** @This throws a debug statement event. This event is thrown whenever a pipe
@@ -400,7 +489,7 @@ static inline void uprobe_notice_va(struct uprobe *uprobe, struct upipe *upipe,
 static inline void uprobe_dbg_va(struct uprobe *uprobe, struct upipe *upipe,
                                  const char *format, ...)
 {
-    UBASE_VARARG(uprobe_dbg(uprobe, upipe, string))
+    UPROBE_LOG_VARARG(uprobe, upipe, UPROBE_LOG_DEBUG)
 }
 
 /** @This throws a verbose statement event. This event is thrown whenever a
@@ -423,7 +512,7 @@ static inline void uprobe_dbg_va(struct uprobe *uprobe, struct upipe *upipe,
 static inline void uprobe_verbose_va(struct uprobe *uprobe, struct upipe *upipe,
                                  const char *format, ...)
 {
-    UBASE_VARARG(uprobe_verbose(uprobe, upipe, string))
+    UPROBE_LOG_VARARG(uprobe, upipe, UPROBE_LOG_VERBOSE)
 }
 
 /** @This throws a fatal error event. After this event, the behaviour
@@ -83,6 +83,14 @@ struct uprobe *uprobe_pfx_alloc(struct uprobe *next,
                                 enum uprobe_log_level min_level,
                                 const char *name);
 
+/** @This returns the name of a pipe if the given probe is a uprobe pfx.
+ *
+ * @param uprobe pointer to any probe
+ * @return name of the pipe, or NULL if the probe is not a uprobe pfx or has
+ * no name
+ */
+const char *uprobe_pfx_get_name(struct uprobe *uprobe);
+
 /** @This allocates a new uprobe pfx structure, with printf-style name
  * generation.
  *
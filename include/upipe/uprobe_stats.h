@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short probe instrumenting the pipes using it
+ *
+ * The probe catches the ready events and attaches instrumentation counters
+ * (see @ref upipe_stats) to the pipes, which are named after the
+ * @ref uprobe_pfx probes between them and this probe. When a pipe dies, its
+ * counters are reported with a @ref UPROBE_STATS event to the next probe.
+ *
+ * Pipes allocated before the probe is inserted in their hierarchy are not
+ * instrumented.
+ */
+
+#ifndef _UPIPE_UPROBE_STATS_H_
+/** @hidden */
+#define _UPIPE_UPROBE_STATS_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/ubase.h>
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_helper_uprobe.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <pthread.h>
+
+/** @This is a super-set of the uprobe structure with additional local
+ * members. */
+struct uprobe_stats {
+    /** protects the list of pipes */
+    pthread_mutex_t lock;
+    /** list of instrumented pipes */
+    struct uchain pipes;
+    /** date of initialization, in nanoseconds */
+    uint64_t start;
+
+    /** structure exported to modules */
+    struct uprobe uprobe;
+};
+
+UPROBE_HELPER_UPROBE(uprobe_stats, uprobe)
+
+/** @This initializes an already allocated uprobe stats structure.
+ *
+ * @param uprobe_stats pointer to the already allocated structure
+ * @param next next probe to test if this one doesn't catch the event
+ * @return pointer to uprobe, or NULL in case of error
+ */
+struct uprobe *uprobe_stats_init(struct uprobe_stats *uprobe_stats,
+                                 struct uprobe *next);
+
+/** @This cleans a uprobe stats structure.
+ *
+ * @param uprobe_stats structure to clean
+ */
+void uprobe_stats_clean(struct uprobe_stats *uprobe_stats);
+
+/** @This allocates a new uprobe stats structure.
+ *
+ * @param next next probe to test if this one doesn't catch the event
+ * @return pointer to uprobe, or NULL in case of error
+ */
+struct uprobe *uprobe_stats_alloc(struct uprobe *next);
+
+/** @This prints the counters of all pipes currently instrumented by the
+ * probe. It may be called from any thread.
+ *
+ * @param uprobe pointer to probe
+ * @param file file to print to
+ */
+void uprobe_stats_dump(struct uprobe *uprobe, FILE *file);
+
+/** @This throws a @ref UPROBE_STATS event to the next probe for every pipe
+ * currently instrumented by the probe. As with all events, it must be called
+ * from the thread running the pipes. The next probe must not call
+ * @ref uprobe_stats_dump.
+ *
+ * @param uprobe pointer to probe
+ */
+void uprobe_stats_report(struct uprobe *uprobe);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -42,7 +42,12 @@ extern "C" {
 #include <stdbool.h>
 #include <stdarg.h>
 #include <assert.h>
+#include <sys/types.h>
 
+/** @hidden */
+struct iovec;
+/** @hidden */
+struct msghdr;
 /** @hidden */
 struct upump_mgr;
 /** @hidden */
@@ -62,10 +67,48 @@ enum upump_type {
     UPUMP_TYPE_FD_READ,
     /** event triggers on available writing space to file descriptor
      * (argument = int) */
-    UPUMP_TYPE_FD_WRITE
+    UPUMP_TYPE_FD_WRITE,
+    /** event triggers when an operation on a file descriptor, performed by
+     * the event loop itself, is completed (argument = struct upump_io *) */
+    UPUMP_TYPE_IO
     /* TODO: Windows objects */
 };
 
+/** types of operations performed by I/O pumps */
+enum upump_io_type {
+    /** reads into buffers, like readv(2) */
+    UPUMP_IO_READ,
+    /** writes buffers, like writev(2) */
+    UPUMP_IO_WRITE,
+    /** receives a message, like recvmsg(2) */
+    UPUMP_IO_RECVMSG,
+    /** sends a message, like sendmsg(2) */
+    UPUMP_IO_SENDMSG
+};
+
+/** @This describes the operation of an I/O pump. The operation is submitted
+ * when the pump is started, and submitted again after each call to the
+ * callback as long as the pump stays started, so the callback may change the
+ * buffers of the next operation. The structure belongs to the caller and
+ * must remain valid, as well as the buffers, as long as the pump exists. */
+struct upump_io {
+    /** type of operation */
+    enum upump_io_type type;
+    /** file descriptor */
+    int fd;
+    /** buffers of read and write operations */
+    const struct iovec *iovecs;
+    /** number of buffers */
+    int iovec_count;
+    /** message header of message operations */
+    struct msghdr *msg;
+    /** position in the file, or -1 for the current position */
+    int64_t offset;
+    /** filled in with the result of the operation, in octets, or a negative
+     * errno value */
+    ssize_t ret;
+};
+
 /** function called when a pump is triggered */
 typedef void (*upump_cb)(struct upump *);
 
@@ -99,6 +142,8 @@ UBASE_FROM_TO(upump, uchain, uchain, uchain)
 enum upump_mgr_command {
     /** release all buffers kept in pools (void) */
     UPUMP_MGR_VACUUM,
+    /** groups timers in a timer wheel with the given slack (uint64_t) */
+    UPUMP_MGR_SET_TIMER_SLACK,
 
     /** non-standard manager commands implemented by a module type can start
      * from there (first arg = signature) */
@@ -240,6 +285,28 @@ static inline struct upump *upump_alloc_fd_write(struct upump_mgr *mgr,
     return upump_alloc(mgr, cb, opaque, refcount, UPUMP_TYPE_FD_WRITE, fd);
 }
 
+/** @This allocates and initializes a pump performing operations on a file
+ * descriptor. Event loops based on readiness notifications do not support
+ * it, so the caller must be prepared to fall back to
+ * @ref upump_alloc_fd_read or @ref upump_alloc_fd_write.
+ *
+ * @param mgr management structure for this event loop
+ * @param cb function to call when an operation is completed
+ * @param opaque pointer to the module's internal structure
+ * @param refcount pointer to urefcount structure to increment during callback,
+ * or NULL
+ * @param io description of the operation
+ * @return pointer to allocated pump, or NULL in case of failure or if the
+ * event loop does not support I/O pumps
+ */
+static inline struct upump *upump_alloc_io(struct upump_mgr *mgr,
+                                           upump_cb cb, void *opaque,
+                                           struct urefcount *refcount,
+                                           struct upump_io *io)
+{
+    return upump_alloc(mgr, cb, opaque, refcount, UPUMP_TYPE_IO, io);
+}
+
 /** @This asks the event loop to start monitoring a pump.
  *
  * @param pump description structure of the pump
@@ -380,6 +447,23 @@ static inline int upump_mgr_vacuum(struct upump_mgr *mgr)
     return upump_mgr_control(mgr, UPUMP_MGR_VACUUM);
 }
 
+/** @This instructs an existing manager to keep its timers in a timer wheel
+ * (see @ref uwheel) instead of its native timers. Timers whose deadlines are
+ * within the same slack then expire together, and arming or stopping a timer
+ * has a constant cost, which pays off with thousands of short timers. It
+ * must be called while no timer of the manager is started.
+ *
+ * @param mgr pointer to upump manager
+ * @param slack maximum delay of the expiry of timers, in units of
+ * @ref #UCLOCK_FREQ, or 0 to use the native timers
+ * @return an error code
+ */
+static inline int upump_mgr_set_timer_slack(struct upump_mgr *mgr,
+                                            uint64_t slack)
+{
+    return upump_mgr_control(mgr, UPUMP_MGR_SET_TIMER_SLACK, slack);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -25,6 +25,11 @@
 
 /** @file
  * @short Upipe thread-safe queue of elements
+ *
+ * By default the queue is backed by a @ref ufifo and holds at most 255
+ * elements. Queues initialized with @ref uqueue_init_mpmc are backed by a
+ * lock-free @ref umpmc ring instead, which scales better with several
+ * producers and holds up to @ref UQUEUE_MPMC_MAX_LENGTH elements.
  */
 
 #ifndef _UPIPE_UQUEUE_H_
@@ -38,20 +43,32 @@ extern "C" {
 #include <upipe/ubase.h>
 #include <upipe/uatomic.h>
 #include <upipe/ufifo.h>
+#include <upipe/umpmc.h>
 #include <upipe/ueventfd.h>
 #include <upipe/upump.h>
 
 #include <stdint.h>
 #include <assert.h>
 
+/** @This is the maximum number of elements in a queue backed by a umpmc. */
+#define UQUEUE_MPMC_MAX_LENGTH UMPMC_MAX_LENGTH
+
 /** @This is the implementation of a queue. */
 struct uqueue {
-    /** FIFO */
-    struct ufifo fifo;
+    /** true if the queue is backed by umpmc instead of ufifo */
+    bool mpmc;
+    union {
+        /** FIFO, if mpmc is false */
+        struct ufifo fifo;
+        /** bounded lock-free ring, if mpmc is true */
+        struct umpmc umpmc;
+    };
     /** number of elements in the queue */
     uatomic_uint32_t counter;
     /** maximum number of elements in the queue */
     uint32_t length;
+    /** number of queued elements from which the consumer is woken up */
+    uatomic_uint32_t threshold;
     /** ueventfd triggered when data can be pushed */
     struct ueventfd event_push;
     /** ueventfd triggered when data can be popped */
@@ -65,16 +82,21 @@ struct uqueue {
  */
 #define uqueue_sizeof(length) ufifo_sizeof(length)
 
-/** @This initializes a uqueue.
+/** @This returns the required size of extra data space for a uqueue backed
+ * by a umpmc.
+ *
+ * @param length maximum number of elements in the queue
+ * @return size in octets to allocate
+ */
+#define uqueue_mpmc_sizeof(length) umpmc_sizeof(length)
+
+/** @internal @This initializes the common part of a uqueue.
  *
  * @param uqueue pointer to a uqueue structure
  * @param length maximum number of elements in the queue
- * @param extra mandatory extra space allocated by the caller, with the size
- * returned by @ref #ufifo_sizeof
  * @return false in case of failure
  */
-static inline bool uqueue_init(struct uqueue *uqueue, uint8_t length,
-                               void *extra)
+static inline bool uqueue_init_common(struct uqueue *uqueue, uint32_t length)
 {
     if (unlikely(!ueventfd_init(&uqueue->event_push, true)))
         return false;
@@ -83,12 +105,71 @@ static inline bool uqueue_init(struct uqueue *uqueue, uint8_t length,
         return false;
     }
 
-    ufifo_init(&uqueue->fifo, length, extra);
     uatomic_init(&uqueue->counter, 0);
     uqueue->length = length;
+    uatomic_init(&uqueue->threshold, 1);
+    return true;
+}
+
+/** @This initializes a uqueue.
+ *
+ * @param uqueue pointer to a uqueue structure
+ * @param length maximum number of elements in the queue (max 255)
+ * @param extra mandatory extra space allocated by the caller, with the size
+ * returned by @ref #uqueue_sizeof
+ * @return false in case of failure
+ */
+static inline bool uqueue_init(struct uqueue *uqueue, uint8_t length,
+                               void *extra)
+{
+    if (unlikely(!uqueue_init_common(uqueue, length)))
+        return false;
+    uqueue->mpmc = false;
+    ufifo_init(&uqueue->fifo, length, extra);
+    return true;
+}
+
+/** @This initializes a uqueue backed by a lock-free umpmc ring, which
+ * scales better when several threads push into the same queue, and allows
+ * for longer queues.
+ *
+ * @param uqueue pointer to a uqueue structure
+ * @param length maximum number of elements in the queue (max
+ * @ref UQUEUE_MPMC_MAX_LENGTH)
+ * @param extra mandatory extra space allocated by the caller, with the size
+ * returned by @ref #uqueue_mpmc_sizeof
+ * @return false in case of failure
+ */
+static inline bool uqueue_init_mpmc(struct uqueue *uqueue, uint32_t length,
+                                    void *extra)
+{
+    if (unlikely(!uqueue_init_common(uqueue, length)))
+        return false;
+    uqueue->mpmc = true;
+    umpmc_init(&uqueue->umpmc, length, extra);
     return true;
 }
 
+/** @This sets the number of queued elements from which producers wake up the
+ * consumer. By default the consumer is woken up as soon as the queue is no
+ * longer empty; a higher threshold coalesces wakeups of bursty producers,
+ * but the consumer must then poll the queue periodically (typically with a
+ * timer) to bound the latency of elements queued below the threshold.
+ * The consumer is woken up so that elements queued under the former
+ * threshold are not delayed.
+ *
+ * @param uqueue pointer to a uqueue structure
+ * @param threshold number of elements, capped to the length of the queue
+ */
+static inline void uqueue_set_threshold(struct uqueue *uqueue,
+                                        uint32_t threshold)
+{
+    assert(threshold);
+    uatomic_store(&uqueue->threshold,
+                  threshold < uqueue->length ? threshold : uqueue->length);
+    ueventfd_write(&uqueue->event_pop);
+}
+
 /** @This allocates a watcher triggering when data is ready to be pushed.
  *
  * @param uqueue pointer to a uqueue structure
@@ -127,6 +208,40 @@ static inline struct upump *uqueue_upump_alloc_pop(struct uqueue *uqueue,
                                 refcount);
 }
 
+/** @internal @This pushes an element into the backing structure.
+ *
+ * @param uqueue pointer to a uqueue structure
+ * @param element pointer to element to push
+ * @return false if the queue is full
+ */
+static inline bool uqueue_push_internal(struct uqueue *uqueue, void *element)
+{
+    if (uqueue->mpmc)
+        return umpmc_push(&uqueue->umpmc, element);
+    return ufifo_push(&uqueue->fifo, element);
+}
+
+/** @internal @This pops elements from the backing structure.
+ *
+ * @param uqueue pointer to a uqueue structure
+ * @param elements array filled in with the popped elements
+ * @param nb maximum number of elements to pop
+ * @return number of popped elements
+ */
+static inline unsigned int uqueue_pop_elements(struct uqueue *uqueue,
+                                               void **elements,
+                                               unsigned int nb)
+{
+    if (uqueue->mpmc)
+        return umpmc_pop_batch(&uqueue->umpmc, elements, nb);
+
+    unsigned int popped;
+    for (popped = 0; popped < nb; popped++)
+        if ((elements[popped] = ufifo_pop(&uqueue->fifo, void *)) == NULL)
+            break;
+    return popped;
+}
+
 /** @This pushes an element into the queue.
  *
  * @param uqueue pointer to a uqueue structure
@@ -135,46 +250,66 @@ static inline struct upump *uqueue_upump_alloc_pop(struct uqueue *uqueue,
  */
 static inline bool uqueue_push(struct uqueue *uqueue, void *element)
 {
-    if (unlikely(!ufifo_push(&uqueue->fifo, element))) {
+    if (unlikely(!uqueue_push_internal(uqueue, element))) {
         /* signal that we are full */
         ueventfd_read(&uqueue->event_push);
 
         /* double-check */
-        if (likely(!ufifo_push(&uqueue->fifo, element)))
+        if (likely(!uqueue_push_internal(uqueue, element)))
             return false;
 
         /* signal that we're alright again */
         ueventfd_write(&uqueue->event_push);
     }
 
-    if (unlikely(uatomic_fetch_add(&uqueue->counter, 1) == 0))
+    if (unlikely(uatomic_fetch_add(&uqueue->counter, 1) ==
+                 uatomic_load(&uqueue->threshold) - 1))
         ueventfd_write(&uqueue->event_pop);
     return true;
 }
 
-/** @internal @This pops an element from the queue.
+/** @This pops elements from the queue, in order, as long as there are some.
+ * Draining the queue in batches saves the wakeups and eventfd system calls
+ * that would otherwise be performed for each element.
  *
  * @param uqueue pointer to a uqueue structure
- * @return pointer to element, or NULL if the LIFO is empty
+ * @param elements array filled in with the popped elements
+ * @param nb maximum number of elements to pop
+ * @return number of popped elements, or 0 if the queue is empty
  */
-static inline void *uqueue_pop_internal(struct uqueue *uqueue)
+static inline unsigned int uqueue_pop_batch(struct uqueue *uqueue,
+                                            void **elements, unsigned int nb)
 {
-    void *element = ufifo_pop(&uqueue->fifo, void *);
-    if (unlikely(element == NULL)) {
+    unsigned int popped = uqueue_pop_elements(uqueue, elements, nb);
+    if (unlikely(!popped)) {
         /* signal that we starve */
         ueventfd_read(&uqueue->event_pop);
 
         /* double-check */
-        element = ufifo_pop(&uqueue->fifo, void *);
-        if (likely(element == NULL))
-            return NULL;
+        popped = uqueue_pop_elements(uqueue, elements, nb);
+        if (likely(!popped))
+            return 0;
 
         /* signal that we're alright again */
         ueventfd_write(&uqueue->event_pop);
     }
 
-    if (unlikely(uatomic_fetch_sub(&uqueue->counter, 1) == uqueue->length))
+    if (unlikely(uatomic_fetch_sub(&uqueue->counter, popped) >=
+                 uqueue->length))
         ueventfd_write(&uqueue->event_push);
+    return popped;
+}
+
+/** @internal @This pops an element from the queue.
+ *
+ * @param uqueue pointer to a uqueue structure
+ * @return pointer to element, or NULL if the LIFO is empty
+ */
+static inline void *uqueue_pop_internal(struct uqueue *uqueue)
+{
+    void *element;
+    if (!uqueue_pop_batch(uqueue, &element, 1))
+        return NULL;
     return element;
 }
 
@@ -203,7 +338,11 @@ static inline unsigned int uqueue_length(struct uqueue *uqueue)
 static inline void uqueue_clean(struct uqueue *uqueue)
 {
     uatomic_clean(&uqueue->counter);
-    ufifo_clean(&uqueue->fifo);
+    uatomic_clean(&uqueue->threshold);
+    if (uqueue->mpmc)
+        umpmc_clean(&uqueue->umpmc);
+    else
+        ufifo_clean(&uqueue->fifo);
     ueventfd_clean(&uqueue->event_push);
     ueventfd_clean(&uqueue->event_pop);
 }
@@ -116,6 +116,15 @@ static inline int uref_block_unmap(struct uref *uref, int offset)
     return ubuf_block_unmap(uref->ubuf, offset);
 }
 
+/** @see ubuf_block_cursor_init */
+static inline int uref_block_cursor_init(struct ubuf_block_cursor *cursor,
+                                         struct uref *uref, int offset)
+{
+    if (uref->ubuf == NULL)
+        return UBASE_ERR_INVALID;
+    return ubuf_block_cursor_init(cursor, uref->ubuf, offset);
+}
+
 /** @see ubuf_block_insert */
 static inline int uref_block_insert(struct uref *uref, int offset,
                                     struct ubuf *insert)
@@ -287,6 +296,16 @@ static inline int uref_block_scan(struct uref *uref, size_t *offset_p,
     return ubuf_block_scan(uref->ubuf, offset_p, word);
 }
 
+/** @see ubuf_block_scan_sync */
+static inline int uref_block_scan_sync(struct uref *uref, size_t *offset_p,
+                                       uint8_t word, size_t stride,
+                                       unsigned int count)
+{
+    if (uref->ubuf == NULL)
+        return UBASE_ERR_INVALID;
+    return ubuf_block_scan_sync(uref->ubuf, offset_p, word, stride, count);
+}
+
 /** @see ubuf_block_find_va */
 static inline int uref_block_find_va(struct uref *uref, size_t *offset_p,
                                      unsigned int nb_octets, va_list args)
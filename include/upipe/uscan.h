@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe functions to scan buffers for sync words and start codes
+ *
+ * The scanning functions are vectorised with SSE2 or AVX2 when the CPU
+ * supports it, which is detected at runtime, and fall back to a portable
+ * implementation otherwise.
+ */
+
+#ifndef _UPIPE_USCAN_H_
+/** @hidden */
+# define _UPIPE_USCAN_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+/** @This finds the first offset in a buffer where an octet word is repeated
+ * a given number of times with a given period, such as the sync word of
+ * transport stream packets.
+ *
+ * Candidates whose repetitions do not all fit in the buffer are only checked
+ * against the octets that are available, so the returned offset may not be
+ * fully validated; this is the case if
+ * offset + (count - 1) * stride >= size.
+ *
+ * @param buffer pointer to the buffer
+ * @param size size of the buffer in octets
+ * @param word octet word to scan for
+ * @param stride period of the word in octets
+ * @param count number of occurrences of the word to find, including the
+ * first one
+ * @return offset of the first candidate, or size if none was found
+ */
+size_t uscan_sync(const uint8_t *buffer, size_t size, uint8_t word,
+                  size_t stride, unsigned int count);
+
+/** @This is the portable implementation of @ref uscan_sync, exported so
+ * that it can be compared to the vectorised versions.
+ *
+ * @param buffer pointer to the buffer
+ * @param size size of the buffer in octets
+ * @param word octet word to scan for
+ * @param stride period of the word in octets
+ * @param count number of occurrences of the word to find, including the
+ * first one
+ * @return offset of the first candidate, or size if none was found
+ */
+size_t uscan_sync_c(const uint8_t *buffer, size_t size, uint8_t word,
+                    size_t stride, unsigned int count);
+
+/** @This finds the first MPEG-style 3-octet start code (00 00 01) in a
+ * buffer.
+ *
+ * @param buffer pointer to the buffer
+ * @param size size of the buffer in octets
+ * @return offset of the first octet of the start code, or size if none was
+ * entirely found in the buffer
+ */
+size_t uscan_start_code(const uint8_t *buffer, size_t size);
+
+/** @This is the portable implementation of @ref uscan_start_code, exported
+ * so that it can be compared to the vectorised versions.
+ *
+ * @param buffer pointer to the buffer
+ * @param size size of the buffer in octets
+ * @return offset of the first octet of the start code, or size if none was
+ * entirely found in the buffer
+ */
+size_t uscan_start_code_c(const uint8_t *buffer, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe hierarchical timer wheel
+ * A timer wheel keeps a large number of timers with O(1) arming and
+ * cancellation. Time is divided in ticks of a configurable duration (the
+ * slack): all timers whose deadline falls within the same tick expire
+ * together, at the end of that tick, and never before their deadline.
+ *
+ * The wheel is not thread-safe and does not read any clock; the event loop
+ * owning it passes the current date, and uses @ref uwheel_next to program a
+ * single timer of its own.
+ */
+
+#ifndef _UPIPE_UWHEEL_H_
+/** @hidden */
+#define _UPIPE_UWHEEL_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/ubase.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/** @This is the number of bits of the slot index in each level. */
+#define UWHEEL_SLOT_BITS 6
+/** @This is the number of slots in each level. */
+#define UWHEEL_SLOTS (1 << UWHEEL_SLOT_BITS)
+/** @This is the number of levels; the last level covers 2^36 ticks. */
+#define UWHEEL_LEVELS 6
+
+/** @hidden */
+struct uwheel_timer;
+
+/** @This is the function called when a timer expires. */
+typedef void (*uwheel_cb)(struct uwheel_timer *);
+
+/** @This stores a timer of a wheel. */
+struct uwheel_timer {
+    /** structure for the list of the slot */
+    struct uchain uchain;
+    /** slot the timer is armed in, or NULL */
+    struct uchain *slot;
+    /** deadline of the timer */
+    uint64_t deadline;
+    /** deadline, in ticks */
+    uint64_t tick;
+    /** function called on expiry */
+    uwheel_cb cb;
+};
+
+UBASE_FROM_TO(uwheel_timer, uchain, uchain, uchain)
+
+/** @This stores a timer wheel. */
+struct uwheel {
+    /** duration of a tick */
+    uint64_t resolution;
+    /** next tick to process */
+    uint64_t now_tick;
+    /** number of armed timers */
+    unsigned int nb_timers;
+    /** bitmaps of the non-empty slots of each level */
+    uint64_t occupied[UWHEEL_LEVELS];
+    /** lists of timers */
+    struct uchain slots[UWHEEL_LEVELS][UWHEEL_SLOTS];
+};
+
+/** @This initializes a timer.
+ *
+ * @param timer pointer to the timer
+ * @param cb function called on expiry
+ */
+static inline void uwheel_timer_init(struct uwheel_timer *timer, uwheel_cb cb)
+{
+    uchain_init(&timer->uchain);
+    timer->slot = NULL;
+    timer->deadline = 0;
+    timer->tick = 0;
+    timer->cb = cb;
+}
+
+/** @This checks if a timer is armed.
+ *
+ * @param timer pointer to the timer
+ * @return true if the timer is armed
+ */
+static inline bool uwheel_timer_armed(const struct uwheel_timer *timer)
+{
+    return timer->slot != NULL;
+}
+
+/** @This initializes a wheel.
+ *
+ * @param wheel pointer to the wheel
+ * @param resolution duration of a tick, in the unit of the dates
+ * @param now current date
+ */
+void uwheel_init(struct uwheel *wheel, uint64_t resolution, uint64_t now);
+
+/** @This arms a timer, or re-arms it if it was already armed. A deadline
+ * in the past makes the timer expire on the next call to
+ * @ref uwheel_expire.
+ *
+ * @param wheel pointer to the wheel
+ * @param timer pointer to the timer
+ * @param deadline date of expiry
+ */
+void uwheel_arm(struct uwheel *wheel, struct uwheel_timer *timer,
+                uint64_t deadline);
+
+/** @This cancels a timer. It does nothing if the timer is not armed.
+ *
+ * @param wheel pointer to the wheel
+ * @param timer pointer to the timer
+ */
+void uwheel_cancel(struct uwheel *wheel, struct uwheel_timer *timer);
+
+/** @This returns the date at which @ref uwheel_expire should be called
+ * next. It may be earlier than the first deadline, when timers have to be
+ * moved between levels, but never later.
+ *
+ * @param wheel pointer to the wheel
+ * @return date of the next event, or UINT64_MAX if no timer is armed
+ */
+uint64_t uwheel_next(struct uwheel *wheel);
+
+/** @This calls the functions of all timers expired at the given date. The
+ * functions may arm and cancel any timer of the wheel.
+ *
+ * @param wheel pointer to the wheel
+ * @param now current date
+ * @return number of expired timers
+ */
+unsigned int uwheel_expire(struct uwheel *wheel, uint64_t now);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
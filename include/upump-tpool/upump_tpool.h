@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short declarations for a Upipe event loop shared by a pool of threads
+ *
+ * A thread pool runs the pumps of several upump managers on a fixed number of
+ * worker threads. Each upump manager allocated with
+ * @ref upump_tpool_mgr_alloc is a serial context: its pumps are never
+ * dispatched concurrently, so the pipes using it need not be thread-safe,
+ * exactly as with a single-threaded event loop. Independent pipelines, for
+ * instance one per program, should each get their own manager; idle workers
+ * then steal runnable managers from busy ones.
+ *
+ * Pipelines attached to different managers must only communicate through
+ * thread-safe structures such as @ref uqueue (see upipe_queue_sink and
+ * upipe_queue_source).
+ */
+
+#ifndef _UPUMP_TPOOL_UPUMP_TPOOL_H_
+/** @hidden */
+#define _UPUMP_TPOOL_UPUMP_TPOOL_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <upipe/upump.h>
+
+/** @hidden */
+struct upump_tpool;
+
+/** @This allocates a pool of worker threads. The threads are only created
+ * by @ref upump_tpool_run.
+ *
+ * @param nb_threads number of worker threads, including the thread calling
+ * @ref upump_tpool_run
+ * @return pointer to the pool, or NULL in case of failure
+ */
+struct upump_tpool *upump_tpool_alloc(unsigned int nb_threads);
+
+/** @This increments the reference count of a pool.
+ *
+ * @param tpool pointer to the pool
+ * @return same pointer to the pool
+ */
+struct upump_tpool *upump_tpool_use(struct upump_tpool *tpool);
+
+/** @This decrements the reference count of a pool, and frees it when it
+ * reaches 0. Managers allocated on the pool hold a reference to it.
+ *
+ * @param tpool pointer to the pool
+ */
+void upump_tpool_release(struct upump_tpool *tpool);
+
+/** @This allocates and initializes a upump_mgr structure whose pumps are run
+ * by the given pool. All pumps of the manager are dispatched serially.
+ *
+ * @param tpool pointer to the pool
+ * @param upump_pool_depth maximum number of upump structures in the pool
+ * @param upump_blocker_pool_depth maximum number of upump_blocker structures in
+ * the pool
+ * @return pointer to the wrapped upump_mgr structure, or NULL in case of
+ * failure
+ */
+struct upump_mgr *upump_tpool_mgr_alloc(struct upump_tpool *tpool,
+                                        uint16_t upump_pool_depth,
+                                        uint16_t upump_blocker_pool_depth);
+
+/** @This runs the pool with the calling thread and the other worker
+ * threads, until there is no started pump left in any of its managers.
+ *
+ * @param tpool pointer to the pool
+ * @return an error code
+ */
+int upump_tpool_run(struct upump_tpool *tpool);
+
+/** @This returns the number of times a worker took a runnable manager from
+ * the queue of another worker, during the last run.
+ *
+ * @param tpool pointer to the pool
+ * @return number of steals
+ */
+uint64_t upump_tpool_get_steals(struct upump_tpool *tpool);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
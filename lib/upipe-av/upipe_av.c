@@ -38,6 +38,7 @@
 
 #include <stdbool.h>
 #include <ctype.h>
+#include <pthread.h>
 
 /** structure to protect exclusive access to avcodec_open() */
 struct udeal upipe_av_deal;
@@ -45,6 +46,16 @@ struct udeal upipe_av_deal;
 static bool avcodec_only = false;
 /** @internal probe used by upipe_av_vlog, defined in upipe_av_init() */
 static struct uprobe *logprobe = NULL;
+/** @internal lock protecting the threads budget */
+static pthread_mutex_t threads_lock = PTHREAD_MUTEX_INITIALIZER;
+/** @internal maximum number of threads of all codecs (0 for no limit) */
+static unsigned int threads_budget = 0;
+/** @internal expected number of codecs sharing the budget */
+static unsigned int threads_expected = 0;
+/** @internal number of threads given to opened codecs */
+static unsigned int threads_used = 0;
+/** @internal number of opened codecs holding threads from the budget */
+static unsigned int threads_codecs = 0;
 
 /** @internal @This replaces av_log_default_callback
  * @param avcl A pointer to an arbitrary struct of which the first field is a
@@ -138,3 +149,147 @@ void upipe_av_clean(void)
     if (logprobe)
         uprobe_release(logprobe);
 }
+
+/** @This sets the maximum number of threads that all avcodec contexts of
+ * the process may use together, and throws @ref UPROBE_AV_THREADS_BUDGET
+ * to the probe given to @ref upipe_av_init if it changed.
+ *
+ * @param threads number of threads, or 0 for no limit (default)
+ * @param codecs number of codecs expected to share the budget
+ */
+void upipe_av_set_threads_budget(unsigned int threads, unsigned int codecs)
+{
+    pthread_mutex_lock(&threads_lock);
+    bool changed = threads != threads_budget || codecs != threads_expected;
+    threads_budget = threads;
+    threads_expected = codecs;
+    pthread_mutex_unlock(&threads_lock);
+
+    if (changed && logprobe != NULL)
+        uprobe_throw(logprobe, NULL, UPROBE_AV_THREADS_BUDGET,
+                     UPIPE_AV_SIGNATURE, threads, codecs);
+}
+
+/** @This returns the maximum number of threads that all avcodec contexts of
+ * the process may use together.
+ *
+ * @param used_p filled in with the number of threads currently given to
+ * opened codecs (may be NULL)
+ * @param codecs_p filled in with the number of opened codecs holding
+ * threads from the budget (may be NULL)
+ * @return number of threads, or 0 for no limit
+ */
+unsigned int upipe_av_get_threads_budget(unsigned int *used_p,
+                                         unsigned int *codecs_p)
+{
+    pthread_mutex_lock(&threads_lock);
+    unsigned int budget = threads_budget;
+    if (used_p != NULL)
+        *used_p = threads_used;
+    if (codecs_p != NULL)
+        *codecs_p = threads_codecs;
+    pthread_mutex_unlock(&threads_lock);
+    return budget;
+}
+
+/** @This sets the threading of a codec context about to be opened, giving
+ * it threads from the budget set by @ref upipe_av_set_threads_budget.
+ * It must be called with exclusive access to avcodec_open().
+ *
+ * @param context avcodec context
+ * @param thread_type types of threading (@ref upipe_av_thread_type), or 0
+ * to keep the default
+ * @param threads number of threads, or 0 to keep the default
+ * @param exhausted_p filled in with true if the budget was exhausted and
+ * the codec is not threaded
+ * @return number of threads taken from the budget, to give back with
+ * @ref upipe_av_yield_threads
+ */
+unsigned int upipe_av_grab_threads(AVCodecContext *context, int thread_type,
+                                   unsigned int threads, bool *exhausted_p)
+{
+    if (thread_type) {
+        context->thread_type = 0;
+        if (thread_type & UPIPE_AV_THREAD_FRAME)
+            context->thread_type |= FF_THREAD_FRAME;
+        if (thread_type & UPIPE_AV_THREAD_SLICE)
+            context->thread_type |= FF_THREAD_SLICE;
+    }
+    if (!threads && context->thread_count > 0)
+        threads = context->thread_count;
+    *exhausted_p = false;
+
+    pthread_mutex_lock(&threads_lock);
+    if (!threads_budget) {
+        pthread_mutex_unlock(&threads_lock);
+        if (threads)
+            context->thread_count = threads;
+        return 0;
+    }
+
+    /* Give a fair share of the budget to every codec expected to share
+     * it, without exceeding what is left. */
+    unsigned int sharers = threads_codecs + 1;
+    if (sharers < threads_expected)
+        sharers = threads_expected;
+    unsigned int left = threads_used < threads_budget ?
+                        threads_budget - threads_used : 0;
+    unsigned int share = threads_budget / sharers;
+    if (!share)
+        share = 1;
+    if (threads && threads < share)
+        share = threads;
+    if (share > left)
+        share = left;
+    if (share) {
+        threads_used += share;
+        threads_codecs++;
+    }
+    pthread_mutex_unlock(&threads_lock);
+
+    if (!share) {
+        /* run the codec in the thread of the pipe */
+        *exhausted_p = true;
+        context->thread_count = 1;
+        return 0;
+    }
+    context->thread_count = share;
+    return share;
+}
+
+/** @This gives back to the budget the threads of a codec context that has
+ * been closed.
+ *
+ * @param threads number of threads returned by @ref upipe_av_grab_threads
+ */
+void upipe_av_yield_threads(unsigned int threads)
+{
+    if (!threads)
+        return;
+    pthread_mutex_lock(&threads_lock);
+    threads_used -= threads;
+    threads_codecs--;
+    pthread_mutex_unlock(&threads_lock);
+}
+
+/** @This returns the threading actually used by an opened codec context.
+ *
+ * @param context avcodec context
+ * @param thread_type_p filled in with the types of threading
+ * (@ref upipe_av_thread_type)
+ * @param threads_p filled in with the number of threads
+ */
+void upipe_av_get_threads(AVCodecContext *context, int *thread_type_p,
+                          unsigned int *threads_p)
+{
+    int thread_type = 0;
+    if (context->active_thread_type & FF_THREAD_FRAME)
+        thread_type |= UPIPE_AV_THREAD_FRAME;
+    if (context->active_thread_type & FF_THREAD_SLICE)
+        thread_type |= UPIPE_AV_THREAD_SLICE;
+    if (thread_type_p != NULL)
+        *thread_type_p = thread_type;
+    if (threads_p != NULL)
+        *threads_p = thread_type && context->thread_count > 0 ?
+                     context->thread_count : 1;
+}
@@ -106,6 +106,39 @@ static inline void upipe_av_deal_abort(struct upump *upump)
     udeal_abort(&upipe_av_deal, upump);
 }
 
+/** @This sets the threading of a codec context about to be opened, giving
+ * it threads from the budget set by @ref upipe_av_set_threads_budget.
+ * It must be called with exclusive access to avcodec_open().
+ *
+ * @param context avcodec context
+ * @param thread_type types of threading (@ref upipe_av_thread_type), or 0
+ * to keep the default
+ * @param threads number of threads, or 0 to keep the default
+ * @param exhausted_p filled in with true if the budget was exhausted and
+ * the codec is not threaded
+ * @return number of threads taken from the budget, to give back with
+ * @ref upipe_av_yield_threads
+ */
+unsigned int upipe_av_grab_threads(AVCodecContext *context, int thread_type,
+                                   unsigned int threads, bool *exhausted_p);
+
+/** @This gives back to the budget the threads of a codec context that has
+ * been closed.
+ *
+ * @param threads number of threads returned by @ref upipe_av_grab_threads
+ */
+void upipe_av_yield_threads(unsigned int threads);
+
+/** @This returns the threading actually used by an opened codec context.
+ *
+ * @param context avcodec context
+ * @param thread_type_p filled in with the types of threading
+ * (@ref upipe_av_thread_type)
+ * @param threads_p filled in with the number of threads
+ */
+void upipe_av_get_threads(AVCodecContext *context, int *thread_type_p,
+                          unsigned int *threads_p);
+
 /** @This wraps around av_strerror() using ulog storage.
  *
  * @param ulog utility structure passed to the module
@@ -73,6 +73,8 @@
 #include "upipe_av_internal.h"
 
 #define EXPECTED_FLOW_DEF "block."
+/** minimal alignment of the planes of pictures, in octets */
+#define UPIPE_AVCDEC_ALIGN 16
 
 /** @hidden */
 static int upipe_avcdec_check(struct upipe *upipe, struct uref *flow_format);
@@ -118,6 +120,9 @@ struct upipe_avcdec {
     struct upump_mgr *upump_mgr;
     /** pixel format used for the ubuf manager */
     enum AVPixelFormat pix_fmt;
+    /** true if pictures are allocated from the ubuf manager (direct
+     * rendering) */
+    bool direct_rendering;
     /** sample format used for the ubuf manager */
     enum AVSampleFormat sample_fmt;
     /** number of channels used for the ubuf manager */
@@ -165,6 +170,16 @@ struct upipe_avcdec {
     AVFrame *frame;
     /** true if the context will be closed */
     bool close;
+    /** requested types of threading, or 0 for the default */
+    int thread_type;
+    /** requested number of threads, or 0 for the default */
+    unsigned int threads;
+    /** number of threads taken from the budget */
+    unsigned int threads_budget;
+    /** types of threading of the last opened codec */
+    int last_thread_type;
+    /** number of threads of the last opened codec */
+    unsigned int last_threads;
 
     /** public upipe structure */
     struct upipe upipe;
@@ -188,6 +203,45 @@ UPIPE_HELPER_INPUT(upipe_avcdec, urefs, nb_urefs, max_urefs, blockers, upipe_avc
 /** @hidden */
 static void upipe_avcdec_free(struct upipe *upipe);
 
+/** @internal @This checks if the pictures allocated by the ubuf manager
+ * have the alignment and padding required by avcodec, so that it may
+ * decode into them directly.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_avcdec_check_direct_rendering(struct upipe *upipe)
+{
+    struct upipe_avcdec *upipe_avcdec = upipe_avcdec_from_upipe(upipe);
+    AVCodecContext *context = upipe_avcdec->context;
+    struct uref *flow_format = upipe_avcdec->flow_def_format;
+    struct uref *flow_provided = upipe_avcdec->flow_def_provided;
+
+    upipe_avcdec->direct_rendering = false;
+    if (context == NULL || context->codec == NULL ||
+        context->codec->type != AVMEDIA_TYPE_VIDEO ||
+        flow_format == NULL || flow_provided == NULL)
+        return;
+    if (!(context->codec->capabilities & CODEC_CAP_DR1)) {
+        upipe_verbose(upipe, "no direct rendering, using default");
+        return;
+    }
+
+    uint64_t align = UPIPE_AVCDEC_ALIGN, align_provided = 0;
+    uint8_t vappend = 0, vappend_provided = 0;
+    uref_pic_flow_get_align(flow_format, &align);
+    uref_pic_flow_get_align(flow_provided, &align_provided);
+    uref_pic_flow_get_vappend(flow_format, &vappend);
+    uref_pic_flow_get_vappend(flow_provided, &vappend_provided);
+    if (!align_provided || align_provided % align ||
+        vappend_provided < vappend) {
+        upipe_warn_va(upipe, "ubuf manager doesn't provide %"PRIu64"-octet "
+                      "aligned pictures with %"PRIu8" appended lines, "
+                      "copying pictures", align, vappend);
+        return;
+    }
+    upipe_avcdec->direct_rendering = true;
+}
+
 /** @internal @This provides a ubuf_mgr request.
  *
  * @param upipe description structure of the pipe
@@ -200,11 +254,146 @@ static int upipe_avcdec_check(struct upipe *upipe, struct uref *flow_format)
     if (flow_format != NULL) {
         uref_free(upipe_avcdec->flow_def_provided);
         upipe_avcdec->flow_def_provided = flow_format;
+        upipe_avcdec_check_direct_rendering(upipe);
     }
     return UBASE_ERR_NONE;
 }
 
-static void upipe_av_uref_pic_free(void *opaque, uint8_t *data);
+/** @internal @This holds the references to a picture allocated for avcodec.
+ * It is shared by the av buffers of all the planes, which libavcodec may
+ * keep as reference frames and release in any order. As thread_safe_callbacks
+ * is not set, libavcodec allocates and releases them from the thread of the
+ * pipe, even with frame threading. */
+struct upipe_avcdec_buf {
+    /** refcount management structure, one per av buffer */
+    struct urefcount urefcount;
+    /** uref carrying the attributes of the frame, and its ubuf in direct
+     * rendering */
+    struct uref *uref;
+    /** number of planes of the ubuf mapped for avcodec */
+    uint8_t mapped;
+    /** buffers allocated by avcodec when not in direct rendering */
+    AVBufferRef *bufs[AV_NUM_DATA_POINTERS];
+};
+
+/** @internal @This unmaps the planes of the ubuf of a picture.
+ *
+ * @param buf pointer to the upipe_avcdec_buf structure
+ */
+static void upipe_avcdec_buf_unmap(struct upipe_avcdec_buf *buf)
+{
+    struct uref *uref = buf->uref;
+    struct uref *flow_def_attr = uref_from_uchain(uref->uchain.next);
+
+    for (uint8_t plane = 0; plane < buf->mapped; plane++) {
+        const char *chroma;
+        if (ubase_check(uref_pic_flow_get_chroma(flow_def_attr, &chroma,
+                                                 plane)))
+            ubuf_pic_plane_unmap(uref->ubuf, chroma, 0, 0, -1, -1);
+    }
+    buf->mapped = 0;
+}
+
+/** @internal @This is called when the last av buffer of a picture is
+ * released.
+ *
+ * @param urefcount pointer to the urefcount structure
+ */
+static void upipe_avcdec_buf_free(struct urefcount *urefcount)
+{
+    struct upipe_avcdec_buf *buf = container_of(urefcount,
+                                                struct upipe_avcdec_buf,
+                                                urefcount);
+    struct uref *uref = buf->uref;
+    struct uref *flow_def_attr = uref_from_uchain(uref->uchain.next);
+
+    upipe_avcdec_buf_unmap(buf);
+    for (int i = 0; i < AV_NUM_DATA_POINTERS; i++)
+        av_buffer_unref(&buf->bufs[i]);
+
+    uref_free(flow_def_attr);
+    uref_free(uref);
+    urefcount_clean(urefcount);
+    free(buf);
+}
+
+/** @internal @This is called by avcodec when releasing the av buffer of a
+ * plane.
+ *
+ * @param opaque pointer to the upipe_avcdec_buf structure
+ * @param data pointer to the data of the plane
+ */
+static void upipe_avcdec_buf_release(void *opaque, uint8_t *data)
+{
+    struct upipe_avcdec_buf *buf = opaque;
+    urefcount_release(&buf->urefcount);
+}
+
+/** @internal @This wraps a plane of a picture into an av buffer.
+ *
+ * @param buf pointer to the upipe_avcdec_buf structure
+ * @param data pointer to the data of the plane
+ * @param size size of the plane in octets
+ * @return pointer to the av buffer, or NULL in case of allocation error
+ */
+static AVBufferRef *upipe_avcdec_buf_wrap(struct upipe_avcdec_buf *buf,
+                                          uint8_t *data, int size)
+{
+    AVBufferRef *buffer = av_buffer_create(data, size,
+                                           upipe_avcdec_buf_release, buf, 0);
+    if (likely(buffer != NULL))
+        urefcount_use(&buf->urefcount);
+    return buffer;
+}
+
+/** @internal @This maps the planes of the ubuf of a picture for avcodec.
+ *
+ * @param upipe description structure of the pipe
+ * @param buf pointer to the upipe_avcdec_buf structure
+ * @param frame avframe to fill in
+ * @param align alignment required by avcodec for data and linesizes
+ * @return an error code
+ */
+static int upipe_avcdec_buf_map(struct upipe *upipe,
+                                struct upipe_avcdec_buf *buf, AVFrame *frame,
+                                uint64_t align)
+{
+    struct uref *uref = buf->uref;
+    struct uref *flow_def_attr = uref_from_uchain(uref->uchain.next);
+    uint8_t planes;
+    size_t vsize;
+    UBASE_RETURN(uref_pic_flow_get_planes(flow_def_attr, &planes))
+    UBASE_RETURN(ubuf_pic_size(uref->ubuf, NULL, &vsize, NULL))
+    if (unlikely(planes > AV_NUM_DATA_POINTERS))
+        return UBASE_ERR_INVALID;
+
+    /* Iterate over the flow def attr because it's designed to be in the
+     * correct chroma order, while the ubuf manager is not necessarily. */
+    for (uint8_t plane = 0; plane < planes; plane++) {
+        const char *chroma;
+        size_t stride;
+        uint8_t vsub;
+        UBASE_RETURN(uref_pic_flow_get_chroma(flow_def_attr, &chroma, plane))
+        UBASE_RETURN(ubuf_pic_plane_write(uref->ubuf, chroma, 0, 0, -1, -1,
+                                          &frame->data[plane]))
+        buf->mapped++;
+        UBASE_RETURN(ubuf_pic_plane_size(uref->ubuf, chroma, &stride, NULL,
+                                         &vsub, NULL))
+
+        if (unlikely((uintptr_t)frame->data[plane] % align || stride % align)) {
+            upipe_verbose_va(upipe, "plane %s is not aligned on %"PRIu64,
+                             chroma, align);
+            return UBASE_ERR_INVALID;
+        }
+
+        frame->linesize[plane] = stride;
+        frame->buf[plane] = upipe_avcdec_buf_wrap(buf, frame->data[plane],
+                                                  stride * vsize / vsub);
+        if (unlikely(frame->buf[plane] == NULL))
+            return UBASE_ERR_ALLOC;
+    }
+    return UBASE_ERR_NONE;
+}
 
 /* Documentation from libavcodec.h (get_buffer) :
  * The function will set AVFrame.data[], AVFrame.linesize[].
@@ -231,9 +420,14 @@ static void upipe_av_uref_pic_free(void *opaque, uint8_t *data);
  */
 
 /** @internal @This is called by avcodec when allocating a new picture.
+ * In direct rendering, the picture is allocated from the ubuf manager and
+ * output without a copy. Otherwise avcodec allocates it, and the picture
+ * is copied in @ref upipe_avcdec_output_pic.
  *
  * @param context current avcodec context
  * @param frame avframe handler entering avcodec black magic box
+ * @param flags AV_GET_BUFFER_FLAG_* flags
+ * @return 0, or a negative value in case of error
  */
 static int upipe_avcdec_get_buffer_pic(struct AVCodecContext *context,
                                        AVFrame *frame,
@@ -247,15 +441,6 @@ static int upipe_avcdec_get_buffer_pic(struct AVCodecContext *context,
         return -1;
     }
 
-    struct uref *uref = uref_dup(upipe_avcdec->uref);
-    frame->opaque = uref;
-
-    uint64_t framenum = 0;
-    uref_pic_get_number(frame->opaque, &framenum);
-
-    upipe_verbose_va(upipe, "Allocating frame for %"PRIu64" (%p) - %dx%d",
-                     framenum, frame->opaque, frame->width, frame->height);
-
     /* Check if we have a new pixel format. */
     if (unlikely(context->pix_fmt != upipe_avcdec->pix_fmt)) {
         ubuf_mgr_release(upipe_avcdec->ubuf_mgr);
@@ -263,27 +448,44 @@ static int upipe_avcdec_get_buffer_pic(struct AVCodecContext *context,
         upipe_avcdec->pix_fmt = context->pix_fmt;
     }
 
-    /* Use avcodec width/height alignement, then resize pic. */
+    /* Use avcodec width/height and linesize alignment, then resize pic. */
     int width_aligned = frame->width, height_aligned = frame->height;
-    avcodec_align_dimensions(context, &width_aligned, &height_aligned);
+    int linesize_align[AV_NUM_DATA_POINTERS] = { 0 };
+    avcodec_align_dimensions2(context, &width_aligned, &height_aligned,
+                              linesize_align);
+    uint64_t align = UPIPE_AVCDEC_ALIGN;
+    for (int i = 0; i < AV_NUM_DATA_POINTERS; i++)
+        if (linesize_align[i] > align)
+            align = linesize_align[i];
 
     /* Prepare flow definition attributes. */
     struct uref *flow_def_attr = upipe_avcdec_alloc_flow_def_attr(upipe);
     if (unlikely(flow_def_attr == NULL)) {
-        uref_free(uref);
         upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
         return -1;
     }
     if (unlikely(!ubase_check(upipe_av_pixfmt_to_flow_def(upipe_avcdec->pix_fmt,
                                                           flow_def_attr)))) {
-        uref_free(uref);
         uref_free(flow_def_attr);
         upipe_err_va(upipe, "unhandled pixel format %d", upipe_avcdec->pix_fmt);
         upipe_throw_fatal(upipe, UBASE_ERR_INVALID);
         return -1;
     }
 
-    UBASE_FATAL(upipe, uref_pic_flow_set_align(flow_def_attr, 16))
+    /* Append enough lines for avcodec to read or write past the end of
+     * each plane, as it may do with its own buffers. */
+    uint8_t planes = 0, vappend = 1;
+    uref_pic_flow_get_planes(flow_def_attr, &planes);
+    for (uint8_t plane = 0; plane < planes; plane++) {
+        uint8_t vsub;
+        if (ubase_check(uref_pic_flow_get_vsubsampling(flow_def_attr, &vsub,
+                                                       plane)) &&
+            vsub > vappend)
+            vappend = vsub;
+    }
+
+    UBASE_FATAL(upipe, uref_pic_flow_set_align(flow_def_attr, align))
+    UBASE_FATAL(upipe, uref_pic_flow_set_vappend(flow_def_attr, vappend))
     UBASE_FATAL(upipe, uref_pic_flow_set_hsize(flow_def_attr, context->width))
     UBASE_FATAL(upipe, uref_pic_flow_set_vsize(flow_def_attr, context->height))
     UBASE_FATAL(upipe, uref_pic_flow_set_hsize_visible(flow_def_attr, context->width))
@@ -299,9 +501,13 @@ static int upipe_avcdec_get_buffer_pic(struct AVCodecContext *context,
 
         uint64_t latency = upipe_avcdec->input_latency +
                            context->delay * UCLOCK_FREQ * fps.den / fps.num;
-        if (context->active_thread_type == FF_THREAD_FRAME &&
-            context->thread_count != -1)
-            latency += context->thread_count * UCLOCK_FREQ * fps.den / fps.num;
+        /* frame threading delays the output by one frame per additional
+         * thread */
+        int thread_type;
+        unsigned int threads;
+        upipe_av_get_threads(context, &thread_type, &threads);
+        if (thread_type & UPIPE_AV_THREAD_FRAME)
+            latency += (threads - 1) * UCLOCK_FREQ * fps.den / fps.num;
         UBASE_FATAL(upipe, uref_clock_set_latency(flow_def_attr, latency))
     }
     /* set aspect-ratio */
@@ -329,105 +535,93 @@ static int upipe_avcdec_get_buffer_pic(struct AVCodecContext *context,
     }
 
     if (unlikely(upipe_avcdec->ubuf_mgr == NULL)) {
+        uref_free(upipe_avcdec->flow_def_format);
         upipe_avcdec->flow_def_format = uref_dup(flow_def_attr);
-        if (unlikely(!upipe_avcdec_demand_ubuf_mgr(upipe, flow_def_attr))) {
-            uref_free(uref);
+        if (unlikely(!upipe_avcdec_demand_ubuf_mgr(upipe, flow_def_attr)))
             return -1;
-        }
     } else
         uref_free(flow_def_attr);
 
+    struct upipe_avcdec_buf *buf = malloc(sizeof(struct upipe_avcdec_buf));
+    struct uref *uref = uref_dup(upipe_avcdec->uref);
     flow_def_attr = uref_dup(upipe_avcdec->flow_def_provided);
-
-    /* Allocate a ubuf */
-    struct ubuf *ubuf = ubuf_pic_alloc(upipe_avcdec->ubuf_mgr,
-                                       width_aligned, height_aligned);
-    if (unlikely(ubuf == NULL))
-        goto error;
-
-    ubuf_pic_clear(ubuf, 0, 0, -1, -1, 0);
-    uref_attach_ubuf(uref, ubuf);
+    if (unlikely(buf == NULL || uref == NULL || flow_def_attr == NULL)) {
+        free(buf);
+        uref_free(uref);
+        uref_free(flow_def_attr);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return -1;
+    }
+    urefcount_init(&buf->urefcount, upipe_avcdec_buf_free);
+    buf->uref = uref;
+    buf->mapped = 0;
+    for (int i = 0; i < AV_NUM_DATA_POINTERS; i++)
+        buf->bufs[i] = NULL;
 
     /* Chain the new flow def attributes to the uref so we can apply them
      * later. */
     uref->uchain.next = uref_to_uchain(flow_def_attr);
+    frame->opaque = uref;
 
-    if (!(context->codec->capabilities & CODEC_CAP_DR1)) {
-        upipe_verbose(upipe, "no direct rendering, using default");
-        return avcodec_default_get_buffer2(context, frame, 0);
-    }
+    uint64_t framenum = 0;
+    uref_pic_get_number(uref, &framenum);
 
-    /* Direct rendering */
-    /* Iterate over the flow def attr because it's designed to be in the correct
-     * chroma order, while the ubuf manager is not necessarily. */
-    uint8_t planes;
-    if (unlikely(!ubase_check(uref_pic_flow_get_planes(flow_def_attr, &planes))))
-        goto error;
+    upipe_verbose_va(upipe, "Allocating frame for %"PRIu64" (%p) - %dx%d",
+                     framenum, frame->opaque, frame->width, frame->height);
 
-    /* Use this as an avcodec refcount */
-    uref_attr_set_priv(uref, planes);
+    if (likely(upipe_avcdec->direct_rendering)) {
+        /* Direct rendering */
+        struct ubuf *ubuf = ubuf_pic_alloc(upipe_avcdec->ubuf_mgr,
+                                           width_aligned, height_aligned);
+        if (unlikely(ubuf == NULL)) {
+            urefcount_release(&buf->urefcount);
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return -1;
+        }
+        uref_attach_ubuf(uref, ubuf);
 
-    for (uint8_t plane = 0; plane < planes; plane++) {
-        const char *chroma;
-        size_t stride = 0;
-        uint8_t vsub = 1;
-        if (unlikely(!ubase_check(uref_pic_flow_get_chroma(flow_def_attr, &chroma, plane)) ||
-                     !ubase_check(ubuf_pic_plane_write(ubuf, chroma, 0, 0, -1, -1,
-                                           &frame->data[plane])) ||
-                     !ubase_check(ubuf_pic_plane_size(ubuf, chroma, &stride, NULL, &vsub,
-                                          NULL)))) {
-            // XXX: missing unmap and release av_buffer for previous planes
-            goto error;
+        if (likely(ubase_check(upipe_avcdec_buf_map(upipe, buf, frame,
+                                                    align)))) {
+            frame->extended_data = frame->data;
+            urefcount_release(&buf->urefcount);
+            return 0; /* success */
         }
 
-        frame->linesize[plane] = stride;
-        frame->buf[plane] = av_buffer_create(frame->data[plane], stride * height_aligned / vsub,
-                upipe_av_uref_pic_free, uref, 0);
+        /* Fall back to avcodec buffers for this picture. */
+        upipe_warn(upipe, "couldn't use direct rendering, copying picture");
+        for (int i = 0; i < AV_NUM_DATA_POINTERS; i++) {
+            av_buffer_unref(&frame->buf[i]);
+            frame->data[i] = NULL;
+            frame->linesize[i] = 0;
+        }
+        upipe_avcdec_buf_unmap(buf);
+        ubuf_free(uref_detach_ubuf(uref));
     }
 
-    frame->extended_data = frame->data;
-
-    return 0; /* success */
-
-error:
-    uref_free(uref);
-    uref_free(flow_def_attr);
-    upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
-    return -1;
-}
-
-static void upipe_av_uref_pic_free(void *opaque, uint8_t *data)
-{
-	struct uref *uref = opaque;
-
-    uint64_t buffers;
-    if (unlikely(!ubase_check(uref_attr_get_priv(uref, &buffers))))
-        return;
-    if (--buffers) {
-        uref_attr_set_priv(uref, buffers);
-        return;
+    int err = avcodec_default_get_buffer2(context, frame, flags);
+    if (unlikely(err < 0)) {
+        urefcount_release(&buf->urefcount);
+        return err;
     }
 
-    struct uref *flow_def_attr = uref_from_uchain(uref->uchain.next);
-
-    assert(flow_def_attr);
-
-    uint8_t planes;
-    if (unlikely(!ubase_check(uref_pic_flow_get_planes(flow_def_attr, &planes))))
-        goto end;
-
-    for (uint8_t plane = 0; plane < planes; plane++) {
-        const char *chroma;
-        if (!ubase_check(uref_pic_flow_get_chroma(flow_def_attr, &chroma, plane)))
-            goto end;
-
-        /* unmap call in avcodec get_buffer2 */
-        ubuf_pic_plane_unmap(uref->ubuf, chroma, 0, 0, -1, -1);
+    /* Keep the uref until avcodec releases all the buffers of the picture. */
+    for (int i = 0; i < AV_NUM_DATA_POINTERS; i++) {
+        buf->bufs[i] = frame->buf[i];
+        frame->buf[i] = NULL;
     }
-
-end:
-    uref_free(flow_def_attr);
-    uref_free(uref);
+    for (int i = 0; i < AV_NUM_DATA_POINTERS && buf->bufs[i] != NULL; i++) {
+        frame->buf[i] = upipe_avcdec_buf_wrap(buf, buf->bufs[i]->data,
+                                              buf->bufs[i]->size);
+        if (unlikely(frame->buf[i] == NULL)) {
+            for (int j = 0; j < i; j++)
+                av_buffer_unref(&frame->buf[j]);
+            urefcount_release(&buf->urefcount);
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return -1;
+        }
+    }
+    urefcount_release(&buf->urefcount);
+    return 0;
 }
 
 /** @internal @This is called by avcodec when allocating a new audio buffer.
@@ -576,6 +770,8 @@ static bool upipe_avcdec_do_av_deal(struct upipe *upipe)
             uref_sound_unmap(upipe_avcdec->uref, 0, -1, AV_NUM_DATA_POINTERS);
 
         avcodec_close(context);
+        upipe_av_yield_threads(upipe_avcdec->threads_budget);
+        upipe_avcdec->threads_budget = 0;
         return false;
     }
 
@@ -601,8 +797,14 @@ static bool upipe_avcdec_do_av_deal(struct upipe *upipe)
     }
 
     /* open new context */
+    bool exhausted;
+    upipe_avcdec->threads_budget =
+        upipe_av_grab_threads(context, upipe_avcdec->thread_type,
+                              upipe_avcdec->threads, &exhausted);
     int err;
     if (unlikely((err = avcodec_open2(context, context->codec, NULL)) < 0)) {
+        upipe_av_yield_threads(upipe_avcdec->threads_budget);
+        upipe_avcdec->threads_budget = 0;
         upipe_av_strerror(err, buf);
         upipe_warn_va(upipe, "could not open codec (%s)", buf);
         upipe_throw_fatal(upipe, UBASE_ERR_EXTERNAL);
@@ -611,6 +813,22 @@ static bool upipe_avcdec_do_av_deal(struct upipe *upipe)
     upipe_notice_va(upipe, "codec %s (%s) %d opened", context->codec->name, 
                     context->codec->long_name, context->codec->id);
 
+    int thread_type;
+    unsigned int threads;
+    upipe_av_get_threads(context, &thread_type, &threads);
+    if (unlikely(exhausted))
+        upipe_warn(upipe, "threads budget exhausted, codec not threaded");
+    if (exhausted || thread_type != upipe_avcdec->last_thread_type ||
+        threads != upipe_avcdec->last_threads) {
+        upipe_avcdec->last_thread_type = thread_type;
+        upipe_avcdec->last_threads = threads;
+        upipe_dbg_va(upipe, "using %u thread(s)%s%s", threads,
+                     thread_type & UPIPE_AV_THREAD_FRAME ? " frame" : "",
+                     thread_type & UPIPE_AV_THREAD_SLICE ? " slice" : "");
+        upipe_throw(upipe, UPROBE_AVCDEC_THREADS, UPIPE_AVCDEC_SIGNATURE,
+                    thread_type, threads);
+    }
+
     return true;
 }
 
@@ -990,13 +1208,6 @@ static void upipe_avcdec_output_pic(struct upipe *upipe, struct upump **upump_p)
     upipe_verbose_va(upipe, "%"PRIu64"\t - Picture decoded ! %dx%d - %"PRIu64,
                  upipe_avcdec->counter, frame->width, frame->height, framenum);
 
-    /* Resize the picture (was allocated too big). */
-    if (unlikely(!ubase_check(uref_pic_resize(uref, 0, 0, frame->width, frame->height)))) {
-        upipe_warn_va(upipe, "couldn't resize picture to %dx%d",
-                      frame->width, frame->height);
-        upipe_throw_error(upipe, UBASE_ERR_EXTERNAL);
-    }
-
     /* Duplicate uref because it is freed in _release, because the ubuf
      * is still in use by avcodec. */
     uref = uref_dup(uref);
@@ -1005,14 +1216,28 @@ static void upipe_avcdec_output_pic(struct upipe *upipe, struct upump **upump_p)
         return;
     }
 
-    if (!(upipe_avcdec->context->codec->capabilities & CODEC_CAP_DR1)) {
+    if (likely(uref->ubuf != NULL)) {
+        /* Direct rendering, resize the picture (was allocated too big). */
+        if (unlikely(!ubase_check(uref_pic_resize(uref, 0, 0, frame->width,
+                                                  frame->height)))) {
+            upipe_warn_va(upipe, "couldn't resize picture to %dx%d",
+                          frame->width, frame->height);
+            upipe_throw_error(upipe, UBASE_ERR_EXTERNAL);
+        }
+    } else {
         /* Not direct rendering, copy data. */
         uint8_t planes;
-        if (unlikely(!ubase_check(uref_pic_flow_get_planes(flow_def_attr, &planes)))) {
+        struct ubuf *ubuf = ubuf_pic_alloc(upipe_avcdec->ubuf_mgr,
+                                           frame->width, frame->height);
+        if (unlikely(ubuf == NULL ||
+                     !ubase_check(uref_pic_flow_get_planes(flow_def_attr,
+                                                           &planes)))) {
+            ubuf_free(ubuf);
             uref_free(uref);
             upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
             return;
         }
+        uref_attach_ubuf(uref, ubuf);
 
         for (uint8_t plane = 0; plane < planes; plane++) {
             uint8_t *dst, *src, hsub, vsub;
@@ -1197,6 +1422,8 @@ static bool upipe_avcdec_decode_avpkt(struct upipe *upipe, AVPacket *avpkt,
             /* output frame if any has been decoded */
             if (gotframe) {
                 upipe_avcdec_output_pic(upipe, upump_p);
+                /* release our reference, avcodec may still hold its own */
+                av_frame_unref(upipe_avcdec->frame);
             }
             break;
 
@@ -1481,6 +1708,51 @@ static int upipe_avcdec_set_option(struct upipe *upipe,
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This sets the threading of the codec. It only takes effect
+ * the next time the codec is opened.
+ *
+ * @param upipe description structure of the pipe
+ * @param thread_type types of threading, or 0 for the default
+ * @param threads number of threads, or 0 for the default
+ * @return an error code
+ */
+static int _upipe_avcdec_set_threads(struct upipe *upipe, int thread_type,
+                                     unsigned int threads)
+{
+    struct upipe_avcdec *upipe_avcdec = upipe_avcdec_from_upipe(upipe);
+    if (thread_type & ~(UPIPE_AV_THREAD_FRAME | UPIPE_AV_THREAD_SLICE))
+        return UBASE_ERR_INVALID;
+    if (upipe_avcdec->context != NULL &&
+        avcodec_is_open(upipe_avcdec->context))
+        return UBASE_ERR_BUSY;
+    upipe_avcdec->thread_type = thread_type;
+    upipe_avcdec->threads = threads;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This returns the threading of the codec.
+ *
+ * @param upipe description structure of the pipe
+ * @param thread_type_p filled in with the types of threading
+ * @param threads_p filled in with the number of threads
+ * @return an error code
+ */
+static int _upipe_avcdec_get_threads(struct upipe *upipe, int *thread_type_p,
+                                     unsigned int *threads_p)
+{
+    struct upipe_avcdec *upipe_avcdec = upipe_avcdec_from_upipe(upipe);
+    if (upipe_avcdec->context != NULL &&
+        avcodec_is_open(upipe_avcdec->context)) {
+        upipe_av_get_threads(upipe_avcdec->context, thread_type_p, threads_p);
+        return UBASE_ERR_NONE;
+    }
+    if (thread_type_p != NULL)
+        *thread_type_p = upipe_avcdec->thread_type;
+    if (threads_p != NULL)
+        *threads_p = upipe_avcdec->threads;
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands on a file source pipe, and
  * checks the status of the pipe afterwards.
  *
@@ -1533,6 +1805,18 @@ static int upipe_avcdec_control(struct upipe *upipe, int command, va_list args)
             const char *content = va_arg(args, const char *);
             return upipe_avcdec_set_option(upipe, option, content);
         }
+        case UPIPE_AVCDEC_SET_THREADS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_AVCDEC_SIGNATURE)
+            int thread_type = va_arg(args, int);
+            unsigned int threads = va_arg(args, unsigned int);
+            return _upipe_avcdec_set_threads(upipe, thread_type, threads);
+        }
+        case UPIPE_AVCDEC_GET_THREADS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_AVCDEC_SIGNATURE)
+            int *thread_type_p = va_arg(args, int *);
+            unsigned int *threads_p = va_arg(args, unsigned int *);
+            return _upipe_avcdec_get_threads(upipe, thread_type_p, threads_p);
+        }
 
         default:
             return UBASE_ERR_UNHANDLED;
@@ -1552,6 +1836,7 @@ static void upipe_avcdec_free(struct upipe *upipe)
         av_free(upipe_avcdec->context);
     }
     av_frame_free(&upipe_avcdec->frame);
+    upipe_av_yield_threads(upipe_avcdec->threads_budget);
 
     upipe_throw_dead(upipe);
     uref_free(upipe_avcdec->uref);
@@ -1604,7 +1889,13 @@ static struct upipe *upipe_avcdec_alloc(struct upipe_mgr *mgr,
     upipe_avcdec->frame = frame;
     upipe_avcdec->counter = 0;
     upipe_avcdec->close = false;
+    upipe_avcdec->thread_type = 0;
+    upipe_avcdec->threads = 0;
+    upipe_avcdec->threads_budget = 0;
+    upipe_avcdec->last_thread_type = 0;
+    upipe_avcdec->last_threads = 0;
     upipe_avcdec->pix_fmt = AV_PIX_FMT_NONE;
+    upipe_avcdec->direct_rendering = false;
     upipe_avcdec->sample_fmt = AV_SAMPLE_FMT_NONE;
     upipe_avcdec->channels = 0;
     upipe_avcdec->uref = NULL;
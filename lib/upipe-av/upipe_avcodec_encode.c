@@ -175,6 +175,16 @@ struct upipe_avcenc {
     AVFrame *frame;
     /** true if the context will be closed */
     bool close;
+    /** requested types of threading, or 0 for the default */
+    int thread_type;
+    /** requested number of threads, or 0 for the default */
+    unsigned int threads;
+    /** number of threads taken from the budget */
+    unsigned int threads_budget;
+    /** types of threading of the last opened codec */
+    int last_thread_type;
+    /** number of threads of the last opened codec */
+    unsigned int last_threads;
 
     /** public upipe structure */
     struct upipe upipe;
@@ -282,12 +292,20 @@ static bool upipe_avcenc_do_av_deal(struct upipe *upipe)
         upipe_notice_va(upipe, "codec %s (%s) %d closed", context->codec->name, 
                         context->codec->long_name, context->codec->id);
         avcodec_close(context);
+        upipe_av_yield_threads(upipe_avcenc->threads_budget);
+        upipe_avcenc->threads_budget = 0;
         return false;
     }
 
     /* open new context */
+    bool exhausted;
+    upipe_avcenc->threads_budget =
+        upipe_av_grab_threads(context, upipe_avcenc->thread_type,
+                              upipe_avcenc->threads, &exhausted);
     int err;
     if (unlikely((err = avcodec_open2(context, context->codec, NULL)) < 0)) {
+        upipe_av_yield_threads(upipe_avcenc->threads_budget);
+        upipe_avcenc->threads_budget = 0;
         upipe_av_strerror(err, buf);
         upipe_warn_va(upipe, "could not open codec (%s)", buf);
         upipe_throw_fatal(upipe, UBASE_ERR_EXTERNAL);
@@ -296,6 +314,22 @@ static bool upipe_avcenc_do_av_deal(struct upipe *upipe)
     upipe_notice_va(upipe, "codec %s (%s) %d opened", context->codec->name, 
                     context->codec->long_name, context->codec->id);
 
+    int thread_type;
+    unsigned int threads;
+    upipe_av_get_threads(context, &thread_type, &threads);
+    if (unlikely(exhausted))
+        upipe_warn(upipe, "threads budget exhausted, codec not threaded");
+    if (exhausted || thread_type != upipe_avcenc->last_thread_type ||
+        threads != upipe_avcenc->last_threads) {
+        upipe_avcenc->last_thread_type = thread_type;
+        upipe_avcenc->last_threads = threads;
+        upipe_dbg_va(upipe, "using %u thread(s)%s%s", threads,
+                     thread_type & UPIPE_AV_THREAD_FRAME ? " frame" : "",
+                     thread_type & UPIPE_AV_THREAD_SLICE ? " slice" : "");
+        upipe_throw(upipe, UPROBE_AVCENC_THREADS, UPIPE_AVCENC_SIGNATURE,
+                    thread_type, threads);
+    }
+
     return true;
 }
 
@@ -440,6 +474,23 @@ static void upipe_avcenc_build_flow_def(struct upipe *upipe)
     if (context->codec->type == AVMEDIA_TYPE_AUDIO && context->frame_size > 0)
         uref_sound_flow_set_samples(flow_def, context->frame_size);
 
+    if (context->codec->type == AVMEDIA_TYPE_VIDEO && context->time_base.den) {
+        /* frames held by the encoder, plus one per additional frame
+         * thread */
+        int thread_type;
+        unsigned int threads;
+        upipe_av_get_threads(context, &thread_type, &threads);
+        uint64_t frames = context->delay > 0 ? context->delay : 0;
+        if (thread_type & UPIPE_AV_THREAD_FRAME)
+            frames += threads - 1;
+
+        uint64_t latency = 0;
+        uref_clock_get_latency(flow_def, &latency);
+        latency += frames * context->ticks_per_frame * UCLOCK_FREQ *
+                   context->time_base.num / context->time_base.den;
+        UBASE_FATAL(upipe, uref_clock_set_latency(flow_def, latency))
+    }
+
     /* global headers (extradata) */
     if (context->extradata_size) {
         UBASE_FATAL(upipe,
@@ -1377,6 +1428,51 @@ static int upipe_avcenc_set_option(struct upipe *upipe,
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This sets the threading of the codec. It only takes effect
+ * the next time the codec is opened.
+ *
+ * @param upipe description structure of the pipe
+ * @param thread_type types of threading, or 0 for the default
+ * @param threads number of threads, or 0 for the default
+ * @return an error code
+ */
+static int _upipe_avcenc_set_threads(struct upipe *upipe, int thread_type,
+                                     unsigned int threads)
+{
+    struct upipe_avcenc *upipe_avcenc = upipe_avcenc_from_upipe(upipe);
+    if (thread_type & ~(UPIPE_AV_THREAD_FRAME | UPIPE_AV_THREAD_SLICE))
+        return UBASE_ERR_INVALID;
+    if (upipe_avcenc->context != NULL &&
+        avcodec_is_open(upipe_avcenc->context))
+        return UBASE_ERR_BUSY;
+    upipe_avcenc->thread_type = thread_type;
+    upipe_avcenc->threads = threads;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This returns the threading of the codec.
+ *
+ * @param upipe description structure of the pipe
+ * @param thread_type_p filled in with the types of threading
+ * @param threads_p filled in with the number of threads
+ * @return an error code
+ */
+static int _upipe_avcenc_get_threads(struct upipe *upipe, int *thread_type_p,
+                                     unsigned int *threads_p)
+{
+    struct upipe_avcenc *upipe_avcenc = upipe_avcenc_from_upipe(upipe);
+    if (upipe_avcenc->context != NULL &&
+        avcodec_is_open(upipe_avcenc->context)) {
+        upipe_av_get_threads(upipe_avcenc->context, thread_type_p, threads_p);
+        return UBASE_ERR_NONE;
+    }
+    if (thread_type_p != NULL)
+        *thread_type_p = upipe_avcenc->thread_type;
+    if (threads_p != NULL)
+        *threads_p = upipe_avcenc->threads;
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands on a file source pipe, and
  * checks the status of the pipe afterwards.
  *
@@ -1431,6 +1527,18 @@ static int upipe_avcenc_control(struct upipe *upipe,
             const char *content = va_arg(args, const char *);
             return upipe_avcenc_set_option(upipe, option, content);
         }
+        case UPIPE_AVCENC_SET_THREADS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_AVCENC_SIGNATURE)
+            int thread_type = va_arg(args, int);
+            unsigned int threads = va_arg(args, unsigned int);
+            return _upipe_avcenc_set_threads(upipe, thread_type, threads);
+        }
+        case UPIPE_AVCENC_GET_THREADS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_AVCENC_SIGNATURE)
+            int *thread_type_p = va_arg(args, int *);
+            unsigned int *threads_p = va_arg(args, unsigned int *);
+            return _upipe_avcenc_get_threads(upipe, thread_type_p, threads_p);
+        }
 
         default:
             return UBASE_ERR_UNHANDLED;
@@ -1448,6 +1556,7 @@ static void upipe_avcenc_free(struct upipe *upipe)
     if (upipe_avcenc->context != NULL)
         av_free(upipe_avcenc->context);
     av_frame_free(&upipe_avcenc->frame);
+    upipe_av_yield_threads(upipe_avcenc->threads_budget);
 
     /* free remaining urefs (should not be any) */
     struct uchain *uchain;
@@ -1522,6 +1631,11 @@ static struct upipe *upipe_avcenc_alloc(struct upipe_mgr *mgr,
     upipe_avcenc->frame = frame;
     upipe_avcenc->context->codec = codec;
     upipe_avcenc->context->opaque = upipe;
+    upipe_avcenc->thread_type = 0;
+    upipe_avcenc->threads = 0;
+    upipe_avcenc->threads_budget = 0;
+    upipe_avcenc->last_thread_type = 0;
+    upipe_avcenc->last_threads = 0;
 
     upipe_avcenc_init_urefcount(upipe);
     upipe_avcenc_init_ubuf_mgr(upipe);
@@ -24,6 +24,8 @@
  * @short Upipe common utils for framers
  */
 
+#include <upipe/uscan.h>
+
 #include <stdint.h>
 
 #include "upipe_framers_common.h"
@@ -48,17 +50,12 @@ const uint8_t *upipe_framers_mpeg_scan(const uint8_t *restrict p,
             return p;
     }
 
-    while (p < end) {
-        if      (p[-1] > 1      ) p += 3;
-        else if (p[-2]          ) p += 2;
-        else if (p[-3]|(p[-1]-1)) p++;
-        else {
-            p++;
-            break;
-        }
-    }
-
-    if (p > end)
+    /* the start code must be followed by its value */
+    size_t size = end - p + 2;
+    size_t offset = uscan_start_code(p - 3, size);
+    if (offset < size)
+        p += offset + 1;
+    else
         p = end;
     *state = ((uint32_t)p[-4] << 24) | (p[-3] << 16) | (p[-2] << 8) | p[-1];
 
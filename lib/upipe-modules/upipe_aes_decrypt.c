@@ -35,6 +35,15 @@
 #include <upipe/uref_block.h>
 #include <upipe/urefcount.h>
 
+#include <string.h>
+#include <assert.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+/** @hidden */
+# define UPIPE_AES_X86
+# include <immintrin.h>
+#endif
+
 #define EXPECTED_FLOW_DEF       "block.aes."
 
 /** @internal @This is the private context of an aes pipe. */
@@ -77,7 +86,7 @@ struct upipe_aes_decrypt {
     /** reset aes state */
     bool restart;
     /** store round keys */
-    uint8_t round_keys[11][4][4];
+    uint8_t round_keys[11][16];
     /** store initialization vector */
     uint8_t iv[16];
 };
@@ -245,7 +254,7 @@ static void aes_key_expansion(const uint8_t key[16],
  * @param round the round number
  * @param state a block
  */
-static inline void aes_add_round_key(uint8_t round_keys[11][4][4],
+static inline void aes_add_round_key(const uint8_t round_keys[11][4][4],
                                      uint8_t round,
                                      uint8_t state[4][4])
 {
@@ -345,7 +354,7 @@ static void aes_inv_mix_columns(uint8_t state[4][4])
  * @param round_keys the generated round keys
  */
 static void aes_inv_cipher(uint8_t state[4][4],
-                           uint8_t round_keys[11][4][4])
+                           const uint8_t round_keys[11][4][4])
 {
     uint8_t round = 10;
 
@@ -376,13 +385,222 @@ static inline void aes_xor_iv(uint8_t state[4][4],
  * @param iv the initialization vector
  */
 static inline void aes_cbc_decrypt(uint8_t buffer[16],
-                                   uint8_t round_keys[11][4][4],
+                                   const uint8_t round_keys[11][4][4],
                                    const uint8_t iv[16])
 {
     aes_inv_cipher((uint8_t (*)[])buffer, round_keys);
     aes_xor_iv((uint8_t (*)[])buffer, iv);
 }
 
+/** @This expands an AES-128 key into the round keys of the cipher.
+ *
+ * @param key the AES key
+ * @param round_keys filled in with the round keys
+ */
+void upipe_aes_decrypt_expand_key(const uint8_t key[16],
+                                  uint8_t round_keys[11][16])
+{
+    aes_key_expansion(key, (uint8_t (*)[4][4])round_keys);
+}
+
+/** @This is the portable implementation of @ref upipe_aes_decrypt_cbc.
+ *
+ * @param buffer the buffer to decrypt
+ * @param size size of the buffer, a multiple of 16 octets
+ * @param round_keys the round keys
+ * @param iv the initialization vector, updated with the last encrypted
+ * block of the buffer
+ */
+void upipe_aes_decrypt_cbc_c(uint8_t *buffer, size_t size,
+                             const uint8_t round_keys[11][16],
+                             uint8_t iv[16])
+{
+    assert(!(size % 16));
+    for ( ; size; size -= 16, buffer += 16) {
+        uint8_t block[16];
+        memcpy(block, buffer, sizeof (block));
+        aes_cbc_decrypt(buffer, (const uint8_t (*)[4][4])round_keys, iv);
+        memcpy(iv, block, sizeof (block));
+    }
+}
+
+#ifdef UPIPE_AES_X86
+/** number of blocks decrypted at once by the AES-NI implementation, so that
+ * the latency of the aesdec instruction is hidden */
+#define AESNI_BLOCKS 8
+/** number of blocks decrypted at once by the VAES implementation */
+#define VAES_BLOCKS 16
+
+/** @internal @This derives the round keys of the equivalent inverse cipher
+ * used by the aesdec instruction.
+ *
+ * @param round_keys the round keys
+ * @param keys filled in with the decryption round keys
+ */
+__attribute__((target("aes,sse2")))
+static inline void aesni_decrypt_keys(const uint8_t round_keys[11][16],
+                                      __m128i keys[11])
+{
+    keys[0] = _mm_loadu_si128((const __m128i *)round_keys[10]);
+    for (unsigned i = 1; i < 10; i++)
+        keys[i] = _mm_aesimc_si128(
+                _mm_loadu_si128((const __m128i *)round_keys[10 - i]));
+    keys[10] = _mm_loadu_si128((const __m128i *)round_keys[0]);
+}
+
+/** @internal @This decrypts the remaining blocks of a buffer one by one.
+ *
+ * @param buffer the buffer to decrypt
+ * @param blocks number of blocks to decrypt
+ * @param keys the decryption round keys
+ * @param prev the previous encrypted block
+ * @return the last encrypted block
+ */
+__attribute__((target("aes,sse2")))
+static inline __m128i aesni_cbc_decrypt_blocks(uint8_t *buffer,
+        size_t blocks, const __m128i keys[11], __m128i prev)
+{
+    for ( ; blocks; blocks--, buffer += 16) {
+        __m128i in = _mm_loadu_si128((const __m128i *)buffer);
+        __m128i b = _mm_xor_si128(in, keys[0]);
+        for (unsigned i = 1; i < 10; i++)
+            b = _mm_aesdec_si128(b, keys[i]);
+        b = _mm_aesdeclast_si128(b, keys[10]);
+        _mm_storeu_si128((__m128i *)buffer, _mm_xor_si128(b, prev));
+        prev = in;
+    }
+    return prev;
+}
+
+/** @internal @This is the AES-NI implementation of
+ * @ref upipe_aes_decrypt_cbc. As CBC decryption does not depend on the
+ * previous plaintext, several blocks go through the rounds together; they
+ * are then chained from the last one, so that each encrypted block is
+ * still in the buffer when the next one needs it.
+ *
+ * @param buffer the buffer to decrypt
+ * @param size size of the buffer, a multiple of 16 octets
+ * @param round_keys the round keys
+ * @param iv the initialization vector, updated with the last encrypted
+ * block of the buffer
+ */
+__attribute__((target("aes,sse2")))
+static void aesni_cbc_decrypt(uint8_t *buffer, size_t size,
+                              const uint8_t round_keys[11][16],
+                              uint8_t iv[16])
+{
+    __m128i keys[11];
+    aesni_decrypt_keys(round_keys, keys);
+    __m128i prev = _mm_loadu_si128((const __m128i *)iv);
+    size_t blocks = size / 16;
+
+    for ( ; blocks >= AESNI_BLOCKS;
+         blocks -= AESNI_BLOCKS, buffer += AESNI_BLOCKS * 16) {
+        __m128i b[AESNI_BLOCKS];
+        for (unsigned j = 0; j < AESNI_BLOCKS; j++)
+            b[j] = _mm_xor_si128(
+                    _mm_loadu_si128((const __m128i *)(buffer + j * 16)),
+                    keys[0]);
+        for (unsigned i = 1; i < 10; i++)
+            for (unsigned j = 0; j < AESNI_BLOCKS; j++)
+                b[j] = _mm_aesdec_si128(b[j], keys[i]);
+        for (unsigned j = 0; j < AESNI_BLOCKS; j++)
+            b[j] = _mm_aesdeclast_si128(b[j], keys[10]);
+
+        __m128i last = _mm_loadu_si128(
+                (const __m128i *)(buffer + (AESNI_BLOCKS - 1) * 16));
+        for (unsigned j = AESNI_BLOCKS - 1; j > 0; j--)
+            _mm_storeu_si128((__m128i *)(buffer + j * 16),
+                    _mm_xor_si128(b[j], _mm_loadu_si128(
+                            (const __m128i *)(buffer + (j - 1) * 16))));
+        _mm_storeu_si128((__m128i *)buffer, _mm_xor_si128(b[0], prev));
+        prev = last;
+    }
+
+    prev = aesni_cbc_decrypt_blocks(buffer, blocks, keys, prev);
+    _mm_storeu_si128((__m128i *)iv, prev);
+}
+
+/** @internal @This is the VAES implementation of
+ * @ref upipe_aes_decrypt_cbc, decrypting two blocks per AVX2 register.
+ *
+ * @param buffer the buffer to decrypt
+ * @param size size of the buffer, a multiple of 16 octets
+ * @param round_keys the round keys
+ * @param iv the initialization vector, updated with the last encrypted
+ * block of the buffer
+ */
+__attribute__((target("aes,avx2,vaes")))
+static void vaes_cbc_decrypt(uint8_t *buffer, size_t size,
+                             const uint8_t round_keys[11][16],
+                             uint8_t iv[16])
+{
+    __m128i keys[11];
+    aesni_decrypt_keys(round_keys, keys);
+    __m256i keys2[11];
+    for (unsigned i = 0; i < 11; i++)
+        keys2[i] = _mm256_broadcastsi128_si256(keys[i]);
+    __m128i prev = _mm_loadu_si128((const __m128i *)iv);
+    size_t blocks = size / 16;
+
+    for ( ; blocks >= VAES_BLOCKS;
+         blocks -= VAES_BLOCKS, buffer += VAES_BLOCKS * 16) {
+        __m256i b[VAES_BLOCKS / 2];
+        for (unsigned j = 0; j < VAES_BLOCKS / 2; j++)
+            b[j] = _mm256_xor_si256(
+                    _mm256_loadu_si256((const __m256i *)(buffer + j * 32)),
+                    keys2[0]);
+        for (unsigned i = 1; i < 10; i++)
+            for (unsigned j = 0; j < VAES_BLOCKS / 2; j++)
+                b[j] = _mm256_aesdec_epi128(b[j], keys2[i]);
+        for (unsigned j = 0; j < VAES_BLOCKS / 2; j++)
+            b[j] = _mm256_aesdeclast_epi128(b[j], keys2[10]);
+
+        /* the previous encrypted blocks are one block behind */
+        __m128i last = _mm_loadu_si128(
+                (const __m128i *)(buffer + (VAES_BLOCKS - 1) * 16));
+        for (unsigned j = VAES_BLOCKS / 2 - 1; j > 0; j--)
+            _mm256_storeu_si256((__m256i *)(buffer + j * 32),
+                    _mm256_xor_si256(b[j], _mm256_loadu_si256(
+                            (const __m256i *)(buffer + j * 32 - 16))));
+        __m256i first = _mm256_inserti128_si256(_mm256_castsi128_si256(prev),
+                _mm_loadu_si128((const __m128i *)buffer), 1);
+        _mm256_storeu_si256((__m256i *)buffer, _mm256_xor_si256(b[0], first));
+        prev = last;
+    }
+
+    prev = aesni_cbc_decrypt_blocks(buffer, blocks, keys, prev);
+    _mm_storeu_si128((__m128i *)iv, prev);
+}
+#endif
+
+/** @This decrypts a buffer in place with AES-128 in CBC mode, with AES-NI
+ * or VAES when the CPU supports it.
+ *
+ * @param buffer the buffer to decrypt
+ * @param size size of the buffer, a multiple of 16 octets
+ * @param round_keys the round keys
+ * @param iv the initialization vector, updated with the last encrypted
+ * block of the buffer
+ */
+void upipe_aes_decrypt_cbc(uint8_t *buffer, size_t size,
+                           const uint8_t round_keys[11][16], uint8_t iv[16])
+{
+    assert(!(size % 16));
+#ifdef UPIPE_AES_X86
+    if (__builtin_cpu_supports("vaes") && __builtin_cpu_supports("avx2") &&
+        size >= VAES_BLOCKS * 16) {
+        vaes_cbc_decrypt(buffer, size, round_keys, iv);
+        return;
+    }
+    if (__builtin_cpu_supports("aes")) {
+        aesni_cbc_decrypt(buffer, size, round_keys, iv);
+        return;
+    }
+#endif
+    upipe_aes_decrypt_cbc_c(buffer, size, round_keys, iv);
+}
+
 /** @internal @This allocates an aes decryption pipe.
  *
  * @param mgr reference to the aes decryption pipe manager.
@@ -471,7 +689,8 @@ static int upipe_aes_decrypt_restart(struct upipe *upipe)
         return ret;
     }
 
-    aes_key_expansion(key, upipe_aes_decrypt->round_keys);
+    upipe_aes_decrypt_expand_key(key, upipe_aes_decrypt->round_keys);
+    memcpy(upipe_aes_decrypt->iv, iv, sizeof (upipe_aes_decrypt->iv));
     return UBASE_ERR_NONE;
 }
 
@@ -496,46 +715,52 @@ static void upipe_aes_decrypt_worker(struct upipe *upipe,
 
     size_t block_size;
     ubase_assert(uref_block_size(upipe_aes_decrypt->next_uref, &block_size));
-    for (size_t size = block_size; size >= 16; size -= 16) {
-        int ret;
-
-        struct uref *uref = upipe_aes_decrypt_extract_uref_stream(upipe, 16);
+    while (block_size >= 16) {
+        /* decrypt whole input urefs at once, so that their attributes are
+         * kept and the cipher works on large buffers */
+        size_t size = upipe_aes_decrypt->next_uref_size;
+        size += (16 - size % 16) % 16;
+        if (!size || size > block_size)
+            size = block_size - block_size % 16;
+        block_size -= size;
+
+        struct uref *uref = upipe_aes_decrypt_extract_uref_stream(upipe, size);
         if (unlikely(!uref)) {
             upipe_throw_fatal(upipe, UBASE_ERR_INVALID);
             return;
         }
 
-        uint8_t iv[16];
-        ret = uref_block_extract(uref, 0, 16, iv);
-        if (unlikely(!ubase_check(ret))) {
-            uref_free(uref);
-            upipe_throw_fatal(upipe, UBASE_ERR_INVALID);
-            return;
-        }
-
         struct ubuf *ubuf =
-            ubuf_block_alloc(upipe_aes_decrypt->ubuf_mgr, 16);
+            ubuf_block_alloc(upipe_aes_decrypt->ubuf_mgr, size);
         if (unlikely(!ubuf)) {
             uref_free(uref);
             upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
             return;
         }
-        uref_attach_ubuf(uref, ubuf);
 
-        int wsize = 16;
+        int wsize = size;
         uint8_t *wbuf;
-        ret = uref_block_write(uref, 0, &wsize, &wbuf);
-        if (unlikely(!ubase_check(ret)) || wsize != 16) {
+        int ret = ubuf_block_write(ubuf, 0, &wsize, &wbuf);
+        if (unlikely(!ubase_check(ret)) || (size_t)wsize != size) {
+            ubuf_free(ubuf);
             uref_free(uref);
             upipe_throw_fatal(upipe, UBASE_ERR_INVALID);
             return;
         }
-        memcpy(wbuf, iv, wsize);
-        aes_cbc_decrypt(wbuf,
-                        upipe_aes_decrypt->round_keys,
-                        upipe_aes_decrypt->iv);
-        ubase_assert(uref_block_unmap(uref, 0));
-        memcpy(upipe_aes_decrypt->iv, iv, sizeof (upipe_aes_decrypt->iv));
+        ret = uref_block_extract(uref, 0, size, wbuf);
+        if (unlikely(!ubase_check(ret))) {
+            ubuf_block_unmap(ubuf, 0);
+            ubuf_free(ubuf);
+            uref_free(uref);
+            upipe_throw_fatal(upipe, UBASE_ERR_INVALID);
+            return;
+        }
+        upipe_aes_decrypt_cbc(wbuf, size,
+                              (const uint8_t (*)[16])
+                              upipe_aes_decrypt->round_keys,
+                              upipe_aes_decrypt->iv);
+        ubase_assert(ubuf_block_unmap(ubuf, 0));
+        uref_attach_ubuf(uref, ubuf);
         upipe_aes_decrypt_output(upipe, uref, upump_p);
     }
 }
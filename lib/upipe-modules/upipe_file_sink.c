@@ -57,6 +57,7 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
 #include <errno.h>
 #include <assert.h>
 
@@ -67,6 +68,8 @@
 /** @hidden */
 static void upipe_fsink_watcher(struct upump *upump);
 /** @hidden */
+static void upipe_fsink_io_watcher(struct upump *upump);
+/** @hidden */
 static bool upipe_fsink_output(struct upipe *upipe, struct uref *uref,
                                struct upump **upump_p);
 
@@ -81,6 +84,20 @@ struct upipe_fsink {
     struct upump *upump;
     /** sync watcher */
     struct upump *upump_sync;
+    /** I/O pump performing the writes */
+    struct upump *upump_io;
+    /** true if the event loop doesn't support I/O pumps */
+    bool io_unsupported;
+    /** description of the write operation of the I/O pump */
+    struct upump_io io;
+    /** buffers of the write operation */
+    struct iovec *io_iovecs;
+    /** number of allocated buffers */
+    int io_iovecs_size;
+    /** reference being written by the I/O pump */
+    struct uref *io_uref;
+    /** true if the write operation of io_uref is completed */
+    bool io_completed;
 
     /** uclock structure, if not NULL we are in live mode */
     struct uclock *uclock;
@@ -115,6 +132,7 @@ UPIPE_HELPER_VOID(upipe_fsink)
 UPIPE_HELPER_UPUMP_MGR(upipe_fsink, upump_mgr)
 UPIPE_HELPER_UPUMP(upipe_fsink, upump, upump_mgr)
 UPIPE_HELPER_UPUMP(upipe_fsink, upump_sync, upump_mgr)
+UPIPE_HELPER_UPUMP(upipe_fsink, upump_io, upump_mgr)
 UPIPE_HELPER_INPUT(upipe_fsink, urefs, nb_urefs, max_urefs, blockers, upipe_fsink_output)
 UPIPE_HELPER_UCLOCK(upipe_fsink, uclock, uclock_request, NULL, upipe_throw_provide_request, NULL)
 
@@ -139,12 +157,21 @@ static struct upipe *upipe_fsink_alloc(struct upipe_mgr *mgr,
     upipe_fsink_init_upump_mgr(upipe);
     upipe_fsink_init_upump(upipe);
     upipe_fsink_init_upump_sync(upipe);
+    upipe_fsink_init_upump_io(upipe);
     upipe_fsink_init_input(upipe);
     upipe_fsink_init_uclock(upipe);
     upipe_fsink->latency = 0;
     upipe_fsink->fd = -1;
     upipe_fsink->path = NULL;
     upipe_fsink->sync_period = 0;
+    upipe_fsink->io_unsupported = false;
+    upipe_fsink->io.type = UPUMP_IO_WRITE;
+    upipe_fsink->io.fd = -1;
+    upipe_fsink->io.msg = NULL;
+    upipe_fsink->io_iovecs = NULL;
+    upipe_fsink->io_iovecs_size = 0;
+    upipe_fsink->io_uref = NULL;
+    upipe_fsink->io_completed = false;
     upipe_throw_ready(upipe);
     return upipe;
 }
@@ -172,6 +199,72 @@ static void upipe_fsink_poll(struct upipe *upipe)
     }
 }
 
+/** @internal @This lets the event loop write a buffer, if it is able to.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param iovec_count number of buffers in the uref
+ * @return false if the buffer must be written synchronously
+ */
+static bool upipe_fsink_submit_io(struct upipe *upipe, struct uref *uref,
+                                  int iovec_count)
+{
+    struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
+    if (upipe_fsink->io_unsupported)
+        return false;
+
+    if (upipe_fsink->upump_io == NULL) {
+        if (unlikely(!ubase_check(upipe_fsink_check_upump_mgr(upipe))))
+            return false;
+        struct upump *upump = upump_alloc_io(upipe_fsink->upump_mgr,
+                upipe_fsink_io_watcher, upipe, upipe->refcount,
+                &upipe_fsink->io);
+        if (upump == NULL) {
+            upipe_fsink->io_unsupported = true;
+            return false;
+        }
+        upipe_fsink_set_upump_io(upipe, upump);
+    }
+
+    if (iovec_count > upipe_fsink->io_iovecs_size) {
+        struct iovec *iovecs = realloc(upipe_fsink->io_iovecs,
+                                       iovec_count * sizeof(struct iovec));
+        if (unlikely(iovecs == NULL))
+            return false;
+        upipe_fsink->io_iovecs = iovecs;
+        upipe_fsink->io_iovecs_size = iovec_count;
+    }
+    if (unlikely(!ubase_check(uref_block_iovec_read(uref, 0, -1,
+                                                    upipe_fsink->io_iovecs))))
+        return false;
+
+    upipe_fsink->io.fd = upipe_fsink->fd;
+    upipe_fsink->io.iovecs = upipe_fsink->io_iovecs;
+    upipe_fsink->io.iovec_count = iovec_count;
+    upipe_fsink->io.offset = -1;
+    upipe_fsink->io_uref = uref;
+    upipe_fsink->io_completed = false;
+    upump_start(upipe_fsink->upump_io);
+    return true;
+}
+
+/** @internal @This abandons the write operation in flight, if any. The
+ * buffer stays in the queue.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_fsink_cancel_io(struct upipe *upipe)
+{
+    struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
+    /* the operation in flight is cancelled with the pump */
+    upipe_fsink_set_upump_io(upipe, NULL);
+    if (upipe_fsink->io_uref != NULL) {
+        uref_block_iovec_unmap(upipe_fsink->io_uref, 0, -1,
+                               upipe_fsink->io_iovecs);
+        upipe_fsink->io_uref = NULL;
+    }
+}
+
 /** @internal @This outputs data to the file sink.
  *
  * @param upipe description structure of the pipe
@@ -217,27 +310,43 @@ static bool upipe_fsink_output(struct upipe *upipe, struct uref *uref,
 
 write_buffer:
     for ( ; ; ) {
-        int iovec_count = uref_block_iovec_count(uref, 0, -1);
-        if (unlikely(iovec_count == -1)) {
-            uref_free(uref);
-            upipe_warn(upipe, "cannot read ubuf buffer");
-            break;
-        }
-        if (unlikely(iovec_count == 0)) {
-            uref_free(uref);
-            break;
-        }
+        ssize_t ret;
+        if (unlikely(upipe_fsink->io_uref == uref)) {
+            if (unlikely(!upipe_fsink->io_completed))
+                return false;
+            uref_block_iovec_unmap(uref, 0, -1, upipe_fsink->io_iovecs);
+            upipe_fsink->io_uref = NULL;
+            ret = upipe_fsink->io.ret;
+            if (unlikely(ret < 0)) {
+                errno = -ret;
+                ret = -1;
+            }
+        } else {
+            int iovec_count = uref_block_iovec_count(uref, 0, -1);
+            if (unlikely(iovec_count == -1)) {
+                uref_free(uref);
+                upipe_warn(upipe, "cannot read ubuf buffer");
+                break;
+            }
+            if (unlikely(iovec_count == 0)) {
+                uref_free(uref);
+                break;
+            }
 
-        struct iovec iovecs[iovec_count];
-        if (unlikely(!ubase_check(uref_block_iovec_read(uref, 0, -1,
-                                                        iovecs)))) {
-            uref_free(uref);
-            upipe_warn(upipe, "cannot read ubuf buffer");
-            break;
-        }
+            if (upipe_fsink_submit_io(upipe, uref, iovec_count))
+                return false;
 
-        ssize_t ret = writev(upipe_fsink->fd, iovecs, iovec_count);
-        uref_block_iovec_unmap(uref, 0, -1, iovecs);
+            struct iovec iovecs[iovec_count];
+            if (unlikely(!ubase_check(uref_block_iovec_read(uref, 0, -1,
+                                                            iovecs)))) {
+                uref_free(uref);
+                upipe_warn(upipe, "cannot read ubuf buffer");
+                break;
+            }
+
+            ret = writev(upipe_fsink->fd, iovecs, iovec_count);
+            uref_block_iovec_unmap(uref, 0, -1, iovecs);
+        }
 
         if (unlikely(ret == -1)) {
             switch (errno) {
@@ -295,6 +404,21 @@ static void upipe_fsink_watcher(struct upump *upump)
     }
 }
 
+/** @internal @This is called when the event loop completed a write
+ * operation. Unblock the sink and unqueue all queued buffers.
+ *
+ * @param upump description structure of the I/O pump
+ */
+static void upipe_fsink_io_watcher(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
+    /* do not submit the same operation again */
+    upump_stop(upump);
+    upipe_fsink->io_completed = true;
+    upipe_fsink_watcher(upump);
+}
+
 /** @internal @This is called when the file descriptor needs to be sync'ed.
  *
  * @param upump description structure of the timer
@@ -357,6 +481,7 @@ static int upipe_fsink_set_flow_def(struct upipe *upipe, struct uref *flow_def)
  */
 static int upipe_fsink_flush(struct upipe *upipe)
 {
+    upipe_fsink_cancel_io(upipe);
     if (upipe_fsink_flush_input(upipe)) {
         upipe_fsink_set_upump(upipe, NULL);
         /* All packets have been output, release again the pipe that has been
@@ -400,6 +525,7 @@ static int _upipe_fsink_set_path(struct upipe *upipe, const char *path,
     ubase_clean_str(&upipe_fsink->path);
     upipe_fsink_set_upump(upipe, NULL);
     upipe_fsink_set_upump_sync(upipe, NULL);
+    upipe_fsink_cancel_io(upipe);
     if (!upipe_fsink_check_input(upipe))
         /* Release the pipe used in @ref upipe_fsink_input. */
         upipe_release(upipe);
@@ -518,6 +644,8 @@ static int  _upipe_fsink_control(struct upipe *upipe, int command, va_list args)
         case UPIPE_ATTACH_UPUMP_MGR:
             upipe_fsink_set_upump(upipe, NULL);
             upipe_fsink_set_upump_sync(upipe, NULL);
+            upipe_fsink_cancel_io(upipe);
+            upipe_fsink_from_upipe(upipe)->io_unsupported = false;
             return upipe_fsink_attach_upump_mgr(upipe);
         case UPIPE_ATTACH_UCLOCK:
             upipe_fsink_set_upump(upipe, NULL);
@@ -589,10 +717,11 @@ static int upipe_fsink_control(struct upipe *upipe, int command, va_list args)
 {
     UBASE_RETURN(_upipe_fsink_control(upipe, command, args));
 
-    if (unlikely(!upipe_fsink_check_input(upipe)))
+    struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
+    if (unlikely(!upipe_fsink_check_input(upipe)) &&
+        upipe_fsink->io_uref == NULL)
         upipe_fsink_poll(upipe);
 
-    struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
     if (upipe_fsink->sync_period && upipe_fsink->fd != -1) {
         if (unlikely(!ubase_check(upipe_fsink_check_upump_mgr(upipe)))) {
             upipe_err_va(upipe, "can't get upump_mgr");
@@ -632,6 +761,9 @@ static void upipe_fsink_free(struct upipe *upipe)
     upipe_fsink_clean_uclock(upipe);
     upipe_fsink_clean_upump(upipe);
     upipe_fsink_clean_upump_sync(upipe);
+    upipe_fsink_cancel_io(upipe);
+    upipe_fsink_clean_upump_io(upipe);
+    free(upipe_fsink->io_iovecs);
     upipe_fsink_clean_upump_mgr(upipe);
     upipe_fsink_clean_input(upipe);
     upipe_fsink_clean_urefcount(upipe);
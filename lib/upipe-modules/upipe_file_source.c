@@ -39,6 +39,7 @@
 #include <upipe/uref_clock.h>
 #include <upipe/upump.h>
 #include <upipe/ubuf.h>
+#include <upipe/ubuf_block_mmap.h>
 #include <upipe/upipe.h>
 #include <upipe/upipe_helper_upipe.h>
 #include <upipe/upipe_helper_urefcount.h>
@@ -60,6 +61,7 @@
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <fcntl.h>
 #include <sys/ioctl.h>
 #include <errno.h>
@@ -71,6 +73,8 @@
 
 /** default size of buffers when unspecified */
 #define UBUF_DEFAULT_SIZE       32768
+/** depth of the pool of the mapped buffers */
+#define UBUF_MMAP_POOL_DEPTH    64
 
 /** @hidden */
 static int upipe_fsrc_check(struct upipe *upipe, struct uref *flow_format);
@@ -123,6 +127,24 @@ struct upipe_fsrc {
     /** length to read */
     uint64_t length;
 
+    /** true if regular files must be mapped */
+    bool mmap;
+    /** ubuf manager pointing to the mapped file, in mmap mode */
+    struct ubuf_mgr *mmap_mgr;
+    /** reading position, in mmap mode or with an I/O pump */
+    uint64_t position;
+    /** last known size of the file, in mmap mode */
+    uint64_t size;
+
+    /** true if the read watcher is an I/O pump */
+    bool io_pump;
+    /** description of the read operation of the I/O pump */
+    struct upump_io io;
+    /** buffer of the read operation */
+    struct iovec iovec;
+    /** reference being read by the I/O pump */
+    struct uref *io_uref;
+
     /** public upipe structure */
     struct upipe upipe;
     /** guard for upump */
@@ -173,7 +195,19 @@ static struct upipe *upipe_fsrc_alloc(struct upipe_mgr *mgr,
     upipe_fsrc_init_output_size(upipe, UBUF_DEFAULT_SIZE);
     upipe_fsrc->uri = NULL;
     upipe_fsrc->fd = -1;
+    upipe_fsrc->regular_file = false;
     upipe_fsrc->length = (uint64_t)-1;
+    upipe_fsrc->mmap = false;
+    upipe_fsrc->mmap_mgr = NULL;
+    upipe_fsrc->position = 0;
+    upipe_fsrc->size = 0;
+    upipe_fsrc->io_pump = false;
+    upipe_fsrc->io.type = UPUMP_IO_READ;
+    upipe_fsrc->io.fd = -1;
+    upipe_fsrc->io.iovecs = &upipe_fsrc->iovec;
+    upipe_fsrc->io.iovec_count = 1;
+    upipe_fsrc->io.msg = NULL;
+    upipe_fsrc->io_uref = NULL;
     upipe_fsrc->safe = false;
     upipe_throw_ready(upipe);
     return upipe;
@@ -185,6 +219,14 @@ static void upipe_fsrc_set_upump_safe(struct upipe *upipe,
     struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
     upipe_fsrc->safe = false;
     upipe_fsrc_set_upump(upipe, upump);
+    if (upipe_fsrc->io_pump) {
+        /* the read in flight, if any, was completed or cancelled */
+        uref_free(upipe_fsrc->io_uref);
+        upipe_fsrc->io_uref = NULL;
+        upipe_fsrc->io_pump = false;
+        if (upipe_fsrc->fd != -1)
+            lseek(upipe_fsrc->fd, upipe_fsrc->position, SEEK_SET);
+    }
 }
 
 /** @internal @This returns the path of the currently opened file.
@@ -202,59 +244,76 @@ static int upipe_fsrc_get_uri(struct upipe *upipe, const char **path_p)
     return uref_uri_get_path(upipe_fsrc->uri, path_p);
 }
 
-/** @internal @This reads data from the source and outputs it.
- * It is called either when the idler triggers (permanent storage mode) or
- * when data is available on the file descriptor (live stream mode).
+/** @internal @This allocates a uref pointing to the next part of the
+ * mapped file.
  *
- * @param upump description structure of the read watcher
+ * @param upipe description structure of the pipe
+ * @param ret_p filled in with the size of the buffer, or -1 in case of
+ * error of the file
+ * @return pointer to uref, or NULL in case of error
  */
-static void upipe_fsrc_worker(struct upump *upump)
+static struct uref *upipe_fsrc_map(struct upipe *upipe, ssize_t *ret_p)
 {
-    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
     struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
-    uint64_t systime = 0; /* to keep gcc quiet */
-    if (upipe_fsrc->uclock != NULL)
-        systime = uclock_now(upipe_fsrc->uclock);
-
-    if (!upipe_fsrc->length) {
-        const char *path;
-        if (ubase_check(upipe_fsrc_get_uri(upipe, &path)))
-            path = "(none)";
-        upipe_notice_va(upipe, "end of range %s", path);
-        upipe_fsrc_set_upump_safe(upipe, NULL);
-        ubase_clean_fd(&upipe_fsrc->fd);
-        upipe_throw_source_end(upipe);
-        return;
-    }
-
-    if (upipe_fsrc->length != (uint64_t)-1 &&
-        upipe_fsrc->length < upipe_fsrc->output_size &&
-        unlikely(upipe_fsrc_set_output_size(upipe, upipe_fsrc->length))) {
-            upipe_err(upipe, "fail to set output size");
-            return;
-    }
-
-    struct uref *uref = uref_block_alloc(upipe_fsrc->uref_mgr,
-                                         upipe_fsrc->ubuf_mgr,
-                                         upipe_fsrc->output_size);
-    if (unlikely(uref == NULL)) {
-        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
-        return;
+    uint64_t size = upipe_fsrc->output_size;
+    if (upipe_fsrc->position + size > upipe_fsrc->size) {
+        /* the file may have grown since */
+        struct stat st;
+        if (unlikely(fstat(upipe_fsrc->fd, &st) == -1)) {
+            *ret_p = -1;
+            return NULL;
+        }
+        upipe_fsrc->size = st.st_size;
+        if (upipe_fsrc->position >= upipe_fsrc->size)
+            size = 0;
+        else if (upipe_fsrc->position + size > upipe_fsrc->size)
+            size = upipe_fsrc->size - upipe_fsrc->position;
     }
 
-    uint8_t *buffer;
-    int output_size = -1;
-    if (unlikely(!ubase_check(uref_block_write(uref, 0, &output_size,
-                                               &buffer)))) {
+    *ret_p = 0;
+    struct uref *uref = uref_alloc(upipe_fsrc->uref_mgr);
+    if (unlikely(uref == NULL))
+        return NULL;
+    struct ubuf *ubuf = ubuf_block_mmap_alloc(upipe_fsrc->mmap_mgr,
+                                              upipe_fsrc->position, size);
+    if (unlikely(ubuf == NULL)) {
         uref_free(uref);
-        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
-        return;
+        *ret_p = -1;
+        return NULL;
     }
-    assert(output_size == upipe_fsrc->output_size);
+    uref_attach_ubuf(uref, ubuf);
+    upipe_fsrc->position += size;
+    *ret_p = size;
+    return uref;
+}
 
-    ssize_t ret = read(upipe_fsrc->fd, buffer, upipe_fsrc->output_size);
-    uref_block_unmap(uref, 0);
+/** @internal @This ends the reading of the configured range.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_fsrc_end_range(struct upipe *upipe)
+{
+    struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
+    const char *path;
+    if (ubase_check(upipe_fsrc_get_uri(upipe, &path)))
+        path = "(none)";
+    upipe_notice_va(upipe, "end of range %s", path);
+    upipe_fsrc_set_upump_safe(upipe, NULL);
+    ubase_clean_fd(&upipe_fsrc->fd);
+    upipe_throw_source_end(upipe);
+}
 
+/** @internal @This outputs data read from the source.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref buffer containing the data
+ * @param ret return value of the read operation
+ * @param systime date of the read operation, if live
+ */
+static void upipe_fsrc_output_data(struct upipe *upipe, struct uref *uref,
+                                   ssize_t ret, uint64_t systime)
+{
+    struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
     const char *path;
     if (!ubase_check(upipe_fsrc_get_uri(upipe, &path)))
         path = "(none)";
@@ -285,8 +344,6 @@ static void upipe_fsrc_worker(struct upump *upump)
         upipe_fsrc->length -= ret;
     if (upipe_fsrc->uclock != NULL)
         uref_clock_set_cr_sys(uref, systime);
-    if (unlikely(ret != upipe_fsrc->output_size))
-        uref_block_resize(uref, 0, ret);
     if (unlikely(ret == 0))
         uref_block_set_end(uref);
     upipe_fsrc->safe = true;
@@ -299,6 +356,143 @@ static void upipe_fsrc_worker(struct upump *upump)
     }
 }
 
+/** @internal @This reads data from the source and outputs it.
+ * It is called either when the idler triggers (permanent storage mode) or
+ * when data is available on the file descriptor (live stream mode).
+ *
+ * @param upump description structure of the read watcher
+ */
+static void upipe_fsrc_worker(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
+    uint64_t systime = 0; /* to keep gcc quiet */
+    if (upipe_fsrc->uclock != NULL)
+        systime = uclock_now(upipe_fsrc->uclock);
+
+    if (!upipe_fsrc->length) {
+        upipe_fsrc_end_range(upipe);
+        return;
+    }
+
+    if (upipe_fsrc->length != (uint64_t)-1 &&
+        upipe_fsrc->length < upipe_fsrc->output_size &&
+        unlikely(upipe_fsrc_set_output_size(upipe, upipe_fsrc->length))) {
+            upipe_err(upipe, "fail to set output size");
+            return;
+    }
+
+    struct uref *uref;
+    ssize_t ret;
+    if (upipe_fsrc->mmap_mgr != NULL) {
+        uref = upipe_fsrc_map(upipe, &ret);
+        if (unlikely(uref == NULL && ret != -1)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
+    } else {
+        uref = uref_block_alloc(upipe_fsrc->uref_mgr, upipe_fsrc->ubuf_mgr,
+                                upipe_fsrc->output_size);
+        if (unlikely(uref == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
+
+        uint8_t *buffer;
+        int output_size = -1;
+        if (unlikely(!ubase_check(uref_block_write(uref, 0, &output_size,
+                                                   &buffer)))) {
+            uref_free(uref);
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
+        assert(output_size == upipe_fsrc->output_size);
+
+        ret = read(upipe_fsrc->fd, buffer, upipe_fsrc->output_size);
+        uref_block_unmap(uref, 0);
+    }
+
+    if (likely(ret != -1) && unlikely(ret != upipe_fsrc->output_size) &&
+        upipe_fsrc->mmap_mgr == NULL)
+        uref_block_resize(uref, 0, ret);
+    upipe_fsrc_output_data(upipe, uref, ret, systime);
+}
+
+/** @internal @This allocates the buffer of the next read operation of the
+ * I/O pump.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_fsrc_prepare_io(struct upipe *upipe)
+{
+    struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
+    upipe_fsrc->io.offset = upipe_fsrc->position;
+    upipe_fsrc->iovec.iov_len = 0;
+    if (!upipe_fsrc->length)
+        /* the empty read will end the range */
+        return UBASE_ERR_NONE;
+
+    if (upipe_fsrc->length != (uint64_t)-1 &&
+        upipe_fsrc->length < upipe_fsrc->output_size)
+        UBASE_RETURN(upipe_fsrc_set_output_size(upipe, upipe_fsrc->length))
+
+    struct uref *uref = uref_block_alloc(upipe_fsrc->uref_mgr,
+                                         upipe_fsrc->ubuf_mgr,
+                                         upipe_fsrc->output_size);
+    if (unlikely(uref == NULL))
+        return UBASE_ERR_ALLOC;
+
+    uint8_t *buffer;
+    int output_size = -1;
+    if (unlikely(!ubase_check(uref_block_write(uref, 0, &output_size,
+                                               &buffer)))) {
+        uref_free(uref);
+        return UBASE_ERR_ALLOC;
+    }
+    upipe_fsrc->iovec.iov_base = buffer;
+    upipe_fsrc->iovec.iov_len = output_size;
+    upipe_fsrc->io_uref = uref;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This outputs the data read by the I/O pump, and prepares the
+ * next read operation.
+ *
+ * @param upump description structure of the I/O pump
+ */
+static void upipe_fsrc_io_worker(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
+    uint64_t systime = 0; /* to keep gcc quiet */
+    if (upipe_fsrc->uclock != NULL)
+        systime = uclock_now(upipe_fsrc->uclock);
+
+    struct uref *uref = upipe_fsrc->io_uref;
+    upipe_fsrc->io_uref = NULL;
+    if (uref == NULL) {
+        upipe_fsrc_end_range(upipe);
+        return;
+    }
+
+    uref_block_unmap(uref, 0);
+    ssize_t ret = upipe_fsrc->io.ret;
+    if (unlikely(ret < 0)) {
+        errno = -ret;
+        ret = -1;
+    } else {
+        upipe_fsrc->position += ret;
+        if (unlikely(ret != upipe_fsrc->iovec.iov_len))
+            uref_block_resize(uref, 0, ret);
+    }
+    upipe_fsrc_output_data(upipe, uref, ret, systime);
+
+    if (upipe_fsrc->io_pump && upipe_fsrc->io_uref == NULL &&
+        unlikely(!ubase_check(upipe_fsrc_prepare_io(upipe))))
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+}
+
 /** @internal @This checks if the pump may be allocated.
  *
  * @param upipe description structure of the pipe
@@ -330,7 +524,7 @@ static int upipe_fsrc_check(struct upipe *upipe, struct uref *flow_format)
         return UBASE_ERR_NONE;
     }
 
-    if (upipe_fsrc->ubuf_mgr == NULL) {
+    if (upipe_fsrc->ubuf_mgr == NULL && upipe_fsrc->mmap_mgr == NULL) {
         struct uref *flow_format =
             uref_block_flow_alloc_def(upipe_fsrc->uref_mgr, NULL);
         uref_block_flow_set_size(flow_format, upipe_fsrc->output_size);
@@ -348,7 +542,33 @@ static int upipe_fsrc_check(struct upipe *upipe, struct uref *flow_format)
         return UBASE_ERR_NONE;
 
     if (upipe_fsrc->fd != -1 && upipe_fsrc->upump == NULL) {
-        struct upump *upump;
+        struct upump *upump = NULL;
+        if (upipe_fsrc->regular_file && upipe_fsrc->mmap_mgr == NULL) {
+            /* let the event loop perform the reads if it is able to */
+            upipe_fsrc->io.fd = upipe_fsrc->fd;
+            upump = upump_alloc_io(upipe_fsrc->upump_mgr,
+                                   upipe_fsrc_io_worker, upipe,
+                                   upipe->refcount, &upipe_fsrc->io);
+            if (upump != NULL) {
+                off_t position = lseek(upipe_fsrc->fd, 0, SEEK_CUR);
+                if (unlikely(position == (off_t)-1)) {
+                    upump_free(upump);
+                    return UBASE_ERR_EXTERNAL;
+                }
+                upipe_fsrc->position = position;
+                int err = upipe_fsrc_prepare_io(upipe);
+                if (unlikely(!ubase_check(err))) {
+                    upump_free(upump);
+                    upipe_throw_fatal(upipe, err);
+                    return err;
+                }
+                upipe_fsrc_set_upump_safe(upipe, upump);
+                upipe_fsrc->io_pump = true;
+                upump_start(upump);
+                return UBASE_ERR_NONE;
+            }
+        }
+
         if (upipe_fsrc->regular_file)
             upump = upump_alloc_idler(upipe_fsrc->upump_mgr,
                                       upipe_fsrc_worker, upipe,
@@ -367,6 +587,53 @@ static int upipe_fsrc_check(struct upipe *upipe, struct uref *flow_format)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This starts mapping the opened file if it is configured and
+ * possible.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_fsrc_open_mmap(struct upipe *upipe)
+{
+    struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
+    if (!upipe_fsrc->mmap || upipe_fsrc->fd == -1 ||
+        !upipe_fsrc->regular_file || upipe_fsrc->mmap_mgr != NULL)
+        return UBASE_ERR_NONE;
+    if (upipe_fsrc->io_pump)
+        /* the idler is allocated again later */
+        upipe_fsrc_set_upump_safe(upipe, NULL);
+
+    off_t position = lseek(upipe_fsrc->fd, 0, SEEK_CUR);
+    if (unlikely(position == (off_t)-1))
+        return UBASE_ERR_EXTERNAL;
+    upipe_fsrc->mmap_mgr = ubuf_block_mmap_mgr_alloc(UBUF_MMAP_POOL_DEPTH,
+                                                     upipe_fsrc->fd, 0);
+    if (unlikely(upipe_fsrc->mmap_mgr == NULL)) {
+        upipe_err(upipe, "unable to map the file");
+        return UBASE_ERR_ALLOC;
+    }
+    upipe_fsrc->position = position;
+    upipe_fsrc->size = 0;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This stops mapping the file, and gives the reading position
+ * back to the file descriptor. Buffers still in use remain valid.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_fsrc_close_mmap(struct upipe *upipe)
+{
+    struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
+    if (upipe_fsrc->mmap_mgr == NULL)
+        return;
+
+    if (upipe_fsrc->fd != -1)
+        lseek(upipe_fsrc->fd, upipe_fsrc->position, SEEK_SET);
+    ubuf_mgr_release(upipe_fsrc->mmap_mgr);
+    upipe_fsrc->mmap_mgr = NULL;
+}
+
 /** @internal @This asks to open the given file.
  *
  * @param upipe description structure of the pipe
@@ -401,13 +668,14 @@ static int upipe_fsrc_open(struct upipe *upipe)
     upipe_fsrc->fd = fd;
     upipe_fsrc->regular_file = !!S_ISREG(st.st_mode);
     upipe_notice_va(upipe, "opening file %s", path);
-    return UBASE_ERR_NONE;
+    return upipe_fsrc_open_mmap(upipe);
 }
 
 static void upipe_fsrc_close(struct upipe *upipe)
 {
     struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
 
+    upipe_fsrc_close_mmap(upipe);
     if (unlikely(upipe_fsrc->fd != -1)) {
         const char *path;
         if (!ubase_check(upipe_fsrc_get_uri(upipe, &path)))
@@ -501,6 +769,10 @@ static int _upipe_fsrc_get_position(struct upipe *upipe,
     assert(position_p != NULL);
     if (unlikely(upipe_fsrc->fd == -1))
         return UBASE_ERR_UNHANDLED;
+    if (upipe_fsrc->mmap_mgr != NULL || upipe_fsrc->io_pump) {
+        *position_p = upipe_fsrc->position;
+        return UBASE_ERR_NONE;
+    }
     off_t position = lseek(upipe_fsrc->fd, 0, SEEK_CUR);
     if (unlikely(position == (off_t)-1))
         return UBASE_ERR_EXTERNAL;
@@ -519,8 +791,13 @@ static int _upipe_fsrc_set_position(struct upipe *upipe, uint64_t position)
     struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
     if (unlikely(upipe_fsrc->fd == -1))
         return UBASE_ERR_UNHANDLED;
-    return lseek(upipe_fsrc->fd, position, SEEK_SET) != (off_t)-1 ?
-        UBASE_ERR_NONE : UBASE_ERR_EXTERNAL;
+    if (upipe_fsrc->io_pump)
+        /* discard the read in flight, the pump is allocated again later */
+        upipe_fsrc_set_upump_safe(upipe, NULL);
+    if (unlikely(lseek(upipe_fsrc->fd, position, SEEK_SET) == (off_t)-1))
+        return UBASE_ERR_EXTERNAL;
+    upipe_fsrc->position = position;
+    return UBASE_ERR_NONE;
 }
 
 static int _upipe_fsrc_set_length(struct upipe *upipe, uint64_t length)
@@ -562,6 +839,23 @@ static int _upipe_fsrc_set_range(struct upipe *upipe, uint64_t offset,
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This sets whether regular files are mapped in memory.
+ *
+ * @param upipe description structure of the pipe
+ * @param mmap true to map regular files
+ * @return an error code
+ */
+static int _upipe_fsrc_set_mmap(struct upipe *upipe, bool mmap)
+{
+    struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
+    upipe_fsrc->mmap = mmap;
+    if (!mmap) {
+        upipe_fsrc_close_mmap(upipe);
+        return UBASE_ERR_NONE;
+    }
+    return upipe_fsrc_open_mmap(upipe);
+}
+
 static int _upipe_fsrc_get_range(struct upipe *upipe,
                                  uint64_t *offset_p,
                                  uint64_t *length_p)
@@ -646,6 +940,18 @@ static int _upipe_fsrc_control(struct upipe *upipe, int command, va_list args)
             return _upipe_fsrc_get_range(upipe, offset_p, length_p);
         }
 
+        case UPIPE_FSRC_GET_MMAP: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FSRC_SIGNATURE)
+            bool *mmap_p = va_arg(args, bool *);
+            *mmap_p = upipe_fsrc_from_upipe(upipe)->mmap;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_FSRC_SET_MMAP: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FSRC_SIGNATURE)
+            bool mmap = va_arg(args, int);
+            return _upipe_fsrc_set_mmap(upipe, mmap);
+        }
+
         default:
             return UBASE_ERR_NONE;
     }
@@ -29,9 +29,12 @@
 
 #include <stdio.h>
 #include <upipe/ubase.h>
+#include <upipe/uatomic.h>
+#include <upipe/ueventfd.h>
 #include <upipe/ucookie.h>
 #include <upipe/uprobe.h>
 #include <upipe/uclock.h>
+#include <upipe/uclock_std.h>
 #include <upipe/uref.h>
 #include <upipe/uref_block.h>
 #include <upipe/uref_block_flow.h>
@@ -67,6 +70,7 @@
 #include <netdb.h>
 #include <errno.h>
 #include <assert.h>
+#include <pthread.h>
 
 #include "http-parser/http_parser.h"
 
@@ -76,6 +80,17 @@
 #define MAX_URL_SIZE            2048
 #define HTTP_VERSION            "HTTP/1.1"
 #define USER_AGENT              "upipe_http_src"
+/** delay before starting a connection attempt to the next address
+ * (RFC 8305) */
+#define HTTP_CONNECT_ATTEMPT_DELAY  (UCLOCK_FREQ / 4)
+/** default maximum number of idle persistent connections */
+#define HTTP_KEEP_ALIVE_MAX_IDLE    16
+/** default time after which idle persistent connections are closed */
+#define HTTP_KEEP_ALIVE_TIMEOUT     (UCLOCK_FREQ * 5)
+
+#ifndef MSG_NOSIGNAL
+#   define MSG_NOSIGNAL 0
+#endif
 
 struct http_range {
     uint64_t offset;
@@ -93,8 +108,48 @@ struct upipe_http_src_cookie {
 
 UBASE_FROM_TO(upipe_http_src_cookie, uchain, uchain, uchain)
 
+/** @internal @This is a name resolution running in a separate thread. */
+struct upipe_http_src_resolver {
+    /** number of references, held by the pipe and by the thread */
+    uatomic_uint32_t refcount;
+    /** event triggered when the resolution is complete */
+    struct ueventfd event;
+    /** host to resolve */
+    char *host;
+    /** service to resolve */
+    char *service;
+    /** return code of getaddrinfo */
+    int error;
+    /** resolved addresses */
+    struct addrinfo *info;
+};
+
+/** @internal @This is a pending connection attempt. */
+struct upipe_http_src_attempt {
+    /** attach to the list of connection attempts */
+    struct uchain uchain;
+    /** pointer to the pipe */
+    struct upipe *upipe;
+    /** socket descriptor */
+    int fd;
+    /** write watcher triggering when the connection is established */
+    struct upump *upump;
+};
+
+UBASE_FROM_TO(upipe_http_src_attempt, uchain, uchain, uchain)
+
 /** @hidden */
 static int upipe_http_src_check(struct upipe *upipe, struct uref *flow_format);
+/** @hidden */
+static int upipe_http_src_mgr_borrow_conn(struct upipe_mgr *mgr,
+                                          const char *key);
+/** @hidden */
+static void upipe_http_src_mgr_park_conn(struct upipe_mgr *mgr,
+                                         const char *key, int fd);
+/** @hidden */
+static bool upipe_http_src_mgr_keep_alive(struct upipe_mgr *mgr);
+/** @hidden */
+static int upipe_http_src_reopen(struct upipe *upipe);
 
 struct header {
     const char *value;
@@ -143,9 +198,34 @@ struct upipe_http_src {
     unsigned int output_size;
     /** write watcher */
     struct upump *upump_write;
+    /** name resolution watcher */
+    struct upump *upump_resolve;
+    /** timer starting the next connection attempt */
+    struct upump *upump_attempt;
+    /** connection timeout watcher */
+    struct upump *upump_timeout;
+
+    /** connection timeout, or 0 */
+    uint64_t connect_timeout;
+    /** pending name resolution */
+    struct upipe_http_src_resolver *resolver;
+    /** resolved addresses */
+    struct addrinfo *addrinfo;
+    /** resolved addresses, in the order of connection attempts */
+    struct addrinfo **addrs;
+    /** number of resolved addresses */
+    unsigned int nb_addrs;
+    /** index of the next address to connect to */
+    unsigned int next_addr;
+    /** list of pending connection attempts */
+    struct uchain attempts;
 
     /** socket descriptor */
     int fd;
+    /** host and port of the connection, identifying persistent connections */
+    char *conn_key;
+    /** true if the connection was reused and nothing was received yet */
+    bool reused;
     /** a request is pending */
     bool request_pending;
     /** http url */
@@ -193,6 +273,9 @@ UPIPE_HELPER_UPUMP_MGR(upipe_http_src, upump_mgr)
 UPIPE_HELPER_UPUMP(upipe_http_src, upump, upump_mgr)
 UPIPE_HELPER_OUTPUT_SIZE(upipe_http_src, output_size)
 UPIPE_HELPER_UPUMP(upipe_http_src, upump_write, upump_mgr)
+UPIPE_HELPER_UPUMP(upipe_http_src, upump_resolve, upump_mgr)
+UPIPE_HELPER_UPUMP(upipe_http_src, upump_attempt, upump_mgr)
+UPIPE_HELPER_UPUMP(upipe_http_src, upump_timeout, upump_mgr)
 
 static int upipe_http_src_header_field(http_parser *parser,
                                        const char *at,
@@ -227,11 +310,23 @@ static struct upipe *upipe_http_src_alloc(struct upipe_mgr *mgr,
     upipe_http_src_init_upump_mgr(upipe);
     upipe_http_src_init_upump(upipe);
     upipe_http_src_init_upump_write(upipe);
+    upipe_http_src_init_upump_resolve(upipe);
+    upipe_http_src_init_upump_attempt(upipe);
+    upipe_http_src_init_upump_timeout(upipe);
     upipe_http_src_init_uclock(upipe);
     upipe_http_src_init_output_size(upipe, UBUF_DEFAULT_SIZE);
 
     struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+    upipe_http_src->connect_timeout = 0;
+    upipe_http_src->resolver = NULL;
+    upipe_http_src->addrinfo = NULL;
+    upipe_http_src->addrs = NULL;
+    upipe_http_src->nb_addrs = 0;
+    upipe_http_src->next_addr = 0;
+    ulist_init(&upipe_http_src->attempts);
     upipe_http_src->fd = -1;
+    upipe_http_src->conn_key = NULL;
+    upipe_http_src->reused = false;
     upipe_http_src->request_pending = false;
     upipe_http_src->url = NULL;
     upipe_http_src->range = HTTP_RANGE(0, -1);
@@ -265,6 +360,151 @@ static struct upipe *upipe_http_src_alloc(struct upipe_mgr *mgr,
     return upipe;
 }
 
+/** @internal @This releases a name resolution.
+ *
+ * @param resolver description structure of the name resolution
+ */
+static void upipe_http_src_resolver_release(
+        struct upipe_http_src_resolver *resolver)
+{
+    if (uatomic_fetch_sub(&resolver->refcount, 1) != 1)
+        return;
+
+    if (resolver->info != NULL)
+        freeaddrinfo(resolver->info);
+    ueventfd_clean(&resolver->event);
+    uatomic_clean(&resolver->refcount);
+    free(resolver);
+}
+
+/** @internal @This resolves the host name in a separate thread, so that
+ * a slow name server does not stall the event loop.
+ *
+ * @param arg description structure of the name resolution
+ * @return NULL
+ */
+static void *upipe_http_src_resolver_thread(void *arg)
+{
+    struct upipe_http_src_resolver *resolver = arg;
+    struct addrinfo hints;
+
+    memset(&hints, 0, sizeof(struct addrinfo));
+    hints.ai_family = PF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = 0;
+
+    resolver->error = getaddrinfo(resolver->host, resolver->service, &hints,
+                                  &resolver->info);
+    ueventfd_write(&resolver->event);
+    upipe_http_src_resolver_release(resolver);
+    return NULL;
+}
+
+/** @internal @This starts the resolution of a host name.
+ *
+ * @param upipe description structure of the pipe
+ * @param host host to resolve
+ * @param service service or port to resolve
+ * @return an error code
+ */
+static int upipe_http_src_resolve(struct upipe *upipe,
+                                  const char *host, const char *service)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+    size_t host_len = strlen(host) + 1;
+    size_t service_len = strlen(service) + 1;
+
+    struct upipe_http_src_resolver *resolver =
+        malloc(sizeof (*resolver) + host_len + service_len);
+    if (unlikely(resolver == NULL))
+        return UBASE_ERR_ALLOC;
+    if (unlikely(!ueventfd_init(&resolver->event, false))) {
+        free(resolver);
+        return UBASE_ERR_EXTERNAL;
+    }
+    uatomic_init(&resolver->refcount, 2);
+    resolver->host = (char *)(resolver + 1);
+    memcpy(resolver->host, host, host_len);
+    resolver->service = resolver->host + host_len;
+    memcpy(resolver->service, service, service_len);
+    resolver->error = 0;
+    resolver->info = NULL;
+
+    pthread_attr_t attr;
+    pthread_t thread;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int err = pthread_create(&thread, &attr, upipe_http_src_resolver_thread,
+                             resolver);
+    pthread_attr_destroy(&attr);
+    if (unlikely(err)) {
+        upipe_err_va(upipe, "unable to start resolver (%s)", strerror(err));
+        ueventfd_clean(&resolver->event);
+        uatomic_clean(&resolver->refcount);
+        free(resolver);
+        return UBASE_ERR_EXTERNAL;
+    }
+
+    upipe_http_src->resolver = resolver;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This frees a connection attempt.
+ *
+ * @param attempt description structure of the connection attempt
+ */
+static void upipe_http_src_attempt_free(struct upipe_http_src_attempt *attempt)
+{
+    ulist_delete(upipe_http_src_attempt_to_uchain(attempt));
+    if (attempt->upump != NULL) {
+        upump_stop(attempt->upump);
+        upump_free(attempt->upump);
+    }
+    ubase_clean_fd(&attempt->fd);
+    free(attempt);
+}
+
+/** @internal @This stops the pending connection attempts and the watchers of
+ * the connection setup, which are restarted from the first address by
+ * @ref upipe_http_src_check.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_http_src_suspend_connect(struct upipe *upipe)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+    struct uchain *uchain, *uchain_tmp;
+
+    ulist_delete_foreach(&upipe_http_src->attempts, uchain, uchain_tmp)
+        upipe_http_src_attempt_free(upipe_http_src_attempt_from_uchain(uchain));
+    upipe_http_src_set_upump_resolve(upipe, NULL);
+    upipe_http_src_set_upump_attempt(upipe, NULL);
+    upipe_http_src_set_upump_timeout(upipe, NULL);
+    upipe_http_src->next_addr = 0;
+}
+
+/** @internal @This aborts the connection setup.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_http_src_clean_connect(struct upipe *upipe)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+
+    upipe_http_src_suspend_connect(upipe);
+    if (upipe_http_src->resolver != NULL) {
+        upipe_http_src_resolver_release(upipe_http_src->resolver);
+        upipe_http_src->resolver = NULL;
+    }
+    free(upipe_http_src->addrs);
+    upipe_http_src->addrs = NULL;
+    upipe_http_src->nb_addrs = 0;
+    if (upipe_http_src->addrinfo != NULL) {
+        freeaddrinfo(upipe_http_src->addrinfo);
+        upipe_http_src->addrinfo = NULL;
+    }
+}
+
 /** @This closes a connection.
  *
  * @param upipe description structure of the pipe
@@ -276,7 +516,10 @@ static void upipe_http_src_close(struct upipe *upipe)
 
     if (likely(upipe_http_src->url != NULL))
         upipe_notice_va(upipe, "closing %s", upipe_http_src->url);
+    upipe_http_src_clean_connect(upipe);
     ubase_clean_fd(&upipe_http_src->fd);
+    ubase_clean_str(&upipe_http_src->conn_key);
+    upipe_http_src->reused = false;
     ubase_clean_str(&upipe_http_src->url);
     upipe_http_src_set_upump(upipe, NULL);
     upipe_http_src->request_pending = false;
@@ -302,6 +545,9 @@ static void upipe_http_src_free(struct upipe *upipe)
     free(upipe_http_src->location);
     upipe_http_src_clean_output_size(upipe);
     upipe_http_src_clean_uclock(upipe);
+    upipe_http_src_clean_upump_timeout(upipe);
+    upipe_http_src_clean_upump_attempt(upipe);
+    upipe_http_src_clean_upump_resolve(upipe);
     upipe_http_src_clean_upump_write(upipe);
     upipe_http_src_clean_upump(upipe);
     upipe_http_src_clean_upump_mgr(upipe);
@@ -455,6 +701,16 @@ static int upipe_http_src_message_complete(http_parser *parser)
         upipe_http_src_output_data(upipe, NULL, 0);
         break;
     }
+
+    if (http_should_keep_alive(parser) && upipe_http_src->fd != -1 &&
+        upipe_http_src->conn_key != NULL) {
+        upipe_verbose_va(upipe, "keeping connection to %s",
+                         upipe_http_src->conn_key);
+        upipe_http_src_set_upump(upipe, NULL);
+        upipe_http_src_mgr_park_conn(upipe->mgr, upipe_http_src->conn_key,
+                                     upipe_http_src->fd);
+        upipe_http_src->fd = -1;
+    }
     upipe_http_src_close(upipe);
     upipe_throw_source_end(upipe);
 
@@ -579,17 +835,24 @@ static void upipe_http_src_worker(struct upump *upump)
             default:
                 break;
         }
+        if (upipe_http_src->reused &&
+            ubase_check(upipe_http_src_reopen(upipe)))
+            return;
         upipe_err_va(upipe, "read error from %s (%s)", upipe_http_src->url,
                      strerror(errno));
         upipe_http_src_set_upump(upipe, NULL);
         upipe_throw_source_end(upipe);
     }
     else if (unlikely(len == 0)) {
-        upipe_verbose(upipe, "connection closed");
         uref_free(uref);
+        if (upipe_http_src->reused &&
+            ubase_check(upipe_http_src_reopen(upipe)))
+            return;
+        upipe_verbose(upipe, "connection closed");
         upipe_throw_source_end(upipe);
     }
     else {
+        upipe_http_src->reused = false;
         if (unlikely(len != upipe_http_src->output_size))
             uref_block_resize(uref, 0, len);
         upipe_http_src_process(upipe, uref, &upump);
@@ -720,6 +983,12 @@ static int upipe_http_src_send_request(struct upipe *upipe)
     if (!first)
         request_add(&req, &req_len, "\r\n");
 
+    /* Connection */
+    if (!upipe_http_src_mgr_keep_alive(upipe->mgr)) {
+        upipe_verbose(upipe, "Connection: close");
+        request_add(&req, &req_len, "Connection: close\r\n");
+    }
+
     /* End of request */
     request_add(&req, &req_len, "\r\n");
 
@@ -729,7 +998,7 @@ static int upipe_http_src_send_request(struct upipe *upipe)
     }
 
     ret = send(upipe_http_src->fd, req_buffer,
-               sizeof (req_buffer) - req_len, 0);
+               sizeof (req_buffer) - req_len, MSG_NOSIGNAL);
     if (ret < 0) {
         switch(errno) {
             case EINTR:
@@ -758,6 +1027,9 @@ static void upipe_http_src_worker_write(struct upump *upump)
     struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
 
     if (unlikely(!ubase_check(upipe_http_src_send_request(upipe)))) {
+        if (upipe_http_src->reused &&
+            ubase_check(upipe_http_src_reopen(upipe)))
+            return;
         upipe_err(upipe, "fail to send request");
     }
     else {
@@ -766,6 +1038,214 @@ static void upipe_http_src_worker_write(struct upump *upump)
     }
 }
 
+/** @internal @This is called when a connection is established.
+ *
+ * @param upipe description structure of the pipe
+ * @param fd connected socket descriptor
+ */
+static void upipe_http_src_connected(struct upipe *upipe, int fd)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+
+    upipe_dbg_va(upipe, "connected to %s", upipe_http_src->url);
+    upipe_http_src_clean_connect(upipe);
+    upipe_http_src->fd = fd;
+    upipe_http_src_check(upipe, NULL);
+}
+
+/** @hidden */
+static void upipe_http_src_connect_next(struct upipe *upipe);
+
+/** @internal @This is called when a connection attempt completes.
+ *
+ * @param upump description structure of the write watcher
+ */
+static void upipe_http_src_worker_connect(struct upump *upump)
+{
+    struct upipe_http_src_attempt *attempt =
+        upump_get_opaque(upump, struct upipe_http_src_attempt *);
+    struct upipe *upipe = attempt->upipe;
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+
+    int error = 0;
+    socklen_t len = sizeof (error);
+    if (unlikely(getsockopt(attempt->fd, SOL_SOCKET, SO_ERROR,
+                            &error, &len) < 0))
+        error = errno;
+
+    if (likely(error == 0)) {
+        int fd = attempt->fd;
+        attempt->fd = -1;
+        upipe_http_src_connected(upipe, fd);
+        return;
+    }
+
+    upipe_dbg_va(upipe, "connection attempt failed (%s)", strerror(error));
+    upipe_http_src_attempt_free(attempt);
+    /* do not wait for the attempt delay to try the next address */
+    if (upipe_http_src->next_addr < upipe_http_src->nb_addrs ||
+        ulist_empty(&upipe_http_src->attempts))
+        upipe_http_src_connect_next(upipe);
+}
+
+/** @internal @This is called when the previous connection attempts did not
+ * complete in time.
+ *
+ * @param upump description structure of the timer
+ */
+static void upipe_http_src_worker_attempt(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    upipe_http_src_connect_next(upipe);
+}
+
+/** @internal @This starts a non-blocking connection to the next resolved
+ * address. If it is not established after @ref HTTP_CONNECT_ATTEMPT_DELAY,
+ * an attempt to the following address is started in parallel (happy
+ * eyeballs, RFC 8305); if it fails, the following address is tried at
+ * once.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_http_src_connect_next(struct upipe *upipe)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+
+    upipe_http_src_set_upump_attempt(upipe, NULL);
+    while (upipe_http_src->next_addr < upipe_http_src->nb_addrs) {
+        struct addrinfo *res =
+            upipe_http_src->addrs[upipe_http_src->next_addr++];
+        int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+        if (unlikely(fd < 0))
+            continue;
+
+        int flags = fcntl(fd, F_GETFL);
+        if (unlikely(flags < 0 ||
+                     fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0)) {
+            ubase_clean_fd(&fd);
+            continue;
+        }
+
+        if (connect(fd, res->ai_addr, res->ai_addrlen) == 0) {
+            upipe_http_src_connected(upipe, fd);
+            return;
+        }
+        if (errno != EINPROGRESS) {
+            upipe_dbg_va(upipe, "connection attempt failed (%s)",
+                         strerror(errno));
+            ubase_clean_fd(&fd);
+            continue;
+        }
+
+        struct upipe_http_src_attempt *attempt = malloc(sizeof (*attempt));
+        if (unlikely(attempt == NULL)) {
+            ubase_clean_fd(&fd);
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
+        uchain_init(upipe_http_src_attempt_to_uchain(attempt));
+        attempt->upipe = upipe;
+        attempt->fd = fd;
+        attempt->upump = upump_alloc_fd_write(upipe_http_src->upump_mgr,
+                                              upipe_http_src_worker_connect,
+                                              attempt, upipe->refcount, fd);
+        if (unlikely(attempt->upump == NULL)) {
+            ubase_clean_fd(&attempt->fd);
+            free(attempt);
+            upipe_throw_fatal(upipe, UBASE_ERR_UPUMP);
+            return;
+        }
+        ulist_add(&upipe_http_src->attempts,
+                  upipe_http_src_attempt_to_uchain(attempt));
+        upump_start(attempt->upump);
+
+        if (upipe_http_src->next_addr < upipe_http_src->nb_addrs)
+            upipe_http_src_wait_upump_attempt(upipe,
+                                              HTTP_CONNECT_ATTEMPT_DELAY,
+                                              upipe_http_src_worker_attempt);
+        return;
+    }
+
+    if (ulist_empty(&upipe_http_src->attempts)) {
+        upipe_err(upipe, "could not connect to any ressource");
+        upipe_http_src_close(upipe);
+        upipe_throw_source_end(upipe);
+    }
+}
+
+/** @internal @This is called when the name resolution is complete.
+ *
+ * @param upump description structure of the watcher
+ */
+static void upipe_http_src_worker_resolve(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+    struct upipe_http_src_resolver *resolver = upipe_http_src->resolver;
+
+    upipe_http_src_set_upump_resolve(upipe, NULL);
+    upipe_http_src->resolver = NULL;
+    int error = resolver->error;
+    struct addrinfo *info = resolver->info;
+    resolver->info = NULL;
+    upipe_http_src_resolver_release(resolver);
+
+    if (unlikely(error)) {
+        upipe_err_va(upipe, "getaddrinfo: %s", gai_strerror(error));
+        upipe_http_src_close(upipe);
+        upipe_throw_source_end(upipe);
+        return;
+    }
+
+    unsigned int nb_addrs = 0;
+    for (struct addrinfo *res = info; res != NULL; res = res->ai_next)
+        nb_addrs++;
+    struct addrinfo **addrs = malloc(sizeof (*addrs) * (nb_addrs + 1));
+    if (unlikely(addrs == NULL)) {
+        freeaddrinfo(info);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
+
+    /* alternate address families, starting with the preferred one */
+    struct addrinfo *first = info, *other = info;
+    unsigned int i = 0;
+    while (i < nb_addrs) {
+        while (first != NULL && first->ai_family != info->ai_family)
+            first = first->ai_next;
+        if (first != NULL) {
+            addrs[i++] = first;
+            first = first->ai_next;
+        }
+        while (other != NULL && other->ai_family == info->ai_family)
+            other = other->ai_next;
+        if (other != NULL) {
+            addrs[i++] = other;
+            other = other->ai_next;
+        }
+    }
+
+    upipe_http_src->addrinfo = info;
+    upipe_http_src->addrs = addrs;
+    upipe_http_src->nb_addrs = nb_addrs;
+    upipe_http_src->next_addr = 0;
+    upipe_http_src_check(upipe, NULL);
+}
+
+/** @internal @This is called when the connection setup times out.
+ *
+ * @param upump description structure of the timer
+ */
+static void upipe_http_src_worker_timeout(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+
+    upipe_err_va(upipe, "connection to %s timed out", upipe_http_src->url);
+    upipe_http_src_close(upipe);
+    upipe_throw_source_end(upipe);
+}
+
 /** @internal @This checks if the pump may be allocated.
  *
  * @param upipe description structure of the pipe
@@ -790,6 +1270,34 @@ static int upipe_http_src_check(struct upipe *upipe, struct uref *flow_format)
     if (upipe_http_src->upump_mgr == NULL)
         return UBASE_ERR_NONE;
 
+    if (upipe_http_src->resolver != NULL &&
+        upipe_http_src->upump_resolve == NULL) {
+        struct upump *upump =
+            ueventfd_upump_alloc(&upipe_http_src->resolver->event,
+                                 upipe_http_src->upump_mgr,
+                                 upipe_http_src_worker_resolve, upipe,
+                                 upipe->refcount);
+        if (unlikely(upump == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_UPUMP);
+            return UBASE_ERR_UPUMP;
+        }
+        upipe_http_src_set_upump_resolve(upipe, upump);
+        upump_start(upump);
+    }
+
+    if ((upipe_http_src->resolver != NULL ||
+         upipe_http_src->addrs != NULL) &&
+        upipe_http_src->connect_timeout &&
+        upipe_http_src->upump_timeout == NULL)
+        upipe_http_src_wait_upump_timeout(upipe,
+                                          upipe_http_src->connect_timeout,
+                                          upipe_http_src_worker_timeout);
+
+    if (upipe_http_src->addrs != NULL &&
+        ulist_empty(&upipe_http_src->attempts) &&
+        upipe_http_src->upump_attempt == NULL)
+        upipe_http_src_connect_next(upipe);
+
     if (upipe_http_src->uref_mgr == NULL) {
         upipe_http_src_require_uref_mgr(upipe);
         return UBASE_ERR_NONE;
@@ -857,7 +1365,41 @@ static int upipe_http_src_get_uri(struct upipe *upipe, const char **url_p)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This connects to the given host, reusing an idle persistent
+ * connection of the manager if possible.
+ *
+ * @param upipe description structure of the pipe
+ * @param host host to connect to
+ * @param service service or port to connect to
+ * @return an error code
+ */
+static int upipe_http_src_connect(struct upipe *upipe,
+                                  const char *host, const char *service)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+
+    free(upipe_http_src->conn_key);
+    upipe_http_src->conn_key = malloc(strlen(host) + strlen(service) + 2);
+    if (unlikely(upipe_http_src->conn_key == NULL))
+        return UBASE_ERR_ALLOC;
+    sprintf(upipe_http_src->conn_key, "%s:%s", host, service);
+
+    int fd = upipe_http_src_mgr_borrow_conn(upipe->mgr,
+                                            upipe_http_src->conn_key);
+    if (fd != -1) {
+        upipe_verbose_va(upipe, "reusing connection to %s",
+                         upipe_http_src->conn_key);
+        upipe_http_src->fd = fd;
+        upipe_http_src->reused = true;
+        return UBASE_ERR_NONE;
+    }
+
+    upipe_verbose_va(upipe, "getaddrinfo to %s", upipe_http_src->conn_key);
+    return upipe_http_src_resolve(upipe, host, service);
+}
+
 /** @internal @This asks to open the given http (real code here).
+ * The connection is established asynchronously.
  *
  * @param upipe description structure of the pipe
  * @param url relative or absolute url of the http
@@ -867,9 +1409,7 @@ static int upipe_http_src_open_url(struct upipe *upipe)
 {
     struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
     struct uref *flow_def = upipe_http_src->flow_def;
-    struct addrinfo *info = NULL, *res;
-    struct addrinfo hints;
-    int ret, fd = -1;
+    int ret;
 
     if (unlikely(flow_def == NULL))
         return UBASE_ERR_INVALID;
@@ -877,12 +1417,6 @@ static int upipe_http_src_open_url(struct upipe *upipe)
     /* init parser */
     http_parser_init(&upipe_http_src->parser, HTTP_RESPONSE);
 
-    /* get socket information */
-    memset(&hints, 0, sizeof(struct addrinfo));
-    hints.ai_family = PF_UNSPEC;
-    hints.ai_socktype = SOCK_STREAM;
-    hints.ai_protocol = 0;
-
     if (upipe_http_src->proxy) {
         struct uuri uuri;
         ret = uuri_from_str(&uuri, upipe_http_src->proxy);
@@ -896,47 +1430,38 @@ static int upipe_http_src_open_url(struct upipe *upipe)
         char service[uuri.authority.port.len + 1];
         ustring_cpy(uuri.authority.port, service, sizeof (service));
 
-        upipe_verbose_va(upipe, "getaddrinfo to %s%s%s",
-                         host, strlen(service) ? ":" : "",
-                         service);
-        ret = getaddrinfo(host, service, &hints, &info);
+        return upipe_http_src_connect(upipe, host, service);
     }
-    else {
-        const char *host;
-        UBASE_RETURN(uref_uri_get_host(flow_def, &host));
 
-        const char *service;
-        if (!ubase_check(uref_uri_get_port(flow_def, &service)))
-            UBASE_RETURN(uref_uri_get_scheme(flow_def, &service));
+    const char *host;
+    UBASE_RETURN(uref_uri_get_host(flow_def, &host));
 
-        upipe_verbose_va(upipe, "getaddrinfo to %s", host);
-        ret = getaddrinfo(host, service, &hints, &info);
-    }
+    const char *service;
+    if (!ubase_check(uref_uri_get_port(flow_def, &service)))
+        UBASE_RETURN(uref_uri_get_scheme(flow_def, &service));
 
-    if (unlikely(ret)) {
-        upipe_err_va(upipe, "getaddrinfo: %s", gai_strerror(ret));
-        return UBASE_ERR_EXTERNAL;
-    }
-
-    /* connect to first working ressource */
-    for (res = info; res; res = res->ai_next) {
-        fd = socket(res->ai_family, res->ai_socktype,
-                                          res->ai_protocol);
-        if (likely(fd >= 0)) {
-            if (connect(fd, res->ai_addr, res->ai_addrlen) == 0)
-                break;
-            ubase_clean_fd(&fd);
-        }
-    }
-    freeaddrinfo(info);
+    return upipe_http_src_connect(upipe, host, service);
+}
 
-    if (fd < 0) {
-        upipe_err(upipe, "could not connect to any ressource");
-        return UBASE_ERR_EXTERNAL;
-    }
+/** @internal @This reopens the connection, when a persistent connection
+ * was closed by the server before it answered the request.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_http_src_reopen(struct upipe *upipe)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
 
-    upipe_http_src->fd = fd;
-    return UBASE_ERR_NONE;
+    upipe_dbg_va(upipe, "persistent connection to %s was closed, reopening",
+                 upipe_http_src->conn_key);
+    upipe_http_src_set_upump(upipe, NULL);
+    upipe_http_src_set_upump_write(upipe, NULL);
+    ubase_clean_fd(&upipe_http_src->fd);
+    upipe_http_src->reused = false;
+    upipe_http_src->request_pending = true;
+    UBASE_RETURN(upipe_http_src_open_url(upipe));
+    return upipe_http_src_check(upipe, NULL);
 }
 
 /** @internal @This asks to open the given http.
@@ -1018,6 +1543,24 @@ static int _upipe_http_src_set_range(struct upipe *upipe,
     return UBASE_ERR_NONE;
 }
 
+static int _upipe_http_src_get_connect_timeout(struct upipe *upipe,
+                                               uint64_t *timeout_p)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+
+    if (timeout_p)
+        *timeout_p = upipe_http_src->connect_timeout;
+    return UBASE_ERR_NONE;
+}
+
+static int _upipe_http_src_set_connect_timeout(struct upipe *upipe,
+                                               uint64_t timeout)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+    upipe_http_src->connect_timeout = timeout;
+    return UBASE_ERR_NONE;
+}
+
 static int _upipe_http_src_set_proxy(struct upipe *upipe, const char *proxy)
 {
     struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
@@ -1048,6 +1591,7 @@ static int _upipe_http_src_control(struct upipe *upipe,
     switch (command) {
         case UPIPE_ATTACH_UPUMP_MGR:
             upipe_http_src_set_upump(upipe, NULL);
+            upipe_http_src_suspend_connect(upipe);
             return upipe_http_src_attach_upump_mgr(upipe);
         case UPIPE_ATTACH_UCLOCK:
             upipe_http_src_set_upump(upipe, NULL);
@@ -1106,6 +1650,17 @@ static int _upipe_http_src_control(struct upipe *upipe,
             return _upipe_http_src_set_proxy(upipe, proxy);
         }
 
+        case UPIPE_HTTP_SRC_GET_CONNECT_TIMEOUT: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_HTTP_SRC_SIGNATURE)
+            uint64_t *timeout_p = va_arg(args, uint64_t *);
+            return _upipe_http_src_get_connect_timeout(upipe, timeout_p);
+        }
+        case UPIPE_HTTP_SRC_SET_CONNECT_TIMEOUT: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_HTTP_SRC_SIGNATURE)
+            uint64_t timeout = va_arg(args, uint64_t);
+            return _upipe_http_src_set_connect_timeout(upipe, timeout);
+        }
+
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -1136,11 +1691,156 @@ struct upipe_http_src_mgr {
     struct uchain cookies;
     /** proxy url */
     char *proxy;
+
+    /** list of idle persistent connections, oldest first */
+    struct uchain idle_conns;
+    /** number of idle persistent connections */
+    unsigned int nb_idle;
+    /** maximum number of idle persistent connections */
+    unsigned int max_idle;
+    /** time after which idle persistent connections are closed */
+    uint64_t idle_timeout;
+    /** clock used to expire idle persistent connections */
+    struct uclock *uclock;
 };
 
 UBASE_FROM_TO(upipe_http_src_mgr, upipe_mgr, upipe_mgr, upipe_mgr)
 UBASE_FROM_TO(upipe_http_src_mgr, urefcount, urefcount, urefcount);
 
+/** @internal @This is an idle persistent connection. */
+struct upipe_http_src_conn {
+    /** attach to the list of idle connections */
+    struct uchain uchain;
+    /** socket descriptor */
+    int fd;
+    /** date at which the connection became idle */
+    uint64_t date;
+    /** host and port of the connection */
+    char key[];
+};
+
+UBASE_FROM_TO(upipe_http_src_conn, uchain, uchain, uchain)
+
+/** @internal @This closes an idle persistent connection.
+ *
+ * @param upipe_http_src_mgr private structure of the manager
+ * @param conn idle connection
+ */
+static void upipe_http_src_mgr_close_conn(
+        struct upipe_http_src_mgr *upipe_http_src_mgr,
+        struct upipe_http_src_conn *conn)
+{
+    ulist_delete(upipe_http_src_conn_to_uchain(conn));
+    upipe_http_src_mgr->nb_idle--;
+    ubase_clean_fd(&conn->fd);
+    free(conn);
+}
+
+/** @internal @This closes the idle persistent connections which expired,
+ * and the oldest ones in excess of the given number.
+ *
+ * @param upipe_http_src_mgr private structure of the manager
+ * @param max_idle maximum number of idle connections to keep
+ */
+static void upipe_http_src_mgr_expire(
+        struct upipe_http_src_mgr *upipe_http_src_mgr,
+        unsigned int max_idle)
+{
+    uint64_t now = uclock_now(upipe_http_src_mgr->uclock);
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach(&upipe_http_src_mgr->idle_conns, uchain, uchain_tmp) {
+        struct upipe_http_src_conn *conn =
+            upipe_http_src_conn_from_uchain(uchain);
+        if (upipe_http_src_mgr->nb_idle <= max_idle &&
+            conn->date + upipe_http_src_mgr->idle_timeout > now)
+            break;
+        upipe_http_src_mgr_close_conn(upipe_http_src_mgr, conn);
+    }
+}
+
+/** @internal @This returns true if persistent connections are kept.
+ *
+ * @param mgr pointer to upipe manager
+ * @return true if persistent connections are kept
+ */
+static bool upipe_http_src_mgr_keep_alive(struct upipe_mgr *mgr)
+{
+    struct upipe_http_src_mgr *upipe_http_src_mgr =
+        upipe_http_src_mgr_from_upipe_mgr(mgr);
+    return upipe_http_src_mgr->max_idle != 0;
+}
+
+/** @internal @This takes an idle persistent connection to the given host.
+ *
+ * @param mgr pointer to upipe manager
+ * @param key host and port of the connection
+ * @return a connected socket descriptor, or -1
+ */
+static int upipe_http_src_mgr_borrow_conn(struct upipe_mgr *mgr,
+                                          const char *key)
+{
+    struct upipe_http_src_mgr *upipe_http_src_mgr =
+        upipe_http_src_mgr_from_upipe_mgr(mgr);
+
+    upipe_http_src_mgr_expire(upipe_http_src_mgr,
+                              upipe_http_src_mgr->max_idle);
+
+    /* most recently used first */
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach_reverse(&upipe_http_src_mgr->idle_conns,
+                                 uchain, uchain_tmp) {
+        struct upipe_http_src_conn *conn =
+            upipe_http_src_conn_from_uchain(uchain);
+        if (strcmp(conn->key, key))
+            continue;
+
+        /* the server may have closed it in the meantime */
+        char c;
+        ssize_t ret = recv(conn->fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+        if (ret == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            int fd = conn->fd;
+            conn->fd = -1;
+            upipe_http_src_mgr_close_conn(upipe_http_src_mgr, conn);
+            return fd;
+        }
+        upipe_http_src_mgr_close_conn(upipe_http_src_mgr, conn);
+    }
+    return -1;
+}
+
+/** @internal @This keeps a persistent connection for later requests.
+ *
+ * @param mgr pointer to upipe manager
+ * @param key host and port of the connection
+ * @param fd connected socket descriptor
+ */
+static void upipe_http_src_mgr_park_conn(struct upipe_mgr *mgr,
+                                         const char *key, int fd)
+{
+    struct upipe_http_src_mgr *upipe_http_src_mgr =
+        upipe_http_src_mgr_from_upipe_mgr(mgr);
+
+    if (unlikely(!upipe_http_src_mgr->max_idle)) {
+        close(fd);
+        return;
+    }
+    upipe_http_src_mgr_expire(upipe_http_src_mgr,
+                              upipe_http_src_mgr->max_idle - 1);
+
+    struct upipe_http_src_conn *conn =
+        malloc(sizeof (*conn) + strlen(key) + 1);
+    if (unlikely(conn == NULL)) {
+        close(fd);
+        return;
+    }
+    conn->fd = fd;
+    conn->date = uclock_now(upipe_http_src_mgr->uclock);
+    strcpy(conn->key, key);
+    ulist_add(&upipe_http_src_mgr->idle_conns,
+              upipe_http_src_conn_to_uchain(conn));
+    upipe_http_src_mgr->nb_idle++;
+}
+
 static int _upipe_http_src_mgr_set_cookie(struct upipe_mgr *upipe_mgr,
                                           const char *cookie_string)
 {
@@ -1248,6 +1948,31 @@ static int _upipe_http_src_mgr_set_proxy(struct upipe_mgr *mgr,
     return UBASE_ERR_NONE;
 }
 
+static int _upipe_http_src_mgr_get_keep_alive(struct upipe_mgr *mgr,
+                                              unsigned int *max_idle_p,
+                                              uint64_t *idle_timeout_p)
+{
+    struct upipe_http_src_mgr *upipe_http_src_mgr =
+        upipe_http_src_mgr_from_upipe_mgr(mgr);
+    if (max_idle_p)
+        *max_idle_p = upipe_http_src_mgr->max_idle;
+    if (idle_timeout_p)
+        *idle_timeout_p = upipe_http_src_mgr->idle_timeout;
+    return UBASE_ERR_NONE;
+}
+
+static int _upipe_http_src_mgr_set_keep_alive(struct upipe_mgr *mgr,
+                                              unsigned int max_idle,
+                                              uint64_t idle_timeout)
+{
+    struct upipe_http_src_mgr *upipe_http_src_mgr =
+        upipe_http_src_mgr_from_upipe_mgr(mgr);
+    upipe_http_src_mgr->max_idle = max_idle;
+    upipe_http_src_mgr->idle_timeout = idle_timeout;
+    upipe_http_src_mgr_expire(upipe_http_src_mgr, max_idle);
+    return UBASE_ERR_NONE;
+}
+
 static int upipe_http_src_mgr_control(struct upipe_mgr *upipe_mgr,
                                       int command, va_list args)
 {
@@ -1276,6 +2001,21 @@ static int upipe_http_src_mgr_control(struct upipe_mgr *upipe_mgr,
         const char *proxy = va_arg(args, const char *);
         return _upipe_http_src_mgr_set_proxy(upipe_mgr, proxy);
     }
+
+    case UPIPE_HTTP_SRC_MGR_GET_KEEP_ALIVE: {
+        UBASE_SIGNATURE_CHECK(args, UPIPE_HTTP_SRC_SIGNATURE)
+        unsigned int *max_idle_p = va_arg(args, unsigned int *);
+        uint64_t *idle_timeout_p = va_arg(args, uint64_t *);
+        return _upipe_http_src_mgr_get_keep_alive(upipe_mgr, max_idle_p,
+                                                  idle_timeout_p);
+    }
+    case UPIPE_HTTP_SRC_MGR_SET_KEEP_ALIVE: {
+        UBASE_SIGNATURE_CHECK(args, UPIPE_HTTP_SRC_SIGNATURE)
+        unsigned int max_idle = va_arg(args, unsigned int);
+        uint64_t idle_timeout = va_arg(args, uint64_t);
+        return _upipe_http_src_mgr_set_keep_alive(upipe_mgr, max_idle,
+                                                  idle_timeout);
+    }
     }
     return UBASE_ERR_UNHANDLED;
 }
@@ -1293,6 +2033,8 @@ static void upipe_http_src_mgr_free(struct urefcount *urefcount)
         free(cookie->value);
         free(cookie);
     }
+    upipe_http_src_mgr_expire(upipe_http_src_mgr, 0);
+    uclock_release(upipe_http_src_mgr->uclock);
     free(upipe_http_src_mgr->proxy);
     urefcount_clean(urefcount);
     free(upipe_http_src_mgr);
@@ -1308,6 +2050,11 @@ struct upipe_mgr *upipe_http_src_mgr_alloc(void)
         malloc(sizeof (*upipe_http_src_mgr));
     if (unlikely(upipe_http_src_mgr == NULL))
         return NULL;
+    upipe_http_src_mgr->uclock = uclock_std_alloc(0);
+    if (unlikely(upipe_http_src_mgr->uclock == NULL)) {
+        free(upipe_http_src_mgr);
+        return NULL;
+    }
     struct upipe_mgr *upipe_mgr =
         upipe_http_src_mgr_to_upipe_mgr(upipe_http_src_mgr);
 
@@ -1326,6 +2073,10 @@ struct upipe_mgr *upipe_http_src_mgr_alloc(void)
     upipe_mgr->refcount = urefcount;
     ulist_init(&upipe_http_src_mgr->cookies);
     upipe_http_src_mgr->proxy = NULL;
+    ulist_init(&upipe_http_src_mgr->idle_conns);
+    upipe_http_src_mgr->nb_idle = 0;
+    upipe_http_src_mgr->max_idle = HTTP_KEEP_ALIVE_MAX_IDLE;
+    upipe_http_src_mgr->idle_timeout = HTTP_KEEP_ALIVE_TIMEOUT;
 
     return upipe_http_src_mgr_to_upipe_mgr(upipe_http_src_mgr);
 }
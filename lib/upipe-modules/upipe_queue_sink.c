@@ -35,6 +35,7 @@
 #include <upipe/upump.h>
 #include <upipe/upump_blocker.h>
 #include <upipe/upipe.h>
+#include <upipe/upipe_stats.h>
 #include <upipe/upipe_helper_upipe.h>
 #include <upipe/upipe_helper_urefcount.h>
 #include <upipe/upipe_helper_uref_mgr.h>
@@ -159,8 +160,12 @@ static bool upipe_qsink_output(struct upipe *upipe, struct uref *uref,
                                struct upump **upump_p)
 {
     struct upipe_qsink *upipe_qsink = upipe_qsink_from_upipe(upipe);
-    return uqueue_push(&upipe_queue(upipe_qsink->qsrc)->uqueue,
-                       uref_to_uchain(uref));
+    struct uqueue *uqueue = &upipe_queue(upipe_qsink->qsrc)->uqueue;
+    if (!uqueue_push(uqueue, uref_to_uchain(uref)))
+        return false;
+    if (unlikely(upipe->stats != NULL))
+        upipe_stats_queue_depth(upipe, uqueue_length(uqueue));
+    return true;
 }
 
 /** @internal @This is called when the queue can be written again.
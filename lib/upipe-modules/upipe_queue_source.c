@@ -28,7 +28,9 @@
  *
  * Note that the allocator requires an additional parameter:
  * @table 2
- * @item queue_length @item maximum length of the queue (<= 255)
+ * @item queue_length @item maximum length of the queue (<= 255, or
+ * <= @ref UQUEUE_MPMC_MAX_LENGTH for the manager returned by
+ * @ref upipe_qsrc_mpmc_mgr_alloc)
  * @end table
  *
  * Also note that this module is exceptional in that upipe_release() may be
@@ -58,6 +60,8 @@
 
 /** maximum length of out of band queues */
 #define OOB_QUEUES 255
+/** maximum number of buffers popped from the queue at once */
+#define POP_BATCH 32
 
 /** @internal @This is the private context of a queue source pipe. */
 struct upipe_qsrc {
@@ -70,6 +74,12 @@ struct upipe_qsrc {
     struct upump *upump;
     /** oob watcher */
     struct upump *upump_oob;
+    /** timer bounding the latency of coalesced wakeups */
+    struct upump *upump_timer;
+    /** number of queued buffers from which the sink wakes us up */
+    unsigned int threshold;
+    /** maximum latency of buffers queued below the threshold */
+    uint64_t latency;
 
     /** pipe acting as output */
     struct upipe *output;
@@ -95,6 +105,10 @@ UPIPE_HELPER_OUTPUT(upipe_qsrc, output, flow_def, output_state, request_list)
 UPIPE_HELPER_UPUMP_MGR(upipe_qsrc, upump_mgr)
 UPIPE_HELPER_UPUMP(upipe_qsrc, upump, upump_mgr)
 UPIPE_HELPER_UPUMP(upipe_qsrc, upump_oob, upump_mgr)
+UPIPE_HELPER_UPUMP(upipe_qsrc, upump_timer, upump_mgr)
+
+/** module manager static descriptor, for queues backed by umpmc */
+static struct upipe_mgr upipe_qsrc_mpmc_mgr;
 
 /** @internal @This allocates a queue source pipe.
  *
@@ -110,25 +124,30 @@ static struct upipe *_upipe_qsrc_alloc(struct upipe_mgr *mgr,
 {
     if (signature != UPIPE_QSRC_SIGNATURE)
         goto upipe_qsrc_alloc_err;
+    bool mpmc = mgr == &upipe_qsrc_mpmc_mgr;
     unsigned int length = va_arg(args, unsigned int);
-    if (!length || length > UINT8_MAX)
+    if (!length || length > (mpmc ? UQUEUE_MPMC_MAX_LENGTH : UINT8_MAX))
         goto upipe_qsrc_alloc_err;
 
+    size_t queue_size = mpmc ? uqueue_mpmc_sizeof(length) :
+                               uqueue_sizeof(length);
     struct upipe_qsrc *upipe_qsrc = malloc(sizeof(struct upipe_qsrc) +
-                                           uqueue_sizeof(length) +
+                                           queue_size +
                                            2 * uqueue_sizeof(OOB_QUEUES));
     if (unlikely(upipe_qsrc == NULL))
         goto upipe_qsrc_alloc_err;
 
     struct upipe *upipe = upipe_qsrc_to_upipe(upipe_qsrc);
     upipe_init(upipe, mgr, uprobe);
-    if (unlikely(!uqueue_init(&upipe_queue(upipe)->uqueue, length,
-                              upipe_qsrc->uqueue_extra) ||
+    if (unlikely(!(mpmc ?
+                   uqueue_init_mpmc(&upipe_queue(upipe)->uqueue, length,
+                                    upipe_qsrc->uqueue_extra) :
+                   uqueue_init(&upipe_queue(upipe)->uqueue, length,
+                               upipe_qsrc->uqueue_extra)) ||
                  !uqueue_init(&upipe_queue(upipe)->downstream_oob, OOB_QUEUES,
-                              upipe_qsrc->uqueue_extra +
-                              uqueue_sizeof(length)) ||
+                              upipe_qsrc->uqueue_extra + queue_size) ||
                  !uqueue_init(&upipe_queue(upipe)->upstream_oob, OOB_QUEUES,
-                              upipe_qsrc->uqueue_extra + uqueue_sizeof(length) +
+                              upipe_qsrc->uqueue_extra + queue_size +
                               uqueue_sizeof(OOB_QUEUES)))) {
         free(upipe_qsrc);
         goto upipe_qsrc_alloc_err;
@@ -139,6 +158,9 @@ static struct upipe *_upipe_qsrc_alloc(struct upipe_mgr *mgr,
     upipe_qsrc_init_upump_mgr(upipe);
     upipe_qsrc_init_upump(upipe);
     upipe_qsrc_init_upump_oob(upipe);
+    upipe_qsrc_init_upump_timer(upipe);
+    upipe_qsrc->threshold = 1;
+    upipe_qsrc->latency = 0;
     upipe_qsrc->upipe_queue.max_length = length;
     upipe_throw_ready(upipe);
 
@@ -167,17 +189,46 @@ static void upipe_qsrc_input(struct upipe *upipe, struct uref *uref,
     upipe_qsrc_output(upipe, uref, upump_p);
 }
 
-/** @internal @This reads data from the queue and outputs it.
+/** @internal @This reads a batch of data from the queue and outputs it.
+ *
+ * @param upipe description structure of the pipe
+ * @return number of urefs popped from the queue
+ */
+static unsigned int upipe_qsrc_pop(struct upipe *upipe)
+{
+    struct upipe_qsrc *upipe_qsrc = upipe_qsrc_from_upipe(upipe);
+    void *urefs[POP_BATCH];
+    unsigned int nb = uqueue_pop_batch(&upipe_queue(upipe)->uqueue, urefs,
+                                       POP_BATCH);
+    for (unsigned int i = 0; i < nb; i++)
+        upipe_qsrc_input(upipe, urefs[i], &upipe_qsrc->upump);
+    return nb;
+}
+
+/** @internal @This reads a batch of data from the queue when it is woken up.
  *
  * @param upump description structure of the read watcher
  */
 static void upipe_qsrc_worker(struct upump *upump)
 {
     struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
-    struct upipe_qsrc *upipe_qsrc = upipe_qsrc_from_upipe(upipe);
-    struct uref *uref = uqueue_pop(&upipe_queue(upipe)->uqueue, struct uref *);
-    if (likely(uref != NULL))
-        upipe_qsrc_input(upipe, uref, &upipe_qsrc->upump);
+    upipe_qsrc_pop(upipe);
+}
+
+/** @internal @This drains the buffers queued below the wakeup threshold.
+ * Batches are popped until the queue is empty or a batch comes back short,
+ * so that a backlog larger than a batch does not wait for the next tick.
+ *
+ * @param upump description structure of the timer
+ */
+static void upipe_qsrc_timer(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    upipe_use(upipe);
+    /* avoid the eventfd system calls of an empty queue */
+    while (uqueue_length(&upipe_queue(upipe)->uqueue) &&
+           upipe_qsrc_pop(upipe) == POP_BATCH);
+    upipe_release(upipe);
 }
 
 /** @internal @This handles the result of a request.
@@ -302,6 +353,7 @@ static void upipe_qsrc_ref_end(struct upipe *upipe)
 
     upipe_qsrc_clean_upump(upipe);
     upipe_qsrc_clean_upump_oob(upipe);
+    upipe_qsrc_clean_upump_timer(upipe);
     upipe_qsrc_clean_upump_mgr(upipe);
     upipe_qsrc_clean_output(upipe);
 
@@ -380,6 +432,27 @@ static int _upipe_qsrc_get_length(struct upipe *upipe, unsigned int *length_p)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This sets the wakeup threshold and latency.
+ *
+ * @param upipe description structure of the pipe
+ * @param threshold number of queued buffers from which the sink wakes us up
+ * @param latency maximum latency of buffers queued below the threshold
+ * @return an error code
+ */
+static int _upipe_qsrc_set_wakeup(struct upipe *upipe, unsigned int threshold,
+                                  uint64_t latency)
+{
+    struct upipe_qsrc *upipe_qsrc = upipe_qsrc_from_upipe(upipe);
+    if (unlikely(!threshold || (threshold > 1 && !latency)))
+        return UBASE_ERR_INVALID;
+
+    upipe_qsrc->threshold = threshold;
+    upipe_qsrc->latency = latency;
+    upipe_qsrc_set_upump_timer(upipe, NULL);
+    uqueue_set_threshold(&upipe_queue(upipe)->uqueue, threshold);
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands on a queue source pipe.
  *
  * @param upipe description structure of the pipe
@@ -392,6 +465,7 @@ static int _upipe_qsrc_control(struct upipe *upipe, int command, va_list args)
     switch (command) {
         case UPIPE_ATTACH_UPUMP_MGR:
             upipe_qsrc_set_upump(upipe, NULL);
+            upipe_qsrc_set_upump_timer(upipe, NULL);
             return upipe_qsrc_attach_upump_mgr(upipe);
         case UPIPE_GET_FLOW_DEF: {
             struct uref **p = va_arg(args, struct uref **);
@@ -416,6 +490,12 @@ static int _upipe_qsrc_control(struct upipe *upipe, int command, va_list args)
             unsigned int *length_p = va_arg(args, unsigned int *);
             return _upipe_qsrc_get_length(upipe, length_p);
         }
+        case UPIPE_QSRC_SET_WAKEUP: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_QSRC_SIGNATURE)
+            unsigned int threshold = va_arg(args, unsigned int);
+            uint64_t latency = va_arg(args, uint64_t);
+            return _upipe_qsrc_set_wakeup(upipe, threshold, latency);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -459,6 +539,20 @@ static int upipe_qsrc_control(struct upipe *upipe, int command, va_list args)
         upump_start(upump);
     }
 
+    if (upipe_qsrc->upump_mgr != NULL && upipe_qsrc->threshold > 1 &&
+        upipe_qsrc->upump_timer == NULL) {
+        struct upump *upump =
+            upump_alloc_timer(upipe_qsrc->upump_mgr, upipe_qsrc_timer, upipe,
+                              upipe->refcount, upipe_qsrc->latency,
+                              upipe_qsrc->latency);
+        if (unlikely(upump == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_UPUMP);
+            return UBASE_ERR_UPUMP;
+        }
+        upipe_qsrc_set_upump_timer(upipe, upump);
+        upump_start(upump);
+    }
+
     return UBASE_ERR_NONE;
 }
 
@@ -507,3 +601,26 @@ struct upipe_mgr *upipe_qsrc_mgr_alloc(void)
 {
     return &upipe_qsrc_mgr;
 }
+
+/** module manager static descriptor, for queues backed by umpmc */
+static struct upipe_mgr upipe_qsrc_mpmc_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_QSRC_SIGNATURE,
+
+    .upipe_alloc = _upipe_qsrc_alloc,
+    .upipe_input = NULL,
+    .upipe_control = upipe_qsrc_control,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for queue source pipes whose
+ * queue is backed by a lock-free umpmc ring, which scales better when
+ * several threads push into the queue, and allows for longer queues.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_qsrc_mpmc_mgr_alloc(void)
+{
+    return &upipe_qsrc_mpmc_mgr;
+}
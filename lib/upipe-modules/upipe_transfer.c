@@ -35,6 +35,7 @@
 #include <upipe/uprobe.h>
 #include <upipe/upump.h>
 #include <upipe/upipe.h>
+#include <upipe/upipe_stats.h>
 #include <upipe/upipe_helper_upipe.h>
 #include <upipe/upipe_helper_urefcount.h>
 #include <upipe/upipe_helper_upump_mgr.h>
@@ -53,6 +54,9 @@
 #include <math.h>
 #include <assert.h>
 
+/** maximum number of messages popped from the queue at once */
+#define UPIPE_XFER_POP_BATCH 32
+
 /** @internal @This is the private context of a xfer pipe manager. */
 struct upipe_xfer_mgr {
     /** real refcount management structure */
@@ -63,10 +67,14 @@ struct upipe_xfer_mgr {
 
     /** watcher */
     struct upump *upump;
+    /** timer bounding the latency of coalesced wakeups */
+    struct upump *upump_timer;
     /** remote upump_mgr */
     struct upump_mgr *upump_mgr;
     /** queue length */
-    uint8_t queue_length;
+    unsigned int queue_length;
+    /** true if the queues are backed by umpmc */
+    bool mpmc;
     /** queue of messages */
     struct uqueue uqueue;
     /** pool of @ref upipe_xfer_msg */
@@ -90,7 +98,9 @@ enum upipe_xfer_command {
     /** release pipe */
     UPIPE_XFER_RELEASE,
     /** detach from remote upump_mgr */
-    UPIPE_XFER_DETACH
+    UPIPE_XFER_DETACH,
+    /** set wakeup threshold and latency of the queue */
+    UPIPE_XFER_SET_WAKEUP
     /* values from @ref uprobe_xfer_event are also allowed (backwards) */
 };
 
@@ -102,6 +112,8 @@ union upipe_xfer_arg {
     struct upipe *pipe;
     /** event */
     int event;
+    /** wakeup threshold */
+    unsigned int threshold;
 };
 
 /** @This is the optional argument of an event. */
@@ -301,6 +313,33 @@ static void upipe_xfer_probe_free(struct urefcount *urefcount_probe)
     }
 }
 
+/** @internal @This returns the size of the extra space of a queue.
+ *
+ * @param mpmc true if the queue is backed by umpmc
+ * @param length maximum length of the queue
+ * @return size in octets
+ */
+static size_t upipe_xfer_queue_sizeof(bool mpmc, unsigned int length)
+{
+    return mpmc ? uqueue_mpmc_sizeof(length) : uqueue_sizeof(length);
+}
+
+/** @internal @This initializes a queue.
+ *
+ * @param uqueue pointer to a uqueue structure
+ * @param mpmc true if the queue is backed by umpmc
+ * @param length maximum length of the queue
+ * @param extra extra space allocated by the caller
+ * @return false in case of failure
+ */
+static bool upipe_xfer_queue_init(struct uqueue *uqueue, bool mpmc,
+                                  unsigned int length, void *extra)
+{
+    if (mpmc)
+        return uqueue_init_mpmc(uqueue, length, extra);
+    return uqueue_init(uqueue, length, extra);
+}
+
 /** @This allocates and initializes an xfer pipe. An xfer pipe allows to
  * transfer an existing pipe to a remote upump_mgr. The xfer pipe is then
  * used to remotely release the transferred pipe.
@@ -328,12 +367,14 @@ static struct upipe *_upipe_xfer_alloc(struct upipe_mgr *mgr,
 
     struct upipe_xfer *upipe_xfer =
         malloc(sizeof(struct upipe_xfer) +
-               uqueue_sizeof(xfer_mgr->queue_length));
+               upipe_xfer_queue_sizeof(xfer_mgr->mpmc,
+                                       xfer_mgr->queue_length));
     if (unlikely(upipe_xfer == NULL))
         goto upipe_xfer_alloc_err2;
 
-    if (unlikely(!uqueue_init(&upipe_xfer->uqueue, xfer_mgr->queue_length,
-                              upipe_xfer->extra))) {
+    if (unlikely(!upipe_xfer_queue_init(&upipe_xfer->uqueue, xfer_mgr->mpmc,
+                                        xfer_mgr->queue_length,
+                                        upipe_xfer->extra))) {
         free(upipe_xfer);
         goto upipe_xfer_alloc_err2;
     }
@@ -370,6 +411,8 @@ static void upipe_xfer_worker(struct upump *upump)
     struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
     struct upipe_xfer *upipe_xfer = upipe_xfer_from_upipe(upipe);
     struct upipe_xfer_msg *msg;
+    if (unlikely(upipe->stats != NULL))
+        upipe_stats_queue_depth(upipe, uqueue_length(&upipe_xfer->uqueue));
     while ((msg = uqueue_pop(&upipe_xfer->uqueue,
                              struct upipe_xfer_msg *)) != NULL) {
         switch (msg->type) {
@@ -512,12 +555,49 @@ static void upipe_xfer_mgr_free(struct upipe_mgr *mgr)
     struct upipe_xfer_mgr *xfer_mgr = upipe_xfer_mgr_from_upipe_mgr(mgr);
     upump_stop(xfer_mgr->upump);
     upump_free(xfer_mgr->upump);
+    if (xfer_mgr->upump_timer != NULL) {
+        upump_stop(xfer_mgr->upump_timer);
+        upump_free(xfer_mgr->upump_timer);
+    }
     upump_mgr_release(xfer_mgr->upump_mgr);
     uqueue_clean(&xfer_mgr->uqueue);
     upipe_xfer_mgr_vacuum(mgr);
     free(xfer_mgr);
 }
 
+/** @hidden */
+static void upipe_xfer_mgr_timer(struct upump *upump);
+
+/** @This applies the wakeup threshold and latency of the queue, in the
+ * remote thread.
+ *
+ * @param mgr xfer_mgr structure
+ * @param threshold number of queued messages from which we are woken up
+ * @param latency maximum latency of messages queued below the threshold
+ */
+static void upipe_xfer_mgr_wakeup(struct upipe_mgr *mgr,
+                                  unsigned int threshold, uint64_t latency)
+{
+    struct upipe_xfer_mgr *xfer_mgr = upipe_xfer_mgr_from_upipe_mgr(mgr);
+    if (xfer_mgr->upump_timer != NULL) {
+        upump_stop(xfer_mgr->upump_timer);
+        upump_free(xfer_mgr->upump_timer);
+        xfer_mgr->upump_timer = NULL;
+    }
+
+    if (threshold > 1) {
+        xfer_mgr->upump_timer = upump_alloc_timer(xfer_mgr->upump_mgr,
+                                                  upipe_xfer_mgr_timer, mgr,
+                                                  NULL, latency, latency);
+        if (unlikely(xfer_mgr->upump_timer == NULL))
+            /* never leave messages stranded below the threshold */
+            threshold = 1;
+        else
+            upump_start(xfer_mgr->upump_timer);
+    }
+    uqueue_set_threshold(&xfer_mgr->uqueue, threshold);
+}
+
 /** @This is called by the remote upump manager to receive messages.
  *
  * @param upump description structure of the read watcher
@@ -526,37 +606,62 @@ static void upipe_xfer_mgr_worker(struct upump *upump)
 {
     struct upipe_mgr *mgr = upump_get_opaque(upump, struct upipe_mgr *);
     struct upipe_xfer_mgr *xfer_mgr = upipe_xfer_mgr_from_upipe_mgr(mgr);
-    struct upipe_xfer_msg *msg;
-    while ((msg = uqueue_pop(&xfer_mgr->uqueue,
-                             struct upipe_xfer_msg *)) != NULL) {
-        switch (msg->type) {
-            case UPIPE_XFER_ATTACH_UPUMP_MGR:
-                upipe_attach_upump_mgr(msg->upipe_remote);
-                break;
-            case UPIPE_XFER_SET_URI:
-                upipe_set_uri(msg->upipe_remote, msg->arg.string);
-                free(msg->arg.string);
-                break;
-            case UPIPE_XFER_SET_OUTPUT:
-                upipe_set_output(msg->upipe_remote, msg->arg.pipe);
-                upipe_release(msg->arg.pipe);
-                break;
-            case UPIPE_XFER_RELEASE:
-                upipe_release(msg->upipe_remote);
-                break;
-            case UPIPE_XFER_DETACH:
-                upipe_xfer_msg_free(mgr, msg);
-                upipe_xfer_mgr_free(mgr);
-                return;
-            default:
-                /* this should not happen */
-                break;
-        }
+    void *msgs[UPIPE_XFER_POP_BATCH];
+    unsigned int nb;
+    while ((nb = uqueue_pop_batch(&xfer_mgr->uqueue, msgs,
+                                  UPIPE_XFER_POP_BATCH))) {
+        for (unsigned int i = 0; i < nb; i++) {
+            struct upipe_xfer_msg *msg = msgs[i];
+            switch (msg->type) {
+                case UPIPE_XFER_ATTACH_UPUMP_MGR:
+                    upipe_attach_upump_mgr(msg->upipe_remote);
+                    break;
+                case UPIPE_XFER_SET_URI:
+                    upipe_set_uri(msg->upipe_remote, msg->arg.string);
+                    free(msg->arg.string);
+                    break;
+                case UPIPE_XFER_SET_OUTPUT:
+                    upipe_set_output(msg->upipe_remote, msg->arg.pipe);
+                    upipe_release(msg->arg.pipe);
+                    break;
+                case UPIPE_XFER_RELEASE:
+                    upipe_release(msg->upipe_remote);
+                    break;
+                case UPIPE_XFER_SET_WAKEUP:
+                    upipe_xfer_mgr_wakeup(mgr, msg->arg.threshold,
+                                          msg->event_arg.u64);
+                    break;
+                case UPIPE_XFER_DETACH:
+                    /* this is the last message, as all references to the
+                     * manager are gone */
+                    assert(i == nb - 1);
+                    upipe_xfer_msg_free(mgr, msg);
+                    upipe_xfer_mgr_free(mgr);
+                    return;
+                default:
+                    /* this should not happen */
+                    break;
+            }
 
-        upipe_xfer_msg_free(mgr, msg);
+            upipe_xfer_msg_free(mgr, msg);
+        }
     }
 }
 
+/** @This is called by the remote upump manager to receive the messages
+ * queued below the wakeup threshold.
+ *
+ * @param upump description structure of the timer
+ */
+static void upipe_xfer_mgr_timer(struct upump *upump)
+{
+    struct upipe_mgr *mgr = upump_get_opaque(upump, struct upipe_mgr *);
+    struct upipe_xfer_mgr *xfer_mgr = upipe_xfer_mgr_from_upipe_mgr(mgr);
+    /* avoid the eventfd system calls of an empty queue */
+    if (uqueue_length(&xfer_mgr->uqueue))
+        upipe_xfer_mgr_worker(upump);
+}
+
 /** @This sends a message to the remote upump manager.
  *
  * @param mgr xfer_mgr structure
@@ -633,6 +738,40 @@ static int _upipe_xfer_mgr_attach(struct upipe_mgr *mgr,
     return UBASE_ERR_NONE;
 }
 
+/** @This sets the wakeup threshold and latency of the queue of messages.
+ * The settings are applied by the remote upump manager, so this call is
+ * thread-safe and may be performed from any thread.
+ *
+ * @param mgr xfer_mgr structure
+ * @param threshold number of queued messages from which the remote upump
+ * manager is woken up
+ * @param latency maximum latency of messages queued below the threshold
+ * @return an error code
+ */
+static int _upipe_xfer_mgr_set_wakeup(struct upipe_mgr *mgr,
+                                      unsigned int threshold,
+                                      uint64_t latency)
+{
+    struct upipe_xfer_mgr *xfer_mgr = upipe_xfer_mgr_from_upipe_mgr(mgr);
+    if (unlikely(!threshold || (threshold > 1 && !latency)))
+        return UBASE_ERR_INVALID;
+
+    struct upipe_xfer_msg *msg = upipe_xfer_msg_alloc(mgr);
+    if (msg == NULL)
+        return UBASE_ERR_ALLOC;
+
+    msg->type = UPIPE_XFER_SET_WAKEUP;
+    msg->upipe_remote = NULL;
+    msg->arg.threshold = threshold;
+    msg->event_arg.u64 = latency;
+
+    if (unlikely(!uqueue_push(&xfer_mgr->uqueue, msg))) {
+        upipe_xfer_msg_free(mgr, msg);
+        return UBASE_ERR_EXTERNAL;
+    }
+    return UBASE_ERR_NONE;
+}
+
 /** @This processes manager control commands.
  *
  * @param mgr xfer_mgr structure
@@ -649,40 +788,48 @@ static int upipe_xfer_mgr_control(struct upipe_mgr *mgr,
             struct upump_mgr *upump_mgr = va_arg(args, struct upump_mgr *);
             return _upipe_xfer_mgr_attach(mgr, upump_mgr);
         }
+        case UPIPE_XFER_MGR_SET_WAKEUP: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_XFER_SIGNATURE)
+            unsigned int threshold = va_arg(args, unsigned int);
+            uint64_t latency = va_arg(args, uint64_t);
+            return _upipe_xfer_mgr_set_wakeup(mgr, threshold, latency);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
 }
 
-/** @This returns a management structure for xfer pipes. You would need one
- * management structure per target event loop (upump manager). The management
- * structure can be allocated in any thread, but must be attached in the
- * same thread as the one running the upump manager.
+/** @internal @This allocates a management structure for xfer pipes.
  *
  * @param queue_length maximum length of the internal queues
  * @param msg_pool_depth maximum number of messages in the pool
+ * @param mpmc true if the queues are backed by umpmc
  * @return pointer to manager
  */
-struct upipe_mgr *upipe_xfer_mgr_alloc(uint8_t queue_length,
-                                       uint16_t msg_pool_depth)
+static struct upipe_mgr *_upipe_xfer_mgr_alloc(unsigned int queue_length,
+                                               uint16_t msg_pool_depth,
+                                               bool mpmc)
 {
     assert(queue_length);
+    size_t queue_size = upipe_xfer_queue_sizeof(mpmc, queue_length);
     struct upipe_xfer_mgr *xfer_mgr = malloc(sizeof(struct upipe_xfer_mgr) +
-                                             uqueue_sizeof(queue_length) +
+                                             queue_size +
                                              ulifo_sizeof(msg_pool_depth));
     if (unlikely(xfer_mgr == NULL))
         return NULL;
 
-    if (unlikely(!uqueue_init(&xfer_mgr->uqueue, queue_length,
-                              xfer_mgr->extra))) {
+    if (unlikely(!upipe_xfer_queue_init(&xfer_mgr->uqueue, mpmc,
+                                        queue_length, xfer_mgr->extra))) {
         free(xfer_mgr);
         return NULL;
     }
     xfer_mgr->upump = NULL;
+    xfer_mgr->upump_timer = NULL;
     xfer_mgr->upump_mgr = NULL;
     xfer_mgr->queue_length = queue_length;
+    xfer_mgr->mpmc = mpmc;
     ulifo_init(&xfer_mgr->msg_pool, msg_pool_depth,
-               xfer_mgr->extra + uqueue_sizeof(queue_length));
+               xfer_mgr->extra + queue_size);
 
     struct upipe_mgr *mgr = upipe_xfer_mgr_to_upipe_mgr(xfer_mgr);
     urefcount_init(upipe_xfer_mgr_to_urefcount(xfer_mgr),
@@ -695,3 +842,33 @@ struct upipe_mgr *upipe_xfer_mgr_alloc(uint8_t queue_length,
     mgr->upipe_mgr_control = upipe_xfer_mgr_control;
     return mgr;
 }
+
+/** @This returns a management structure for xfer pipes. You would need one
+ * management structure per target event loop (upump manager). The management
+ * structure can be allocated in any thread, but must be attached in the
+ * same thread as the one running the upump manager.
+ *
+ * @param queue_length maximum length of the internal queues
+ * @param msg_pool_depth maximum number of messages in the pool
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_xfer_mgr_alloc(uint8_t queue_length,
+                                       uint16_t msg_pool_depth)
+{
+    return _upipe_xfer_mgr_alloc(queue_length, msg_pool_depth, false);
+}
+
+/** @This returns a management structure for xfer pipes, whose internal
+ * queues are backed by lock-free umpmc rings. This scales better when many
+ * threads send messages to the same event loop.
+ *
+ * @param queue_length maximum length of the internal queues
+ * (<= @ref UQUEUE_MPMC_MAX_LENGTH)
+ * @param msg_pool_depth maximum number of messages in the pool
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_xfer_mgr_alloc_mpmc(unsigned int queue_length,
+                                            uint16_t msg_pool_depth)
+{
+    return _upipe_xfer_mgr_alloc(queue_length, msg_pool_depth, true);
+}
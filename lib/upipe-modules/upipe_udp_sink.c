@@ -28,6 +28,10 @@
  * @short Upipe sink module for udp
  */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include <upipe/ubase.h>
 #include <upipe/ulist.h>
 #include <upipe/uprobe.h>
@@ -58,6 +62,10 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
 #include <errno.h>
 #include <assert.h>
 
@@ -70,12 +78,30 @@
 
 #define UDP_DEFAULT_TTL 0
 #define UDP_DEFAULT_PORT 1234
+/** maximum number of datagrams sent per system call in batch mode */
+#define UDP_MAX_BATCH 1024
+/** maximum payload of a UDP datagram, used to size segmentation offload */
+#define UDP_MAX_PAYLOAD 65507
+/** maximum number of segments per datagram in segmentation offload mode */
+#define UDP_MAX_SEGMENTS 64
+
+#ifdef UDP_SEGMENT
+/** @internal @This is a control message carrying the segment size. */
+union upipe_udpsink_cmsg {
+    /** for alignment */
+    struct cmsghdr align;
+    /** control message */
+    uint8_t buffer[CMSG_SPACE(sizeof(uint16_t))];
+};
+#endif
 
 /** @hidden */
 static void upipe_udpsink_watcher(struct upump *upump);
 /** @hidden */
 static bool upipe_udpsink_output(struct upipe *upipe, struct uref *uref,
                                  struct upump **upump_p);
+/** @hidden */
+static void upipe_udpsink_batch_watcher(struct upump *upump);
 
 /** @internal @This is the private context of a udp sink pipe. */
 struct upipe_udpsink {
@@ -112,6 +138,43 @@ struct upipe_udpsink {
     /** RAW header */
     uint8_t raw_header[RAW_HEADER_SIZE];
 
+    /** maximum number of datagrams per system call (<= 1 disables batch) */
+    unsigned int batch;
+    /** time a datagram may be sent ahead of its date in batch mode */
+    uint64_t window;
+    /** true if UDP segmentation offload may be used in batch mode */
+    bool gso;
+    /** urefs waiting to be sent in batch mode */
+    struct uref **pending;
+#ifdef UPIPE_HAVE_SENDMMSG
+    /** sizes of the pending urefs */
+    size_t *sizes;
+    /** number of iovecs of the pending urefs */
+    int *counts;
+    /** iovecs of the payload of the pending urefs */
+    struct iovec **payloads;
+    /** message headers passed to sendmmsg */
+    struct mmsghdr *msgs;
+    /** headers of the pending urefs in RAW mode */
+    uint8_t (*raw_headers)[RAW_HEADER_SIZE];
+#ifdef UDP_SEGMENT
+    /** control messages of segmentation offload */
+    union upipe_udpsink_cmsg *cmsgs;
+#endif
+    /** iovecs passed to sendmmsg */
+    struct iovec *iovecs;
+    /** number of allocated iovecs */
+    unsigned int iovecs_size;
+#endif
+    /** number of urefs waiting to be sent */
+    unsigned int nb_pending;
+    /** date of the first pending uref */
+    uint64_t pending_first;
+    /** date of the last pending uref */
+    uint64_t pending_last;
+    /** batch flush timer */
+    struct upump *upump_batch;
+
     /** public upipe structure */
     struct upipe upipe;
 };
@@ -121,6 +184,7 @@ UPIPE_HELPER_UREFCOUNT(upipe_udpsink, urefcount, upipe_udpsink_free)
 UPIPE_HELPER_VOID(upipe_udpsink)
 UPIPE_HELPER_UPUMP_MGR(upipe_udpsink, upump_mgr)
 UPIPE_HELPER_UPUMP(upipe_udpsink, upump, upump_mgr)
+UPIPE_HELPER_UPUMP(upipe_udpsink, upump_batch, upump_mgr)
 UPIPE_HELPER_INPUT(upipe_udpsink, urefs, nb_urefs, max_urefs, blockers, upipe_udpsink_output)
 UPIPE_HELPER_UCLOCK(upipe_udpsink, uclock, uclock_request, NULL, upipe_throw_provide_request, NULL)
 
@@ -145,12 +209,31 @@ static struct upipe *upipe_udpsink_alloc(struct upipe_mgr *mgr,
     upipe_udpsink_init_urefcount(upipe);
     upipe_udpsink_init_upump_mgr(upipe);
     upipe_udpsink_init_upump(upipe);
+    upipe_udpsink_init_upump_batch(upipe);
     upipe_udpsink_init_input(upipe);
     upipe_udpsink_init_uclock(upipe);
     upipe_udpsink->latency = 0;
     upipe_udpsink->fd = -1;
     upipe_udpsink->uri = NULL;
     upipe_udpsink->raw = false;
+    upipe_udpsink->batch = 1;
+    upipe_udpsink->window = 0;
+    upipe_udpsink->gso = false;
+    upipe_udpsink->pending = NULL;
+#ifdef UPIPE_HAVE_SENDMMSG
+    upipe_udpsink->sizes = NULL;
+    upipe_udpsink->counts = NULL;
+    upipe_udpsink->payloads = NULL;
+    upipe_udpsink->msgs = NULL;
+    upipe_udpsink->raw_headers = NULL;
+#ifdef UDP_SEGMENT
+    upipe_udpsink->cmsgs = NULL;
+#endif
+    upipe_udpsink->iovecs = NULL;
+    upipe_udpsink->iovecs_size = 0;
+#endif
+    upipe_udpsink->nb_pending = 0;
+    upipe_udpsink->pending_first = upipe_udpsink->pending_last = 0;
     upipe_throw_ready(upipe);
     return upipe;
 }
@@ -178,6 +261,373 @@ static void upipe_udpsink_poll(struct upipe *upipe)
     }
 }
 
+/** @internal @This frees the urefs waiting to be sent in batch mode.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_udpsink_drop_batch(struct upipe *upipe)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+    upipe_udpsink_set_upump_batch(upipe, NULL);
+    if (!upipe_udpsink->nb_pending)
+        return;
+
+    for (unsigned int i = 0; i < upipe_udpsink->nb_pending; i++)
+        uref_free(upipe_udpsink->pending[i]);
+    upipe_udpsink->nb_pending = 0;
+    /* Release the pipe used in @ref upipe_udpsink_output_batch. */
+    upipe_release(upipe);
+}
+
+/** @internal @This frees the arrays used in batch mode.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_udpsink_free_batch(struct upipe *upipe)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+    free(upipe_udpsink->pending);
+    upipe_udpsink->pending = NULL;
+#ifdef UPIPE_HAVE_SENDMMSG
+    free(upipe_udpsink->sizes);
+    upipe_udpsink->sizes = NULL;
+    free(upipe_udpsink->counts);
+    upipe_udpsink->counts = NULL;
+    free(upipe_udpsink->payloads);
+    upipe_udpsink->payloads = NULL;
+    free(upipe_udpsink->msgs);
+    upipe_udpsink->msgs = NULL;
+    free(upipe_udpsink->raw_headers);
+    upipe_udpsink->raw_headers = NULL;
+#ifdef UDP_SEGMENT
+    free(upipe_udpsink->cmsgs);
+    upipe_udpsink->cmsgs = NULL;
+#endif
+    free(upipe_udpsink->iovecs);
+    upipe_udpsink->iovecs = NULL;
+    upipe_udpsink->iovecs_size = 0;
+#endif
+}
+
+/** @internal @This allocates the arrays used in batch mode, so that sending
+ * a batch does not need them on the stack.
+ *
+ * @param upipe description structure of the pipe
+ * @param batch maximum number of datagrams per system call
+ * @return an error code
+ */
+static int upipe_udpsink_alloc_batch(struct upipe *upipe, unsigned int batch)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+    upipe_udpsink->pending = calloc(batch, sizeof(struct uref *));
+    bool failed = upipe_udpsink->pending == NULL;
+#ifdef UPIPE_HAVE_SENDMMSG
+    upipe_udpsink->sizes = calloc(batch, sizeof(size_t));
+    upipe_udpsink->counts = calloc(batch, sizeof(int));
+    upipe_udpsink->payloads = calloc(batch, sizeof(struct iovec *));
+    upipe_udpsink->msgs = calloc(batch, sizeof(struct mmsghdr));
+    upipe_udpsink->raw_headers = calloc(batch, RAW_HEADER_SIZE);
+    failed = failed || upipe_udpsink->sizes == NULL ||
+             upipe_udpsink->counts == NULL ||
+             upipe_udpsink->payloads == NULL ||
+             upipe_udpsink->msgs == NULL ||
+             upipe_udpsink->raw_headers == NULL;
+#ifdef UDP_SEGMENT
+    upipe_udpsink->cmsgs = calloc(batch, sizeof(union upipe_udpsink_cmsg));
+    failed = failed || upipe_udpsink->cmsgs == NULL;
+#endif
+#endif
+    if (unlikely(failed)) {
+        upipe_udpsink_free_batch(upipe);
+        return UBASE_ERR_ALLOC;
+    }
+    return UBASE_ERR_NONE;
+}
+
+#ifdef UPIPE_HAVE_SENDMMSG
+/** @internal @This removes the first urefs from the pending batch.
+ *
+ * @param upipe description structure of the pipe
+ * @param nb number of urefs to remove
+ */
+static void upipe_udpsink_shift_batch(struct upipe *upipe, unsigned int nb)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+    assert(nb <= upipe_udpsink->nb_pending);
+    for (unsigned int i = 0; i < nb; i++)
+        uref_free(upipe_udpsink->pending[i]);
+    memmove(upipe_udpsink->pending, upipe_udpsink->pending + nb,
+            (upipe_udpsink->nb_pending - nb) * sizeof(struct uref *));
+    upipe_udpsink->nb_pending -= nb;
+}
+
+/** @internal @This sends the pending urefs with a single sendmmsg(2) call
+ * when possible, grouping them into segmentation offload datagrams if all
+ * payloads have the same size.
+ *
+ * @param upipe description structure of the pipe
+ * @return false if the socket is full, in which case the remaining urefs are
+ * kept and a watcher is started
+ */
+static bool upipe_udpsink_flush_batch(struct upipe *upipe)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+    if (!upipe_udpsink->nb_pending)
+        return true;
+
+    while (upipe_udpsink->nb_pending) {
+        unsigned int nb = upipe_udpsink->nb_pending;
+        struct uref **pending = upipe_udpsink->pending;
+        size_t *sizes = upipe_udpsink->sizes;
+        int *counts = upipe_udpsink->counts;
+        unsigned int nb_iovecs = 0;
+        bool same_size = true;
+
+        for (unsigned int i = 0; i < nb; i++) {
+            sizes[i] = 0;
+            uref_block_size(pending[i], &sizes[i]);
+            counts[i] = uref_block_iovec_count(pending[i], 0, -1);
+            nb_iovecs += counts[i] + (upipe_udpsink->raw ? 1 : 0);
+            if (sizes[i] != sizes[0])
+                same_size = false;
+        }
+
+        /* number of urefs per datagram */
+        unsigned int segments = 1;
+#ifdef UDP_SEGMENT
+        if (upipe_udpsink->gso && !upipe_udpsink->raw && same_size &&
+            nb > 1 && sizes[0] && sizes[0] <= UDP_MAX_PAYLOAD / 2) {
+            segments = UDP_MAX_PAYLOAD / sizes[0];
+            if (segments > UDP_MAX_SEGMENTS)
+                segments = UDP_MAX_SEGMENTS;
+        }
+#endif
+        unsigned int nb_msgs = (nb + segments - 1) / segments;
+
+        if (unlikely(nb_iovecs > upipe_udpsink->iovecs_size)) {
+            struct iovec *iovecs = realloc(upipe_udpsink->iovecs,
+                                           nb_iovecs * sizeof(struct iovec));
+            if (unlikely(iovecs == NULL)) {
+                upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+                upipe_udpsink_drop_batch(upipe);
+                return true;
+            }
+            upipe_udpsink->iovecs = iovecs;
+            upipe_udpsink->iovecs_size = nb_iovecs;
+        }
+
+        struct iovec **payloads = upipe_udpsink->payloads;
+        struct mmsghdr *msgs = upipe_udpsink->msgs;
+        uint8_t (*raw_headers)[RAW_HEADER_SIZE] = upipe_udpsink->raw_headers;
+#ifdef UDP_SEGMENT
+        union upipe_udpsink_cmsg *controls = upipe_udpsink->cmsgs;
+#endif
+        memset(msgs, 0, nb_msgs * sizeof(struct mmsghdr));
+
+        struct iovec *iovec = upipe_udpsink->iovecs;
+        unsigned int i;
+        for (i = 0; i < nb; i++) {
+            struct mmsghdr *msg = &msgs[i / segments];
+            if (i % segments == 0)
+                msg->msg_hdr.msg_iov = iovec;
+
+            if (upipe_udpsink->raw) {
+                memcpy(raw_headers[i], upipe_udpsink->raw_header,
+                       RAW_HEADER_SIZE);
+                udp_raw_set_len(raw_headers[i], sizes[i]);
+                iovec->iov_base = raw_headers[i];
+                iovec->iov_len = RAW_HEADER_SIZE;
+                iovec++;
+            }
+            payloads[i] = iovec;
+            if (unlikely(!ubase_check(uref_block_iovec_read(pending[i], 0, -1,
+                                                            iovec))))
+                break;
+            iovec += counts[i];
+            msg->msg_hdr.msg_iovlen = iovec - msg->msg_hdr.msg_iov;
+        }
+
+        if (unlikely(i < nb)) {
+            /* drop the faulty uref and try again */
+            upipe_warn(upipe, "cannot read ubuf buffer");
+            for (unsigned int j = 0; j < i; j++)
+                uref_block_iovec_unmap(pending[j], 0, -1, payloads[j]);
+            uref_free(pending[i]);
+            memmove(pending + i, pending + i + 1,
+                    (nb - i - 1) * sizeof(struct uref *));
+            upipe_udpsink->nb_pending--;
+            continue;
+        }
+
+#ifdef UDP_SEGMENT
+        if (segments > 1) {
+            for (unsigned int j = 0; j < nb_msgs; j++) {
+                struct msghdr *hdr = &msgs[j].msg_hdr;
+                hdr->msg_control = controls[j].buffer;
+                hdr->msg_controllen = sizeof(controls[j].buffer);
+                struct cmsghdr *cmsg = CMSG_FIRSTHDR(hdr);
+                cmsg->cmsg_level = SOL_UDP;
+                cmsg->cmsg_type = UDP_SEGMENT;
+                cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+                uint16_t segment_size = sizes[0];
+                memcpy(CMSG_DATA(cmsg), &segment_size, sizeof(uint16_t));
+            }
+        }
+#endif
+
+        int ret = sendmmsg(upipe_udpsink->fd, msgs, nb_msgs, 0);
+        int err = errno;
+        for (i = 0; i < nb; i++)
+            uref_block_iovec_unmap(pending[i], 0, -1, payloads[i]);
+
+        if (likely(ret > 0)) {
+            unsigned int sent = ret * segments;
+            upipe_udpsink_shift_batch(upipe, sent < nb ? sent : nb);
+            continue;
+        }
+
+        switch (err) {
+            case EINTR:
+                continue;
+            case EAGAIN:
+#if EAGAIN != EWOULDBLOCK
+            case EWOULDBLOCK:
+#endif
+                /* the watcher will send the remaining urefs */
+                upipe_udpsink_set_upump_batch(upipe, NULL);
+                upipe_udpsink_poll(upipe);
+                return false;
+            case EIO:
+            case EINVAL:
+            case ENOPROTOOPT:
+            case EOPNOTSUPP:
+                if (segments > 1) {
+                    upipe_warn(upipe, "disabling UDP segmentation offload");
+                    upipe_udpsink->gso = false;
+                    continue;
+                }
+                break;
+            default:
+                break;
+        }
+        /* Errors at this point come from ICMP messages such as
+         * "port unreachable", and we do not want to kill the application
+         * with transient errors. */
+        upipe_udpsink_shift_batch(upipe, segments < nb ? segments : nb);
+    }
+
+    upipe_udpsink_set_upump_batch(upipe, NULL);
+    /* Release the pipe used in @ref upipe_udpsink_output_batch. */
+    upipe_release(upipe);
+    return true;
+}
+
+/** @internal @This queues a uref in the pending batch, and sends the batch
+ * if the uref cannot join it.
+ *
+ * A batch is sent at the date of its first uref, and a uref may join the
+ * batch if its own date is no later than the date of the first uref plus the
+ * batch window, so that no datagram is sent later than its date, and none is
+ * sent earlier than the batch window.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @return true if the uref was processed
+ */
+static bool upipe_udpsink_output_batch(struct upipe *upipe, struct uref *uref)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+    uint64_t now = 0, systime = 0;
+    if (upipe_udpsink->uclock != NULL) {
+        now = uclock_now(upipe_udpsink->uclock);
+        if (unlikely(!ubase_check(uref_clock_get_cr_sys(uref, &systime)))) {
+            upipe_warn(upipe, "received non-dated buffer");
+            systime = now;
+        } else {
+            systime += upipe_udpsink->latency;
+            if (now > systime + SYSTIME_TOLERANCE) {
+                upipe_warn_va(upipe,
+                    "dropping late packet %"PRIu64" ms, latency %"PRIu64" ms",
+                    (now - systime) / (UCLOCK_FREQ / 1000),
+                    upipe_udpsink->latency / (UCLOCK_FREQ / 1000));
+                uref_free(uref);
+                return true;
+            } else if (now > systime + SYSTIME_PRINT)
+                upipe_warn_va(upipe,
+                    "outputting late packet %"PRIu64" ms, latency %"PRIu64" ms",
+                    (now - systime) / (UCLOCK_FREQ / 1000),
+                    upipe_udpsink->latency / (UCLOCK_FREQ / 1000));
+        }
+    }
+
+    int iovec_count = uref_block_iovec_count(uref, 0, -1);
+    if (unlikely(iovec_count <= 0)) {
+        if (iovec_count == -1)
+            upipe_warn(upipe, "cannot read ubuf buffer");
+        uref_free(uref);
+        return true;
+    }
+
+    if (upipe_udpsink->nb_pending &&
+        (upipe_udpsink->nb_pending >= upipe_udpsink->batch ||
+         systime > upipe_udpsink->pending_first + upipe_udpsink->window)) {
+        /* the current batch must be sent first */
+        if (now + upipe_udpsink->window < upipe_udpsink->pending_last)
+            /* too early, wait for the batch timer */
+            return false;
+        if (!upipe_udpsink_flush_batch(upipe))
+            return false;
+    }
+
+    if (!upipe_udpsink->nb_pending) {
+        /* Increment upipe refcount to avoid disappearing before all packets
+         * have been sent. */
+        upipe_use(upipe);
+        upipe_udpsink->pending_first = systime;
+        upipe_udpsink_check_upump_mgr(upipe);
+        if (likely(upipe_udpsink->upump_mgr != NULL))
+            upipe_udpsink_wait_upump_batch(upipe,
+                    systime > now ? systime - now : 0,
+                    upipe_udpsink_batch_watcher);
+    }
+    upipe_udpsink->pending[upipe_udpsink->nb_pending++] = uref;
+    upipe_udpsink->pending_last = systime;
+
+    if (unlikely(upipe_udpsink->upump_mgr == NULL))
+        upipe_udpsink_flush_batch(upipe);
+    return true;
+}
+#else
+/** @hidden */
+static bool upipe_udpsink_flush_batch(struct upipe *upipe)
+{
+    return true;
+}
+#endif
+
+/** @internal @This is called when the pending batch must be sent.
+ *
+ * @param upump description structure of the timer
+ */
+static void upipe_udpsink_batch_watcher(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+    upipe_udpsink_set_upump_batch(upipe, NULL);
+    if (!upipe_udpsink_flush_batch(upipe))
+        return;
+
+    if (upipe_udpsink->upump == NULL && !upipe_udpsink_check_input(upipe)) {
+        upipe_udpsink_output_input(upipe);
+        upipe_udpsink_unblock_input(upipe);
+        if (upipe_udpsink_check_input(upipe)) {
+            /* All packets have been output, release again the pipe that has
+             * been used in @ref upipe_udpsink_input. */
+            upipe_release(upipe);
+        }
+    }
+}
+
 /** @internal @This outputs data to the udp sink.
  *
  * @param upipe description structure of the pipe
@@ -205,6 +655,11 @@ static bool upipe_udpsink_output(struct upipe *upipe, struct uref *uref,
         return true;
     }
 
+#ifdef UPIPE_HAVE_SENDMMSG
+    if (upipe_udpsink->batch > 1)
+        return upipe_udpsink_output_batch(upipe, uref);
+#endif
+
     if (likely(upipe_udpsink->uclock == NULL))
         goto write_buffer;
 
@@ -318,7 +773,12 @@ write_buffer:
 static void upipe_udpsink_watcher(struct upump *upump)
 {
     struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
     upipe_udpsink_set_upump(upipe, NULL);
+    /* a pending batch without timer was interrupted by a full socket */
+    if (upipe_udpsink->nb_pending && upipe_udpsink->upump_batch == NULL &&
+        !upipe_udpsink_flush_batch(upipe))
+        return;
     upipe_udpsink_output_input(upipe);
     upipe_udpsink_unblock_input(upipe);
     if (upipe_udpsink_check_input(upipe)) {
@@ -395,6 +855,10 @@ static int _upipe_udpsink_set_uri(struct upipe *upipe, const char *uri,
     bool use_tcp = false;
 
     if (unlikely(upipe_udpsink->fd != -1)) {
+        upipe_udpsink_flush_batch(upipe);
+        upipe_udpsink_drop_batch(upipe);
+        /* the flush may have started a watcher on the socket */
+        upipe_udpsink_set_upump(upipe, NULL);
         if (likely(upipe_udpsink->uri != NULL))
             upipe_notice_va(upipe, "closing socket %s", upipe_udpsink->uri);
         close(upipe_udpsink->fd);
@@ -450,6 +914,7 @@ static int _upipe_udpsink_set_uri(struct upipe *upipe, const char *uri,
  */
 static int upipe_udpsink_flush(struct upipe *upipe)
 {
+    upipe_udpsink_drop_batch(upipe);
     if (upipe_udpsink_flush_input(upipe)) {
         upipe_udpsink_set_upump(upipe, NULL);
         /* All packets have been output, release again the pipe that has been
@@ -459,6 +924,76 @@ static int upipe_udpsink_flush(struct upipe *upipe)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This returns the batch parameters.
+ *
+ * @param upipe description structure of the pipe
+ * @param batch_p filled in with the maximum number of datagrams per system call
+ * @param window_p filled in with the batch window
+ * @return an error code
+ */
+static int _upipe_udpsink_get_batch(struct upipe *upipe,
+                                    unsigned int *batch_p, uint64_t *window_p)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+    if (batch_p != NULL)
+        *batch_p = upipe_udpsink->batch;
+    if (window_p != NULL)
+        *window_p = upipe_udpsink->window;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the batch parameters.
+ *
+ * @param upipe description structure of the pipe
+ * @param batch maximum number of datagrams per system call
+ * @param window maximum advance of a datagram on its date
+ * @return an error code
+ */
+static int _upipe_udpsink_set_batch(struct upipe *upipe,
+                                    unsigned int batch, uint64_t window)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+    if (batch == 0 || batch > UDP_MAX_BATCH)
+        return UBASE_ERR_INVALID;
+#ifndef UPIPE_HAVE_SENDMMSG
+    if (batch > 1) {
+        upipe_warn(upipe, "batch mode is not supported on this platform");
+        return UBASE_ERR_EXTERNAL;
+    }
+#endif
+
+    upipe_udpsink_flush_batch(upipe);
+    upipe_udpsink_drop_batch(upipe);
+    upipe_udpsink_free_batch(upipe);
+    upipe_udpsink->batch = 1;
+    upipe_udpsink->window = window;
+    if (batch > 1) {
+        UBASE_RETURN(upipe_udpsink_alloc_batch(upipe, batch))
+        upipe_udpsink->batch = batch;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This enables or disables UDP segmentation offload in batch
+ * mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param enable true to enable segmentation offload
+ * @return an error code
+ */
+static int _upipe_udpsink_set_gso(struct upipe *upipe, bool enable)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+#ifndef UDP_SEGMENT
+    if (enable) {
+        upipe_warn(upipe, "segmentation offload is not supported on this platform");
+        return UBASE_ERR_EXTERNAL;
+    }
+#endif
+    upipe_udpsink->gso = enable;
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands on a udp sink pipe.
  *
  * @param upipe description structure of the pipe
@@ -471,6 +1006,8 @@ static int _upipe_udpsink_control(struct upipe *upipe,
 {
     switch (command) {
         case UPIPE_ATTACH_UPUMP_MGR:
+            upipe_udpsink_flush_batch(upipe);
+            upipe_udpsink_drop_batch(upipe);
             upipe_udpsink_set_upump(upipe, NULL);
             return upipe_udpsink_attach_upump_mgr(upipe);
         case UPIPE_ATTACH_UCLOCK:
@@ -517,6 +1054,23 @@ static int _upipe_udpsink_control(struct upipe *upipe,
             enum upipe_udpsink_mode mode = va_arg(args, enum upipe_udpsink_mode);
             return _upipe_udpsink_set_uri(upipe, uri, mode);
         }
+        case UPIPE_UDPSINK_GET_BATCH: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSINK_SIGNATURE)
+            unsigned int *batch_p = va_arg(args, unsigned int *);
+            uint64_t *window_p = va_arg(args, uint64_t *);
+            return _upipe_udpsink_get_batch(upipe, batch_p, window_p);
+        }
+        case UPIPE_UDPSINK_SET_BATCH: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSINK_SIGNATURE)
+            unsigned int batch = va_arg(args, unsigned int);
+            uint64_t window = va_arg(args, uint64_t);
+            return _upipe_udpsink_set_batch(upipe, batch, window);
+        }
+        case UPIPE_UDPSINK_SET_GSO: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSINK_SIGNATURE)
+            int enable = va_arg(args, int);
+            return _upipe_udpsink_set_gso(upipe, !!enable);
+        }
         case UPIPE_FLUSH:
             return upipe_udpsink_flush(upipe);
         default:
@@ -557,7 +1111,9 @@ static void upipe_udpsink_free(struct upipe *upipe)
     upipe_throw_dead(upipe);
 
     free(upipe_udpsink->uri);
+    upipe_udpsink_free_batch(upipe);
     upipe_udpsink_clean_uclock(upipe);
+    upipe_udpsink_clean_upump_batch(upipe);
     upipe_udpsink_clean_upump(upipe);
     upipe_udpsink_clean_upump_mgr(upipe);
     upipe_udpsink_clean_input(upipe);
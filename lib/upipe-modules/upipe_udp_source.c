@@ -28,6 +28,10 @@
  * @short Upipe source module for udp sockets
  */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include <upipe/ubase.h>
 #include <upipe/uprobe.h>
 #include <upipe/uclock.h>
@@ -63,10 +67,14 @@
 #include <sys/ioctl.h>
 #include <errno.h>
 #include <assert.h>
+#include <time.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 
 /** default size of buffers when unspecified */
 #define UBUF_DEFAULT_SIZE       4096
+/** maximum number of datagrams read per wakeup in batch mode */
+#define UDP_MAX_BATCH           1024
 
 #define UDP_DEFAULT_TTL 0
 #define UDP_DEFAULT_PORT 1234
@@ -74,6 +82,19 @@
 /** @hidden */
 static int upipe_udpsrc_check(struct upipe *upipe, struct uref *flow_format);
 
+/** @internal @This is a preallocated receive slot used in batch mode. */
+struct upipe_udpsrc_slot {
+    /** preallocated buffer, mapped for writing */
+    struct ubuf *ubuf;
+    /** description of the mapped buffer */
+    struct iovec iovec;
+    /** ancillary data (kernel receive timestamp) */
+    union {
+        struct cmsghdr align;
+        uint8_t buffer[CMSG_SPACE(sizeof(struct timespec))];
+    } control;
+};
+
 /** @internal @This is the private context of a udp socket source pipe. */
 struct upipe_udpsrc {
     /** refcount management structure */
@@ -117,6 +138,24 @@ struct upipe_udpsrc {
     /** udp socket uri */
     char *uri;
 
+    /** true if the read watcher is an I/O pump */
+    bool io_pump;
+    /** description of the read operation of the I/O pump */
+    struct upump_io io;
+    /** buffer of the read operation */
+    struct iovec iovec;
+    /** reference being read by the I/O pump */
+    struct uref *io_uref;
+
+    /** maximum number of datagrams read per wakeup (<= 1 disables batch) */
+    unsigned int batch;
+    /** receive slots in batch mode */
+    struct upipe_udpsrc_slot *slots;
+#ifdef UPIPE_HAVE_RECVMMSG
+    /** message headers passed to recvmmsg in batch mode */
+    struct mmsghdr *msgs;
+#endif
+
     /** public upipe structure */
     struct upipe upipe;
 };
@@ -166,17 +205,134 @@ static struct upipe *upipe_udpsrc_alloc(struct upipe_mgr *mgr,
     upipe_udpsrc_init_output_size(upipe, UBUF_DEFAULT_SIZE);
     upipe_udpsrc->fd = -1;
     upipe_udpsrc->uri = NULL;
+    upipe_udpsrc->io_pump = false;
+    upipe_udpsrc->io.type = UPUMP_IO_READ;
+    upipe_udpsrc->io.fd = -1;
+    upipe_udpsrc->io.iovecs = &upipe_udpsrc->iovec;
+    upipe_udpsrc->io.iovec_count = 1;
+    upipe_udpsrc->io.msg = NULL;
+    upipe_udpsrc->io.offset = -1;
+    upipe_udpsrc->io_uref = NULL;
+    upipe_udpsrc->batch = 0;
+    upipe_udpsrc->slots = NULL;
+#ifdef UPIPE_HAVE_RECVMMSG
+    upipe_udpsrc->msgs = NULL;
+#endif
     upipe_throw_ready(upipe);
     return upipe;
 }
 
+/** @internal @This releases the buffers preallocated for batch mode, for
+ * instance because the ubuf manager or the output size changed. The slots
+ * themselves are kept.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_udpsrc_flush_slots(struct upipe *upipe)
+{
+    struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    if (upipe_udpsrc->slots == NULL)
+        return;
+
+    for (unsigned int i = 0; i < upipe_udpsrc->batch; i++) {
+        struct upipe_udpsrc_slot *slot = &upipe_udpsrc->slots[i];
+        if (slot->ubuf != NULL) {
+            ubuf_block_unmap(slot->ubuf, 0);
+            ubuf_free(slot->ubuf);
+            slot->ubuf = NULL;
+        }
+    }
+}
+
+/** @internal @This frees the slots used in batch mode.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_udpsrc_clean_slots(struct upipe *upipe)
+{
+    struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    upipe_udpsrc_flush_slots(upipe);
+    free(upipe_udpsrc->slots);
+    upipe_udpsrc->slots = NULL;
+#ifdef UPIPE_HAVE_RECVMMSG
+    free(upipe_udpsrc->msgs);
+    upipe_udpsrc->msgs = NULL;
+#endif
+}
+
+/** @internal @This asks the kernel to timestamp received datagrams, so that
+ * the reception date doesn't depend on the wakeup latency in batch mode.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_udpsrc_set_timestamping(struct upipe *upipe)
+{
+#ifdef SO_TIMESTAMPNS
+    struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    int enable = 1;
+    if (upipe_udpsrc->fd == -1 || upipe_udpsrc->batch <= 1)
+        return;
+    if (unlikely(setsockopt(upipe_udpsrc->fd, SOL_SOCKET, SO_TIMESTAMPNS,
+                            &enable, sizeof(enable)) < 0))
+        upipe_warn_va(upipe, "unable to enable kernel timestamps (%m)");
+#endif
+}
+
+/** @internal @This outputs a datagram read from the source.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref buffer containing the datagram
+ * @param ret return value of the read operation
+ * @param systime date of the read operation, if live
+ */
+static void upipe_udpsrc_output_data(struct upipe *upipe, struct uref *uref,
+                                     ssize_t ret, uint64_t systime)
+{
+    struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    if (unlikely(ret == -1)) {
+        uref_free(uref);
+        switch (errno) {
+            case EINTR:
+            case EAGAIN:
+#if EAGAIN != EWOULDBLOCK
+            case EWOULDBLOCK:
+#endif
+                /* not an issue, try again later */
+                return;
+            case EBADF:
+            case EINVAL:
+            case EIO:
+            default:
+                break;
+        }
+        upipe_err_va(upipe, "read error from %s (%m)", upipe_udpsrc->uri);
+        upipe_udpsrc_set_upump(upipe, NULL);
+        upipe_throw_source_end(upipe);
+        return;
+    }
+    if (unlikely(ret == 0)) {
+        uref_free(uref);
+        if (likely(upipe_udpsrc->uclock == NULL)) {
+            upipe_notice_va(upipe, "end of udp socket %s", upipe_udpsrc->uri);
+            upipe_udpsrc_set_upump(upipe, NULL);
+            upipe_throw_source_end(upipe);
+        }
+        return;
+    }
+    if (unlikely(upipe_udpsrc->uclock != NULL))
+        uref_clock_set_cr_sys(uref, systime);
+    if (unlikely(ret != upipe_udpsrc->output_size))
+        uref_block_resize(uref, 0, ret);
+    upipe_udpsrc_output(upipe, uref, &upipe_udpsrc->upump);
+}
+
 /** @internal @This reads data from the source and outputs it.
  * It is called either when the idler triggers (permanent storage mode) or
  * when data is available on the udp socket descriptor (live stream mode).
  *
  * @param upump description structure of the read watcher
  */
-static void upipe_udpsrc_worker(struct upump *upump)
+static void upipe_udpsrc_worker_single(struct upump *upump)
 {
     struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
     struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
@@ -204,9 +360,165 @@ static void upipe_udpsrc_worker(struct upump *upump)
 
     ssize_t ret = read(upipe_udpsrc->fd, buffer, upipe_udpsrc->output_size);
     uref_block_unmap(uref, 0);
+    upipe_udpsrc_output_data(upipe, uref, ret, systime);
+}
 
-    if (unlikely(ret == -1)) {
+/** @internal @This allocates the buffer of the next read operation of the
+ * I/O pump, unless the previous one was not used.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_udpsrc_prepare_io(struct upipe *upipe)
+{
+    struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    if (upipe_udpsrc->io_uref != NULL)
+        return UBASE_ERR_NONE;
+
+    struct uref *uref = uref_block_alloc(upipe_udpsrc->uref_mgr,
+                                         upipe_udpsrc->ubuf_mgr,
+                                         upipe_udpsrc->output_size);
+    if (unlikely(uref == NULL))
+        return UBASE_ERR_ALLOC;
+
+    uint8_t *buffer;
+    int output_size = -1;
+    if (unlikely(!ubase_check(uref_block_write(uref, 0, &output_size,
+                                               &buffer)))) {
         uref_free(uref);
+        return UBASE_ERR_ALLOC;
+    }
+    upipe_udpsrc->iovec.iov_base = buffer;
+    upipe_udpsrc->iovec.iov_len = output_size;
+    upipe_udpsrc->io_uref = uref;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This outputs the datagram read by the I/O pump, and prepares
+ * the next read operation.
+ *
+ * @param upump description structure of the I/O pump
+ */
+static void upipe_udpsrc_io_worker(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    uint64_t systime = 0; /* to keep gcc quiet */
+    if (unlikely(upipe_udpsrc->uclock != NULL))
+        systime = uclock_now(upipe_udpsrc->uclock);
+
+    struct uref *uref = upipe_udpsrc->io_uref;
+    upipe_udpsrc->io_uref = NULL;
+    uref_block_unmap(uref, 0);
+    ssize_t ret = upipe_udpsrc->io.ret;
+    if (unlikely(ret < 0)) {
+        errno = -ret;
+        ret = -1;
+    } else if (unlikely(ret != upipe_udpsrc->iovec.iov_len))
+        /* the output size may have changed in the meantime */
+        uref_block_resize(uref, 0, ret);
+    upipe_udpsrc_output_data(upipe, uref, ret, systime);
+
+    if (upipe_udpsrc->upump != NULL && upipe_udpsrc->io_pump &&
+        unlikely(!ubase_check(upipe_udpsrc_prepare_io(upipe))))
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+}
+
+#ifdef UPIPE_HAVE_RECVMMSG
+/** @internal @This makes sure all receive slots have a buffer mapped for
+ * writing, and prepares the message headers for recvmmsg.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_udpsrc_fill_slots(struct upipe *upipe)
+{
+    struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    for (unsigned int i = 0; i < upipe_udpsrc->batch; i++) {
+        struct upipe_udpsrc_slot *slot = &upipe_udpsrc->slots[i];
+        struct mmsghdr *msg = &upipe_udpsrc->msgs[i];
+        if (slot->ubuf == NULL) {
+            slot->ubuf = ubuf_block_alloc(upipe_udpsrc->ubuf_mgr,
+                                          upipe_udpsrc->output_size);
+            if (unlikely(slot->ubuf == NULL))
+                return UBASE_ERR_ALLOC;
+
+            uint8_t *buffer;
+            int size = -1;
+            if (unlikely(!ubase_check(ubuf_block_write(slot->ubuf, 0, &size,
+                                                       &buffer)))) {
+                ubuf_free(slot->ubuf);
+                slot->ubuf = NULL;
+                return UBASE_ERR_ALLOC;
+            }
+            assert(size == upipe_udpsrc->output_size);
+            slot->iovec.iov_base = buffer;
+            slot->iovec.iov_len = size;
+        }
+
+        memset(msg, 0, sizeof(struct mmsghdr));
+        msg->msg_hdr.msg_iov = &slot->iovec;
+        msg->msg_hdr.msg_iovlen = 1;
+        msg->msg_hdr.msg_control = slot->control.buffer;
+        msg->msg_hdr.msg_controllen = sizeof(slot->control.buffer);
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This returns the reception date of a datagram, converted to
+ * the time base of the uclock.
+ *
+ * @param msg message header filled in by recvmmsg
+ * @param systime date of the wakeup in the time base of the uclock
+ * @param now_real date of the wakeup in the time base of the kernel
+ * timestamps, in nanoseconds
+ * @return reception date of the datagram
+ */
+static uint64_t upipe_udpsrc_get_cr_sys(struct msghdr *msg, uint64_t systime,
+                                        uint64_t now_real)
+{
+#ifdef SO_TIMESTAMPNS
+    struct cmsghdr *cmsg;
+    for (cmsg = CMSG_FIRSTHDR(msg); cmsg != NULL;
+         cmsg = CMSG_NXTHDR(msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_TIMESTAMPNS)
+            continue;
+
+        struct timespec ts;
+        memcpy(&ts, CMSG_DATA(cmsg), sizeof(struct timespec));
+        uint64_t recv_real = (uint64_t)ts.tv_sec * UINT64_C(1000000000) +
+                             ts.tv_nsec;
+        if (unlikely(recv_real > now_real))
+            break;
+        uint64_t delay = (now_real - recv_real) * (UCLOCK_FREQ / 1000000) /
+                         1000;
+        if (unlikely(delay > systime))
+            break;
+        return systime - delay;
+    }
+#endif
+    return systime;
+}
+
+/** @internal @This reads up to batch datagrams from the socket in a single
+ * system call, and outputs them.
+ *
+ * @param upump description structure of the read watcher
+ */
+static void upipe_udpsrc_worker_batch(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    int fd = upipe_udpsrc->fd;
+
+    if (unlikely(!ubase_check(upipe_udpsrc_fill_slots(upipe)))) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
+
+    int ret = recvmmsg(fd, upipe_udpsrc->msgs, upipe_udpsrc->batch,
+                       MSG_DONTWAIT, NULL);
+    if (unlikely(ret == -1)) {
         switch (errno) {
             case EINTR:
             case EAGAIN:
@@ -226,20 +538,89 @@ static void upipe_udpsrc_worker(struct upump *upump)
         upipe_throw_source_end(upipe);
         return;
     }
-    if (unlikely(ret == 0)) {
-        uref_free(uref);
-        if (likely(upipe_udpsrc->uclock == NULL)) {
-            upipe_notice_va(upipe, "end of udp socket %s", upipe_udpsrc->uri);
-            upipe_udpsrc_set_upump(upipe, NULL);
-            upipe_throw_source_end(upipe);
+
+    /* one clock reading per batch, the kernel timestamps give the offsets */
+    uint64_t systime = 0, now_real = 0;
+    if (unlikely(upipe_udpsrc->uclock != NULL)) {
+        struct timespec ts;
+        systime = uclock_now(upipe_udpsrc->uclock);
+        clock_gettime(CLOCK_REALTIME, &ts);
+        now_real = (uint64_t)ts.tv_sec * UINT64_C(1000000000) + ts.tv_nsec;
+    }
+
+    /* detach all buffers first, as the slots may be flushed by a control
+     * command coming from downstream */
+    struct uref *urefs[ret];
+    bool end = false;
+    for (int i = 0; i < ret; i++) {
+        struct upipe_udpsrc_slot *slot = &upipe_udpsrc->slots[i];
+        struct mmsghdr *msg = &upipe_udpsrc->msgs[i];
+        struct ubuf *ubuf = slot->ubuf;
+        slot->ubuf = NULL;
+        ubuf_block_unmap(ubuf, 0);
+        urefs[i] = NULL;
+
+        if (unlikely(msg->msg_len == 0)) {
+            ubuf_free(ubuf);
+            if (likely(upipe_udpsrc->uclock == NULL))
+                end = true;
+            continue;
+        }
+
+        struct uref *uref = uref_alloc(upipe_udpsrc->uref_mgr);
+        if (unlikely(uref == NULL)) {
+            ubuf_free(ubuf);
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            continue;
         }
+        if (unlikely(msg->msg_len != upipe_udpsrc->output_size))
+            ubuf_block_resize(ubuf, 0, msg->msg_len);
+        uref_attach_ubuf(uref, ubuf);
+
+        if (unlikely(upipe_udpsrc->uclock != NULL))
+            uref_clock_set_cr_sys(uref,
+                    upipe_udpsrc_get_cr_sys(&msg->msg_hdr, systime, now_real));
+        urefs[i] = uref;
+    }
+
+    /* outputting may trigger the release of the pipe */
+    upipe_use(upipe);
+    for (int i = 0; i < ret; i++) {
+        if (urefs[i] == NULL)
+            continue;
+        if (unlikely(upipe_udpsrc->fd != fd)) {
+            /* the socket was closed by a downstream pipe */
+            uref_free(urefs[i]);
+            continue;
+        }
+        upipe_udpsrc_output(upipe, urefs[i], &upipe_udpsrc->upump);
+    }
+
+    if (unlikely(end) && upipe_udpsrc->fd == fd) {
+        upipe_notice_va(upipe, "end of udp socket %s", upipe_udpsrc->uri);
+        upipe_udpsrc_set_upump(upipe, NULL);
+        upipe_throw_source_end(upipe);
+    }
+    upipe_release(upipe);
+}
+#endif
+
+/** @internal @This reads data from the source and outputs it, either one
+ * datagram at a time or in batches.
+ *
+ * @param upump description structure of the read watcher
+ */
+static void upipe_udpsrc_worker(struct upump *upump)
+{
+#ifdef UPIPE_HAVE_RECVMMSG
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    if (upipe_udpsrc->slots != NULL) {
+        upipe_udpsrc_worker_batch(upump);
         return;
     }
-    if (unlikely(upipe_udpsrc->uclock != NULL))
-        uref_clock_set_cr_sys(uref, systime);
-    if (unlikely(ret != upipe_udpsrc->output_size))
-        uref_block_resize(uref, 0, ret);
-    upipe_udpsrc_output(upipe, uref, &upipe_udpsrc->upump);
+#endif
+    upipe_udpsrc_worker_single(upump);
 }
 
 /** @internal @This checks if the pump may be allocated.
@@ -251,8 +632,11 @@ static void upipe_udpsrc_worker(struct upump *upump)
 static int upipe_udpsrc_check(struct upipe *upipe, struct uref *flow_format)
 {
     struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
-    if (flow_format != NULL)
+    if (flow_format != NULL) {
         upipe_udpsrc_store_flow_def(upipe, flow_format);
+        /* the ubuf manager may have changed */
+        upipe_udpsrc_flush_slots(upipe);
+    }
 
     upipe_udpsrc_check_upump_mgr(upipe);
     if (upipe_udpsrc->upump_mgr == NULL)
@@ -281,10 +665,27 @@ static int upipe_udpsrc_check(struct upipe *upipe, struct uref *flow_format)
         return UBASE_ERR_NONE;
 
     if (upipe_udpsrc->fd != -1 && upipe_udpsrc->upump == NULL) {
-        struct upump *upump;
-        upump = upump_alloc_fd_read(upipe_udpsrc->upump_mgr,
-                                    upipe_udpsrc_worker, upipe, upipe->refcount,
-                                    upipe_udpsrc->fd);
+        struct upump *upump = NULL;
+        if (upipe_udpsrc->slots == NULL) {
+            /* let the event loop perform the reads if it is able to */
+            upipe_udpsrc->io.fd = upipe_udpsrc->fd;
+            upump = upump_alloc_io(upipe_udpsrc->upump_mgr,
+                                   upipe_udpsrc_io_worker, upipe,
+                                   upipe->refcount, &upipe_udpsrc->io);
+            if (upump != NULL) {
+                int err = upipe_udpsrc_prepare_io(upipe);
+                if (unlikely(!ubase_check(err))) {
+                    upump_free(upump);
+                    upipe_throw_fatal(upipe, err);
+                    return err;
+                }
+            }
+        }
+        upipe_udpsrc->io_pump = upump != NULL;
+        if (upump == NULL)
+            upump = upump_alloc_fd_read(upipe_udpsrc->upump_mgr,
+                                        upipe_udpsrc_worker, upipe,
+                                        upipe->refcount, upipe_udpsrc->fd);
         if (unlikely(upump == NULL)) {
             upipe_throw_fatal(upipe, UBASE_ERR_UPUMP);
             return UBASE_ERR_UPUMP;
@@ -345,10 +746,62 @@ static int upipe_udpsrc_set_uri(struct upipe *upipe, const char *uri)
         upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
         return UBASE_ERR_ALLOC;
     }
+    upipe_udpsrc_set_timestamping(upipe);
     upipe_notice_va(upipe, "opening udp socket %s", upipe_udpsrc->uri);
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This returns the maximum number of datagrams read per wakeup.
+ *
+ * @param upipe description structure of the pipe
+ * @param batch_p filled in with the maximum number of datagrams
+ * @return an error code
+ */
+static int _upipe_udpsrc_get_batch(struct upipe *upipe, unsigned int *batch_p)
+{
+    struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    assert(batch_p != NULL);
+    *batch_p = upipe_udpsrc->batch > 1 ? upipe_udpsrc->batch : 1;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the maximum number of datagrams read per wakeup.
+ *
+ * @param upipe description structure of the pipe
+ * @param batch maximum number of datagrams (0 or 1 to disable batch mode)
+ * @return an error code
+ */
+static int _upipe_udpsrc_set_batch(struct upipe *upipe, unsigned int batch)
+{
+    struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    if (unlikely(batch > UDP_MAX_BATCH))
+        return UBASE_ERR_INVALID;
+
+    upipe_udpsrc_clean_slots(upipe);
+    upipe_udpsrc->batch = 0;
+    if (upipe_udpsrc->upump != NULL && upipe_udpsrc->io_pump)
+        /* the read watcher is allocated again later */
+        upipe_udpsrc_set_upump(upipe, NULL);
+    if (batch <= 1)
+        return UBASE_ERR_NONE;
+
+#ifdef UPIPE_HAVE_RECVMMSG
+    upipe_udpsrc->slots = calloc(batch, sizeof(struct upipe_udpsrc_slot));
+    upipe_udpsrc->msgs = calloc(batch, sizeof(struct mmsghdr));
+    if (unlikely(upipe_udpsrc->slots == NULL ||
+                 upipe_udpsrc->msgs == NULL)) {
+        upipe_udpsrc_clean_slots(upipe);
+        return UBASE_ERR_ALLOC;
+    }
+    upipe_udpsrc->batch = batch;
+    upipe_udpsrc_set_timestamping(upipe);
+    return UBASE_ERR_NONE;
+#else
+    upipe_warn(upipe, "batch mode is not supported on this platform");
+    return UBASE_ERR_EXTERNAL;
+#endif
+}
+
 /** @internal @This processes control commands on a udp socket source pipe.
  *
  * @param upipe description structure of the pipe
@@ -387,6 +840,7 @@ static int _upipe_udpsrc_control(struct upipe *upipe,
         }
         case UPIPE_SET_OUTPUT_SIZE: {
             unsigned int output_size = va_arg(args, unsigned int);
+            upipe_udpsrc_flush_slots(upipe);
             return upipe_udpsrc_set_output_size(upipe, output_size);
         }
 
@@ -398,6 +852,17 @@ static int _upipe_udpsrc_control(struct upipe *upipe,
             const char *uri = va_arg(args, const char *);
             return upipe_udpsrc_set_uri(upipe, uri);
         }
+
+        case UPIPE_UDPSRC_GET_BATCH: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSRC_SIGNATURE)
+            unsigned int *batch_p = va_arg(args, unsigned int *);
+            return _upipe_udpsrc_get_batch(upipe, batch_p);
+        }
+        case UPIPE_UDPSRC_SET_BATCH: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSRC_SIGNATURE)
+            unsigned int batch = va_arg(args, unsigned int);
+            return _upipe_udpsrc_set_batch(upipe, batch);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -435,9 +900,12 @@ static void upipe_udpsrc_free(struct upipe *upipe)
     upipe_throw_dead(upipe);
 
     free(upipe_udpsrc->uri);
+    upipe_udpsrc_clean_slots(upipe);
     upipe_udpsrc_clean_output_size(upipe);
     upipe_udpsrc_clean_uclock(upipe);
     upipe_udpsrc_clean_upump(upipe);
+    /* the read in flight, if any, was cancelled with the pump */
+    uref_free(upipe_udpsrc->io_uref);
     upipe_udpsrc_clean_upump_mgr(upipe);
     upipe_udpsrc_clean_output(upipe);
     upipe_udpsrc_clean_ubuf_mgr(upipe);
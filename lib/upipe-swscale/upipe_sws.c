@@ -55,16 +55,43 @@
 #include <unistd.h>
 #include <errno.h>
 #include <assert.h>
+#include <pthread.h>
 
 #include <libavutil/opt.h>
+#include <libavutil/pixdesc.h>
 #include <libswscale/swscale.h>
 
+/** minimum number of output lines of a band */
+#define UPIPE_SWS_MIN_BAND 16
+
 /** @hidden */
 static bool upipe_sws_handle(struct upipe *upipe, struct uref *uref,
                              struct upump **upump_p);
 /** @hidden */
 static int upipe_sws_check(struct upipe *upipe, struct uref *flow_format);
 
+/** @internal @This describes a horizontal band of the pictures. */
+struct upipe_sws_band {
+    /** pointer to the pipe */
+    struct upipe_sws *upipe_sws;
+    /** swscale image conversion context [0] for progressive, [1,2] interlaced */
+    struct SwsContext *convert_ctx[3];
+    /** first input line of the band, for each context */
+    int input_y[3];
+    /** number of input lines of the band, for each context */
+    int input_vsize[3];
+    /** first output line of the band, for each context */
+    int output_y[3];
+    /** number of output lines of the band, for each context */
+    int output_vsize[3];
+    /** result of the last conversion */
+    int ret;
+    /** last job processed by the worker */
+    uint64_t job;
+    /** worker thread (unused for the first band) */
+    pthread_t thread;
+};
+
 /** upipe_sws structure with swscale parameters */
 struct upipe_sws {
     /** refcount management structure */
@@ -101,8 +128,33 @@ struct upipe_sws {
 
     /** swscale flags */
     int flags;
-    /** swscale image conversion context [0] for progressive, [1,2] interlaced */
-    struct SwsContext *convert_ctx[3];
+    /** number of bands, and of threads */
+    unsigned int nb_bands;
+    /** bands of the pictures, the first one is scaled by the pipe thread */
+    struct upipe_sws_band *bands;
+    /** protects the job and the synchronization with workers */
+    pthread_mutex_t lock;
+    /** signals the workers that a job is available */
+    pthread_cond_t job_cond;
+    /** signals the pipe thread that all workers are done */
+    pthread_cond_t done_cond;
+    /** current job */
+    uint64_t job;
+    /** number of workers still processing the current job */
+    unsigned int pending;
+    /** true if the workers must exit */
+    bool exit;
+    /** context of the current job */
+    int job_ctx;
+    /** input planes of the current job */
+    const uint8_t *job_input_planes[UPIPE_AV_MAX_PLANES + 1];
+    /** input strides of the current job */
+    int job_input_strides[UPIPE_AV_MAX_PLANES + 1];
+    /** output planes of the current job */
+    uint8_t *job_output_planes[UPIPE_AV_MAX_PLANES + 1];
+    /** output strides of the current job */
+    int job_output_strides[UPIPE_AV_MAX_PLANES + 1];
+
     /** input pixel format */
     enum AVPixelFormat input_pix_fmt;
     /** requested output pixel format */
@@ -163,6 +215,350 @@ static int upipe_sws_convert_color(struct upipe *upipe, struct uref *flow_def)
     return colorspace;
 }
 
+/** @internal @This returns the vertical subsampling of a pixel format.
+ *
+ * @param pix_fmt pixel format
+ * @return log2 of the vertical chroma subsampling
+ */
+static int upipe_sws_log2_chroma_h(enum AVPixelFormat pix_fmt)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(pix_fmt);
+    return desc != NULL ? desc->log2_chroma_h : 0;
+}
+
+/** @internal @This returns the offset of a line in a plane.
+ *
+ * @param pix_fmt pixel format
+ * @param plane index of the plane
+ * @param stride stride of the plane
+ * @param y line of the picture
+ * @return offset of the line in the plane, in octets
+ */
+static ptrdiff_t upipe_sws_plane_offset(enum AVPixelFormat pix_fmt,
+                                        int plane, int stride, int y)
+{
+    if (plane == 1 || plane == 2)
+        y >>= upipe_sws_log2_chroma_h(pix_fmt);
+    return (ptrdiff_t)y * stride;
+}
+
+/** @internal @This sets the chroma position options of the contexts of a
+ * band.
+ *
+ * @param upipe description structure of the pipe
+ * @param band description structure of the band
+ */
+static void upipe_sws_band_set_chroma_pos(struct upipe *upipe,
+                                          struct upipe_sws_band *band)
+{
+    struct upipe_sws *upipe_sws = upipe_sws_from_upipe(upipe);
+    if (upipe_sws->input_pix_fmt == AV_PIX_FMT_YUV420P) {
+        av_opt_set_int(band->convert_ctx[0], "src_v_chr_pos", 128, 0);
+        av_opt_set_int(band->convert_ctx[1], "src_v_chr_pos", 64, 0);
+        av_opt_set_int(band->convert_ctx[2], "src_v_chr_pos", 192, 0);
+    }
+
+    if (upipe_sws->output_pix_fmt == AV_PIX_FMT_YUV420P) {
+        av_opt_set_int(band->convert_ctx[0], "dst_v_chr_pos", 128, 0);
+        av_opt_set_int(band->convert_ctx[1], "dst_v_chr_pos", 64, 0);
+        av_opt_set_int(band->convert_ctx[2], "dst_v_chr_pos", 192, 0);
+    }
+}
+
+/** @internal @This initializes a band.
+ *
+ * @param upipe description structure of the pipe
+ * @param band description structure of the band
+ * @return an error code
+ */
+static int upipe_sws_band_init(struct upipe *upipe,
+                               struct upipe_sws_band *band)
+{
+    memset(band, 0, sizeof(struct upipe_sws_band));
+    band->upipe_sws = upipe_sws_from_upipe(upipe);
+    band->job = band->upipe_sws->job;
+    for (int i = 0; i < 3; i++) {
+        band->convert_ctx[i] = sws_alloc_context();
+        if (unlikely(band->convert_ctx[i] == NULL)) {
+            for (i--; i >= 0; i--)
+                sws_freeContext(band->convert_ctx[i]);
+            return UBASE_ERR_ALLOC;
+        }
+    }
+    upipe_sws_band_set_chroma_pos(upipe, band);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This cleans up a band.
+ *
+ * @param band description structure of the band
+ */
+static void upipe_sws_band_clean(struct upipe_sws_band *band)
+{
+    for (int i = 0; i < 3; i++) {
+        if (likely(band->convert_ctx[i]))
+            sws_freeContext(band->convert_ctx[i]);
+        band->convert_ctx[i] = NULL;
+    }
+}
+
+/** @internal @This splits the pictures into bands. Bands start on lines
+ * which are mapped exactly from the input to the output, and are compatible
+ * with the chroma subsampling, so that the lines of each band are sampled at
+ * the same positions as with a single context. Bands do not overlap, so the
+ * lines within the filter support of a boundary differ slightly, as each
+ * band clamps its own edges.
+ *
+ * @param upipe description structure of the pipe
+ * @param ctx index of the context
+ * @param input_vsize number of input lines
+ * @param output_vsize number of output lines
+ */
+static void upipe_sws_split(struct upipe *upipe, int ctx,
+                            int input_vsize, int output_vsize)
+{
+    struct upipe_sws *upipe_sws = upipe_sws_from_upipe(upipe);
+    int input_log2 = upipe_sws_log2_chroma_h(upipe_sws->input_pix_fmt);
+    int output_log2 = upipe_sws_log2_chroma_h(upipe_sws->output_pix_fmt);
+    int align = 1 << (input_log2 > output_log2 ? input_log2 : output_log2);
+    int gcd = ubase_gcd(input_vsize, output_vsize);
+    int nb_units = 0, input_unit = 0, output_unit = 0;
+    if (likely(gcd)) {
+        input_unit = input_vsize / gcd;
+        output_unit = output_vsize / gcd;
+        int mult = 1;
+        while ((input_unit * mult) % align || (output_unit * mult) % align)
+            mult *= 2;
+        input_unit *= mult;
+        output_unit *= mult;
+        nb_units = gcd / mult;
+    }
+
+    int nb_bands = upipe_sws->nb_bands;
+    if (output_unit && nb_bands > output_vsize / UPIPE_SWS_MIN_BAND)
+        nb_bands = output_vsize / UPIPE_SWS_MIN_BAND;
+    if (nb_bands > nb_units)
+        nb_bands = nb_units;
+    if (nb_bands < 1)
+        nb_bands = 1;
+
+    for (int i = 0; i < upipe_sws->nb_bands; i++) {
+        struct upipe_sws_band *band = &upipe_sws->bands[i];
+        if (i >= nb_bands) {
+            band->input_y[ctx] = band->input_vsize[ctx] = 0;
+            band->output_y[ctx] = band->output_vsize[ctx] = 0;
+            continue;
+        }
+
+        int start = i * nb_units / nb_bands;
+        int end = (i + 1) * nb_units / nb_bands;
+        band->input_y[ctx] = start * input_unit;
+        band->output_y[ctx] = start * output_unit;
+        if (i == nb_bands - 1) {
+            band->input_vsize[ctx] = input_vsize - band->input_y[ctx];
+            band->output_vsize[ctx] = output_vsize - band->output_y[ctx];
+        } else {
+            band->input_vsize[ctx] = (end - start) * input_unit;
+            band->output_vsize[ctx] = (end - start) * output_unit;
+        }
+    }
+}
+
+/** @internal @This sets the color space details of a context.
+ *
+ * @param upipe description structure of the pipe
+ * @param convert_ctx swscale context
+ */
+static void upipe_sws_set_colorspace(struct upipe *upipe,
+                                     struct SwsContext *convert_ctx)
+{
+    struct upipe_sws *upipe_sws = upipe_sws_from_upipe(upipe);
+    if (upipe_sws->colorspace_invalid)
+        return;
+
+    int in_full, out_full, brightness, contrast, saturation;
+    const int *inv_table, *table;
+
+    if (unlikely(sws_getColorspaceDetails(convert_ctx,
+                    (int **)&inv_table, &in_full, (int **)&table, &out_full,
+                    &brightness, &contrast, &saturation) < 0)) {
+        upipe_warn(upipe, "unable to set color space data");
+        upipe_sws->colorspace_invalid = true;
+        return;
+    }
+
+    if (upipe_sws->input_colorspace != -1)
+        inv_table = sws_getCoefficients(upipe_sws->input_colorspace);
+    if (upipe_sws->input_color_range != -1)
+        in_full = upipe_sws->input_color_range;
+    if (upipe_sws->output_colorspace != -1)
+        table = sws_getCoefficients(upipe_sws->output_colorspace);
+    if (upipe_sws->output_color_range != -1)
+        out_full = upipe_sws->output_color_range;
+
+    if (unlikely(sws_setColorspaceDetails(convert_ctx,
+                    inv_table, in_full, table, out_full,
+                    brightness, contrast, saturation) < 0)) {
+        upipe_warn(upipe, "unable to set color space data");
+        upipe_sws->colorspace_invalid = true;
+    }
+}
+
+/** @internal @This scales the band of the current job.
+ *
+ * @param band description structure of the band
+ */
+static void upipe_sws_band_scale(struct upipe_sws_band *band)
+{
+    struct upipe_sws *upipe_sws = band->upipe_sws;
+    int ctx = upipe_sws->job_ctx;
+    band->ret = 1;
+    if (!band->output_vsize[ctx])
+        return;
+
+    const uint8_t *input_planes[UPIPE_AV_MAX_PLANES + 1];
+    uint8_t *output_planes[UPIPE_AV_MAX_PLANES + 1];
+    for (int i = 0; i < UPIPE_AV_MAX_PLANES + 1; i++) {
+        input_planes[i] = upipe_sws->job_input_planes[i];
+        if (input_planes[i] != NULL)
+            input_planes[i] += upipe_sws_plane_offset(
+                    upipe_sws->input_pix_fmt, i,
+                    upipe_sws->job_input_strides[i], band->input_y[ctx]);
+        output_planes[i] = upipe_sws->job_output_planes[i];
+        if (output_planes[i] != NULL)
+            output_planes[i] += upipe_sws_plane_offset(
+                    upipe_sws->output_pix_fmt, i,
+                    upipe_sws->job_output_strides[i], band->output_y[ctx]);
+    }
+
+    band->ret = sws_scale(band->convert_ctx[ctx],
+                          input_planes, upipe_sws->job_input_strides,
+                          0, band->input_vsize[ctx],
+                          output_planes, upipe_sws->job_output_strides);
+}
+
+/** @internal @This is the main loop of a worker thread.
+ *
+ * @param opaque description structure of the band
+ * @return NULL
+ */
+static void *upipe_sws_worker(void *opaque)
+{
+    struct upipe_sws_band *band = opaque;
+    struct upipe_sws *upipe_sws = band->upipe_sws;
+
+    pthread_mutex_lock(&upipe_sws->lock);
+    for ( ; ; ) {
+        while (!upipe_sws->exit && band->job == upipe_sws->job)
+            pthread_cond_wait(&upipe_sws->job_cond, &upipe_sws->lock);
+        if (upipe_sws->exit)
+            break;
+        band->job = upipe_sws->job;
+        pthread_mutex_unlock(&upipe_sws->lock);
+
+        upipe_sws_band_scale(band);
+
+        pthread_mutex_lock(&upipe_sws->lock);
+        if (!--upipe_sws->pending)
+            pthread_cond_signal(&upipe_sws->done_cond);
+    }
+    pthread_mutex_unlock(&upipe_sws->lock);
+    return NULL;
+}
+
+/** @internal @This starts the worker threads of all bands but the first.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_sws_start_workers(struct upipe *upipe)
+{
+    struct upipe_sws *upipe_sws = upipe_sws_from_upipe(upipe);
+    for (int i = 1; i < upipe_sws->nb_bands; i++) {
+        struct upipe_sws_band *band = &upipe_sws->bands[i];
+        band->job = upipe_sws->job;
+        if (unlikely(pthread_create(&band->thread, NULL,
+                                    upipe_sws_worker, band) != 0)) {
+            upipe_err(upipe, "couldn't create worker thread");
+            for (int j = i; j < upipe_sws->nb_bands; j++)
+                upipe_sws_band_clean(&upipe_sws->bands[j]);
+            upipe_sws->nb_bands = i;
+            return UBASE_ERR_EXTERNAL;
+        }
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This stops the worker threads.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_sws_stop_workers(struct upipe *upipe)
+{
+    struct upipe_sws *upipe_sws = upipe_sws_from_upipe(upipe);
+    if (upipe_sws->nb_bands <= 1)
+        return;
+
+    pthread_mutex_lock(&upipe_sws->lock);
+    upipe_sws->exit = true;
+    pthread_cond_broadcast(&upipe_sws->job_cond);
+    pthread_mutex_unlock(&upipe_sws->lock);
+
+    for (int i = 1; i < upipe_sws->nb_bands; i++)
+        pthread_join(upipe_sws->bands[i].thread, NULL);
+    upipe_sws->exit = false;
+}
+
+/** @internal @This scales a picture or a field with all bands, the first
+ * band being scaled by the calling thread.
+ *
+ * @param upipe description structure of the pipe
+ * @param ctx index of the context
+ * @param input_planes input planes
+ * @param input_strides input strides
+ * @param output_planes output planes
+ * @param output_strides output strides
+ * @return the result of sws_scale, or the first error
+ */
+static int upipe_sws_scale(struct upipe *upipe, int ctx,
+                           const uint8_t **input_planes, int *input_strides,
+                           uint8_t **output_planes, int *output_strides)
+{
+    struct upipe_sws *upipe_sws = upipe_sws_from_upipe(upipe);
+    upipe_sws->job_ctx = ctx;
+    memcpy(upipe_sws->job_input_planes, input_planes,
+           sizeof(upipe_sws->job_input_planes));
+    memcpy(upipe_sws->job_input_strides, input_strides,
+           sizeof(upipe_sws->job_input_strides));
+    memcpy(upipe_sws->job_output_planes, output_planes,
+           sizeof(upipe_sws->job_output_planes));
+    memcpy(upipe_sws->job_output_strides, output_strides,
+           sizeof(upipe_sws->job_output_strides));
+
+    if (upipe_sws->nb_bands > 1) {
+        pthread_mutex_lock(&upipe_sws->lock);
+        upipe_sws->job++;
+        upipe_sws->pending = upipe_sws->nb_bands - 1;
+        pthread_cond_broadcast(&upipe_sws->job_cond);
+        pthread_mutex_unlock(&upipe_sws->lock);
+    }
+
+    upipe_sws_band_scale(&upipe_sws->bands[0]);
+
+    if (upipe_sws->nb_bands > 1) {
+        pthread_mutex_lock(&upipe_sws->lock);
+        while (upipe_sws->pending)
+            pthread_cond_wait(&upipe_sws->done_cond, &upipe_sws->lock);
+        pthread_mutex_unlock(&upipe_sws->lock);
+    }
+
+    int ret = upipe_sws->bands[0].ret;
+    for (int i = 1; i < upipe_sws->nb_bands; i++)
+        if (upipe_sws->bands[i].ret <= 0 && ret > 0)
+            ret = upipe_sws->bands[i].ret;
+    return ret;
+}
+
 /** @internal @This handles data.
  *
  * @param upipe description structure of the pipe
@@ -207,45 +603,26 @@ static bool upipe_sws_handle(struct upipe *upipe, struct uref *uref,
 
     int i;
     for (i = 0; i < 3; i++) {
-        upipe_sws->convert_ctx[i] = sws_getCachedContext(upipe_sws->convert_ctx[i],
-                    input_hsize, input_vsize >> !!i, upipe_sws->input_pix_fmt,
-                    output_hsize, output_vsize >> !!i, upipe_sws->output_pix_fmt,
-                    upipe_sws->flags, NULL, NULL, NULL);
-
-        if (unlikely(upipe_sws->convert_ctx[i] == NULL)) {
-            upipe_err(upipe, "sws_getContext failed");
-            uref_free(uref);
-            return true;
-        }
-
-        if (upipe_sws->colorspace_invalid)
-            continue;
-
-        int in_full, out_full, brightness, contrast, saturation;
-        const int *inv_table, *table;
-
-        if (unlikely(sws_getColorspaceDetails(upipe_sws->convert_ctx[i],
-                        (int **)&inv_table, &in_full, (int **)&table, &out_full,
-                        &brightness, &contrast, &saturation) < 0)) {
-            upipe_warn(upipe, "unable to set color space data");
-            upipe_sws->colorspace_invalid = true;
-            continue;
-        }
-
-        if (upipe_sws->input_colorspace != -1)
-            inv_table = sws_getCoefficients(upipe_sws->input_colorspace);
-        if (upipe_sws->input_color_range != -1)
-            in_full = upipe_sws->input_color_range;
-        if (upipe_sws->output_colorspace != -1)
-            table = sws_getCoefficients(upipe_sws->output_colorspace);
-        if (upipe_sws->output_color_range != -1)
-            out_full = upipe_sws->output_color_range;
-
-        if (unlikely(sws_setColorspaceDetails(upipe_sws->convert_ctx[i],
-                        inv_table, in_full, table, out_full,
-                        brightness, contrast, saturation) < 0)) {
-            upipe_warn(upipe, "unable to set color space data");
-            upipe_sws->colorspace_invalid = true;
+        upipe_sws_split(upipe, i, input_vsize >> !!i, output_vsize >> !!i);
+        for (int j = 0; j < upipe_sws->nb_bands; j++) {
+            struct upipe_sws_band *band = &upipe_sws->bands[j];
+            if (!band->output_vsize[i])
+                continue;
+
+            band->convert_ctx[i] = sws_getCachedContext(band->convert_ctx[i],
+                        input_hsize, band->input_vsize[i],
+                        upipe_sws->input_pix_fmt,
+                        output_hsize, band->output_vsize[i],
+                        upipe_sws->output_pix_fmt,
+                        upipe_sws->flags, NULL, NULL, NULL);
+
+            if (unlikely(band->convert_ctx[i] == NULL)) {
+                upipe_err(upipe, "sws_getContext failed");
+                uref_free(uref);
+                return true;
+            }
+
+            upipe_sws_set_colorspace(upipe, band->convert_ctx[i]);
         }
     }
 
@@ -324,14 +701,12 @@ static bool upipe_sws_handle(struct upipe *upipe, struct uref *uref,
     /* fire ! */
     int ret = 0, ret2 = 1;
     if (progressive) {
-        ret = sws_scale(upipe_sws->convert_ctx[0],
-                        input_planes, input_strides, 0, input_vsize,
-                        output_planes, output_strides);
+        ret = upipe_sws_scale(upipe, 0, input_planes, input_strides,
+                              output_planes, output_strides);
     }
     else {
-        ret = sws_scale(upipe_sws->convert_ctx[1],
-                        input_planes, input_strides, 0, (input_vsize+1)/2,
-                        output_planes, output_strides);
+        ret = upipe_sws_scale(upipe, 1, input_planes, input_strides,
+                              output_planes, output_strides);
 
         for (i = 0; i < UPIPE_AV_MAX_PLANES && input_planes[i]; i++) {
                 input_planes[i] += input_strides[i] >> 1;
@@ -340,9 +715,8 @@ static bool upipe_sws_handle(struct upipe *upipe, struct uref *uref,
                 output_planes[i] += output_strides[i] >> 1;
         }
 
-        ret2 = sws_scale(upipe_sws->convert_ctx[2],
-                         input_planes, input_strides, 0, input_vsize/2,
-                         output_planes, output_strides);
+        ret2 = upipe_sws_scale(upipe, 2, input_planes, input_strides,
+                               output_planes, output_strides);
     }
 
     /* unmap pictures */
@@ -517,17 +891,8 @@ static int upipe_sws_set_flow_def(struct upipe *upipe, struct uref *flow_def)
         }
     }
 
-    if (upipe_sws->input_pix_fmt == AV_PIX_FMT_YUV420P) {
-        av_opt_set_int(upipe_sws->convert_ctx[0], "src_v_chr_pos", 128, 0);
-        av_opt_set_int(upipe_sws->convert_ctx[1], "src_v_chr_pos", 64, 0);
-        av_opt_set_int(upipe_sws->convert_ctx[2], "src_v_chr_pos", 192, 0);
-    }
-
-    if (upipe_sws->output_pix_fmt == AV_PIX_FMT_YUV420P) {
-        av_opt_set_int(upipe_sws->convert_ctx[0], "dst_v_chr_pos", 128, 0);
-        av_opt_set_int(upipe_sws->convert_ctx[1], "dst_v_chr_pos", 64, 0);
-        av_opt_set_int(upipe_sws->convert_ctx[2], "dst_v_chr_pos", 192, 0);
-    }
+    for (int i = 0; i < upipe_sws->nb_bands; i++)
+        upipe_sws_band_set_chroma_pos(upipe, &upipe_sws->bands[i]);
     upipe_sws->colorspace_invalid = false;
 
     upipe_input(upipe, flow_def, NULL);
@@ -561,6 +926,63 @@ static int _upipe_sws_set_flags(struct upipe *upipe, int flags)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This gets the number of threads.
+ *
+ * @param upipe description structure of the pipe
+ * @param threads_p filled in with the number of threads
+ * @return an error code
+ */
+static int _upipe_sws_get_threads(struct upipe *upipe,
+                                  unsigned int *threads_p)
+{
+    struct upipe_sws *upipe_sws = upipe_sws_from_upipe(upipe);
+    *threads_p = upipe_sws->nb_bands;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the number of threads, and (re)starts the workers.
+ *
+ * @param upipe description structure of the pipe
+ * @param threads number of threads
+ * @return an error code
+ */
+static int _upipe_sws_set_threads(struct upipe *upipe, unsigned int threads)
+{
+    struct upipe_sws *upipe_sws = upipe_sws_from_upipe(upipe);
+    if (unlikely(!threads))
+        return UBASE_ERR_INVALID;
+    if (threads == upipe_sws->nb_bands)
+        return UBASE_ERR_NONE;
+
+    upipe_sws_stop_workers(upipe);
+
+    if (threads > upipe_sws->nb_bands) {
+        struct upipe_sws_band *bands = realloc(upipe_sws->bands,
+                threads * sizeof(struct upipe_sws_band));
+        if (unlikely(bands == NULL)) {
+            upipe_sws_start_workers(upipe);
+            return UBASE_ERR_ALLOC;
+        }
+        upipe_sws->bands = bands;
+        for (int i = upipe_sws->nb_bands; i < threads; i++) {
+            if (unlikely(!ubase_check(upipe_sws_band_init(upipe,
+                                                          &bands[i])))) {
+                for (i--; i >= upipe_sws->nb_bands; i--)
+                    upipe_sws_band_clean(&bands[i]);
+                upipe_sws_start_workers(upipe);
+                return UBASE_ERR_ALLOC;
+            }
+        }
+    } else {
+        for (int i = threads; i < upipe_sws->nb_bands; i++)
+            upipe_sws_band_clean(&upipe_sws->bands[i]);
+    }
+
+    upipe_sws->nb_bands = threads;
+    upipe_dbg_va(upipe, "using %u threads", threads);
+    return upipe_sws_start_workers(upipe);
+}
+
 /** @internal @This processes control commands on a file source pipe, and
  * checks the status of the pipe afterwards.
  *
@@ -616,6 +1038,16 @@ static int upipe_sws_control(struct upipe *upipe, int command, va_list args)
             int flags = va_arg(args, int);
             return _upipe_sws_set_flags(upipe, flags);
         }
+        case UPIPE_SWS_GET_THREADS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_SWS_SIGNATURE)
+            unsigned int *threads_p = va_arg(args, unsigned int *);
+            return _upipe_sws_get_threads(upipe, threads_p);
+        }
+        case UPIPE_SWS_SET_THREADS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_SWS_SIGNATURE)
+            unsigned int threads = va_arg(args, unsigned int);
+            return _upipe_sws_set_threads(upipe, threads);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -655,13 +1087,23 @@ static struct upipe *upipe_sws_alloc(struct upipe_mgr *mgr,
     upipe_sws_init_flow_def(upipe);
     upipe_sws_init_input(upipe);
     upipe_sws->colorspace_invalid = false;
-
-    memset(upipe_sws->convert_ctx, 0, sizeof(upipe_sws->convert_ctx));
-    for (int i = 0; i < 3; i++) {
-        upipe_sws->convert_ctx[i] = sws_alloc_context();
-        if (!upipe_sws->convert_ctx[i])
-            goto fail;
+    upipe_sws->input_pix_fmt = AV_PIX_FMT_NONE;
+
+    upipe_sws->job = 0;
+    upipe_sws->pending = 0;
+    upipe_sws->exit = false;
+    upipe_sws->nb_bands = 1;
+    upipe_sws->bands = malloc(sizeof(struct upipe_sws_band));
+    if (unlikely(upipe_sws->bands == NULL))
+        goto fail;
+    if (unlikely(!ubase_check(upipe_sws_band_init(upipe,
+                                                  upipe_sws->bands)))) {
+        free(upipe_sws->bands);
+        goto fail;
     }
+    pthread_mutex_init(&upipe_sws->lock, NULL);
+    pthread_cond_init(&upipe_sws->job_cond, NULL);
+    pthread_cond_init(&upipe_sws->done_cond, NULL);
 
     upipe_sws->flags = SWS_FULL_CHR_H_INP | SWS_ACCURATE_RND | SWS_LANCZOS;
 
@@ -676,11 +1118,6 @@ static struct upipe *upipe_sws_alloc(struct upipe_mgr *mgr,
     return upipe;
 
 fail:
-    for (int i = 0; i < 3; i++) {
-        if (likely(upipe_sws->convert_ctx[i]))
-            sws_freeContext(upipe_sws->convert_ctx[i]);
-        upipe_sws->convert_ctx[i] = NULL;
-    }
     uref_free(flow_def);
     upipe_sws_free_flow(upipe);
     return NULL;
@@ -693,11 +1130,13 @@ fail:
 static void upipe_sws_free(struct upipe *upipe)
 {
     struct upipe_sws *upipe_sws = upipe_sws_from_upipe(upipe);
-    for (int i = 0; i < 3; i++) {
-        if (likely(upipe_sws->convert_ctx[i]))
-            sws_freeContext(upipe_sws->convert_ctx[i]);
-        upipe_sws->convert_ctx[i] = NULL;
-    }
+    upipe_sws_stop_workers(upipe);
+    for (int i = 0; i < upipe_sws->nb_bands; i++)
+        upipe_sws_band_clean(&upipe_sws->bands[i]);
+    free(upipe_sws->bands);
+    pthread_cond_destroy(&upipe_sws->done_cond);
+    pthread_cond_destroy(&upipe_sws->job_cond);
+    pthread_mutex_destroy(&upipe_sws->lock);
 
     upipe_throw_dead(upipe);
     upipe_sws_clean_input(upipe);
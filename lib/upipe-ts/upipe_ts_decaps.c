@@ -37,11 +37,13 @@
 #include <upipe/upipe_helper_void.h>
 #include <upipe/upipe_helper_output.h>
 #include <upipe-ts/upipe_ts_decaps.h>
+#include <upipe-ts/uref_ts_vector.h>
 
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdarg.h>
 #include <string.h>
+#include <inttypes.h>
 #include <assert.h>
 
 #include <bitstream/mpeg/ts.h>
@@ -103,7 +105,208 @@ static struct upipe *upipe_ts_decaps_alloc(struct upipe_mgr *mgr,
     return upipe;
 }
 
-/** @internal @This parses and removes the TS header of a packet.
+/** @internal @This checks whether the payload of a packet is identical to
+ * the payload of the previous packet.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param offset offset of the payload in the uref
+ * @param size size of the payload
+ * @param last_offset offset of the previous payload in the same uref, or -1
+ * if it is stored in last_uref
+ * @param last_size size of the previous payload
+ * @return true if the packet is a duplicate
+ */
+static bool upipe_ts_decaps_duplicate(struct upipe *upipe, struct uref *uref,
+                                      int offset, int size,
+                                      int last_offset, int last_size)
+{
+    struct upipe_ts_decaps *upipe_ts_decaps = upipe_ts_decaps_from_upipe(upipe);
+    struct uref *last_uref = uref;
+    if (last_offset == -1) {
+        size_t uref_size;
+        if (upipe_ts_decaps->last_uref == NULL ||
+            !ubase_check(uref_block_size(upipe_ts_decaps->last_uref,
+                                         &uref_size)))
+            return false;
+        last_uref = upipe_ts_decaps->last_uref;
+        last_offset = 0;
+        last_size = uref_size;
+    }
+    if (size != last_size)
+        return false;
+
+    uint8_t payload[TS_SIZE], last_payload[TS_SIZE];
+    return ubase_check(uref_block_extract(uref, offset, size, payload)) &&
+           ubase_check(uref_block_extract(last_uref, last_offset, size,
+                                          last_payload)) &&
+           !memcmp(payload, last_payload, size);
+}
+
+/** @internal @This parses and removes the TS headers of a vector of
+ * packets of the same PID. The payloads of consecutive packets are gathered
+ * in a single uref pointing to the original buffer, until a packet needs
+ * its own flags.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param packets number of TS packets in the vector
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_ts_decaps_input_vector(struct upipe *upipe,
+                                         struct uref *uref,
+                                         unsigned int packets,
+                                         struct upump **upump_p)
+{
+    struct upipe_ts_decaps *upipe_ts_decaps = upipe_ts_decaps_from_upipe(upipe);
+    uref_ts_vector_delete_packets(uref);
+    uref_ts_vector_delete_pids(uref);
+
+    struct uref *output = NULL;
+    bool discontinuity_pending = false;
+    int last_offset = -1, last_size = 0;
+    for (unsigned int i = 0; i < packets; i++) {
+        int offset = i * TS_SIZE;
+        uint8_t buffer[TS_HEADER_SIZE_PCR];
+        const uint8_t *ts_header = uref_block_peek(uref, offset,
+                                                   TS_HEADER_SIZE_PCR, buffer);
+        if (unlikely(ts_header == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            break;
+        }
+        bool transporterror = ts_get_transporterror(ts_header);
+        bool unitstart = ts_get_unitstart(ts_header);
+        uint8_t cc = ts_get_cc(ts_header);
+        bool has_payload = ts_has_payload(ts_header);
+        bool has_adaptation = ts_has_adaptation(ts_header);
+        bool discontinuity = upipe_ts_decaps->last_cc == -1;
+        bool valid = true, has_pcr = false;
+        uint64_t pcrval = 0;
+        int header_size = TS_HEADER_SIZE;
+
+        if (unlikely(has_adaptation)) {
+            uint8_t af_length = ts_get_adaptation(ts_header);
+            if (unlikely((!has_payload && af_length != 183) ||
+                         (has_payload && af_length >= 183))) {
+                upipe_warn(upipe, "invalid adaptation field received");
+                /* keep invalid packets with a 0-length payload because
+                 * it is a common error in the field */
+                valid = has_payload && af_length == 183;
+            }
+
+            if (valid && af_length) {
+                if (unlikely(!discontinuity &&
+                             tsaf_has_discontinuity(ts_header))) {
+                    upipe_warn(upipe, "discontinuity flagged");
+                    discontinuity = true;
+                }
+                if (tsaf_has_pcr(ts_header)) {
+                    has_pcr = true;
+                    pcrval = tsaf_get_pcr(ts_header) * 300 +
+                             tsaf_get_pcrext(ts_header);
+                    pcrval *= UCLOCK_FREQ / 27000000;
+                }
+            }
+            header_size += 1 + af_length;
+        }
+        UBASE_FATAL(upipe, uref_block_peek_unmap(uref, offset, buffer,
+                                                 ts_header))
+        if (unlikely(!valid))
+            continue;
+
+        if (unlikely(has_pcr)) {
+            /* the packet carrying the PCR starts a new output */
+            if (output != NULL) {
+                upipe_ts_decaps_output(upipe, output, upump_p);
+                output = NULL;
+            }
+            uref_clock_set_ref(uref);
+            upipe_throw_clock_ref(upipe, uref, pcrval, discontinuity ? 1 : 0);
+            uref_clock_delete_ref(uref);
+        }
+
+        int payload_offset = offset + header_size;
+        int payload_size = TS_SIZE - header_size;
+        if (unlikely(ts_check_duplicate(cc, upipe_ts_decaps->last_cc))) {
+            if (!has_payload)
+                /* padding or just PCR */
+                continue;
+            if (upipe_ts_decaps_duplicate(upipe, uref,
+                        payload_offset, payload_size,
+                        last_offset, last_size)) {
+                upipe_dbg(upipe, "removing duplicate packet");
+                continue;
+            }
+            upipe_warn_va(upipe, "potentially lost 16 packets");
+            discontinuity = true;
+        }
+
+        if (unlikely(!discontinuity &&
+                     ts_check_discontinuity(cc, upipe_ts_decaps->last_cc))) {
+            upipe_warn_va(upipe, "potentially lost %d packets",
+                          (0x10 + cc - upipe_ts_decaps->last_cc - 1) & 0xf);
+            discontinuity = true;
+        }
+        upipe_ts_decaps->last_cc = cc;
+
+        discontinuity_pending = discontinuity_pending || discontinuity;
+        if (unlikely(!has_payload || !payload_size))
+            continue;
+
+        if (output != NULL &&
+            (unitstart || discontinuity_pending || transporterror)) {
+            upipe_ts_decaps_output(upipe, output, upump_p);
+            output = NULL;
+        }
+
+        if (output == NULL) {
+            output = uref_block_splice(uref, payload_offset, payload_size);
+            if (unlikely(output == NULL)) {
+                upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+                break;
+            }
+            if (unlikely(discontinuity_pending))
+                uref_flow_set_discontinuity(output);
+            if (unlikely(unitstart))
+                uref_block_set_start(output);
+            if (unlikely(transporterror))
+                uref_flow_set_error(output);
+            if (unlikely(has_pcr))
+                uref_clock_set_ref(output);
+            discontinuity_pending = false;
+        } else {
+            struct ubuf *ubuf = ubuf_block_splice(uref->ubuf, payload_offset,
+                                                  payload_size);
+            if (unlikely(ubuf == NULL ||
+                         !ubase_check(uref_block_append(output, ubuf)))) {
+                if (ubuf != NULL)
+                    ubuf_free(ubuf);
+                upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+                break;
+            }
+        }
+        last_offset = payload_offset;
+        last_size = payload_size;
+
+        if (unlikely(transporterror)) {
+            /* do not propagate the error flag to the next packets */
+            upipe_ts_decaps_output(upipe, output, upump_p);
+            output = NULL;
+        }
+    }
+
+    if (output != NULL)
+        upipe_ts_decaps_output(upipe, output, upump_p);
+    if (last_offset != -1) {
+        uref_free(upipe_ts_decaps->last_uref);
+        upipe_ts_decaps->last_uref = uref_block_splice(uref, last_offset,
+                                                       last_size);
+    }
+    uref_free(uref);
+}
+
+/** @internal @This parses and removes the TS header of a packet, or of a
+ * vector of packets.
  *
  * @param upipe description structure of the pipe
  * @param uref uref structure
@@ -113,6 +316,21 @@ static void upipe_ts_decaps_input(struct upipe *upipe, struct uref *uref,
                                   struct upump **upump_p)
 {
     struct upipe_ts_decaps *upipe_ts_decaps = upipe_ts_decaps_from_upipe(upipe);
+    uint64_t packets;
+    if (unlikely(ubase_check(uref_ts_vector_get_packets(uref, &packets)))) {
+        size_t size;
+        if (unlikely(!packets || packets > UINT16_MAX ||
+                     !ubase_check(uref_block_size(uref, &size)) ||
+                     size != packets * TS_SIZE)) {
+            upipe_warn_va(upipe, "invalid vector of %"PRIu64" TS packets, "
+                          "dropping", packets);
+            uref_free(uref);
+            return;
+        }
+        upipe_ts_decaps_input_vector(upipe, uref, packets, upump_p);
+        return;
+    }
+
     uint8_t buffer[TS_HEADER_SIZE];
     const uint8_t *ts_header = uref_block_peek(uref, 0, TS_HEADER_SIZE,
                                                buffer);
@@ -36,17 +36,19 @@
 #include <upipe/upipe_helper_output.h>
 #include <upipe/upipe_helper_subpipe.h>
 #include <upipe-ts/uref_ts_flow.h>
+#include <upipe-ts/uref_ts_vector.h>
 #include <upipe-ts/upipe_ts_split.h>
 
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdarg.h>
 #include <string.h>
+#include <inttypes.h>
 #include <assert.h>
 
 #include <bitstream/mpeg/ts.h>
 
-/** we only accept blocks containing exactly one TS packet */
+/** we only accept blocks containing TS packets */
 #define EXPECTED_FLOW_DEF "block.mpegts."
 /** maximum number of PIDs */
 #define MAX_PIDS 8192
@@ -57,6 +59,8 @@ struct upipe_ts_split_pid {
     struct uchain subs;
     /** true if we asked for this PID */
     bool set;
+    /** first packet of this PID in the vector being split, or -1 */
+    int first;
 };
 
 /** @internal @This is the private context of a ts split pipe. */
@@ -270,6 +274,7 @@ static struct upipe *upipe_ts_split_alloc(struct upipe_mgr *mgr,
     for (i = 0; i < MAX_PIDS; i++) {
         ulist_init(&upipe_ts_split->pids[i].subs);
         upipe_ts_split->pids[i].set = false;
+        upipe_ts_split->pids[i].first = -1;
     }
     upipe_throw_ready(upipe);
     return upipe;
@@ -338,27 +343,18 @@ static void upipe_ts_split_pid_unset(struct upipe *upipe, uint16_t pid,
     upipe_ts_split_pid_check(upipe, pid);
 }
 
-/** @internal @This demuxes a TS packet to the appropriate output(s).
+/** @internal @This outputs TS packets of a given PID to the appropriate
+ * output(s).
  *
  * @param upipe description structure of the pipe
  * @param uref uref structure
+ * @param pid PID of the packets
  * @param upump_p reference to pump that generated the buffer
  */
-static void upipe_ts_split_input(struct upipe *upipe, struct uref *uref,
-                                 struct upump **upump_p)
+static void upipe_ts_split_output(struct upipe *upipe, struct uref *uref,
+                                  uint16_t pid, struct upump **upump_p)
 {
     struct upipe_ts_split *upipe_ts_split = upipe_ts_split_from_upipe(upipe);
-    uint8_t buffer[TS_HEADER_SIZE];
-    const uint8_t *ts_header = uref_block_peek(uref, 0, TS_HEADER_SIZE,
-                                               buffer);
-    if (unlikely(ts_header == NULL)) {
-        uref_free(uref);
-        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
-        return;
-    }
-    uint16_t pid = ts_get_pid(ts_header);
-    UBASE_FATAL(upipe, uref_block_peek_unmap(uref, 0, buffer, ts_header))
-
     struct uchain *uchain;
     ulist_foreach (&upipe_ts_split->pids[pid].subs, uchain) {
         struct upipe_ts_split_sub *output =
@@ -384,6 +380,146 @@ static void upipe_ts_split_input(struct upipe *upipe, struct uref *uref,
         uref_free(uref);
 }
 
+/** @internal @This demuxes a vector of TS packets to the appropriate
+ * output(s). The packets of each PID are gathered in a single uref, pointing
+ * to the original buffer.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param packets number of TS packets in the vector
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_ts_split_input_vector(struct upipe *upipe, struct uref *uref,
+                                        unsigned int packets,
+                                        struct upump **upump_p)
+{
+    struct upipe_ts_split *upipe_ts_split = upipe_ts_split_from_upipe(upipe);
+    uint16_t pids[packets];
+    const uint8_t *index;
+    size_t index_size;
+    if (ubase_check(uref_ts_vector_get_pids(uref, &index, &index_size)) &&
+        index_size == 2 * packets) {
+        for (unsigned int i = 0; i < packets; i++)
+            pids[i] = uref_ts_vector_pid(index, i);
+    } else {
+        for (unsigned int i = 0; i < packets; i++) {
+            uint8_t buffer[TS_HEADER_SIZE];
+            const uint8_t *ts_header = uref_block_peek(uref, i * TS_SIZE,
+                                                       TS_HEADER_SIZE, buffer);
+            if (unlikely(ts_header == NULL)) {
+                uref_free(uref);
+                upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+                return;
+            }
+            pids[i] = ts_get_pid(ts_header);
+            UBASE_FATAL(upipe, uref_block_peek_unmap(uref, i * TS_SIZE,
+                                                     buffer, ts_header))
+        }
+    }
+    /* outputs only carry packets of a single PID */
+    uref_ts_vector_delete_pids(uref);
+
+    /* chain the packets of the same PID */
+    int next[packets];
+    for (int i = packets - 1; i >= 0; i--) {
+        next[i] = upipe_ts_split->pids[pids[i]].first;
+        upipe_ts_split->pids[pids[i]].first = i;
+    }
+
+    for (int i = 0; i < (int)packets; i++) {
+        uint16_t pid = pids[i];
+        if (upipe_ts_split->pids[pid].first != i)
+            continue;
+        upipe_ts_split->pids[pid].first = -1;
+        if (ulist_empty(&upipe_ts_split->pids[pid].subs))
+            continue;
+
+        struct uref *output = NULL;
+        uint64_t output_packets = 0;
+        int j = i;
+        while (j != -1) {
+            int start = j;
+            while (next[j] == j + 1)
+                j++;
+            int offset = start * TS_SIZE;
+            int size = (j - start + 1) * TS_SIZE;
+            output_packets += j - start + 1;
+            if (start == 0 && size == packets * TS_SIZE) {
+                /* the whole vector belongs to the same PID */
+                output = uref;
+                uref = NULL;
+            } else if (output == NULL) {
+                output = uref_block_splice(uref, offset, size);
+                if (unlikely(output == NULL))
+                    break;
+            } else {
+                struct ubuf *ubuf = ubuf_block_splice(uref->ubuf, offset,
+                                                      size);
+                if (unlikely(ubuf == NULL ||
+                             !ubase_check(uref_block_append(output, ubuf)))) {
+                    if (ubuf != NULL)
+                        ubuf_free(ubuf);
+                    uref_free(output);
+                    output = NULL;
+                    break;
+                }
+            }
+            j = next[j];
+        }
+
+        if (unlikely(output == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            continue;
+        }
+        if (output_packets > 1)
+            UBASE_ERROR(upipe, uref_ts_vector_set_packets(output,
+                                                          output_packets))
+        else
+            uref_ts_vector_delete_packets(output);
+        upipe_ts_split_output(upipe, output, pid, upump_p);
+    }
+    if (uref != NULL)
+        uref_free(uref);
+}
+
+/** @internal @This demuxes a TS packet, or a vector of TS packets, to the
+ * appropriate output(s).
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_ts_split_input(struct upipe *upipe, struct uref *uref,
+                                 struct upump **upump_p)
+{
+    uint64_t packets;
+    if (unlikely(ubase_check(uref_ts_vector_get_packets(uref, &packets)))) {
+        size_t size;
+        if (unlikely(!packets || packets > UINT16_MAX ||
+                     !ubase_check(uref_block_size(uref, &size)) ||
+                     size != packets * TS_SIZE)) {
+            upipe_warn_va(upipe, "invalid vector of %"PRIu64" TS packets, "
+                          "dropping", packets);
+            uref_free(uref);
+            return;
+        }
+        upipe_ts_split_input_vector(upipe, uref, packets, upump_p);
+        return;
+    }
+
+    uint8_t buffer[TS_HEADER_SIZE];
+    const uint8_t *ts_header = uref_block_peek(uref, 0, TS_HEADER_SIZE,
+                                               buffer);
+    if (unlikely(ts_header == NULL)) {
+        uref_free(uref);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
+    uint16_t pid = ts_get_pid(ts_header);
+    UBASE_FATAL(upipe, uref_block_peek_unmap(uref, 0, buffer, ts_header))
+    upipe_ts_split_output(upipe, uref, pid, upump_p);
+}
+
 /** @internal @This sets the input flow definition.
  *
  * @param upipe description structure of the pipe
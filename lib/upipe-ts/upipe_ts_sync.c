@@ -46,6 +46,7 @@
 #include <upipe/upipe_helper_output.h>
 #include <upipe/upipe_helper_output_size.h>
 #include <upipe-ts/upipe_ts_sync.h>
+#include <upipe-ts/uref_ts_vector.h>
 
 #include <stdlib.h>
 #include <stdbool.h>
@@ -57,6 +58,8 @@
 
 /** default number of packets to sync with */
 #define DEFAULT_TS_SYNC 2
+/** maximum number of packets in a vector */
+#define MAX_TS_VECTOR 1024
 /** we only accept blocks */
 #define EXPECTED_FLOW_DEF "block."
 /** when configured with standard TS size, we output TS packets */
@@ -84,6 +87,8 @@ struct upipe_ts_sync {
     size_t output_size;
     /** number of packets to sync with */
     unsigned int ts_sync;
+    /** maximum number of packets per output uref */
+    unsigned int vector;
     /** next uref to be processed */
     struct uref *next_uref;
     /** original size of the next uref */
@@ -129,6 +134,7 @@ static struct upipe *upipe_ts_sync_alloc(struct upipe_mgr *mgr,
     upipe_ts_sync_init_output(upipe);
     upipe_ts_sync_init_output_size(upipe, TS_SIZE);
     upipe_ts_sync->ts_sync = DEFAULT_TS_SYNC;
+    upipe_ts_sync->vector = 1;
     upipe_ts_sync->next_uref = NULL;
     ulist_init(&upipe_ts_sync->urefs);
     upipe_throw_ready(upipe);
@@ -146,35 +152,81 @@ static struct upipe *upipe_ts_sync_alloc(struct upipe_mgr *mgr,
 static bool upipe_ts_sync_check(struct upipe *upipe, size_t *offset_p)
 {
     struct upipe_ts_sync *upipe_ts_sync = upipe_ts_sync_from_upipe(upipe);
-    for ( ; ; ) {
-        if (unlikely(!ubase_check(uref_block_scan(upipe_ts_sync->next_uref,
-                                                  offset_p, TS_SYNC))))
-            return false;
-
-        /* first octet at *offset_p is a sync word */
-        int ts_sync = upipe_ts_sync->ts_sync - 1;
-        for (int offset = *offset_p + upipe_ts_sync->output_size; ts_sync;
-             ts_sync--, offset += upipe_ts_sync->output_size) {
-            const uint8_t *buffer;
-            int size = 1;
-            uint8_t word;
-            if (unlikely(!ubase_check(uref_block_read(upipe_ts_sync->next_uref,
-                                          offset, &size, &buffer))))
-                /* not enough sync words could be tested */
-                return false;
-            assert(size == 1);
-            word = *buffer;
-            uref_block_unmap(upipe_ts_sync->next_uref, offset);
-            if (word != TS_SYNC) {
-                *offset_p += 1;
-                break;
-            }
+    return ubase_check(uref_block_scan_sync(upipe_ts_sync->next_uref,
+                offset_p, TS_SYNC, upipe_ts_sync->output_size,
+                upipe_ts_sync->ts_sync));
+}
+
+/** @internal @This counts the number of TS packets that may be output at
+ * once in vector mode. The first packet has already been checked by
+ * @ref upipe_ts_sync_check; each following packet must also be followed by
+ * the configured number of sync words.
+ *
+ * @param upipe description structure of the pipe
+ * @return number of packets to output
+ */
+static unsigned int upipe_ts_sync_count(struct upipe *upipe)
+{
+    struct upipe_ts_sync *upipe_ts_sync = upipe_ts_sync_from_upipe(upipe);
+    if (upipe_ts_sync->output_size != TS_SIZE)
+        return 1;
+
+    unsigned int packets = 1;
+    struct ubuf_block_cursor cursor;
+    if (!ubase_check(ubuf_block_cursor_init(&cursor,
+                    upipe_ts_sync->next_uref->ubuf,
+                    upipe_ts_sync->ts_sync * upipe_ts_sync->output_size)))
+        return packets;
+
+    /* check the sync words of a whole segment per mapping */
+    while (packets < upipe_ts_sync->vector &&
+           !ubuf_block_cursor_end(&cursor)) {
+        const uint8_t *buffer;
+        int size = -1;
+        if (!ubase_check(ubuf_block_cursor_read(&cursor, &size, &buffer)))
+            break;
+        int offset = 0;
+        while (offset < size && packets < upipe_ts_sync->vector &&
+               buffer[offset] == TS_SYNC) {
+            packets++;
+            offset += upipe_ts_sync->output_size;
         }
-        if (!ts_sync)
+        ubuf_block_cursor_unmap(&cursor);
+        if (offset < size ||
+            !ubase_check(ubuf_block_cursor_skip(&cursor, offset)))
             break;
     }
+    return packets;
+}
 
-    return true;
+/** @internal @This attaches the PID index to a vector of TS packets.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref vector of TS packets
+ * @param packets number of packets in the vector
+ */
+static void upipe_ts_sync_index(struct upipe *upipe, struct uref *uref,
+                                unsigned int packets)
+{
+    uint8_t pids[2 * packets];
+    struct ubuf_block_cursor cursor;
+    UBASE_FATAL_RETURN(upipe, ubuf_block_cursor_init(&cursor, uref->ubuf, 0))
+    for (unsigned int i = 0; i < packets; i++) {
+        uint8_t buffer[TS_HEADER_SIZE];
+        const uint8_t *ts_header = ubuf_block_cursor_peek(&cursor,
+                                                          TS_HEADER_SIZE,
+                                                          buffer);
+        if (unlikely(ts_header == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
+        uref_ts_vector_set_pid(pids, i, ts_get_pid(ts_header));
+        ubuf_block_cursor_peek_unmap(&cursor, buffer, ts_header);
+        if (i + 1 < packets)
+            UBASE_FATAL_RETURN(upipe, ubuf_block_cursor_skip(&cursor, TS_SIZE))
+    }
+    UBASE_FATAL(upipe, uref_ts_vector_set_packets(uref, packets))
+    UBASE_FATAL(upipe, uref_ts_vector_set_pids(uref, pids, 2 * packets))
 }
 
 /** @internal @This flushes all input buffers.
@@ -235,12 +287,17 @@ static void upipe_ts_sync_input(struct upipe *upipe, struct uref *uref,
 
         /* upipe_ts_sync_check said there is at least one TS packet there. */
         upipe_ts_sync_sync_acquired(upipe);
+        unsigned int packets = 1;
+        if (upipe_ts_sync->vector > 1)
+            packets = upipe_ts_sync_count(upipe);
         struct uref *output = upipe_ts_sync_extract_uref_stream(upipe,
-                                                    upipe_ts_sync->output_size);
+                                        packets * upipe_ts_sync->output_size);
         if (unlikely(output == NULL)) {
             upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
             continue;
         }
+        if (packets > 1)
+            upipe_ts_sync_index(upipe, output, packets);
         upipe_ts_sync_output(upipe, output, upump_p);
     }
 }
@@ -302,6 +359,39 @@ static int _upipe_ts_sync_set_sync(struct upipe *upipe, int sync)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This returns the maximum number of packets per output uref.
+ *
+ * @param upipe description structure of the pipe
+ * @param vector_p filled in with the maximum number of packets
+ * @return an error code
+ */
+static int _upipe_ts_sync_get_vector(struct upipe *upipe,
+                                     unsigned int *vector_p)
+{
+    struct upipe_ts_sync *upipe_ts_sync = upipe_ts_sync_from_upipe(upipe);
+    assert(vector_p != NULL);
+    *vector_p = upipe_ts_sync->vector;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the maximum number of packets per output uref.
+ * With a value greater than 1 (vector mode), consecutive TS packets are
+ * output in a single uref carrying a PID index, which is only understood by
+ * ts_split and ts_decaps. The default value is 1.
+ *
+ * @param upipe description structure of the pipe
+ * @param vector maximum number of packets
+ * @return an error code
+ */
+static int _upipe_ts_sync_set_vector(struct upipe *upipe, unsigned int vector)
+{
+    struct upipe_ts_sync *upipe_ts_sync = upipe_ts_sync_from_upipe(upipe);
+    if (vector < 1 || vector > MAX_TS_VECTOR)
+        return UBASE_ERR_INVALID;
+    upipe_ts_sync->vector = vector;
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands on a ts sync pipe.
  *
  * @param upipe description structure of the pipe
@@ -358,6 +448,16 @@ static int upipe_ts_sync_control(struct upipe *upipe,
             int sync = va_arg(args, int);
             return _upipe_ts_sync_set_sync(upipe, sync);
         }
+        case UPIPE_TS_SYNC_GET_VECTOR: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_SYNC_SIGNATURE)
+            unsigned int *vector_p = va_arg(args, unsigned int *);
+            return _upipe_ts_sync_get_vector(upipe, vector_p);
+        }
+        case UPIPE_TS_SYNC_SET_VECTOR: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_SYNC_SIGNATURE)
+            unsigned int vector = va_arg(args, unsigned int);
+            return _upipe_ts_sync_set_vector(upipe, vector);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -0,0 +1,665 @@
+/*
+ * V210 decoder
+ *
+ * Copyright (C) 2009 Michael Niedermayer <michaelni@gmx.at>
+ * Copyright (c) 2009 Baptiste Coudurier <baptiste dot coudurier at gmail dot com>
+ * Copyright (c) 2015 Open Broadcast Systems Ltd
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * This file is based on the implementation in FFmpeg.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/** @file
+ * @short Upipe v210dec module
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/uprobe.h>
+#include <upipe/uref.h>
+#include <upipe/ubuf.h>
+#include <upipe/uref_pic_flow.h>
+#include <upipe/uref_pic.h>
+#include <upipe/upipe.h>
+#include <upipe/uref_flow.h>
+#include <upipe/uref_dump.h>
+#include <upipe/upipe_helper_upipe.h>
+#include <upipe/upipe_helper_urefcount.h>
+#include <upipe/upipe_helper_void.h>
+#include <upipe/upipe_helper_ubuf_mgr.h>
+#include <upipe/upipe_helper_output.h>
+#include <upipe/upipe_helper_input.h>
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <string.h>
+#include <assert.h>
+
+#include <upipe-v210/upipe_v210dec.h>
+
+#include <libavutil/cpu.h>
+#include <libavutil/intreadwrite.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+/** @hidden */
+# define UPIPE_V210_X86
+# include <immintrin.h>
+#endif
+
+#define UPIPE_V210_MAX_PLANES 3
+/** chroma map of v210 pictures */
+#define UPIPE_V210_CHROMA "u10y10v10y10u10y10v10y10u10y10v10y10"
+
+/** upipe_v210dec structure with v210dec parameters */
+struct upipe_v210dec {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** ubuf manager */
+    struct ubuf_mgr *ubuf_mgr;
+    /** flow format packet */
+    struct uref *flow_format;
+    /** ubuf manager request */
+    struct urequest ubuf_mgr_request;
+
+    /** output pipe */
+    struct upipe *output;
+    /** flow_definition packet */
+    struct uref *flow_def;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** list of output requests */
+    struct uchain request_list;
+
+    /** temporary uref storage (used during urequest) */
+    struct uchain urefs;
+    /** nb urefs in storage */
+    unsigned int nb_urefs;
+    /** max urefs in storage */
+    unsigned int max_urefs;
+    /** list of blockers (used during udeal) */
+    struct uchain blockers;
+
+    /** horizontal size of the flow, or 0 to use the size of the pictures */
+    uint64_t hsize;
+
+    /** cpu flags **/
+    int cpu_flags;
+
+    /** 10-bit line unpacking function **/
+    upipe_v210dec_unpack_line_10 unpack_line_10;
+
+    /** output chroma map */
+    const char *output_chroma_map[UPIPE_V210_MAX_PLANES];
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+/** @hidden */
+static bool upipe_v210dec_handle(struct upipe *upipe, struct uref *uref,
+                                 struct upump **upump_p);
+/** @hidden */
+static int upipe_v210dec_check(struct upipe *upipe, struct uref *flow_format);
+
+UPIPE_HELPER_UPIPE(upipe_v210dec, upipe, UPIPE_V210DEC_SIGNATURE);
+UPIPE_HELPER_UREFCOUNT(upipe_v210dec, urefcount, upipe_v210dec_free);
+UPIPE_HELPER_VOID(upipe_v210dec);
+UPIPE_HELPER_OUTPUT(upipe_v210dec, output, flow_def, output_state, request_list)
+UPIPE_HELPER_UBUF_MGR(upipe_v210dec, ubuf_mgr, flow_format, ubuf_mgr_request,
+                      upipe_v210dec_check,
+                      upipe_v210dec_register_output_request,
+                      upipe_v210dec_unregister_output_request)
+UPIPE_HELPER_INPUT(upipe_v210dec, urefs, nb_urefs, max_urefs, blockers, upipe_v210dec_handle)
+
+
+#define READ_PIXELS(a, b, c)            \
+    do {                                \
+        val  = AV_RL32(src);            \
+        src += 4;                       \
+        *a++ =  val & 0x3FF;            \
+        *b++ = (val >> 10) & 0x3FF;     \
+        *c++ = (val >> 20) & 0x3FF;     \
+    } while (0)
+
+static void v210dec_planar_unpack_10_c(const uint8_t *src, uint16_t *y,
+                                       uint16_t *u, uint16_t *v,
+                                       ptrdiff_t width)
+{
+    uint32_t val;
+    int i;
+
+    for( i = 0; i < width-5; i += 6 ){
+        READ_PIXELS(u, y, v);
+        READ_PIXELS(y, u, y);
+        READ_PIXELS(v, y, u);
+        READ_PIXELS(y, v, y);
+    }
+}
+
+#ifdef UPIPE_V210_X86
+/* The 3 samples of each word are extracted, the first two in the 16-bit
+ * halves of a 32-bit lane and the third one alone, in the order
+ * u y v | y u y | v y u | y v y; the shuffles then gather the luma, and the
+ * chroma with u in the low half and v in the high half. Z zeroes a 16-bit
+ * sample and W picks one. */
+#define Z -1, -1
+#define W(n) 2 * (n), 2 * (n) + 1
+
+/** @internal @This splits 6 pixels of packed samples into luma and chroma
+ * registers.
+ */
+#define UNPACK_10(type, suffix, words, luma, chroma)                        \
+    do {                                                                    \
+        __typeof__(words) pairs = _##type##_or_si##suffix(                  \
+            _##type##_and_si##suffix(words, mask_lo),                       \
+            _##type##_and_si##suffix(_##type##_slli_epi32(words, 6),        \
+                                     mask_hi));                             \
+        __typeof__(words) thirds = _##type##_and_si##suffix(                \
+            _##type##_srli_epi32(words, 20), mask_lo);                      \
+        luma = _##type##_or_si##suffix(                                     \
+            _##type##_shuffle_epi8(pairs, luma_pairs),                      \
+            _##type##_shuffle_epi8(thirds, luma_thirds));                   \
+        chroma = _##type##_or_si##suffix(                                   \
+            _##type##_shuffle_epi8(pairs, chroma_pairs),                    \
+            _##type##_shuffle_epi8(thirds, chroma_thirds));                 \
+    } while (0)
+
+/** @internal @This is the SSSE3 implementation of the 10-bit unpacking
+ * function, handling 6 pixels per iteration.
+ */
+__attribute__((target("ssse3")))
+static void v210dec_planar_unpack_10_ssse3(const uint8_t *src, uint16_t *y,
+                                           uint16_t *u, uint16_t *v,
+                                           ptrdiff_t width)
+{
+    const __m128i luma_pairs =
+        _mm_setr_epi8(W(1), W(2), Z, W(5), W(6), Z, Z, Z);
+    const __m128i luma_thirds =
+        _mm_setr_epi8(Z, Z, W(2), Z, Z, W(6), Z, Z);
+    const __m128i chroma_pairs =
+        _mm_setr_epi8(W(0), W(3), Z, Z, Z, W(4), W(7), Z);
+    const __m128i chroma_thirds =
+        _mm_setr_epi8(Z, Z, W(4), Z, W(0), Z, Z, Z);
+    const __m128i mask_lo = _mm_set1_epi32(0x3ff);
+    const __m128i mask_hi = _mm_set1_epi32(0x3ff << 16);
+    ptrdiff_t i;
+
+    /* stores go up to 2 pixels beyond the 6 being unpacked, which are
+     * written again afterwards */
+    for (i = 0; i + 8 <= width; i += 6) {
+        __m128i luma, chroma;
+        UNPACK_10(mm, 128, _mm_loadu_si128((const __m128i *)src),
+                  luma, chroma);
+        _mm_storeu_si128((__m128i *)y, luma);
+        _mm_storel_epi64((__m128i *)u, chroma);
+        _mm_storel_epi64((__m128i *)v, _mm_unpackhi_epi64(chroma, chroma));
+        src += 16;
+        y += 6;
+        u += 3;
+        v += 3;
+    }
+    v210dec_planar_unpack_10_c(src, y, u, v, width - i);
+}
+
+/** @internal @This is the AVX2 implementation of the 10-bit unpacking
+ * function, handling 12 pixels per iteration, 6 in each lane.
+ */
+__attribute__((target("avx2")))
+static void v210dec_planar_unpack_10_avx2(const uint8_t *src, uint16_t *y,
+                                          uint16_t *u, uint16_t *v,
+                                          ptrdiff_t width)
+{
+    const __m256i luma_pairs = _mm256_broadcastsi128_si256(
+            _mm_setr_epi8(W(1), W(2), Z, W(5), W(6), Z, Z, Z));
+    const __m256i luma_thirds = _mm256_broadcastsi128_si256(
+            _mm_setr_epi8(Z, Z, W(2), Z, Z, W(6), Z, Z));
+    const __m256i chroma_pairs = _mm256_broadcastsi128_si256(
+            _mm_setr_epi8(W(0), W(3), Z, Z, Z, W(4), W(7), Z));
+    const __m256i chroma_thirds = _mm256_broadcastsi128_si256(
+            _mm_setr_epi8(Z, Z, W(4), Z, W(0), Z, Z, Z));
+    const __m256i mask_lo = _mm256_set1_epi32(0x3ff);
+    const __m256i mask_hi = _mm256_set1_epi32(0x3ff << 16);
+    ptrdiff_t i;
+
+    for (i = 0; i + 14 <= width; i += 12) {
+        __m256i luma, chroma;
+        UNPACK_10(mm256, 256, _mm256_loadu_si256((const __m256i *)src),
+                  luma, chroma);
+        __m128i chroma0 = _mm256_castsi256_si128(chroma);
+        __m128i chroma1 = _mm256_extracti128_si256(chroma, 1);
+        _mm_storeu_si128((__m128i *)y, _mm256_castsi256_si128(luma));
+        _mm_storeu_si128((__m128i *)(y + 6),
+                         _mm256_extracti128_si256(luma, 1));
+        _mm_storel_epi64((__m128i *)u, chroma0);
+        _mm_storel_epi64((__m128i *)(u + 3), chroma1);
+        _mm_storel_epi64((__m128i *)v, _mm_unpackhi_epi64(chroma0, chroma0));
+        _mm_storel_epi64((__m128i *)(v + 3),
+                         _mm_unpackhi_epi64(chroma1, chroma1));
+        src += 32;
+        y += 12;
+        u += 6;
+        v += 6;
+    }
+    v210dec_planar_unpack_10_ssse3(src, y, u, v, width - i);
+}
+
+#undef Z
+#undef W
+#endif
+
+/** @This returns the fastest 10-bit unpacking function for the given CPU
+ * flags.
+ *
+ * @param cpu_flags CPU flags, as returned by av_get_cpu_flags()
+ * @return an unpacking function
+ */
+upipe_v210dec_unpack_line_10 upipe_v210dec_select_unpack_line_10(
+        int cpu_flags)
+{
+#ifdef UPIPE_V210_X86
+    if (cpu_flags & AV_CPU_FLAG_AVX2)
+        return v210dec_planar_unpack_10_avx2;
+    if (cpu_flags & AV_CPU_FLAG_SSSE3)
+        return v210dec_planar_unpack_10_ssse3;
+#endif
+    return v210dec_planar_unpack_10_c;
+}
+
+/** @internal @This handles data.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure describing the picture
+ * @param upump_p reference to pump that generated the buffer
+ * @return false if the input must be blocked
+ */
+static bool upipe_v210dec_handle(struct upipe *upipe, struct uref *uref,
+                                 struct upump **upump_p)
+{
+    struct upipe_v210dec *upipe_v210dec = upipe_v210dec_from_upipe(upipe);
+    const char *def;
+    if (unlikely(ubase_check(uref_flow_get_def(uref, &def)))) {
+        upipe_v210dec_store_flow_def(upipe, NULL);
+        upipe_v210dec_require_ubuf_mgr(upipe, uref);
+        return true;
+    }
+
+    if (upipe_v210dec->flow_def == NULL)
+        return false;
+
+    size_t hsize, vsize;
+    if (!ubase_check(uref_pic_size(uref, &hsize, &vsize, NULL))) {
+        upipe_warn(upipe, "invalid buffer received");
+        uref_free(uref);
+        return true;
+    }
+    /* the encoder pads the lines to a multiple of 48 pixels */
+    if (upipe_v210dec->hsize && upipe_v210dec->hsize < hsize)
+        hsize = upipe_v210dec->hsize;
+
+    /* map input */
+    const uint8_t *input_plane;
+    size_t input_stride;
+    if (unlikely(!ubase_check(uref_pic_plane_read(uref, UPIPE_V210_CHROMA,
+                                                  0, 0, -1, -1,
+                                                  &input_plane)) ||
+                 !ubase_check(uref_pic_plane_size(uref, UPIPE_V210_CHROMA,
+                                                  &input_stride,
+                                                  NULL, NULL, NULL)))) {
+        upipe_warn(upipe, "invalid buffer received");
+        uref_free(uref);
+        return true;
+    }
+
+    /* allocate dest ubuf */
+    struct ubuf *ubuf = ubuf_pic_alloc(upipe_v210dec->ubuf_mgr, hsize, vsize);
+    if (unlikely(ubuf == NULL)) {
+        uref_pic_plane_unmap(uref, UPIPE_V210_CHROMA, 0, 0, -1, -1);
+        uref_free(uref);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return true;
+    }
+
+    /* map output */
+    uint8_t *output_planes[UPIPE_V210_MAX_PLANES];
+    size_t output_strides[UPIPE_V210_MAX_PLANES];
+    int i;
+    for (i = 0; i < UPIPE_V210_MAX_PLANES; i++) {
+        if (unlikely(!ubase_check(ubuf_pic_plane_write(ubuf,
+                                      upipe_v210dec->output_chroma_map[i],
+                                      0, 0, -1, -1, &output_planes[i])) ||
+                     !ubase_check(ubuf_pic_plane_size(ubuf,
+                                      upipe_v210dec->output_chroma_map[i],
+                                      &output_strides[i],
+                                      NULL, NULL, NULL)))) {
+            upipe_warn(upipe, "invalid buffer received");
+            while (--i >= 0)
+                ubuf_pic_plane_unmap(ubuf,
+                                     upipe_v210dec->output_chroma_map[i],
+                                     0, 0, -1, -1);
+            ubuf_free(ubuf);
+            uref_pic_plane_unmap(uref, UPIPE_V210_CHROMA, 0, 0, -1, -1);
+            uref_free(uref);
+            return true;
+        }
+    }
+
+    /* Do v210 unpacking */
+    size_t h;
+    for (h = 0; h < vsize; h++) {
+        const uint8_t *src = input_plane + h * input_stride;
+        uint16_t *y = (uint16_t *)(output_planes[0] + h * output_strides[0]);
+        uint16_t *u = (uint16_t *)(output_planes[1] + h * output_strides[1]);
+        uint16_t *v = (uint16_t *)(output_planes[2] + h * output_strides[2]);
+        uint32_t val;
+        size_t w = (hsize / 6) * 6;
+        upipe_v210dec->unpack_line_10(src, y, u, v, w);
+
+        y += w;
+        u += w >> 1;
+        v += w >> 1;
+        src += (w / 6) * 16;
+        if (w + 1 < hsize) {
+            READ_PIXELS(u, y, v);
+
+            val = AV_RL32(src);
+            src += 4;
+            *y++ = val & 0x3FF;
+            if (w + 3 < hsize) {
+                *u++ = (val >> 10) & 0x3FF;
+                *y++ = (val >> 20) & 0x3FF;
+
+                val = AV_RL32(src);
+                src += 4;
+                *v++ = val & 0x3FF;
+                *y++ = (val >> 10) & 0x3FF;
+            }
+        }
+    }
+
+    /* unmap pictures */
+    for (i = 0; i < UPIPE_V210_MAX_PLANES; i++)
+        ubuf_pic_plane_unmap(ubuf, upipe_v210dec->output_chroma_map[i],
+                             0, 0, -1, -1);
+    uref_pic_plane_unmap(uref, UPIPE_V210_CHROMA, 0, 0, -1, -1);
+
+    uref_attach_ubuf(uref, ubuf);
+    upipe_v210dec_output(upipe, uref, upump_p);
+    return true;
+}
+
+/** @internal @This receives incoming uref.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure describing the picture
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_v210dec_input(struct upipe *upipe, struct uref *uref,
+                                struct upump **upump_p)
+{
+    if (!upipe_v210dec_check_input(upipe)) {
+        upipe_v210dec_hold_input(upipe, uref);
+        upipe_v210dec_block_input(upipe, upump_p);
+    } else if (!upipe_v210dec_handle(upipe, uref, upump_p)) {
+        upipe_v210dec_hold_input(upipe, uref);
+        upipe_v210dec_block_input(upipe, upump_p);
+        /* Increment upipe refcount to avoid disappearing before all packets
+         * have been sent. */
+        upipe_use(upipe);
+    }
+}
+
+/** @internal @This receives a provided ubuf manager.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_format amended flow format
+ * @return an error code
+ */
+static int upipe_v210dec_check(struct upipe *upipe, struct uref *flow_format)
+{
+    struct upipe_v210dec *upipe_v210dec = upipe_v210dec_from_upipe(upipe);
+    if (flow_format != NULL)
+        upipe_v210dec_store_flow_def(upipe, flow_format);
+
+    if (upipe_v210dec->flow_def == NULL)
+        return UBASE_ERR_NONE;
+
+    bool was_buffered = !upipe_v210dec_check_input(upipe);
+    upipe_v210dec_output_input(upipe);
+    upipe_v210dec_unblock_input(upipe);
+    if (was_buffered && upipe_v210dec_check_input(upipe)) {
+        /* All packets have been output, release again the pipe that has been
+         * used in @ref upipe_v210dec_input. */
+        upipe_release(upipe);
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the input flow definition.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def flow definition packet
+ * @return an error code
+ */
+static int upipe_v210dec_set_flow_def(struct upipe *upipe, struct uref *flow_def)
+{
+    if (flow_def == NULL)
+        return UBASE_ERR_INVALID;
+
+    UBASE_RETURN(uref_flow_match_def(flow_def, "pic."))
+
+    struct upipe_v210dec *upipe_v210dec = upipe_v210dec_from_upipe(upipe);
+    struct uref *flow_def_dup;
+
+    uint8_t macropixel;
+    if (!ubase_check(uref_pic_flow_get_macropixel(flow_def, &macropixel)))
+        return UBASE_ERR_INVALID;
+
+    if (!(macropixel == 48 &&
+          ubase_check(uref_pic_flow_check_chroma(flow_def, 1, 1, 128,
+                                                 UPIPE_V210_CHROMA)))) {
+        upipe_err(upipe, "incompatible input flow def");
+        uref_dump(flow_def, upipe->uprobe);
+        return UBASE_ERR_EXTERNAL;
+    }
+
+    upipe_v210dec->hsize = 0;
+    uref_pic_flow_get_hsize(flow_def, &upipe_v210dec->hsize);
+
+    if ((flow_def_dup = uref_dup(flow_def)) == NULL)
+        return UBASE_ERR_ALLOC;
+
+    uref_pic_flow_clear_format(flow_def_dup);
+    if (unlikely(!ubase_check(uref_pic_flow_set_macropixel(flow_def_dup, 1)) ||
+                 !ubase_check(uref_pic_flow_add_plane(flow_def_dup, 1, 1, 2,
+                                  upipe_v210dec->output_chroma_map[0])) ||
+                 !ubase_check(uref_pic_flow_add_plane(flow_def_dup, 2, 1, 2,
+                                  upipe_v210dec->output_chroma_map[1])) ||
+                 !ubase_check(uref_pic_flow_add_plane(flow_def_dup, 2, 1, 2,
+                                  upipe_v210dec->output_chroma_map[2])))) {
+        uref_free(flow_def_dup);
+        return UBASE_ERR_ALLOC;
+    }
+
+    upipe_input(upipe, flow_def_dup, NULL);
+    return UBASE_ERR_NONE;
+}
+
+/** @This sets the 10-bit unpacking function.
+ *
+ * @param upipe description structure of the pipe
+ * @param unpack unpacking function
+ * @return an error code
+ */
+static inline int _upipe_v210dec_set_unpack_line_10(struct upipe *upipe,
+        upipe_v210dec_unpack_line_10 unpack)
+{
+    struct upipe_v210dec *upipe_v210dec = upipe_v210dec_from_upipe(upipe);
+    if (unlikely(!unpack)) {
+        return UBASE_ERR_INVALID;
+    }
+
+    upipe_v210dec->unpack_line_10 = unpack;
+    return UBASE_ERR_NONE;
+}
+
+/** @This gets the 10-bit unpacking function.
+ *
+ * @param upipe description structure of the pipe
+ * @param unpack_p written with the unpacking function
+ * @return an error code
+ */
+static inline int _upipe_v210dec_get_unpack_line_10(struct upipe *upipe,
+        upipe_v210dec_unpack_line_10 *unpack_p)
+{
+    struct upipe_v210dec *upipe_v210dec = upipe_v210dec_from_upipe(upipe);
+    if (unlikely(!unpack_p)) {
+        return UBASE_ERR_INVALID;
+    }
+
+    *unpack_p = upipe_v210dec->unpack_line_10;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands on a v210dec pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_v210dec_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *request = va_arg(args, struct urequest *);
+            if (request->type == UREQUEST_UBUF_MGR ||
+                request->type == UREQUEST_FLOW_FORMAT)
+                return upipe_throw_provide_request(upipe, request);
+            return upipe_v210dec_alloc_output_proxy(upipe, request);
+        }
+        case UPIPE_UNREGISTER_REQUEST: {
+            struct urequest *request = va_arg(args, struct urequest *);
+            if (request->type == UREQUEST_UBUF_MGR ||
+                request->type == UREQUEST_FLOW_FORMAT)
+                return UBASE_ERR_NONE;
+            return upipe_v210dec_free_output_proxy(upipe, request);
+        }
+
+        case UPIPE_GET_OUTPUT: {
+            struct upipe **p = va_arg(args, struct upipe **);
+            return upipe_v210dec_get_output(upipe, p);
+        }
+        case UPIPE_SET_OUTPUT: {
+            struct upipe *output = va_arg(args, struct upipe *);
+            return upipe_v210dec_set_output(upipe, output);
+        }
+        case UPIPE_GET_FLOW_DEF: {
+            struct uref **p = va_arg(args, struct uref **);
+            return upipe_v210dec_get_flow_def(upipe, p);
+        }
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow = va_arg(args, struct uref *);
+            return upipe_v210dec_set_flow_def(upipe, flow);
+        }
+
+        case UPIPE_V210DEC_SET_UNPACK_LINE_10: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_V210DEC_SIGNATURE)
+            return _upipe_v210dec_set_unpack_line_10(upipe,
+                   va_arg(args, upipe_v210dec_unpack_line_10));
+        }
+        case UPIPE_V210DEC_GET_UNPACK_LINE_10: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_V210DEC_SIGNATURE)
+            return _upipe_v210dec_get_unpack_line_10(upipe,
+                   va_arg(args, upipe_v210dec_unpack_line_10 *));
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @internal @This allocates a v210dec pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_v210dec_alloc(struct upipe_mgr *mgr,
+                                         struct uprobe *uprobe,
+                                         uint32_t signature, va_list args)
+{
+    struct upipe *upipe = upipe_v210dec_alloc_void(mgr, uprobe, signature, args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_v210dec *upipe_v210dec = upipe_v210dec_from_upipe(upipe);
+    upipe_v210dec->cpu_flags = av_get_cpu_flags();
+    upipe_v210dec->hsize = 0;
+
+    upipe_v210dec->unpack_line_10 =
+        upipe_v210dec_select_unpack_line_10(upipe_v210dec->cpu_flags);
+
+    upipe_v210dec->output_chroma_map[0] = "y10l";
+    upipe_v210dec->output_chroma_map[1] = "u10l";
+    upipe_v210dec->output_chroma_map[2] = "v10l";
+
+    upipe_v210dec_init_urefcount(upipe);
+    upipe_v210dec_init_ubuf_mgr(upipe);
+    upipe_v210dec_init_output(upipe);
+    upipe_v210dec_init_input(upipe);
+
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @This frees a upipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_v210dec_free(struct upipe *upipe)
+{
+    upipe_throw_dead(upipe);
+    upipe_v210dec_clean_input(upipe);
+    upipe_v210dec_clean_output(upipe);
+    upipe_v210dec_clean_ubuf_mgr(upipe);
+    upipe_v210dec_clean_urefcount(upipe);
+    upipe_v210dec_free_void(upipe);
+}
+
+/** module manager static descriptor */
+static struct upipe_mgr upipe_v210dec_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_V210DEC_SIGNATURE,
+
+    .upipe_alloc = upipe_v210dec_alloc,
+    .upipe_input = upipe_v210dec_input,
+    .upipe_control = upipe_v210dec_control,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for v210dec pipes
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_v210dec_mgr_alloc(void)
+{
+    return &upipe_v210dec_mgr;
+}
@@ -57,6 +57,12 @@
 #include <libavutil/cpu.h>
 #include <libavutil/intreadwrite.h>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+/** @hidden */
+# define UPIPE_V210_X86
+# include <immintrin.h>
+#endif
+
 #define UPIPE_V210_MAX_PLANES 3
 
 /** upipe_v210enc structure with v210enc parameters */
@@ -180,6 +186,290 @@ static void v210enc_planar_pack_10_c(const uint16_t *y, const uint16_t *u,
     }
 }
 
+#ifdef UPIPE_V210_X86
+/* The samples of 6 pixels are packed in 4 words of 3 samples each,
+ * u y v | y u y | v y u | y v y. The shuffles gather the first two samples
+ * of each word in the 16-bit halves of a 32-bit lane, so that pmaddwd
+ * shifts and adds them at once, and the third one alone, to be shifted
+ * into place. Z zeroes a 16-bit sample, W picks a 16-bit sample and B zero
+ * extends an 8-bit sample. */
+#define Z -1, -1
+#define W(n) 2 * (n), 2 * (n) + 1
+#define B(n) (n), -1
+
+/** @internal @This packs 6 pixels of 10 bits from one register of luma and
+ * one register of chroma holding u in its low half and v in its high half.
+ */
+#define PACK_10(type, suffix, luma, chroma)                                 \
+    _##type##_or_si##suffix(                                                \
+        _##type##_madd_epi16(                                               \
+            _##type##_or_si##suffix(                                        \
+                _##type##_shuffle_epi8(luma, pairs_y),                      \
+                _##type##_shuffle_epi8(chroma, pairs_c)),                   \
+            mult),                                                          \
+        _##type##_slli_epi32(                                               \
+            _##type##_or_si##suffix(                                        \
+                _##type##_shuffle_epi8(luma, thirds_y),                     \
+                _##type##_shuffle_epi8(chroma, thirds_c)), 20))
+
+/** @internal @This clips 10-bit samples to the valid range, with unsigned
+ * saturation so that out of range input is clipped like in the C version.
+ */
+#define CLIP_10(type, v)                                                    \
+    _##type##_adds_epu16(_##type##_subs_epu16(                              \
+        _##type##_sub_epi16(v, _##type##_subs_epu16(v, max)), min), min)
+
+/** @internal @This is the SSSE3 implementation of the 10-bit packing
+ * function, handling 6 pixels per iteration.
+ */
+__attribute__((target("ssse3")))
+static void v210enc_planar_pack_10_ssse3(const uint16_t *y, const uint16_t *u,
+                                         const uint16_t *v, uint8_t *dst,
+                                         ptrdiff_t width)
+{
+    const __m128i pairs_y = _mm_setr_epi8(Z, W(0), W(1), Z, Z, W(3), W(4), Z);
+    const __m128i pairs_c = _mm_setr_epi8(W(0), Z, Z, W(1), W(5), Z, Z, W(6));
+    const __m128i thirds_y = _mm_setr_epi8(Z, Z, W(2), Z, Z, Z, W(5), Z);
+    const __m128i thirds_c = _mm_setr_epi8(W(4), Z, Z, Z, W(2), Z, Z, Z);
+    const __m128i mult = _mm_set1_epi32(1 | (1 << 26));
+    const __m128i min = _mm_set1_epi16(4);
+    const __m128i max = _mm_set1_epi16(1019);
+    ptrdiff_t i;
+
+    /* loads go up to 2 pixels beyond the 6 being packed */
+    for (i = 0; i + 8 <= width; i += 6) {
+        __m128i luma = _mm_loadu_si128((const __m128i *)y);
+        __m128i chroma = _mm_unpacklo_epi64(
+                _mm_loadl_epi64((const __m128i *)u),
+                _mm_loadl_epi64((const __m128i *)v));
+        luma = CLIP_10(mm, luma);
+        chroma = CLIP_10(mm, chroma);
+        _mm_storeu_si128((__m128i *)dst, PACK_10(mm, 128, luma, chroma));
+        y += 6;
+        u += 3;
+        v += 3;
+        dst += 16;
+    }
+    v210enc_planar_pack_10_c(y, u, v, dst, width - i);
+}
+
+/** @internal @This is the AVX2 implementation of the 10-bit packing
+ * function, handling 12 pixels per iteration, 6 in each lane.
+ */
+__attribute__((target("avx2")))
+static void v210enc_planar_pack_10_avx2(const uint16_t *y, const uint16_t *u,
+                                        const uint16_t *v, uint8_t *dst,
+                                        ptrdiff_t width)
+{
+    const __m256i pairs_y = _mm256_broadcastsi128_si256(
+            _mm_setr_epi8(Z, W(0), W(1), Z, Z, W(3), W(4), Z));
+    const __m256i pairs_c = _mm256_broadcastsi128_si256(
+            _mm_setr_epi8(W(0), Z, Z, W(1), W(5), Z, Z, W(6)));
+    const __m256i thirds_y = _mm256_broadcastsi128_si256(
+            _mm_setr_epi8(Z, Z, W(2), Z, Z, Z, W(5), Z));
+    const __m256i thirds_c = _mm256_broadcastsi128_si256(
+            _mm_setr_epi8(W(4), Z, Z, Z, W(2), Z, Z, Z));
+    const __m256i mult = _mm256_set1_epi32(1 | (1 << 26));
+    const __m256i min = _mm256_set1_epi16(4);
+    const __m256i max = _mm256_set1_epi16(1019);
+    ptrdiff_t i;
+
+    for (i = 0; i + 14 <= width; i += 12) {
+        __m256i luma = _mm256_inserti128_si256(_mm256_castsi128_si256(
+                    _mm_loadu_si128((const __m128i *)y)),
+                _mm_loadu_si128((const __m128i *)(y + 6)), 1);
+        __m256i chroma = _mm256_inserti128_si256(_mm256_castsi128_si256(
+                    _mm_unpacklo_epi64(
+                        _mm_loadl_epi64((const __m128i *)u),
+                        _mm_loadl_epi64((const __m128i *)v))),
+                _mm_unpacklo_epi64(
+                    _mm_loadl_epi64((const __m128i *)(u + 3)),
+                    _mm_loadl_epi64((const __m128i *)(v + 3))), 1);
+        luma = CLIP_10(mm256, luma);
+        chroma = CLIP_10(mm256, chroma);
+        _mm256_storeu_si256((__m256i *)dst,
+                            PACK_10(mm256, 256, luma, chroma));
+        y += 12;
+        u += 6;
+        v += 6;
+        dst += 32;
+    }
+    v210enc_planar_pack_10_ssse3(y, u, v, dst, width - i);
+}
+
+/** @internal @This is the SSSE3 implementation of the 8-bit packing
+ * function, handling 12 pixels per iteration. The 8-bit samples are zero
+ * extended by the shuffles and packed like 10-bit samples, shifted by two
+ * more bits.
+ */
+__attribute__((target("ssse3")))
+static void v210enc_planar_pack_8_ssse3(const uint8_t *y, const uint8_t *u,
+                                        const uint8_t *v, uint8_t *dst,
+                                        ptrdiff_t width)
+{
+    const __m128i pairs_y0 = _mm_setr_epi8(Z, B(0), B(1), Z, Z, B(3), B(4), Z);
+    const __m128i pairs_c0 = _mm_setr_epi8(B(0), Z, Z, B(1), B(9), Z, Z,
+                                           B(10));
+    const __m128i thirds_y0 = _mm_setr_epi8(Z, Z, B(2), Z, Z, Z, B(5), Z);
+    const __m128i thirds_c0 = _mm_setr_epi8(B(8), Z, Z, Z, B(2), Z, Z, Z);
+    const __m128i pairs_y1 = _mm_setr_epi8(Z, B(6), B(7), Z, Z, B(9), B(10),
+                                           Z);
+    const __m128i pairs_c1 = _mm_setr_epi8(B(3), Z, Z, B(4), B(12), Z, Z,
+                                           B(13));
+    const __m128i thirds_y1 = _mm_setr_epi8(Z, Z, B(8), Z, Z, Z, B(11), Z);
+    const __m128i thirds_c1 = _mm_setr_epi8(B(11), Z, Z, Z, B(5), Z, Z, Z);
+    const __m128i mult = _mm_set1_epi32(4 | (1 << 28));
+    const __m128i min = _mm_set1_epi8(1);
+    const __m128i max = _mm_set1_epi8(254);
+    ptrdiff_t i;
+
+    /* loads go up to 4 pixels beyond the 12 being packed */
+    for (i = 0; i + 16 <= width; i += 12) {
+        __m128i luma = _mm_loadu_si128((const __m128i *)y);
+        __m128i chroma = _mm_unpacklo_epi64(
+                _mm_loadl_epi64((const __m128i *)u),
+                _mm_loadl_epi64((const __m128i *)v));
+        luma = _mm_min_epu8(_mm_max_epu8(luma, min), max);
+        chroma = _mm_min_epu8(_mm_max_epu8(chroma, min), max);
+
+        __m128i pairs = _mm_madd_epi16(_mm_or_si128(
+                    _mm_shuffle_epi8(luma, pairs_y0),
+                    _mm_shuffle_epi8(chroma, pairs_c0)), mult);
+        __m128i thirds = _mm_or_si128(
+                _mm_shuffle_epi8(luma, thirds_y0),
+                _mm_shuffle_epi8(chroma, thirds_c0));
+        _mm_storeu_si128((__m128i *)dst,
+                         _mm_or_si128(pairs, _mm_slli_epi32(thirds, 22)));
+
+        pairs = _mm_madd_epi16(_mm_or_si128(
+                    _mm_shuffle_epi8(luma, pairs_y1),
+                    _mm_shuffle_epi8(chroma, pairs_c1)), mult);
+        thirds = _mm_or_si128(
+                _mm_shuffle_epi8(luma, thirds_y1),
+                _mm_shuffle_epi8(chroma, thirds_c1));
+        _mm_storeu_si128((__m128i *)(dst + 16),
+                         _mm_or_si128(pairs, _mm_slli_epi32(thirds, 22)));
+        y += 12;
+        u += 6;
+        v += 6;
+        dst += 32;
+    }
+    v210enc_planar_pack_8_c(y, u, v, dst, width - i);
+}
+
+/** @internal @This is the AVX2 implementation of the 8-bit packing
+ * function, handling 24 pixels per iteration, 12 in each lane.
+ */
+__attribute__((target("avx2")))
+static void v210enc_planar_pack_8_avx2(const uint8_t *y, const uint8_t *u,
+                                       const uint8_t *v, uint8_t *dst,
+                                       ptrdiff_t width)
+{
+    const __m256i pairs_y0 = _mm256_broadcastsi128_si256(
+            _mm_setr_epi8(Z, B(0), B(1), Z, Z, B(3), B(4), Z));
+    const __m256i pairs_c0 = _mm256_broadcastsi128_si256(
+            _mm_setr_epi8(B(0), Z, Z, B(1), B(9), Z, Z, B(10)));
+    const __m256i thirds_y0 = _mm256_broadcastsi128_si256(
+            _mm_setr_epi8(Z, Z, B(2), Z, Z, Z, B(5), Z));
+    const __m256i thirds_c0 = _mm256_broadcastsi128_si256(
+            _mm_setr_epi8(B(8), Z, Z, Z, B(2), Z, Z, Z));
+    const __m256i pairs_y1 = _mm256_broadcastsi128_si256(
+            _mm_setr_epi8(Z, B(6), B(7), Z, Z, B(9), B(10), Z));
+    const __m256i pairs_c1 = _mm256_broadcastsi128_si256(
+            _mm_setr_epi8(B(3), Z, Z, B(4), B(12), Z, Z, B(13)));
+    const __m256i thirds_y1 = _mm256_broadcastsi128_si256(
+            _mm_setr_epi8(Z, Z, B(8), Z, Z, Z, B(11), Z));
+    const __m256i thirds_c1 = _mm256_broadcastsi128_si256(
+            _mm_setr_epi8(B(11), Z, Z, Z, B(5), Z, Z, Z));
+    const __m256i mult = _mm256_set1_epi32(4 | (1 << 28));
+    const __m256i min = _mm256_set1_epi8(1);
+    const __m256i max = _mm256_set1_epi8(254);
+    ptrdiff_t i;
+
+    for (i = 0; i + 28 <= width; i += 24) {
+        __m256i luma = _mm256_inserti128_si256(_mm256_castsi128_si256(
+                    _mm_loadu_si128((const __m128i *)y)),
+                _mm_loadu_si128((const __m128i *)(y + 12)), 1);
+        __m256i chroma = _mm256_inserti128_si256(_mm256_castsi128_si256(
+                    _mm_unpacklo_epi64(
+                        _mm_loadl_epi64((const __m128i *)u),
+                        _mm_loadl_epi64((const __m128i *)v))),
+                _mm_unpacklo_epi64(
+                    _mm_loadl_epi64((const __m128i *)(u + 6)),
+                    _mm_loadl_epi64((const __m128i *)(v + 6))), 1);
+        luma = _mm256_min_epu8(_mm256_max_epu8(luma, min), max);
+        chroma = _mm256_min_epu8(_mm256_max_epu8(chroma, min), max);
+
+        __m256i pairs = _mm256_madd_epi16(_mm256_or_si256(
+                    _mm256_shuffle_epi8(luma, pairs_y0),
+                    _mm256_shuffle_epi8(chroma, pairs_c0)), mult);
+        __m256i thirds = _mm256_or_si256(
+                _mm256_shuffle_epi8(luma, thirds_y0),
+                _mm256_shuffle_epi8(chroma, thirds_c0));
+        __m256i first = _mm256_or_si256(pairs,
+                                        _mm256_slli_epi32(thirds, 22));
+
+        pairs = _mm256_madd_epi16(_mm256_or_si256(
+                    _mm256_shuffle_epi8(luma, pairs_y1),
+                    _mm256_shuffle_epi8(chroma, pairs_c1)), mult);
+        thirds = _mm256_or_si256(
+                _mm256_shuffle_epi8(luma, thirds_y1),
+                _mm256_shuffle_epi8(chroma, thirds_c1));
+        __m256i second = _mm256_or_si256(pairs,
+                                         _mm256_slli_epi32(thirds, 22));
+
+        /* each lane holds 12 pixels, in two halves */
+        _mm256_storeu_si256((__m256i *)dst,
+                            _mm256_permute2x128_si256(first, second, 0x20));
+        _mm256_storeu_si256((__m256i *)(dst + 32),
+                            _mm256_permute2x128_si256(first, second, 0x31));
+        y += 24;
+        u += 12;
+        v += 12;
+        dst += 64;
+    }
+    v210enc_planar_pack_8_ssse3(y, u, v, dst, width - i);
+}
+
+#undef Z
+#undef W
+#undef B
+#endif
+
+/** @This returns the fastest 8-bit packing function for the given CPU
+ * flags.
+ *
+ * @param cpu_flags CPU flags, as returned by av_get_cpu_flags()
+ * @return a packing function
+ */
+upipe_v210enc_pack_line_8 upipe_v210enc_select_pack_line_8(int cpu_flags)
+{
+#ifdef UPIPE_V210_X86
+    if (cpu_flags & AV_CPU_FLAG_AVX2)
+        return v210enc_planar_pack_8_avx2;
+    if (cpu_flags & AV_CPU_FLAG_SSSE3)
+        return v210enc_planar_pack_8_ssse3;
+#endif
+    return v210enc_planar_pack_8_c;
+}
+
+/** @This returns the fastest 10-bit packing function for the given CPU
+ * flags.
+ *
+ * @param cpu_flags CPU flags, as returned by av_get_cpu_flags()
+ * @return a packing function
+ */
+upipe_v210enc_pack_line_10 upipe_v210enc_select_pack_line_10(int cpu_flags)
+{
+#ifdef UPIPE_V210_X86
+    if (cpu_flags & AV_CPU_FLAG_AVX2)
+        return v210enc_planar_pack_10_avx2;
+    if (cpu_flags & AV_CPU_FLAG_SSSE3)
+        return v210enc_planar_pack_10_ssse3;
+#endif
+    return v210enc_planar_pack_10_c;
+}
+
 /** @internal @This handles data.
  *
  * @param upipe description structure of the pipe
@@ -635,8 +925,10 @@ static struct upipe *upipe_v210enc_alloc(struct upipe_mgr *mgr,
     struct upipe_v210enc *upipe_v210enc = upipe_v210enc_from_upipe(upipe);
     upipe_v210enc->cpu_flags = av_get_cpu_flags();
 
-    upipe_v210enc->pack_line_8  = v210enc_planar_pack_8_c;
-    upipe_v210enc->pack_line_10 = v210enc_planar_pack_10_c;
+    upipe_v210enc->pack_line_8  =
+        upipe_v210enc_select_pack_line_8(upipe_v210enc->cpu_flags);
+    upipe_v210enc->pack_line_10 =
+        upipe_v210enc_select_pack_line_10(upipe_v210enc->cpu_flags);
 
     upipe_v210enc_init_urefcount(upipe);
     upipe_v210enc_init_ubuf_mgr(upipe);
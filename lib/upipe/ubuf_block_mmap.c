@@ -0,0 +1,472 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe ubuf manager for block formats pointing to a mapped file
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/uatomic.h>
+#include <upipe/urefcount.h>
+#include <upipe/upool.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_block.h>
+#include <upipe/ubuf_block_common.h>
+#include <upipe/ubuf_block_mmap.h>
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <assert.h>
+
+/** default size of the mapped windows */
+#define UBUF_DEFAULT_WINDOW_SIZE    (8 * 1024 * 1024)
+
+/** @This is a region of the file mapped in memory, shared by all buffers
+ * pointing into it. */
+struct ubuf_block_mmap_window {
+    /** number of blocks pointing to the window, plus one for the manager
+     * while it is the current window */
+    uatomic_uint32_t refcount;
+    /** position of the window in the file */
+    uint64_t offset;
+    /** size of the window */
+    size_t size;
+    /** mapped memory */
+    uint8_t *base;
+};
+
+/** @This is a super-set of the @ref ubuf (and @ref ubuf_block)
+ * structure with a private field pointing to the window. */
+struct ubuf_block_mmap {
+    /** pointer to the window, or NULL for empty buffers */
+    struct ubuf_block_mmap_window *window;
+
+    /** common block structure */
+    struct ubuf_block ubuf_block;
+};
+
+UBASE_FROM_TO(ubuf_block_mmap, ubuf, ubuf, ubuf_block.ubuf)
+
+/** @This is a super-set of the ubuf_mgr structure with additional local
+ * members. */
+struct ubuf_block_mmap_mgr {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** duplicate of the file descriptor */
+    int fd;
+    /** size of the windows, multiple of the page size */
+    uint64_t window_size;
+    /** page size */
+    uint64_t page_size;
+    /** current window, or NULL */
+    struct ubuf_block_mmap_window *window;
+    /** position up to which read-ahead has been requested */
+    uint64_t readahead;
+
+    /** ubuf pool */
+    struct upool ubuf_pool;
+
+    /** common management structure */
+    struct ubuf_mgr mgr;
+
+    /** extra space for upool */
+    uint8_t upool_extra[];
+};
+
+UBASE_FROM_TO(ubuf_block_mmap_mgr, ubuf_mgr, ubuf_mgr, mgr)
+UBASE_FROM_TO(ubuf_block_mmap_mgr, urefcount, urefcount, urefcount)
+UBASE_FROM_TO(ubuf_block_mmap_mgr, upool, ubuf_pool, ubuf_pool)
+
+/** @internal @This releases a window, and unmaps it if it is no longer
+ * used.
+ *
+ * @param window pointer to window
+ */
+static void ubuf_block_mmap_window_release(
+        struct ubuf_block_mmap_window *window)
+{
+    if (window == NULL || uatomic_fetch_sub(&window->refcount, 1) != 1)
+        return;
+    munmap(window->base, window->size);
+    uatomic_clean(&window->refcount);
+    free(window);
+}
+
+/** @internal @This maps a new window containing the given part of the file,
+ * and makes it the current window.
+ *
+ * @param mgr pointer to ubuf manager
+ * @param offset position of the wanted part in the file
+ * @param size size of the wanted part
+ * @return pointer to the new window, or NULL in case of error
+ */
+static struct ubuf_block_mmap_window *
+    ubuf_block_mmap_window_map(struct ubuf_mgr *mgr, uint64_t offset,
+                               size_t size)
+{
+    struct ubuf_block_mmap_mgr *mmap_mgr =
+        ubuf_block_mmap_mgr_from_ubuf_mgr(mgr);
+    struct ubuf_block_mmap_window *window =
+        malloc(sizeof(struct ubuf_block_mmap_window));
+    if (unlikely(window == NULL))
+        return NULL;
+
+    window->offset = offset - offset % mmap_mgr->page_size;
+    uint64_t window_size = offset + size - window->offset;
+    window_size += mmap_mgr->page_size - 1;
+    window_size -= window_size % mmap_mgr->page_size;
+    if (window_size < mmap_mgr->window_size)
+        window_size = mmap_mgr->window_size;
+    window->size = window_size;
+
+    void *base = mmap(NULL, window->size, PROT_READ, MAP_PRIVATE,
+                      mmap_mgr->fd, window->offset);
+    if (unlikely(base == MAP_FAILED)) {
+        free(window);
+        return NULL;
+    }
+    window->base = base;
+    uatomic_init(&window->refcount, 1);
+
+    /* unless the window was already read ahead by a sequential read */
+    struct ubuf_block_mmap_window *old = mmap_mgr->window;
+    if (old == NULL || window->offset < old->offset ||
+        window->offset + window->size > mmap_mgr->readahead) {
+#ifdef MADV_WILLNEED
+        madvise(window->base, window->size, MADV_WILLNEED);
+#endif
+        mmap_mgr->readahead = window->offset + window->size;
+    }
+#ifdef MADV_SEQUENTIAL
+    madvise(window->base, window->size, MADV_SEQUENTIAL);
+#endif
+
+    ubuf_block_mmap_window_release(old);
+    mmap_mgr->window = window;
+    return window;
+}
+
+/** @This allocates a ubuf pointing to a part of the file.
+ *
+ * @param mgr common management structure
+ * @param signature must be UBUF_ALLOC_BLOCK_MMAP (sentinel)
+ * @param args optional arguments (1st = offset, 2nd = size)
+ * @return pointer to ubuf or NULL in case of allocation error
+ */
+static struct ubuf *ubuf_block_mmap_alloc_ubuf(struct ubuf_mgr *mgr,
+                                               uint32_t signature,
+                                               va_list args)
+{
+    /* plain block allocations cannot be honoured */
+    if (unlikely(signature != UBUF_ALLOC_BLOCK_MMAP))
+        return NULL;
+
+    uint64_t offset = va_arg(args, uint64_t);
+    int size = va_arg(args, int);
+    assert(size >= 0);
+
+    struct ubuf_block_mmap_mgr *mmap_mgr =
+        ubuf_block_mmap_mgr_from_ubuf_mgr(mgr);
+    struct ubuf_block_mmap *block_mmap = upool_alloc(&mmap_mgr->ubuf_pool,
+                                                     struct ubuf_block_mmap *);
+    if (unlikely(block_mmap == NULL))
+        return NULL;
+
+    struct ubuf *ubuf = ubuf_block_mmap_to_ubuf(block_mmap);
+    ubuf_block_common_init(ubuf, false);
+    block_mmap->window = NULL;
+    if (size) {
+        struct ubuf_block_mmap_window *window = mmap_mgr->window;
+        if (window == NULL || offset < window->offset ||
+            offset + size > window->offset + window->size) {
+            window = ubuf_block_mmap_window_map(mgr, offset, size);
+            if (unlikely(window == NULL)) {
+                upool_free(&mmap_mgr->ubuf_pool, block_mmap);
+                return NULL;
+            }
+        }
+        uatomic_fetch_add(&window->refcount, 1);
+        block_mmap->window = window;
+        ubuf_block_common_set(ubuf, offset - window->offset, size);
+        ubuf_block_common_set_buffer(ubuf, window->base);
+
+#ifdef POSIX_FADV_WILLNEED
+        /* read the next window ahead once half of this one is consumed */
+        if (offset + size > window->offset + window->size / 2 &&
+            mmap_mgr->readahead <= window->offset + window->size) {
+            posix_fadvise(mmap_mgr->fd, mmap_mgr->readahead,
+                          mmap_mgr->window_size, POSIX_FADV_WILLNEED);
+            mmap_mgr->readahead += mmap_mgr->window_size;
+        }
+#endif
+    }
+
+    ubuf_mgr_use(mgr);
+    return ubuf;
+}
+
+/** @internal @This allocates a new ubuf pointing to the same window.
+ *
+ * @param ubuf pointer to ubuf
+ * @return pointer to the new ubuf, or NULL in case of allocation error
+ */
+static struct ubuf *ubuf_block_mmap_alloc_ref(struct ubuf *ubuf)
+{
+    struct ubuf_block_mmap_mgr *mmap_mgr =
+        ubuf_block_mmap_mgr_from_ubuf_mgr(ubuf->mgr);
+    struct ubuf_block_mmap *new_block = upool_alloc(&mmap_mgr->ubuf_pool,
+                                                    struct ubuf_block_mmap *);
+    if (unlikely(new_block == NULL))
+        return NULL;
+
+    struct ubuf_block_mmap *block_mmap = ubuf_block_mmap_from_ubuf(ubuf);
+    new_block->window = block_mmap->window;
+    if (new_block->window != NULL)
+        uatomic_fetch_add(&new_block->window->refcount, 1);
+
+    struct ubuf *new_ubuf = ubuf_block_mmap_to_ubuf(new_block);
+    ubuf_block_common_init(new_ubuf, false);
+    ubuf_mgr_use(new_ubuf->mgr);
+    return new_ubuf;
+}
+
+/** @This asks for the creation of a new reference to the same buffer space.
+ *
+ * @param ubuf pointer to ubuf
+ * @param new_ubuf_p reference written with a pointer to the newly allocated
+ * ubuf
+ * @return an error code
+ */
+static int ubuf_block_mmap_dup(struct ubuf *ubuf, struct ubuf **new_ubuf_p)
+{
+    assert(new_ubuf_p != NULL);
+    struct ubuf *new_ubuf = ubuf_block_mmap_alloc_ref(ubuf);
+    if (unlikely(new_ubuf == NULL))
+        return UBASE_ERR_ALLOC;
+
+    if (unlikely(!ubase_check(ubuf_block_common_dup(ubuf, new_ubuf)))) {
+        ubuf_free(new_ubuf);
+        return UBASE_ERR_INVALID;
+    }
+    *new_ubuf_p = new_ubuf;
+    return UBASE_ERR_NONE;
+}
+
+/** @This asks for the creation of a new reference to the same buffer space.
+ *
+ * @param ubuf pointer to ubuf
+ * @param new_ubuf_p reference written with a pointer to the newly allocated
+ * ubuf
+ * @param offset offset in the buffer
+ * @param size final size of the buffer
+ * @return an error code
+ */
+static int ubuf_block_mmap_splice(struct ubuf *ubuf, struct ubuf **new_ubuf_p,
+                                  int offset, int size)
+{
+    assert(new_ubuf_p != NULL);
+    struct ubuf *new_ubuf = ubuf_block_mmap_alloc_ref(ubuf);
+    if (unlikely(new_ubuf == NULL))
+        return UBASE_ERR_ALLOC;
+
+    if (unlikely(!ubase_check(ubuf_block_common_splice(ubuf, new_ubuf,
+                                                       offset, size)))) {
+        ubuf_free(new_ubuf);
+        return UBASE_ERR_INVALID;
+    }
+    *new_ubuf_p = new_ubuf;
+    return UBASE_ERR_NONE;
+}
+
+/** @This handles control commands.
+ *
+ * @param ubuf pointer to ubuf
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int ubuf_block_mmap_control(struct ubuf *ubuf, int command,
+                                   va_list args)
+{
+    switch (command) {
+        case UBUF_DUP: {
+            struct ubuf **new_ubuf_p = va_arg(args, struct ubuf **);
+            return ubuf_block_mmap_dup(ubuf, new_ubuf_p);
+        }
+        case UBUF_SINGLE:
+            /* the pages belong to the file and are mapped read-only */
+            return UBASE_ERR_BUSY;
+
+        case UBUF_SPLICE_BLOCK: {
+            struct ubuf **new_ubuf_p = va_arg(args, struct ubuf **);
+            int offset = va_arg(args, int);
+            int size = va_arg(args, int);
+            return ubuf_block_mmap_splice(ubuf, new_ubuf_p, offset, size);
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This recycles or frees a ubuf.
+ *
+ * @param ubuf pointer to a ubuf structure
+ */
+static void ubuf_block_mmap_free(struct ubuf *ubuf)
+{
+    struct ubuf_mgr *mgr = ubuf->mgr;
+    struct ubuf_block_mmap_mgr *mmap_mgr =
+        ubuf_block_mmap_mgr_from_ubuf_mgr(mgr);
+    struct ubuf_block_mmap *block_mmap = ubuf_block_mmap_from_ubuf(ubuf);
+
+    ubuf_block_common_clean(ubuf);
+    ubuf_block_mmap_window_release(block_mmap->window);
+    upool_free(&mmap_mgr->ubuf_pool, block_mmap);
+    ubuf_mgr_release(mgr);
+}
+
+/** @internal @This allocates the data structure.
+ *
+ * @param upool pointer to upool
+ * @return pointer to ubuf_block_mmap or NULL in case of allocation error
+ */
+static void *ubuf_block_mmap_alloc_inner(struct upool *upool)
+{
+    struct ubuf_block_mmap_mgr *mmap_mgr =
+        ubuf_block_mmap_mgr_from_ubuf_pool(upool);
+    struct ubuf_block_mmap *block_mmap =
+        malloc(sizeof(struct ubuf_block_mmap));
+    if (unlikely(block_mmap == NULL))
+        return NULL;
+    struct ubuf *ubuf = ubuf_block_mmap_to_ubuf(block_mmap);
+    ubuf->mgr = ubuf_block_mmap_mgr_to_ubuf_mgr(mmap_mgr);
+    return block_mmap;
+}
+
+/** @internal @This frees a ubuf_block_mmap.
+ *
+ * @param upool pointer to upool
+ * @param _block_mmap pointer to a ubuf_block_mmap structure to free
+ */
+static void ubuf_block_mmap_free_inner(struct upool *upool, void *_block_mmap)
+{
+    free(_block_mmap);
+}
+
+/** @This handles manager control commands.
+ *
+ * @param mgr pointer to ubuf manager
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int ubuf_block_mmap_mgr_control(struct ubuf_mgr *mgr,
+                                       int command, va_list args)
+{
+    struct ubuf_block_mmap_mgr *mmap_mgr =
+        ubuf_block_mmap_mgr_from_ubuf_mgr(mgr);
+    switch (command) {
+        case UBUF_MGR_CHECK:
+            /* this manager cannot allocate arbitrary buffers */
+            return UBASE_ERR_INVALID;
+        case UBUF_MGR_VACUUM:
+            upool_vacuum(&mmap_mgr->ubuf_pool);
+            return UBASE_ERR_NONE;
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a ubuf manager.
+ *
+ * @param urefcount pointer to urefcount
+ */
+static void ubuf_block_mmap_mgr_free(struct urefcount *urefcount)
+{
+    struct ubuf_block_mmap_mgr *mmap_mgr =
+        ubuf_block_mmap_mgr_from_urefcount(urefcount);
+    ubuf_block_mmap_window_release(mmap_mgr->window);
+    upool_clean(&mmap_mgr->ubuf_pool);
+    close(mmap_mgr->fd);
+
+    urefcount_clean(urefcount);
+    free(mmap_mgr);
+}
+
+/** @This allocates a new instance of the ubuf manager for block formats
+ * pointing to a mapped file.
+ *
+ * @param ubuf_pool_depth maximum number of ubuf structures in the pool
+ * @param fd file descriptor of a regular file opened for reading; the
+ * manager works on its own duplicate
+ * @param window_size size of the regions of the file mapped at once, in
+ * octets (0 for a default value)
+ * @return pointer to manager, or NULL in case of error
+ */
+struct ubuf_mgr *ubuf_block_mmap_mgr_alloc(uint16_t ubuf_pool_depth, int fd,
+                                           uint64_t window_size)
+{
+    long page_size = sysconf(_SC_PAGESIZE);
+    if (unlikely(page_size <= 0))
+        return NULL;
+
+    struct ubuf_block_mmap_mgr *mmap_mgr =
+        malloc(sizeof(struct ubuf_block_mmap_mgr) +
+               upool_sizeof(ubuf_pool_depth));
+    if (unlikely(mmap_mgr == NULL))
+        return NULL;
+
+    mmap_mgr->fd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (unlikely(mmap_mgr->fd == -1)) {
+        free(mmap_mgr);
+        return NULL;
+    }
+
+    upool_init(&mmap_mgr->ubuf_pool, ubuf_pool_depth, mmap_mgr->upool_extra,
+               ubuf_block_mmap_alloc_inner, ubuf_block_mmap_free_inner);
+
+    if (!window_size)
+        window_size = UBUF_DEFAULT_WINDOW_SIZE;
+    mmap_mgr->page_size = page_size;
+    mmap_mgr->window_size = window_size + page_size - 1;
+    mmap_mgr->window_size -= mmap_mgr->window_size % page_size;
+    mmap_mgr->window = NULL;
+    mmap_mgr->readahead = 0;
+
+    urefcount_init(ubuf_block_mmap_mgr_to_urefcount(mmap_mgr),
+                   ubuf_block_mmap_mgr_free);
+    mmap_mgr->mgr.refcount = ubuf_block_mmap_mgr_to_urefcount(mmap_mgr);
+    mmap_mgr->mgr.signature = UBUF_ALLOC_BLOCK;
+    mmap_mgr->mgr.ubuf_alloc = ubuf_block_mmap_alloc_ubuf;
+    mmap_mgr->mgr.ubuf_control = ubuf_block_mmap_control;
+    mmap_mgr->mgr.ubuf_free = ubuf_block_mmap_free;
+    mmap_mgr->mgr.ubuf_mgr_control = ubuf_block_mmap_mgr_control;
+
+    return ubuf_block_mmap_mgr_to_ubuf_mgr(mmap_mgr);
+}
@@ -38,8 +38,10 @@
 #include <upipe/udict_inline.h>
 
 #include <stdlib.h>
+#include <string.h>
 #include <inttypes.h>
 #include <assert.h>
+#include <pthread.h>
 
 /** define to activate statistics */
 #undef STATS
@@ -47,6 +49,15 @@
 #define UDICT_MIN_SIZE 128
 /** default extra space added on udict expansion */
 #define UDICT_EXTRA_SIZE 64
+/** maximum number of interned attribute names */
+#define UDICT_KEYS_MAX 1024
+/** number of buckets of the hash table of interned names (power of 2,
+ * larger than UDICT_KEYS_MAX) */
+#define UDICT_KEYS_BUCKETS 2048
+/** size of the storage of interned names */
+#define UDICT_KEYS_STORAGE 32768
+/** flag set on the type of attributes stored with an interned name */
+#define UDICT_TYPE_INTERNED 0x80
 
 /** @internal @This represents a shorthand attribute type. */
 struct inline_shorthand {
@@ -100,6 +111,39 @@ static const struct inline_shorthand inline_shorthands[] = {
     { "p.cea_708", UDICT_TYPE_OPAQUE }
 };
 
+/** @internal @This represents an interned attribute name. */
+struct inline_key {
+    /** identifier stored in the attributes */
+    uint16_t id;
+    /** name of the attribute */
+    char name[];
+};
+
+/** @This stores the interned attribute names of all inline managers.
+ *
+ * Attribute names are interned the first time they are set, and attributes
+ * are then stored with the 2-octet identifier instead of the name, so that
+ * lookups compare identifiers instead of strings. Names are never removed;
+ * once the table is full, new names are stored as strings. The buckets are
+ * written under the lock and read without it: a key is entirely written
+ * before it is published in a bucket with a release store, and readers load
+ * buckets with acquire loads. */
+static struct {
+    /** lock for writers */
+    pthread_mutex_t lock;
+    /** hash table of keys, with linear probing */
+    const struct inline_key *buckets[UDICT_KEYS_BUCKETS];
+    /** keys indexed by identifier */
+    const struct inline_key *keys[UDICT_KEYS_MAX];
+    /** number of keys */
+    unsigned int nb_keys;
+    /** number of octets used in the storage */
+    size_t storage_used;
+    /** storage of keys */
+    uint8_t storage[UDICT_KEYS_STORAGE]
+        __attribute__ ((aligned (sizeof(uint16_t))));
+} inline_keys = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
 /** @This stores the size of the value of basic attribute types. */
 static const size_t attr_sizes[] = { 0, 0, 0, 0, 1, 1, 1, 8, 8, 16, 8 };
 
@@ -208,17 +252,78 @@ static const struct inline_shorthand *
     return &inline_shorthands[type - UDICT_TYPE_SHORTHAND - 1];
 }
 
+/** @internal @This looks up the identifier of an interned attribute name,
+ * and optionally interns it.
+ *
+ * @param name name of the attribute
+ * @param intern true if the name is to be interned if it is not already
+ * @return identifier of the name, or -1 if it is not interned
+ */
+static int udict_inline_key(const char *name, bool intern)
+{
+    /* FNV-1a */
+    uint32_t hash = 2166136261U;
+    const char *p;
+    for (p = name; *p; p++) {
+        hash ^= (uint8_t)*p;
+        hash *= 16777619U;
+    }
+    size_t namelen = p - name;
+
+    unsigned int bucket = hash & (UDICT_KEYS_BUCKETS - 1);
+    const struct inline_key *key;
+    while ((key = __atomic_load_n(&inline_keys.buckets[bucket],
+                                  __ATOMIC_ACQUIRE)) != NULL) {
+        if (!strcmp(key->name, name))
+            return key->id;
+        bucket = (bucket + 1) & (UDICT_KEYS_BUCKETS - 1);
+    }
+    if (!intern)
+        return -1;
+
+    pthread_mutex_lock(&inline_keys.lock);
+    /* another thread may have published keys in the meantime */
+    while ((key = __atomic_load_n(&inline_keys.buckets[bucket],
+                                  __ATOMIC_RELAXED)) != NULL) {
+        if (!strcmp(key->name, name)) {
+            pthread_mutex_unlock(&inline_keys.lock);
+            return key->id;
+        }
+        bucket = (bucket + 1) & (UDICT_KEYS_BUCKETS - 1);
+    }
+
+    size_t key_size = (sizeof(struct inline_key) + namelen + 1 +
+                       sizeof(uint16_t) - 1) & ~(sizeof(uint16_t) - 1);
+    if (unlikely(inline_keys.nb_keys >= UDICT_KEYS_MAX ||
+                 inline_keys.storage_used + key_size > UDICT_KEYS_STORAGE)) {
+        /* the attribute is stored with its name instead */
+        pthread_mutex_unlock(&inline_keys.lock);
+        return -1;
+    }
+
+    struct inline_key *new_key = (struct inline_key *)
+        (inline_keys.storage + inline_keys.storage_used);
+    inline_keys.storage_used += key_size;
+    new_key->id = inline_keys.nb_keys;
+    memcpy(new_key->name, name, namelen + 1);
+    inline_keys.keys[inline_keys.nb_keys++] = new_key;
+    __atomic_store_n(&inline_keys.buckets[bucket], new_key, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&inline_keys.lock);
+    return new_key->id;
+}
+
 /** @internal @This jumps to the next attribute.
  *
  * @param attr attribute to iterate from
  * @return pointer to the next valid attribute, or NULL
  */
-static uint8_t *udict_inline_next(uint8_t *attr)
+static inline uint8_t *udict_inline_next(uint8_t *attr)
 {
     if (*attr == UDICT_TYPE_END)
         return NULL;
 
-    if (likely(*attr > UDICT_TYPE_SHORTHAND)) {
+    if (likely(*attr > UDICT_TYPE_SHORTHAND &&
+               !(*attr & UDICT_TYPE_INTERNED))) {
         const struct inline_shorthand *shorthand =
             udict_inline_shorthand(*attr);
         if (unlikely(shorthand == NULL))
@@ -252,10 +357,29 @@ static uint8_t *udict_inline_find(struct udict *udict, const char *name,
     }
 #endif
     uint8_t *attr = umem_buffer(&inl->umem);
+    if (type > UDICT_TYPE_SHORTHAND || type == UDICT_TYPE_END) {
+        while (attr != NULL) {
+            if (*attr == type)
+                return attr;
+            attr = udict_inline_next(attr);
+        }
+        return NULL;
+    }
+
+    int id = udict_inline_key(name, false);
+    if (likely(id >= 0)) {
+        uint8_t interned_type = type | UDICT_TYPE_INTERNED;
+        while (attr != NULL) {
+            if (*attr == interned_type &&
+                attr[3] == (id >> 8) && attr[4] == (id & 0xff))
+                return attr;
+            attr = udict_inline_next(attr);
+        }
+        return NULL;
+    }
+
     while (attr != NULL) {
-        if (*attr == type &&
-             (type > UDICT_TYPE_SHORTHAND || type == UDICT_TYPE_END ||
-              !strcmp((const char *)(attr + 3), name)))
+        if (*attr == type && !strcmp((const char *)(attr + 3), name))
             return attr;
         attr = udict_inline_next(attr);
     }
@@ -290,6 +414,11 @@ static void udict_inline_iterate(struct udict *udict, const char **name_p,
         return;
     }
 
+    if (*attr & UDICT_TYPE_INTERNED) {
+        *type_p = *attr & ~UDICT_TYPE_INTERNED;
+        *name_p = inline_keys.keys[(attr[3] << 8) | attr[4]]->name;
+        return;
+    }
     *type_p = *attr;
     *name_p = *attr > UDICT_TYPE_SHORTHAND ? NULL : (const char *)(attr + 3);
 }
@@ -327,6 +456,12 @@ static uint8_t *_udict_inline_get(struct udict *udict, const char *name,
                 *size_p = size;
             attr += 3;
         }
+    } else if (likely(*attr & UDICT_TYPE_INTERNED)) {
+        uint16_t size = (attr[1] << 8) | attr[2];
+        assert(size >= 2);
+        if (likely(size_p != NULL))
+            *size_p = size - 2;
+        attr += 5;
     } else {
         uint16_t size = (attr[1] << 8) | attr[2];
         size_t namelen = strlen(name);
@@ -431,9 +566,12 @@ static int udict_inline_set(struct udict *udict, const char *name,
     /* calculate header size */
     size_t header_size = 1;
     size_t namelen = 0;
+    int id = -1;
     if (likely(shorthand != NULL)) {
         if (base_type == UDICT_TYPE_OPAQUE || base_type == UDICT_TYPE_STRING)
             header_size += 2;
+    } else if (likely((id = udict_inline_key(name, true)) >= 0)) {
+        header_size += 2 + 2;
     } else {
         namelen = strlen(name);
         header_size += 2 + namelen + 1;
@@ -455,7 +593,15 @@ static int udict_inline_set(struct udict *udict, const char *name,
     assert(*attr == UDICT_TYPE_END);
 
     /* write attribute header */
-    if (unlikely(shorthand == NULL)) {
+    if (likely(id >= 0)) {
+        assert(2 + attr_size <= UINT16_MAX);
+        uint16_t size = 2 + attr_size;
+        *attr++ = type | UDICT_TYPE_INTERNED;
+        *attr++ = size >> 8;
+        *attr++ = size & 0xff;
+        *attr++ = id >> 8;
+        *attr++ = id & 0xff;
+    } else if (unlikely(shorthand == NULL)) {
         assert(namelen + 1 + attr_size <= UINT16_MAX);
         uint16_t size = namelen + 1 + attr_size;
         *attr++ = type;
@@ -664,6 +810,8 @@ struct udict_mgr *udict_inline_mgr_alloc(unsigned int udict_pool_depth,
                                          struct umem_mgr *umem_mgr,
                                          int min_size, int extra_size)
 {
+    assert(UDICT_TYPE_SHORTHAND + sizeof(inline_shorthands) /
+           sizeof(struct inline_shorthand) < UDICT_TYPE_INTERNED);
     struct udict_inline_mgr *inline_mgr =
         malloc(sizeof(struct udict_inline_mgr) +
                upool_sizeof(udict_pool_depth));
@@ -0,0 +1,457 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe per-thread magazines in front of a ulifo
+ *
+ * Each thread has a table of magazines indexed by the slot of the depot.
+ * The fast path only reads thread-local data, the immutable fields of the
+ * depot and its vacuum counter. A global lock protects the allocation of
+ * slots, the budgets and lists of magazines of each depot, and the
+ * magazines of dead depots and exiting threads. Statistics are only written
+ * by the thread owning the magazine, and read with relaxed atomic loads.
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/uatomic.h>
+#include <upipe/ulist.h>
+#include <upipe/ulifo.h>
+#include <upipe/umagazine.h>
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+/** @internal @This is the magazine of a thread for a depot. */
+struct umagazine_thread {
+    /** structure for double-linked lists of the depot */
+    struct uchain uchain;
+    /** depot, or NULL if the depot is dead */
+    struct umagazine *umagazine;
+    /** generation of the depot the magazine was registered with */
+    uint64_t generation;
+    /** maximum number of elements in the magazine, or 0 if the budget of
+     * the depot was exhausted when the magazine was registered */
+    unsigned int capacity;
+    /** number of elements in the magazine */
+    unsigned int count;
+    /** value of the vacuum counter of the depot last seen */
+    uint32_t vacuums;
+    /** number of elements allocated from the magazine */
+    uatomic_uint64_t hits;
+    /** number of allocations which found the magazine empty */
+    uatomic_uint64_t misses;
+    /** number of times the magazine was flushed to the shared LIFO */
+    uatomic_uint64_t flushes;
+    /** elements, the most recently released on top */
+    void *elements[UMAGAZINE_MAX_SIZE];
+};
+
+UBASE_FROM_TO(umagazine_thread, uchain, uchain, uchain)
+
+/** @internal @This is the table of magazines of a thread. */
+struct umagazine_table {
+    /** magazines indexed by slot */
+    struct umagazine_thread *magazines[UMAGAZINE_MAX_DEPOTS];
+};
+
+/** @internal global lock */
+static pthread_mutex_t umagazine_lock = PTHREAD_MUTEX_INITIALIZER;
+/** @internal slots in use */
+static uint64_t umagazine_slots[UMAGAZINE_MAX_DEPOTS / 64];
+/** @internal last generation number */
+static uint64_t umagazine_generation = 0;
+/** @internal key to the table of magazines of the thread */
+static pthread_key_t umagazine_key;
+/** @internal make sure the key is only created once */
+static pthread_once_t umagazine_once = PTHREAD_ONCE_INIT;
+
+/** @internal @This increments a statistics counter of a magazine, from the
+ * thread owning it.
+ *
+ * @param counter pointer to the counter
+ */
+static inline void umagazine_stats_inc(uatomic_uint64_t *counter)
+{
+    uatomic64_store_relaxed(counter, uatomic64_load_relaxed(counter) + 1);
+}
+
+/** @internal @This adds the statistics of a magazine to a sum.
+ *
+ * @param sum statistics to add to
+ * @param magazine magazine whose statistics are added
+ */
+static void umagazine_stats_add(struct umagazine_stats *sum,
+                                struct umagazine_thread *magazine)
+{
+    sum->hits += uatomic64_load_relaxed(&magazine->hits);
+    sum->misses += uatomic64_load_relaxed(&magazine->misses);
+    sum->flushes += uatomic64_load_relaxed(&magazine->flushes);
+}
+
+/** @internal @This releases an element to the shared LIFO of the depot, or
+ * with the call-back if it is full.
+ *
+ * @param umagazine pointer to a umagazine structure
+ * @param element pointer to element
+ */
+static void umagazine_release(struct umagazine *umagazine, void *element)
+{
+    if (unlikely(!ulifo_push(umagazine->lifo, element)))
+        umagazine->free_cb(umagazine->opaque, element);
+}
+
+/** @internal @This is called when a thread exits, to give the elements of
+ * its magazines back to the shared LIFOs.
+ *
+ * @param _table pointer to the table of magazines of the thread
+ */
+static void umagazine_table_free(void *_table)
+{
+    struct umagazine_table *table = (struct umagazine_table *)_table;
+
+    pthread_mutex_lock(&umagazine_lock);
+    for (unsigned int i = 0; i < UMAGAZINE_MAX_DEPOTS; i++) {
+        struct umagazine_thread *magazine = table->magazines[i];
+        if (magazine == NULL)
+            continue;
+
+        struct umagazine *umagazine = magazine->umagazine;
+        if (umagazine != NULL) {
+            while (magazine->count)
+                umagazine_release(umagazine,
+                                  magazine->elements[--magazine->count]);
+            umagazine_stats_add(&umagazine->stats, magazine);
+            umagazine->available += magazine->capacity;
+            ulist_delete(umagazine_thread_to_uchain(magazine));
+        }
+        uatomic64_clean(&magazine->hits);
+        uatomic64_clean(&magazine->misses);
+        uatomic64_clean(&magazine->flushes);
+        free(magazine);
+    }
+    pthread_mutex_unlock(&umagazine_lock);
+    free(table);
+}
+
+/** @internal @This creates the key to the tables of magazines. */
+static void umagazine_key_init(void)
+{
+    pthread_key_create(&umagazine_key, umagazine_table_free);
+}
+
+/** @This initializes a magazine depot.
+ *
+ * @param umagazine pointer to a umagazine structure
+ * @param lifo pointer to the shared LIFO, initialized by the caller
+ * @param size number of elements in per-thread magazines, capped to
+ * @ref #UMAGAZINE_MAX_SIZE; below 2, magazines are disabled and all
+ * operations go directly to the shared LIFO
+ * @param max maximum number of elements kept in the magazines of all
+ * threads together; threads registering once it is exhausted work without
+ * magazines
+ * @param free_cb call-back to release elements
+ * @param opaque opaque for the call-back
+ */
+void umagazine_init(struct umagazine *umagazine, struct ulifo *lifo,
+                    unsigned int size, unsigned int max,
+                    umagazine_free_cb free_cb, void *opaque)
+{
+    umagazine->lifo = lifo;
+    umagazine->size = 0;
+    umagazine->available = max;
+    umagazine->slot = 0;
+    umagazine->generation = 0;
+    uatomic_init(&umagazine->vacuums, 0);
+    umagazine->free_cb = free_cb;
+    umagazine->opaque = opaque;
+    ulist_init(&umagazine->magazines);
+    memset(&umagazine->stats, 0, sizeof(struct umagazine_stats));
+    if (size < 2 || max < 2)
+        return;
+
+    pthread_once(&umagazine_once, umagazine_key_init);
+
+    pthread_mutex_lock(&umagazine_lock);
+    for (unsigned int i = 0; i < UMAGAZINE_MAX_DEPOTS / 64; i++) {
+        if (umagazine_slots[i] == UINT64_MAX)
+            continue;
+        unsigned int bit = __builtin_ctzll(~umagazine_slots[i]);
+        umagazine_slots[i] |= UINT64_C(1) << bit;
+        umagazine->slot = i * 64 + bit;
+        umagazine->generation = ++umagazine_generation;
+        umagazine->size = size < UMAGAZINE_MAX_SIZE ? size :
+                          UMAGAZINE_MAX_SIZE;
+        break;
+    }
+    pthread_mutex_unlock(&umagazine_lock);
+}
+
+/** @internal @This registers a magazine of the calling thread for a depot.
+ *
+ * @param umagazine pointer to a umagazine structure
+ * @param table table of magazines of the calling thread
+ * @return pointer to the magazine, or NULL in case of allocation failure
+ */
+static struct umagazine_thread *
+    umagazine_register(struct umagazine *umagazine,
+                       struct umagazine_table *table)
+{
+    struct umagazine_thread *magazine = table->magazines[umagazine->slot];
+    if (magazine == NULL) {
+        magazine = malloc(sizeof(struct umagazine_thread));
+        if (unlikely(magazine == NULL))
+            return NULL;
+        magazine->umagazine = NULL;
+        magazine->count = 0;
+        uatomic64_init(&magazine->hits, 0);
+        uatomic64_init(&magazine->misses, 0);
+        uatomic64_init(&magazine->flushes, 0);
+        table->magazines[umagazine->slot] = magazine;
+    }
+
+    pthread_mutex_lock(&umagazine_lock);
+    /* the previous depot of this slot is dead and has emptied it */
+    assert(magazine->umagazine == NULL || magazine->count == 0);
+    uchain_init(umagazine_thread_to_uchain(magazine));
+    magazine->umagazine = umagazine;
+    magazine->generation = umagazine->generation;
+    magazine->capacity = umagazine->size < umagazine->available ?
+                         umagazine->size : umagazine->available;
+    if (magazine->capacity < 2)
+        magazine->capacity = 0;
+    umagazine->available -= magazine->capacity;
+    magazine->count = 0;
+    magazine->vacuums = uatomic_load_relaxed(&umagazine->vacuums);
+    uatomic64_store_relaxed(&magazine->hits, 0);
+    uatomic64_store_relaxed(&magazine->misses, 0);
+    uatomic64_store_relaxed(&magazine->flushes, 0);
+    ulist_add(&umagazine->magazines, umagazine_thread_to_uchain(magazine));
+    pthread_mutex_unlock(&umagazine_lock);
+    return magazine;
+}
+
+/** @internal @This releases all elements of a magazine with the call-back.
+ *
+ * @param umagazine pointer to a umagazine structure
+ * @param magazine magazine of the calling thread
+ */
+static void umagazine_drain(struct umagazine *umagazine,
+                            struct umagazine_thread *magazine)
+{
+    while (magazine->count)
+        umagazine->free_cb(umagazine->opaque,
+                           magazine->elements[--magazine->count]);
+}
+
+/** @internal @This returns the magazine of the calling thread for a depot.
+ *
+ * @param umagazine pointer to a umagazine structure
+ * @return pointer to the magazine, or NULL if magazines are not available
+ * to the calling thread
+ */
+static inline struct umagazine_thread *
+    umagazine_get(struct umagazine *umagazine)
+{
+    if (unlikely(!umagazine->size))
+        return NULL;
+
+    struct umagazine_table *table = pthread_getspecific(umagazine_key);
+    if (unlikely(table == NULL)) {
+        table = calloc(1, sizeof(struct umagazine_table));
+        if (unlikely(table == NULL))
+            return NULL;
+        if (unlikely(pthread_setspecific(umagazine_key, table) != 0)) {
+            free(table);
+            return NULL;
+        }
+    }
+
+    struct umagazine_thread *magazine = table->magazines[umagazine->slot];
+    if (unlikely(magazine == NULL ||
+                 magazine->generation != umagazine->generation))
+        magazine = umagazine_register(umagazine, table);
+    if (unlikely(magazine == NULL || !magazine->capacity))
+        return NULL;
+
+    uint32_t vacuums = uatomic_load_relaxed(&umagazine->vacuums);
+    if (unlikely(magazine->vacuums != vacuums)) {
+        /* another thread vacuumed the depot */
+        magazine->vacuums = vacuums;
+        umagazine_drain(umagazine, magazine);
+    }
+    return magazine;
+}
+
+/** @internal @This allocates an element from the magazine of the calling
+ * thread, refilling it from the shared LIFO if needed.
+ *
+ * @param umagazine pointer to a umagazine structure
+ * @return pointer to element, or NULL if the depot is empty
+ */
+void *umagazine_pop_internal(struct umagazine *umagazine)
+{
+    struct umagazine_thread *magazine = umagazine_get(umagazine);
+    if (unlikely(magazine == NULL))
+        return ulifo_pop(umagazine->lifo, void *);
+
+    if (likely(magazine->count)) {
+        umagazine_stats_inc(&magazine->hits);
+        return magazine->elements[--magazine->count];
+    }
+
+    umagazine_stats_inc(&magazine->misses);
+    void *element = ulifo_pop(umagazine->lifo, void *);
+    if (unlikely(element == NULL))
+        return NULL;
+
+    /* refill half of the magazine */
+    while (magazine->count < magazine->capacity / 2) {
+        void *refill = ulifo_pop(umagazine->lifo, void *);
+        if (refill == NULL)
+            break;
+        magazine->elements[magazine->count++] = refill;
+    }
+    /* keep the most recently released elements on top */
+    for (unsigned int i = 0; i < magazine->count / 2; i++) {
+        void *tmp = magazine->elements[i];
+        magazine->elements[i] = magazine->elements[magazine->count - 1 - i];
+        magazine->elements[magazine->count - 1 - i] = tmp;
+    }
+    return element;
+}
+
+/** @This releases an element to the magazine of the calling thread, flushing
+ * it to the shared LIFO if it is full. Elements which do not fit in the
+ * shared LIFO are released with the call-back.
+ *
+ * @param umagazine pointer to a umagazine structure
+ * @param element pointer to element (not NULL)
+ */
+void umagazine_push(struct umagazine *umagazine, void *element)
+{
+    assert(element != NULL);
+    struct umagazine_thread *magazine = umagazine_get(umagazine);
+    if (unlikely(magazine == NULL)) {
+        if (unlikely(!ulifo_push(umagazine->lifo, element)))
+            umagazine->free_cb(umagazine->opaque, element);
+        return;
+    }
+
+    if (unlikely(magazine->count >= magazine->capacity)) {
+        /* flush the least recently released half of the magazine */
+        unsigned int half = magazine->capacity / 2;
+        umagazine_stats_inc(&magazine->flushes);
+        for (unsigned int i = 0; i < half; i++)
+            if (unlikely(!ulifo_push(umagazine->lifo,
+                                     magazine->elements[i])))
+                umagazine->free_cb(umagazine->opaque, magazine->elements[i]);
+        magazine->count -= half;
+        memmove(magazine->elements, magazine->elements + half,
+                magazine->count * sizeof(void *));
+    }
+    magazine->elements[magazine->count++] = element;
+}
+
+/** @This releases all elements kept in the magazine of the calling thread,
+ * with the call-back. The other threads release the elements of their
+ * magazines the next time they use the depot, or when they exit.
+ *
+ * @param umagazine pointer to a umagazine structure
+ */
+void umagazine_vacuum(struct umagazine *umagazine)
+{
+    if (!umagazine->size)
+        return;
+    uatomic_fetch_add(&umagazine->vacuums, 1);
+    struct umagazine_thread *magazine = umagazine_get(umagazine);
+    if (magazine != NULL)
+        umagazine_drain(umagazine, magazine);
+}
+
+/** @This returns the statistics of a magazine depot. Counters of running
+ * threads are read with relaxed atomic loads, so they may lag behind.
+ *
+ * @param umagazine pointer to a umagazine structure
+ * @param stats filled in with the statistics
+ */
+void umagazine_stats(struct umagazine *umagazine,
+                     struct umagazine_stats *stats)
+{
+    pthread_mutex_lock(&umagazine_lock);
+    *stats = umagazine->stats;
+    struct uchain *uchain;
+    ulist_foreach (&umagazine->magazines, uchain) {
+        struct umagazine_thread *magazine =
+            umagazine_thread_from_uchain(uchain);
+        umagazine_stats_add(stats, magazine);
+    }
+    pthread_mutex_unlock(&umagazine_lock);
+}
+
+/** @This cleans up a magazine depot, releasing the elements kept in the
+ * magazines of all threads with the call-back. No other thread may use the
+ * depot at this point. When it is the last depot alive, the per-thread
+ * table of the calling thread is also freed. Please note that it is the
+ * caller's responsibility to empty and clean the shared LIFO afterwards.
+ *
+ * @param umagazine pointer to a umagazine structure
+ */
+void umagazine_clean(struct umagazine *umagazine)
+{
+    uatomic_clean(&umagazine->vacuums);
+    if (!umagazine->size)
+        return;
+
+    pthread_mutex_lock(&umagazine_lock);
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach (&umagazine->magazines, uchain, uchain_tmp) {
+        struct umagazine_thread *magazine =
+            umagazine_thread_from_uchain(uchain);
+        while (magazine->count)
+            umagazine->free_cb(umagazine->opaque,
+                               magazine->elements[--magazine->count]);
+        /* the magazine belongs to its thread, which will reuse it */
+        magazine->umagazine = NULL;
+        ulist_delete(uchain);
+    }
+    umagazine_slots[umagazine->slot / 64] &=
+        ~(UINT64_C(1) << (umagazine->slot % 64));
+    umagazine->size = 0;
+    bool last = true;
+    for (unsigned int i = 0; i < UMAGAZINE_MAX_DEPOTS / 64; i++)
+        if (umagazine_slots[i])
+            last = false;
+    pthread_mutex_unlock(&umagazine_lock);
+
+    /* the main thread does not run the destructors of thread-specific data,
+     * so free its table when it is not needed anymore */
+    struct umagazine_table *table;
+    if (last && (table = pthread_getspecific(umagazine_key)) != NULL) {
+        pthread_setspecific(umagazine_key, NULL);
+        umagazine_table_free(table);
+    }
+}
@@ -0,0 +1,491 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/urefcount.h>
+#include <upipe/ulifo.h>
+#include <upipe/umagazine.h>
+#include <upipe/umem.h>
+#include <upipe/umem_huge.h>
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+/** size of a huge page, to which the arena is rounded and aligned */
+#define UMEM_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+/** size of a regular page, used to prefault the arena */
+#define UMEM_HUGE_SMALL_PAGE_SIZE 4096
+/** alignment of buffers carved from the arena */
+#define UMEM_HUGE_ALIGN 64
+/** buffers larger than this are not kept in per-thread magazines */
+#define UMEM_HUGE_MAGAZINE_MAX_SIZE 65536
+
+#ifndef MPOL_BIND
+/** memory policy binding allocations to a set of nodes (linux/mempolicy.h) */
+#define MPOL_BIND 2
+#endif
+
+struct umem_huge_mgr;
+
+/** @This is the description of a pool of buffers of a given size. */
+struct umem_huge_pool {
+    /** pointer to the manager */
+    struct umem_huge_mgr *huge_mgr;
+    /** list of free buffers of the arena which did not fit in the LIFO,
+     * linked through their first octets (protected by the manager lock) */
+    void *spill;
+    /** per-thread magazines in front of the LIFO */
+    struct umagazine magazine;
+};
+
+/** @This defines the private data structures of the umem huge manager. */
+struct umem_huge_mgr {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** common management structure */
+    struct umem_mgr mgr;
+
+    /** start of the arena */
+    uint8_t *arena;
+    /** size of the arena */
+    size_t arena_size;
+    /** true if the arena is backed by MAP_HUGETLB pages */
+    bool hugetlb;
+    /** lock protecting arena_used and the spill lists */
+    pthread_mutex_t lock;
+    /** number of octets already carved from the arena */
+    size_t arena_used;
+
+    /** size (in octets) of buffers of pools[0] */
+    size_t pool0_size;
+    /** number of pools of buffers */
+    size_t nb_pools;
+    /** description of each pool */
+    struct umem_huge_pool *huge_pools;
+    /** buffer pools */
+    struct ulifo pools[];
+};
+
+UBASE_FROM_TO(umem_huge_mgr, umem_mgr, umem_mgr, mgr)
+UBASE_FROM_TO(umem_huge_mgr, urefcount, urefcount, urefcount)
+
+/** @internal @This returns the nearest bigger size to allocate for a umem of
+ * the given size to fit into and returns the index of the appropriate pool.
+ *
+ * @param mgr description structure of the umem mgr
+ * @param wanted desired size of the umem
+ * @param real_p reference written with the actual size of the future buffer
+ * @return index of the pool in which to find appropriate buffers
+ */
+static unsigned int umem_huge_find(struct umem_mgr *mgr, size_t wanted,
+                                   size_t *real_p)
+{
+    struct umem_huge_mgr *huge_mgr = umem_huge_mgr_from_umem_mgr(mgr);
+    size_t size = huge_mgr->pool0_size;
+    unsigned int pool;
+
+    for (pool = 0; pool < huge_mgr->nb_pools; pool++)
+        if (wanted <= (size << pool))
+            break;
+    if (likely(real_p != NULL))
+        *real_p = pool < huge_mgr->nb_pools ? size << pool : wanted;
+    return pool;
+}
+
+/** @internal @This checks if a buffer was carved from the arena.
+ *
+ * @param huge_mgr pointer to the private structure
+ * @param buffer buffer to check
+ * @return true if the buffer belongs to the arena
+ */
+static inline bool umem_huge_in_arena(struct umem_huge_mgr *huge_mgr,
+                                      void *buffer)
+{
+    return (uint8_t *)buffer >= huge_mgr->arena &&
+           (uint8_t *)buffer < huge_mgr->arena + huge_mgr->arena_size;
+}
+
+/** @internal @This takes a buffer from the spill list of a pool, or carves a
+ * new one from the arena.
+ *
+ * @param huge_mgr pointer to the private structure
+ * @param pool index of the pool
+ * @param real_size size of the buffers of the pool
+ * @return pointer to buffer, or NULL if the arena is exhausted
+ */
+static uint8_t *umem_huge_carve(struct umem_huge_mgr *huge_mgr,
+                                unsigned int pool, size_t real_size)
+{
+    struct umem_huge_pool *huge_pool = &huge_mgr->huge_pools[pool];
+    uint8_t *buffer = NULL;
+
+    pthread_mutex_lock(&huge_mgr->lock);
+    if (huge_pool->spill != NULL) {
+        buffer = huge_pool->spill;
+        huge_pool->spill = *(void **)buffer;
+    } else if (huge_mgr->arena_size - huge_mgr->arena_used >= real_size) {
+        buffer = huge_mgr->arena + huge_mgr->arena_used;
+        huge_mgr->arena_used += (real_size + UMEM_HUGE_ALIGN - 1) &
+                                ~(size_t)(UMEM_HUGE_ALIGN - 1);
+        if (huge_mgr->arena_used > huge_mgr->arena_size)
+            huge_mgr->arena_used = huge_mgr->arena_size;
+    }
+    pthread_mutex_unlock(&huge_mgr->lock);
+    return buffer;
+}
+
+/** @This allocates a new umem buffer space.
+ *
+ * @param mgr management structure
+ * @param umem caller-allocated structure, filled in with the required pointer
+ * and size (previous content is discarded)
+ * @param size requested size of the umem
+ * @return false if the memory couldn't be allocated (umem left untouched)
+ */
+static bool umem_huge_alloc(struct umem_mgr *mgr, struct umem *umem,
+                            size_t size)
+{
+    struct umem_huge_mgr *huge_mgr = umem_huge_mgr_from_umem_mgr(mgr);
+    size_t real_size;
+    unsigned int pool = umem_huge_find(mgr, size, &real_size);
+    uint8_t *buffer = NULL;
+
+    if (likely(pool < huge_mgr->nb_pools)) {
+        buffer = umagazine_pop(&huge_mgr->huge_pools[pool].magazine,
+                               uint8_t *);
+        if (unlikely(buffer == NULL))
+            buffer = umem_huge_carve(huge_mgr, pool, real_size);
+    }
+    if (unlikely(buffer == NULL))
+        buffer = malloc(real_size);
+    if (unlikely(buffer == NULL))
+        return false;
+
+    umem->buffer = buffer;
+    umem->size = size;
+    umem->real_size = real_size;
+    umem->mgr = mgr;
+    return true;
+}
+
+/** @This frees a umem.
+ *
+ * @param umem pointer to umem
+ */
+static void umem_huge_free(struct umem *umem)
+{
+    struct umem_huge_mgr *huge_mgr = umem_huge_mgr_from_umem_mgr(umem->mgr);
+    unsigned int pool = umem_huge_find(umem->mgr, umem->real_size, NULL);
+
+    if (likely(pool < huge_mgr->nb_pools))
+        umagazine_push(&huge_mgr->huge_pools[pool].magazine, umem->buffer);
+    else
+        free(umem->buffer);
+    umem->buffer = NULL;
+    umem->mgr = NULL;
+}
+
+/** @internal @This releases a buffer which does not fit in a pool. Buffers of
+ * the arena are kept in the spill list of the pool, others are freed.
+ *
+ * @param opaque pointer to the description of the pool
+ * @param buffer buffer to release
+ */
+static void umem_huge_release(void *opaque, void *buffer)
+{
+    struct umem_huge_pool *huge_pool = opaque;
+    struct umem_huge_mgr *huge_mgr = huge_pool->huge_mgr;
+
+    if (!umem_huge_in_arena(huge_mgr, buffer)) {
+        free(buffer);
+        return;
+    }
+    pthread_mutex_lock(&huge_mgr->lock);
+    *(void **)buffer = huge_pool->spill;
+    huge_pool->spill = buffer;
+    pthread_mutex_unlock(&huge_mgr->lock);
+}
+
+/** @This resizes a umem. We do not realloc() the buffer because it would
+ * artificially grow the size of a pool, and create a malloc/free contention.
+ *
+ * @param umem caller-allocated structure, previously successfully passed to
+ * @ref umem_alloc, and filled in with the new pointer and size
+ * @param new_size new requested size of the umem
+ * @return false if the memory couldn't be allocated (umem left untouched)
+ */
+static bool umem_huge_realloc(struct umem *umem, size_t new_size)
+{
+    if (likely(new_size <= umem->real_size)) {
+        umem->size = new_size;
+        return true;
+    }
+
+    struct umem new_umem;
+    if (!umem_huge_alloc(umem->mgr, &new_umem, new_size))
+        return false;
+    memcpy(new_umem.buffer, umem->buffer, umem->size);
+    umem_huge_free(umem);
+    *umem = new_umem;
+    return true;
+}
+
+/** @This instructs an existing umem manager to release all structures
+ * currently kept in pools. Buffers of the arena are kept in the spill lists,
+ * as the arena itself is only released with the manager. It is intended as a
+ * debug tool only.
+ *
+ * @param mgr pointer to umem manager
+ */
+static void umem_huge_mgr_vacuum(struct umem_mgr *mgr)
+{
+    struct umem_huge_mgr *huge_mgr = umem_huge_mgr_from_umem_mgr(mgr);
+
+    for (unsigned int i = 0; i < huge_mgr->nb_pools; i++) {
+        uint8_t *buffer;
+        umagazine_vacuum(&huge_mgr->huge_pools[i].magazine);
+        while ((buffer = ulifo_pop(&huge_mgr->pools[i], uint8_t *)) != NULL)
+            umem_huge_release(&huge_mgr->huge_pools[i], buffer);
+    }
+}
+
+/** @This frees a umem manager.
+ *
+ * @param urefcount pointer to urefcount
+ */
+static void umem_huge_mgr_free(struct urefcount *urefcount)
+{
+    struct umem_huge_mgr *huge_mgr = umem_huge_mgr_from_urefcount(urefcount);
+
+    for (unsigned int i = 0; i < huge_mgr->nb_pools; i++) {
+        uint8_t *buffer;
+        umagazine_clean(&huge_mgr->huge_pools[i].magazine);
+        while ((buffer = ulifo_pop(&huge_mgr->pools[i], uint8_t *)) != NULL)
+            umem_huge_release(&huge_mgr->huge_pools[i], buffer);
+        ulifo_clean(&huge_mgr->pools[i]);
+    }
+
+    munmap(huge_mgr->arena, huge_mgr->arena_size);
+    pthread_mutex_destroy(&huge_mgr->lock);
+    urefcount_clean(urefcount);
+    free(huge_mgr);
+}
+
+/** @internal @This reserves the arena, with explicit huge pages if they are
+ * available, or with transparent huge pages otherwise, and binds it to a NUMA
+ * node.
+ *
+ * @param huge_mgr pointer to the private structure, filled in with the arena
+ * @param arena_size requested size of the arena
+ * @param numa_node NUMA node to bind the arena to, or -1
+ * @return false in case of error
+ */
+static bool umem_huge_arena_alloc(struct umem_huge_mgr *huge_mgr,
+                                  size_t arena_size, int numa_node)
+{
+    arena_size = (arena_size + UMEM_HUGE_PAGE_SIZE - 1) &
+                 ~(size_t)(UMEM_HUGE_PAGE_SIZE - 1);
+    huge_mgr->arena_size = arena_size;
+    huge_mgr->hugetlb = false;
+
+    void *arena = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    arena = mmap(NULL, arena_size, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    huge_mgr->hugetlb = arena != MAP_FAILED;
+#endif
+
+    if (arena == MAP_FAILED) {
+        /* map one more huge page so that the arena may be aligned */
+        uint8_t *map = mmap(NULL, arena_size + UMEM_HUGE_PAGE_SIZE,
+                            PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (unlikely(map == MAP_FAILED))
+            return false;
+        uint8_t *start = (uint8_t *)(((uintptr_t)map + UMEM_HUGE_PAGE_SIZE - 1) &
+                                     ~(uintptr_t)(UMEM_HUGE_PAGE_SIZE - 1));
+        if (start > map)
+            munmap(map, start - map);
+        if (start + arena_size < map + arena_size + UMEM_HUGE_PAGE_SIZE)
+            munmap(start + arena_size,
+                   map + arena_size + UMEM_HUGE_PAGE_SIZE -
+                   (start + arena_size));
+        arena = start;
+#ifdef MADV_HUGEPAGE
+        madvise(arena, arena_size, MADV_HUGEPAGE);
+#endif
+    }
+
+    if (numa_node >= 0) {
+#ifdef SYS_mbind
+        unsigned long mask[(numa_node / (8 * sizeof(unsigned long))) + 1];
+        memset(mask, 0, sizeof(mask));
+        mask[numa_node / (8 * sizeof(unsigned long))] =
+            1UL << (numa_node % (8 * sizeof(unsigned long)));
+        if (unlikely(syscall(SYS_mbind, arena, arena_size, MPOL_BIND,
+                             mask, (unsigned long)numa_node + 2, 0) != 0)) {
+            munmap(arena, arena_size);
+            return false;
+        }
+#else
+        munmap(arena, arena_size);
+        return false;
+#endif
+    }
+
+    /* prefault the arena so that page faults do not happen in the data path */
+    for (size_t offset = 0; offset < arena_size;
+         offset += UMEM_HUGE_SMALL_PAGE_SIZE)
+        ((volatile uint8_t *)arena)[offset] = 0;
+
+    huge_mgr->arena = arena;
+    return true;
+}
+
+/** @This returns whether the arena of a umem huge manager is backed by
+ * explicitly reserved huge pages (MAP_HUGETLB), as opposed to transparent
+ * huge pages or regular pages.
+ *
+ * @param mgr pointer to a umem manager allocated by @ref umem_huge_mgr_alloc
+ * @return true if the arena uses MAP_HUGETLB
+ */
+bool umem_huge_mgr_hugetlb(struct umem_mgr *mgr)
+{
+    struct umem_huge_mgr *huge_mgr = umem_huge_mgr_from_umem_mgr(mgr);
+    return huge_mgr->hugetlb;
+}
+
+/** @This allocates a new instance of the umem huge manager allocating buffers
+ * from a huge page arena, using pools in power of 2's.
+ *
+ * @param arena_size size (in octets) of the arena to reserve, rounded up to
+ * the huge page size
+ * @param numa_node NUMA node to bind the arena to, or -1
+ * @param pool0_size size (in octets) of the smallest allocatable buffer; it
+ * must be a power of 2
+ * @param nb_pools number of buffer pools to maintain, with sizes in power of
+ * 2's increments, followed, for each pool, by the maximum number of buffers
+ * to keep in the pool (unsigned int); larger buffers will be directly managed
+ * with malloc() and free()
+ * @return pointer to manager, or NULL in case of error
+ */
+struct umem_mgr *umem_huge_mgr_alloc(size_t arena_size, int numa_node,
+                                     size_t pool0_size, size_t nb_pools, ...)
+{
+    assert(pool0_size >= sizeof(void *));
+    assert(!(pool0_size & (pool0_size - 1)));
+
+    size_t alloc_size = sizeof(struct umem_huge_mgr) +
+                        sizeof(struct ulifo) * nb_pools +
+                        sizeof(struct umem_huge_pool) * nb_pools;
+    unsigned int pools_depths[nb_pools];
+    va_list args;
+    va_start(args, nb_pools);
+    for (unsigned int i = 0; i < nb_pools; i++) {
+        pools_depths[i] = va_arg(args, unsigned int);
+        assert(pools_depths[i] <= UINT16_MAX);
+        alloc_size += ulifo_sizeof(pools_depths[i]);
+    }
+    va_end(args);
+
+    struct umem_huge_mgr *huge_mgr = malloc(alloc_size);
+    if (unlikely(huge_mgr == NULL))
+        return NULL;
+
+    if (unlikely(!umem_huge_arena_alloc(huge_mgr, arena_size, numa_node))) {
+        free(huge_mgr);
+        return NULL;
+    }
+    pthread_mutex_init(&huge_mgr->lock, NULL);
+    huge_mgr->arena_used = 0;
+    huge_mgr->pool0_size = pool0_size;
+    huge_mgr->nb_pools = nb_pools;
+
+    huge_mgr->huge_pools = (void *)huge_mgr + sizeof(struct umem_huge_mgr) +
+                           sizeof(struct ulifo) * nb_pools;
+    void *extra = (void *)huge_mgr->huge_pools +
+                  sizeof(struct umem_huge_pool) * nb_pools;
+
+    for (unsigned int i = 0; i < nb_pools; i++) {
+        struct umem_huge_pool *huge_pool = &huge_mgr->huge_pools[i];
+        huge_pool->huge_mgr = huge_mgr;
+        huge_pool->spill = NULL;
+        ulifo_init(&huge_mgr->pools[i], pools_depths[i], extra);
+        extra += ulifo_sizeof(pools_depths[i]);
+        /* a quarter of the pool may be kept by each thread, and the whole
+         * pool by all threads together */
+        umagazine_init(&huge_pool->magazine, &huge_mgr->pools[i],
+                       (pool0_size << i) <= UMEM_HUGE_MAGAZINE_MAX_SIZE ?
+                       pools_depths[i] / 4 : 0, pools_depths[i],
+                       umem_huge_release, huge_pool);
+    }
+
+    urefcount_init(umem_huge_mgr_to_urefcount(huge_mgr), umem_huge_mgr_free);
+    huge_mgr->mgr.refcount = umem_huge_mgr_to_urefcount(huge_mgr);
+    huge_mgr->mgr.umem_alloc = umem_huge_alloc;
+    huge_mgr->mgr.umem_realloc = umem_huge_realloc;
+    huge_mgr->mgr.umem_free = umem_huge_free;
+    huge_mgr->mgr.umem_mgr_vacuum = umem_huge_mgr_vacuum;
+
+    return umem_huge_mgr_to_umem_mgr(huge_mgr);
+}
+
+/** @This allocates a new instance of the umem huge manager allocating buffers
+ * from a huge page arena, using pools in power of 2's from 4 KiB to 64 MiB,
+ * with a simpler API.
+ *
+ * @param arena_size size (in octets) of the arena to reserve, rounded up to
+ * the huge page size
+ * @param numa_node NUMA node to bind the arena to, or -1
+ * @param base_pools_depth number of buffers to keep in the pool for the smaller
+ * buffers; for larger buffers the same number is used, divided by 2, 4, or 8
+ * @return pointer to manager, or NULL in case of error
+ */
+struct umem_mgr *umem_huge_mgr_alloc_simple(size_t arena_size, int numa_node,
+                                            uint16_t base_pools_depth)
+{
+    return umem_huge_mgr_alloc(arena_size, numa_node, 4096, 15,
+                               base_pools_depth, /* 4 Ki */
+                               base_pools_depth, /* 8 Ki */
+                               base_pools_depth, /* 16 Ki */
+                               base_pools_depth, /* 32 Ki */
+                               base_pools_depth / 2, /* 64 Ki */
+                               base_pools_depth / 2, /* 128 Ki */
+                               base_pools_depth / 2, /* 256 Ki */
+                               base_pools_depth / 2, /* 512 Ki */
+                               base_pools_depth / 4, /* 1 Mi */
+                               base_pools_depth / 4, /* 2 Mi */
+                               base_pools_depth / 4, /* 4 Mi */
+                               base_pools_depth / 4, /* 8 Mi */
+                               base_pools_depth / 8, /* 16 Mi */
+                               base_pools_depth / 8, /* 32 Mi */
+                               base_pools_depth / 8); /* 64 Mi */
+}
@@ -26,13 +26,18 @@
 #include <upipe/ubase.h>
 #include <upipe/urefcount.h>
 #include <upipe/ulifo.h>
+#include <upipe/umagazine.h>
 #include <upipe/umem.h>
 #include <upipe/umem_pool.h>
 
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 #include <assert.h>
 
+/** buffers larger than this are not kept in per-thread magazines */
+#define UMEM_POOL_MAGAZINE_MAX_SIZE 65536
+
 /** @This defines the private data structures of the umem pool manager. */
 struct umem_pool_mgr {
     /** refcount management structure */
@@ -45,6 +50,8 @@ struct umem_pool_mgr {
     size_t pool0_size;
     /** number of pools of buffers */
     size_t nb_pools;
+    /** per-thread magazines in front of each pool */
+    struct umagazine *magazines;
     /** buffer pools */
     struct ulifo pools[];
 };
@@ -92,7 +99,7 @@ static bool umem_pool_alloc(struct umem_mgr *mgr, struct umem *umem,
     uint8_t *buffer = NULL;
 
     if (likely(pool < pool_mgr->nb_pools))
-        buffer = ulifo_pop(&pool_mgr->pools[pool], uint8_t *);
+        buffer = umagazine_pop(&pool_mgr->magazines[pool], uint8_t *);
     if (unlikely(buffer == NULL))
         buffer = malloc(real_size);
     if (unlikely(buffer == NULL))
@@ -117,13 +124,24 @@ static void umem_pool_free(struct umem *umem)
     struct umem_pool_mgr *pool_mgr = umem_pool_mgr_from_umem_mgr(umem->mgr);
     unsigned int pool = umem_pool_find(umem->mgr, umem->real_size, NULL);
 
-    if (unlikely(pool >= pool_mgr->nb_pools ||
-                 !ulifo_push(&pool_mgr->pools[pool], umem->buffer)))
+    if (likely(pool < pool_mgr->nb_pools))
+        umagazine_push(&pool_mgr->magazines[pool], umem->buffer);
+    else
         free(umem->buffer);
     umem->buffer = NULL;
     umem->mgr = NULL;
 }
 
+/** @internal @This releases buffers which do not fit in a pool.
+ *
+ * @param opaque unused
+ * @param buffer buffer to free
+ */
+static void umem_pool_free_magazine(void *opaque, void *buffer)
+{
+    free(buffer);
+}
+
 /** @This resizes a umem. We do not realloc() the buffer because it would
  * artificially grow the size of a pool, and create a malloc/free contention.
  *
@@ -160,6 +178,7 @@ static void umem_pool_mgr_vacuum(struct umem_mgr *mgr)
 
     for (unsigned int i = 0; i < pool_mgr->nb_pools; i++) {
         uint8_t *buffer;
+        umagazine_vacuum(&pool_mgr->magazines[i]);
         while ((buffer = ulifo_pop(&pool_mgr->pools[i], uint8_t *)) != NULL)
             free(buffer);
     }
@@ -174,13 +193,56 @@ static void umem_pool_mgr_free(struct urefcount *urefcount)
     struct umem_pool_mgr *pool_mgr = umem_pool_mgr_from_urefcount(urefcount);
     umem_pool_mgr_vacuum(umem_pool_mgr_to_umem_mgr(pool_mgr));
 
-    for (unsigned int i = 0; i < pool_mgr->nb_pools; i++)
+    for (unsigned int i = 0; i < pool_mgr->nb_pools; i++) {
+        umagazine_clean(&pool_mgr->magazines[i]);
         ulifo_clean(&pool_mgr->pools[i]);
+    }
 
     urefcount_clean(urefcount);
     free(pool_mgr);
 }
 
+/** @This returns the statistics of the per-thread magazines of a umem pool
+ * manager, summed over all pools.
+ *
+ * @param mgr pointer to a umem manager allocated by @ref umem_pool_mgr_alloc
+ * @param stats filled in with the statistics
+ */
+void umem_pool_mgr_stats(struct umem_mgr *mgr, struct umagazine_stats *stats)
+{
+    struct umem_pool_mgr *pool_mgr = umem_pool_mgr_from_umem_mgr(mgr);
+    memset(stats, 0, sizeof(struct umagazine_stats));
+    for (unsigned int i = 0; i < pool_mgr->nb_pools; i++) {
+        struct umagazine_stats pool_stats;
+        umagazine_stats(&pool_mgr->magazines[i], &pool_stats);
+        stats->hits += pool_stats.hits;
+        stats->misses += pool_stats.misses;
+        stats->flushes += pool_stats.flushes;
+    }
+}
+
+/** @This enables per-thread magazines in front of the pools of buffers of
+ * up to 64 KiB. The magazines of all threads together keep at most the
+ * depth of their pool. It must be called before the manager is used.
+ *
+ * @param mgr pointer to a umem manager allocated by @ref umem_pool_mgr_alloc
+ * @param size number of buffers in per-thread magazines (see
+ * @ref umagazine_init), or 0 to disable them
+ */
+void umem_pool_mgr_set_magazines(struct umem_mgr *mgr, unsigned int size)
+{
+    struct umem_pool_mgr *pool_mgr = umem_pool_mgr_from_umem_mgr(mgr);
+
+    for (unsigned int i = 0; i < pool_mgr->nb_pools; i++) {
+        struct ulifo *pool = &pool_mgr->pools[i];
+        umagazine_clean(&pool_mgr->magazines[i]);
+        umagazine_init(&pool_mgr->magazines[i], pool,
+                       (pool_mgr->pool0_size << i) <=
+                       UMEM_POOL_MAGAZINE_MAX_SIZE ? size : 0,
+                       pool->uring.length, umem_pool_free_magazine, NULL);
+    }
+}
+
 /** @This allocates a new instance of the umem pool manager allocating buffers
  * from application memory, using pools in power of 2's.
  *
@@ -195,7 +257,8 @@ static void umem_pool_mgr_free(struct urefcount *urefcount)
 struct umem_mgr *umem_pool_mgr_alloc(size_t pool0_size, size_t nb_pools, ...)
 {
     size_t alloc_size = sizeof(struct umem_pool_mgr) +
-                        sizeof(struct ulifo) * nb_pools;
+                        sizeof(struct ulifo) * nb_pools +
+                        sizeof(struct umagazine) * nb_pools;
     unsigned int pools_depths[nb_pools];
     va_list args;
     va_start(args, nb_pools);
@@ -213,12 +276,16 @@ struct umem_mgr *umem_pool_mgr_alloc(size_t pool0_size, size_t nb_pools, ...)
     pool_mgr->pool0_size = pool0_size;
     pool_mgr->nb_pools = nb_pools;
 
-    void *extra = (void *)pool_mgr + sizeof(struct umem_pool_mgr) +
-                  sizeof(struct ulifo) * nb_pools;
+    pool_mgr->magazines = (void *)pool_mgr + sizeof(struct umem_pool_mgr) +
+                          sizeof(struct ulifo) * nb_pools;
+    void *extra = (void *)pool_mgr->magazines +
+                  sizeof(struct umagazine) * nb_pools;
 
     for (unsigned int i = 0; i < nb_pools; i++) {
         ulifo_init(&pool_mgr->pools[i], pools_depths[i], extra);
         extra += ulifo_sizeof(pools_depths[i]);
+        umagazine_init(&pool_mgr->magazines[i], &pool_mgr->pools[i], 0, 0,
+                       umem_pool_free_magazine, NULL);
     }
 
     urefcount_init(umem_pool_mgr_to_urefcount(pool_mgr), umem_pool_mgr_free);
@@ -0,0 +1,224 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe instrumentation counters of pipes
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/uref.h>
+#include <upipe/uref_block.h>
+#include <upipe/upipe.h>
+#include <upipe/upipe_stats.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <time.h>
+#include <pthread.h>
+
+/** @internal @This is an instrumented input call in progress in a thread. */
+struct upipe_stats_frame {
+    /** counters of the pipe */
+    struct upipe_stats *stats;
+    /** time spent in the instrumented pipes called from this one */
+    uint64_t child_time;
+    /** frame of the calling pipe, or NULL */
+    struct upipe_stats_frame *caller;
+};
+
+/** key to the current frame of each thread */
+static pthread_key_t upipe_stats_key;
+/** makes sure the key is only created once */
+static pthread_once_t upipe_stats_once = PTHREAD_ONCE_INIT;
+
+/** @internal @This creates the key to the current frames. */
+static void upipe_stats_key_init(void)
+{
+    pthread_key_create(&upipe_stats_key, NULL);
+}
+
+/** @This initializes the counters of a pipe.
+ *
+ * @param stats pointer to the counters
+ */
+void upipe_stats_init(struct upipe_stats *stats)
+{
+    pthread_once(&upipe_stats_once, upipe_stats_key_init);
+    uatomic64_init(&stats->urefs_in, 0);
+    uatomic64_init(&stats->urefs_out, 0);
+    uatomic64_init(&stats->bytes_in, 0);
+    uatomic64_init(&stats->bytes_out, 0);
+    uatomic64_init(&stats->total_time, 0);
+    uatomic64_init(&stats->self_time, 0);
+    uatomic64_init(&stats->max_time, 0);
+    for (unsigned int i = 0; i < UPIPE_STATS_BUCKETS; i++)
+        uatomic64_init(&stats->histogram[i], 0);
+    uatomic64_init(&stats->queue_depth, 0);
+    uatomic64_init(&stats->queue_depth_max, 0);
+}
+
+/** @This cleans up the counters of a pipe.
+ *
+ * @param stats pointer to the counters
+ */
+void upipe_stats_clean(struct upipe_stats *stats)
+{
+    uatomic64_clean(&stats->urefs_in);
+    uatomic64_clean(&stats->urefs_out);
+    uatomic64_clean(&stats->bytes_in);
+    uatomic64_clean(&stats->bytes_out);
+    uatomic64_clean(&stats->total_time);
+    uatomic64_clean(&stats->self_time);
+    uatomic64_clean(&stats->max_time);
+    for (unsigned int i = 0; i < UPIPE_STATS_BUCKETS; i++)
+        uatomic64_clean(&stats->histogram[i]);
+    uatomic64_clean(&stats->queue_depth);
+    uatomic64_clean(&stats->queue_depth_max);
+}
+
+/** @This returns the current date used by the counters.
+ *
+ * @return monotonic date in nanoseconds
+ */
+uint64_t upipe_stats_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * UINT64_C(1000000000) + ts.tv_nsec;
+}
+
+/** @internal @This sends an input buffer into an instrumented pipe, and
+ * updates its counters.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure to send
+ * @param upump_p reference to the pump that generated the buffer
+ */
+void upipe_stats_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    struct upipe_stats *stats = upipe->stats;
+    struct upipe_stats_frame frame;
+    frame.stats = stats;
+    frame.child_time = 0;
+    frame.caller = pthread_getspecific(upipe_stats_key);
+
+    size_t size = 0;
+    if (uref->ubuf != NULL && !ubase_check(uref_block_size(uref, &size)))
+        size = 0;
+    upipe_stats_add(&stats->urefs_in, 1);
+    upipe_stats_add(&stats->bytes_in, size);
+    if (frame.caller != NULL) {
+        upipe_stats_add(&frame.caller->stats->urefs_out, 1);
+        upipe_stats_add(&frame.caller->stats->bytes_out, size);
+    }
+
+    pthread_setspecific(upipe_stats_key, &frame);
+    upipe_use(upipe);
+    uint64_t start = upipe_stats_now();
+    upipe->mgr->upipe_input(upipe, uref, upump_p);
+    uint64_t duration = upipe_stats_now() - start;
+    pthread_setspecific(upipe_stats_key, frame.caller);
+
+    uint64_t self = duration > frame.child_time ?
+                    duration - frame.child_time : 0;
+    upipe_stats_add(&stats->total_time, duration);
+    upipe_stats_add(&stats->self_time, self);
+    upipe_stats_max(&stats->max_time, self);
+    unsigned int bucket = self ? 64 - __builtin_clzll(self) : 0;
+    if (bucket >= UPIPE_STATS_BUCKETS)
+        bucket = UPIPE_STATS_BUCKETS - 1;
+    upipe_stats_add(&stats->histogram[bucket], 1);
+    if (frame.caller != NULL)
+        frame.caller->child_time += duration;
+
+    /* this may free the pipe and its counters */
+    upipe_release(upipe);
+}
+
+/** @This returns an upper bound of the given percentile of the self time of
+ * calls, from the histogram.
+ *
+ * @param stats pointer to the counters
+ * @param percentile percentile between 0 and 100
+ * @return duration in nanoseconds, or 0 if there was no call
+ */
+uint64_t upipe_stats_percentile(const struct upipe_stats *stats,
+                                unsigned int percentile)
+{
+    uint64_t total = 0;
+    uint64_t histogram[UPIPE_STATS_BUCKETS];
+    for (unsigned int i = 0; i < UPIPE_STATS_BUCKETS; i++) {
+        histogram[i] = upipe_stats_get(&stats->histogram[i]);
+        total += histogram[i];
+    }
+    if (!total)
+        return 0;
+
+    uint64_t rank = (total * percentile + 99) / 100;
+    uint64_t count = 0;
+    for (unsigned int i = 0; i < UPIPE_STATS_BUCKETS - 1; i++) {
+        count += histogram[i];
+        if (count >= rank)
+            return UINT64_C(1) << i;
+    }
+    return upipe_stats_get(&stats->max_time);
+}
+
+/** @This prints the header of the lines printed by @ref upipe_stats_dump.
+ *
+ * @param file file to print to
+ */
+void upipe_stats_dump_header(FILE *file)
+{
+    fprintf(file, "%-32s %10s %10s %12s %10s %10s %6s %9s %9s %9s %7s\n",
+            "pipe", "urefs in", "urefs out", "octets in", "total ms",
+            "self ms", "load", "p50 us", "p99 us", "max us", "queue");
+}
+
+/** @This prints the counters of a pipe on a single line.
+ *
+ * @param stats pointer to the counters
+ * @param name name of the pipe
+ * @param elapsed duration of the measurement, in nanoseconds, to print the
+ * load of the pipe, or 0
+ * @param file file to print to
+ */
+void upipe_stats_dump(const struct upipe_stats *stats, const char *name,
+                      uint64_t elapsed, FILE *file)
+{
+    uint64_t self_time = upipe_stats_get(&stats->self_time);
+    fprintf(file, "%-32s %10"PRIu64" %10"PRIu64" %12"PRIu64" %10.1f %10.1f "
+            "%5.1f%% %9.1f %9.1f %9.1f %3"PRIu64"/%-3"PRIu64"\n",
+            name, upipe_stats_get(&stats->urefs_in),
+            upipe_stats_get(&stats->urefs_out),
+            upipe_stats_get(&stats->bytes_in),
+            upipe_stats_get(&stats->total_time) / 1e6,
+            self_time / 1e6, elapsed ? 100. * self_time / elapsed : 0.,
+            upipe_stats_percentile(stats, 50) / 1e3,
+            upipe_stats_percentile(stats, 99) / 1e3,
+            upipe_stats_get(&stats->max_time) / 1e3,
+            upipe_stats_get(&stats->queue_depth),
+            upipe_stats_get(&stats->queue_depth_max));
+}
@@ -305,6 +305,7 @@ struct uprobe *uprobe_dejitter_init(struct uprobe_dejitter *uprobe_dejitter,
     uprobe_dejitter->last_print = 0;
     uprobe_dejitter_set(uprobe, enabled, deviation);
     uprobe_init(uprobe, uprobe_dejitter_throw, next);
+    uprobe_set_log_mode(uprobe, UPROBE_LOG_MODE_FORWARD, UPROBE_LOG_VERBOSE);
     return uprobe;
 }
 
@@ -79,6 +79,7 @@ struct uprobe *uprobe_loglevel_init(struct uprobe_loglevel *uprobe_loglevel,
     assert(uprobe_loglevel);
     struct uprobe *uprobe = uprobe_loglevel_to_uprobe(uprobe_loglevel);
     uprobe_init(uprobe, uprobe_loglevel_throw, next);
+    uprobe_set_log_mode(uprobe, UPROBE_LOG_MODE_FORWARD, min_level);
     ulist_init(&uprobe_loglevel->patterns);
     uprobe_loglevel->min_level = min_level;
     return uprobe;
@@ -88,6 +89,13 @@ void uprobe_loglevel_clean(struct uprobe_loglevel *uprobe_loglevel)
 {
     assert(uprobe_loglevel != NULL);
     struct uprobe *uprobe = uprobe_loglevel_to_uprobe(uprobe_loglevel);
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach(&uprobe_loglevel->patterns, uchain, uchain_tmp) {
+        struct pattern *pattern = pattern_from_uchain(uchain);
+        ulist_delete(uchain);
+        regfree(&pattern->preq);
+        free(pattern);
+    }
     uprobe_clean(uprobe);
 }
 
@@ -115,6 +123,9 @@ int uprobe_loglevel_set(struct uprobe *uprobe,
     }
     pattern->log_level = log_level;
     ulist_add(&uprobe_loglevel->patterns, pattern_to_uchain(pattern));
+    /* messages matching the pattern may now pass through */
+    if (log_level < uprobe->log_level)
+        uprobe->log_level = log_level;
 
     return UBASE_ERR_NONE;
 }
@@ -91,9 +91,23 @@ struct uprobe *uprobe_pfx_init(struct uprobe_pfx *uprobe_pfx,
         uprobe_pfx->name = NULL;
     uprobe_pfx->min_level = min_level;
     uprobe_init(uprobe, uprobe_pfx_throw, next);
+    uprobe_set_log_mode(uprobe, UPROBE_LOG_MODE_FORWARD, min_level);
     return uprobe;
 }
 
+/** @This returns the name of a pipe if the given probe is a uprobe pfx.
+ *
+ * @param uprobe pointer to any probe
+ * @return name of the pipe, or NULL if the probe is not a uprobe pfx or has
+ * no name
+ */
+const char *uprobe_pfx_get_name(struct uprobe *uprobe)
+{
+    if (uprobe == NULL || uprobe->uprobe_throw != uprobe_pfx_throw)
+        return NULL;
+    return uprobe_pfx_from_uprobe(uprobe)->name;
+}
+
 /** @This cleans a uprobe_pfx structure.
  *
  * @param uprobe_pfx structure to clean
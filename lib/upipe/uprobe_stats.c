@@ -0,0 +1,249 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short probe instrumenting the pipes using it
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/ulist.h>
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/uprobe_stats.h>
+#include <upipe/uprobe_helper_alloc.h>
+#include <upipe/upipe.h>
+#include <upipe/upipe_stats.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <assert.h>
+
+/** maximum length of the name of a pipe */
+#define NAME_LENGTH 256
+/** maximum depth of the prefixes of a pipe */
+#define MAX_PREFIXES 16
+
+/** @internal @This stores the counters of an instrumented pipe. */
+struct uprobe_stats_pipe {
+    /** structure for the list of pipes */
+    struct uchain uchain;
+    /** pointer to the pipe */
+    struct upipe *upipe;
+    /** name of the pipe */
+    char *name;
+    /** counters */
+    struct upipe_stats stats;
+};
+
+UBASE_FROM_TO(uprobe_stats_pipe, uchain, uchain, uchain)
+
+/** @internal @This builds the name of a pipe from the prefix probes between
+ * the pipe and this probe, outermost first like log messages.
+ *
+ * @param uprobe pointer to probe
+ * @param upipe pointer to pipe
+ * @return allocated name
+ */
+static char *uprobe_stats_name(struct uprobe *uprobe, struct upipe *upipe)
+{
+    const char *prefixes[MAX_PREFIXES];
+    unsigned int nb_prefixes = 0;
+    for (struct uprobe *probe = upipe->uprobe;
+         probe != NULL && probe != uprobe && nb_prefixes < MAX_PREFIXES;
+         probe = probe->next) {
+        const char *name = uprobe_pfx_get_name(probe);
+        if (name != NULL)
+            prefixes[nb_prefixes++] = name;
+    }
+
+    char name[NAME_LENGTH] = "";
+    size_t len = 0;
+    while (nb_prefixes && len < NAME_LENGTH)
+        len += snprintf(name + len, NAME_LENGTH - len, len ? " %s" : "%s",
+                        prefixes[--nb_prefixes]);
+    if (!len)
+        snprintf(name, NAME_LENGTH, "%p", upipe);
+    return strdup(name);
+}
+
+/** @internal @This attaches counters to a new pipe.
+ *
+ * @param uprobe pointer to probe
+ * @param upipe pointer to pipe
+ */
+static void uprobe_stats_attach(struct uprobe *uprobe, struct upipe *upipe)
+{
+    struct uprobe_stats *uprobe_stats = uprobe_stats_from_uprobe(uprobe);
+    struct uprobe_stats_pipe *pipe = malloc(sizeof(struct uprobe_stats_pipe));
+    if (unlikely(pipe == NULL))
+        return;
+    pipe->name = uprobe_stats_name(uprobe, upipe);
+    if (unlikely(pipe->name == NULL)) {
+        free(pipe);
+        return;
+    }
+    pipe->upipe = upipe;
+    upipe_stats_init(&pipe->stats);
+
+    pthread_mutex_lock(&uprobe_stats->lock);
+    ulist_add(&uprobe_stats->pipes, uprobe_stats_pipe_to_uchain(pipe));
+    pthread_mutex_unlock(&uprobe_stats->lock);
+    upipe->stats = &pipe->stats;
+}
+
+/** @internal @This reports and detaches the counters of a dying pipe.
+ *
+ * @param uprobe pointer to probe
+ * @param upipe pointer to pipe
+ */
+static void uprobe_stats_detach(struct uprobe *uprobe, struct upipe *upipe)
+{
+    struct uprobe_stats *uprobe_stats = uprobe_stats_from_uprobe(uprobe);
+    struct uprobe_stats_pipe *pipe = NULL;
+    struct uchain *uchain;
+
+    /* the counters may have been attached by another probe */
+    pthread_mutex_lock(&uprobe_stats->lock);
+    ulist_foreach(&uprobe_stats->pipes, uchain) {
+        struct uprobe_stats_pipe *entry =
+            uprobe_stats_pipe_from_uchain(uchain);
+        if (entry->upipe == upipe) {
+            ulist_delete(uchain);
+            pipe = entry;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&uprobe_stats->lock);
+    if (pipe == NULL)
+        return;
+
+    uprobe_throw(uprobe->next, upipe, UPROBE_STATS, &pipe->stats);
+    upipe->stats = NULL;
+    upipe_stats_clean(&pipe->stats);
+    free(pipe->name);
+    free(pipe);
+}
+
+/** @internal @This catches events thrown by pipes.
+ *
+ * @param uprobe pointer to probe
+ * @param upipe pointer to pipe throwing the event
+ * @param event event thrown
+ * @param args optional event-specific parameters
+ * @return an error code
+ */
+static int uprobe_stats_throw(struct uprobe *uprobe, struct upipe *upipe,
+                              int event, va_list args)
+{
+    if (upipe != NULL) {
+        if (event == UPROBE_READY && upipe->stats == NULL)
+            uprobe_stats_attach(uprobe, upipe);
+        else if (event == UPROBE_DEAD && upipe->stats != NULL)
+            uprobe_stats_detach(uprobe, upipe);
+    }
+    return uprobe_throw_next(uprobe, upipe, event, args);
+}
+
+/** @This initializes an already allocated uprobe stats structure.
+ *
+ * @param uprobe_stats pointer to the already allocated structure
+ * @param next next probe to test if this one doesn't catch the event
+ * @return pointer to uprobe, or NULL in case of error
+ */
+struct uprobe *uprobe_stats_init(struct uprobe_stats *uprobe_stats,
+                                 struct uprobe *next)
+{
+    assert(uprobe_stats != NULL);
+    struct uprobe *uprobe = uprobe_stats_to_uprobe(uprobe_stats);
+    if (unlikely(pthread_mutex_init(&uprobe_stats->lock, NULL) != 0))
+        return NULL;
+    ulist_init(&uprobe_stats->pipes);
+    uprobe_stats->start = upipe_stats_now();
+    uprobe_init(uprobe, uprobe_stats_throw, next);
+    uprobe_set_log_mode(uprobe, UPROBE_LOG_MODE_FORWARD, UPROBE_LOG_VERBOSE);
+    return uprobe;
+}
+
+/** @This cleans a uprobe stats structure.
+ *
+ * @param uprobe_stats structure to clean
+ */
+void uprobe_stats_clean(struct uprobe_stats *uprobe_stats)
+{
+    assert(uprobe_stats != NULL);
+    struct uprobe *uprobe = uprobe_stats_to_uprobe(uprobe_stats);
+    /* the probe is only released when all pipes using it are dead */
+    assert(ulist_empty(&uprobe_stats->pipes));
+    pthread_mutex_destroy(&uprobe_stats->lock);
+    uprobe_clean(uprobe);
+}
+
+#define ARGS_DECL struct uprobe *next
+#define ARGS next
+UPROBE_HELPER_ALLOC(uprobe_stats)
+#undef ARGS
+#undef ARGS_DECL
+
+/** @This prints the counters of all pipes currently instrumented by the
+ * probe. It may be called from any thread.
+ *
+ * @param uprobe pointer to probe
+ * @param file file to print to
+ */
+void uprobe_stats_dump(struct uprobe *uprobe, FILE *file)
+{
+    struct uprobe_stats *uprobe_stats = uprobe_stats_from_uprobe(uprobe);
+    uint64_t elapsed = upipe_stats_now() - uprobe_stats->start;
+    struct uchain *uchain;
+
+    upipe_stats_dump_header(file);
+    pthread_mutex_lock(&uprobe_stats->lock);
+    ulist_foreach(&uprobe_stats->pipes, uchain) {
+        struct uprobe_stats_pipe *pipe =
+            uprobe_stats_pipe_from_uchain(uchain);
+        upipe_stats_dump(&pipe->stats, pipe->name, elapsed, file);
+    }
+    pthread_mutex_unlock(&uprobe_stats->lock);
+}
+
+/** @This throws a @ref UPROBE_STATS event to the next probe for every pipe
+ * currently instrumented by the probe. As with all events, it must be called
+ * from the thread running the pipes. The next probe must not call
+ * @ref uprobe_stats_dump.
+ *
+ * @param uprobe pointer to probe
+ */
+void uprobe_stats_report(struct uprobe *uprobe)
+{
+    struct uprobe_stats *uprobe_stats = uprobe_stats_from_uprobe(uprobe);
+    struct uchain *uchain;
+    pthread_mutex_lock(&uprobe_stats->lock);
+    ulist_foreach(&uprobe_stats->pipes, uchain) {
+        struct uprobe_stats_pipe *pipe =
+            uprobe_stats_pipe_from_uchain(uchain);
+        uprobe_throw(uprobe->next, pipe->upipe, UPROBE_STATS, &pipe->stats);
+    }
+    pthread_mutex_unlock(&uprobe_stats->lock);
+}
@@ -82,7 +82,9 @@ static int uprobe_stdio_throw(struct uprobe *uprobe, struct upipe *upipe,
         tmp += sprintf(tmp, "[%s] ", ulog_pfx->tag);
     }
 
-    fprintf(uprobe_stdio->stream, "%s: %s%s\n", level_name, buffer, ulog->msg);
+    char msg_buffer[ulog_msg_size(ulog)];
+    const char *msg = ulog_msg(ulog, msg_buffer, sizeof(msg_buffer));
+    fprintf(uprobe_stdio->stream, "%s: %s%s\n", level_name, buffer, msg);
     return UBASE_ERR_NONE;
 }
 
@@ -103,6 +105,7 @@ struct uprobe *uprobe_stdio_init(struct uprobe_stdio *uprobe_stdio,
     uprobe_stdio->stream = stream;
     uprobe_stdio->min_level = min_level;
     uprobe_init(uprobe, uprobe_stdio_throw, next);
+    uprobe_set_log_mode(uprobe, UPROBE_LOG_MODE_SINK, min_level);
     return uprobe;
 }
 
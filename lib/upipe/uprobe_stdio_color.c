@@ -157,8 +157,10 @@ static int uprobe_stdio_color_throw(struct uprobe *uprobe,
             break;
         }
 
+    char msg_buffer[ulog_msg_size(ulog)];
+    const char *msg = ulog_msg(ulog, msg_buffer, sizeof(msg_buffer));
     fprintf(uprobe_stdio_color->stream, LEVEL("%s", "%*s") ": %s %s\n",
-            level.color, LEVEL_NAME_LEN, level.name, buffer, ulog->msg);
+            level.color, LEVEL_NAME_LEN, level.name, buffer, msg);
 
     return UBASE_ERR_NONE;
 }
@@ -177,6 +179,7 @@ struct uprobe *uprobe_stdio_color_init(
     assert(uprobe_stdio_color != NULL);
     struct uprobe *uprobe = uprobe_stdio_color_to_uprobe(uprobe_stdio_color);
     uprobe_init(uprobe, uprobe_stdio_color_throw, next);
+    uprobe_set_log_mode(uprobe, UPROBE_LOG_MODE_SINK, min_level);
     uprobe_stdio_color->stream = stream;
     uprobe_stdio_color->min_level = min_level;
     return uprobe;
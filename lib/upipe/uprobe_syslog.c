@@ -93,7 +93,9 @@ static int uprobe_syslog_throw(struct uprobe *uprobe, struct upipe *upipe,
         tmp += sprintf(tmp, "[%s] ", ulog_pfx->tag);
     }
 
-    syslog(priority, "%s%s", buffer, ulog->msg);
+    char msg_buffer[ulog_msg_size(ulog)];
+    const char *msg = ulog_msg(ulog, msg_buffer, sizeof(msg_buffer));
+    syslog(priority, "%s%s", buffer, msg);
     return UBASE_ERR_NONE;
 }
 
@@ -130,6 +132,7 @@ struct uprobe *uprobe_syslog_init(struct uprobe_syslog *uprobe_syslog,
         openlog(uprobe_syslog->ident, option, facility);
 
     uprobe_init(uprobe, uprobe_syslog_throw, next);
+    uprobe_set_log_mode(uprobe, UPROBE_LOG_MODE_SINK, min_level);
     return uprobe;
 }
 
@@ -148,6 +148,7 @@ struct uprobe *
     uprobe_ubuf_mem_pool->shared_pool_depth = shared_pool_depth;
     uatomic_ptr_init(&uprobe_ubuf_mem_pool->first, NULL);
     uprobe_init(uprobe, uprobe_ubuf_mem_pool_throw, next);
+    uprobe_set_log_mode(uprobe, UPROBE_LOG_MODE_FORWARD, UPROBE_LOG_VERBOSE);
     return uprobe;
 }
 
@@ -80,6 +80,7 @@ struct uprobe *uprobe_uclock_init(struct uprobe_uclock *uprobe_uclock,
     struct uprobe *uprobe = uprobe_uclock_to_uprobe(uprobe_uclock);
     uprobe_uclock->uclock = uclock_use(uclock);
     uprobe_init(uprobe, uprobe_uclock_throw, next);
+    uprobe_set_log_mode(uprobe, UPROBE_LOG_MODE_FORWARD, UPROBE_LOG_VERBOSE);
     return uprobe;
 }
 
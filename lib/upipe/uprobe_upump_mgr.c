@@ -88,6 +88,7 @@ struct uprobe *uprobe_upump_mgr_init(struct uprobe_upump_mgr *uprobe_upump_mgr,
     uprobe_upump_mgr->upump_mgr = upump_mgr_use(upump_mgr);
     uprobe_upump_mgr->frozen = false;
     uprobe_init(uprobe, uprobe_upump_mgr_throw, next);
+    uprobe_set_log_mode(uprobe, UPROBE_LOG_MODE_FORWARD, UPROBE_LOG_VERBOSE);
     return uprobe;
 }
 
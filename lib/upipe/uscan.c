@@ -0,0 +1,421 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe functions to scan buffers for sync words and start codes
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/uscan.h>
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+/** @hidden */
+# define USCAN_X86
+# include <immintrin.h>
+#endif
+
+/** @This is the portable implementation of @ref uscan_sync.
+ *
+ * @param buffer pointer to the buffer
+ * @param size size of the buffer in octets
+ * @param word octet word to scan for
+ * @param stride period of the word in octets
+ * @param count number of occurrences of the word to find, including the
+ * first one
+ * @return offset of the first candidate, or size if none was found
+ */
+size_t uscan_sync_c(const uint8_t *buffer, size_t size, uint8_t word,
+                    size_t stride, unsigned int count)
+{
+    size_t offset = 0;
+    while (offset < size) {
+        const uint8_t *match = memchr(buffer + offset, word, size - offset);
+        if (match == NULL)
+            return size;
+        offset = match - buffer;
+
+        unsigned int i;
+        size_t next = offset + stride;
+        for (i = 1; i < count && next < size; i++, next += stride)
+            if (buffer[next] != word)
+                break;
+        if (i == count || next >= size)
+            return offset;
+        offset++;
+    }
+    return size;
+}
+
+#ifdef USCAN_X86
+/** @internal @This checks the following periods of a mask of candidates
+ * found in an SSE2 register.
+ *
+ * @param p pointer to the last checked period of the register
+ * @param mask mask of candidates in the register
+ * @param words register filled with the octet word
+ * @param stride period of the word in octets
+ * @param count number of occurrences of the word still to check
+ * @return mask of validated candidates
+ */
+__attribute__((target("sse2")))
+static inline unsigned int uscan_sync_sse2_mask(const uint8_t *p,
+        unsigned int mask, __m128i words, size_t stride, unsigned int count)
+{
+    for ( ; mask && count; count--) {
+        p += stride;
+        mask &= _mm_movemask_epi8(_mm_cmpeq_epi8(
+                    _mm_loadu_si128((const __m128i *)p), words));
+    }
+    return mask;
+}
+
+/** @internal @This is the SSE2 implementation of @ref uscan_sync. The
+ * first two periods are compared four registers at a time without
+ * branching, which skips most of the octets of a corrupted stream; the
+ * remaining candidates are then tested sixteen at once, by comparing each
+ * following period and anding the masks until none is left.
+ *
+ * @param buffer pointer to the buffer
+ * @param size size of the buffer in octets
+ * @param word octet word to scan for
+ * @param stride period of the word in octets
+ * @param count number of occurrences of the word to find, including the
+ * first one
+ * @return offset of the first candidate, or size if none was found
+ */
+__attribute__((target("sse2")))
+static size_t uscan_sync_sse2(const uint8_t *buffer, size_t size,
+                              uint8_t word, size_t stride, unsigned int count)
+{
+    const __m128i words = _mm_set1_epi8(word);
+    const size_t span = (count - 1) * stride;
+    size_t offset = 0;
+
+    while (offset + span + 4 * sizeof(__m128i) <= size) {
+        const uint8_t *p = buffer + offset;
+        __m128i v[4];
+        for (int j = 0; j < 4; j++)
+            v[j] = _mm_and_si128(
+                    _mm_cmpeq_epi8(_mm_loadu_si128(
+                            (const __m128i *)p + j), words),
+                    _mm_cmpeq_epi8(_mm_loadu_si128(
+                            (const __m128i *)(p + stride) + j), words));
+        if (likely(!_mm_movemask_epi8(_mm_or_si128(
+                            _mm_or_si128(v[0], v[1]),
+                            _mm_or_si128(v[2], v[3]))))) {
+            offset += 4 * sizeof(__m128i);
+            continue;
+        }
+
+        for (int j = 0; j < 4; j++) {
+            unsigned int mask = uscan_sync_sse2_mask(
+                    p + stride + j * sizeof(__m128i),
+                    _mm_movemask_epi8(v[j]), words, stride, count - 2);
+            if (mask)
+                return offset + __builtin_ctz(mask);
+            offset += sizeof(__m128i);
+        }
+    }
+
+    while (offset + span + sizeof(__m128i) <= size) {
+        const uint8_t *p = buffer + offset;
+        unsigned int mask = uscan_sync_sse2_mask(p,
+                _mm_movemask_epi8(_mm_cmpeq_epi8(
+                        _mm_loadu_si128((const __m128i *)p), words)),
+                words, stride, count - 1);
+        if (mask)
+            return offset + __builtin_ctz(mask);
+        offset += sizeof(__m128i);
+    }
+
+    return offset + uscan_sync_c(buffer + offset, size - offset, word,
+                                 stride, count);
+}
+
+/** @internal @This checks the following periods of a mask of candidates
+ * found in an AVX2 register.
+ *
+ * @param p pointer to the last checked period of the register
+ * @param mask mask of candidates in the register
+ * @param words register filled with the octet word
+ * @param stride period of the word in octets
+ * @param count number of occurrences of the word still to check
+ * @return mask of validated candidates
+ */
+__attribute__((target("avx2")))
+static inline uint32_t uscan_sync_avx2_mask(const uint8_t *p,
+        uint32_t mask, __m256i words, size_t stride, unsigned int count)
+{
+    for ( ; mask && count; count--) {
+        p += stride;
+        mask &= _mm256_movemask_epi8(_mm256_cmpeq_epi8(
+                    _mm256_loadu_si256((const __m256i *)p), words));
+    }
+    return mask;
+}
+
+/** @internal @This is the AVX2 implementation of @ref uscan_sync, testing
+ * thirty-two candidates at once.
+ *
+ * @param buffer pointer to the buffer
+ * @param size size of the buffer in octets
+ * @param word octet word to scan for
+ * @param stride period of the word in octets
+ * @param count number of occurrences of the word to find, including the
+ * first one
+ * @return offset of the first candidate, or size if none was found
+ */
+__attribute__((target("avx2")))
+static size_t uscan_sync_avx2(const uint8_t *buffer, size_t size,
+                              uint8_t word, size_t stride, unsigned int count)
+{
+    const __m256i words = _mm256_set1_epi8(word);
+    const size_t span = (count - 1) * stride;
+    size_t offset = 0;
+
+    while (offset + span + 4 * sizeof(__m256i) <= size) {
+        const uint8_t *p = buffer + offset;
+        __m256i v[4];
+        for (int j = 0; j < 4; j++)
+            v[j] = _mm256_and_si256(
+                    _mm256_cmpeq_epi8(_mm256_loadu_si256(
+                            (const __m256i *)p + j), words),
+                    _mm256_cmpeq_epi8(_mm256_loadu_si256(
+                            (const __m256i *)(p + stride) + j), words));
+        __m256i any = _mm256_or_si256(_mm256_or_si256(v[0], v[1]),
+                                      _mm256_or_si256(v[2], v[3]));
+        if (likely(_mm256_testz_si256(any, any))) {
+            offset += 4 * sizeof(__m256i);
+            continue;
+        }
+
+        for (int j = 0; j < 4; j++) {
+            uint32_t mask = uscan_sync_avx2_mask(
+                    p + stride + j * sizeof(__m256i),
+                    _mm256_movemask_epi8(v[j]), words, stride, count - 2);
+            if (mask)
+                return offset + __builtin_ctz(mask);
+            offset += sizeof(__m256i);
+        }
+    }
+
+    return offset + uscan_sync_sse2(buffer + offset, size - offset, word,
+                                    stride, count);
+}
+#endif
+
+/** @This finds the first offset in a buffer where an octet word is repeated
+ * a given number of times with a given period.
+ *
+ * @param buffer pointer to the buffer
+ * @param size size of the buffer in octets
+ * @param word octet word to scan for
+ * @param stride period of the word in octets
+ * @param count number of occurrences of the word to find, including the
+ * first one
+ * @return offset of the first candidate, or size if none was found
+ */
+size_t uscan_sync(const uint8_t *buffer, size_t size, uint8_t word,
+                  size_t stride, unsigned int count)
+{
+    assert(count > 0);
+    assert(count == 1 || stride > 0);
+    if (count == 1) {
+        /* the C library has the fastest implementation for this case */
+        const uint8_t *match = memchr(buffer, word, size);
+        return match != NULL ? match - buffer : size;
+    }
+
+#ifdef USCAN_X86
+    if (__builtin_cpu_supports("avx2"))
+        return uscan_sync_avx2(buffer, size, word, stride, count);
+    if (__builtin_cpu_supports("sse2"))
+        return uscan_sync_sse2(buffer, size, word, stride, count);
+#endif
+    return uscan_sync_c(buffer, size, word, stride, count);
+}
+
+/** @This is the portable implementation of @ref uscan_start_code. It looks
+ * for the final 01 octet, which is rare in compressed data, and then checks
+ * the two preceding octets.
+ *
+ * @param buffer pointer to the buffer
+ * @param size size of the buffer in octets
+ * @return offset of the first octet of the start code, or size if none was
+ * entirely found in the buffer
+ */
+size_t uscan_start_code_c(const uint8_t *buffer, size_t size)
+{
+    size_t offset = 2;
+    while (offset < size) {
+        const uint8_t *match = memchr(buffer + offset, 1, size - offset);
+        if (match == NULL)
+            break;
+        offset = match - buffer;
+        if (!buffer[offset - 1] && !buffer[offset - 2])
+            return offset - 2;
+        /* the next start code cannot use this octet as one of its zeros */
+        offset += 3;
+    }
+    return size;
+}
+
+#ifdef USCAN_X86
+/** @internal @This returns the mask of the start codes beginning in an
+ * SSE2 register.
+ *
+ * @param p pointer to the first octet of the register
+ * @return register with all bits set for the start codes
+ */
+__attribute__((target("sse2")))
+static inline __m128i uscan_start_code_sse2_mask(const uint8_t *p)
+{
+    const __m128i zeros = _mm_setzero_si128();
+    return _mm_and_si128(_mm_and_si128(
+            _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)p), zeros),
+            _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + 1)), zeros)),
+            _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + 2)),
+                           _mm_set1_epi8(1)));
+}
+
+/** @internal @This is the SSE2 implementation of @ref uscan_start_code.
+ * Each register is compared to 00, 00 and 01 at offsets 0, 1 and 2, and the
+ * masks are anded; four registers are tested at once without branching.
+ *
+ * @param buffer pointer to the buffer
+ * @param size size of the buffer in octets
+ * @return offset of the first octet of the start code, or size if none was
+ * entirely found in the buffer
+ */
+__attribute__((target("sse2")))
+static size_t uscan_start_code_sse2(const uint8_t *buffer, size_t size)
+{
+    size_t offset = 0;
+
+    while (offset + 2 + 4 * sizeof(__m128i) <= size) {
+        const uint8_t *p = buffer + offset;
+        __m128i v[4];
+        for (int j = 0; j < 4; j++)
+            v[j] = uscan_start_code_sse2_mask(p + j * sizeof(__m128i));
+        if (likely(!_mm_movemask_epi8(_mm_or_si128(
+                            _mm_or_si128(v[0], v[1]),
+                            _mm_or_si128(v[2], v[3]))))) {
+            offset += 4 * sizeof(__m128i);
+            continue;
+        }
+
+        for (int j = 0; j < 4; j++) {
+            unsigned int mask = _mm_movemask_epi8(v[j]);
+            if (mask)
+                return offset + __builtin_ctz(mask);
+            offset += sizeof(__m128i);
+        }
+    }
+
+    while (offset + 2 + sizeof(__m128i) <= size) {
+        unsigned int mask = _mm_movemask_epi8(
+                uscan_start_code_sse2_mask(buffer + offset));
+        if (mask)
+            return offset + __builtin_ctz(mask);
+        offset += sizeof(__m128i);
+    }
+
+    return offset + uscan_start_code_c(buffer + offset, size - offset);
+}
+
+/** @internal @This returns the mask of the start codes beginning in an
+ * AVX2 register.
+ *
+ * @param p pointer to the first octet of the register
+ * @return register with all bits set for the start codes
+ */
+__attribute__((target("avx2")))
+static inline __m256i uscan_start_code_avx2_mask(const uint8_t *p)
+{
+    const __m256i zeros = _mm256_setzero_si256();
+    return _mm256_and_si256(_mm256_and_si256(
+            _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)p), zeros),
+            _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(p + 1)),
+                              zeros)),
+            _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(p + 2)),
+                              _mm256_set1_epi8(1)));
+}
+
+/** @internal @This is the AVX2 implementation of @ref uscan_start_code.
+ *
+ * @param buffer pointer to the buffer
+ * @param size size of the buffer in octets
+ * @return offset of the first octet of the start code, or size if none was
+ * entirely found in the buffer
+ */
+__attribute__((target("avx2")))
+static size_t uscan_start_code_avx2(const uint8_t *buffer, size_t size)
+{
+    size_t offset = 0;
+
+    while (offset + 2 + 4 * sizeof(__m256i) <= size) {
+        const uint8_t *p = buffer + offset;
+        __m256i v[4];
+        for (int j = 0; j < 4; j++)
+            v[j] = uscan_start_code_avx2_mask(p + j * sizeof(__m256i));
+        __m256i any = _mm256_or_si256(_mm256_or_si256(v[0], v[1]),
+                                      _mm256_or_si256(v[2], v[3]));
+        if (likely(_mm256_testz_si256(any, any))) {
+            offset += 4 * sizeof(__m256i);
+            continue;
+        }
+
+        for (int j = 0; j < 4; j++) {
+            uint32_t mask = _mm256_movemask_epi8(v[j]);
+            if (mask)
+                return offset + __builtin_ctz(mask);
+            offset += sizeof(__m256i);
+        }
+    }
+
+    return offset + uscan_start_code_sse2(buffer + offset, size - offset);
+}
+#endif
+
+/** @This finds the first MPEG-style 3-octet start code in a buffer.
+ *
+ * @param buffer pointer to the buffer
+ * @param size size of the buffer in octets
+ * @return offset of the first octet of the start code, or size if none was
+ * entirely found in the buffer
+ */
+size_t uscan_start_code(const uint8_t *buffer, size_t size)
+{
+#ifdef USCAN_X86
+    if (__builtin_cpu_supports("avx2"))
+        return uscan_start_code_avx2(buffer, size);
+    if (__builtin_cpu_supports("sse2"))
+        return uscan_start_code_sse2(buffer, size);
+#endif
+    return uscan_start_code_c(buffer, size);
+}
@@ -0,0 +1,273 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe hierarchical timer wheel
+ *
+ * Level l holds the timers expiring between 64^l and 64^(l+1) ticks from
+ * now, in the slot given by bits [6l, 6l+6) of their tick. When the wheel
+ * reaches the beginning of a slot of level l, the slot is cascaded: its
+ * timers are placed again, in lower levels.
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/ulist.h>
+#include <upipe/uwheel.h>
+
+#include <stdint.h>
+#include <assert.h>
+
+/** mask of the slot index */
+#define UWHEEL_SLOT_MASK (UWHEEL_SLOTS - 1)
+
+/** @internal @This rotates a bitmap so that the given slot becomes bit 0.
+ *
+ * @param bitmap bitmap of a level
+ * @param slot slot index
+ * @return rotated bitmap
+ */
+static inline uint64_t uwheel_rotate(uint64_t bitmap, unsigned int slot)
+{
+    return (bitmap >> slot) | (bitmap << ((UWHEEL_SLOTS - slot) &
+                                          UWHEEL_SLOT_MASK));
+}
+
+/** @internal @This moves all timers of a slot to another list.
+ *
+ * @param wheel pointer to the wheel
+ * @param level level of the slot
+ * @param slot slot index
+ * @param list list to fill in
+ */
+static void uwheel_take(struct uwheel *wheel, unsigned int level,
+                        unsigned int slot, struct uchain *list)
+{
+    struct uchain *head = &wheel->slots[level][slot];
+    ulist_init(list);
+    if (ulist_empty(head))
+        return;
+    list->next = head->next;
+    list->prev = head->prev;
+    list->next->prev = list;
+    list->prev->next = list;
+    ulist_init(head);
+    wheel->occupied[level] &= ~(UINT64_C(1) << slot);
+}
+
+/** @internal @This places a timer in the slot matching its tick.
+ *
+ * @param wheel pointer to the wheel
+ * @param timer pointer to the timer
+ */
+static void uwheel_place(struct uwheel *wheel, struct uwheel_timer *timer)
+{
+    uint64_t tick = timer->tick > wheel->now_tick ? timer->tick :
+                    wheel->now_tick;
+    uint64_t delta = tick - wheel->now_tick;
+    unsigned int level = 0;
+    if (delta >= UWHEEL_SLOTS) {
+        level = (63 - __builtin_clzll(delta)) / UWHEEL_SLOT_BITS;
+        if (level >= UWHEEL_LEVELS)
+            level = UWHEEL_LEVELS - 1;
+    }
+    unsigned int slot = (tick >> (UWHEEL_SLOT_BITS * level)) &
+                        UWHEEL_SLOT_MASK;
+
+    timer->slot = &wheel->slots[level][slot];
+    ulist_add(timer->slot, &timer->uchain);
+    wheel->occupied[level] |= UINT64_C(1) << slot;
+}
+
+/** @internal @This returns the next tick where there is something to do.
+ *
+ * @param wheel pointer to the wheel
+ * @return next tick, or UINT64_MAX if no timer is armed
+ */
+static uint64_t uwheel_next_tick(struct uwheel *wheel)
+{
+    uint64_t now = wheel->now_tick;
+    uint64_t next = UINT64_MAX;
+    if (!wheel->nb_timers)
+        return next;
+
+    if (wheel->occupied[0]) {
+        uint64_t bitmap = uwheel_rotate(wheel->occupied[0],
+                                        now & UWHEEL_SLOT_MASK);
+        next = now + __builtin_ctzll(bitmap);
+    }
+
+    for (unsigned int level = 1; level < UWHEEL_LEVELS; level++) {
+        if (!wheel->occupied[level])
+            continue;
+        unsigned int shift = UWHEEL_SLOT_BITS * level;
+        uint64_t period = now >> shift;
+        unsigned int slot = period & UWHEEL_SLOT_MASK;
+        uint64_t cascade;
+        if ((period << shift) == now &&
+            (wheel->occupied[level] & (UINT64_C(1) << slot)))
+            cascade = now;
+        else {
+            /* the current slot was already cascaded, so it comes last */
+            uint64_t bitmap = uwheel_rotate(wheel->occupied[level],
+                                            (slot + 1) & UWHEEL_SLOT_MASK);
+            cascade = (period + __builtin_ctzll(bitmap) + 1) << shift;
+        }
+        if (cascade < next)
+            next = cascade;
+    }
+    return next;
+}
+
+/** @internal @This cascades the slots of higher levels beginning at the
+ * current tick.
+ *
+ * @param wheel pointer to the wheel
+ */
+static void uwheel_cascade(struct uwheel *wheel)
+{
+    uint64_t now = wheel->now_tick;
+    for (unsigned int level = 1; level < UWHEEL_LEVELS; level++) {
+        unsigned int shift = UWHEEL_SLOT_BITS * level;
+        if ((now >> shift) << shift != now)
+            break;
+
+        struct uchain list;
+        uwheel_take(wheel, level, (now >> shift) & UWHEEL_SLOT_MASK, &list);
+        struct uchain *uchain;
+        while ((uchain = ulist_pop(&list)) != NULL)
+            uwheel_place(wheel, uwheel_timer_from_uchain(uchain));
+    }
+}
+
+/** @This initializes a wheel.
+ *
+ * @param wheel pointer to the wheel
+ * @param resolution duration of a tick, in the unit of the dates
+ * @param now current date
+ */
+void uwheel_init(struct uwheel *wheel, uint64_t resolution, uint64_t now)
+{
+    assert(resolution);
+    wheel->resolution = resolution;
+    wheel->now_tick = now / resolution;
+    wheel->nb_timers = 0;
+    for (unsigned int level = 0; level < UWHEEL_LEVELS; level++) {
+        wheel->occupied[level] = 0;
+        for (unsigned int slot = 0; slot < UWHEEL_SLOTS; slot++)
+            ulist_init(&wheel->slots[level][slot]);
+    }
+}
+
+/** @This arms a timer, or re-arms it if it was already armed. A deadline
+ * in the past makes the timer expire on the next call to
+ * @ref uwheel_expire.
+ *
+ * @param wheel pointer to the wheel
+ * @param timer pointer to the timer
+ * @param deadline date of expiry
+ */
+void uwheel_arm(struct uwheel *wheel, struct uwheel_timer *timer,
+                uint64_t deadline)
+{
+    uwheel_cancel(wheel, timer);
+    timer->deadline = deadline;
+    /* round up so that a timer never expires before its deadline */
+    timer->tick = deadline / wheel->resolution +
+                  (deadline % wheel->resolution != 0);
+    uwheel_place(wheel, timer);
+    wheel->nb_timers++;
+}
+
+/** @This cancels a timer. It does nothing if the timer is not armed.
+ *
+ * @param wheel pointer to the wheel
+ * @param timer pointer to the timer
+ */
+void uwheel_cancel(struct uwheel *wheel, struct uwheel_timer *timer)
+{
+    struct uchain *head = timer->slot;
+    if (head == NULL)
+        return;
+
+    ulist_delete(&timer->uchain);
+    timer->slot = NULL;
+    wheel->nb_timers--;
+    if (ulist_empty(head)) {
+        unsigned int index = head - &wheel->slots[0][0];
+        wheel->occupied[index / UWHEEL_SLOTS] &=
+            ~(UINT64_C(1) << (index % UWHEEL_SLOTS));
+    }
+}
+
+/** @This returns the date at which @ref uwheel_expire should be called
+ * next. It may be earlier than the first deadline, when timers have to be
+ * moved between levels, but never later.
+ *
+ * @param wheel pointer to the wheel
+ * @return date of the next event, or UINT64_MAX if no timer is armed
+ */
+uint64_t uwheel_next(struct uwheel *wheel)
+{
+    uint64_t tick = uwheel_next_tick(wheel);
+    if (tick > UINT64_MAX / wheel->resolution)
+        return UINT64_MAX;
+    return tick * wheel->resolution;
+}
+
+/** @This calls the functions of all timers expired at the given date. The
+ * functions may arm and cancel any timer of the wheel.
+ *
+ * @param wheel pointer to the wheel
+ * @param now current date
+ * @return number of expired timers
+ */
+unsigned int uwheel_expire(struct uwheel *wheel, uint64_t now)
+{
+    uint64_t target = now / wheel->resolution;
+    unsigned int nb_expired = 0;
+
+    while (wheel->now_tick <= target) {
+        uint64_t tick = uwheel_next_tick(wheel);
+        if (tick > target) {
+            wheel->now_tick = target + 1;
+            break;
+        }
+        wheel->now_tick = tick;
+        uwheel_cascade(wheel);
+
+        struct uchain expired;
+        uwheel_take(wheel, 0, tick & UWHEEL_SLOT_MASK, &expired);
+        /* timers armed by the callbacks go to the next ticks */
+        wheel->now_tick = tick + 1;
+
+        struct uchain *uchain;
+        while ((uchain = ulist_pop(&expired)) != NULL) {
+            struct uwheel_timer *timer = uwheel_timer_from_uchain(uchain);
+            timer->slot = NULL;
+            wheel->nb_timers--;
+            nb_expired++;
+            timer->cb(timer);
+        }
+    }
+    return nb_expired;
+}
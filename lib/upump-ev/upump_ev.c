@@ -32,6 +32,7 @@
 #include <upipe/uclock.h>
 #include <upipe/upump.h>
 #include <upipe/upump_common.h>
+#include <upipe/uwheel.h>
 #include <upump-ev/upump_ev.h>
 
 #include <stdlib.h>
@@ -47,6 +48,17 @@ struct upump_ev_mgr {
     /** ev private structure */
     struct ev_loop *ev_loop;
 
+    /** timer wheel, or NULL to use ev timers */
+    struct uwheel *wheel;
+    /** ev timer driving the timer wheel */
+    struct ev_timer wheel_timer;
+    /** date for which the ev timer is programmed */
+    uint64_t wheel_next;
+    /** date of the expiry in progress */
+    uint64_t wheel_now;
+    /** true while expired timers are dispatched */
+    bool wheel_expiring;
+
     /** common structure */
     struct upump_common_mgr common_mgr;
 
@@ -69,6 +81,14 @@ struct upump_ev {
         struct ev_timer ev_timer;
         struct ev_idle ev_idle;
     };
+    /** timer of the wheel */
+    struct uwheel_timer wheel_timer;
+    /** true if the timer was started in the wheel */
+    bool wheel;
+    /** timeout of a timer */
+    uint64_t after;
+    /** repeat period of a timer */
+    uint64_t repeat;
 
     /** common structure */
     struct upump_common common;
@@ -105,6 +125,85 @@ static void upump_ev_dispatch_timer(struct ev_loop *ev_loop,
     upump_common_dispatch(upump);
 }
 
+/** @This returns the current date of the loop.
+ *
+ * @param ev_mgr pointer to a upump_ev_mgr structure
+ * @return current date in units of @ref #UCLOCK_FREQ
+ */
+static inline uint64_t upump_ev_mgr_now(struct upump_ev_mgr *ev_mgr)
+{
+    return (uint64_t)(ev_now(ev_mgr->ev_loop) * UCLOCK_FREQ);
+}
+
+/** @This programs the ev timer for the next event of the timer wheel.
+ *
+ * @param ev_mgr pointer to a upump_ev_mgr structure
+ */
+static void upump_ev_mgr_wheel_update(struct upump_ev_mgr *ev_mgr)
+{
+    uint64_t next = uwheel_next(ev_mgr->wheel);
+    if (ev_is_active(&ev_mgr->wheel_timer)) {
+        if (next >= ev_mgr->wheel_next)
+            return;
+        ev_timer_stop(ev_mgr->ev_loop, &ev_mgr->wheel_timer);
+    }
+    ev_mgr->wheel_next = next;
+    if (next == UINT64_MAX)
+        return;
+
+    uint64_t now = upump_ev_mgr_now(ev_mgr);
+    ev_timer_set(&ev_mgr->wheel_timer,
+                 next > now ? (ev_tstamp)(next - now) / UCLOCK_FREQ : 0., 0.);
+    ev_timer_start(ev_mgr->ev_loop, &ev_mgr->wheel_timer);
+}
+
+/** @This dispatches the expired timers of the timer wheel.
+ *
+ * @param ev_loop current event loop (unused parameter)
+ * @param ev_timer ev timer of the wheel
+ * @param revents events triggered (unused parameter)
+ */
+static void upump_ev_mgr_dispatch_wheel(struct ev_loop *ev_loop,
+                                        struct ev_timer *ev_timer, int revents)
+{
+    struct upump_ev_mgr *ev_mgr = container_of(ev_timer, struct upump_ev_mgr,
+                                               wheel_timer);
+    struct upump_mgr *mgr = upump_ev_mgr_to_upump_mgr(ev_mgr);
+    uint64_t now = upump_ev_mgr_now(ev_mgr);
+    /* do not let rounding errors delay the timers by another tick */
+    if (now < ev_mgr->wheel_next)
+        now = ev_mgr->wheel_next;
+    ev_mgr->wheel_now = now;
+
+    /* a callback may release the last pump of the manager */
+    upump_mgr_use(mgr);
+    ev_mgr->wheel_expiring = true;
+    uwheel_expire(ev_mgr->wheel, now);
+    ev_mgr->wheel_expiring = false;
+    upump_ev_mgr_wheel_update(ev_mgr);
+    upump_mgr_release(mgr);
+}
+
+/** @This dispatches an event to a pump for a timer of the wheel.
+ *
+ * @param wheel_timer timer of the wheel
+ */
+static void upump_ev_dispatch_wheel(struct uwheel_timer *wheel_timer)
+{
+    struct upump_ev *upump_ev = container_of(wheel_timer, struct upump_ev,
+                                             wheel_timer);
+    struct upump *upump = upump_ev_to_upump(upump_ev);
+    if (upump_ev->repeat) {
+        struct upump_ev_mgr *ev_mgr = upump_ev_mgr_from_upump_mgr(upump->mgr);
+        /* like ev timers, do not try to catch up with missed periods */
+        uint64_t deadline = wheel_timer->deadline + upump_ev->repeat;
+        if (deadline < ev_mgr->wheel_now)
+            deadline = ev_mgr->wheel_now;
+        uwheel_arm(ev_mgr->wheel, wheel_timer, deadline);
+    }
+    upump_common_dispatch(upump);
+}
+
 /** @This dispatches an event to a pump for type ev_idle.
  *
  * @param ev_loop current event loop (unused parameter)
@@ -144,6 +243,8 @@ static struct upump *upump_ev_alloc(struct upump_mgr *mgr,
         case UPUMP_TYPE_TIMER: {
             uint64_t after = va_arg(args, uint64_t);
             uint64_t repeat = va_arg(args, uint64_t);
+            upump_ev->after = after;
+            upump_ev->repeat = repeat;
             ev_timer_init(&upump_ev->ev_timer, upump_ev_dispatch_timer,
                           (ev_tstamp)after / UCLOCK_FREQ,
                           (ev_tstamp)repeat / UCLOCK_FREQ);
@@ -164,6 +265,8 @@ static struct upump *upump_ev_alloc(struct upump_mgr *mgr,
             return NULL;
     }
     upump_ev->event = event;
+    uwheel_timer_init(&upump_ev->wheel_timer, upump_ev_dispatch_wheel);
+    upump_ev->wheel = false;
 
     upump_mgr_use(mgr);
     upump_common_init(upump);
@@ -185,7 +288,13 @@ static void upump_ev_real_start(struct upump *upump)
             ev_idle_start(ev_mgr->ev_loop, &upump_ev->ev_idle);
             break;
         case UPUMP_TYPE_TIMER:
-            ev_timer_start(ev_mgr->ev_loop, &upump_ev->ev_timer);
+            upump_ev->wheel = ev_mgr->wheel != NULL;
+            if (upump_ev->wheel) {
+                uwheel_arm(ev_mgr->wheel, &upump_ev->wheel_timer,
+                           upump_ev_mgr_now(ev_mgr) + upump_ev->after);
+                upump_ev_mgr_wheel_update(ev_mgr);
+            } else
+                ev_timer_start(ev_mgr->ev_loop, &upump_ev->ev_timer);
             break;
         case UPUMP_TYPE_FD_READ:
         case UPUMP_TYPE_FD_WRITE:
@@ -210,7 +319,17 @@ static void upump_ev_real_stop(struct upump *upump)
             ev_idle_stop(ev_mgr->ev_loop, &upump_ev->ev_idle);
             break;
         case UPUMP_TYPE_TIMER:
-            ev_timer_stop(ev_mgr->ev_loop, &upump_ev->ev_timer);
+            if (!upump_ev->wheel) {
+                ev_timer_stop(ev_mgr->ev_loop, &upump_ev->ev_timer);
+                break;
+            }
+            if (!uwheel_timer_armed(&upump_ev->wheel_timer))
+                break;
+            uwheel_cancel(ev_mgr->wheel, &upump_ev->wheel_timer);
+            /* the ev timer may trigger early, but must not keep the loop
+             * running */
+            if (!ev_mgr->wheel->nb_timers)
+                ev_timer_stop(ev_mgr->ev_loop, &ev_mgr->wheel_timer);
             break;
         case UPUMP_TYPE_FD_READ:
         case UPUMP_TYPE_FD_WRITE:
@@ -263,6 +382,33 @@ static void upump_ev_free_inner(struct upool *upool, void *upump_ev)
     free(upump_ev);
 }
 
+/** @This sets the slack of the timer wheel.
+ *
+ * @param mgr pointer to a upump_mgr structure
+ * @param slack maximum delay of the expiry of timers, or 0
+ * @return an error code
+ */
+static int upump_ev_mgr_set_timer_slack(struct upump_mgr *mgr, uint64_t slack)
+{
+    struct upump_ev_mgr *ev_mgr = upump_ev_mgr_from_upump_mgr(mgr);
+    if (ev_mgr->wheel != NULL) {
+        if (ev_mgr->wheel->nb_timers || ev_mgr->wheel_expiring)
+            return UBASE_ERR_BUSY;
+        ev_timer_stop(ev_mgr->ev_loop, &ev_mgr->wheel_timer);
+        free(ev_mgr->wheel);
+        ev_mgr->wheel = NULL;
+    }
+    if (!slack)
+        return UBASE_ERR_NONE;
+
+    ev_mgr->wheel = malloc(sizeof(struct uwheel));
+    if (unlikely(ev_mgr->wheel == NULL))
+        return UBASE_ERR_ALLOC;
+    uwheel_init(ev_mgr->wheel, slack, upump_ev_mgr_now(ev_mgr));
+    ev_mgr->wheel_next = UINT64_MAX;
+    return UBASE_ERR_NONE;
+}
+
 /** @This processes control commands on a upump_ev_mgr.
  *
  * @param mgr pointer to a upump_mgr structure
@@ -277,6 +423,10 @@ static int upump_ev_mgr_control(struct upump_mgr *mgr,
         case UPUMP_MGR_VACUUM:
             upump_common_mgr_vacuum(mgr);
             return UBASE_ERR_NONE;
+        case UPUMP_MGR_SET_TIMER_SLACK: {
+            uint64_t slack = va_arg(args, uint64_t);
+            return upump_ev_mgr_set_timer_slack(mgr, slack);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -289,6 +439,10 @@ static int upump_ev_mgr_control(struct upump_mgr *mgr,
 static void upump_ev_mgr_free(struct urefcount *urefcount)
 {
     struct upump_ev_mgr *ev_mgr = upump_ev_mgr_from_urefcount(urefcount);
+    if (ev_mgr->wheel != NULL) {
+        ev_timer_stop(ev_mgr->ev_loop, &ev_mgr->wheel_timer);
+        free(ev_mgr->wheel);
+    }
     upump_common_mgr_clean(upump_ev_mgr_to_upump_mgr(ev_mgr));
     free(ev_mgr);
 }
@@ -319,6 +473,10 @@ struct upump_mgr *upump_ev_mgr_alloc(struct ev_loop *ev_loop,
                           upump_ev_alloc_inner, upump_ev_free_inner);
 
     ev_mgr->ev_loop = ev_loop;
+    ev_mgr->wheel = NULL;
+    ev_timer_init(&ev_mgr->wheel_timer, upump_ev_mgr_dispatch_wheel, 0., 0.);
+    ev_mgr->wheel_next = UINT64_MAX;
+    ev_mgr->wheel_expiring = false;
     urefcount_init(upump_ev_mgr_to_urefcount(ev_mgr), upump_ev_mgr_free);
     ev_mgr->common_mgr.mgr.refcount = upump_ev_mgr_to_urefcount(ev_mgr);
     ev_mgr->common_mgr.mgr.upump_alloc = upump_ev_alloc;
@@ -0,0 +1,1007 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short implementation of a Upipe event loop shared by a pool of threads
+ *
+ * Each manager is a serial context, run by at most one worker at a time.
+ * File descriptors and timers (backed by timerfds) are watched by a single
+ * epoll instance in one-shot mode. The worker which polls queues the
+ * managers whose pumps triggered at the head of its own deque; idle workers
+ * steal from the tail of the deques of the others. A manager which still has
+ * work to do after a run (triggered pumps or idlers) is queued again at the
+ * tail of the deque of the worker which ran it.
+ *
+ * Only one worker polls at a time. Pumps registered to epoll which are freed
+ * while another worker may be processing their events are kept aside until
+ * the next poll.
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/ulist.h>
+#include <upipe/urefcount.h>
+#include <upipe/uatomic.h>
+#include <upipe/uclock.h>
+#include <upipe/upump.h>
+#include <upipe/upump_common.h>
+#include <upump-tpool/upump_tpool.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+/** maximum number of events retrieved by a single poll */
+#define UPUMP_TPOOL_EVENTS 64
+
+/** @This stores the parameters of a worker thread. */
+struct upump_tpool_worker {
+    /** pointer to the pool */
+    struct upump_tpool *tpool;
+    /** index of the worker in the pool */
+    unsigned int index;
+    /** thread running the worker (unused for the first one) */
+    pthread_t thread;
+
+    /** lock protecting the deque */
+    pthread_mutex_t lock;
+    /** deque of runnable managers */
+    struct uchain runnable;
+};
+
+/** @This stores the parameters of a pool. */
+struct upump_tpool {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** epoll file descriptor */
+    int epoll_fd;
+    /** eventfd used to interrupt the polling worker */
+    int event_fd;
+    /** key to retrieve the worker of the current thread */
+    pthread_key_t key;
+
+    /** lock held by the polling worker */
+    pthread_mutex_t poll_lock;
+    /** lock protecting the sleep of the workers and the list of zombies */
+    pthread_mutex_t lock;
+    /** condition to wake up sleeping workers */
+    pthread_cond_t cond;
+    /** list of freed pumps which may still be reported by epoll */
+    struct uchain zombies;
+
+    /** number of started pumps plus number of queued or running managers */
+    uatomic_uint32_t activity;
+    /** number of sleeping workers */
+    uatomic_uint32_t nb_sleeping;
+    /** 1 if a worker is blocked in epoll_wait */
+    uatomic_uint32_t blocked_poll;
+    /** 1 if the workers must return */
+    uatomic_uint32_t exiting;
+    /** next worker to queue managers woken up outside of the pool */
+    uatomic_uint32_t next_worker;
+    /** number of managers stolen during the last run */
+    uatomic_uint32_t steals;
+
+    /** number of workers */
+    unsigned int nb_workers;
+    /** workers */
+    struct upump_tpool_worker workers[];
+};
+
+UBASE_FROM_TO(upump_tpool, urefcount, urefcount, urefcount)
+
+/** @This is the state of a manager with regard to the workers. */
+enum upump_tpool_state {
+    /** nothing to do */
+    UPUMP_TPOOL_IDLE,
+    /** in the deque of a worker, or about to be run */
+    UPUMP_TPOOL_QUEUED,
+    /** run by a worker */
+    UPUMP_TPOOL_RUNNING
+};
+
+/** @This stores management parameters and local structures. */
+struct upump_tpool_mgr {
+    /** refcount management structure */
+    struct urefcount urefcount;
+    /** pointer to the pool */
+    struct upump_tpool *tpool;
+
+    /** lock protecting the state, the lists and the pumps flags */
+    pthread_mutex_t lock;
+    /** state of the manager */
+    enum upump_tpool_state state;
+    /** structure for double-linked lists of the workers */
+    struct uchain uchain;
+    /** list of pumps which triggered */
+    struct uchain pending;
+    /** list of started idlers */
+    struct uchain idlers;
+    /** pump being dispatched */
+    struct upump_tpool_pump *dispatching;
+
+    /** common structure */
+    struct upump_common_mgr common_mgr;
+
+    /** extra space for upool */
+    uint8_t upool_extra[];
+};
+
+UBASE_FROM_TO(upump_tpool_mgr, upump_mgr, upump_mgr, common_mgr.mgr)
+UBASE_FROM_TO(upump_tpool_mgr, urefcount, urefcount, urefcount)
+UBASE_FROM_TO(upump_tpool_mgr, uchain, uchain, uchain)
+
+/** @This stores local structures. */
+struct upump_tpool_pump {
+    /** type of event to watch */
+    enum upump_type event;
+    /** structure for double-linked lists of the manager or the pool */
+    struct uchain uchain;
+    /** file descriptor to watch, or timerfd */
+    int fd;
+    /** true if the file descriptor was added to epoll */
+    bool registered;
+    /** true if the pump is started and not blocked */
+    bool active;
+    /** delay before the first trigger of a timer */
+    uint64_t after;
+    /** delay between subsequent triggers of a timer, or 0 */
+    uint64_t repeat;
+
+    /** common structure */
+    struct upump_common common;
+};
+
+UBASE_FROM_TO(upump_tpool_pump, upump, upump, common.upump)
+UBASE_FROM_TO(upump_tpool_pump, uchain, uchain, uchain)
+
+/** @internal @This returns the manager of a pump.
+ *
+ * @param pump pointer to a upump_tpool_pump structure
+ * @return pointer to the manager
+ */
+static inline struct upump_tpool_mgr *
+    upump_tpool_pump_mgr(struct upump_tpool_pump *pump)
+{
+    return upump_tpool_mgr_from_upump_mgr(pump->common.upump.mgr);
+}
+
+/** @internal @This wakes up a worker if another one could take part in the
+ * work.
+ *
+ * @param tpool pointer to the pool
+ * @param worker worker which received work, or NULL outside of the pool
+ */
+static void upump_tpool_notify(struct upump_tpool *tpool,
+                               struct upump_tpool_worker *worker)
+{
+    if (uatomic_load(&tpool->nb_sleeping)) {
+        pthread_mutex_lock(&tpool->lock);
+        pthread_cond_signal(&tpool->cond);
+        pthread_mutex_unlock(&tpool->lock);
+    } else if ((worker == NULL || uatomic_load(&tpool->blocked_poll)) &&
+               uatomic_load(&tpool->exiting) == 0)
+        eventfd_write(tpool->event_fd, 1);
+}
+
+/** @internal @This queues a manager if it is idle. The lock of the manager
+ * must be held.
+ *
+ * @param tpool_mgr pointer to a upump_tpool_mgr structure
+ */
+static void upump_tpool_mgr_wake(struct upump_tpool_mgr *tpool_mgr)
+{
+    struct upump_tpool *tpool = tpool_mgr->tpool;
+    if (tpool_mgr->state != UPUMP_TPOOL_IDLE)
+        return;
+    tpool_mgr->state = UPUMP_TPOOL_QUEUED;
+    uatomic_fetch_add(&tpool->activity, 1);
+
+    struct upump_tpool_worker *current = pthread_getspecific(tpool->key);
+    struct upump_tpool_worker *worker = current;
+    if (worker == NULL)
+        worker = &tpool->workers[uatomic_fetch_add(&tpool->next_worker, 1) %
+                                 tpool->nb_workers];
+    pthread_mutex_lock(&worker->lock);
+    ulist_unshift(&worker->runnable, upump_tpool_mgr_to_uchain(tpool_mgr));
+    bool crowded = current == NULL ||
+                   !ulist_is_last(&worker->runnable,
+                                  upump_tpool_mgr_to_uchain(tpool_mgr));
+    pthread_mutex_unlock(&worker->lock);
+    if (crowded)
+        upump_tpool_notify(tpool, current);
+}
+
+/** @internal @This marks a pump as triggered. The lock of the manager must
+ * be held.
+ *
+ * @param tpool_mgr pointer to a upump_tpool_mgr structure
+ * @param pump pointer to a upump_tpool_pump structure
+ */
+static void upump_tpool_pump_trigger(struct upump_tpool_mgr *tpool_mgr,
+                                     struct upump_tpool_pump *pump)
+{
+    struct uchain *uchain = upump_tpool_pump_to_uchain(pump);
+    if (!pump->active || ulist_is_in(uchain))
+        return;
+    ulist_add(&tpool_mgr->pending, uchain);
+    upump_tpool_mgr_wake(tpool_mgr);
+}
+
+/** @internal @This arms the file descriptor of a pump for one event. The
+ * lock of the manager must be held.
+ *
+ * @param tpool_mgr pointer to a upump_tpool_mgr structure
+ * @param pump pointer to a upump_tpool_pump structure
+ */
+static void upump_tpool_pump_arm(struct upump_tpool_mgr *tpool_mgr,
+                                 struct upump_tpool_pump *pump)
+{
+    struct epoll_event event;
+    event.events = (pump->event == UPUMP_TYPE_FD_WRITE ? EPOLLOUT : EPOLLIN) |
+                   EPOLLONESHOT;
+    event.data.ptr = pump;
+    if (pump->registered) {
+        epoll_ctl(tpool_mgr->tpool->epoll_fd, EPOLL_CTL_MOD, pump->fd, &event);
+        return;
+    }
+
+    if (likely(epoll_ctl(tpool_mgr->tpool->epoll_fd, EPOLL_CTL_ADD, pump->fd,
+                         &event) != -1))
+        pump->registered = true;
+    else if (errno == EPERM)
+        /* regular files cannot be polled and are always ready */
+        upump_tpool_pump_trigger(tpool_mgr, pump);
+}
+
+/** @internal @This releases pumps which were freed while registered.
+ *
+ * @param tpool pointer to the pool
+ */
+static void upump_tpool_reap(struct upump_tpool *tpool)
+{
+    struct uchain zombies;
+    ulist_init(&zombies);
+    struct uchain *uchain;
+    pthread_mutex_lock(&tpool->lock);
+    while ((uchain = ulist_pop(&tpool->zombies)) != NULL)
+        ulist_add(&zombies, uchain);
+    pthread_mutex_unlock(&tpool->lock);
+
+    while ((uchain = ulist_pop(&zombies)) != NULL) {
+        struct upump_tpool_pump *pump = upump_tpool_pump_from_uchain(uchain);
+        struct upump_tpool_mgr *tpool_mgr = upump_tpool_pump_mgr(pump);
+        upool_free(&tpool_mgr->common_mgr.upump_pool, pump);
+        upump_mgr_release(upump_tpool_mgr_to_upump_mgr(tpool_mgr));
+    }
+}
+
+/** @internal @This waits for events and marks the pumps as triggered. The
+ * poll lock must be held.
+ *
+ * @param worker pointer to the current worker
+ * @param timeout maximum time to wait in milliseconds, or -1
+ */
+static void upump_tpool_poll(struct upump_tpool_worker *worker, int timeout)
+{
+    struct upump_tpool *tpool = worker->tpool;
+    upump_tpool_reap(tpool);
+
+    struct epoll_event events[UPUMP_TPOOL_EVENTS];
+    if (timeout)
+        uatomic_store(&tpool->blocked_poll, 1);
+    int ret = epoll_wait(tpool->epoll_fd, events, UPUMP_TPOOL_EVENTS, timeout);
+    if (timeout)
+        uatomic_store(&tpool->blocked_poll, 0);
+
+    for (int i = 0; i < ret; i++) {
+        struct upump_tpool_pump *pump = events[i].data.ptr;
+        if (pump == NULL) {
+            eventfd_t value;
+            eventfd_read(tpool->event_fd, &value);
+            continue;
+        }
+
+        struct upump_tpool_mgr *tpool_mgr = upump_tpool_pump_mgr(pump);
+        pthread_mutex_lock(&tpool_mgr->lock);
+        upump_tpool_pump_trigger(tpool_mgr, pump);
+        pthread_mutex_unlock(&tpool_mgr->lock);
+    }
+}
+
+/** @internal @This dispatches a pump which triggered.
+ *
+ * @param tpool_mgr pointer to a upump_tpool_mgr structure
+ * @param pump pointer to a upump_tpool_pump structure
+ */
+static void upump_tpool_pump_dispatch(struct upump_tpool_mgr *tpool_mgr,
+                                      struct upump_tpool_pump *pump)
+{
+    if (pump->event == UPUMP_TYPE_TIMER) {
+        uint64_t expirations;
+        if (read(pump->fd, &expirations, sizeof(expirations)) !=
+                sizeof(expirations)) {
+            /* the timer was restarted after it triggered */
+            pthread_mutex_lock(&tpool_mgr->lock);
+            if (pump->active)
+                upump_tpool_pump_arm(tpool_mgr, pump);
+            pthread_mutex_unlock(&tpool_mgr->lock);
+            return;
+        }
+        if (!pump->repeat) {
+            pthread_mutex_lock(&tpool_mgr->lock);
+            pump->active = false;
+            pthread_mutex_unlock(&tpool_mgr->lock);
+            uatomic_fetch_sub(&tpool_mgr->tpool->activity, 1);
+        }
+    }
+
+    tpool_mgr->dispatching = pump;
+    upump_common_dispatch(upump_tpool_pump_to_upump(pump));
+    if (tpool_mgr->dispatching != pump)
+        /* the pump was freed */
+        return;
+    tpool_mgr->dispatching = NULL;
+
+    pthread_mutex_lock(&tpool_mgr->lock);
+    if (pump->active)
+        upump_tpool_pump_arm(tpool_mgr, pump);
+    pthread_mutex_unlock(&tpool_mgr->lock);
+}
+
+/** @internal @This dispatches the started idlers. Like in libev, they are
+ * only called when no other pump was triggered.
+ *
+ * @param tpool_mgr pointer to a upump_tpool_mgr structure
+ */
+static void upump_tpool_dispatch_idlers(struct upump_tpool_mgr *tpool_mgr)
+{
+    struct uchain idlers;
+    ulist_init(&idlers);
+    struct uchain *uchain;
+    pthread_mutex_lock(&tpool_mgr->lock);
+    while ((uchain = ulist_pop(&tpool_mgr->idlers)) != NULL)
+        ulist_add(&idlers, uchain);
+
+    while ((uchain = ulist_pop(&idlers)) != NULL) {
+        ulist_add(&tpool_mgr->idlers, uchain);
+        pthread_mutex_unlock(&tpool_mgr->lock);
+        upump_common_dispatch(
+                upump_tpool_pump_to_upump(upump_tpool_pump_from_uchain(uchain)));
+        pthread_mutex_lock(&tpool_mgr->lock);
+    }
+    pthread_mutex_unlock(&tpool_mgr->lock);
+}
+
+/** @internal @This runs a manager, and queues it again if it has work left.
+ *
+ * @param worker pointer to the current worker
+ * @param tpool_mgr pointer to a upump_tpool_mgr structure
+ */
+static void upump_tpool_mgr_run(struct upump_tpool_worker *worker,
+                                struct upump_tpool_mgr *tpool_mgr)
+{
+    struct upump_tpool *tpool = tpool_mgr->tpool;
+    pthread_mutex_lock(&tpool_mgr->lock);
+    tpool_mgr->state = UPUMP_TPOOL_RUNNING;
+    size_t nb_pending = ulist_depth(&tpool_mgr->pending);
+    pthread_mutex_unlock(&tpool_mgr->lock);
+
+    /* pumps which trigger in the meantime wait for the next run */
+    bool dispatched = false;
+    while (nb_pending--) {
+        pthread_mutex_lock(&tpool_mgr->lock);
+        struct uchain *uchain = ulist_pop(&tpool_mgr->pending);
+        pthread_mutex_unlock(&tpool_mgr->lock);
+        if (uchain == NULL)
+            break;
+        upump_tpool_pump_dispatch(tpool_mgr,
+                                  upump_tpool_pump_from_uchain(uchain));
+        dispatched = true;
+    }
+    if (!dispatched)
+        upump_tpool_dispatch_idlers(tpool_mgr);
+
+    pthread_mutex_lock(&tpool_mgr->lock);
+    if (ulist_empty(&tpool_mgr->pending) && ulist_empty(&tpool_mgr->idlers)) {
+        tpool_mgr->state = UPUMP_TPOOL_IDLE;
+        uatomic_fetch_sub(&tpool->activity, 1);
+        pthread_mutex_unlock(&tpool_mgr->lock);
+        return;
+    }
+
+    tpool_mgr->state = UPUMP_TPOOL_QUEUED;
+    pthread_mutex_lock(&worker->lock);
+    ulist_add(&worker->runnable, upump_tpool_mgr_to_uchain(tpool_mgr));
+    bool crowded = !ulist_is_first(&worker->runnable,
+                                   upump_tpool_mgr_to_uchain(tpool_mgr));
+    pthread_mutex_unlock(&worker->lock);
+    pthread_mutex_unlock(&tpool_mgr->lock);
+    if (crowded)
+        upump_tpool_notify(tpool, worker);
+}
+
+/** @internal @This takes a manager from the head of the deque of a worker.
+ *
+ * @param worker pointer to the current worker
+ * @return pointer to a manager, or NULL
+ */
+static struct upump_tpool_mgr *
+    upump_tpool_worker_pop(struct upump_tpool_worker *worker)
+{
+    pthread_mutex_lock(&worker->lock);
+    struct uchain *uchain = ulist_pop(&worker->runnable);
+    pthread_mutex_unlock(&worker->lock);
+    return uchain != NULL ? upump_tpool_mgr_from_uchain(uchain) : NULL;
+}
+
+/** @internal @This takes a manager from the tail of the deque of another
+ * worker.
+ *
+ * @param worker pointer to the current worker
+ * @return pointer to a manager, or NULL
+ */
+static struct upump_tpool_mgr *
+    upump_tpool_worker_steal(struct upump_tpool_worker *worker)
+{
+    struct upump_tpool *tpool = worker->tpool;
+    for (unsigned int i = 1; i < tpool->nb_workers; i++) {
+        struct upump_tpool_worker *victim =
+            &tpool->workers[(worker->index + i) % tpool->nb_workers];
+        struct uchain *uchain = NULL;
+        pthread_mutex_lock(&victim->lock);
+        if (!ulist_empty(&victim->runnable)) {
+            uchain = victim->runnable.prev;
+            ulist_delete(uchain);
+        }
+        pthread_mutex_unlock(&victim->lock);
+        if (uchain != NULL) {
+            uatomic_fetch_add(&tpool->steals, 1);
+            return upump_tpool_mgr_from_uchain(uchain);
+        }
+    }
+    return NULL;
+}
+
+/** @internal @This checks if a deque contains a manager.
+ *
+ * @param tpool pointer to the pool
+ * @return true if a manager is queued
+ */
+static bool upump_tpool_queued(struct upump_tpool *tpool)
+{
+    for (unsigned int i = 0; i < tpool->nb_workers; i++) {
+        struct upump_tpool_worker *worker = &tpool->workers[i];
+        pthread_mutex_lock(&worker->lock);
+        bool empty = ulist_empty(&worker->runnable);
+        pthread_mutex_unlock(&worker->lock);
+        if (!empty)
+            return true;
+    }
+    return false;
+}
+
+/** @internal @This puts the current worker to sleep until some work is
+ * queued.
+ *
+ * @param tpool pointer to the pool
+ */
+static void upump_tpool_sleep(struct upump_tpool *tpool)
+{
+    pthread_mutex_lock(&tpool->lock);
+    uatomic_fetch_add(&tpool->nb_sleeping, 1);
+    if (!uatomic_load(&tpool->exiting) && !upump_tpool_queued(tpool))
+        pthread_cond_wait(&tpool->cond, &tpool->lock);
+    uatomic_fetch_sub(&tpool->nb_sleeping, 1);
+    pthread_mutex_unlock(&tpool->lock);
+}
+
+/** @internal @This makes all workers return.
+ *
+ * @param tpool pointer to the pool
+ */
+static void upump_tpool_exit(struct upump_tpool *tpool)
+{
+    pthread_mutex_lock(&tpool->lock);
+    uatomic_store(&tpool->exiting, 1);
+    pthread_cond_broadcast(&tpool->cond);
+    pthread_mutex_unlock(&tpool->lock);
+    eventfd_write(tpool->event_fd, 1);
+}
+
+/** @internal @This runs a worker until there is no started pump left.
+ *
+ * @param worker pointer to the worker
+ */
+static void upump_tpool_work(struct upump_tpool_worker *worker)
+{
+    struct upump_tpool *tpool = worker->tpool;
+    pthread_setspecific(tpool->key, worker);
+
+    while (!uatomic_load(&tpool->exiting)) {
+        struct upump_tpool_mgr *tpool_mgr = upump_tpool_worker_pop(worker);
+        if (tpool_mgr == NULL)
+            tpool_mgr = upump_tpool_worker_steal(worker);
+        if (tpool_mgr != NULL) {
+            upump_tpool_mgr_run(worker, tpool_mgr);
+            /* keep watching file descriptors while all workers are busy */
+            if (pthread_mutex_trylock(&tpool->poll_lock) == 0) {
+                upump_tpool_poll(worker, 0);
+                pthread_mutex_unlock(&tpool->poll_lock);
+            }
+            continue;
+        }
+
+        if (!uatomic_load(&tpool->activity)) {
+            upump_tpool_exit(tpool);
+            break;
+        }
+
+        if (pthread_mutex_trylock(&tpool->poll_lock) == 0) {
+            upump_tpool_poll(worker, -1);
+            pthread_mutex_unlock(&tpool->poll_lock);
+        } else
+            upump_tpool_sleep(tpool);
+    }
+
+    pthread_setspecific(tpool->key, NULL);
+}
+
+/** @internal @This is the entry point of the worker threads.
+ *
+ * @param arg pointer to the worker
+ * @return NULL
+ */
+static void *upump_tpool_thread(void *arg)
+{
+    upump_tpool_work(arg);
+    return NULL;
+}
+
+/** @This runs the pool with the calling thread and the other worker
+ * threads, until there is no started pump left in any of its managers.
+ *
+ * @param tpool pointer to the pool
+ * @return an error code
+ */
+int upump_tpool_run(struct upump_tpool *tpool)
+{
+    upump_tpool_use(tpool);
+    uatomic_store(&tpool->exiting, 0);
+    uatomic_store(&tpool->steals, 0);
+
+    int err = UBASE_ERR_NONE;
+    unsigned int nb_threads;
+    for (nb_threads = 1; nb_threads < tpool->nb_workers; nb_threads++)
+        if (unlikely(pthread_create(&tpool->workers[nb_threads].thread, NULL,
+                                    upump_tpool_thread,
+                                    &tpool->workers[nb_threads]) != 0)) {
+            err = UBASE_ERR_EXTERNAL;
+            upump_tpool_exit(tpool);
+            break;
+        }
+
+    upump_tpool_work(&tpool->workers[0]);
+    for (unsigned int i = 1; i < nb_threads; i++)
+        pthread_join(tpool->workers[i].thread, NULL);
+
+    /* no worker polls any longer */
+    upump_tpool_reap(tpool);
+    upump_tpool_release(tpool);
+    return err;
+}
+
+/** @This returns the number of times a worker took a runnable manager from
+ * the queue of another worker, during the last run.
+ *
+ * @param tpool pointer to the pool
+ * @return number of steals
+ */
+uint64_t upump_tpool_get_steals(struct upump_tpool *tpool)
+{
+    return uatomic_load(&tpool->steals);
+}
+
+/** @This allocates a new upump_tpool_pump.
+ *
+ * @param mgr pointer to a upump_mgr structure wrapped into a
+ * upump_tpool_mgr structure
+ * @param event type of event to watch for
+ * @param args optional parameters depending on event type
+ * @return pointer to allocated pump, or NULL in case of failure
+ */
+static struct upump *upump_tpool_pump_alloc(struct upump_mgr *mgr,
+                                       enum upump_type event, va_list args)
+{
+    struct upump_tpool_mgr *tpool_mgr = upump_tpool_mgr_from_upump_mgr(mgr);
+    struct upump_tpool_pump *pump =
+        upool_alloc(&tpool_mgr->common_mgr.upump_pool,
+                    struct upump_tpool_pump *);
+    if (unlikely(pump == NULL))
+        return NULL;
+    struct upump *upump = upump_tpool_pump_to_upump(pump);
+
+    pump->fd = -1;
+    switch (event) {
+        case UPUMP_TYPE_IDLER:
+            break;
+        case UPUMP_TYPE_TIMER:
+            pump->after = va_arg(args, uint64_t);
+            pump->repeat = va_arg(args, uint64_t);
+            pump->fd = timerfd_create(CLOCK_MONOTONIC,
+                                      TFD_NONBLOCK | TFD_CLOEXEC);
+            if (unlikely(pump->fd == -1)) {
+                upool_free(&tpool_mgr->common_mgr.upump_pool, pump);
+                return NULL;
+            }
+            break;
+        case UPUMP_TYPE_FD_READ:
+        case UPUMP_TYPE_FD_WRITE:
+            pump->fd = va_arg(args, int);
+            break;
+        default:
+            upool_free(&tpool_mgr->common_mgr.upump_pool, pump);
+            return NULL;
+    }
+    pump->event = event;
+    uchain_init(&pump->uchain);
+    pump->registered = false;
+    pump->active = false;
+
+    upump_mgr_use(mgr);
+    upump_common_init(upump);
+
+    return upump;
+}
+
+/** @This starts a pump.
+ *
+ * @param upump description structure of the pump
+ */
+static void upump_tpool_real_start(struct upump *upump)
+{
+    struct upump_tpool_pump *pump = upump_tpool_pump_from_upump(upump);
+    struct upump_tpool_mgr *tpool_mgr = upump_tpool_pump_mgr(pump);
+    pthread_mutex_lock(&tpool_mgr->lock);
+    if (pump->active) {
+        pthread_mutex_unlock(&tpool_mgr->lock);
+        return;
+    }
+    pump->active = true;
+    uatomic_fetch_add(&tpool_mgr->tpool->activity, 1);
+
+    switch (pump->event) {
+        case UPUMP_TYPE_IDLER:
+            ulist_add(&tpool_mgr->idlers, upump_tpool_pump_to_uchain(pump));
+            upump_tpool_mgr_wake(tpool_mgr);
+            break;
+        case UPUMP_TYPE_TIMER: {
+            struct itimerspec value;
+            /* a zero value would disarm the timer */
+            uint64_t after = pump->after ? pump->after : 1;
+            value.it_value.tv_sec = after / UCLOCK_FREQ;
+            value.it_value.tv_nsec = (after % UCLOCK_FREQ) * 1000000000 /
+                                     UCLOCK_FREQ;
+            if (!value.it_value.tv_sec && !value.it_value.tv_nsec)
+                value.it_value.tv_nsec = 1;
+            value.it_interval.tv_sec = pump->repeat / UCLOCK_FREQ;
+            value.it_interval.tv_nsec = (pump->repeat % UCLOCK_FREQ) *
+                                        1000000000 / UCLOCK_FREQ;
+            timerfd_settime(pump->fd, 0, &value, NULL);
+            upump_tpool_pump_arm(tpool_mgr, pump);
+            break;
+        }
+        case UPUMP_TYPE_FD_READ:
+        case UPUMP_TYPE_FD_WRITE:
+            upump_tpool_pump_arm(tpool_mgr, pump);
+            break;
+        default:
+            break;
+    }
+    pthread_mutex_unlock(&tpool_mgr->lock);
+}
+
+/** @This stops a pump. A file descriptor stays registered until the next
+ * event, which is then ignored.
+ *
+ * @param upump description structure of the pump
+ */
+static void upump_tpool_real_stop(struct upump *upump)
+{
+    struct upump_tpool_pump *pump = upump_tpool_pump_from_upump(upump);
+    struct upump_tpool_mgr *tpool_mgr = upump_tpool_pump_mgr(pump);
+    pthread_mutex_lock(&tpool_mgr->lock);
+    if (!pump->active) {
+        pthread_mutex_unlock(&tpool_mgr->lock);
+        return;
+    }
+    pump->active = false;
+    uatomic_fetch_sub(&tpool_mgr->tpool->activity, 1);
+
+    struct uchain *uchain = upump_tpool_pump_to_uchain(pump);
+    if (ulist_is_in(uchain))
+        ulist_delete(uchain);
+    if (pump->event == UPUMP_TYPE_TIMER) {
+        struct itimerspec value;
+        memset(&value, 0, sizeof(value));
+        timerfd_settime(pump->fd, 0, &value, NULL);
+    }
+    pthread_mutex_unlock(&tpool_mgr->lock);
+}
+
+/** @This released the memory space previously used by a pump.
+ * Please note that the pump must be stopped before.
+ *
+ * @param upump description structure of the pump
+ */
+static void upump_tpool_pump_free(struct upump *upump)
+{
+    struct upump_tpool_pump *pump = upump_tpool_pump_from_upump(upump);
+    struct upump_tpool_mgr *tpool_mgr = upump_tpool_pump_mgr(pump);
+    struct upump_tpool *tpool = tpool_mgr->tpool;
+    upump_stop(upump);
+    upump_common_clean(upump);
+    if (tpool_mgr->dispatching == pump)
+        tpool_mgr->dispatching = NULL;
+
+    bool zombie = false;
+    if (pump->registered) {
+        epoll_ctl(tpool->epoll_fd, EPOLL_CTL_DEL, pump->fd, NULL);
+        /* the polling worker may still hold an event for this pump */
+        if (pthread_mutex_trylock(&tpool->poll_lock) == 0)
+            pthread_mutex_unlock(&tpool->poll_lock);
+        else
+            zombie = true;
+    }
+    if (pump->event == UPUMP_TYPE_TIMER)
+        close(pump->fd);
+
+    if (zombie) {
+        pthread_mutex_lock(&tpool->lock);
+        ulist_add(&tpool->zombies, upump_tpool_pump_to_uchain(pump));
+        pthread_mutex_unlock(&tpool->lock);
+        return;
+    }
+    upool_free(&tpool_mgr->common_mgr.upump_pool, pump);
+    upump_mgr_release(&tpool_mgr->common_mgr.mgr);
+}
+
+/** @internal @This allocates the data structure.
+ *
+ * @param upool pointer to upool
+ * @return pointer to upump_tpool_pump or NULL in case of allocation error
+ */
+static void *upump_tpool_alloc_inner(struct upool *upool)
+{
+    struct upump_common_mgr *common_mgr =
+        upump_common_mgr_from_upump_pool(upool);
+    struct upump_tpool_pump *pump = malloc(sizeof(struct upump_tpool_pump));
+    if (unlikely(pump == NULL))
+        return NULL;
+    struct upump *upump = upump_tpool_pump_to_upump(pump);
+    upump->mgr = upump_common_mgr_to_upump_mgr(common_mgr);
+    return pump;
+}
+
+/** @internal @This frees a upump_tpool_pump.
+ *
+ * @param upool pointer to upool
+ * @param pump pointer to a upump_tpool_pump structure to free
+ */
+static void upump_tpool_free_inner(struct upool *upool, void *pump)
+{
+    free(pump);
+}
+
+/** @This processes control commands on a upump_tpool_mgr.
+ *
+ * @param mgr pointer to a upump_mgr structure
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upump_tpool_mgr_control(struct upump_mgr *mgr,
+                                   int command, va_list args)
+{
+    switch (command) {
+        case UPUMP_MGR_VACUUM:
+            upump_common_mgr_vacuum(mgr);
+            return UBASE_ERR_NONE;
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a upump manager.
+ *
+ * @param urefcount pointer to urefcount
+ */
+static void upump_tpool_mgr_free(struct urefcount *urefcount)
+{
+    struct upump_tpool_mgr *tpool_mgr =
+        upump_tpool_mgr_from_urefcount(urefcount);
+    struct upump_tpool *tpool = tpool_mgr->tpool;
+    upump_common_mgr_clean(upump_tpool_mgr_to_upump_mgr(tpool_mgr));
+    pthread_mutex_destroy(&tpool_mgr->lock);
+    urefcount_clean(urefcount);
+    free(tpool_mgr);
+    upump_tpool_release(tpool);
+}
+
+/** @This allocates and initializes a upump_mgr structure whose pumps are run
+ * by the given pool. All pumps of the manager are dispatched serially.
+ *
+ * @param tpool pointer to the pool
+ * @param upump_pool_depth maximum number of upump structures in the pool
+ * @param upump_blocker_pool_depth maximum number of upump_blocker structures in
+ * the pool
+ * @return pointer to the wrapped upump_mgr structure, or NULL in case of
+ * failure
+ */
+struct upump_mgr *upump_tpool_mgr_alloc(struct upump_tpool *tpool,
+                                        uint16_t upump_pool_depth,
+                                        uint16_t upump_blocker_pool_depth)
+{
+    struct upump_tpool_mgr *tpool_mgr =
+        malloc(sizeof(struct upump_tpool_mgr) +
+               upump_common_mgr_sizeof(upump_pool_depth,
+                                       upump_blocker_pool_depth));
+    if (unlikely(tpool_mgr == NULL))
+        return NULL;
+
+    tpool_mgr->tpool = upump_tpool_use(tpool);
+    pthread_mutex_init(&tpool_mgr->lock, NULL);
+    tpool_mgr->state = UPUMP_TPOOL_IDLE;
+    uchain_init(&tpool_mgr->uchain);
+    ulist_init(&tpool_mgr->pending);
+    ulist_init(&tpool_mgr->idlers);
+    tpool_mgr->dispatching = NULL;
+
+    struct upump_mgr *mgr = upump_tpool_mgr_to_upump_mgr(tpool_mgr);
+    upump_common_mgr_init(mgr, upump_pool_depth, upump_blocker_pool_depth,
+                          tpool_mgr->upool_extra,
+                          upump_tpool_real_start, upump_tpool_real_stop,
+                          upump_tpool_alloc_inner, upump_tpool_free_inner);
+
+    urefcount_init(upump_tpool_mgr_to_urefcount(tpool_mgr),
+                   upump_tpool_mgr_free);
+    tpool_mgr->common_mgr.mgr.refcount =
+        upump_tpool_mgr_to_urefcount(tpool_mgr);
+    tpool_mgr->common_mgr.mgr.upump_alloc = upump_tpool_pump_alloc;
+    tpool_mgr->common_mgr.mgr.upump_free = upump_tpool_pump_free;
+    tpool_mgr->common_mgr.mgr.upump_mgr_control = upump_tpool_mgr_control;
+    return mgr;
+}
+
+/** @This frees a pool.
+ *
+ * @param urefcount pointer to urefcount
+ */
+static void upump_tpool_destroy(struct urefcount *urefcount)
+{
+    struct upump_tpool *tpool = upump_tpool_from_urefcount(urefcount);
+    for (unsigned int i = 0; i < tpool->nb_workers; i++)
+        pthread_mutex_destroy(&tpool->workers[i].lock);
+    pthread_cond_destroy(&tpool->cond);
+    pthread_mutex_destroy(&tpool->lock);
+    pthread_mutex_destroy(&tpool->poll_lock);
+    pthread_key_delete(tpool->key);
+    close(tpool->event_fd);
+    close(tpool->epoll_fd);
+    uatomic_clean(&tpool->activity);
+    uatomic_clean(&tpool->nb_sleeping);
+    uatomic_clean(&tpool->blocked_poll);
+    uatomic_clean(&tpool->exiting);
+    uatomic_clean(&tpool->next_worker);
+    uatomic_clean(&tpool->steals);
+    urefcount_clean(urefcount);
+    free(tpool);
+}
+
+/** @This allocates a pool of worker threads. The threads are only created
+ * by @ref upump_tpool_run.
+ *
+ * @param nb_threads number of worker threads, including the thread calling
+ * @ref upump_tpool_run
+ * @return pointer to the pool, or NULL in case of failure
+ */
+struct upump_tpool *upump_tpool_alloc(unsigned int nb_threads)
+{
+    if (unlikely(!nb_threads))
+        return NULL;
+
+    struct upump_tpool *tpool =
+        malloc(sizeof(struct upump_tpool) +
+               nb_threads * sizeof(struct upump_tpool_worker));
+    if (unlikely(tpool == NULL))
+        return NULL;
+
+    tpool->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (unlikely(tpool->epoll_fd == -1)) {
+        free(tpool);
+        return NULL;
+    }
+    tpool->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = NULL;
+    if (unlikely(tpool->event_fd == -1 ||
+                 epoll_ctl(tpool->epoll_fd, EPOLL_CTL_ADD, tpool->event_fd,
+                           &event) == -1 ||
+                 pthread_key_create(&tpool->key, NULL) != 0)) {
+        if (tpool->event_fd != -1)
+            close(tpool->event_fd);
+        close(tpool->epoll_fd);
+        free(tpool);
+        return NULL;
+    }
+
+    pthread_mutex_init(&tpool->poll_lock, NULL);
+    pthread_mutex_init(&tpool->lock, NULL);
+    pthread_cond_init(&tpool->cond, NULL);
+    ulist_init(&tpool->zombies);
+    uatomic_init(&tpool->activity, 0);
+    uatomic_init(&tpool->nb_sleeping, 0);
+    uatomic_init(&tpool->blocked_poll, 0);
+    uatomic_init(&tpool->exiting, 0);
+    uatomic_init(&tpool->next_worker, 0);
+    uatomic_init(&tpool->steals, 0);
+
+    tpool->nb_workers = nb_threads;
+    for (unsigned int i = 0; i < nb_threads; i++) {
+        struct upump_tpool_worker *worker = &tpool->workers[i];
+        worker->tpool = tpool;
+        worker->index = i;
+        pthread_mutex_init(&worker->lock, NULL);
+        ulist_init(&worker->runnable);
+    }
+
+    urefcount_init(upump_tpool_to_urefcount(tpool), upump_tpool_destroy);
+    return tpool;
+}
+
+/** @This increments the reference count of a pool.
+ *
+ * @param tpool pointer to the pool
+ * @return same pointer to the pool
+ */
+struct upump_tpool *upump_tpool_use(struct upump_tpool *tpool)
+{
+    urefcount_use(upump_tpool_to_urefcount(tpool));
+    return tpool;
+}
+
+/** @This decrements the reference count of a pool, and frees it when it
+ * reaches 0. Managers allocated on the pool hold a reference to it.
+ *
+ * @param tpool pointer to the pool
+ */
+void upump_tpool_release(struct upump_tpool *tpool)
+{
+    urefcount_release(upump_tpool_to_urefcount(tpool));
+}
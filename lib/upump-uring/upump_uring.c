@@ -0,0 +1,775 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short implementation of a Upipe event loop using Linux io_uring
+ *
+ * The ring is driven with raw system calls. File descriptor pumps use
+ * one-shot poll requests that are armed again after each dispatch, and I/O
+ * pumps submit the operation itself. Timers and idlers are handled in
+ * userland, and the timeout of the next timer is passed to io_uring_enter,
+ * so that an iteration of the loop costs a single system call.
+ */
+
+#include <upipe/ubase.h>
+#include <upipe/ulist.h>
+#include <upipe/urefcount.h>
+#include <upipe/uclock.h>
+#include <upipe/upump.h>
+#include <upipe/upump_common.h>
+#include <upump-uring/upump_uring.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <time.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <sys/socket.h>
+
+#include <linux/io_uring.h>
+
+/** default number of submission queue entries */
+#define UPUMP_URING_ENTRIES 256
+
+/** @This stores management parameters and local structures.
+ */
+struct upump_uring_mgr {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** io_uring file descriptor */
+    int fd;
+    /** mapping of the submission and completion rings */
+    void *ring;
+    /** size of the mapping of the rings */
+    size_t ring_size;
+    /** array of submission queue entries */
+    struct io_uring_sqe *sqes;
+    /** size of the array of submission queue entries */
+    size_t sqes_size;
+
+    /** head of the submission ring, written by the kernel */
+    unsigned int *sq_head;
+    /** tail of the submission ring */
+    unsigned int *sq_tail;
+    /** local copy of the tail of the submission ring */
+    unsigned int sq_local_tail;
+    /** mask of the submission ring */
+    unsigned int sq_mask;
+    /** number of entries of the submission ring */
+    unsigned int sq_entries;
+    /** head of the completion ring */
+    unsigned int *cq_head;
+    /** tail of the completion ring, written by the kernel */
+    unsigned int *cq_tail;
+    /** mask of the completion ring */
+    unsigned int cq_mask;
+    /** array of completion queue entries */
+    struct io_uring_cqe *cqes;
+
+    /** list of pumps waiting for their operation to be submitted */
+    struct uchain to_arm;
+    /** list of pumps whose operation is completed */
+    struct uchain ready;
+    /** list of started timers, sorted by deadline */
+    struct uchain timers;
+    /** list of started idlers */
+    struct uchain idlers;
+    /** list of freed pumps whose operation is still in flight */
+    struct uchain zombies;
+    /** number of started pumps */
+    unsigned int nb_active;
+
+    /** common structure */
+    struct upump_common_mgr common_mgr;
+
+    /** extra space for upool */
+    uint8_t upool_extra[];
+};
+
+UBASE_FROM_TO(upump_uring_mgr, upump_mgr, upump_mgr, common_mgr.mgr)
+UBASE_FROM_TO(upump_uring_mgr, urefcount, urefcount, urefcount)
+
+/** @This stores local structures.
+ */
+struct upump_uring {
+    /** type of event to watch */
+    enum upump_type event;
+    /** structure for double-linked lists of the manager */
+    struct uchain uchain;
+    /** true if the pump is started and not blocked */
+    bool active;
+    /** true if an operation was submitted and is not completed */
+    bool in_flight;
+    /** true if the result of an I/O operation was not dispatched yet */
+    bool completed;
+    /** true if the pump was freed while its operation was in flight */
+    bool zombie;
+
+    union {
+        /** file descriptor to watch */
+        int fd;
+        /** description of the I/O operation */
+        struct upump_io *io;
+        /** timer parameters */
+        struct {
+            /** delay before the first trigger */
+            uint64_t after;
+            /** delay between subsequent triggers, or 0 */
+            uint64_t repeat;
+            /** date of the next trigger */
+            uint64_t deadline;
+        } timer;
+    };
+
+    /** common structure */
+    struct upump_common common;
+};
+
+UBASE_FROM_TO(upump_uring, upump, upump, common.upump)
+UBASE_FROM_TO(upump_uring, uchain, uchain, uchain)
+
+/** @internal @This returns the current monotonic date.
+ *
+ * @return date in 27 MHz ticks
+ */
+static uint64_t upump_uring_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * UCLOCK_FREQ +
+           (uint64_t)ts.tv_nsec * UCLOCK_FREQ / 1000000000;
+}
+
+/** @internal @This calls io_uring_enter.
+ *
+ * @param uring_mgr pointer to a upump_uring_mgr structure
+ * @param min_complete number of completions to wait for
+ * @param timeout maximum time to wait in 27 MHz ticks, or UINT64_MAX
+ * @return number of submitted entries, or a negative errno value
+ */
+static int upump_uring_enter(struct upump_uring_mgr *uring_mgr,
+                             unsigned int min_complete, uint64_t timeout)
+{
+    unsigned int to_submit = uring_mgr->sq_local_tail -
+        __atomic_load_n(uring_mgr->sq_head, __ATOMIC_ACQUIRE);
+    __atomic_store_n(uring_mgr->sq_tail, uring_mgr->sq_local_tail,
+                     __ATOMIC_RELEASE);
+    if (!to_submit && !min_complete)
+        return 0;
+
+    struct __kernel_timespec ts;
+    struct io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+    unsigned int flags = 0;
+    if (min_complete) {
+        flags |= IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+        if (timeout != UINT64_MAX) {
+            ts.tv_sec = timeout / UCLOCK_FREQ;
+            ts.tv_nsec = (timeout % UCLOCK_FREQ) * 1000000000 / UCLOCK_FREQ;
+            arg.ts = (uintptr_t)&ts;
+        }
+    }
+
+    int ret = syscall(__NR_io_uring_enter, uring_mgr->fd, to_submit,
+                      min_complete, flags, flags ? &arg : NULL,
+                      flags ? sizeof(arg) : 0);
+    return ret < 0 ? -errno : ret;
+}
+
+/** @internal @This returns a free submission queue entry.
+ *
+ * @param uring_mgr pointer to a upump_uring_mgr structure
+ * @return pointer to a cleared entry, or NULL if the ring is full
+ */
+static struct io_uring_sqe *upump_uring_get_sqe(
+        struct upump_uring_mgr *uring_mgr)
+{
+    unsigned int head = __atomic_load_n(uring_mgr->sq_head, __ATOMIC_ACQUIRE);
+    if (uring_mgr->sq_local_tail - head >= uring_mgr->sq_entries) {
+        upump_uring_enter(uring_mgr, 0, 0);
+        head = __atomic_load_n(uring_mgr->sq_head, __ATOMIC_ACQUIRE);
+        if (uring_mgr->sq_local_tail - head >= uring_mgr->sq_entries)
+            return NULL;
+    }
+    struct io_uring_sqe *sqe =
+        &uring_mgr->sqes[uring_mgr->sq_local_tail++ & uring_mgr->sq_mask];
+    memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+/** @internal @This submits the operations of the pumps waiting for it.
+ *
+ * @param uring_mgr pointer to a upump_uring_mgr structure
+ */
+static void upump_uring_arm(struct upump_uring_mgr *uring_mgr)
+{
+    struct uchain *uchain;
+    while ((uchain = ulist_peek(&uring_mgr->to_arm)) != NULL) {
+        struct upump_uring *upump_uring = upump_uring_from_uchain(uchain);
+        struct io_uring_sqe *sqe = upump_uring_get_sqe(uring_mgr);
+        if (unlikely(sqe == NULL))
+            return;
+
+        switch (upump_uring->event) {
+            case UPUMP_TYPE_FD_READ:
+            case UPUMP_TYPE_FD_WRITE:
+                sqe->opcode = IORING_OP_POLL_ADD;
+                sqe->fd = upump_uring->fd;
+                sqe->poll32_events =
+                    upump_uring->event == UPUMP_TYPE_FD_READ ?
+                    POLLIN : POLLOUT;
+                break;
+            case UPUMP_TYPE_IO: {
+                struct upump_io *io = upump_uring->io;
+                sqe->fd = io->fd;
+                switch (io->type) {
+                    case UPUMP_IO_READ:
+                    case UPUMP_IO_WRITE:
+                        sqe->opcode = io->type == UPUMP_IO_READ ?
+                                      IORING_OP_READV : IORING_OP_WRITEV;
+                        sqe->addr = (uintptr_t)io->iovecs;
+                        sqe->len = io->iovec_count;
+                        sqe->off = io->offset;
+                        break;
+                    case UPUMP_IO_RECVMSG:
+                    case UPUMP_IO_SENDMSG:
+                        sqe->opcode = io->type == UPUMP_IO_RECVMSG ?
+                                      IORING_OP_RECVMSG : IORING_OP_SENDMSG;
+                        sqe->addr = (uintptr_t)io->msg;
+                        sqe->len = 1;
+                        break;
+                }
+                break;
+            }
+            default:
+                break;
+        }
+        sqe->user_data = (uintptr_t)upump_uring;
+        upump_uring->in_flight = true;
+        ulist_delete(uchain);
+    }
+}
+
+/** @internal @This processes the completion queue, without calling any
+ * callback.
+ *
+ * @param uring_mgr pointer to a upump_uring_mgr structure
+ */
+static void upump_uring_reap(struct upump_uring_mgr *uring_mgr)
+{
+    unsigned int head = *uring_mgr->cq_head;
+    unsigned int tail = __atomic_load_n(uring_mgr->cq_tail, __ATOMIC_ACQUIRE);
+    while (head != tail) {
+        struct io_uring_cqe *cqe = &uring_mgr->cqes[head++ & uring_mgr->cq_mask];
+        if (cqe->user_data == 0)
+            continue;
+
+        struct upump_uring *upump_uring =
+            (struct upump_uring *)(uintptr_t)cqe->user_data;
+        upump_uring->in_flight = false;
+        if (unlikely(upump_uring->zombie)) {
+            /* the operation of a freed pump is over, release it now */
+            ulist_delete(upump_uring_to_uchain(upump_uring));
+            upool_free(&uring_mgr->common_mgr.upump_pool, upump_uring);
+            continue;
+        }
+        if (upump_uring->event == UPUMP_TYPE_IO) {
+            upump_uring->io->ret = cqe->res;
+            upump_uring->completed = true;
+        }
+        if (upump_uring->active)
+            ulist_add(&uring_mgr->ready, upump_uring_to_uchain(upump_uring));
+    }
+    __atomic_store_n(uring_mgr->cq_head, head, __ATOMIC_RELEASE);
+}
+
+/** @internal @This inserts a timer in the sorted list of timers.
+ *
+ * @param uring_mgr pointer to a upump_uring_mgr structure
+ * @param upump_uring timer to insert
+ */
+static void upump_uring_insert_timer(struct upump_uring_mgr *uring_mgr,
+                                     struct upump_uring *upump_uring)
+{
+    struct uchain *uchain;
+    ulist_foreach_reverse (&uring_mgr->timers, uchain) {
+        struct upump_uring *timer = upump_uring_from_uchain(uchain);
+        if (timer->timer.deadline <= upump_uring->timer.deadline)
+            break;
+    }
+    ulist_insert(uchain, uchain->next, upump_uring_to_uchain(upump_uring));
+}
+
+/** @internal @This dispatches the pumps whose operation is completed.
+ *
+ * @param uring_mgr pointer to a upump_uring_mgr structure
+ * @return false if no pump was dispatched
+ */
+static bool upump_uring_dispatch_ready(struct upump_uring_mgr *uring_mgr)
+{
+    struct uchain ready;
+    ulist_init(&ready);
+    struct uchain *uchain;
+    while ((uchain = ulist_pop(&uring_mgr->ready)) != NULL)
+        ulist_add(&ready, uchain);
+    if (ulist_empty(&ready))
+        return false;
+
+    while ((uchain = ulist_pop(&ready)) != NULL) {
+        struct upump_uring *upump_uring = upump_uring_from_uchain(uchain);
+        /* arm again unless the callback stops or frees the pump */
+        upump_uring->completed = false;
+        ulist_add(&uring_mgr->to_arm, uchain);
+        upump_common_dispatch(upump_uring_to_upump(upump_uring));
+    }
+    return true;
+}
+
+/** @internal @This dispatches the expired timers.
+ *
+ * @param uring_mgr pointer to a upump_uring_mgr structure
+ * @return false if no pump was dispatched
+ */
+static bool upump_uring_dispatch_timers(struct upump_uring_mgr *uring_mgr)
+{
+    uint64_t now = upump_uring_now();
+    struct uchain expired;
+    ulist_init(&expired);
+    struct uchain *uchain;
+    while ((uchain = ulist_peek(&uring_mgr->timers)) != NULL &&
+           upump_uring_from_uchain(uchain)->timer.deadline <= now)
+        ulist_add(&expired, ulist_pop(&uring_mgr->timers));
+    if (ulist_empty(&expired))
+        return false;
+
+    while ((uchain = ulist_pop(&expired)) != NULL) {
+        struct upump_uring *upump_uring = upump_uring_from_uchain(uchain);
+        if (upump_uring->timer.repeat) {
+            upump_uring->timer.deadline += upump_uring->timer.repeat;
+            if (upump_uring->timer.deadline <= now)
+                upump_uring->timer.deadline = now + upump_uring->timer.repeat;
+            upump_uring_insert_timer(uring_mgr, upump_uring);
+        } else {
+            upump_uring->active = false;
+            uring_mgr->nb_active--;
+        }
+        upump_common_dispatch(upump_uring_to_upump(upump_uring));
+    }
+    return true;
+}
+
+/** @internal @This dispatches the started idlers. Like in libev, they are
+ * only called when no other pump was triggered.
+ *
+ * @param uring_mgr pointer to a upump_uring_mgr structure
+ */
+static void upump_uring_dispatch_idlers(struct upump_uring_mgr *uring_mgr)
+{
+    struct uchain idlers;
+    ulist_init(&idlers);
+    struct uchain *uchain;
+    while ((uchain = ulist_pop(&uring_mgr->idlers)) != NULL)
+        ulist_add(&idlers, uchain);
+
+    while ((uchain = ulist_pop(&idlers)) != NULL) {
+        struct upump_uring *upump_uring = upump_uring_from_uchain(uchain);
+        ulist_add(&uring_mgr->idlers, uchain);
+        upump_common_dispatch(upump_uring_to_upump(upump_uring));
+    }
+}
+
+/** @This runs the event loop of a upump_uring_mgr, until there is no started
+ * pump left.
+ *
+ * @param mgr pointer to a upump_mgr structure wrapped into a
+ * upump_uring_mgr structure
+ * @return an error code
+ */
+int upump_uring_mgr_run(struct upump_mgr *mgr)
+{
+    struct upump_uring_mgr *uring_mgr = upump_uring_mgr_from_upump_mgr(mgr);
+    upump_mgr_use(mgr);
+
+    int err = UBASE_ERR_NONE;
+    while (uring_mgr->nb_active) {
+        upump_uring_arm(uring_mgr);
+
+        uint64_t timeout = UINT64_MAX;
+        struct uchain *uchain;
+        if (!ulist_empty(&uring_mgr->ready) ||
+            !ulist_empty(&uring_mgr->idlers))
+            timeout = 0;
+        else if ((uchain = ulist_peek(&uring_mgr->timers)) != NULL) {
+            uint64_t deadline = upump_uring_from_uchain(uchain)->timer.deadline;
+            uint64_t now = upump_uring_now();
+            timeout = deadline > now ? deadline - now : 0;
+        }
+
+        int ret = upump_uring_enter(uring_mgr, timeout ? 1 : 0, timeout);
+        if (unlikely(ret < 0 && ret != -ETIME && ret != -EINTR &&
+                     ret != -EAGAIN && ret != -EBUSY)) {
+            err = UBASE_ERR_EXTERNAL;
+            break;
+        }
+
+        upump_uring_reap(uring_mgr);
+        bool dispatched = upump_uring_dispatch_ready(uring_mgr);
+        dispatched = upump_uring_dispatch_timers(uring_mgr) || dispatched;
+        if (!dispatched)
+            upump_uring_dispatch_idlers(uring_mgr);
+    }
+
+    upump_mgr_release(mgr);
+    return err;
+}
+
+/** @This allocates a new upump_uring.
+ *
+ * @param mgr pointer to a upump_mgr structure wrapped into a
+ * upump_uring_mgr structure
+ * @param event type of event to watch for
+ * @param args optional parameters depending on event type
+ * @return pointer to allocated pump, or NULL in case of failure
+ */
+static struct upump *upump_uring_alloc(struct upump_mgr *mgr,
+                                       enum upump_type event, va_list args)
+{
+    struct upump_uring_mgr *uring_mgr = upump_uring_mgr_from_upump_mgr(mgr);
+    struct upump_uring *upump_uring =
+        upool_alloc(&uring_mgr->common_mgr.upump_pool, struct upump_uring *);
+    if (unlikely(upump_uring == NULL))
+        return NULL;
+    struct upump *upump = upump_uring_to_upump(upump_uring);
+
+    switch (event) {
+        case UPUMP_TYPE_IDLER:
+            break;
+        case UPUMP_TYPE_TIMER:
+            upump_uring->timer.after = va_arg(args, uint64_t);
+            upump_uring->timer.repeat = va_arg(args, uint64_t);
+            break;
+        case UPUMP_TYPE_FD_READ:
+        case UPUMP_TYPE_FD_WRITE:
+            upump_uring->fd = va_arg(args, int);
+            break;
+        case UPUMP_TYPE_IO:
+            upump_uring->io = va_arg(args, struct upump_io *);
+            break;
+        default:
+            upool_free(&uring_mgr->common_mgr.upump_pool, upump_uring);
+            return NULL;
+    }
+    upump_uring->event = event;
+    uchain_init(&upump_uring->uchain);
+    upump_uring->active = false;
+    upump_uring->in_flight = false;
+    upump_uring->completed = false;
+    upump_uring->zombie = false;
+
+    upump_mgr_use(mgr);
+    upump_common_init(upump);
+
+    return upump;
+}
+
+/** @This starts a pump.
+ *
+ * @param upump description structure of the pump
+ */
+static void upump_uring_real_start(struct upump *upump)
+{
+    struct upump_uring *upump_uring = upump_uring_from_upump(upump);
+    struct upump_uring_mgr *uring_mgr =
+        upump_uring_mgr_from_upump_mgr(upump->mgr);
+    if (upump_uring->active)
+        return;
+    upump_uring->active = true;
+    uring_mgr->nb_active++;
+
+    struct uchain *uchain = upump_uring_to_uchain(upump_uring);
+    switch (upump_uring->event) {
+        case UPUMP_TYPE_IDLER:
+            ulist_add(&uring_mgr->idlers, uchain);
+            break;
+        case UPUMP_TYPE_TIMER:
+            upump_uring->timer.deadline =
+                upump_uring_now() + upump_uring->timer.after;
+            upump_uring_insert_timer(uring_mgr, upump_uring);
+            break;
+        case UPUMP_TYPE_IO:
+            if (upump_uring->completed) {
+                ulist_add(&uring_mgr->ready, uchain);
+                break;
+            }
+            /* fall through */
+        case UPUMP_TYPE_FD_READ:
+        case UPUMP_TYPE_FD_WRITE:
+            if (!upump_uring->in_flight && !ulist_is_in(uchain))
+                ulist_add(&uring_mgr->to_arm, uchain);
+            break;
+        default:
+            break;
+    }
+}
+
+/** @This stops a pump. Operations in flight are not cancelled: the
+ * completion of an I/O operation is reported when the pump is started again.
+ *
+ * @param upump description structure of the pump
+ */
+static void upump_uring_real_stop(struct upump *upump)
+{
+    struct upump_uring *upump_uring = upump_uring_from_upump(upump);
+    struct upump_uring_mgr *uring_mgr =
+        upump_uring_mgr_from_upump_mgr(upump->mgr);
+    if (!upump_uring->active)
+        return;
+    upump_uring->active = false;
+    uring_mgr->nb_active--;
+
+    struct uchain *uchain = upump_uring_to_uchain(upump_uring);
+    if (ulist_is_in(uchain))
+        ulist_delete(uchain);
+}
+
+/** @internal @This requests the cancellation of the operation in flight of
+ * a pump, without waiting for it. The completion of the operation is reported
+ * by the kernel later, possibly with -ECANCELED.
+ *
+ * @param uring_mgr pointer to a upump_uring_mgr structure
+ * @param upump_uring pump to cancel
+ */
+static void upump_uring_cancel(struct upump_uring_mgr *uring_mgr,
+                               struct upump_uring *upump_uring)
+{
+    struct io_uring_sqe *sqe = upump_uring_get_sqe(uring_mgr);
+    if (unlikely(sqe == NULL))
+        /* the operation will complete on its own */
+        return;
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = (uintptr_t)upump_uring;
+    sqe->user_data = 0;
+    upump_uring_enter(uring_mgr, 0, 0);
+}
+
+/** @This released the memory space previously used by a pump.
+ * Please note that the pump must be stopped before. An operation in flight
+ * is cancelled without waiting, and the structure is only recycled once its
+ * completion is reaped by the event loop.
+ *
+ * @param upump description structure of the pump
+ */
+static void upump_uring_free(struct upump *upump)
+{
+    struct upump_uring_mgr *uring_mgr =
+        upump_uring_mgr_from_upump_mgr(upump->mgr);
+    upump_stop(upump);
+    upump_common_clean(upump);
+    struct upump_uring *upump_uring = upump_uring_from_upump(upump);
+    if (upump_uring->in_flight) {
+        /* the completion still refers to the pump, so keep it detached from
+         * the caller until the completion is reaped */
+        struct uchain *uchain = upump_uring_to_uchain(upump_uring);
+        if (ulist_is_in(uchain))
+            ulist_delete(uchain);
+        upump_uring->zombie = true;
+        upump_uring->io = NULL;
+        ulist_add(&uring_mgr->zombies, uchain);
+        upump_uring_cancel(uring_mgr, upump_uring);
+    } else
+        upool_free(&uring_mgr->common_mgr.upump_pool, upump_uring);
+    upump_mgr_release(&uring_mgr->common_mgr.mgr);
+}
+
+/** @internal @This allocates the data structure.
+ *
+ * @param upool pointer to upool
+ * @return pointer to upump_uring or NULL in case of allocation error
+ */
+static void *upump_uring_alloc_inner(struct upool *upool)
+{
+    struct upump_common_mgr *common_mgr =
+        upump_common_mgr_from_upump_pool(upool);
+    struct upump_uring *upump_uring = malloc(sizeof(struct upump_uring));
+    if (unlikely(upump_uring == NULL))
+        return NULL;
+    struct upump *upump = upump_uring_to_upump(upump_uring);
+    upump->mgr = upump_common_mgr_to_upump_mgr(common_mgr);
+    return upump_uring;
+}
+
+/** @internal @This frees a upump_uring.
+ *
+ * @param upool pointer to upool
+ * @param upump_uring pointer to a upump_uring structure to free
+ */
+static void upump_uring_free_inner(struct upool *upool, void *upump_uring)
+{
+    free(upump_uring);
+}
+
+/** @This processes control commands on a upump_uring_mgr.
+ *
+ * @param mgr pointer to a upump_mgr structure
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upump_uring_mgr_control(struct upump_mgr *mgr,
+                                   int command, va_list args)
+{
+    switch (command) {
+        case UPUMP_MGR_VACUUM:
+            upump_common_mgr_vacuum(mgr);
+            return UBASE_ERR_NONE;
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a upump manager.
+ *
+ * @param urefcount pointer to urefcount
+ */
+static void upump_uring_mgr_free(struct urefcount *urefcount)
+{
+    struct upump_uring_mgr *uring_mgr =
+        upump_uring_mgr_from_urefcount(urefcount);
+    /* closing the ring cancels the remaining operations, and their
+     * completions are never reaped */
+    struct uchain *uchain;
+    while ((uchain = ulist_pop(&uring_mgr->zombies)) != NULL)
+        upool_free(&uring_mgr->common_mgr.upump_pool,
+                   upump_uring_from_uchain(uchain));
+    upump_common_mgr_clean(upump_uring_mgr_to_upump_mgr(uring_mgr));
+    munmap(uring_mgr->sqes, uring_mgr->sqes_size);
+    munmap(uring_mgr->ring, uring_mgr->ring_size);
+    close(uring_mgr->fd);
+    free(uring_mgr);
+}
+
+/** @This allocates and initializes a upump_mgr structure with its own
+ * io_uring instance.
+ *
+ * @param entries number of submission queue entries, or 0 for the default
+ * @param upump_pool_depth maximum number of upump structures in the pool
+ * @param upump_blocker_pool_depth maximum number of upump_blocker structures in
+ * the pool
+ * @return pointer to the wrapped upump_mgr structure, or NULL if io_uring is
+ * not supported by the running kernel
+ */
+struct upump_mgr *upump_uring_mgr_alloc(unsigned int entries,
+                                        uint16_t upump_pool_depth,
+                                        uint16_t upump_blocker_pool_depth)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = syscall(__NR_io_uring_setup,
+                     entries ? entries : UPUMP_URING_ENTRIES, &params);
+    if (unlikely(fd < 0))
+        return NULL;
+    /* timeouts of io_uring_enter appeared at the same time (Linux 5.11) */
+    if (unlikely(!(params.features & IORING_FEAT_SINGLE_MMAP) ||
+                 !(params.features & IORING_FEAT_EXT_ARG))) {
+        close(fd);
+        return NULL;
+    }
+
+    size_t sq_size = params.sq_off.array +
+                     params.sq_entries * sizeof(unsigned int);
+    size_t cq_size = params.cq_off.cqes +
+                     params.cq_entries * sizeof(struct io_uring_cqe);
+    size_t ring_size = sq_size > cq_size ? sq_size : cq_size;
+    void *ring = mmap(NULL, ring_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (unlikely(ring == MAP_FAILED)) {
+        close(fd);
+        return NULL;
+    }
+    size_t sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    void *sqes = mmap(NULL, sqes_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (unlikely(sqes == MAP_FAILED)) {
+        munmap(ring, ring_size);
+        close(fd);
+        return NULL;
+    }
+
+    struct upump_uring_mgr *uring_mgr =
+        malloc(sizeof(struct upump_uring_mgr) +
+               upump_common_mgr_sizeof(upump_pool_depth,
+                                       upump_blocker_pool_depth));
+    if (unlikely(uring_mgr == NULL)) {
+        munmap(sqes, sqes_size);
+        munmap(ring, ring_size);
+        close(fd);
+        return NULL;
+    }
+
+    uring_mgr->fd = fd;
+    uring_mgr->ring = ring;
+    uring_mgr->ring_size = ring_size;
+    uring_mgr->sqes = sqes;
+    uring_mgr->sqes_size = sqes_size;
+    uring_mgr->sq_head = ring + params.sq_off.head;
+    uring_mgr->sq_tail = ring + params.sq_off.tail;
+    uring_mgr->sq_local_tail = *uring_mgr->sq_tail;
+    uring_mgr->sq_mask = *(unsigned int *)(ring + params.sq_off.ring_mask);
+    uring_mgr->sq_entries = params.sq_entries;
+    uring_mgr->cq_head = ring + params.cq_off.head;
+    uring_mgr->cq_tail = ring + params.cq_off.tail;
+    uring_mgr->cq_mask = *(unsigned int *)(ring + params.cq_off.ring_mask);
+    uring_mgr->cqes = ring + params.cq_off.cqes;
+    /* entries are always used in ring order */
+    unsigned int *sq_array = ring + params.sq_off.array;
+    for (unsigned int i = 0; i < params.sq_entries; i++)
+        sq_array[i] = i;
+
+    ulist_init(&uring_mgr->to_arm);
+    ulist_init(&uring_mgr->ready);
+    ulist_init(&uring_mgr->timers);
+    ulist_init(&uring_mgr->idlers);
+    ulist_init(&uring_mgr->zombies);
+    uring_mgr->nb_active = 0;
+
+    struct upump_mgr *mgr = upump_uring_mgr_to_upump_mgr(uring_mgr);
+    upump_common_mgr_init(mgr, upump_pool_depth, upump_blocker_pool_depth,
+                          uring_mgr->upool_extra,
+                          upump_uring_real_start, upump_uring_real_stop,
+                          upump_uring_alloc_inner, upump_uring_free_inner);
+
+    urefcount_init(upump_uring_mgr_to_urefcount(uring_mgr),
+                   upump_uring_mgr_free);
+    uring_mgr->common_mgr.mgr.refcount =
+        upump_uring_mgr_to_urefcount(uring_mgr);
+    uring_mgr->common_mgr.mgr.upump_alloc = upump_uring_alloc;
+    uring_mgr->common_mgr.mgr.upump_free = upump_uring_free;
+    uring_mgr->common_mgr.mgr.upump_mgr_control = upump_uring_mgr_control;
+    return mgr;
+}
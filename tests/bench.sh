@@ -0,0 +1,18 @@
+#!/bin/sh
+# Runs the benchmark suite and writes the results, prefixed with a header
+# describing the build, to the given file (default bench.txt).
+# Extra options of upipe_bench may be passed in BENCH_FLAGS, for instance
+# BENCH_FLAGS="-r 9 -s 4" or BENCH_FLAGS="null_sink qsink_qsrc".
+
+set -e
+
+srcdir="$1"
+output="${2:-bench.txt}"
+
+{
+    echo "# commit `git -C "$srcdir" describe --always --dirty 2>/dev/null || echo unknown`"
+    echo "# date `date -u +%Y-%m-%dT%H:%M:%SZ`"
+    echo "# host `uname -srm`, `getconf _NPROCESSORS_ONLN 2>/dev/null || echo '?'` cpus"
+    echo "# flags $BENCH_FLAGS"
+    ./upipe_bench -t "$srcdir"/upipe_ts_test.ts $BENCH_FLAGS
+} | tee "$output"
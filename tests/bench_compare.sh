@@ -0,0 +1,36 @@
+#!/bin/sh
+# Compares two result files written by bench.sh, for instance from two
+# commits. For each scenario, prints the CPU time and allocations per uref
+# and the throughput of both runs, and the relative change of the CPU time.
+
+if [ $# -ne 2 ]; then
+    echo "Usage: $0 <old results> <new results>" >&2
+    exit 1
+fi
+
+awk '
+function field(line, key,    n, i, kv) {
+    n = split(line, kv, /[ =]/)
+    for (i = 1; i < n; i += 2)
+        if (kv[i] == key)
+            return kv[i + 1]
+    return ""
+}
+/^bench=/ {
+    name = field($0, "bench")
+    if (FNR == NR) {
+        old[name] = $0
+        next
+    }
+    if (!(name in old)) {
+        printf "%-14s (new)\n", name
+        next
+    }
+    o = old[name]
+    ocpu = field(o, "cpu_ns_per_uref"); ncpu = field($0, "cpu_ns_per_uref")
+    printf "%-14s %10.1f -> %10.1f ns/uref %+7.1f%%  %8.3f -> %8.3f allocs/uref  %10s -> %10s urefs/s\n",
+           name, ocpu, ncpu, (ocpu > 0 ? 100 * (ncpu - ocpu) / ocpu : 0),
+           field(o, "allocs_per_uref"), field($0, "allocs_per_uref"),
+           field(o, "urefs_per_s"), field($0, "urefs_per_s")
+}
+' "$1" "$2"
@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short benchmark of the access to block buffers
+ *
+ * The headers of the 7 TS packets of a UDP datagram are peeked and their
+ * payloads read, first from a single segment, then from a chain of one
+ * segment per packet, and from a chain of segments which do not match the
+ * packets, with offsets and with a cursor.
+ */
+
+#undef NDEBUG
+
+#include <upipe/umem.h>
+#include <upipe/umem_pool.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_block.h>
+#include <upipe/ubuf_block_mem.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <assert.h>
+#include <time.h>
+
+#define UMEM_POOL 16
+#define UBUF_POOL_DEPTH 16
+#define TS_SIZE 188
+#define TS_HEADER_SIZE 4
+#define NB_PACKETS 7
+/** size of the segments not matching the packets */
+#define ODD_SEGMENT 100
+#define DEFAULT_LOOPS 2000000
+
+static unsigned int nb_loops = DEFAULT_LOOPS;
+static volatile unsigned int sum;
+
+/** returns the CPU time of the process in nanoseconds */
+static uint64_t cputime(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * UINT64_C(1000000000) + ts.tv_nsec;
+}
+
+/** allocates a datagram made of segments of the given size */
+static struct ubuf *alloc_datagram(struct ubuf_mgr *mgr, int segment)
+{
+    struct ubuf *ubuf = NULL;
+    for (int offset = 0; offset < NB_PACKETS * TS_SIZE; offset += segment) {
+        int size = NB_PACKETS * TS_SIZE - offset;
+        if (size > segment)
+            size = segment;
+        struct ubuf *append = ubuf_block_alloc(mgr, size);
+        assert(append != NULL);
+        uint8_t *w;
+        ubase_assert(ubuf_block_write(append, 0, &size, &w));
+        for (int i = 0; i < size; i++)
+            w[i] = (offset + i) % TS_SIZE ? offset + i : 0x47;
+        ubase_assert(ubuf_block_unmap(append, 0));
+        if (ubuf == NULL)
+            ubuf = append;
+        else
+            ubase_assert(ubuf_block_append(ubuf, append));
+    }
+    return ubuf;
+}
+
+/** walks through the packets with offsets */
+static void walk_offsets(struct ubuf *ubuf)
+{
+    unsigned int total = 0;
+    for (int i = 0; i < NB_PACKETS; i++) {
+        int offset = i * TS_SIZE;
+        uint8_t buffer[TS_HEADER_SIZE];
+        const uint8_t *header = ubuf_block_peek(ubuf, offset, TS_HEADER_SIZE,
+                                                buffer);
+        assert(header != NULL);
+        total += header[0] + header[3];
+        ubase_assert(ubuf_block_peek_unmap(ubuf, offset, buffer, header));
+
+        offset += TS_HEADER_SIZE;
+        int size = TS_SIZE - TS_HEADER_SIZE;
+        while (size > 0) {
+            int read_size = size;
+            const uint8_t *payload;
+            ubase_assert(ubuf_block_read(ubuf, offset, &read_size, &payload));
+            total += payload[read_size - 1];
+            ubase_assert(ubuf_block_unmap(ubuf, offset));
+            offset += read_size;
+            size -= read_size;
+        }
+    }
+    sum += total;
+}
+
+/** walks through the packets with a cursor */
+static void walk_cursor(struct ubuf *ubuf)
+{
+    unsigned int total = 0;
+    struct ubuf_block_cursor cursor;
+    ubase_assert(ubuf_block_cursor_init(&cursor, ubuf, 0));
+    for (int i = 0; i < NB_PACKETS; i++) {
+        uint8_t buffer[TS_HEADER_SIZE];
+        const uint8_t *header = ubuf_block_cursor_peek(&cursor,
+                TS_HEADER_SIZE, buffer);
+        assert(header != NULL);
+        total += header[0] + header[3];
+        ubase_assert(ubuf_block_cursor_peek_unmap(&cursor, buffer, header));
+        ubase_assert(ubuf_block_cursor_skip(&cursor, TS_HEADER_SIZE));
+
+        int size = TS_SIZE - TS_HEADER_SIZE;
+        while (size > 0) {
+            int read_size = size;
+            const uint8_t *payload;
+            ubase_assert(ubuf_block_cursor_read(&cursor, &read_size,
+                                                &payload));
+            total += payload[read_size - 1];
+            ubase_assert(ubuf_block_cursor_unmap(&cursor));
+            ubase_assert(ubuf_block_cursor_skip(&cursor, read_size));
+            size -= read_size;
+        }
+    }
+    sum += total;
+}
+
+static void bench(const char *name, struct ubuf *ubuf,
+                  void (*walk)(struct ubuf *))
+{
+    uint64_t start = cputime();
+    for (unsigned int i = 0; i < nb_loops; i++)
+        walk(ubuf);
+    uint64_t duration = cputime() - start;
+    printf("%-24s %8.1f ns per packet\n", name,
+           (double)duration / nb_loops / NB_PACKETS);
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stdout, "Usage: %s [-n <loops>]\n", argv0);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv)
+{
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+            case 'n':
+                nb_loops = strtoul(optarg, NULL, 10);
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+    if (!nb_loops)
+        usage(argv[0]);
+
+    struct umem_mgr *umem_mgr = umem_pool_mgr_alloc_simple(UMEM_POOL);
+    assert(umem_mgr != NULL);
+    struct ubuf_mgr *mgr = ubuf_block_mem_mgr_alloc(UBUF_POOL_DEPTH,
+                                                    UBUF_POOL_DEPTH,
+                                                    umem_mgr, -1, 0);
+    assert(mgr != NULL);
+
+    struct ubuf *single = alloc_datagram(mgr, NB_PACKETS * TS_SIZE);
+    struct ubuf *packets = alloc_datagram(mgr, TS_SIZE);
+    struct ubuf *odd = alloc_datagram(mgr, ODD_SEGMENT);
+
+    printf("%u datagrams of %u packets\n", nb_loops, NB_PACKETS);
+    bench("single segment", single, walk_offsets);
+    bench("single segment cursor", single, walk_cursor);
+    bench("packet segments", packets, walk_offsets);
+    bench("packet segments cursor", packets, walk_cursor);
+    bench("odd segments", odd, walk_offsets);
+    bench("odd segments cursor", odd, walk_cursor);
+
+    ubuf_free(single);
+    ubuf_free(packets);
+    ubuf_free(odd);
+    ubuf_mgr_release(mgr);
+    umem_mgr_release(umem_mgr);
+    return 0;
+}
@@ -206,6 +206,42 @@ int main(int argc, char **argv)
     assert(r[0] == 0 && r[3] == 3);
     ubase_assert(ubuf_block_peek_unmap(ubuf1, 0, buffer, r));
 
+    assert(ubuf_block_peek(ubuf1, 62, 4, buffer) == NULL);
+
+    /* test ubuf_block_cursor */
+    struct ubuf_block_cursor cursor;
+    ubase_nassert(ubuf_block_cursor_init(&cursor, ubuf1, 66));
+    ubase_assert(ubuf_block_cursor_init(&cursor, ubuf1, -35));
+    assert(!ubuf_block_cursor_end(&cursor));
+    r = ubuf_block_cursor_peek(&cursor, 4, buffer);
+    assert(r == buffer);
+    assert(r[0] == 30 && r[3] == 33);
+    ubase_assert(ubuf_block_cursor_peek_unmap(&cursor, buffer, r));
+
+    wanted = -1;
+    ubase_assert(ubuf_block_cursor_read(&cursor, &wanted, &r));
+    assert(wanted == 2);
+    assert(r[0] == 30 && r[1] == 31);
+    ubase_assert(ubuf_block_cursor_unmap(&cursor));
+
+    ubase_assert(ubuf_block_cursor_skip(&cursor, 3));
+    r = ubuf_block_cursor_peek(&cursor, 4, buffer);
+    assert(r != NULL);
+    assert(r != buffer);
+    assert(r[0] == 33 && r[3] == 36);
+    ubase_assert(ubuf_block_cursor_peek_unmap(&cursor, buffer, r));
+
+    ubase_assert(ubuf_block_cursor_skip(&cursor, 29));
+    assert(ubuf_block_cursor_peek(&cursor, 4, buffer) == NULL);
+    r = ubuf_block_cursor_peek(&cursor, 3, buffer);
+    assert(r != NULL);
+    assert(r[0] == 62 && r[2] == 64);
+    ubase_assert(ubuf_block_cursor_peek_unmap(&cursor, buffer, r));
+    ubase_nassert(ubuf_block_cursor_skip(&cursor, 4));
+    ubase_assert(ubuf_block_cursor_skip(&cursor, 3));
+    assert(ubuf_block_cursor_end(&cursor));
+    ubase_nassert(ubuf_block_cursor_read(&cursor, &wanted, &r));
+
     /* test refcounting */
     wanted = -1;
     ubase_nassert(ubuf_block_write(ubuf1, 32, &wanted, &w));
@@ -250,6 +286,33 @@ int main(int argc, char **argv)
     ubase_assert(ubuf_block_find(ubuf1, &offset, 2, 2, 3));
     assert(offset == 2);
 
+    /* test ubuf_block_scan_sync across segments */
+    ubuf2 = ubuf_block_alloc(mgr, 100);
+    assert(ubuf2 != NULL);
+    ubuf3 = ubuf_block_alloc(mgr, 100);
+    assert(ubuf3 != NULL);
+    wanted = -1;
+    ubase_assert(ubuf_block_write(ubuf2, 0, &wanted, &w));
+    memset(w, 0, wanted);
+    w[5] = w[55] = w[10] = w[60] = 0x47;
+    ubase_assert(ubuf_block_unmap(ubuf2, 0));
+    wanted = -1;
+    ubase_assert(ubuf_block_write(ubuf3, 0, &wanted, &w));
+    memset(w, 0, wanted);
+    w[10] = w[60] = 0x47;
+    ubase_assert(ubuf_block_unmap(ubuf3, 0));
+    ubase_assert(ubuf_block_append(ubuf2, ubuf3));
+    offset = 0;
+    ubase_assert(ubuf_block_scan_sync(ubuf2, &offset, 0x47, 50, 4));
+    assert(offset == 10);
+    offset = 0;
+    ubase_nassert(ubuf_block_scan_sync(ubuf2, &offset, 0x47, 50, 5));
+    assert(offset == 10);
+    offset = 11;
+    ubase_nassert(ubuf_block_scan_sync(ubuf2, &offset, 0x47, 50, 4));
+    assert(offset == 60);
+    ubuf_free(ubuf2);
+
     /* test ubuf_block_stream */
     struct ubuf_block_stream s;
     ubuf_block_stream_init(&s, ubuf1, 0);
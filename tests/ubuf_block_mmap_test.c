@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for ubuf manager for block formats pointing to a mapped
+ * file
+ */
+
+#undef NDEBUG
+
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_block.h>
+#include <upipe/ubuf_block_mmap.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+
+#define UBUF_POOL_DEPTH     1
+#define UBUF_SIZE           1000
+#define NB_WINDOWS          3
+
+static char path[] = "/tmp/ubuf_block_mmap_test.XXXXXX";
+
+/** returns the number of octets of the file mapped in memory, or -1 if it
+ * cannot be known */
+static long mapped_size(void)
+{
+    FILE *maps = fopen("/proc/self/maps", "r");
+    if (maps == NULL)
+        return -1;
+
+    long size = 0;
+    char line[4096];
+    while (fgets(line, sizeof(line), maps) != NULL) {
+        unsigned long start, end;
+        if (strstr(line, path) != NULL &&
+            sscanf(line, "%lx-%lx", &start, &end) == 2)
+            size += end - start;
+    }
+    fclose(maps);
+    return size;
+}
+
+/** checks that a buffer contains the given part of the file */
+static void check(struct ubuf *ubuf, size_t offset, size_t size)
+{
+    size_t ubuf_size;
+    ubase_assert(ubuf_block_size(ubuf, &ubuf_size));
+    assert(ubuf_size == size);
+
+    int pos = 0;
+    while (size) {
+        const uint8_t *r;
+        int wanted = -1;
+        ubase_assert(ubuf_block_read(ubuf, pos, &wanted, &r));
+        for (int i = 0; i < wanted; i++)
+            assert(r[i] == (uint8_t)((offset + pos + i) * 7));
+        ubase_assert(ubuf_block_unmap(ubuf, pos));
+        pos += wanted;
+        size -= wanted;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    long page_size = sysconf(_SC_PAGESIZE);
+    size_t window_size = page_size * 2;
+    size_t file_size = window_size * NB_WINDOWS;
+
+    int fd = mkstemp(path);
+    assert(fd != -1);
+    uint8_t *data = malloc(file_size);
+    assert(data != NULL);
+    for (size_t i = 0; i < file_size; i++)
+        data[i] = i * 7;
+    assert(write(fd, data, file_size) == file_size);
+    free(data);
+
+    struct ubuf_mgr *mgr = ubuf_block_mmap_mgr_alloc(UBUF_POOL_DEPTH, fd,
+                                                     window_size);
+    assert(mgr != NULL);
+    /* the manager has its own file descriptor */
+    close(fd);
+
+    /* plain allocations are not possible */
+    assert(ubuf_block_alloc(mgr, UBUF_SIZE) == NULL);
+
+    struct ubuf *ubuf1 = ubuf_block_mmap_alloc(mgr, 100, UBUF_SIZE);
+    assert(ubuf1 != NULL);
+    check(ubuf1, 100, UBUF_SIZE);
+
+    /* buffers are read-only */
+    uint8_t *w;
+    int wanted = -1;
+    assert(!ubase_check(ubuf_block_write(ubuf1, 0, &wanted, &w)));
+
+    struct ubuf *ubuf2 = ubuf_dup(ubuf1);
+    assert(ubuf2 != NULL);
+    check(ubuf2, 100, UBUF_SIZE);
+    ubuf_free(ubuf2);
+
+    ubuf2 = ubuf_block_splice(ubuf1, 10, 20);
+    assert(ubuf2 != NULL);
+    check(ubuf2, 110, 20);
+    ubuf_free(ubuf2);
+    ubuf_free(ubuf1);
+
+    /* read the whole file sequentially */
+    struct ubuf *ubufs[file_size / UBUF_SIZE + 1];
+    unsigned int nb_ubufs = 0;
+    for (size_t offset = 0; offset < file_size; offset += UBUF_SIZE) {
+        size_t size = file_size - offset < UBUF_SIZE ?
+                      file_size - offset : UBUF_SIZE;
+        ubufs[nb_ubufs] = ubuf_block_mmap_alloc(mgr, offset, size);
+        assert(ubufs[nb_ubufs] != NULL);
+        check(ubufs[nb_ubufs], offset, size);
+        nb_ubufs++;
+    }
+
+    /* buffers of consecutive windows may be appended */
+    ubuf1 = ubuf_dup(ubufs[0]);
+    assert(ubuf1 != NULL);
+    for (unsigned int i = 1; i < nb_ubufs; i++) {
+        ubuf2 = ubuf_dup(ubufs[i]);
+        assert(ubuf2 != NULL);
+        ubase_assert(ubuf_block_append(ubuf1, ubuf2));
+    }
+    check(ubuf1, 0, file_size);
+
+    /* end of file */
+    ubuf2 = ubuf_block_mmap_alloc(mgr, file_size, 0);
+    assert(ubuf2 != NULL);
+    check(ubuf2, file_size, 0);
+    ubuf_free(ubuf2);
+
+    long mapped = mapped_size();
+    if (mapped != -1) {
+        assert(mapped >= file_size);
+        ubuf_free(ubuf1);
+        for (unsigned int i = 0; i < nb_ubufs / 2; i++)
+            ubuf_free(ubufs[i]);
+        /* the first windows are no longer used */
+        assert(mapped_size() < mapped);
+        for (unsigned int i = nb_ubufs / 2; i < nb_ubufs; i++)
+            ubuf_free(ubufs[i]);
+    } else {
+        ubuf_free(ubuf1);
+        for (unsigned int i = 0; i < nb_ubufs; i++)
+            ubuf_free(ubufs[i]);
+    }
+
+    /* going backwards maps a new window */
+    ubuf1 = ubuf_block_mmap_alloc(mgr, 0, UBUF_SIZE);
+    assert(ubuf1 != NULL);
+    check(ubuf1, 0, UBUF_SIZE);
+    ubuf_mgr_release(mgr);
+    /* the manager is kept alive by the buffer */
+    check(ubuf1, 0, UBUF_SIZE);
+    ubuf_free(ubuf1);
+
+    assert(mapped_size() <= 0);
+    unlink(path);
+    return 0;
+}
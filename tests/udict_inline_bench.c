@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short benchmark of the inline manager of dictionary attributes
+ *
+ * A dictionary holding the attributes of an elementary stream flow
+ * definition, as built by ts_demux and the framers, is queried, updated and
+ * duplicated in a loop. The cost per dictionary of each operation is
+ * printed.
+ */
+
+#undef NDEBUG
+
+#include <upipe/ubase.h>
+#include <upipe/umem.h>
+#include <upipe/umem_pool.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+#include <time.h>
+
+#define DEFAULT_LOOPS 200000
+#define UDICT_POOL_DEPTH 10
+
+/** named attributes of the flow definition */
+static const char *names[] = {
+    "t.pid", "t.pcr_pid", "t.maxdelay", "t.tbrate", "t.pes_id",
+    "t.pes_header", "t.pes_mindur", "t.descs", "f.program",
+    "b.octetrate", "b.max_octetrate", "b.max_buffer_size", "x.start_pts",
+    "x.latency_sys", "x.channels", "x.rate"
+};
+#define NB_NAMES (sizeof(names) / sizeof(names[0]))
+
+/** attributes which are looked up by pipes but usually absent */
+static const char *absent_names[] = {
+    "t.pes_align", "b.start", "x.discontinuity", "f.eof"
+};
+#define NB_ABSENT (sizeof(absent_names) / sizeof(absent_names[0]))
+
+/** returns the monotonic time in nanoseconds */
+static uint64_t now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * UINT64_C(1000000000) + ts.tv_nsec;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stdout, "Usage: %s [-n <loops>]\n", argv0);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int nb_loops = DEFAULT_LOOPS;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+            case 'n':
+                nb_loops = strtoul(optarg, NULL, 10);
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+
+    struct umem_mgr *umem_mgr = umem_pool_mgr_alloc_simple(UDICT_POOL_DEPTH);
+    assert(umem_mgr != NULL);
+    struct udict_mgr *mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH, umem_mgr,
+                                                   -1, -1);
+    assert(mgr != NULL);
+
+    struct udict *udict = udict_alloc(mgr, 0);
+    assert(udict != NULL);
+    ubase_assert(udict_set_string(udict, "block.mpeg2video.pic.",
+                                  UDICT_TYPE_FLOW_DEF, NULL));
+    ubase_assert(udict_set_unsigned(udict, 1, UDICT_TYPE_FLOW_ID, NULL));
+    ubase_assert(udict_set_unsigned(udict, 1920, UDICT_TYPE_PIC_HSIZE, NULL));
+    ubase_assert(udict_set_unsigned(udict, 1080, UDICT_TYPE_PIC_VSIZE, NULL));
+    for (unsigned int i = 0; i < NB_NAMES; i++)
+        ubase_assert(udict_set_unsigned(udict, i, UDICT_TYPE_UNSIGNED,
+                                        names[i]));
+
+    uint64_t sum = 0;
+    uint64_t start = now();
+    for (unsigned int loop = 0; loop < nb_loops; loop++) {
+        for (unsigned int i = 0; i < NB_NAMES; i++) {
+            uint64_t v;
+            ubase_assert(udict_get_unsigned(udict, &v, UDICT_TYPE_UNSIGNED,
+                                            names[i]));
+            sum += v;
+        }
+        for (unsigned int i = 0; i < NB_ABSENT; i++)
+            ubase_nassert(udict_get_void(udict, NULL, UDICT_TYPE_VOID,
+                                         absent_names[i]));
+    }
+    uint64_t get_duration = now() - start;
+
+    start = now();
+    for (unsigned int loop = 0; loop < nb_loops; loop++)
+        for (unsigned int i = 0; i < NB_NAMES; i++)
+            ubase_assert(udict_set_unsigned(udict, loop, UDICT_TYPE_UNSIGNED,
+                                            names[i]));
+    uint64_t set_duration = now() - start;
+
+    start = now();
+    for (unsigned int loop = 0; loop < nb_loops; loop++) {
+        struct udict *dup = udict_dup(udict);
+        assert(dup != NULL);
+        udict_free(dup);
+    }
+    uint64_t dup_duration = now() - start;
+    assert(sum == (uint64_t)nb_loops * NB_NAMES * (NB_NAMES - 1) / 2);
+
+    printf("%u named attributes, %u absent\n", (unsigned int)NB_NAMES,
+           (unsigned int)NB_ABSENT);
+    printf("get: %8.1f ns per udict\n", (double)get_duration / nb_loops);
+    printf("set: %8.1f ns per udict\n", (double)set_duration / nb_loops);
+    printf("dup: %8.1f ns per udict\n", (double)dup_duration / nb_loops);
+
+    udict_free(udict);
+    udict_mgr_release(mgr);
+    umem_mgr_release(umem_mgr);
+    return 0;
+}
@@ -44,6 +44,8 @@
 #include <assert.h>
 
 #define UDICT_POOL_DEPTH 1
+/** more than the number of attribute names which may be interned */
+#define NB_NAMES 1100
 
 #define SALUTATION "Hello everyone, this is just some padding to make the structure bigger, if you don't mind."
 
@@ -123,6 +125,42 @@ int main(int argc, char **argv)
     udict_free(udict2);
 
     udict_free(udict1);
+
+    /* names beyond the capacity of the interning table are stored as
+     * strings */
+    udict1 = udict_alloc(mgr, 0);
+    assert(udict1 != NULL);
+    char name[32];
+    for (unsigned int i = 0; i < NB_NAMES; i++) {
+        snprintf(name, sizeof(name), "x.name[%u]", i);
+        ubase_assert(udict_set_unsigned(udict1, i, UDICT_TYPE_UNSIGNED,
+                                        name));
+    }
+    for (unsigned int i = 0; i < NB_NAMES; i++) {
+        snprintf(name, sizeof(name), "x.name[%u]", i);
+        ubase_assert(udict_get_unsigned(udict1, &u, UDICT_TYPE_UNSIGNED,
+                                        name));
+        assert(u == i);
+        ubase_nassert(udict_get_void(udict1, NULL, UDICT_TYPE_VOID, name));
+    }
+    const char *iname = NULL;
+    enum udict_type itype = UDICT_TYPE_END;
+    unsigned int nb_attrs = 0;
+    while (ubase_check(udict_iterate(udict1, &iname, &itype)) &&
+           itype != UDICT_TYPE_END) {
+        snprintf(name, sizeof(name), "x.name[%u]", nb_attrs);
+        assert(itype == UDICT_TYPE_UNSIGNED);
+        assert(!strcmp(iname, name));
+        nb_attrs++;
+    }
+    assert(nb_attrs == NB_NAMES);
+    snprintf(name, sizeof(name), "x.name[%u]", 0);
+    ubase_assert(udict_delete(udict1, UDICT_TYPE_UNSIGNED, name));
+    snprintf(name, sizeof(name), "x.name[%u]", NB_NAMES - 1);
+    ubase_assert(udict_delete(udict1, UDICT_TYPE_UNSIGNED, name));
+    ubase_nassert(udict_get_unsigned(udict1, &u, UDICT_TYPE_UNSIGNED, name));
+    udict_free(udict1);
+
     udict_mgr_release(mgr);
 
     umem_mgr_release(umem_mgr);
@@ -162,7 +162,11 @@ int main(int argc, char **argv)
         0, 1000000, 5000000, 0, 50000, 0, 0, 10000000, 5000, 0
     };
     uint8_t ulifo_buffer[ulifo_sizeof(ULIFO_MAX_DEPTH)];
+#ifdef UQUEUE_MPMC
+    uint8_t uqueue_buffer[uqueue_mpmc_sizeof(UQUEUE_MAX_DEPTH)];
+#else
     uint8_t uqueue_buffer[uqueue_sizeof(UQUEUE_MAX_DEPTH)];
+#endif
 
     if (argc > 1)
         nb_loops = atoi(argv[1]);
@@ -181,7 +185,11 @@ int main(int argc, char **argv)
         ulifo_push(&ulifo, &elems[i].uchain);
     }
 
+#ifdef UQUEUE_MPMC
+    assert(uqueue_init_mpmc(&uqueue, UQUEUE_MAX_DEPTH, uqueue_buffer));
+#else
     assert(uqueue_init(&uqueue, UQUEUE_MAX_DEPTH, uqueue_buffer));
+#endif
     struct upump *upump = uqueue_upump_alloc_pop(&uqueue, upump_mgr, pop, NULL,
                                                  NULL);
     assert(upump != NULL);
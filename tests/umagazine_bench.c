@@ -0,0 +1,213 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short benchmark of umagazine against a bare ulifo
+ *
+ * From 1 to 8 threads allocate and free elements from a shared pool, either
+ * in their own thread, or in pairs where one thread allocates and hands the
+ * elements to the other one, which frees them (like a decoder thread and an
+ * encoder thread). The throughput with per-thread magazines is compared to
+ * the one with the shared LIFO alone.
+ */
+
+#undef NDEBUG
+
+#include <upipe/ubase.h>
+#include <upipe/uatomic.h>
+#include <upipe/ulifo.h>
+#include <upipe/umpmc.h>
+#include <upipe/umagazine.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#define POOL_DEPTH 1024
+#define QUEUE_LENGTH 255
+#define MAX_THREADS 8
+#define DEFAULT_ELEMENTS 1000000
+#define BATCH_SIZE 16
+
+/** number of elements allocated by each thread */
+static unsigned int nb_elements = DEFAULT_ELEMENTS;
+/** pool under test */
+static struct ulifo ulifo;
+static struct umagazine umagazine;
+
+/** @This is the context of a thread. */
+struct thread {
+    pthread_t id;
+    /** queue to the freeing thread, for pairs */
+    struct umpmc *umpmc;
+};
+
+/** returns the monotonic time in nanoseconds */
+static uint64_t now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * UINT64_C(1000000000) + ts.tv_nsec;
+}
+
+static void free_cb(void *opaque, void *element)
+{
+    free(element);
+}
+
+static void *alloc_element(void)
+{
+    void *element = umagazine_pop(&umagazine, void *);
+    if (unlikely(element == NULL))
+        element = malloc(64);
+    assert(element != NULL);
+    return element;
+}
+
+static void *local_thread(void *_thread)
+{
+    void *elements[BATCH_SIZE];
+    for (unsigned int n = 0; n < nb_elements; n += BATCH_SIZE) {
+        for (unsigned int i = 0; i < BATCH_SIZE; i++)
+            elements[i] = alloc_element();
+        for (unsigned int i = 0; i < BATCH_SIZE; i++)
+            umagazine_push(&umagazine, elements[i]);
+    }
+    return NULL;
+}
+
+static void *alloc_thread(void *_thread)
+{
+    struct thread *thread = (struct thread *)_thread;
+    for (unsigned int n = 0; n < nb_elements; n++) {
+        void *element = alloc_element();
+        while (!umpmc_push(thread->umpmc, element))
+            sched_yield();
+    }
+    return NULL;
+}
+
+static void *free_thread(void *_thread)
+{
+    struct thread *thread = (struct thread *)_thread;
+    void *elements[BATCH_SIZE];
+    unsigned int n = 0;
+    while (n < nb_elements) {
+        unsigned int nb = umpmc_pop_batch(thread->umpmc, elements,
+                                          BATCH_SIZE);
+        if (!nb) {
+            sched_yield();
+            continue;
+        }
+        for (unsigned int i = 0; i < nb; i++)
+            umagazine_push(&umagazine, elements[i]);
+        n += nb;
+    }
+    return NULL;
+}
+
+/** runs threads and returns the throughput in Mops/s */
+static double bench(unsigned int nb_threads, bool magazines, bool pairs,
+                    struct umagazine_stats *stats)
+{
+    uint8_t lifo_buffer[ulifo_sizeof(POOL_DEPTH)];
+    ulifo_init(&ulifo, POOL_DEPTH, lifo_buffer);
+    umagazine_init(&umagazine, &ulifo, magazines ? POOL_DEPTH / 4 : 0,
+                   POOL_DEPTH, free_cb, NULL);
+
+    struct thread threads[MAX_THREADS];
+    struct umpmc umpmcs[MAX_THREADS / 2];
+    uint8_t umpmc_buffers[MAX_THREADS / 2][umpmc_sizeof(QUEUE_LENGTH)];
+    uint64_t start = now();
+    for (unsigned int i = 0; i < nb_threads; i++) {
+        void *(*cb)(void *) = local_thread;
+        if (pairs) {
+            if (!(i % 2))
+                umpmc_init(&umpmcs[i / 2], QUEUE_LENGTH, umpmc_buffers[i / 2]);
+            threads[i].umpmc = &umpmcs[i / 2];
+            cb = i % 2 ? free_thread : alloc_thread;
+        }
+        assert(!pthread_create(&threads[i].id, NULL, cb, &threads[i]));
+    }
+    for (unsigned int i = 0; i < nb_threads; i++)
+        assert(!pthread_join(threads[i].id, NULL));
+    uint64_t duration = now() - start;
+
+    umagazine_stats(&umagazine, stats);
+    umagazine_clean(&umagazine);
+    void *element;
+    while ((element = ulifo_pop(&ulifo, void *)) != NULL)
+        free(element);
+    ulifo_clean(&ulifo);
+    if (pairs)
+        for (unsigned int i = 0; i < nb_threads / 2; i++)
+            umpmc_clean(&umpmcs[i]);
+
+    unsigned int nb_allocators = pairs ? nb_threads / 2 : nb_threads;
+    return (double)nb_elements * nb_allocators * 1000 / duration;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stdout, "Usage: %s [-n <elements per thread>]\n", argv0);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[])
+{
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+            case 'n':
+                nb_elements = strtoul(optarg, NULL, 10);
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+
+    struct umagazine_stats stats;
+    printf("%-8s %-6s %12s %12s %10s %10s %10s\n", "threads", "mode",
+           "ulifo Mop/s", "magaz Mop/s", "hits", "misses", "flushes");
+    for (unsigned int i = 1; i <= MAX_THREADS; i++) {
+        for (int pairs = 0; pairs <= 1; pairs++) {
+            if (pairs && i % 2)
+                continue;
+            double ulifo_rate = bench(i, false, pairs, &stats);
+            double magazine_rate = bench(i, true, pairs, &stats);
+            printf("%-8u %-6s %12.2f %12.2f %10"PRIu64" %10"PRIu64
+                   " %10"PRIu64"\n", i, pairs ? "pairs" : "local",
+                   ulifo_rate, magazine_rate,
+                   stats.hits, stats.misses, stats.flushes);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,209 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short unit tests for umagazine
+ */
+
+#undef NDEBUG
+
+#include <upipe/ubase.h>
+#include <upipe/uatomic.h>
+#include <upipe/ulifo.h>
+#include <upipe/umagazine.h>
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <pthread.h>
+
+#define LIFO_LENGTH 16
+#define MAGAZINE_SIZE 8
+#define NB_THREADS 4
+#define NB_LOOPS 10000
+
+static struct ulifo ulifo;
+static struct umagazine umagazine;
+static uatomic_uint32_t freed;
+static pthread_barrier_t barrier;
+
+static void free_cb(void *opaque, void *element)
+{
+    assert(opaque == &umagazine);
+    uatomic_fetch_add(&freed, 1);
+    free(element);
+}
+
+static void *alloc_element(void)
+{
+    void *element = umagazine_pop(&umagazine, void *);
+    if (element == NULL)
+        element = malloc(1);
+    assert(element != NULL);
+    return element;
+}
+
+static void *thread(void *unused)
+{
+    void *elements[MAGAZINE_SIZE * 2];
+    for (unsigned int loop = 0; loop < NB_LOOPS; loop++) {
+        unsigned int nb = loop % (MAGAZINE_SIZE * 2) + 1;
+        for (unsigned int i = 0; i < nb; i++)
+            elements[i] = alloc_element();
+        for (unsigned int i = 0; i < nb; i++)
+            umagazine_push(&umagazine, elements[i]);
+    }
+    /* the magazine is flushed when the thread exits */
+    return NULL;
+}
+
+static void *vacuum_thread(void *unused)
+{
+    for (unsigned int i = 0; i < 3; i++)
+        umagazine_push(&umagazine, malloc(1));
+    assert(ulifo_pop(&ulifo, void *) == NULL);
+    pthread_barrier_wait(&barrier);
+    /* the main thread vacuums the depot */
+    pthread_barrier_wait(&barrier);
+    assert(umagazine_pop(&umagazine, void *) == NULL);
+    assert(uatomic_load(&freed) == 3);
+    return NULL;
+}
+
+static void *bounded_thread(void *unused)
+{
+    /* the budget of the depot is exhausted, so there is no magazine */
+    void *element = malloc(1);
+    umagazine_push(&umagazine, element);
+    assert(ulifo_pop(&ulifo, void *) == element);
+    free(element);
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    uint8_t buffer[ulifo_sizeof(LIFO_LENGTH)];
+    struct umagazine_stats stats;
+    uatomic_init(&freed, 0);
+
+    /* single-threaded behaviour */
+    ulifo_init(&ulifo, LIFO_LENGTH, buffer);
+    umagazine_init(&umagazine, &ulifo, MAGAZINE_SIZE, LIFO_LENGTH, free_cb,
+                   &umagazine);
+    assert(umagazine_pop(&umagazine, void *) == NULL);
+    void *elements[MAGAZINE_SIZE + 1];
+    for (unsigned int i = 0; i < MAGAZINE_SIZE + 1; i++)
+        elements[i] = malloc(1);
+    for (unsigned int i = 0; i < MAGAZINE_SIZE + 1; i++)
+        umagazine_push(&umagazine, elements[i]);
+    /* half of the magazine was flushed, oldest first */
+    assert(ulifo_pop(&ulifo, void *) == elements[MAGAZINE_SIZE / 2 - 1]);
+    assert(ulifo_push(&ulifo, elements[MAGAZINE_SIZE / 2 - 1]));
+    for (int i = MAGAZINE_SIZE; i >= MAGAZINE_SIZE / 2; i--)
+        assert(umagazine_pop(&umagazine, void *) == elements[i]);
+    /* refilled from the shared LIFO */
+    assert(umagazine_pop(&umagazine, void *) ==
+           elements[MAGAZINE_SIZE / 2 - 1]);
+    assert(ulifo_pop(&ulifo, void *) == NULL);
+    for (int i = MAGAZINE_SIZE / 2 - 2; i >= 0; i--)
+        assert(umagazine_pop(&umagazine, void *) == elements[i]);
+    assert(umagazine_pop(&umagazine, void *) == NULL);
+
+    umagazine_stats(&umagazine, &stats);
+    assert(stats.hits == MAGAZINE_SIZE);
+    assert(stats.misses == 3);
+    assert(stats.flushes == 1);
+
+    for (unsigned int i = 0; i < 3; i++)
+        umagazine_push(&umagazine, elements[i]);
+    umagazine_vacuum(&umagazine);
+    assert(uatomic_load(&freed) == 3);
+    for (unsigned int i = 3; i < MAGAZINE_SIZE + 1; i++)
+        umagazine_push(&umagazine, elements[i]);
+    umagazine_clean(&umagazine);
+    assert(uatomic_load(&freed) == MAGAZINE_SIZE + 1);
+    void *element;
+    while ((element = ulifo_pop(&ulifo, void *)) != NULL)
+        free(element);
+    ulifo_clean(&ulifo);
+
+    /* the slot of the dead depot is reused */
+    ulifo_init(&ulifo, LIFO_LENGTH, buffer);
+    umagazine_init(&umagazine, &ulifo, MAGAZINE_SIZE,
+                   (NB_THREADS + 1) * MAGAZINE_SIZE, free_cb, &umagazine);
+    umagazine_push(&umagazine, malloc(1));
+    umagazine_stats(&umagazine, &stats);
+    assert(stats.hits == 0 && stats.misses == 0 && stats.flushes == 0);
+
+    /* several threads, whose magazines are flushed when they exit */
+    pthread_t ids[NB_THREADS];
+    for (unsigned int i = 0; i < NB_THREADS; i++)
+        assert(!pthread_create(&ids[i], NULL, thread, NULL));
+    for (unsigned int i = 0; i < NB_THREADS; i++)
+        assert(!pthread_join(ids[i], NULL));
+    umagazine_stats(&umagazine, &stats);
+    assert(stats.hits + stats.misses == NB_THREADS *
+           (NB_LOOPS / (MAGAZINE_SIZE * 2)) *
+           (MAGAZINE_SIZE * 2) * (MAGAZINE_SIZE * 2 + 1) / 2);
+    assert(stats.hits > stats.misses);
+
+    umagazine_clean(&umagazine);
+    while ((element = ulifo_pop(&ulifo, void *)) != NULL)
+        free(element);
+    ulifo_clean(&ulifo);
+
+    /* vacuuming reaches the magazines of other threads */
+    pthread_t id;
+    uatomic_store(&freed, 0);
+    ulifo_init(&ulifo, LIFO_LENGTH, buffer);
+    umagazine_init(&umagazine, &ulifo, MAGAZINE_SIZE, LIFO_LENGTH, free_cb,
+                   &umagazine);
+    assert(!pthread_barrier_init(&barrier, NULL, 2));
+    assert(!pthread_create(&id, NULL, vacuum_thread, NULL));
+    pthread_barrier_wait(&barrier);
+    umagazine_vacuum(&umagazine);
+    assert(uatomic_load(&freed) == 0);
+    pthread_barrier_wait(&barrier);
+    assert(!pthread_join(id, NULL));
+    pthread_barrier_destroy(&barrier);
+    umagazine_clean(&umagazine);
+    ulifo_clean(&ulifo);
+
+    /* the magazines of all threads together are bounded */
+    ulifo_init(&ulifo, LIFO_LENGTH, buffer);
+    umagazine_init(&umagazine, &ulifo, MAGAZINE_SIZE, MAGAZINE_SIZE + 1,
+                   free_cb, &umagazine);
+    element = malloc(1);
+    umagazine_push(&umagazine, element);
+    assert(ulifo_pop(&ulifo, void *) == NULL);
+    assert(!pthread_create(&id, NULL, bounded_thread, NULL));
+    assert(!pthread_join(id, NULL));
+    umagazine_clean(&umagazine);
+    assert(ulifo_pop(&ulifo, void *) == NULL);
+    ulifo_clean(&ulifo);
+
+    uatomic_clean(&freed);
+    return 0;
+}
@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short benchmark of umem huge manager against umem pool manager
+ *
+ * A window of raw video frames (1080p 4:2:2 10 bits, or the given size) is
+ * allocated, filled with a copy of a source frame, and released in a loop,
+ * like a pipeline keeping a few pictures in flight. The page faults taken
+ * during the loop and the copy throughput are compared between the two
+ * managers.
+ */
+
+#undef NDEBUG
+
+#include <upipe/ubase.h>
+#include <upipe/umem.h>
+#include <upipe/umem_pool.h>
+#include <upipe/umem_huge.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#define DEFAULT_FRAME_SIZE (1920 * 1080 * 2 * 10 / 8 * 2)
+#define DEFAULT_FRAMES 500
+#define WINDOW 8
+
+/** size of a frame */
+static size_t frame_size = DEFAULT_FRAME_SIZE;
+/** number of frames to copy */
+static unsigned int nb_frames = DEFAULT_FRAMES;
+
+/** returns the monotonic time in nanoseconds */
+static uint64_t now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * UINT64_C(1000000000) + ts.tv_nsec;
+}
+
+/** returns the number of minor page faults of the process */
+static uint64_t faults(void)
+{
+    struct rusage rusage;
+    getrusage(RUSAGE_SELF, &rusage);
+    return rusage.ru_minflt + rusage.ru_majflt;
+}
+
+/** copies frames and returns the throughput in GB/s */
+static double bench(struct umem_mgr *mgr, const uint8_t *source,
+                    uint64_t *faults_p)
+{
+    struct umem window[WINDOW];
+    uint64_t start_faults = faults();
+    uint64_t start = now();
+    for (unsigned int i = 0; i < nb_frames; i++) {
+        struct umem *umem = &window[i % WINDOW];
+        if (i >= WINDOW)
+            umem_free(umem);
+        assert(umem_alloc(mgr, umem, frame_size));
+        memcpy(umem_buffer(umem), source, frame_size);
+    }
+    for (unsigned int i = 0; i < WINDOW && i < nb_frames; i++)
+        umem_free(&window[i]);
+    uint64_t duration = now() - start;
+    *faults_p = faults() - start_faults;
+    return (double)frame_size * nb_frames / duration;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stdout, "Usage: %s [-n <frames>] [-s <frame size>] [-N <node>]\n",
+            argv0);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[])
+{
+    int numa_node = -1;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:N:")) != -1) {
+        switch (opt) {
+            case 'n':
+                nb_frames = strtoul(optarg, NULL, 10);
+                break;
+            case 's':
+                frame_size = strtoul(optarg, NULL, 10);
+                break;
+            case 'N':
+                numa_node = atoi(optarg);
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+
+    uint8_t *source = malloc(frame_size);
+    assert(source != NULL);
+    memset(source, 0x42, frame_size);
+
+    /* both managers keep the whole window in their pools */
+    struct umem_mgr *pool_mgr = umem_pool_mgr_alloc_simple(WINDOW * 8);
+    assert(pool_mgr != NULL);
+    struct umem_mgr *huge_mgr =
+        umem_huge_mgr_alloc_simple(WINDOW * frame_size * 2, numa_node,
+                                   WINDOW * 8);
+    assert(huge_mgr != NULL);
+
+    uint64_t pool_faults, huge_faults;
+    double pool_rate = bench(pool_mgr, source, &pool_faults);
+    double huge_rate = bench(huge_mgr, source, &huge_faults);
+
+    printf("%-12s %12s %10s\n", "manager", "faults", "GB/s");
+    printf("%-12s %12"PRIu64" %10.2f\n", "umem_pool", pool_faults, pool_rate);
+    printf("%-12s %12"PRIu64" %10.2f (%s)\n", "umem_huge", huge_faults,
+           huge_rate, umem_huge_mgr_hugetlb(huge_mgr) ? "hugetlb" : "thp");
+
+    umem_mgr_release(pool_mgr);
+    umem_mgr_release(huge_mgr);
+    free(source);
+    return 0;
+}
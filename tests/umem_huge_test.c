@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for umem huge manager
+ */
+
+#undef NDEBUG
+
+#include <upipe/umem.h>
+#include <upipe/umem_huge.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#define ARENA_SIZE (4 * 1024 * 1024)
+#define FRAME_SIZE (1024 * 1024)
+
+int main(int argc, char **argv)
+{
+    struct umem_mgr *mgr = umem_huge_mgr_alloc_simple(ARENA_SIZE, -1, 32);
+    assert(mgr != NULL);
+    printf("arena %s MAP_HUGETLB\n",
+           umem_huge_mgr_hugetlb(mgr) ? "uses" : "does not use");
+
+    struct umem umem;
+    assert(umem_alloc(mgr, &umem, 42));
+    uint8_t *p = umem_buffer(&umem);
+    assert(p != NULL);
+    assert(!((uintptr_t)p % 64));
+    memset(p, 0x42, 42);
+    printf("Passed 1\n");
+
+    assert(umem_realloc(&umem, 43));
+    p = umem_buffer(&umem);
+    assert(p != NULL);
+    assert(p[0] == 0x42);
+    assert(p[41] == 0x42);
+    p[42] = 0x43;
+    printf("Passed 2\n");
+
+    assert(umem_realloc(&umem, 8192));
+    p = umem_buffer(&umem);
+    assert(p != NULL);
+    assert(p[0] == 0x42);
+    assert(p[41] == 0x42);
+    assert(p[42] == 0x43);
+    memset(p + 43, 0x44, 8192 - 43);
+    printf("Passed 3\n");
+
+    assert(umem_realloc(&umem, 64));
+    p = umem_buffer(&umem);
+    assert(p != NULL);
+    assert(p[0] == 0x42);
+    assert(p[63] == 0x44);
+    umem_free(&umem);
+    printf("Passed 4\n");
+
+    assert(umem_alloc(mgr, &umem, 8192));
+    assert(umem_buffer(&umem) == p);
+    umem_free(&umem);
+    printf("Passed 5\n");
+
+    /* exhaust the arena, the last frames are allocated with malloc() */
+    struct umem frames[ARENA_SIZE / FRAME_SIZE + 2];
+    for (unsigned int i = 0; i < ARENA_SIZE / FRAME_SIZE + 2; i++) {
+        assert(umem_alloc(mgr, &frames[i], FRAME_SIZE));
+        memset(umem_buffer(&frames[i]), i, FRAME_SIZE);
+    }
+    for (unsigned int i = 0; i < ARENA_SIZE / FRAME_SIZE + 2; i++) {
+        assert(umem_buffer(&frames[i])[0] == i);
+        assert(umem_buffer(&frames[i])[FRAME_SIZE - 1] == i);
+    }
+    uint8_t *first = umem_buffer(&frames[0]);
+    for (unsigned int i = 0; i < ARENA_SIZE / FRAME_SIZE + 2; i++)
+        umem_free(&frames[i]);
+    printf("Passed 6\n");
+
+    /* buffers of the arena survive vacuuming */
+    umem_mgr_vacuum(mgr);
+    bool found = false;
+    for (unsigned int i = 0; i < ARENA_SIZE / FRAME_SIZE; i++) {
+        assert(umem_alloc(mgr, &frames[i], FRAME_SIZE));
+        found = found || umem_buffer(&frames[i]) == first;
+    }
+    assert(found);
+    for (unsigned int i = 0; i < ARENA_SIZE / FRAME_SIZE; i++)
+        umem_free(&frames[i]);
+    printf("Passed 7\n");
+
+    /* buffers larger than the largest pool */
+    assert(umem_alloc(mgr, &umem, 128 * 1024 * 1024 + 1));
+    umem_free(&umem);
+    printf("Passed 8\n");
+
+    umem_mgr_release(mgr);
+
+    /* binding to a node may not be permitted, but must not crash */
+    mgr = umem_huge_mgr_alloc_simple(ARENA_SIZE, 0, 32);
+    if (mgr != NULL) {
+        assert(umem_alloc(mgr, &umem, FRAME_SIZE));
+        memset(umem_buffer(&umem), 0, FRAME_SIZE);
+        umem_free(&umem);
+        umem_mgr_release(mgr);
+    }
+    printf("Passed 9\n");
+    return 0;
+}
@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short benchmark of umpmc against ufifo under producer contention
+ *
+ * From 1 to 8 producer threads push elements as fast as they can into a
+ * queue of 255 elements, which is emptied by a single consumer thread. The
+ * throughput of the lock-free ring is compared to the one of the uring-based
+ * FIFO formerly used by uqueue.
+ */
+
+#undef NDEBUG
+
+#include <upipe/ubase.h>
+#include <upipe/uatomic.h>
+#include <upipe/ufifo.h>
+#include <upipe/umpmc.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#define QUEUE_LENGTH 255
+#define MAX_PRODUCERS 8
+#define DEFAULT_ELEMENTS 1000000
+#define BATCH_SIZE 16
+
+/** number of elements pushed by each producer */
+static unsigned int nb_elements = DEFAULT_ELEMENTS;
+/** number of producers which are still running */
+static uatomic_uint32_t producers;
+/** queues under test */
+static struct ufifo ufifo;
+static struct umpmc umpmc;
+/** whether the consumer pops batches from the umpmc */
+static bool batch;
+
+/** returns the monotonic time in nanoseconds */
+static uint64_t now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * UINT64_C(1000000000) + ts.tv_nsec;
+}
+
+static void *ufifo_producer(void *unused)
+{
+    for (uintptr_t i = 1; i <= nb_elements; i++)
+        while (!ufifo_push(&ufifo, (void *)i))
+            sched_yield();
+    uatomic_fetch_sub(&producers, 1);
+    return NULL;
+}
+
+static void ufifo_consumer(void)
+{
+    for ( ; ; ) {
+        if (ufifo_pop(&ufifo, void *) != NULL)
+            continue;
+        if (!uatomic_load(&producers) && ufifo_pop(&ufifo, void *) == NULL)
+            break;
+        sched_yield();
+    }
+}
+
+static void *umpmc_producer(void *unused)
+{
+    for (uintptr_t i = 1; i <= nb_elements; i++)
+        while (!umpmc_push(&umpmc, (void *)i))
+            sched_yield();
+    uatomic_fetch_sub(&producers, 1);
+    return NULL;
+}
+
+static void umpmc_consumer(void)
+{
+    void *opaques[BATCH_SIZE];
+    unsigned int nb = batch ? BATCH_SIZE : 1;
+    for ( ; ; ) {
+        if (umpmc_pop_batch(&umpmc, opaques, nb))
+            continue;
+        if (!uatomic_load(&producers) && !umpmc_pop_batch(&umpmc, opaques, nb))
+            break;
+        sched_yield();
+    }
+}
+
+/** runs producers and a consumer, and returns the throughput in Mops/s */
+static double bench(unsigned int nb_producers, void *(*producer)(void *),
+                    void (*consumer)(void))
+{
+    pthread_t ids[MAX_PRODUCERS];
+    uatomic_store(&producers, nb_producers);
+    uint64_t start = now();
+    for (unsigned int i = 0; i < nb_producers; i++)
+        assert(!pthread_create(&ids[i], NULL, producer, NULL));
+    consumer();
+    for (unsigned int i = 0; i < nb_producers; i++)
+        assert(!pthread_join(ids[i], NULL));
+    uint64_t duration = now() - start;
+    return (double)nb_elements * nb_producers * 1000 / duration;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stdout, "Usage: %s [-n <elements per producer>]\n", argv0);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[])
+{
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+            case 'n':
+                nb_elements = strtoul(optarg, NULL, 10);
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+
+    uint8_t ufifo_buffer[ufifo_sizeof(QUEUE_LENGTH)];
+    uint8_t umpmc_buffer[umpmc_sizeof(QUEUE_LENGTH)];
+    ufifo_init(&ufifo, QUEUE_LENGTH, ufifo_buffer);
+    umpmc_init(&umpmc, QUEUE_LENGTH, umpmc_buffer);
+    uatomic_init(&producers, 0);
+
+    printf("%-10s %14s %14s %14s\n", "producers", "ufifo (Mops/s)",
+           "umpmc (Mops/s)", "batch (Mops/s)");
+    for (unsigned int i = 1; i <= MAX_PRODUCERS; i++) {
+        double ufifo_rate = bench(i, ufifo_producer, ufifo_consumer);
+        batch = false;
+        double umpmc_rate = bench(i, umpmc_producer, umpmc_consumer);
+        batch = true;
+        double batch_rate = bench(i, umpmc_producer, umpmc_consumer);
+        printf("%-10u %14.2f %14.2f %14.2f\n", i, ufifo_rate, umpmc_rate,
+               batch_rate);
+    }
+
+    uatomic_clean(&producers);
+    umpmc_clean(&umpmc);
+    ufifo_clean(&ufifo);
+    return 0;
+}
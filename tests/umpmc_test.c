@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short unit tests for umpmc
+ */
+
+#undef NDEBUG
+
+#include <upipe/ubase.h>
+#include <upipe/uatomic.h>
+#include <upipe/umpmc.h>
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+
+#define UMPMC_LENGTH 6
+#define NB_THREADS 4
+#define NB_LOOPS 10000
+#define BATCH_SIZE 5
+
+struct thread {
+    pthread_t id;
+    unsigned int thread;
+    uint64_t sum;
+    /** last element popped from each producer */
+    uintptr_t last[NB_THREADS];
+};
+
+static struct umpmc umpmc;
+static unsigned int nb_loops = NB_LOOPS;
+static uatomic_uint32_t done;
+
+/* elements are encoded as (thread << 24) | (loop + 1) to never be NULL */
+
+static void *push_thread(void *_thread)
+{
+    struct thread *thread = (struct thread *)_thread;
+    unsigned int loop = 0;
+    while (loop < nb_loops) {
+        void *opaques[BATCH_SIZE];
+        unsigned int nb = loop % BATCH_SIZE + 1;
+        if (nb > nb_loops - loop)
+            nb = nb_loops - loop;
+        for (unsigned int i = 0; i < nb; i++)
+            opaques[i] = (void *)(((uintptr_t)thread->thread << 24) |
+                                  (loop + i + 1));
+        unsigned int pushed = umpmc_push_batch(&umpmc, opaques, nb);
+        assert(pushed <= nb);
+        loop += pushed;
+        if (!pushed)
+            sched_yield();
+    }
+    return NULL;
+}
+
+static void *pop_thread(void *_thread)
+{
+    struct thread *thread = (struct thread *)_thread;
+    thread->sum = 0;
+    for (unsigned int i = 0; i < NB_THREADS; i++)
+        thread->last[i] = 0;
+    for ( ; ; ) {
+        void *opaques[BATCH_SIZE];
+        unsigned int popped = umpmc_pop_batch(&umpmc, opaques, BATCH_SIZE);
+        if (!popped) {
+            if (uatomic_load(&done))
+                return NULL;
+            sched_yield();
+            continue;
+        }
+        for (unsigned int i = 0; i < popped; i++) {
+            uintptr_t elem = (uintptr_t)opaques[i];
+            /* elements of a given producer are popped in order */
+            assert((elem & 0xffffff) > thread->last[elem >> 24]);
+            thread->last[elem >> 24] = elem & 0xffffff;
+            thread->sum += elem & 0xffffff;
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    uint8_t buffer[umpmc_sizeof(UMPMC_LENGTH)];
+
+    if (argc > 1)
+        nb_loops = atoi(argv[1]);
+
+    /* single-threaded behaviour */
+    umpmc_init(&umpmc, UMPMC_LENGTH, buffer);
+    assert(umpmc_capacity(&umpmc) == UMPMC_LENGTH);
+    assert(umpmc_pop(&umpmc, void *) == NULL);
+    for (int lap = 0; lap < 3; lap++) {
+        void *opaques[UMPMC_LENGTH + 2];
+        for (uintptr_t i = 0; i < UMPMC_LENGTH + 2; i++)
+            opaques[i] = (void *)(i + 1);
+        assert(umpmc_push(&umpmc, opaques[0]));
+        assert(umpmc_push_batch(&umpmc, opaques + 1, UMPMC_LENGTH + 1) ==
+               UMPMC_LENGTH - 1);
+        assert(!umpmc_push(&umpmc, opaques[UMPMC_LENGTH]));
+
+        assert(umpmc_pop(&umpmc, uintptr_t) == 1);
+        assert(umpmc_push(&umpmc, opaques[UMPMC_LENGTH]));
+        assert(!umpmc_push(&umpmc, opaques[UMPMC_LENGTH + 1]));
+
+        void *popped[UMPMC_LENGTH + 2];
+        assert(umpmc_pop_batch(&umpmc, popped, 2) == 2);
+        assert(popped[0] == opaques[1] && popped[1] == opaques[2]);
+        assert(umpmc_pop_batch(&umpmc, popped, UMPMC_LENGTH + 2) ==
+               UMPMC_LENGTH - 2);
+        for (int i = 0; i < UMPMC_LENGTH - 2; i++)
+            assert(popped[i] == opaques[i + 3]);
+        assert(umpmc_pop(&umpmc, void *) == NULL);
+    }
+    umpmc_clean(&umpmc);
+
+    /* multiple producers, with one and then several consumers */
+    for (unsigned int nb_poppers = 1; nb_poppers <= NB_THREADS;
+         nb_poppers += NB_THREADS - 1) {
+        umpmc_init(&umpmc, UMPMC_LENGTH, buffer);
+        uatomic_init(&done, 0);
+        struct thread pushers[NB_THREADS], poppers[NB_THREADS];
+        for (unsigned int i = 0; i < nb_poppers; i++) {
+            poppers[i].thread = i;
+            assert(!pthread_create(&poppers[i].id, NULL, pop_thread,
+                                   &poppers[i]));
+        }
+        for (unsigned int i = 0; i < NB_THREADS; i++) {
+            pushers[i].thread = i;
+            assert(!pthread_create(&pushers[i].id, NULL, push_thread,
+                                   &pushers[i]));
+        }
+        for (unsigned int i = 0; i < NB_THREADS; i++)
+            assert(!pthread_join(pushers[i].id, NULL));
+        uatomic_store(&done, 1);
+
+        uint64_t sum = 0;
+        for (unsigned int i = 0; i < nb_poppers; i++) {
+            assert(!pthread_join(poppers[i].id, NULL));
+            sum += poppers[i].sum;
+        }
+        assert(sum == (uint64_t)NB_THREADS * nb_loops * (nb_loops + 1) / 2);
+        assert(umpmc_pop(&umpmc, void *) == NULL);
+        uatomic_clean(&done);
+        umpmc_clean(&umpmc);
+    }
+
+    return 0;
+}
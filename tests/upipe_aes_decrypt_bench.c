@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short benchmark of AES-128-CBC decryption
+ *
+ * The portable and accelerated implementations decrypt the same buffer in
+ * chunks of the size of a datagram, of an HTTP read and of a whole HLS
+ * segment.
+ */
+
+#undef NDEBUG
+
+#include <upipe/ubase.h>
+#include <upipe-modules/upipe_aes_decrypt.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <assert.h>
+#include <time.h>
+
+#define BUFFER_SIZE (2 * 1024 * 1024)
+#define DEFAULT_LOOPS 4
+
+/** returns the monotonic time in nanoseconds */
+static uint64_t now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * UINT64_C(1000000000) + ts.tv_nsec;
+}
+
+/** prints the throughput of the decryption of a buffer in chunks */
+static void bench(const uint8_t *buffer, size_t chunk,
+                  const uint8_t round_keys[11][16], unsigned int loops)
+{
+    void (*decrypts[])(uint8_t *, size_t, const uint8_t [11][16],
+                       uint8_t [16]) = {
+        upipe_aes_decrypt_cbc_c, upipe_aes_decrypt_cbc
+    };
+    size_t size = BUFFER_SIZE - BUFFER_SIZE % chunk;
+    uint8_t *outputs[2];
+    uint64_t durations[2];
+    for (int i = 0; i < 2; i++) {
+        outputs[i] = malloc(size);
+        assert(outputs[i] != NULL);
+        durations[i] = 0;
+        for (unsigned int j = 0; j < loops; j++) {
+            memcpy(outputs[i], buffer, size);
+            uint8_t iv[16] = { 0 };
+            uint64_t start = now();
+            for (size_t offset = 0; offset < size; offset += chunk)
+                decrypts[i](outputs[i] + offset, chunk, round_keys, iv);
+            durations[i] += now() - start;
+        }
+    }
+    assert(!memcmp(outputs[0], outputs[1], size));
+    free(outputs[0]);
+    free(outputs[1]);
+
+    /* octets per nanosecond are thousands of MB/s */
+    printf("%-24zu %12.1f %12.1f\n", chunk,
+           (double)size * loops * 1000. / durations[0],
+           (double)size * loops * 1000. / durations[1]);
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stdout, "Usage: %s [-n <loops>]\n", argv0);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int loops = DEFAULT_LOOPS;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+            case 'n':
+                loops = strtoul(optarg, NULL, 10);
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+    if (!loops)
+        usage(argv[0]);
+
+    uint8_t *buffer = malloc(BUFFER_SIZE);
+    assert(buffer != NULL);
+    srand(42);
+    for (size_t i = 0; i < BUFFER_SIZE; i++)
+        buffer[i] = rand();
+
+    uint8_t key[16];
+    for (int i = 0; i < sizeof (key); i++)
+        key[i] = rand();
+    uint8_t round_keys[11][16];
+    upipe_aes_decrypt_expand_key(key, round_keys);
+
+    printf("%-24s %12s %12s\n", "chunk", "C (MB/s)", "AES-NI (MB/s)");
+    /* UDP datagram, HTTP read, HLS segment */
+    size_t chunks[] = { 1328, 65536, BUFFER_SIZE };
+    for (int i = 0; i < UBASE_ARRAY_SIZE(chunks); i++)
+        bench(buffer, chunks[i], (const uint8_t (*)[16])round_keys, loops);
+
+    free(buffer);
+    return 0;
+}
@@ -0,0 +1,306 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for aes decrypt module
+ */
+
+#undef NDEBUG
+
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/uprobe_ubuf_mem.h>
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_block.h>
+#include <upipe/ubuf_block_mem.h>
+#include <upipe/uref.h>
+#include <upipe/uref_flow.h>
+#include <upipe/uref_block_flow.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_std.h>
+#include <upipe/upipe.h>
+#include <upipe-modules/upipe_aes_decrypt.h>
+#include <upipe-modules/uref_aes_flow.h>
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <assert.h>
+
+#define UDICT_POOL_DEPTH 10
+#define UREF_POOL_DEPTH 10
+#define UBUF_POOL_DEPTH 10
+#define UPROBE_LOG_LEVEL UPROBE_LOG_DEBUG
+#define MAX_BLOCKS 40
+
+/* test vectors of NIST SP 800-38A, F.2.2 CBC-AES128.Decrypt */
+static const uint8_t key[16] = {
+    0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+    0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c
+};
+
+static const uint8_t iv[16] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+};
+
+static const uint8_t ciphertext[64] = {
+    0x76, 0x49, 0xab, 0xac, 0x81, 0x19, 0xb2, 0x46,
+    0xce, 0xe9, 0x8e, 0x9b, 0x12, 0xe9, 0x19, 0x7d,
+    0x50, 0x86, 0xcb, 0x9b, 0x50, 0x72, 0x19, 0xee,
+    0x95, 0xdb, 0x11, 0x3a, 0x91, 0x76, 0x78, 0xb2,
+    0x73, 0xbe, 0xd6, 0xb8, 0xe3, 0xc1, 0x74, 0x3b,
+    0x71, 0x16, 0xe6, 0x9e, 0x22, 0x22, 0x95, 0x16,
+    0x3f, 0xf1, 0xca, 0xa1, 0x68, 0x1f, 0xac, 0x09,
+    0x12, 0x0e, 0xca, 0x30, 0x75, 0x86, 0xe1, 0xa7
+};
+
+static const uint8_t plaintext[64] = {
+    0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96,
+    0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+    0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c,
+    0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+    0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11,
+    0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+    0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17,
+    0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10
+};
+
+/** sizes of the urefs sent to the pipe */
+static const int chunks[] = { 5, 11, 30, 1, 17 };
+
+static size_t received = 0;
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        default:
+            assert(0);
+            break;
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_NEW_FLOW_DEF:
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr,
+                                struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct upipe *upipe = malloc(sizeof(struct upipe));
+    assert(upipe != NULL);
+    upipe_init(upipe, mgr, uprobe);
+    return upipe;
+}
+
+/** helper phony pipe */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    assert(uref != NULL);
+    size_t size;
+    ubase_assert(uref_block_size(uref, &size));
+    upipe_dbg_va(upipe, "received buffer of size %zu", size);
+    assert(!(size % 16));
+    assert(received + size <= sizeof (plaintext));
+
+    uint8_t buffer[sizeof (plaintext)];
+    ubase_assert(uref_block_extract(uref, 0, size, buffer));
+    assert(!memcmp(buffer, plaintext + received, size));
+    received += size;
+    uref_free(uref);
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF:
+            return UBASE_ERR_NONE;
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *urequest = va_arg(args, struct urequest *);
+            return upipe_throw_provide_request(upipe, urequest);
+        }
+        case UPIPE_UNREGISTER_REQUEST:
+            return UBASE_ERR_NONE;
+        default:
+            assert(0);
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    upipe_clean(upipe);
+    free(upipe);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr aes_decrypt_test_mgr = {
+    .refcount = NULL,
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
+/** checks the accelerated and portable implementations against each other
+ * on every number of blocks, in one or two calls */
+static void check_cbc(const uint8_t round_keys[11][16])
+{
+    uint8_t buffer[MAX_BLOCKS * 16];
+    for (unsigned i = 0; i < sizeof (buffer); i++)
+        buffer[i] = rand();
+
+    for (unsigned blocks = 0; blocks <= MAX_BLOCKS; blocks++) {
+        uint8_t ref[MAX_BLOCKS * 16], dec[MAX_BLOCKS * 16];
+        uint8_t ref_iv[16], dec_iv[16];
+        memcpy(ref, buffer, blocks * 16);
+        memcpy(dec, buffer, blocks * 16);
+        memcpy(ref_iv, iv, sizeof (iv));
+        memcpy(dec_iv, iv, sizeof (iv));
+
+        upipe_aes_decrypt_cbc_c(ref, blocks * 16, round_keys, ref_iv);
+        unsigned half = blocks / 2;
+        upipe_aes_decrypt_cbc(dec, half * 16, round_keys, dec_iv);
+        upipe_aes_decrypt_cbc(dec + half * 16, (blocks - half) * 16,
+                              round_keys, dec_iv);
+        assert(!memcmp(ref, dec, blocks * 16));
+        assert(!memcmp(ref_iv, dec_iv, sizeof (ref_iv)));
+        if (blocks)
+            assert(!memcmp(ref_iv, buffer + (blocks - 1) * 16,
+                           sizeof (ref_iv)));
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    /* functions */
+    uint8_t round_keys[11][16];
+    upipe_aes_decrypt_expand_key(key, round_keys);
+
+    uint8_t buffer[sizeof (ciphertext)];
+    uint8_t buffer_iv[16];
+    memcpy(buffer, ciphertext, sizeof (buffer));
+    memcpy(buffer_iv, iv, sizeof (buffer_iv));
+    upipe_aes_decrypt_cbc_c(buffer, sizeof (buffer),
+                            (const uint8_t (*)[16])round_keys, buffer_iv);
+    assert(!memcmp(buffer, plaintext, sizeof (buffer)));
+
+    memcpy(buffer, ciphertext, sizeof (buffer));
+    memcpy(buffer_iv, iv, sizeof (buffer_iv));
+    upipe_aes_decrypt_cbc(buffer, sizeof (buffer),
+                          (const uint8_t (*)[16])round_keys, buffer_iv);
+    assert(!memcmp(buffer, plaintext, sizeof (buffer)));
+    assert(!memcmp(buffer_iv, ciphertext + sizeof (ciphertext) - 16,
+                   sizeof (buffer_iv)));
+
+    check_cbc((const uint8_t (*)[16])round_keys);
+
+    /* pipe */
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr,
+                                                   0);
+    assert(uref_mgr != NULL);
+    struct ubuf_mgr *ubuf_mgr = ubuf_block_mem_mgr_alloc(UBUF_POOL_DEPTH,
+                                                         UBUF_POOL_DEPTH,
+                                                         umem_mgr, -1, 0);
+    assert(ubuf_mgr != NULL);
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+    logger = uprobe_ubuf_mem_alloc(logger, umem_mgr, UBUF_POOL_DEPTH,
+                                   UBUF_POOL_DEPTH);
+    assert(logger != NULL);
+
+    struct upipe *upipe_sink = upipe_void_alloc(&aes_decrypt_test_mgr,
+                                                uprobe_use(logger));
+    assert(upipe_sink != NULL);
+
+    struct upipe_mgr *upipe_aes_decrypt_mgr = upipe_aes_decrypt_mgr_alloc();
+    assert(upipe_aes_decrypt_mgr != NULL);
+    struct upipe *upipe_aes_decrypt = upipe_void_alloc(upipe_aes_decrypt_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "aes decrypt"));
+    assert(upipe_aes_decrypt != NULL);
+    ubase_assert(upipe_set_output(upipe_aes_decrypt, upipe_sink));
+
+    struct uref *uref = uref_block_flow_alloc_def(uref_mgr, "aes.");
+    assert(uref != NULL);
+    ubase_assert(uref_aes_set_method(uref, "AES-128"));
+    ubase_assert(uref_aes_set_key(uref, key, sizeof (key)));
+    ubase_assert(uref_aes_set_iv(uref, iv, sizeof (iv)));
+    ubase_assert(upipe_set_flow_def(upipe_aes_decrypt, uref));
+    uref_free(uref);
+
+    size_t offset = 0;
+    for (unsigned i = 0; i < UBASE_ARRAY_SIZE(chunks); i++) {
+        uref = uref_block_alloc(uref_mgr, ubuf_mgr, chunks[i]);
+        assert(uref != NULL);
+        uint8_t *w;
+        int size = -1;
+        ubase_assert(uref_block_write(uref, 0, &size, &w));
+        assert(size == chunks[i]);
+        memcpy(w, ciphertext + offset, size);
+        ubase_assert(uref_block_unmap(uref, 0));
+        offset += size;
+        upipe_input(upipe_aes_decrypt, uref, NULL);
+    }
+    assert(offset == sizeof (ciphertext));
+
+    upipe_release(upipe_aes_decrypt);
+    printf("received: %zu\n", received);
+    assert(received == sizeof (plaintext));
+
+    /* release everything */
+    upipe_mgr_release(upipe_aes_decrypt_mgr); // nop
+
+    test_free(upipe_sink);
+
+    uref_mgr_release(uref_mgr);
+    ubuf_mgr_release(ubuf_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+
+    return 0;
+}
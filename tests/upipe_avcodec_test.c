@@ -33,11 +33,13 @@
 #include <upipe/uprobe_upump_mgr.h>
 #include <upipe/uprobe_ubuf_mem.h>
 #include <upipe/upipe.h>
+#include <upipe/upipe_helper_upipe.h>
 #include <upipe/umem.h>
 #include <upipe/umem_alloc.h>
 #include <upipe/udict.h>
 #include <upipe/udict_inline.h>
 #include <upipe/ubuf.h>
+#include <upipe/ubuf_mem.h>
 #include <upipe/ubuf_pic.h>
 #include <upipe/ubuf_pic_mem.h>
 #include <upipe/ubuf_sound.h>
@@ -83,8 +85,12 @@ UREF_ATTR_INT(xflow, num, "x.f.num", flow num)
 #define UBUF_ALIGN          32
 #define UBUF_ALIGN_OFFSET   0
 #define THREAD_NUM          4
+#define THREADS_BUDGET      6
+#define THREADS_CODECS      3
 #define FRAMES_LIMIT        100
 #define THREAD_FRAMES_LIMIT (FRAMES_LIMIT / 8)
+#define DR_ALIGN            16
+#define DR_THREADS          2
 #define WIDTH 120
 #define HEIGHT 90
 #define STREAM stdout
@@ -94,11 +100,13 @@ enum uprobe_log_level loglevel = UPROBE_LOG_VERBOSE;
 struct upipe_mgr *upipe_avcdec_mgr;
 struct upipe_mgr *upipe_avcenc_mgr;
 struct upipe_mgr *upipe_null_mgr;
+struct umem_mgr *umem_mgr;
 struct uref_mgr *uref_mgr;
 struct ubuf_mgr *sound_mgr;
 struct ubuf_mgr *pic_mgr;
 struct uprobe *logger;
 struct uprobe uprobe_avcenc_s;
+unsigned int budget_events = 0;
 
 struct thread {
     pthread_t id;
@@ -108,6 +116,118 @@ struct thread {
     struct upipe *avcenc;
 };
 
+/** ubuf manager provided to avcdec in the direct rendering tests */
+enum dr_test {
+    /** not a direct rendering test */
+    DR_NONE,
+    /** pictures are aligned, avcodec decodes into them */
+    DR_ALIGNED,
+    /** pictures are not aligned, avcdec copies avcodec buffers */
+    DR_UNALIGNED
+};
+
+enum dr_test dr_test = DR_NONE;
+int dr_thread_type = 0;
+struct ubuf_mgr *dr_ubuf_mgr = NULL;
+unsigned int dr_pics = 0;
+
+/** phony pipe checking the pictures output by avcdec */
+struct dr_sink {
+    struct upipe upipe;
+};
+
+/** helper phony pipe */
+UPIPE_HELPER_UPIPE(dr_sink, upipe, 0);
+
+/** helper phony pipe */
+static struct upipe *dr_sink_alloc(struct upipe_mgr *mgr,
+                                   struct uprobe *uprobe,
+                                   uint32_t signature, va_list args)
+{
+    struct dr_sink *dr_sink = malloc(sizeof(struct dr_sink));
+    assert(dr_sink != NULL);
+    upipe_init(&dr_sink->upipe, mgr, uprobe);
+    upipe_throw_ready(&dr_sink->upipe);
+    return &dr_sink->upipe;
+}
+
+/** helper phony pipe */
+static void dr_sink_input(struct upipe *upipe, struct uref *uref,
+                          struct upump **upump_p)
+{
+    size_t width, height, stride;
+    const uint8_t *buf;
+    ubase_assert(uref_pic_size(uref, &width, &height, NULL));
+    assert(width == WIDTH && height == HEIGHT);
+    ubase_assert(uref_pic_plane_size(uref, "y8", &stride, NULL, NULL, NULL));
+    ubase_assert(uref_pic_plane_read(uref, "y8", 0, 0, -1, -1, &buf));
+    if (dr_test == DR_ALIGNED)
+        /* decoded in place by avcodec */
+        assert(!((uintptr_t)buf % DR_ALIGN) && !(stride % DR_ALIGN));
+    else
+        /* copied from the buffers of avcodec */
+        assert(stride == WIDTH);
+    ubase_assert(uref_pic_plane_unmap(uref, "y8", 0, 0, -1, -1));
+    dr_pics++;
+    uref_free(uref);
+}
+
+/** helper phony pipe */
+static int dr_sink_provide_ubuf_mgr(struct upipe *upipe,
+                                    struct urequest *urequest)
+{
+    struct uref *flow_format = uref_dup(urequest->uref);
+    assert(flow_format != NULL);
+    if (dr_test == DR_UNALIGNED) {
+        uref_pic_flow_delete_align(flow_format);
+        uref_pic_flow_delete_vappend(flow_format);
+    }
+
+    struct ubuf_mgr *ubuf_mgr =
+        ubuf_mem_mgr_alloc_from_flow_def(UBUF_POOL_DEPTH, UBUF_POOL_DEPTH,
+                                         umem_mgr, flow_format);
+    assert(ubuf_mgr != NULL);
+    ubuf_mgr_release(dr_ubuf_mgr);
+    dr_ubuf_mgr = ubuf_mgr_use(ubuf_mgr);
+    return urequest_provide_ubuf_mgr(urequest, ubuf_mgr, flow_format);
+}
+
+/** helper phony pipe */
+static int dr_sink_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF:
+        case UPIPE_UNREGISTER_REQUEST:
+            return UBASE_ERR_NONE;
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *urequest = va_arg(args, struct urequest *);
+            if (urequest->type == UREQUEST_UBUF_MGR)
+                return dr_sink_provide_ubuf_mgr(upipe, urequest);
+            return upipe_throw_provide_request(upipe, urequest);
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static void dr_sink_free(struct upipe *upipe)
+{
+    struct dr_sink *dr_sink = dr_sink_from_upipe(upipe);
+    upipe_throw_dead(upipe);
+    upipe_clean(upipe);
+    free(dr_sink);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr dr_sink_mgr = {
+    .refcount = NULL,
+    .signature = 0,
+    .upipe_alloc = dr_sink_alloc,
+    .upipe_input = dr_sink_input,
+    .upipe_control = dr_sink_control
+};
+
 /** definition of our uprobe */
 static int catch(struct uprobe *uprobe, struct upipe *upipe, int event, va_list args)
 {
@@ -117,6 +237,30 @@ static int catch(struct uprobe *uprobe, struct upipe *upipe, int event, va_list
         case UPROBE_NEW_FLOW_DEF:
         case UPROBE_NEED_UPUMP_MGR:
             break;
+        case UPROBE_AVCDEC_THREADS: {
+            /* also UPROBE_AVCENC_THREADS and UPROBE_AV_THREADS_BUDGET */
+            uint32_t signature = va_arg(args, uint32_t);
+            if (signature == UPIPE_AV_SIGNATURE) {
+                assert(upipe == NULL);
+                unsigned int budget = va_arg(args, unsigned int);
+                unsigned int codecs = va_arg(args, unsigned int);
+                assert(budget == THREADS_BUDGET);
+                assert(codecs == THREADS_CODECS);
+                budget_events++;
+                break;
+            }
+            assert(signature == UPIPE_AVCDEC_SIGNATURE ||
+                   signature == UPIPE_AVCENC_SIGNATURE);
+            va_arg(args, int);
+            unsigned int threads = va_arg(args, unsigned int);
+            /* a fair share, and never more than the budget */
+            unsigned int used;
+            assert(threads >= 1 &&
+                   threads <= THREADS_BUDGET / THREADS_CODECS);
+            upipe_av_get_threads_budget(&used, NULL);
+            assert(used <= THREADS_BUDGET);
+            break;
+        }
         default:
             assert(0);
             break;
@@ -154,6 +298,18 @@ static int catch_avcenc(struct uprobe *uprobe, struct upipe *upipe,
     assert(avcdec);
     upipe_release(avcdec);
 
+    if (dr_test != DR_NONE) {
+        if (dr_thread_type)
+            ubase_assert(upipe_avcdec_set_threads(avcdec, dr_thread_type,
+                                                  DR_THREADS));
+        struct upipe *dr_sink = upipe_void_alloc(&dr_sink_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), loglevel, "dr sink"));
+        assert(dr_sink);
+        upipe_set_output(avcdec, dr_sink);
+        upipe_release(dr_sink);
+        return UBASE_ERR_NONE;
+    }
+
     /* /dev/null */
     struct upipe *null = upipe_void_alloc(upipe_null_mgr,
         uprobe_pfx_alloc_va(uprobe_use(logger), loglevel,
@@ -230,6 +386,47 @@ static void source_idler(struct upump *upump)
     thread->iteration++;
 }
 
+/* direct rendering test, without upump_mgr */
+static void test_direct_rendering(const char *codec_def, enum dr_test test,
+                                  int thread_type)
+{
+    dr_test = test;
+    dr_thread_type = thread_type;
+    dr_pics = 0;
+
+    struct uref *flow = uref_pic_flow_alloc_def(uref_mgr, 1);
+    assert(flow != NULL);
+    ubase_assert(uref_pic_flow_add_plane(flow, 1, 1, 1, "y8"));
+    ubase_assert(uref_pic_flow_add_plane(flow, 2, 2, 1, "u8"));
+    ubase_assert(uref_pic_flow_add_plane(flow, 2, 2, 1, "v8"));
+    ubase_assert(uref_pic_flow_set_hsize(flow, WIDTH));
+    ubase_assert(uref_pic_flow_set_vsize(flow, HEIGHT));
+    struct urational fps = { .num = 25, .den = 1 };
+    ubase_assert(uref_pic_flow_set_fps(flow, fps));
+    struct upipe *avcenc = build_pipeline(codec_def, NULL, -1, flow);
+    uref_free(flow);
+    /* B frames keep reference frames longer, so that avcodec releases
+     * them out of order */
+    if (thread_type & UPIPE_AV_THREAD_FRAME)
+        ubase_assert(upipe_set_option(avcenc, "bf", "2"));
+
+    for (int i = 0; i < FRAMES_LIMIT; i++) {
+        struct uref *pic = uref_pic_alloc(uref_mgr, pic_mgr, WIDTH, HEIGHT);
+        assert(pic != NULL);
+        fill_pic(pic->ubuf);
+        upipe_input(avcenc, pic, NULL);
+    }
+    upipe_release(avcenc);
+
+    /* all pictures, including those kept by avcodec, were released */
+    assert(dr_pics > 0);
+    assert(dr_ubuf_mgr != NULL);
+    assert(urefcount_single(dr_ubuf_mgr->refcount));
+    ubuf_mgr_release(dr_ubuf_mgr);
+    dr_ubuf_mgr = NULL;
+    dr_test = DR_NONE;
+}
+
 /* thread entry point */
 static void *thread_start(void *_thread)
 {
@@ -295,7 +492,7 @@ int main(int argc, char **argv)
     }
 
     /* uref and mem management */
-    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    umem_mgr = umem_alloc_mgr_alloc();
     assert(umem_mgr != NULL);
     struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH, umem_mgr, -1, -1);
     assert(udict_mgr != NULL);
@@ -332,6 +529,11 @@ int main(int argc, char **argv)
 
     /* init upipe_av */
     assert(upipe_av_init(false, uprobe_use(logger)));
+    upipe_av_set_threads_budget(THREADS_BUDGET, THREADS_CODECS);
+    assert(upipe_av_get_threads_budget(NULL, NULL) == THREADS_BUDGET);
+    /* the event is only thrown when the budget changes */
+    upipe_av_set_threads_budget(THREADS_BUDGET, THREADS_CODECS);
+    assert(budget_events == 1);
 
     /* global managers */
     assert(upipe_avcdec_mgr = upipe_avcdec_mgr_alloc());
@@ -365,6 +567,13 @@ int main(int argc, char **argv)
     struct upipe *avcenc = build_pipeline("mpeg2video.pic.", NULL, -1, flow);
     uref_free(flow);
 
+    int thread_type;
+    unsigned int threads;
+    ubase_assert(upipe_avcenc_set_threads(avcenc, UPIPE_AV_THREAD_SLICE, 2));
+    ubase_assert(upipe_avcenc_get_threads(avcenc, &thread_type, &threads));
+    assert(thread_type == UPIPE_AV_THREAD_SLICE);
+    assert(threads == 2);
+
     for (i=0; i < FRAMES_LIMIT; i++) {
         pic = uref_pic_alloc(uref_mgr, pic_mgr, WIDTH, HEIGHT);
         assert(pic != NULL);
@@ -375,6 +584,14 @@ int main(int argc, char **argv)
     upipe_release(avcenc);
     printf("Everything good so far, cleaning\n");
 
+    /* direct rendering into an aligned ubuf_mgr, or copy from avcodec
+     * buffers with an unaligned one */
+    test_direct_rendering("mpeg2video.pic.", DR_ALIGNED, 0);
+    test_direct_rendering("mpeg2video.pic.", DR_UNALIGNED, 0);
+    /* reference frames released out of order with frame threading */
+    test_direct_rendering("mpeg4.pic.", DR_ALIGNED, UPIPE_AV_THREAD_FRAME);
+    printf("Direct rendering tests ended\n");
+
     /* mono-threaded audio test without upump_mgr */
     flow = uref_sound_flow_alloc_def(uref_mgr, "s16le.", 2, 4);
     assert(flow != NULL);
@@ -398,6 +615,12 @@ int main(int argc, char **argv)
     upipe_release(avcenc);
     printf("Everything good so far, cleaning\n");
 
+    /* all codecs are closed and gave their threads back */
+    unsigned int used, codecs;
+    assert(upipe_av_get_threads_budget(&used, &codecs) == THREADS_BUDGET);
+    assert(used == 0);
+    assert(codecs == 0);
+
     /* clean managers and probes */
     upipe_mgr_release(upipe_avcdec_mgr);
     upipe_mgr_release(upipe_avcenc_mgr);
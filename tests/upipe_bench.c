@@ -0,0 +1,1036 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short reproducible benchmark suite of common pipelines
+ *
+ * Each scenario runs a fixed amount of work on generated or bundled content,
+ * once to warm up the pools and then a number of times, and the median wall
+ * and CPU times are reported. Allocations are counted by wrapping the libc
+ * allocator, so that a regression in pool usage shows up as allocations per
+ * uref.
+ *
+ * Results are printed one scenario per line, as key=value pairs, so that
+ * they can be compared between commits with bench_compare.sh. Scenarios
+ * which need an event loop are only built with libev, and the TS scenarios
+ * additionally need bitstream. The scaling scenarios need libswscale, and are
+ * named after the output size and the number of threads.
+ */
+
+#undef NDEBUG
+
+#include <upipe/ubase.h>
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/uprobe_stats.h>
+#include <upipe/uprobe_uref_mgr.h>
+#include <upipe/uprobe_upump_mgr.h>
+#include <upipe/uprobe_ubuf_mem.h>
+#include <upipe/umem.h>
+#include <upipe/umem_pool.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_block_mem.h>
+#include <upipe/uref.h>
+#include <upipe/uref_std.h>
+#include <upipe/uref_flow.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_block_flow.h>
+#include <upipe/uref_clock.h>
+#include <upipe/upipe.h>
+#include <upipe/upipe_stats.h>
+#include <upipe-modules/upipe_null.h>
+
+#ifdef HAVE_EV
+#include <upipe/upump.h>
+#include <upump-ev/upump_ev.h>
+#include <upipe-modules/upipe_file_source.h>
+#include <upipe-modules/upipe_queue_source.h>
+#include <upipe-modules/upipe_queue_sink.h>
+#include <ev.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#ifdef HAVE_BITSTREAM
+#include <upipe-ts/upipe_ts_demux.h>
+#include <upipe-ts/upipe_ts_mux.h>
+#include <upipe-framers/upipe_mpgv_framer.h>
+#include <upipe-framers/upipe_h264_framer.h>
+#include <upipe-framers/upipe_h265_framer.h>
+#include <upipe-framers/upipe_mpga_framer.h>
+#include <upipe-framers/upipe_a52_framer.h>
+#include <upipe-modules/upipe_noclock.h>
+#endif
+#endif
+
+#ifdef HAVE_SWSCALE
+#include <upipe/ubuf_pic_mem.h>
+#include <upipe/uref_pic.h>
+#include <upipe/uref_pic_flow.h>
+#include <upipe-swscale/upipe_sws.h>
+#endif
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <assert.h>
+#include <errno.h>
+#include <time.h>
+
+#define UMEM_POOL 512
+#define UDICT_POOL_DEPTH 512
+#define UREF_POOL_DEPTH 512
+#define UBUF_POOL_DEPTH 512
+#define UBUF_SHARED_POOL_DEPTH 512
+#define UPUMP_POOL 5
+#define UPUMP_BLOCKER_POOL 5
+#define UPROBE_LOG_LEVEL UPROBE_LOG_ERROR
+/** default number of measured runs of each scenario */
+#define DEFAULT_REPEATS 5
+/** size of the blocks of the synthetic scenarios (7 TS packets) */
+#define BLOCK_SIZE 1316
+/** number of urefs of the synthetic scenarios, per unit of scale */
+#define CHURN_UREFS 1000000
+/** number of urefs sent across threads, per unit of scale */
+#define QUEUE_UREFS 200000
+/** length of the queue between threads */
+#define QUEUE_LENGTH 255
+/** size of the generated file, per unit of scale */
+#define FILE_SIZE (32 * 1024 * 1024)
+/** number of times the TS file is processed, per unit of scale */
+#define TS_LOOPS 20
+/** number of 1080p pictures scaled, per unit of scale */
+#define SWS_PICTURES 50
+
+/** results of a run of a scenario */
+struct bench_result {
+    /** number of urefs processed */
+    uint64_t urefs;
+    /** number of octets processed */
+    uint64_t octets;
+    /** self time of the measured pipes, for partial scenarios */
+    uint64_t self_time;
+    /** wall clock time, in nanoseconds */
+    uint64_t wall;
+    /** CPU time of the process, in nanoseconds */
+    uint64_t cpu;
+    /** number of allocations */
+    uint64_t allocs;
+};
+
+/** description of a scenario */
+struct bench_scenario {
+    /** name of the scenario */
+    const char *name;
+    /** true if only the self time of the instrumented pipes is relevant */
+    bool partial;
+    /** runs the scenario once */
+    void (*run)(struct bench_result *);
+};
+
+/** number of allocations since the start of the program */
+static uint64_t nb_allocs = 0;
+/** results of the current run */
+static struct bench_result *current = NULL;
+/** multiplier of the amount of work */
+static unsigned int scale = 1;
+/** path of the bundled TS file */
+static const char *ts_file = NULL;
+
+static struct umem_mgr *umem_mgr;
+static struct udict_mgr *udict_mgr;
+static struct uref_mgr *uref_mgr;
+static struct ubuf_mgr *ubuf_mgr;
+static struct uprobe *logger;
+/** probe counting the urefs entering the pipes below it */
+static struct uprobe *uprobe_count;
+static struct upipe_mgr *upipe_null_mgr;
+
+#ifdef __GLIBC__
+/* count allocations by wrapping the allocator of the libc */
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void *__libc_memalign(size_t alignment, size_t size);
+
+void *malloc(size_t size)
+{
+    __atomic_fetch_add(&nb_allocs, 1, __ATOMIC_RELAXED);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+    __atomic_fetch_add(&nb_allocs, 1, __ATOMIC_RELAXED);
+    return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    __atomic_fetch_add(&nb_allocs, 1, __ATOMIC_RELAXED);
+    return __libc_realloc(ptr, size);
+}
+
+int posix_memalign(void **memptr, size_t alignment, size_t size)
+{
+    __atomic_fetch_add(&nb_allocs, 1, __ATOMIC_RELAXED);
+    *memptr = __libc_memalign(alignment, size);
+    return *memptr == NULL ? ENOMEM : 0;
+}
+#endif
+
+/** returns the date of the given clock, in nanoseconds */
+static uint64_t now(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * UINT64_C(1000000000) + ts.tv_nsec;
+}
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    assert(event != UPROBE_FATAL);
+    return UBASE_ERR_NONE;
+}
+
+/** accumulates the counters of the instrumented pipes */
+static int catch_count(struct uprobe *uprobe, struct upipe *upipe,
+                       int event, va_list args)
+{
+    if (event != UPROBE_STATS)
+        return uprobe_throw_next(uprobe, upipe, event, args);
+
+    const struct upipe_stats *stats = va_arg(args, const struct upipe_stats *);
+    __atomic_fetch_add(&current->urefs, upipe_stats_get(&stats->urefs_in),
+                       __ATOMIC_RELAXED);
+    __atomic_fetch_add(&current->octets, upipe_stats_get(&stats->bytes_in),
+                       __ATOMIC_RELAXED);
+    __atomic_fetch_add(&current->self_time,
+                       upipe_stats_get(&stats->self_time), __ATOMIC_RELAXED);
+    return UBASE_ERR_NONE;
+}
+
+/** releases source pipes at the end of their input */
+static int catch_src(struct uprobe *uprobe, struct upipe *upipe,
+                     int event, va_list args)
+{
+    if (event == UPROBE_SOURCE_END) {
+        upipe_release(upipe);
+        return UBASE_ERR_NONE;
+    }
+    return uprobe_throw_next(uprobe, upipe, event, args);
+}
+
+static struct uprobe uprobe_src_s;
+
+/** allocates and frees urefs carrying a few attributes */
+static void bench_uref_churn(struct bench_result *result)
+{
+    uint64_t nb = (uint64_t)CHURN_UREFS * scale;
+    for (uint64_t i = 0; i < nb; i++) {
+        struct uref *uref = uref_alloc(uref_mgr);
+        assert(uref != NULL);
+        uref_clock_set_pts_prog(uref, i);
+        uref_clock_set_dts_prog(uref, i);
+        ubase_assert(uref_flow_set_id(uref, i));
+        ubase_assert(uref_flow_set_random(uref));
+        struct uref *dup = uref_dup(uref);
+        assert(dup != NULL);
+        uref_free(uref);
+        uref_free(dup);
+    }
+    result->urefs = nb;
+}
+
+/** allocates, duplicates and frees block urefs */
+static void bench_block_churn(struct bench_result *result)
+{
+    uint64_t nb = (uint64_t)CHURN_UREFS * scale;
+    for (uint64_t i = 0; i < nb; i++) {
+        struct uref *uref = uref_block_alloc(uref_mgr, ubuf_mgr, BLOCK_SIZE);
+        assert(uref != NULL);
+        struct uref *dup = uref_dup(uref);
+        assert(dup != NULL);
+        uref_free(uref);
+        uref_free(dup);
+    }
+    result->urefs = nb;
+    result->octets = nb * BLOCK_SIZE;
+}
+
+/** sends block urefs to a null sink */
+static void bench_null_sink(struct bench_result *result)
+{
+    struct upipe *upipe_null = upipe_void_alloc(upipe_null_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "null"));
+    assert(upipe_null != NULL);
+
+    uint64_t nb = (uint64_t)CHURN_UREFS * scale;
+    for (uint64_t i = 0; i < nb; i++) {
+        struct uref *uref = uref_block_alloc(uref_mgr, ubuf_mgr, BLOCK_SIZE);
+        assert(uref != NULL);
+        upipe_input(upipe_null, uref, NULL);
+    }
+    upipe_release(upipe_null);
+    result->urefs = nb;
+    result->octets = nb * BLOCK_SIZE;
+}
+
+#ifdef HAVE_EV
+static struct upipe_mgr *upipe_fsrc_mgr;
+/** path of the generated file */
+static char gen_file[] = "/tmp/upipe_bench.XXXXXX";
+
+/** generates a file of TS packets with a deterministic content */
+static void gen_file_init(void)
+{
+    int fd = mkstemp(gen_file);
+    assert(fd != -1);
+    uint8_t packet[188];
+    uint32_t seed = 1;
+    for (size_t size = 0; size < (size_t)FILE_SIZE * scale;
+         size += sizeof(packet)) {
+        for (unsigned int i = 0; i < sizeof(packet); i++) {
+            seed = seed * 1103515245 + 12345;
+            packet[i] = seed >> 16;
+        }
+        packet[0] = 0x47;
+        assert(write(fd, packet, sizeof(packet)) == sizeof(packet));
+    }
+    close(fd);
+}
+
+/** reads the generated file into a null sink */
+static void bench_fsrc_null(struct bench_result *result)
+{
+    struct ev_loop *loop = ev_loop_new(0);
+    assert(loop != NULL);
+    struct upump_mgr *upump_mgr =
+        upump_ev_mgr_alloc(loop, UPUMP_POOL, UPUMP_BLOCKER_POOL);
+    assert(upump_mgr != NULL);
+    struct uprobe *uprobe = uprobe_upump_mgr_alloc(uprobe_use(logger),
+                                                   upump_mgr);
+    assert(uprobe != NULL);
+    uprobe_init(&uprobe_src_s, catch_src, uprobe_use(uprobe));
+
+    struct upipe *upipe_fsrc = upipe_void_alloc(upipe_fsrc_mgr,
+            uprobe_pfx_alloc(uprobe_use(&uprobe_src_s), UPROBE_LOG_LEVEL,
+                             "file source"));
+    assert(upipe_fsrc != NULL);
+    ubase_assert(upipe_set_output_size(upipe_fsrc, BLOCK_SIZE));
+    ubase_assert(upipe_set_uri(upipe_fsrc, gen_file));
+    struct upipe *upipe_null = upipe_void_alloc_output(upipe_fsrc,
+            upipe_null_mgr,
+            uprobe_pfx_alloc(uprobe_stats_alloc(uprobe_use(uprobe_count)),
+                             UPROBE_LOG_LEVEL, "null"));
+    assert(upipe_null != NULL);
+    upipe_release(upipe_null);
+
+    ev_run(loop, 0);
+
+    uprobe_clean(&uprobe_src_s);
+    uprobe_release(uprobe);
+    upump_mgr_release(upump_mgr);
+    ev_loop_destroy(loop);
+}
+
+static struct upipe_mgr *upipe_qsrc_mgr;
+static struct upipe_mgr *upipe_qsink_mgr;
+/** queue source shared between threads */
+static struct upipe *upipe_qsrc;
+/** signals that the queue source is ready */
+static sem_t qsrc_ready;
+/** queue sink */
+static struct upipe *upipe_qsink;
+/** number of urefs sent to the queue sink */
+static uint64_t qsink_urefs;
+
+/** runs the queue source and a null sink in a separate thread */
+static void *qsrc_thread(void *unused)
+{
+    struct ev_loop *loop = ev_loop_new(0);
+    assert(loop != NULL);
+    struct upump_mgr *upump_mgr =
+        upump_ev_mgr_alloc(loop, UPUMP_POOL, UPUMP_BLOCKER_POOL);
+    assert(upump_mgr != NULL);
+    struct uprobe *uprobe = uprobe_upump_mgr_alloc(uprobe_use(logger),
+                                                   upump_mgr);
+    assert(uprobe != NULL);
+    struct uprobe uprobe_qsrc_s;
+    uprobe_init(&uprobe_qsrc_s, catch_src, uprobe_use(uprobe));
+
+    upipe_qsrc = upipe_qsrc_alloc(upipe_qsrc_mgr,
+            uprobe_pfx_alloc(uprobe_use(&uprobe_qsrc_s), UPROBE_LOG_LEVEL,
+                             "queue source"), QUEUE_LENGTH);
+    assert(upipe_qsrc != NULL);
+    ubase_assert(upipe_attach_upump_mgr(upipe_qsrc));
+    struct upipe *upipe_null = upipe_void_alloc_output(upipe_qsrc,
+            upipe_null_mgr,
+            uprobe_pfx_alloc(uprobe_stats_alloc(uprobe_use(uprobe_count)),
+                             UPROBE_LOG_LEVEL, "null"));
+    assert(upipe_null != NULL);
+    upipe_release(upipe_null);
+    sem_post(&qsrc_ready);
+
+    ev_run(loop, 0);
+
+    uprobe_clean(&uprobe_qsrc_s);
+    uprobe_release(uprobe);
+    upump_mgr_release(upump_mgr);
+    ev_loop_destroy(loop);
+    return NULL;
+}
+
+/** sends one block uref to the queue sink per iteration of the loop */
+static void qsink_idler(struct upump *upump)
+{
+    /* the last uref may still be held by the sink until we are unblocked */
+    if (qsink_urefs >= (uint64_t)QUEUE_UREFS * scale) {
+        upump_stop(upump);
+        upipe_release(upipe_qsink);
+        return;
+    }
+    struct uref *uref = uref_block_alloc(uref_mgr, ubuf_mgr, BLOCK_SIZE);
+    assert(uref != NULL);
+    qsink_urefs++;
+    upipe_input(upipe_qsink, uref, &upump);
+}
+
+/** sends block urefs to a null sink in another thread */
+static void bench_qsink_qsrc(struct bench_result *result)
+{
+    struct ev_loop *loop = ev_loop_new(0);
+    assert(loop != NULL);
+    struct upump_mgr *upump_mgr =
+        upump_ev_mgr_alloc(loop, UPUMP_POOL, UPUMP_BLOCKER_POOL);
+    assert(upump_mgr != NULL);
+    struct uprobe *uprobe = uprobe_upump_mgr_alloc(uprobe_use(logger),
+                                                   upump_mgr);
+    assert(uprobe != NULL);
+
+    pthread_t thread;
+    assert(sem_init(&qsrc_ready, 0, 0) == 0);
+    assert(pthread_create(&thread, NULL, qsrc_thread, NULL) == 0);
+    while (sem_wait(&qsrc_ready) == -1);
+
+    upipe_qsink = upipe_qsink_alloc(upipe_qsink_mgr,
+            uprobe_pfx_alloc(uprobe_use(uprobe), UPROBE_LOG_LEVEL,
+                             "queue sink"), upipe_qsrc);
+    assert(upipe_qsink != NULL);
+    struct uref *flow_def = uref_block_flow_alloc_def(uref_mgr, NULL);
+    assert(flow_def != NULL);
+    ubase_assert(upipe_set_flow_def(upipe_qsink, flow_def));
+    uref_free(flow_def);
+
+    qsink_urefs = 0;
+    struct upump *upump = upump_alloc_idler(upump_mgr, qsink_idler, NULL,
+                                            NULL);
+    assert(upump != NULL);
+    upump_start(upump);
+
+    ev_run(loop, 0);
+
+    assert(pthread_join(thread, NULL) == 0);
+    sem_destroy(&qsrc_ready);
+    assert(result->urefs == qsink_urefs);
+
+    upump_free(upump);
+    uprobe_release(uprobe);
+    upump_mgr_release(upump_mgr);
+    ev_loop_destroy(loop);
+}
+
+#ifdef HAVE_BITSTREAM
+/** TS pipeline run once per loop */
+struct ts_pipeline {
+    /** probe hierarchy of the pipeline */
+    struct uprobe *uprobe;
+    /** probe of the demux */
+    struct uprobe uprobe_demux_s;
+    /** probe of the demux programs */
+    struct uprobe uprobe_demux_program_s;
+    /** true if the programs are muxed again */
+    bool mux;
+    /** true if the framers are allocated by the pipeline */
+    bool framers;
+};
+
+static struct upipe_mgr *upipe_ts_demux_mgr;
+static struct upipe_mgr *upipe_ts_demux_noframer_mgr;
+static struct upipe_mgr *upipe_ts_mux_mgr;
+static struct upipe_mgr *upipe_noclock_mgr;
+static struct upipe_mgr *upipe_mpgvf_mgr;
+static struct upipe_mgr *upipe_h264f_mgr;
+static struct upipe_mgr *upipe_h265f_mgr;
+static struct upipe_mgr *upipe_mpgaf_mgr;
+static struct upipe_mgr *upipe_a52f_mgr;
+
+/** returns the framer manager for the given flow definition, or NULL */
+static struct upipe_mgr *framer_mgr(const char *def)
+{
+    if (!ubase_ncmp(def, "block.mpeg2video.") ||
+        !ubase_ncmp(def, "block.mpeg1video."))
+        return upipe_mpgvf_mgr;
+    if (!ubase_ncmp(def, "block.h264."))
+        return upipe_h264f_mgr;
+    if (!ubase_ncmp(def, "block.hevc."))
+        return upipe_h265f_mgr;
+    if (!ubase_ncmp(def, "block.mp2.") || !ubase_ncmp(def, "block.aac."))
+        return upipe_mpgaf_mgr;
+    if (!ubase_ncmp(def, "block.ac3.") || !ubase_ncmp(def, "block.eac3."))
+        return upipe_a52f_mgr;
+    return NULL;
+}
+
+/** returns true if a sub pipe already exists for the given flow */
+static bool ts_has_sub(struct upipe *upipe, uint64_t flow_id)
+{
+    struct upipe *sub = NULL;
+    while (ubase_check(upipe_iterate_sub(upipe, &sub)) && sub != NULL) {
+        struct uref *flow_def;
+        uint64_t id;
+        if (ubase_check(upipe_get_flow_def(sub, &flow_def)) &&
+            ubase_check(uref_flow_get_id(flow_def, &id)) && id == flow_id)
+            return true;
+    }
+    return false;
+}
+
+/** allocates the outputs of the demux programs */
+static int catch_ts_demux_program(struct uprobe *uprobe, struct upipe *upipe,
+                                  int event, va_list args)
+{
+    struct ts_pipeline *pipeline =
+        container_of(uprobe, struct ts_pipeline, uprobe_demux_program_s);
+    if (event != UPROBE_SPLIT_UPDATE)
+        return uprobe_throw_next(uprobe, upipe, event, args);
+
+    struct uref *flow_def = NULL;
+    while (ubase_check(upipe_split_iterate(upipe, &flow_def)) &&
+           flow_def != NULL) {
+        uint64_t flow_id;
+        const char *def;
+        ubase_assert(uref_flow_get_id(flow_def, &flow_id));
+        ubase_assert(uref_flow_get_def(flow_def, &def));
+        if (ts_has_sub(upipe, flow_id))
+            continue;
+
+        struct upipe *output = upipe_flow_alloc_sub(upipe,
+            uprobe_pfx_alloc_va(uprobe_use(&uprobe_src_s), UPROBE_LOG_LEVEL,
+                                "ts demux output %"PRIu64, flow_id),
+            flow_def);
+        assert(output != NULL);
+
+        struct upipe_mgr *mgr = framer_mgr(def);
+        if (pipeline->framers && mgr != NULL) {
+            output = upipe_void_chain_output(output, mgr,
+                uprobe_pfx_alloc_va(
+                    uprobe_stats_alloc(uprobe_use(uprobe_count)),
+                    UPROBE_LOG_LEVEL, "framer %"PRIu64, flow_id));
+            assert(output != NULL);
+        }
+
+        if (pipeline->mux) {
+            output = upipe_void_chain_output(output, upipe_noclock_mgr,
+                uprobe_pfx_alloc_va(uprobe_use(pipeline->uprobe),
+                                    UPROBE_LOG_LEVEL,
+                                    "noclock %"PRIu64, flow_id));
+            assert(output != NULL);
+            struct upipe *upipe_ts_mux_program;
+            ubase_assert(upipe_get_output(upipe, &upipe_ts_mux_program));
+            output = upipe_void_chain_output_sub(output, upipe_ts_mux_program,
+                uprobe_pfx_alloc_va(uprobe_use(pipeline->uprobe),
+                                    UPROBE_LOG_LEVEL,
+                                    "mux input %"PRIu64, flow_id));
+        } else
+            output = upipe_void_chain_output(output, upipe_null_mgr,
+                uprobe_pfx_alloc_va(uprobe_use(pipeline->uprobe),
+                                    UPROBE_LOG_LEVEL, "null %"PRIu64,
+                                    flow_id));
+        assert(output != NULL);
+        upipe_release(output);
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** allocates the demux programs */
+static int catch_ts_demux(struct uprobe *uprobe, struct upipe *upipe,
+                          int event, va_list args)
+{
+    struct ts_pipeline *pipeline =
+        container_of(uprobe, struct ts_pipeline, uprobe_demux_s);
+    if (event != UPROBE_SPLIT_UPDATE)
+        return uprobe_throw_next(uprobe, upipe, event, args);
+
+    struct uref *flow_def = NULL;
+    while (ubase_check(upipe_split_iterate(upipe, &flow_def)) &&
+           flow_def != NULL) {
+        uint64_t flow_id;
+        ubase_assert(uref_flow_get_id(flow_def, &flow_id));
+        if (ts_has_sub(upipe, flow_id))
+            continue;
+
+        struct upipe *sub = upipe_flow_alloc_sub(upipe,
+            uprobe_pfx_alloc_va(uprobe_use(&pipeline->uprobe_demux_program_s),
+                                UPROBE_LOG_LEVEL,
+                                "ts demux program %"PRIu64, flow_id),
+            flow_def);
+        assert(sub != NULL);
+
+        if (pipeline->mux) {
+            struct upipe *upipe_ts_mux;
+            ubase_assert(upipe_get_output(upipe, &upipe_ts_mux));
+            sub = upipe_void_alloc_output_sub(sub, upipe_ts_mux,
+                uprobe_pfx_alloc_va(uprobe_use(pipeline->uprobe),
+                                    UPROBE_LOG_LEVEL,
+                                    "ts mux program %"PRIu64, flow_id));
+            assert(sub != NULL);
+            ubase_assert(upipe_ts_mux_set_version(sub, 1));
+        }
+        upipe_release(sub);
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** runs the TS file through a demux, and optionally framers and a mux */
+static void bench_ts(bool framers, bool mux)
+{
+    for (unsigned int i = 0; i < TS_LOOPS * scale; i++) {
+        struct ev_loop *loop = ev_loop_new(0);
+        assert(loop != NULL);
+        struct upump_mgr *upump_mgr =
+            upump_ev_mgr_alloc(loop, UPUMP_POOL, UPUMP_BLOCKER_POOL);
+        assert(upump_mgr != NULL);
+
+        struct ts_pipeline pipeline;
+        pipeline.mux = mux;
+        pipeline.framers = framers;
+        pipeline.uprobe = uprobe_upump_mgr_alloc(uprobe_use(logger),
+                                                 upump_mgr);
+        assert(pipeline.uprobe != NULL);
+        uprobe_init(&uprobe_src_s, catch_src, uprobe_use(pipeline.uprobe));
+        uprobe_init(&pipeline.uprobe_demux_s, catch_ts_demux,
+                    uprobe_use(pipeline.uprobe));
+        uprobe_init(&pipeline.uprobe_demux_program_s, catch_ts_demux_program,
+                    uprobe_use(&uprobe_src_s));
+
+        struct upipe *upipe_fsrc = upipe_void_alloc(upipe_fsrc_mgr,
+                uprobe_pfx_alloc(uprobe_use(&uprobe_src_s),
+                                 UPROBE_LOG_LEVEL, "file source"));
+        assert(upipe_fsrc != NULL);
+        ubase_assert(upipe_set_output_size(upipe_fsrc, BLOCK_SIZE));
+        ubase_assert(upipe_set_uri(upipe_fsrc, ts_file));
+
+        /* when framers are measured alone, the demux must not frame */
+        struct uprobe *uprobe_demux = uprobe_use(&pipeline.uprobe_demux_s);
+        if (!framers)
+            uprobe_demux = uprobe_stats_alloc(uprobe_demux);
+        struct upipe *upipe = upipe_void_alloc_output(upipe_fsrc,
+                framers ? upipe_ts_demux_noframer_mgr : upipe_ts_demux_mgr,
+                uprobe_pfx_alloc(uprobe_demux, UPROBE_LOG_LEVEL, "ts demux"));
+        assert(upipe != NULL);
+        ubase_assert(upipe_ts_demux_set_conformance(upipe,
+                                                    UPIPE_TS_CONFORMANCE_ISO));
+
+        if (mux) {
+            upipe = upipe_void_chain_output(upipe, upipe_ts_mux_mgr,
+                    uprobe_pfx_alloc(uprobe_use(pipeline.uprobe),
+                                     UPROBE_LOG_LEVEL, "ts mux"));
+            assert(upipe != NULL);
+            ubase_assert(upipe_ts_mux_set_mode(upipe,
+                                               UPIPE_TS_MUX_MODE_CAPPED));
+            ubase_assert(upipe_ts_mux_set_version(upipe, 1));
+            ubase_assert(upipe_ts_mux_set_cr_prog(upipe, 0));
+            upipe = upipe_void_chain_output(upipe, upipe_null_mgr,
+                    uprobe_pfx_alloc(uprobe_use(pipeline.uprobe),
+                                     UPROBE_LOG_LEVEL, "null"));
+            assert(upipe != NULL);
+        }
+        upipe_release(upipe);
+
+        ev_run(loop, 0);
+
+        uprobe_clean(&pipeline.uprobe_demux_program_s);
+        uprobe_clean(&pipeline.uprobe_demux_s);
+        uprobe_clean(&uprobe_src_s);
+        uprobe_release(pipeline.uprobe);
+        upump_mgr_release(upump_mgr);
+        ev_loop_destroy(loop);
+    }
+}
+
+/** demuxes and frames the TS file */
+static void bench_ts_demux(struct bench_result *result)
+{
+    bench_ts(false, false);
+}
+
+/** frames the elementary streams of the TS file */
+static void bench_framers(struct bench_result *result)
+{
+    bench_ts(true, false);
+}
+
+/** demuxes, frames and muxes again the TS file */
+static void bench_ts_roundtrip(struct bench_result *result)
+{
+    bench_ts(false, true);
+}
+#endif
+#endif
+
+#ifdef HAVE_SWSCALE
+static struct upipe_mgr *upipe_sws_mgr;
+/** allocator of the input pictures */
+static struct ubuf_mgr *pic_mgr;
+
+/** scales progressive 1080p pictures to the given size */
+static void bench_sws(struct bench_result *result, uint64_t vsize,
+                      unsigned int threads)
+{
+    struct uref *flow_def = uref_pic_flow_alloc_def(uref_mgr, 1);
+    assert(flow_def != NULL);
+    ubase_assert(uref_pic_flow_add_plane(flow_def, 1, 1, 1, "y8"));
+    ubase_assert(uref_pic_flow_add_plane(flow_def, 2, 2, 1, "u8"));
+    ubase_assert(uref_pic_flow_add_plane(flow_def, 2, 2, 1, "v8"));
+    ubase_assert(uref_pic_flow_set_hsize(flow_def, 1920));
+    ubase_assert(uref_pic_flow_set_vsize(flow_def, 1080));
+    struct uref *output_flow = uref_dup(flow_def);
+    assert(output_flow != NULL);
+    ubase_assert(uref_pic_flow_set_hsize(output_flow, vsize * 16 / 9));
+    ubase_assert(uref_pic_flow_set_vsize(output_flow, vsize));
+
+    struct upipe *upipe_sws = upipe_flow_alloc(upipe_sws_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "sws"),
+            output_flow);
+    assert(upipe_sws != NULL);
+    uref_free(output_flow);
+    ubase_assert(upipe_sws_set_threads(upipe_sws, threads));
+    ubase_assert(upipe_set_flow_def(upipe_sws, flow_def));
+    uref_free(flow_def);
+    struct upipe *upipe_null = upipe_void_alloc_output(upipe_sws,
+            upipe_null_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "null"));
+    assert(upipe_null != NULL);
+    upipe_release(upipe_null);
+
+    struct uref *pic = uref_pic_alloc(uref_mgr, pic_mgr, 1920, 1080);
+    assert(pic != NULL);
+    ubase_assert(uref_pic_set_progressive(pic));
+    const char *chromas[] = { "y8", "u8", "v8" };
+    for (int i = 0; i < UBASE_ARRAY_SIZE(chromas); i++) {
+        uint8_t *buffer;
+        size_t stride, vsize;
+        ubase_assert(uref_pic_plane_write(pic, chromas[i], 0, 0, -1, -1,
+                                          &buffer));
+        ubase_assert(uref_pic_plane_size(pic, chromas[i], &stride,
+                                         NULL, NULL, NULL));
+        uref_pic_size(pic, NULL, &vsize, NULL);
+        for (size_t j = 0; j < stride * (i ? vsize / 2 : vsize); j++)
+            buffer[j] = j * 7 + j / stride;
+        ubase_assert(uref_pic_plane_unmap(pic, chromas[i], 0, 0, -1, -1));
+    }
+
+    uint64_t nb = (uint64_t)SWS_PICTURES * scale;
+    for (uint64_t i = 0; i < nb; i++) {
+        struct uref *uref = uref_dup(pic);
+        assert(uref != NULL);
+        upipe_input(upipe_sws, uref, NULL);
+    }
+    uref_free(pic);
+    upipe_release(upipe_sws);
+    result->urefs = nb;
+    result->octets = nb * 1920 * 1080 * 3 / 2;
+}
+
+#define BENCH_SWS(vsize, threads)                                           \
+/** scales 1080p pictures with the given number of threads */              \
+static void bench_sws_##vsize##p_t##threads(struct bench_result *result)  \
+{                                                                           \
+    bench_sws(result, vsize, threads);                                      \
+}
+
+BENCH_SWS(720, 1)
+BENCH_SWS(720, 2)
+BENCH_SWS(720, 4)
+BENCH_SWS(720, 8)
+BENCH_SWS(540, 1)
+BENCH_SWS(540, 2)
+BENCH_SWS(540, 4)
+BENCH_SWS(540, 8)
+BENCH_SWS(360, 1)
+BENCH_SWS(360, 2)
+BENCH_SWS(360, 4)
+BENCH_SWS(360, 8)
+#undef BENCH_SWS
+#endif
+
+/** list of scenarios */
+static const struct bench_scenario scenarios[] = {
+    { "uref_churn", false, bench_uref_churn },
+    { "block_churn", false, bench_block_churn },
+    { "null_sink", false, bench_null_sink },
+#ifdef HAVE_EV
+    { "fsrc_null", false, bench_fsrc_null },
+    { "qsink_qsrc", false, bench_qsink_qsrc },
+#ifdef HAVE_BITSTREAM
+    { "ts_demux", false, bench_ts_demux },
+    { "framers", true, bench_framers },
+    { "ts_roundtrip", false, bench_ts_roundtrip },
+#endif
+#endif
+#ifdef HAVE_SWSCALE
+    { "sws_720p_t1", false, bench_sws_720p_t1 },
+    { "sws_720p_t2", false, bench_sws_720p_t2 },
+    { "sws_720p_t4", false, bench_sws_720p_t4 },
+    { "sws_720p_t8", false, bench_sws_720p_t8 },
+    { "sws_540p_t1", false, bench_sws_540p_t1 },
+    { "sws_540p_t2", false, bench_sws_540p_t2 },
+    { "sws_540p_t4", false, bench_sws_540p_t4 },
+    { "sws_540p_t8", false, bench_sws_540p_t8 },
+    { "sws_360p_t1", false, bench_sws_360p_t1 },
+    { "sws_360p_t2", false, bench_sws_360p_t2 },
+    { "sws_360p_t4", false, bench_sws_360p_t4 },
+    { "sws_360p_t8", false, bench_sws_360p_t8 },
+#endif
+};
+
+/** sorts durations */
+static int compare_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+/** runs a scenario and prints its results */
+static void bench(const struct bench_scenario *scenario,
+                  unsigned int repeats)
+{
+    uint64_t walls[repeats], cpus[repeats];
+    struct bench_result result;
+
+    /* the first run only warms up the pools and caches */
+    for (int i = -1; i < (int)repeats; i++) {
+        memset(&result, 0, sizeof(result));
+        current = &result;
+        uint64_t allocs = __atomic_load_n(&nb_allocs, __ATOMIC_RELAXED);
+        uint64_t wall = now(CLOCK_MONOTONIC);
+        uint64_t cpu = now(CLOCK_PROCESS_CPUTIME_ID);
+        scenario->run(&result);
+        result.cpu = now(CLOCK_PROCESS_CPUTIME_ID) - cpu;
+        result.wall = now(CLOCK_MONOTONIC) - wall;
+        result.allocs = __atomic_load_n(&nb_allocs, __ATOMIC_RELAXED) - allocs;
+        current = NULL;
+        if (scenario->partial)
+            result.cpu = result.wall = result.self_time;
+        if (i >= 0) {
+            walls[i] = result.wall;
+            cpus[i] = result.cpu;
+        }
+    }
+    assert(result.urefs);
+
+    qsort(walls, repeats, sizeof(uint64_t), compare_u64);
+    qsort(cpus, repeats, sizeof(uint64_t), compare_u64);
+    uint64_t wall = walls[repeats / 2];
+    uint64_t cpu = cpus[repeats / 2];
+    printf("bench=%s urefs=%"PRIu64" octets=%"PRIu64" wall_ns=%"PRIu64
+           " cpu_ns=%"PRIu64" urefs_per_s=%.0f mbps=%.1f"
+           " cpu_ns_per_uref=%.1f allocs_per_uref=%.3f\n",
+           scenario->name, result.urefs, result.octets, wall, cpu,
+           wall ? result.urefs * 1e9 / wall : 0.,
+           wall ? result.octets * 8e3 / wall : 0.,
+           (double)cpu / result.urefs,
+           (double)result.allocs / result.urefs);
+    fflush(stdout);
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stdout, "Usage: %s [-l] [-r <repeats>] [-s <scale>] [-t <ts file>] [<scenario> ...]\n", argv0);
+    fprintf(stdout, "   -l: list the scenarios\n");
+    fprintf(stdout, "   -t: bundled TS file, required by the TS scenarios\n");
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int repeats = DEFAULT_REPEATS;
+    int opt;
+    while ((opt = getopt(argc, argv, "lr:s:t:")) != -1) {
+        switch (opt) {
+            case 'l':
+                for (int i = 0; i < UBASE_ARRAY_SIZE(scenarios); i++)
+                    printf("%s\n", scenarios[i].name);
+                exit(EXIT_SUCCESS);
+            case 'r':
+                repeats = strtoul(optarg, NULL, 10);
+                break;
+            case 's':
+                scale = strtoul(optarg, NULL, 10);
+                break;
+            case 't':
+                ts_file = optarg;
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+    if (!repeats || !scale)
+        usage(argv[0]);
+
+    umem_mgr = umem_pool_mgr_alloc_simple(UMEM_POOL);
+    assert(umem_mgr != NULL);
+    udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH, umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr, 0);
+    assert(uref_mgr != NULL);
+    ubuf_mgr = ubuf_block_mem_mgr_alloc(UBUF_POOL_DEPTH,
+                                        UBUF_SHARED_POOL_DEPTH,
+                                        umem_mgr, -1, 0);
+    assert(ubuf_mgr != NULL);
+
+    struct uprobe uprobe_s;
+    uprobe_init(&uprobe_s, catch, NULL);
+    logger = uprobe_stdio_alloc(&uprobe_s, stderr, UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+    logger = uprobe_uref_mgr_alloc(logger, uref_mgr);
+    assert(logger != NULL);
+    logger = uprobe_ubuf_mem_alloc(logger, umem_mgr, UBUF_POOL_DEPTH,
+                                   UBUF_SHARED_POOL_DEPTH);
+    assert(logger != NULL);
+    struct uprobe uprobe_count_s;
+    uprobe_init(&uprobe_count_s, catch_count, uprobe_use(logger));
+    uprobe_count = &uprobe_count_s;
+
+    upipe_null_mgr = upipe_null_mgr_alloc();
+    assert(upipe_null_mgr != NULL);
+#ifdef HAVE_EV
+    upipe_fsrc_mgr = upipe_fsrc_mgr_alloc();
+    assert(upipe_fsrc_mgr != NULL);
+    upipe_qsrc_mgr = upipe_qsrc_mgr_alloc();
+    assert(upipe_qsrc_mgr != NULL);
+    upipe_qsink_mgr = upipe_qsink_mgr_alloc();
+    assert(upipe_qsink_mgr != NULL);
+    gen_file_init();
+#ifdef HAVE_BITSTREAM
+    upipe_noclock_mgr = upipe_noclock_mgr_alloc();
+    assert(upipe_noclock_mgr != NULL);
+    upipe_ts_mux_mgr = upipe_ts_mux_mgr_alloc();
+    assert(upipe_ts_mux_mgr != NULL);
+    upipe_mpgvf_mgr = upipe_mpgvf_mgr_alloc();
+    assert(upipe_mpgvf_mgr != NULL);
+    upipe_h264f_mgr = upipe_h264f_mgr_alloc();
+    assert(upipe_h264f_mgr != NULL);
+    upipe_h265f_mgr = upipe_h265f_mgr_alloc();
+    assert(upipe_h265f_mgr != NULL);
+    upipe_mpgaf_mgr = upipe_mpgaf_mgr_alloc();
+    assert(upipe_mpgaf_mgr != NULL);
+    upipe_a52f_mgr = upipe_a52f_mgr_alloc();
+    assert(upipe_a52f_mgr != NULL);
+    upipe_ts_demux_noframer_mgr = upipe_ts_demux_mgr_alloc();
+    assert(upipe_ts_demux_noframer_mgr != NULL);
+    upipe_ts_demux_mgr = upipe_ts_demux_mgr_alloc();
+    assert(upipe_ts_demux_mgr != NULL);
+    ubase_assert(upipe_ts_demux_mgr_set_mpgvf_mgr(upipe_ts_demux_mgr,
+                                                  upipe_mpgvf_mgr));
+    ubase_assert(upipe_ts_demux_mgr_set_h264f_mgr(upipe_ts_demux_mgr,
+                                                  upipe_h264f_mgr));
+    ubase_assert(upipe_ts_demux_mgr_set_h265f_mgr(upipe_ts_demux_mgr,
+                                                  upipe_h265f_mgr));
+    ubase_assert(upipe_ts_demux_mgr_set_mpgaf_mgr(upipe_ts_demux_mgr,
+                                                  upipe_mpgaf_mgr));
+    ubase_assert(upipe_ts_demux_mgr_set_a52f_mgr(upipe_ts_demux_mgr,
+                                                 upipe_a52f_mgr));
+#endif
+#endif
+#ifdef HAVE_SWSCALE
+    upipe_sws_mgr = upipe_sws_mgr_alloc();
+    assert(upipe_sws_mgr != NULL);
+    pic_mgr = ubuf_pic_mem_mgr_alloc(UBUF_POOL_DEPTH, UBUF_SHARED_POOL_DEPTH,
+                                     umem_mgr, 1, 0, 0, 0, 0, 16, 0);
+    assert(pic_mgr != NULL);
+    ubase_assert(ubuf_pic_mem_mgr_add_plane(pic_mgr, "y8", 1, 1, 1));
+    ubase_assert(ubuf_pic_mem_mgr_add_plane(pic_mgr, "u8", 2, 2, 1));
+    ubase_assert(ubuf_pic_mem_mgr_add_plane(pic_mgr, "v8", 2, 2, 1));
+#endif
+
+    for (int i = 0; i < UBASE_ARRAY_SIZE(scenarios); i++) {
+        const struct bench_scenario *scenario = &scenarios[i];
+        if (optind < argc) {
+            bool found = false;
+            for (int j = optind; j < argc; j++)
+                if (!strcmp(argv[j], scenario->name))
+                    found = true;
+            if (!found)
+                continue;
+        }
+        if (!strncmp(scenario->name, "ts_", 3) ||
+            !strcmp(scenario->name, "framers")) {
+            if (ts_file == NULL) {
+                fprintf(stderr, "skipping %s: no TS file\n", scenario->name);
+                continue;
+            }
+        }
+        bench(scenario, repeats);
+    }
+
+#ifdef HAVE_EV
+#ifdef HAVE_BITSTREAM
+    upipe_mgr_release(upipe_ts_demux_mgr);
+    upipe_mgr_release(upipe_ts_demux_noframer_mgr);
+    upipe_mgr_release(upipe_a52f_mgr);
+    upipe_mgr_release(upipe_mpgaf_mgr);
+    upipe_mgr_release(upipe_h265f_mgr);
+    upipe_mgr_release(upipe_h264f_mgr);
+    upipe_mgr_release(upipe_mpgvf_mgr);
+    upipe_mgr_release(upipe_ts_mux_mgr);
+    upipe_mgr_release(upipe_noclock_mgr);
+#endif
+    unlink(gen_file);
+    upipe_mgr_release(upipe_qsink_mgr);
+    upipe_mgr_release(upipe_qsrc_mgr);
+    upipe_mgr_release(upipe_fsrc_mgr);
+#endif
+#ifdef HAVE_SWSCALE
+    ubuf_mgr_release(pic_mgr);
+    upipe_mgr_release(upipe_sws_mgr);
+#endif
+    upipe_mgr_release(upipe_null_mgr);
+
+    uprobe_clean(&uprobe_count_s);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe_s);
+    ubuf_mgr_release(ubuf_mgr);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    return 0;
+}
@@ -72,9 +72,11 @@
 #define UPROBE_LOG_LEVEL UPROBE_LOG_DEBUG
 
 static void usage(const char *argv0) {
-    fprintf(stdout, "Usage: %s [-d <delay>] [-a|-o] <source file> <sink file>\n", argv0);
+    fprintf(stdout, "Usage: %s [-d <delay>] [-a|-o] [-m] [-r <offset>:<length>] <source file> <sink file>\n", argv0);
     fprintf(stdout, "-a : append\n");
     fprintf(stdout, "-o : overwrite\n");
+    fprintf(stdout, "-m : map the source file in memory\n");
+    fprintf(stdout, "-r : read only a range of the source file\n");
     exit(EXIT_FAILURE);
 }
 
@@ -100,8 +102,10 @@ int main(int argc, char *argv[])
     const char *src_file, *sink_file;
     uint64_t delay = 0;
     enum upipe_fsink_mode mode = UPIPE_FSINK_CREATE;
+    bool map = false;
+    uint64_t offset = 0, length = (uint64_t)-1;
     int opt;
-    while ((opt = getopt(argc, argv, "d:ao")) != -1) {
+    while ((opt = getopt(argc, argv, "d:aomr:")) != -1) {
         switch (opt) {
             case 'd':
                 delay = atoi(optarg);
@@ -112,6 +116,13 @@ int main(int argc, char *argv[])
             case 'o':
                 mode = UPIPE_FSINK_OVERWRITE;
                 break;
+            case 'm':
+                map = true;
+                break;
+            case 'r':
+                if (sscanf(optarg, "%"SCNu64":%"SCNu64, &offset, &length) != 2)
+                    usage(argv[0]);
+                break;
             default:
                 usage(argv[0]);
         }
@@ -159,7 +170,10 @@ int main(int argc, char *argv[])
                              UPROBE_LOG_LEVEL, "file source"));
     assert(upipe_fsrc != NULL);
     ubase_assert(upipe_set_output_size(upipe_fsrc, READ_SIZE));
+    ubase_assert(upipe_fsrc_set_mmap(upipe_fsrc, map));
     ubase_assert(upipe_set_uri(upipe_fsrc, src_file));
+    if (length != (uint64_t)-1)
+        ubase_assert(upipe_src_set_range(upipe_fsrc, offset, length));
     uint64_t size;
     if (ubase_check(upipe_src_get_size(upipe_fsrc, &size)))
         fprintf(stdout, "source file has size %"PRIu64"\n", size);
@@ -10,3 +10,12 @@ trap cleanup EXIT
 
 "$srcdir"/valgrind_wrapper.sh "$srcdir" ./upipe_file_test Makefile "$TMP"/test
 cmp --quiet "$TMP"/test Makefile
+
+"$srcdir"/valgrind_wrapper.sh "$srcdir" ./upipe_file_test -m Makefile "$TMP"/test_mmap
+cmp --quiet "$TMP"/test_mmap Makefile
+
+tail -c +1001 Makefile | head -c 10000 > "$TMP"/range
+"$srcdir"/valgrind_wrapper.sh "$srcdir" ./upipe_file_test -r 1000:10000 Makefile "$TMP"/test_range
+cmp --quiet "$TMP"/test_range "$TMP"/range
+"$srcdir"/valgrind_wrapper.sh "$srcdir" ./upipe_file_test -m -r 1000:10000 Makefile "$TMP"/test_range_mmap
+cmp --quiet "$TMP"/test_range_mmap "$TMP"/range
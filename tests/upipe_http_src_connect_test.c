@@ -0,0 +1,345 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for the connection setup of http source pipe
+ *
+ * A local server is started with a full accept queue, so that connections
+ * are only established after the server has waited for some time and the
+ * client has retransmitted its SYN. In the meantime, a timer running in the
+ * same event loop must keep ticking. A second pipe connecting to the same
+ * server must time out.
+ */
+
+#undef NDEBUG
+
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/uprobe_uref_mgr.h>
+#include <upipe/uprobe_upump_mgr.h>
+#include <upipe/uprobe_ubuf_mem.h>
+#include <upipe/uclock.h>
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/ubuf.h>
+#include <upipe/uref.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_std.h>
+#include <upipe/upump.h>
+#include <upump-ev/upump_ev.h>
+#include <upipe/upipe.h>
+#include <upipe/upipe_helper_upipe.h>
+#include <upipe-modules/upipe_http_source.h>
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include <ev.h>
+
+#define UDICT_POOL_DEPTH 0
+#define UREF_POOL_DEPTH 0
+#define UBUF_POOL_DEPTH 0
+#define UPUMP_POOL 0
+#define UPUMP_BLOCKER_POOL 0
+#define UPROBE_LOG_LEVEL UPROBE_LOG_DEBUG
+/** period of the timer */
+#define TICK (UCLOCK_FREQ / 100)
+/** delay before the server starts accepting connections, in us */
+#define SERVER_DELAY 300000
+/** connection timeout of the pipe which must time out */
+#define CONNECT_TIMEOUT (UCLOCK_FREQ / 10)
+#define BODY "hello"
+
+static int listen_fd;
+static struct upipe *upipe_timeout;
+static struct upipe *upipe_delayed;
+static struct upump *tick_pump;
+static unsigned int nb_ticks = 0;
+static unsigned int timeout_ticks = 0;
+static unsigned int first_data_ticks = 0;
+static size_t nb_bytes = 0;
+static bool timeout_ended = false;
+static bool delayed_ended = false;
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        default:
+            assert(0);
+            break;
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_NEW_FLOW_DEF:
+            break;
+        case UPROBE_SOURCE_END:
+            if (upipe == upipe_timeout) {
+                assert(!timeout_ended);
+                timeout_ended = true;
+                timeout_ticks = nb_ticks;
+            } else {
+                assert(upipe == upipe_delayed);
+                assert(!delayed_ended);
+                delayed_ended = true;
+                upump_stop(tick_pump);
+            }
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** helper phony pipe */
+struct test_pipe {
+    struct upipe upipe;
+};
+
+/** helper phony pipe */
+UPIPE_HELPER_UPIPE(test_pipe, upipe, 0);
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct test_pipe *test_pipe = malloc(sizeof(struct test_pipe));
+    assert(test_pipe != NULL);
+    upipe_init(&test_pipe->upipe, mgr, uprobe);
+    upipe_throw_ready(&test_pipe->upipe);
+    return &test_pipe->upipe;
+}
+
+/** helper phony pipe */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    size_t size;
+    ubase_assert(uref_block_size(uref, &size));
+    if (size && !nb_bytes)
+        first_data_ticks = nb_ticks;
+    nb_bytes += size;
+    uref_free(uref);
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF:
+            return UBASE_ERR_NONE;
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *urequest = va_arg(args, struct urequest *);
+            return upipe_throw_provide_request(upipe, urequest);
+        }
+        case UPIPE_UNREGISTER_REQUEST:
+            return UBASE_ERR_NONE;
+        default:
+            assert(0);
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    upipe_throw_dead(upipe);
+    struct test_pipe *test_pipe = test_pipe_from_upipe(upipe);
+    upipe_clean(upipe);
+    free(test_pipe);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr test_mgr = {
+    .refcount = NULL,
+    .signature = 0,
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
+/** timer running in the same event loop as the pipes */
+static void tick(struct upump *upump)
+{
+    nb_ticks++;
+}
+
+/** stand-in http server, accepting connections after a delay */
+static void *server(void *arg)
+{
+    int filler_fd = *(int *)arg;
+
+    usleep(SERVER_DELAY);
+
+    /* empty the accept queue */
+    int fd = accept(listen_fd, NULL, NULL);
+    assert(fd != -1);
+    close(fd);
+    close(filler_fd);
+
+    fd = accept(listen_fd, NULL, NULL);
+    assert(fd != -1);
+    char request[4096];
+    size_t len = 0;
+    while (len < sizeof(request) - 1) {
+        ssize_t ret = recv(fd, request + len, sizeof(request) - 1 - len, 0);
+        assert(ret > 0);
+        len += ret;
+        request[len] = '\0';
+        if (strstr(request, "\r\n\r\n") != NULL)
+            break;
+    }
+    assert(!strncmp(request, "GET / HTTP/1.1\r\n",
+                    strlen("GET / HTTP/1.1\r\n")));
+
+    const char *response = "HTTP/1.1 200 OK\r\n"
+                           "Content-Length: 5\r\n\r\n" BODY;
+    assert(send(fd, response, strlen(response), 0) ==
+           (ssize_t)strlen(response));
+    close(fd);
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    /* server with a full accept queue */
+    listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    assert(listen_fd != -1);
+    struct sockaddr_in sin;
+    memset(&sin, 0, sizeof(sin));
+    sin.sin_family = AF_INET;
+    sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    sin.sin_port = 0;
+    assert(bind(listen_fd, (struct sockaddr *)&sin, sizeof(sin)) == 0);
+    assert(listen(listen_fd, 0) == 0);
+    socklen_t sin_len = sizeof(sin);
+    assert(getsockname(listen_fd, (struct sockaddr *)&sin, &sin_len) == 0);
+
+    int filler_fd = socket(AF_INET, SOCK_STREAM, 0);
+    assert(filler_fd != -1);
+    assert(connect(filler_fd, (struct sockaddr *)&sin, sizeof(sin)) == 0);
+
+    char uri[64];
+    snprintf(uri, sizeof(uri), "http://127.0.0.1:%u/", ntohs(sin.sin_port));
+
+    struct ev_loop *loop = ev_default_loop(0);
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr,
+                                                   0);
+    assert(uref_mgr != NULL);
+    struct upump_mgr *upump_mgr = upump_ev_mgr_alloc(loop, UPUMP_POOL,
+                                                     UPUMP_BLOCKER_POOL);
+    assert(upump_mgr != NULL);
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+    logger = uprobe_uref_mgr_alloc(logger, uref_mgr);
+    assert(logger != NULL);
+    logger = uprobe_upump_mgr_alloc(logger, upump_mgr);
+    assert(logger != NULL);
+    logger = uprobe_ubuf_mem_alloc(logger, umem_mgr, UBUF_POOL_DEPTH,
+                                   UBUF_POOL_DEPTH);
+    assert(logger != NULL);
+
+    struct upipe *sink = upipe_void_alloc(&test_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "sink"));
+    assert(sink != NULL);
+
+    struct upipe_mgr *upipe_http_src_mgr = upipe_http_src_mgr_alloc();
+    assert(upipe_http_src_mgr != NULL);
+
+    upipe_timeout = upipe_void_alloc(upipe_http_src_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "http timeout"));
+    assert(upipe_timeout != NULL);
+    uint64_t timeout;
+    ubase_assert(upipe_http_src_get_connect_timeout(upipe_timeout, &timeout));
+    assert(timeout == 0);
+    ubase_assert(upipe_http_src_set_connect_timeout(upipe_timeout,
+                                                    CONNECT_TIMEOUT));
+    ubase_assert(upipe_http_src_get_connect_timeout(upipe_timeout, &timeout));
+    assert(timeout == CONNECT_TIMEOUT);
+    ubase_assert(upipe_set_output(upipe_timeout, sink));
+
+    upipe_delayed = upipe_void_alloc(upipe_http_src_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "http delayed"));
+    assert(upipe_delayed != NULL);
+    ubase_assert(upipe_set_output(upipe_delayed, sink));
+
+    tick_pump = upump_alloc_timer(upump_mgr, tick, NULL, NULL, TICK, TICK);
+    assert(tick_pump != NULL);
+    upump_start(tick_pump);
+
+    pthread_t server_thread;
+    assert(pthread_create(&server_thread, NULL, server, &filler_fd) == 0);
+
+    /* connections must not block the caller */
+    ubase_assert(upipe_set_uri(upipe_timeout, uri));
+    ubase_assert(upipe_set_uri(upipe_delayed, uri));
+
+    ev_loop(loop, 0);
+
+    assert(!pthread_join(server_thread, NULL));
+
+    assert(timeout_ended);
+    assert(delayed_ended);
+    /* the timeout expired before the server started accepting */
+    assert(timeout_ticks < SERVER_DELAY * 100 / 1000000);
+    /* the event loop was serviced while the connection was pending */
+    assert(first_data_ticks >= SERVER_DELAY * 100 / 1000000);
+    assert(nb_bytes == strlen(BODY));
+
+    upump_free(tick_pump);
+    upipe_release(upipe_timeout);
+    upipe_release(upipe_delayed);
+    test_free(sink);
+    upipe_mgr_release(upipe_http_src_mgr); // nop
+
+    upump_mgr_release(upump_mgr);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+    close(listen_fd);
+
+    ev_default_destroy();
+    return 0;
+}
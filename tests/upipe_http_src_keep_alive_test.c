@@ -0,0 +1,426 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for the persistent connections of http source pipe
+ *
+ * A local server counts the accepted connections while playlists and
+ * segments are fetched one after the other, as the HLS pipes do, with a
+ * new http source pipe for each request.
+ */
+
+#undef NDEBUG
+
+#include <upipe/uatomic.h>
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/uprobe_uref_mgr.h>
+#include <upipe/uprobe_upump_mgr.h>
+#include <upipe/uprobe_ubuf_mem.h>
+#include <upipe/uclock.h>
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/ubuf.h>
+#include <upipe/uref.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_std.h>
+#include <upipe/upump.h>
+#include <upump-ev/upump_ev.h>
+#include <upipe/upipe.h>
+#include <upipe/upipe_helper_upipe.h>
+#include <upipe-modules/upipe_http_source.h>
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+#include <pthread.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include <ev.h>
+
+#define UDICT_POOL_DEPTH 0
+#define UREF_POOL_DEPTH 0
+#define UBUF_POOL_DEPTH 0
+#define UPUMP_POOL 0
+#define UPUMP_BLOCKER_POOL 0
+#define UPROBE_LOG_LEVEL UPROBE_LOG_DEBUG
+/** number of segments of the playback */
+#define NB_SEGMENTS 100
+/** the playlist is refreshed before every group of segments */
+#define PLAYLIST_PERIOD 10
+/** number of requests of the playback */
+#define NB_FETCHES (NB_SEGMENTS + NB_SEGMENTS / PLAYLIST_PERIOD)
+#define SEGMENT_SIZE (188 * 10)
+#define PLAYLIST "#EXTM3U\n#EXT-X-TARGETDURATION:2\n"
+/** idle timeout of the expiry step */
+#define IDLE_TIMEOUT (UCLOCK_FREQ / 10)
+#define MAX_CLIENTS 8
+
+static int listen_fd;
+/** number of connections accepted by the server */
+static uatomic_uint32_t nb_accepted;
+/** the server closes the connection upon the next request */
+static uatomic_uint32_t drop_next;
+/** the server must exit */
+static uatomic_uint32_t server_exit;
+
+static char uri_prefix[64];
+static struct upipe_mgr *upipe_http_src_mgr;
+static struct upump_mgr *upump_mgr;
+static struct uprobe *logger;
+static struct upipe *sink;
+static struct upipe *upipe_http_src;
+static struct upump *next_pump;
+static unsigned int step = 0;
+static size_t nb_bytes = 0;
+static size_t expected_bytes = 0;
+
+static void start_next(uint64_t delay);
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        default:
+            assert(0);
+            break;
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_NEW_FLOW_DEF:
+            break;
+        case UPROBE_SOURCE_END:
+            assert(upipe == upipe_http_src);
+            assert(nb_bytes == expected_bytes);
+            step++;
+            if (step == NB_FETCHES) {
+                /* the whole playback used a single connection */
+                assert(uatomic_load(&nb_accepted) == 1);
+                uatomic_store(&drop_next, 1);
+                start_next(0);
+            } else if (step == NB_FETCHES + 1) {
+                /* the closed connection was transparently reopened */
+                assert(uatomic_load(&nb_accepted) == 2);
+                ubase_assert(upipe_http_src_mgr_set_keep_alive(
+                            upipe_http_src_mgr, 16, IDLE_TIMEOUT));
+                start_next(IDLE_TIMEOUT * 2);
+            } else if (step == NB_FETCHES + 2) {
+                /* the idle connection expired */
+                assert(uatomic_load(&nb_accepted) == 3);
+                ubase_assert(upipe_http_src_mgr_set_keep_alive(
+                            upipe_http_src_mgr, 0, IDLE_TIMEOUT));
+                start_next(0);
+            } else if (step == NB_FETCHES + 3) {
+                start_next(0);
+            } else if (step == NB_FETCHES + 4) {
+                /* no persistent connections */
+                assert(uatomic_load(&nb_accepted) == 5);
+            } else
+                start_next(0);
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** helper phony pipe */
+struct test_pipe {
+    struct upipe upipe;
+};
+
+/** helper phony pipe */
+UPIPE_HELPER_UPIPE(test_pipe, upipe, 0);
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct test_pipe *test_pipe = malloc(sizeof(struct test_pipe));
+    assert(test_pipe != NULL);
+    upipe_init(&test_pipe->upipe, mgr, uprobe);
+    upipe_throw_ready(&test_pipe->upipe);
+    return &test_pipe->upipe;
+}
+
+/** helper phony pipe */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    size_t size;
+    ubase_assert(uref_block_size(uref, &size));
+    nb_bytes += size;
+    uref_free(uref);
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF:
+            return UBASE_ERR_NONE;
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *urequest = va_arg(args, struct urequest *);
+            return upipe_throw_provide_request(upipe, urequest);
+        }
+        case UPIPE_UNREGISTER_REQUEST:
+            return UBASE_ERR_NONE;
+        default:
+            assert(0);
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    upipe_throw_dead(upipe);
+    struct test_pipe *test_pipe = test_pipe_from_upipe(upipe);
+    upipe_clean(upipe);
+    free(test_pipe);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr test_mgr = {
+    .refcount = NULL,
+    .signature = 0,
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
+/** fetches the next playlist or segment with a new pipe */
+static void fetch(struct upump *upump)
+{
+    upipe_release(upipe_http_src);
+    upipe_http_src = upipe_void_alloc(upipe_http_src_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "http"));
+    assert(upipe_http_src != NULL);
+    ubase_assert(upipe_set_output(upipe_http_src, sink));
+
+    char uri[128];
+    if (step < NB_FETCHES && !(step % (PLAYLIST_PERIOD + 1))) {
+        snprintf(uri, sizeof(uri), "%s/live.m3u8", uri_prefix);
+        expected_bytes += strlen(PLAYLIST);
+    } else {
+        snprintf(uri, sizeof(uri), "%s/segment%u.ts", uri_prefix, step);
+        expected_bytes += SEGMENT_SIZE;
+    }
+    ubase_assert(upipe_set_uri(upipe_http_src, uri));
+}
+
+/** schedules the next request */
+static void start_next(uint64_t delay)
+{
+    if (next_pump != NULL)
+        upump_free(next_pump);
+    next_pump = upump_alloc_timer(upump_mgr, fetch, NULL, NULL, delay, 0);
+    assert(next_pump != NULL);
+    upump_start(next_pump);
+}
+
+/** answers a request of a client, and returns false if the connection
+ * must be closed */
+static bool server_answer(int fd, const char *request)
+{
+    if (uatomic_load(&drop_next)) {
+        uatomic_store(&drop_next, 0);
+        return false;
+    }
+
+    char path[64];
+    assert(sscanf(request, "GET %63s HTTP/1.1\r\n", path) == 1);
+
+    char body[SEGMENT_SIZE];
+    size_t body_len;
+    if (!strcmp(path, "/live.m3u8")) {
+        body_len = strlen(PLAYLIST);
+        memcpy(body, PLAYLIST, body_len);
+    } else {
+        body_len = SEGMENT_SIZE;
+        memset(body, 0x47, body_len);
+    }
+
+    char response[256 + SEGMENT_SIZE];
+    int len = snprintf(response, sizeof(response),
+                       "HTTP/1.1 200 OK\r\nContent-Length: %zu\r\n\r\n",
+                       body_len);
+    memcpy(response + len, body, body_len);
+    len += body_len;
+    assert(send(fd, response, len, 0) == len);
+
+    return strstr(request, "Connection: close\r\n") == NULL;
+}
+
+/** stand-in http server supporting persistent connections */
+static void *server(void *arg)
+{
+    struct pollfd fds[MAX_CLIENTS + 1];
+    char buffers[MAX_CLIENTS + 1][4096];
+    size_t lens[MAX_CLIENTS + 1];
+    unsigned int nb_fds = 1;
+    fds[0].fd = listen_fd;
+    fds[0].events = POLLIN;
+
+    while (!uatomic_load(&server_exit)) {
+        assert(poll(fds, nb_fds, 10) >= 0);
+
+        for (unsigned int i = 1; i < nb_fds; i++) {
+            if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR)))
+                continue;
+
+            ssize_t ret = recv(fds[i].fd, buffers[i] + lens[i],
+                               sizeof(buffers[i]) - 1 - lens[i], 0);
+            bool keep = ret > 0;
+            if (keep) {
+                lens[i] += ret;
+                buffers[i][lens[i]] = '\0';
+                char *end = strstr(buffers[i], "\r\n\r\n");
+                if (end != NULL) {
+                    keep = server_answer(fds[i].fd, buffers[i]);
+                    lens[i] = 0;
+                }
+            }
+            if (!keep) {
+                close(fds[i].fd);
+                nb_fds--;
+                fds[i] = fds[nb_fds];
+                memcpy(buffers[i], buffers[nb_fds], lens[nb_fds]);
+                lens[i] = lens[nb_fds];
+                i--;
+            }
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int fd = accept(listen_fd, NULL, NULL);
+            assert(fd != -1);
+            assert(nb_fds < MAX_CLIENTS + 1);
+            uatomic_fetch_add(&nb_accepted, 1);
+            fds[nb_fds].fd = fd;
+            fds[nb_fds].events = POLLIN;
+            fds[nb_fds].revents = 0;
+            lens[nb_fds] = 0;
+            nb_fds++;
+        }
+    }
+
+    for (unsigned int i = 1; i < nb_fds; i++)
+        close(fds[i].fd);
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    uatomic_init(&nb_accepted, 0);
+    uatomic_init(&drop_next, 0);
+    uatomic_init(&server_exit, 0);
+
+    listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    assert(listen_fd != -1);
+    struct sockaddr_in sin;
+    memset(&sin, 0, sizeof(sin));
+    sin.sin_family = AF_INET;
+    sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    sin.sin_port = 0;
+    assert(bind(listen_fd, (struct sockaddr *)&sin, sizeof(sin)) == 0);
+    assert(listen(listen_fd, MAX_CLIENTS) == 0);
+    socklen_t sin_len = sizeof(sin);
+    assert(getsockname(listen_fd, (struct sockaddr *)&sin, &sin_len) == 0);
+    snprintf(uri_prefix, sizeof(uri_prefix), "http://127.0.0.1:%u",
+             ntohs(sin.sin_port));
+
+    pthread_t server_thread;
+    assert(pthread_create(&server_thread, NULL, server, NULL) == 0);
+
+    struct ev_loop *loop = ev_default_loop(0);
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr,
+                                                   0);
+    assert(uref_mgr != NULL);
+    upump_mgr = upump_ev_mgr_alloc(loop, UPUMP_POOL, UPUMP_BLOCKER_POOL);
+    assert(upump_mgr != NULL);
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    logger = uprobe_stdio_alloc(&uprobe, stdout, UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+    logger = uprobe_uref_mgr_alloc(logger, uref_mgr);
+    assert(logger != NULL);
+    logger = uprobe_upump_mgr_alloc(logger, upump_mgr);
+    assert(logger != NULL);
+    logger = uprobe_ubuf_mem_alloc(logger, umem_mgr, UBUF_POOL_DEPTH,
+                                   UBUF_POOL_DEPTH);
+    assert(logger != NULL);
+
+    sink = upipe_void_alloc(&test_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "sink"));
+    assert(sink != NULL);
+
+    upipe_http_src_mgr = upipe_http_src_mgr_alloc();
+    assert(upipe_http_src_mgr != NULL);
+    unsigned int max_idle;
+    uint64_t idle_timeout;
+    ubase_assert(upipe_http_src_mgr_get_keep_alive(upipe_http_src_mgr,
+                                                   &max_idle, &idle_timeout));
+    assert(max_idle);
+    assert(idle_timeout);
+
+    start_next(0);
+    ev_loop(loop, 0);
+
+    assert(step == NB_FETCHES + 4);
+    assert(nb_bytes == expected_bytes);
+
+    uatomic_store(&server_exit, 1);
+    assert(!pthread_join(server_thread, NULL));
+
+    upump_free(next_pump);
+    upipe_release(upipe_http_src);
+    test_free(sink);
+    upipe_mgr_release(upipe_http_src_mgr);
+
+    upump_mgr_release(upump_mgr);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+    close(listen_fd);
+    uatomic_clean(&nb_accepted);
+    uatomic_clean(&drop_next);
+    uatomic_clean(&server_exit);
+
+    ev_default_destroy();
+    return 0;
+}
@@ -59,6 +59,7 @@
 #define UPUMP_POOL 0
 #define UPUMP_BLOCKER_POOL 0
 #define QUEUE_LENGTH 6
+#define LONG_QUEUE_LENGTH 1000
 #define UPROBE_LOG_LEVEL UPROBE_LOG_VERBOSE
 
 UREF_ATTR_SMALL_UNSIGNED(test, test, "x.test", test)
@@ -255,8 +256,32 @@ int main(int argc, char *argv[])
     upipe_release(upipe_qsrc);
     upipe_release(upipe_qsink);
 
+    /* long queues are only allowed with the umpmc backend */
+    upipe_qsrc = upipe_qsrc_alloc(upipe_qsrc_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "queue source"), LONG_QUEUE_LENGTH);
+    assert(upipe_qsrc == NULL);
+
+    struct upipe_mgr *upipe_qsrc_mpmc_mgr = upipe_qsrc_mpmc_mgr_alloc();
+    assert(upipe_qsrc_mpmc_mgr != NULL);
+    upipe_qsrc = upipe_qsrc_alloc(upipe_qsrc_mpmc_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "queue source"), LONG_QUEUE_LENGTH);
+    assert(upipe_qsrc != NULL);
+    ubase_assert(upipe_qsrc_get_max_length(upipe_qsrc, &length));
+    assert(length == LONG_QUEUE_LENGTH);
+
+    upipe_qsink = upipe_qsink_alloc(upipe_qsink_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "queue sink"),
+            upipe_qsrc);
+    assert(upipe_qsink != NULL);
+    upipe_release(upipe_qsrc);
+    upipe_release(upipe_qsink);
+
     upipe_mgr_release(upipe_qsink_mgr); // nop
     upipe_mgr_release(upipe_qsrc_mgr); // nop
+    upipe_mgr_release(upipe_qsrc_mpmc_mgr); // nop
 
     test_free(upipe_sink);
 
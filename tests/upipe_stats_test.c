@@ -0,0 +1,277 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for the instrumentation counters of pipes
+ */
+
+#undef NDEBUG
+
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/uprobe_stats.h>
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_block_mem.h>
+#include <upipe/uref.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_std.h>
+#include <upipe/upipe.h>
+#include <upipe/upipe_stats.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+#define UDICT_POOL_DEPTH 5
+#define UREF_POOL_DEPTH 5
+#define UBUF_POOL_DEPTH 5
+#define UPROBE_LOG_LEVEL UPROBE_LOG_DEBUG
+#define ITERATIONS 100
+#define BLOCK_SIZE 188
+#define DEPTH_THREADS 4
+#define DEPTH_REPORTS 100000
+
+static struct upipe *upipe_fwd = NULL;
+static struct upipe *upipe_sink = NULL;
+static struct upipe *upipe_plain = NULL;
+static unsigned int nb_stats = 0;
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+            break;
+        case UPROBE_STATS: {
+            const struct upipe_stats *stats =
+                va_arg(args, const struct upipe_stats *);
+            assert(upipe == upipe_fwd || upipe == upipe_sink);
+            uint64_t self_time = upipe_stats_get(&stats->self_time);
+            uint64_t total_time = upipe_stats_get(&stats->total_time);
+            assert(upipe_stats_get(&stats->urefs_in) == ITERATIONS);
+            assert(upipe_stats_get(&stats->bytes_in) ==
+                   ITERATIONS * BLOCK_SIZE);
+            assert(self_time <= total_time);
+            if (upipe == upipe_fwd) {
+                assert(upipe_stats_get(&stats->urefs_out) == ITERATIONS);
+                assert(upipe_stats_get(&stats->bytes_out) ==
+                       ITERATIONS * BLOCK_SIZE);
+            } else {
+                assert(upipe_stats_get(&stats->urefs_out) == 0);
+                assert(self_time == total_time);
+            }
+            nb_stats++;
+            break;
+        }
+        default:
+            assert(0);
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct upipe *upipe = malloc(sizeof(struct upipe));
+    assert(upipe != NULL);
+    upipe_init(upipe, mgr, uprobe);
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** helper phony pipe */
+static void fwd_input(struct upipe *upipe, struct uref *uref,
+                      struct upump **upump_p)
+{
+    assert(upipe->stats == NULL ||
+           upipe_stats_get(&upipe->stats->urefs_in) > 0);
+    upipe_input(upipe_sink, uref, upump_p);
+}
+
+/** helper phony pipe */
+static void sink_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    uref_free(uref);
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    return UBASE_ERR_UNHANDLED;
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    upipe_throw_dead(upipe);
+    upipe_clean(upipe);
+    free(upipe);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr fwd_mgr = {
+    .refcount = NULL,
+    .upipe_alloc = test_alloc,
+    .upipe_input = fwd_input,
+    .upipe_control = test_control
+};
+
+/** helper phony pipe */
+static struct upipe_mgr sink_mgr = {
+    .refcount = NULL,
+    .upipe_alloc = test_alloc,
+    .upipe_input = sink_input,
+    .upipe_control = test_control
+};
+
+/** reports queue depths concurrently with other threads */
+static void *depth_thread(void *_offset)
+{
+    uint64_t offset = (uintptr_t)_offset;
+    for (uint64_t i = 0; i < DEPTH_REPORTS; i++)
+        upipe_stats_queue_depth(upipe_fwd, i * DEPTH_THREADS + offset);
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr,
+                                                   0);
+    assert(uref_mgr != NULL);
+    struct ubuf_mgr *ubuf_mgr = ubuf_block_mem_mgr_alloc(UBUF_POOL_DEPTH,
+                                                         UBUF_POOL_DEPTH,
+                                                         umem_mgr, -1, 0);
+    assert(ubuf_mgr != NULL);
+
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+    struct uprobe *uprobe_stats = uprobe_stats_alloc(uprobe_use(logger));
+    assert(uprobe_stats != NULL);
+    /* log messages are forwarded to the logger */
+    bool deferred;
+    assert(uprobe_log_min_level(uprobe_stats, &deferred) == UPROBE_LOG_LEVEL);
+    assert(deferred);
+
+    upipe_sink = upipe_void_alloc(&sink_mgr,
+            uprobe_pfx_alloc(uprobe_use(uprobe_stats), UPROBE_LOG_LEVEL,
+                             "sink"));
+    assert(upipe_sink != NULL);
+    assert(upipe_sink->stats != NULL);
+    upipe_fwd = upipe_void_alloc(&fwd_mgr,
+            uprobe_pfx_alloc(uprobe_use(uprobe_stats), UPROBE_LOG_LEVEL,
+                             "fwd"));
+    assert(upipe_fwd != NULL);
+    assert(upipe_fwd->stats != NULL);
+    /* pipes not using the probe are not instrumented */
+    upipe_plain = upipe_void_alloc(&fwd_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "plain"));
+    assert(upipe_plain != NULL);
+    assert(upipe_plain->stats == NULL);
+
+    for (int i = 0; i < ITERATIONS; i++) {
+        struct uref *uref = uref_block_alloc(uref_mgr, ubuf_mgr, BLOCK_SIZE);
+        assert(uref != NULL);
+        upipe_input(upipe_fwd, uref, NULL);
+    }
+    /* urefs from a plain pipe are counted as input but not as output */
+    struct uref *uref = uref_block_alloc(uref_mgr, ubuf_mgr, BLOCK_SIZE);
+    assert(uref != NULL);
+    upipe_input(upipe_plain, uref, NULL);
+    assert(upipe_stats_get(&upipe_sink->stats->urefs_in) == ITERATIONS + 1);
+    assert(upipe_stats_get(&upipe_fwd->stats->urefs_out) == ITERATIONS);
+    assert(upipe_stats_get(&upipe_fwd->stats->total_time) >=
+           upipe_stats_get(&upipe_fwd->stats->self_time));
+
+    uint64_t nb_calls = 0;
+    for (int i = 0; i < UPIPE_STATS_BUCKETS; i++)
+        nb_calls += upipe_stats_get(&upipe_fwd->stats->histogram[i]);
+    assert(nb_calls == ITERATIONS);
+    assert(upipe_stats_percentile(upipe_fwd->stats, 50) <=
+           upipe_stats_percentile(upipe_fwd->stats, 99));
+
+    upipe_stats_queue_depth(upipe_fwd, 3);
+    upipe_stats_queue_depth(upipe_fwd, 1);
+    assert(upipe_stats_get(&upipe_fwd->stats->queue_depth) == 1);
+    assert(upipe_stats_get(&upipe_fwd->stats->queue_depth_max) == 3);
+    upipe_stats_queue_depth(upipe_plain, 3);
+
+    /* the highest depth wins over concurrent reports */
+    pthread_t threads[DEPTH_THREADS];
+    for (uintptr_t i = 0; i < DEPTH_THREADS; i++)
+        assert(!pthread_create(&threads[i], NULL, depth_thread, (void *)i));
+    for (unsigned int i = 0; i < DEPTH_THREADS; i++)
+        assert(!pthread_join(threads[i], NULL));
+    assert(upipe_stats_get(&upipe_fwd->stats->queue_depth_max) ==
+           DEPTH_REPORTS * DEPTH_THREADS - 1);
+    upipe_stats_queue_depth(upipe_fwd, 1);
+
+    char *buffer;
+    size_t size;
+    FILE *file = open_memstream(&buffer, &size);
+    assert(file != NULL);
+    uprobe_stats_dump(uprobe_stats, file);
+    fclose(file);
+    printf("%s", buffer);
+    assert(strstr(buffer, "\nfwd ") != NULL);
+    assert(strstr(buffer, "\nsink ") != NULL);
+    assert(strstr(buffer, "plain") == NULL);
+    free(buffer);
+
+    /* the sink gets one more uref, and is released last */
+    test_free(upipe_plain);
+    test_free(upipe_fwd);
+    upipe_stats_set(&upipe_sink->stats->urefs_in, ITERATIONS);
+    upipe_stats_set(&upipe_sink->stats->bytes_in, ITERATIONS * BLOCK_SIZE);
+    test_free(upipe_sink);
+    assert(nb_stats == 2);
+
+    uprobe_release(uprobe_stats);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+
+    ubuf_mgr_release(ubuf_mgr);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    return 0;
+}
@@ -69,6 +69,13 @@
 
 #define SRCSIZE             32
 #define DSTSIZE             16
+/* large enough for two bands of 16 output lines */
+#define BAND_SRCSIZE        64
+#define BAND_DSTSIZE        32
+/* output lines around the boundary between bands which may differ */
+#define SEAM_LINES          8
+/* maximum difference of the lines around the boundary */
+#define SEAM_TOLERANCE      8
 
 /** definition of our uprobe */
 static int catch(struct uprobe *uprobe, struct upipe *upipe,
@@ -196,6 +203,67 @@ static bool compare_chroma(struct uref **urefs, const char *chroma, uint8_t hsub
     return true;
 }
 
+/* fill picture with a smooth gradient */
+static void fill_gradient(struct uref *uref, const char *chroma,
+                          uint8_t hsub, uint8_t vsub)
+{
+    size_t hsize, vsize, stride;
+    uint8_t *buffer;
+    uref_pic_plane_write(uref, chroma, 0, 0, -1, -1, &buffer);
+    uref_pic_plane_size(uref, chroma, &stride, NULL, NULL, NULL);
+    assert(buffer != NULL);
+    uref_pic_size(uref, &hsize, &vsize, NULL);
+    hsize /= hsub;
+    vsize /= vsub;
+    for (int y = 0; y < vsize; y++) {
+        for (int x = 0; x < hsize; x++)
+            buffer[x] = 16 + 2 * y * vsub + x * hsub;
+        buffer += stride;
+    }
+    uref_pic_plane_unmap(uref, chroma, 0, 0, -1, -1);
+}
+
+/* compare a chroma of two pictures scaled with and without bands: lines
+ * close to the boundary may differ slightly, the others must be identical */
+static bool compare_seam(struct uref **urefs, const char *chroma,
+                         uint8_t hsub, uint8_t vsub, int boundary,
+                         struct uprobe *uprobe)
+{
+    size_t hsize, vsize, stride[2];
+    const uint8_t *buffer[2];
+    bool ret = true;
+
+    for (int i = 0; i < 2; i++) {
+        ubase_assert(uref_pic_plane_read(urefs[i], chroma, 0, 0, -1, -1,
+                                         &buffer[i]));
+        ubase_assert(uref_pic_plane_size(urefs[i], chroma, &stride[i],
+                                         NULL, NULL, NULL));
+    }
+    ubase_assert(uref_pic_size(urefs[0], &hsize, &vsize, NULL));
+    hsize /= hsub;
+    vsize /= vsub;
+    boundary /= vsub;
+
+    for (int y = 0; y < vsize; y++) {
+        bool seam = y >= boundary - SEAM_LINES / vsub &&
+                    y < boundary + SEAM_LINES / vsub;
+        for (int x = 0; x < hsize; x++) {
+            int diff = abs(buffer[0][y * stride[0] + x] -
+                           buffer[1][y * stride[1] + x]);
+            if (diff > (seam ? SEAM_TOLERANCE : 0)) {
+                uprobe_dbg_va(uprobe, NULL,
+                              "####### %s pos %d %d differs by %d !",
+                              chroma, x, y, diff);
+                ret = false;
+            }
+        }
+    }
+
+    for (int i = 0; i < 2; i++)
+        uref_pic_plane_unmap(urefs[i], chroma, 0, 0, -1, -1);
+    return ret;
+}
+
 /** helper phony pipe */
 struct sws_test {
     struct uref *pic;
@@ -417,12 +485,72 @@ int main(int argc, char **argv)
     struct uref *pic = uref_dup(uref1);
     upipe_input(sws, pic, NULL);
 
+    assert(sws_test_from_upipe(sws_test)->pic);
+    assert(compare_chroma(((struct uref*[]){uref2, sws_test_from_upipe(sws_test)->pic}), "y8", 1, 1, 1, logger));
+
+    /* pictures this small are not split into bands */
+    unsigned int threads;
+    ubase_assert(upipe_sws_get_threads(sws, &threads));
+    assert(threads == 1);
+    ubase_nassert(upipe_sws_set_threads(sws, 0));
+    ubase_assert(upipe_sws_set_threads(sws, 4));
+    ubase_assert(upipe_sws_get_threads(sws, &threads));
+    assert(threads == 4);
+    pic = uref_dup(uref1);
+    upipe_input(sws, pic, NULL);
+
     assert(sws_test_from_upipe(sws_test)->pic);
     assert(compare_chroma(((struct uref*[]){uref2, sws_test_from_upipe(sws_test)->pic}), "y8", 1, 1, 1, logger));
     assert(compare_chroma(((struct uref*[]){uref2, sws_test_from_upipe(sws_test)->pic}), "u8", 2, 2, 1, logger));
     assert(compare_chroma(((struct uref*[]){uref2, sws_test_from_upipe(sws_test)->pic}), "v8", 2, 2, 1, logger));
 
     /* release urefs */
+    uref_free(uref1);
+    uref_free(uref2);
+    upipe_release(sws);
+
+    /* scale a picture split into two bands */
+    pic_flow = uref_pic_flow_alloc_def(uref_mgr, 1);
+    assert(pic_flow != NULL);
+    ubase_assert(uref_pic_flow_add_plane(pic_flow, 1, 1, 1, "y8"));
+    ubase_assert(uref_pic_flow_add_plane(pic_flow, 2, 2, 1, "u8"));
+    ubase_assert(uref_pic_flow_add_plane(pic_flow, 2, 2, 1, "v8"));
+    ubase_assert(uref_pic_flow_set_align(pic_flow, UBUF_ALIGN));
+    output_flow = uref_dup(pic_flow);
+    assert(output_flow != NULL);
+    ubase_assert(uref_pic_flow_set_hsize(output_flow, BAND_DSTSIZE));
+    ubase_assert(uref_pic_flow_set_vsize(output_flow, BAND_DSTSIZE));
+    sws = upipe_flow_alloc(upipe_sws_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "sws"),
+            output_flow);
+    assert(sws != NULL);
+    ubase_assert(upipe_set_flow_def(sws, pic_flow));
+    ubase_assert(upipe_set_output(sws, sws_test));
+    uref_free(output_flow);
+    uref_free(pic_flow);
+
+    uref1 = uref_pic_alloc(uref_mgr, ubuf_mgr, BAND_SRCSIZE, BAND_SRCSIZE);
+    assert(uref1 != NULL);
+    ubase_assert(uref_pic_set_progressive(uref1));
+    fill_gradient(uref1, "y8", 1, 1);
+    fill_gradient(uref1, "u8", 2, 2);
+    fill_gradient(uref1, "v8", 2, 2);
+
+    upipe_input(sws, uref_dup(uref1), NULL);
+    uref2 = sws_test_from_upipe(sws_test)->pic;
+    assert(uref2 != NULL);
+    sws_test_from_upipe(sws_test)->pic = NULL;
+
+    /* the bands start on output lines 0 and 16, which are also chroma lines
+     * and multiples of the 8-line dither pattern of swscale */
+    ubase_assert(upipe_sws_set_threads(sws, 2));
+    upipe_input(sws, uref_dup(uref1), NULL);
+    assert(sws_test_from_upipe(sws_test)->pic);
+    struct uref *banded[] = { uref2, sws_test_from_upipe(sws_test)->pic };
+    assert(compare_seam(banded, "y8", 1, 1, BAND_DSTSIZE / 2, logger));
+    assert(compare_seam(banded, "u8", 2, 2, BAND_DSTSIZE / 2, logger));
+    assert(compare_seam(banded, "v8", 2, 2, BAND_DSTSIZE / 2, logger));
+
     uref_free(uref1);
     uref_free(uref2);
 
@@ -47,12 +47,14 @@
 #include <upipe/uref_std.h>
 #include <upipe/upipe.h>
 #include <upipe-ts/upipe_ts_decaps.h>
+#include <upipe-ts/uref_ts_vector.h>
 
 #include <stdbool.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <unistd.h>
 #include <inttypes.h>
+#include <string.h>
 #include <assert.h>
 
 #include <bitstream/mpeg/ts.h>
@@ -240,6 +242,91 @@ int main(int argc, char *argv[])
     assert(!nb_packets);
     assert(!pcr);
 
+    /* vector of two packets, output as a single payload */
+    uref = uref_block_alloc(uref_mgr, ubuf_mgr, 2 * TS_SIZE);
+    assert(uref != NULL);
+    size = -1;
+    ubase_assert(uref_block_write(uref, 0, &size, &buffer));
+    assert(size == 2 * TS_SIZE);
+    memset(buffer, 0, 2 * TS_SIZE);
+    ts_init(buffer);
+    ts_set_cc(buffer, 4);
+    ts_set_payload(buffer);
+    ts_init(buffer + TS_SIZE);
+    ts_set_cc(buffer + TS_SIZE, 5);
+    ts_set_payload(buffer + TS_SIZE);
+    uref_block_unmap(uref, 0);
+    ubase_assert(uref_ts_vector_set_packets(uref, 2));
+    start = UBASE_ERR_INVALID;
+    discontinuity = UBASE_ERR_INVALID;
+    payload_size = 2 * 184;
+    nb_packets++;
+    upipe_input(upipe_ts_decaps, uref, NULL);
+    assert(!nb_packets);
+
+    /* vector of a packet and its duplicate */
+    uref = uref_block_alloc(uref_mgr, ubuf_mgr, 2 * TS_SIZE);
+    assert(uref != NULL);
+    size = -1;
+    ubase_assert(uref_block_write(uref, 0, &size, &buffer));
+    assert(size == 2 * TS_SIZE);
+    memset(buffer, 0, 2 * TS_SIZE);
+    ts_init(buffer);
+    ts_set_unitstart(buffer);
+    ts_set_cc(buffer, 6);
+    ts_set_payload(buffer);
+    memcpy(buffer + TS_SIZE, buffer, TS_SIZE);
+    uref_block_unmap(uref, 0);
+    ubase_assert(uref_ts_vector_set_packets(uref, 2));
+    start = UBASE_ERR_NONE;
+    payload_size = 184;
+    nb_packets++;
+    upipe_input(upipe_ts_decaps, uref, NULL);
+    assert(!nb_packets);
+
+    /* vector with a PCR */
+    uref = uref_block_alloc(uref_mgr, ubuf_mgr, 2 * TS_SIZE);
+    assert(uref != NULL);
+    size = -1;
+    ubase_assert(uref_block_write(uref, 0, &size, &buffer));
+    assert(size == 2 * TS_SIZE);
+    memset(buffer, 0, 2 * TS_SIZE);
+    ts_init(buffer);
+    ts_set_cc(buffer, 7);
+    ts_set_payload(buffer);
+    ts_set_adaptation(buffer, 42);
+    pcr = 0x112121212;
+    tsaf_set_pcr(buffer, pcr / 300);
+    tsaf_set_pcrext(buffer, pcr % 300);
+    ts_init(buffer + TS_SIZE);
+    ts_set_cc(buffer + TS_SIZE, 8);
+    ts_set_payload(buffer + TS_SIZE);
+    uref_block_unmap(uref, 0);
+    ubase_assert(uref_ts_vector_set_packets(uref, 2));
+    start = UBASE_ERR_INVALID;
+    payload_size = 141 + 184;
+    nb_packets++;
+    upipe_input(upipe_ts_decaps, uref, NULL);
+    assert(!nb_packets);
+    assert(!pcr);
+
+    /* vector whose size is not the announced number of packets */
+    uref = uref_block_alloc(uref_mgr, ubuf_mgr, 2 * TS_SIZE);
+    assert(uref != NULL);
+    size = -1;
+    ubase_assert(uref_block_write(uref, 0, &size, &buffer));
+    memset(buffer, 0, 2 * TS_SIZE);
+    ts_init(buffer);
+    ts_set_cc(buffer, 9);
+    ts_set_payload(buffer);
+    ts_init(buffer + TS_SIZE);
+    ts_set_cc(buffer + TS_SIZE, 10);
+    ts_set_payload(buffer + TS_SIZE);
+    uref_block_unmap(uref, 0);
+    ubase_assert(uref_ts_vector_set_packets(uref, 3));
+    upipe_input(upipe_ts_decaps, uref, NULL);
+    assert(!nb_packets);
+
     upipe_release(upipe_ts_decaps);
     upipe_mgr_release(upipe_ts_decaps_mgr); // nop
 
@@ -0,0 +1,303 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short benchmark of ts_sync, ts_split and ts_decaps, with and without
+ * vectors of TS packets
+ *
+ * A TS file is loaded in memory and fed repeatedly, in blocks of 7 TS
+ * packets, to a ts_sync pipe followed by a ts_split pipe with one ts_decaps
+ * pipe per PID. The result is in megabits per CPU second.
+ */
+
+#undef NDEBUG
+
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/umem.h>
+#include <upipe/umem_pool.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_block.h>
+#include <upipe/ubuf_block_mem.h>
+#include <upipe/uref.h>
+#include <upipe/uref_flow.h>
+#include <upipe/uref_block_flow.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_std.h>
+#include <upipe/upipe.h>
+#include <upipe-ts/upipe_ts_sync.h>
+#include <upipe-ts/upipe_ts_split.h>
+#include <upipe-ts/upipe_ts_decaps.h>
+#include <upipe-ts/uref_ts_flow.h>
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <assert.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include <bitstream/mpeg/ts.h>
+
+#define UMEM_POOL 512
+#define UDICT_POOL_DEPTH 500
+#define UREF_POOL_DEPTH 500
+#define UBUF_POOL_DEPTH 500
+#define UPROBE_LOG_LEVEL UPROBE_LOG_ERROR
+#define BLOCK_SIZE (7 * TS_SIZE)
+#define DEFAULT_LOOPS 200
+#define MAX_PIDS 8192
+
+static uint64_t nb_urefs = 0, nb_octets = 0;
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    return UBASE_ERR_NONE;
+}
+
+/** helper phony pipe counting payloads */
+static struct upipe *count_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                 uint32_t signature, va_list args)
+{
+    struct upipe *upipe = malloc(sizeof(struct upipe));
+    assert(upipe != NULL);
+    upipe_init(upipe, mgr, uprobe);
+    return upipe;
+}
+
+/** helper phony pipe counting payloads */
+static void count_input(struct upipe *upipe, struct uref *uref,
+                        struct upump **upump_p)
+{
+    size_t size;
+    ubase_assert(uref_block_size(uref, &size));
+    nb_urefs++;
+    nb_octets += size;
+    uref_free(uref);
+}
+
+/** helper phony pipe counting payloads */
+static int count_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF:
+            return UBASE_ERR_NONE;
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe counting payloads */
+static void count_free(struct upipe *upipe)
+{
+    upipe_clean(upipe);
+    free(upipe);
+}
+
+/** helper phony pipe counting payloads */
+static struct upipe_mgr count_mgr = {
+    .refcount = NULL,
+    .upipe_alloc = count_alloc,
+    .upipe_input = count_input,
+    .upipe_control = count_control
+};
+
+/** returns the CPU time used by the process, in microseconds */
+static uint64_t cpu_time(void)
+{
+    struct rusage rusage;
+    getrusage(RUSAGE_SELF, &rusage);
+    return (uint64_t)(rusage.ru_utime.tv_sec + rusage.ru_stime.tv_sec) *
+               UINT64_C(1000000) +
+           rusage.ru_utime.tv_usec + rusage.ru_stime.tv_usec;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stdout, "Usage: %s [-n <loops>] <file.ts> [<vector> ...]\n", argv0);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int loops = DEFAULT_LOOPS;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+            case 'n':
+                loops = strtoul(optarg, NULL, 10);
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+    if (optind >= argc)
+        usage(argv[0]);
+
+    /* load the file */
+    FILE *file = fopen(argv[optind++], "r");
+    assert(file != NULL);
+    fseek(file, 0, SEEK_END);
+    long file_size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    file_size -= file_size % BLOCK_SIZE;
+    assert(file_size > 0);
+    uint8_t *data = malloc(file_size);
+    assert(data != NULL);
+    assert(fread(data, file_size, 1, file) == 1);
+    fclose(file);
+
+    static bool pids[MAX_PIDS];
+    for (long offset = 0; offset < file_size; offset += TS_SIZE)
+        pids[ts_get_pid(data + offset)] = true;
+
+    struct umem_mgr *umem_mgr = umem_pool_mgr_alloc_simple(UMEM_POOL);
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr,
+                                                   0);
+    assert(uref_mgr != NULL);
+    struct ubuf_mgr *ubuf_mgr = ubuf_block_mem_mgr_alloc(UBUF_POOL_DEPTH,
+                                                         UBUF_POOL_DEPTH,
+                                                         umem_mgr, 0, 0);
+    assert(ubuf_mgr != NULL);
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+
+    struct upipe *count = upipe_void_alloc(&count_mgr, uprobe_use(logger));
+    assert(count != NULL);
+    struct upipe_mgr *upipe_ts_sync_mgr = upipe_ts_sync_mgr_alloc();
+    assert(upipe_ts_sync_mgr != NULL);
+    struct upipe_mgr *upipe_ts_split_mgr = upipe_ts_split_mgr_alloc();
+    assert(upipe_ts_split_mgr != NULL);
+    struct upipe_mgr *upipe_ts_decaps_mgr = upipe_ts_decaps_mgr_alloc();
+    assert(upipe_ts_decaps_mgr != NULL);
+
+    unsigned int default_vectors[] = { 1, 7, 32, 64 };
+    unsigned int nb_vectors = argc - optind;
+    if (!nb_vectors)
+        nb_vectors = UBASE_ARRAY_SIZE(default_vectors);
+
+    printf("%8s %12s %12s %10s %14s %14s\n", "vector", "packets",
+           "payloads", "cpu (ms)", "Mbit/s/core", "packets/s/core");
+    for (unsigned int v = 0; v < nb_vectors; v++) {
+        unsigned int vector = optind < argc ?
+                              strtoul(argv[optind + v], NULL, 10) :
+                              default_vectors[v];
+
+        struct uref *flow_def = uref_block_flow_alloc_def(uref_mgr, NULL);
+        assert(flow_def != NULL);
+        struct upipe *upipe_ts_sync = upipe_void_alloc(upipe_ts_sync_mgr,
+                uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                                 "ts sync"));
+        assert(upipe_ts_sync != NULL);
+        ubase_assert(upipe_set_flow_def(upipe_ts_sync, flow_def));
+        ubase_assert(upipe_ts_sync_set_vector(upipe_ts_sync, vector));
+        uref_free(flow_def);
+
+        struct upipe *upipe_ts_split = upipe_void_alloc_output(upipe_ts_sync,
+                upipe_ts_split_mgr,
+                uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                                 "ts split"));
+        assert(upipe_ts_split != NULL);
+
+        struct upipe *outputs[MAX_PIDS];
+        flow_def = uref_block_flow_alloc_def(uref_mgr, "mpegts.");
+        assert(flow_def != NULL);
+        for (unsigned int pid = 0; pid < MAX_PIDS; pid++) {
+            outputs[pid] = NULL;
+            if (!pids[pid] || pid == 8191)
+                continue;
+            ubase_assert(uref_ts_flow_set_pid(flow_def, pid));
+            outputs[pid] = upipe_flow_alloc_sub(upipe_ts_split,
+                    uprobe_pfx_alloc_va(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                                        "ts split output %u", pid), flow_def);
+            assert(outputs[pid] != NULL);
+            struct upipe *decaps = upipe_void_alloc_output(outputs[pid],
+                    upipe_ts_decaps_mgr,
+                    uprobe_pfx_alloc_va(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                                        "ts decaps %u", pid));
+            assert(decaps != NULL);
+            ubase_assert(upipe_set_output(decaps, count));
+            upipe_release(decaps);
+        }
+        uref_free(flow_def);
+
+        nb_urefs = nb_octets = 0;
+        uint64_t start = cpu_time();
+        for (unsigned int l = 0; l < loops; l++) {
+            for (long offset = 0; offset < file_size; offset += BLOCK_SIZE) {
+                struct uref *uref = uref_block_alloc(uref_mgr, ubuf_mgr,
+                                                     BLOCK_SIZE);
+                assert(uref != NULL);
+                uint8_t *buffer;
+                int size = -1;
+                ubase_assert(uref_block_write(uref, 0, &size, &buffer));
+                assert(size == BLOCK_SIZE);
+                memcpy(buffer, data + offset, BLOCK_SIZE);
+                uref_block_unmap(uref, 0);
+                upipe_input(upipe_ts_sync, uref, NULL);
+            }
+        }
+        uint64_t cpu = cpu_time() - start;
+        uint64_t packets = (uint64_t)loops * (file_size / TS_SIZE);
+
+        printf("%8u %12"PRIu64" %12"PRIu64" %10"PRIu64" %14"PRIu64" %14"PRIu64
+               "\n", vector, packets, nb_urefs, cpu / 1000,
+               cpu ? (uint64_t)loops * file_size * 8 / cpu : 0,
+               cpu ? packets * UINT64_C(1000000) / cpu : 0);
+
+        for (unsigned int pid = 0; pid < MAX_PIDS; pid++)
+            if (outputs[pid] != NULL)
+                upipe_release(outputs[pid]);
+        upipe_release(upipe_ts_split);
+        upipe_release(upipe_ts_sync);
+    }
+
+    count_free(count);
+    upipe_mgr_release(upipe_ts_decaps_mgr); /* nop */
+    upipe_mgr_release(upipe_ts_split_mgr); /* nop */
+    upipe_mgr_release(upipe_ts_sync_mgr); /* nop */
+    uref_mgr_release(uref_mgr);
+    ubuf_mgr_release(ubuf_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+    free(data);
+
+    return 0;
+}
@@ -46,6 +46,7 @@
 #include <upipe/uref_std.h>
 #include <upipe/upipe.h>
 #include <upipe-ts/uref_ts_flow.h>
+#include <upipe-ts/uref_ts_vector.h>
 #include <upipe-ts/upipe_ts_split.h>
 
 #include <stdbool.h>
@@ -95,6 +96,8 @@ static int catch(struct uprobe *uprobe, struct upipe *upipe,
 struct test {
     uint16_t pid;
     bool got_packet;
+    unsigned int nb_urefs;
+    unsigned int nb_packets;
     struct upipe upipe;
 };
 
@@ -109,6 +112,7 @@ static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
     assert(test != NULL);
     upipe_init(&test->upipe, mgr, uprobe);
     test->got_packet = false;
+    test->nb_urefs = test->nb_packets = 0;
     test->pid = pid;
     return &test->upipe;
 }
@@ -120,13 +124,29 @@ static void test_input(struct upipe *upipe, struct uref *uref,
     struct test *test = container_of(upipe, struct test, upipe);
     assert(uref != NULL);
     test->got_packet = true;
-    const uint8_t *buffer;
-    int size = -1;
-    ubase_assert(uref_block_read(uref, 0, &size, &buffer));
-    assert(size == TS_SIZE); //because of the way we allocated it
-    assert(ts_validate(buffer));
-    assert(ts_get_pid(buffer) == test->pid);
-    uref_block_unmap(uref, 0);
+    test->nb_urefs++;
+    size_t size;
+    ubase_assert(uref_block_size(uref, &size));
+    assert(size && !(size % TS_SIZE));
+    const uint8_t *pids;
+    size_t pids_size;
+    assert(!ubase_check(uref_ts_vector_get_pids(uref, &pids, &pids_size)));
+    uint64_t packets;
+    if (size > TS_SIZE) {
+        ubase_assert(uref_ts_vector_get_packets(uref, &packets));
+        assert(packets * TS_SIZE == size);
+    } else
+        assert(!ubase_check(uref_ts_vector_get_packets(uref, &packets)));
+    for (int offset = 0; offset < size; offset += TS_SIZE) {
+        uint8_t buffer[TS_HEADER_SIZE];
+        const uint8_t *ts_header = uref_block_peek(uref, offset,
+                                                   TS_HEADER_SIZE, buffer);
+        assert(ts_header != NULL);
+        assert(ts_validate(ts_header));
+        assert(ts_get_pid(ts_header) == test->pid);
+        ubase_assert(uref_block_peek_unmap(uref, offset, buffer, ts_header));
+        test->nb_packets++;
+    }
     uref_free(uref);
 }
 
@@ -236,6 +256,62 @@ int main(int argc, char *argv[])
     uref_block_unmap(uref, 0);
     upipe_input(upipe_ts_split, uref, NULL);
 
+    struct test *test68 = container_of(upipe_sink68, struct test, upipe);
+    struct test *test69 = container_of(upipe_sink69, struct test, upipe);
+    assert(test68->nb_urefs == 1 && test68->nb_packets == 1);
+    assert(test69->nb_urefs == 1 && test69->nb_packets == 1);
+
+    /* vector of packets with a PID index */
+    static const uint16_t vector_pids[] = { 68, 69, 68, 68, 70, 69 };
+    unsigned int packets = UBASE_ARRAY_SIZE(vector_pids);
+    uint8_t index[2 * packets];
+    uref = uref_block_alloc(uref_mgr, ubuf_mgr, packets * TS_SIZE);
+    assert(uref != NULL);
+    size = -1;
+    ubase_assert(uref_block_write(uref, 0, &size, &buffer));
+    assert(size == packets * TS_SIZE);
+    for (unsigned int i = 0; i < packets; i++) {
+        ts_pad(buffer + i * TS_SIZE);
+        ts_set_pid(buffer + i * TS_SIZE, vector_pids[i]);
+        uref_ts_vector_set_pid(index, i, vector_pids[i]);
+    }
+    uref_block_unmap(uref, 0);
+    ubase_assert(uref_ts_vector_set_packets(uref, packets));
+    ubase_assert(uref_ts_vector_set_pids(uref, index, 2 * packets));
+    upipe_input(upipe_ts_split, uref, NULL);
+    assert(test68->nb_urefs == 2 && test68->nb_packets == 4);
+    assert(test69->nb_urefs == 2 && test69->nb_packets == 3);
+
+    /* vector of packets of a single PID, without index */
+    uref = uref_block_alloc(uref_mgr, ubuf_mgr, 3 * TS_SIZE);
+    assert(uref != NULL);
+    size = -1;
+    ubase_assert(uref_block_write(uref, 0, &size, &buffer));
+    assert(size == 3 * TS_SIZE);
+    for (unsigned int i = 0; i < 3; i++) {
+        ts_pad(buffer + i * TS_SIZE);
+        ts_set_pid(buffer + i * TS_SIZE, 69);
+    }
+    uref_block_unmap(uref, 0);
+    ubase_assert(uref_ts_vector_set_packets(uref, 3));
+    upipe_input(upipe_ts_split, uref, NULL);
+    assert(test68->nb_urefs == 2 && test68->nb_packets == 4);
+    assert(test69->nb_urefs == 3 && test69->nb_packets == 6);
+
+    /* vector whose size is not the announced number of packets */
+    uref = uref_block_alloc(uref_mgr, ubuf_mgr, 2 * TS_SIZE + 10);
+    assert(uref != NULL);
+    size = -1;
+    ubase_assert(uref_block_write(uref, 0, &size, &buffer));
+    for (unsigned int i = 0; i < 2; i++) {
+        ts_pad(buffer + i * TS_SIZE);
+        ts_set_pid(buffer + i * TS_SIZE, 68);
+    }
+    uref_block_unmap(uref, 0);
+    ubase_assert(uref_ts_vector_set_packets(uref, 2));
+    upipe_input(upipe_ts_split, uref, NULL);
+    assert(test68->nb_urefs == 2 && test68->nb_packets == 4);
+
     upipe_release(upipe_ts_split_output68);
     upipe_release(upipe_ts_split_output69);
     upipe_release(upipe_ts_split);
@@ -46,6 +46,7 @@
 #include <upipe/uref_std.h>
 #include <upipe/upipe.h>
 #include <upipe-ts/upipe_ts_sync.h>
+#include <upipe-ts/uref_ts_vector.h>
 
 #include <stdbool.h>
 #include <stdlib.h>
@@ -101,16 +102,35 @@ static void test_input(struct upipe *upipe, struct uref *uref,
     assert(uref != NULL);
     size_t size;
     ubase_assert(uref_block_size(uref, &size));
-    assert(size == TS_SIZE);
+    assert(size && !(size % TS_SIZE));
+    unsigned int packets = size / TS_SIZE;
 
-    const uint8_t *buffer;
-    int rsize = 1;
-    ubase_assert(uref_block_read(uref, 0, &rsize, &buffer));
-    assert(rsize == 1);
-    assert(ts_validate(buffer));
-    uref_block_unmap(uref, 0);
+    uint64_t vector_packets;
+    const uint8_t *pids = NULL;
+    size_t pids_size;
+    if (packets > 1) {
+        ubase_assert(uref_ts_vector_get_packets(uref, &vector_packets));
+        assert(vector_packets == packets);
+        ubase_assert(uref_ts_vector_get_pids(uref, &pids, &pids_size));
+        assert(pids_size == 2 * packets);
+    } else {
+        assert(!ubase_check(uref_ts_vector_get_packets(uref,
+                                                       &vector_packets)));
+        assert(!ubase_check(uref_ts_vector_get_pids(uref, &pids, &pids_size)));
+    }
+
+    for (unsigned int i = 0; i < packets; i++) {
+        const uint8_t *buffer;
+        int rsize = 1;
+        ubase_assert(uref_block_read(uref, i * TS_SIZE, &rsize, &buffer));
+        assert(rsize == 1);
+        assert(ts_validate(buffer));
+        uref_block_unmap(uref, i * TS_SIZE);
+        if (packets > 1)
+            assert(uref_ts_vector_pid(pids, i) == 0x1fff);
+        nb_packets--;
+    }
     uref_free(uref);
-    nb_packets--;
 }
 
 /** helper phony pipe */
@@ -179,7 +199,7 @@ int main(int argc, char *argv[])
     uref_free(uref);
 
     uint8_t *buffer;
-    int size;
+    int size, i;
 
     uref = uref_block_alloc(uref_mgr, ubuf_mgr, 2 * TS_SIZE);
     assert(uref != NULL);
@@ -230,6 +250,39 @@ int main(int argc, char *argv[])
     upipe_input(upipe_ts_sync, uref, NULL);
     assert(!nb_packets);
 
+    nb_packets++;
+    upipe_release(upipe_ts_sync);
+    assert(!nb_packets);
+
+    /* vector mode */
+    upipe_ts_sync = upipe_void_alloc(upipe_ts_sync_mgr,
+            uprobe_pfx_alloc(uprobe_use(uprobe_stdio), UPROBE_LOG_LEVEL,
+                             "ts sync vector"));
+    assert(upipe_ts_sync != NULL);
+    uref = uref_block_flow_alloc_def(uref_mgr, NULL);
+    assert(uref != NULL);
+    ubase_assert(upipe_set_flow_def(upipe_ts_sync, uref));
+    ubase_assert(upipe_set_output(upipe_ts_sync, upipe_sink));
+    uref_free(uref);
+    unsigned int vector;
+    ubase_assert(upipe_ts_sync_set_vector(upipe_ts_sync, 4));
+    ubase_assert(upipe_ts_sync_get_vector(upipe_ts_sync, &vector));
+    assert(vector == 4);
+
+    uref = uref_block_alloc(uref_mgr, ubuf_mgr, 6 * TS_SIZE);
+    assert(uref != NULL);
+    size = -1;
+    ubase_assert(uref_block_write(uref, 0, &size, &buffer));
+    assert(size == 6 * TS_SIZE);
+    for (i = 0; i < 6; i++)
+        ts_pad(buffer + i * TS_SIZE);
+    uref_block_unmap(uref, 0);
+    /* the last packet is kept until the next sync word */
+    nb_packets += 5;
+    expect_loss = -1;
+    upipe_input(upipe_ts_sync, uref, NULL);
+    assert(!nb_packets);
+
     nb_packets++;
     upipe_release(upipe_ts_sync);
     assert(!nb_packets);
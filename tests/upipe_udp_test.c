@@ -49,6 +49,7 @@
 #include <upipe/ubuf_block_mem.h>
 #include <upipe/uref.h>
 #include <upipe/uref_block.h>
+#include <upipe/uref_clock.h>
 #include <upipe/uref_flow.h>
 #include <upipe/uref_block_flow.h>
 #include <upipe/uref_std.h>
@@ -82,6 +83,12 @@
 #define UPROBE_LOG_LEVEL UPROBE_LOG_DEBUG
 #define BUF_SIZE 256
 #define FORMAT "This is packet number %d"
+#define BURST 32
+#define BURST_DELAY (UCLOCK_FREQ / 100)
+#define BURST_STEP (UCLOCK_FREQ / 100000)
+#define BURST_WINDOW (UCLOCK_FREQ / 1000)
+#define BURST_TIMEOUT UCLOCK_FREQ
+#define CR_SYS_TOLERANCE (UCLOCK_FREQ / 1000)
 
 /* FIXME: uncomment or remove */
 /*static void usage(const char *argv0) {
@@ -100,10 +107,16 @@ int sockfd;
 struct ubuf_mgr *ubuf_mgr;
 struct uref_mgr *uref_mgr;
 struct upump *write_pump;
+struct upump *timeout_pump;
+struct uclock *uclock;
 struct addrinfo hints, *servinfo, *p;
 struct upipe *upipe_udpsrc;
 struct upipe *upipe_udpsink;
 static int counter = 0;
+/* counter after the last datagram of the burst, or -1 */
+static int burst_end = -1;
+static uint64_t burst_date = 0;
+static uint64_t last_cr_sys = 0;
 
 /** definition of our uprobe */
 static int catch(struct uprobe *uprobe, struct upipe *upipe,
@@ -162,6 +175,21 @@ static void test_input(struct upipe *upipe, struct uref *uref,
         uref_block_peek_unmap(uref, 0, buf, rbuf);
     }
 
+    if (burst_end != -1) {
+        /* each datagram is dated with its own kernel timestamp */
+        uint64_t cr_sys;
+        ubase_assert(uref_clock_get_cr_sys(uref, &cr_sys));
+        assert(cr_sys + CR_SYS_TOLERANCE >= burst_date);
+        assert(cr_sys <= uclock_now(uclock));
+        assert(cr_sys + CR_SYS_TOLERANCE >= last_cr_sys);
+        last_cr_sys = cr_sys;
+
+        if (udpsrc_test->counter == burst_end) {
+            upump_stop(timeout_pump);
+            upipe_set_uri(upipe_udpsrc, NULL);
+        }
+    }
+
     uref_free(uref);
 }
 
@@ -249,6 +277,39 @@ static void genpackets2(struct upump *upump)
     }
 }
 
+/* burst generator */
+static void genburst(struct upump *upump)
+{
+    struct uref *uref;
+    uint8_t *buf;
+    int i, size = -1;
+
+    upump_stop(write_pump);
+    burst_date = uclock_now(uclock) + BURST_DELAY;
+    burst_end = counter + BURST;
+    printf("Burst: %d to %d\n", counter, burst_end - 1);
+
+    /* all datagrams fit in the batch window, and are sent together */
+    for (i = 0; i < BURST; i++) {
+        uref = uref_block_alloc(uref_mgr, ubuf_mgr, BUF_SIZE);
+        uref_block_write(uref, 0, &size, &buf);
+        assert(size == BUF_SIZE);
+        memset(buf, 0, size);
+        snprintf((char *)buf, BUF_SIZE, FORMAT, counter);
+        uref_block_unmap(uref, 0);
+        uref_clock_set_cr_sys(uref, burst_date + i * BURST_STEP);
+        counter++;
+        upipe_input(upipe_udpsink, uref, NULL);
+    }
+}
+
+/* burst timeout */
+static void burst_timeout(struct upump *upump)
+{
+    printf("Burst timed out\n");
+    upipe_set_uri(upipe_udpsrc, NULL);
+}
+
 int main(int argc, char *argv[])
 {
     char udp_uri[512], port_str[8];
@@ -270,7 +331,7 @@ int main(int argc, char *argv[])
     struct upump_mgr *upump_mgr = upump_ev_mgr_alloc(loop, UPUMP_POOL,
                                                      UPUMP_BLOCKER_POOL);
     assert(upump_mgr != NULL);
-    struct uclock *uclock = uclock_std_alloc(0);
+    uclock = uclock_std_alloc(0);
     assert(uclock != NULL);
     struct uprobe uprobe;
     uprobe_init(&uprobe, catch, NULL);
@@ -353,6 +414,19 @@ int main(int argc, char *argv[])
     ubase_assert(upipe_set_flow_def(upipe_udpsink, flow_def));
     uref_free(flow_def);
 
+    /* read the second run in batch mode */
+    unsigned int batch;
+    ubase_assert(upipe_udpsrc_set_batch(upipe_udpsrc, 8));
+    ubase_assert(upipe_udpsrc_get_batch(upipe_udpsrc, &batch));
+    assert(batch == 8);
+
+    /* and write it in batch mode */
+    uint64_t window;
+    ubase_assert(upipe_udpsink_set_batch(upipe_udpsink, 4, UCLOCK_FREQ / 1000));
+    ubase_assert(upipe_udpsink_get_batch(upipe_udpsink, &batch, &window));
+    assert(batch == 4);
+    assert(window == UCLOCK_FREQ / 1000);
+
     /* reset source uri */
     for (i=0; i < 10; i++) {
         port = ((rand() % 40000) + 1024);
@@ -372,8 +446,43 @@ int main(int argc, char *argv[])
 
     /* fire again */
     ev_loop(loop, 0);
+    upump_free(write_pump);
+
+    /* burst through the loopback, segmented by the kernel if possible */
+    ubase_assert(upipe_attach_uclock(upipe_udpsink));
+    ubase_assert(upipe_udpsink_set_batch(upipe_udpsink, BURST, BURST_WINDOW));
+    if (!ubase_check(upipe_udpsink_set_gso(upipe_udpsink, true)))
+        printf("UDP segmentation offload unavailable, sending datagrams\n");
+
+    for (i=0; i < 10; i++) {
+        port = ((rand() % 40000) + 1024);
+        snprintf(udp_uri, sizeof(udp_uri), "@127.0.0.1:%d", port);
+        printf("Trying uri: %s ...\n", udp_uri);
+        if (( ret = ubase_check(upipe_set_uri(upipe_udpsrc, udp_uri)) )) {
+            break;
+        }
+    }
+    assert(ret);
+    ubase_assert(upipe_udpsink_set_uri(upipe_udpsink, udp_uri+1, 0));
+    /* datagrams of the previous run may have been lost */
+    udpsrc_test_from_upipe(udpsrc_test)->counter = counter;
+
+    write_pump = upump_alloc_idler(upump_mgr, genburst, NULL, NULL);
+    assert(write_pump);
+    upump_start(write_pump);
+    timeout_pump = upump_alloc_timer(upump_mgr, burst_timeout, NULL, NULL,
+                                     BURST_TIMEOUT, 0);
+    assert(timeout_pump);
+    upump_start(timeout_pump);
+
+    /* fire the burst */
+    ev_loop(loop, 0);
+
+    /* all datagrams were received, in order */
+    assert(udpsrc_test_from_upipe(udpsrc_test)->counter == burst_end);
 
     /* release */
+    upump_free(timeout_pump);
     upump_free(write_pump);
     upipe_release(upipe_udpsrc);
     upipe_release(upipe_udpsink);
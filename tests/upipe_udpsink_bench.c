@@ -0,0 +1,328 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short benchmark of udp sink pipes, with and without batch mode
+ *
+ * A number of udp sinks sharing the same upump manager send paced CBR
+ * streams of datagrams of 7 TS packets to the loopback interface. The send
+ * system calls are counted by wrapping the libc functions, so the result is
+ * in packets per CPU second and system calls per second.
+ */
+
+#undef NDEBUG
+#define _GNU_SOURCE
+
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/uprobe_upump_mgr.h>
+#include <upipe/uprobe_uclock.h>
+#include <upipe/uclock.h>
+#include <upipe/uclock_std.h>
+#include <upipe/umem.h>
+#include <upipe/umem_pool.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_block_mem.h>
+#include <upipe/uref.h>
+#include <upipe/uref_std.h>
+#include <upipe/uref_block.h>
+#include <upipe/uref_block_flow.h>
+#include <upipe/uref_clock.h>
+#include <upipe/upump.h>
+#include <upump-ev/upump_ev.h>
+#include <upipe/upipe.h>
+#include <upipe-modules/upipe_udp_sink.h>
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <assert.h>
+#include <dlfcn.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include <ev.h>
+
+#define UMEM_POOL 512
+#define UDICT_POOL_DEPTH 500
+#define UREF_POOL_DEPTH 500
+#define UBUF_POOL_DEPTH 500
+#define UPUMP_POOL 10
+#define UPUMP_BLOCKER_POOL 10
+#define UPROBE_LOG_LEVEL UPROBE_LOG_WARNING
+#define DGRAM_SIZE (7 * 188)
+#define MAX_SINKS 1000
+#define DEFAULT_DURATION 2
+#define DEFAULT_RATE 1000
+#define DEFAULT_BATCH 32
+#define DEFAULT_WINDOW 4
+#define TICK (UCLOCK_FREQ / 1000)
+
+static struct upipe *sinks[MAX_SINKS];
+static uint64_t next_dates[MAX_SINKS];
+static unsigned int nb_sinks;
+static uint64_t interval, end;
+static uint64_t packets = 0, syscalls = 0;
+static struct uref_mgr *uref_mgr;
+static struct ubuf_mgr *ubuf_mgr;
+static struct uclock *uclock;
+
+/** counts writev(2) system calls issued by the sinks */
+ssize_t writev(int fd, const struct iovec *iov, int iovcnt)
+{
+    static ssize_t (*real_writev)(int, const struct iovec *, int) = NULL;
+    if (real_writev == NULL)
+        real_writev = dlsym(RTLD_NEXT, "writev");
+    syscalls++;
+    return real_writev(fd, iov, iovcnt);
+}
+
+/** counts sendmmsg(2) system calls issued by the sinks */
+int sendmmsg(int fd, struct mmsghdr *msgs, unsigned int vlen, int flags)
+{
+    static int (*real_sendmmsg)(int, struct mmsghdr *, unsigned int,
+                                int) = NULL;
+    if (real_sendmmsg == NULL)
+        real_sendmmsg = dlsym(RTLD_NEXT, "sendmmsg");
+    syscalls++;
+    return real_sendmmsg(fd, msgs, vlen, flags);
+}
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_LOG:
+            break;
+        default:
+            assert(0);
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** feeds the sinks with the datagrams due before the next tick */
+static void generator(struct upump *upump)
+{
+    uint64_t now = uclock_now(uclock);
+    if (now > end) {
+        upump_stop(upump);
+        return;
+    }
+
+    for (unsigned int i = 0; i < nb_sinks; i++) {
+        while (next_dates[i] < now + 2 * TICK) {
+            struct uref *uref = uref_block_alloc(uref_mgr, ubuf_mgr,
+                                                 DGRAM_SIZE);
+            assert(uref != NULL);
+            uint8_t *buffer;
+            int size = -1;
+            ubase_assert(uref_block_write(uref, 0, &size, &buffer));
+            memset(buffer, 0x47, size);
+            uref_block_unmap(uref, 0);
+            uref_clock_set_cr_sys(uref, next_dates[i]);
+            upipe_input(sinks[i], uref, NULL);
+            next_dates[i] += interval;
+            packets++;
+        }
+    }
+}
+
+/** returns the CPU time used by the process, in microseconds */
+static uint64_t cpu_time(void)
+{
+    struct rusage rusage;
+    getrusage(RUSAGE_SELF, &rusage);
+    return (uint64_t)(rusage.ru_utime.tv_sec + rusage.ru_stime.tv_sec) *
+               UINT64_C(1000000) +
+           rusage.ru_utime.tv_usec + rusage.ru_stime.tv_usec;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stdout, "Usage: %s [-d <seconds>] [-r <packets/s>] [-b <batch>] [-w <window ms>] [-g] [<sinks> ...]\n", argv0);
+    fprintf(stdout, "   -g: use UDP segmentation offload in batch mode\n");
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int duration = DEFAULT_DURATION;
+    unsigned int rate = DEFAULT_RATE;
+    unsigned int batch = DEFAULT_BATCH;
+    unsigned int window = DEFAULT_WINDOW;
+    bool gso = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "d:r:b:w:g")) != -1) {
+        switch (opt) {
+            case 'd':
+                duration = strtoul(optarg, NULL, 10);
+                break;
+            case 'r':
+                rate = strtoul(optarg, NULL, 10);
+                break;
+            case 'b':
+                batch = strtoul(optarg, NULL, 10);
+                break;
+            case 'w':
+                window = strtoul(optarg, NULL, 10);
+                break;
+            case 'g':
+                gso = true;
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+    if (!rate)
+        usage(argv[0]);
+    interval = UCLOCK_FREQ / rate;
+
+    /* receiving socket, never read */
+    struct sockaddr_in sin;
+    socklen_t sin_len = sizeof(sin);
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    assert(fd != -1);
+    memset(&sin, 0, sizeof(sin));
+    sin.sin_family = AF_INET;
+    sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    assert(bind(fd, (struct sockaddr *)&sin, sizeof(sin)) == 0);
+    assert(getsockname(fd, (struct sockaddr *)&sin, &sin_len) == 0);
+    char uri[64];
+    snprintf(uri, sizeof(uri), "127.0.0.1:%u", ntohs(sin.sin_port));
+
+    struct ev_loop *loop = ev_default_loop(0);
+    struct umem_mgr *umem_mgr = umem_pool_mgr_alloc_simple(UMEM_POOL);
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr, 0);
+    assert(uref_mgr != NULL);
+    ubuf_mgr = ubuf_block_mem_mgr_alloc(UBUF_POOL_DEPTH, UBUF_POOL_DEPTH,
+                                        umem_mgr, 0, 0);
+    assert(ubuf_mgr != NULL);
+    struct upump_mgr *upump_mgr = upump_ev_mgr_alloc(loop, UPUMP_POOL,
+                                                     UPUMP_BLOCKER_POOL);
+    assert(upump_mgr != NULL);
+    uclock = uclock_std_alloc(0);
+    assert(uclock != NULL);
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+    logger = uprobe_upump_mgr_alloc(logger, upump_mgr);
+    assert(logger != NULL);
+    logger = uprobe_uclock_alloc(logger, uclock);
+    assert(logger != NULL);
+
+    struct upipe_mgr *upipe_udpsink_mgr = upipe_udpsink_mgr_alloc();
+    assert(upipe_udpsink_mgr != NULL);
+    struct uref *flow_def = uref_block_flow_alloc_def(uref_mgr, NULL);
+    assert(flow_def != NULL);
+
+    unsigned int default_sinks[] = { 1, 10, 100 };
+    unsigned int nb_runs = argc - optind;
+    if (!nb_runs)
+        nb_runs = UBASE_ARRAY_SIZE(default_sinks);
+
+    printf("%6s %6s %12s %10s %14s %12s %10s\n", "sinks", "batch",
+           "packets", "cpu (ms)", "packets/s/core", "syscalls/s",
+           "pkts/call");
+    for (unsigned int r = 0; r < nb_runs * 2; r++) {
+        nb_sinks = optind < argc ? strtoul(argv[optind + r / 2], NULL, 10)
+                                 : default_sinks[r / 2];
+        assert(nb_sinks > 0 && nb_sinks <= MAX_SINKS);
+        unsigned int run_batch = r % 2 ? batch : 1;
+
+        uint64_t now = uclock_now(uclock);
+        for (unsigned int i = 0; i < nb_sinks; i++) {
+            sinks[i] = upipe_void_alloc(upipe_udpsink_mgr,
+                    uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                                     "udp sink"));
+            assert(sinks[i] != NULL);
+            ubase_assert(upipe_set_flow_def(sinks[i], flow_def));
+            ubase_assert(upipe_attach_uclock(sinks[i]));
+            ubase_assert(upipe_udpsink_set_batch(sinks[i], run_batch,
+                        window * (UCLOCK_FREQ / 1000)));
+            if (gso && run_batch > 1)
+                upipe_udpsink_set_gso(sinks[i], true);
+            ubase_assert(upipe_set_uri(sinks[i], uri));
+            /* spread the streams over one interval */
+            next_dates[i] = now + TICK + interval * i / nb_sinks;
+        }
+        end = now + duration * UCLOCK_FREQ;
+        packets = syscalls = 0;
+
+        struct upump *timer = upump_alloc_timer(upump_mgr, generator, NULL,
+                                                NULL, 0, TICK);
+        assert(timer != NULL);
+        upump_start(timer);
+
+        uint64_t start = cpu_time();
+        now = uclock_now(uclock);
+        ev_loop(loop, 0);
+        uint64_t cpu = cpu_time() - start;
+        uint64_t wall = (uclock_now(uclock) - now) / (UCLOCK_FREQ / 1000000);
+
+        printf("%6u %6u %12"PRIu64" %10"PRIu64" %14"PRIu64" %12"PRIu64
+               " %10.1f\n", nb_sinks, run_batch, packets, cpu / 1000,
+               cpu ? packets * UINT64_C(1000000) / cpu : 0,
+               wall ? syscalls * UINT64_C(1000000) / wall : 0,
+               syscalls ? (double)packets / syscalls : 0.);
+
+        upump_free(timer);
+        for (unsigned int i = 0; i < nb_sinks; i++)
+            upipe_release(sinks[i]);
+    }
+
+    uref_free(flow_def);
+    upipe_mgr_release(upipe_udpsink_mgr); /* nop */
+    upump_mgr_release(upump_mgr);
+    ubuf_mgr_release(ubuf_mgr);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uclock_release(uclock);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+    close(fd);
+
+    ev_default_destroy();
+    return 0;
+}
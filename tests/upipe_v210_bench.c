@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short benchmark of v210 packing and unpacking
+ *
+ * The portable and vectorised implementations process UHD lines, and their
+ * outputs are checked to be identical.
+ */
+
+#undef NDEBUG
+
+#include <upipe/ubase.h>
+#include <upipe-v210/upipe_v210enc.h>
+#include <upipe-v210/upipe_v210dec.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <assert.h>
+#include <time.h>
+
+#include <libavutil/cpu.h>
+
+#define WIDTH 3840
+#define LINES 2160
+#define V210_SIZE (WIDTH / 6 * 16)
+#define DEFAULT_LOOPS 4
+
+/** CPU flags of the benchmarked implementations */
+static const struct {
+    const char *name;
+    int flags;
+} implementations[] = {
+    { "C", 0 },
+    { "SSSE3", AV_CPU_FLAG_SSSE3 },
+    { "AVX2", AV_CPU_FLAG_SSSE3 | AV_CPU_FLAG_AVX2 },
+};
+
+/** returns the monotonic time in nanoseconds */
+static uint64_t now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * UINT64_C(1000000000) + ts.tv_nsec;
+}
+
+/** prints the throughput of an implementation in lines per second */
+static void print(const char *name, uint64_t duration, unsigned int loops)
+{
+    printf("%-24s %12.0f\n", name,
+           (double)LINES * loops * 1000000000. / duration);
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stdout, "Usage: %s [-n <loops>]\n", argv0);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int loops = DEFAULT_LOOPS;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+            case 'n':
+                loops = strtoul(optarg, NULL, 10);
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+    if (!loops)
+        usage(argv[0]);
+
+    uint8_t *y8 = malloc(WIDTH * 2);
+    uint16_t *y10 = malloc(WIDTH * 2 * sizeof (uint16_t));
+    uint8_t *v210_8[2] = { malloc(V210_SIZE), malloc(V210_SIZE) };
+    uint8_t *v210[2] = { malloc(V210_SIZE), malloc(V210_SIZE) };
+    uint16_t *planar[2] = {
+        malloc(WIDTH * 2 * sizeof (uint16_t)),
+        malloc(WIDTH * 2 * sizeof (uint16_t))
+    };
+    assert(y8 != NULL && y10 != NULL && v210_8[0] != NULL &&
+           v210_8[1] != NULL && v210[0] != NULL && v210[1] != NULL &&
+           planar[0] != NULL && planar[1] != NULL);
+    srand(42);
+    for (int i = 0; i < WIDTH * 2; i++) {
+        y8[i] = rand();
+        y10[i] = rand() % 1024;
+    }
+    const uint8_t *u8 = y8 + WIDTH, *v8 = u8 + WIDTH / 2;
+    const uint16_t *u10 = y10 + WIDTH, *v10 = u10 + WIDTH / 2;
+
+    int available = av_get_cpu_flags();
+    printf("%-24s %12s\n", "implementation", "lines/s");
+    for (int i = 0; i < UBASE_ARRAY_SIZE(implementations); i++) {
+        int flags = implementations[i].flags;
+        if ((available & flags) != flags)
+            continue;
+        char name[32];
+        int k = i ? 1 : 0;
+
+        upipe_v210enc_pack_line_8 pack_8 =
+            upipe_v210enc_select_pack_line_8(flags);
+        uint64_t start = now();
+        for (unsigned int j = 0; j < loops * LINES; j++)
+            pack_8(y8, u8, v8, v210_8[k], WIDTH);
+        snprintf(name, sizeof (name), "pack 8 bits %s",
+                 implementations[i].name);
+        print(name, now() - start, loops);
+        if (k)
+            assert(!memcmp(v210_8[0], v210_8[1], V210_SIZE));
+
+        upipe_v210enc_pack_line_10 pack_10 =
+            upipe_v210enc_select_pack_line_10(flags);
+        start = now();
+        for (unsigned int j = 0; j < loops * LINES; j++)
+            pack_10(y10, u10, v10, v210[k], WIDTH);
+        snprintf(name, sizeof (name), "pack 10 bits %s",
+                 implementations[i].name);
+        print(name, now() - start, loops);
+        if (k)
+            assert(!memcmp(v210[0], v210[1], V210_SIZE));
+
+        upipe_v210dec_unpack_line_10 unpack_10 =
+            upipe_v210dec_select_unpack_line_10(flags);
+        start = now();
+        for (unsigned int j = 0; j < loops * LINES; j++)
+            unpack_10(v210[k], planar[k], planar[k] + WIDTH,
+                      planar[k] + WIDTH * 3 / 2, WIDTH);
+        snprintf(name, sizeof (name), "unpack 10 bits %s",
+                 implementations[i].name);
+        print(name, now() - start, loops);
+        if (k)
+            assert(!memcmp(planar[0], planar[1],
+                           WIDTH * 2 * sizeof (uint16_t)));
+    }
+
+    free(y8);
+    free(y10);
+    free(v210_8[0]);
+    free(v210_8[1]);
+    free(v210[0]);
+    free(v210[1]);
+    free(planar[0]);
+    free(planar[1]);
+    return 0;
+}
@@ -0,0 +1,332 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for v210enc and v210dec pipes
+ *
+ * The vectorised packing and unpacking functions are compared to the
+ * portable ones, and a picture is sent through v210enc and v210dec.
+ */
+
+#undef NDEBUG
+
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/uprobe_ubuf_mem.h>
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/ubuf.h>
+#include <upipe/ubuf_pic.h>
+#include <upipe/ubuf_pic_mem.h>
+#include <upipe/uref.h>
+#include <upipe/uref_pic.h>
+#include <upipe/uref_pic_flow.h>
+#include <upipe/uref_std.h>
+#include <upipe/upipe.h>
+#include <upipe-v210/upipe_v210enc.h>
+#include <upipe-v210/upipe_v210dec.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#include <libavutil/cpu.h>
+
+#define UDICT_POOL_DEPTH 5
+#define UREF_POOL_DEPTH 5
+#define UBUF_POOL_DEPTH 5
+#define UPROBE_LOG_LEVEL UPROBE_LOG_DEBUG
+#define MAX_WIDTH 120
+#define GUARD 64
+#define WIDTH 100
+#define HEIGHT 4
+
+/** CPU flags of the implementations to compare to the portable one */
+static const int cpu_flags[] = {
+    AV_CPU_FLAG_SSSE3,
+    AV_CPU_FLAG_SSSE3 | AV_CPU_FLAG_AVX2,
+};
+
+static struct uref *output = NULL;
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        default:
+            assert(0);
+            break;
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_NEW_FLOW_DEF:
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr,
+                                struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct upipe *upipe = malloc(sizeof(struct upipe));
+    assert(upipe != NULL);
+    upipe_init(upipe, mgr, uprobe);
+    return upipe;
+}
+
+/** helper phony pipe */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    assert(output == NULL);
+    output = uref;
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF:
+            return UBASE_ERR_NONE;
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *urequest = va_arg(args, struct urequest *);
+            return upipe_throw_provide_request(upipe, urequest);
+        }
+        case UPIPE_UNREGISTER_REQUEST:
+            return UBASE_ERR_NONE;
+        default:
+            assert(0);
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    upipe_clean(upipe);
+    free(upipe);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr v210_test_mgr = {
+    .refcount = NULL,
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
+/** checks the 8-bit packing functions on lines of the given width */
+static void check_pack_8(int flags, ptrdiff_t width)
+{
+    uint8_t y[MAX_WIDTH], u[MAX_WIDTH / 2], v[MAX_WIDTH / 2];
+    uint8_t ref[MAX_WIDTH / 12 * 32 + GUARD], dst[MAX_WIDTH / 12 * 32 + GUARD];
+    for (int i = 0; i < MAX_WIDTH; i++)
+        y[i] = rand();
+    for (int i = 0; i < MAX_WIDTH / 2; i++) {
+        u[i] = rand();
+        v[i] = rand();
+    }
+    memset(ref, 0xaa, sizeof (ref));
+    memset(dst, 0xaa, sizeof (dst));
+    upipe_v210enc_select_pack_line_8(0)(y, u, v, ref, width);
+    upipe_v210enc_select_pack_line_8(flags)(y, u, v, dst, width);
+    assert(!memcmp(ref, dst, sizeof (ref)));
+}
+
+/** checks the 10-bit packing functions on lines of the given width */
+static void check_pack_10(int flags, ptrdiff_t width)
+{
+    uint16_t y[MAX_WIDTH], u[MAX_WIDTH / 2], v[MAX_WIDTH / 2];
+    uint8_t ref[MAX_WIDTH / 6 * 16 + GUARD], dst[MAX_WIDTH / 6 * 16 + GUARD];
+    /* also out of range values, which are clipped */
+    for (int i = 0; i < MAX_WIDTH; i++)
+        y[i] = rand() % 8 ? rand() % 1024 : rand();
+    for (int i = 0; i < MAX_WIDTH / 2; i++) {
+        u[i] = rand() % 8 ? rand() % 1024 : rand();
+        v[i] = rand() % 8 ? rand() % 1024 : rand();
+    }
+    memset(ref, 0xaa, sizeof (ref));
+    memset(dst, 0xaa, sizeof (dst));
+    upipe_v210enc_select_pack_line_10(0)(y, u, v, ref, width);
+    upipe_v210enc_select_pack_line_10(flags)(y, u, v, dst, width);
+    assert(!memcmp(ref, dst, sizeof (ref)));
+}
+
+/** checks the 10-bit unpacking functions on lines of the given width */
+static void check_unpack_10(int flags, ptrdiff_t width)
+{
+    uint8_t src[MAX_WIDTH / 6 * 16];
+    for (int i = 0; i < sizeof (src); i++)
+        src[i] = rand();
+
+    uint16_t ref[MAX_WIDTH * 2 + GUARD], dst[MAX_WIDTH * 2 + GUARD];
+    memset(ref, 0xaa, sizeof (ref));
+    memset(dst, 0xaa, sizeof (dst));
+    upipe_v210dec_select_unpack_line_10(0)(src, ref, ref + MAX_WIDTH,
+            ref + MAX_WIDTH * 3 / 2, width);
+    upipe_v210dec_select_unpack_line_10(flags)(src, dst, dst + MAX_WIDTH,
+            dst + MAX_WIDTH * 3 / 2, width);
+    /* the vectorised versions may write beyond the width */
+    assert(!memcmp(ref, dst, width * sizeof (uint16_t)));
+    assert(!memcmp(ref + MAX_WIDTH, dst + MAX_WIDTH,
+                   width / 2 * sizeof (uint16_t)));
+    assert(!memcmp(ref + MAX_WIDTH * 3 / 2, dst + MAX_WIDTH * 3 / 2,
+                   width / 2 * sizeof (uint16_t)));
+}
+
+int main(int argc, char *argv[])
+{
+    int available = av_get_cpu_flags();
+    for (int i = 0; i < UBASE_ARRAY_SIZE(cpu_flags); i++) {
+        if ((available & cpu_flags[i]) != cpu_flags[i])
+            continue;
+        printf("checking CPU flags 0x%x\n", cpu_flags[i]);
+        for (ptrdiff_t width = 0; width <= MAX_WIDTH; width += 6) {
+            if (!(width % 12))
+                check_pack_8(cpu_flags[i], width);
+            check_pack_10(cpu_flags[i], width);
+            check_unpack_10(cpu_flags[i], width);
+        }
+    }
+
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr,
+                                                   0);
+    assert(uref_mgr != NULL);
+    struct ubuf_mgr *pic_mgr = ubuf_pic_mem_mgr_alloc(UBUF_POOL_DEPTH,
+            UBUF_POOL_DEPTH, umem_mgr, 1, 0, 0, 0, 0, 16, 0);
+    assert(pic_mgr != NULL);
+    ubase_assert(ubuf_pic_mem_mgr_add_plane(pic_mgr, "y10l", 1, 1, 2));
+    ubase_assert(ubuf_pic_mem_mgr_add_plane(pic_mgr, "u10l", 2, 1, 2));
+    ubase_assert(ubuf_pic_mem_mgr_add_plane(pic_mgr, "v10l", 2, 1, 2));
+
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+    logger = uprobe_ubuf_mem_alloc(logger, umem_mgr, UBUF_POOL_DEPTH,
+                                   UBUF_POOL_DEPTH);
+    assert(logger != NULL);
+
+    struct upipe *sink = upipe_void_alloc(&v210_test_mgr, uprobe_use(logger));
+    assert(sink != NULL);
+
+    struct upipe_mgr *upipe_v210enc_mgr = upipe_v210enc_mgr_alloc();
+    assert(upipe_v210enc_mgr != NULL);
+    struct upipe *v210enc = upipe_void_alloc(upipe_v210enc_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "v210enc"));
+    assert(v210enc != NULL);
+
+    struct upipe_mgr *upipe_v210dec_mgr = upipe_v210dec_mgr_alloc();
+    assert(upipe_v210dec_mgr != NULL);
+    struct upipe *v210dec = upipe_void_alloc_output(v210enc,
+            upipe_v210dec_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "v210dec"));
+    assert(v210dec != NULL);
+    ubase_assert(upipe_set_output(v210dec, sink));
+
+    struct uref *flow_def = uref_pic_flow_alloc_def(uref_mgr, 1);
+    assert(flow_def != NULL);
+    ubase_assert(uref_pic_flow_add_plane(flow_def, 1, 1, 2, "y10l"));
+    ubase_assert(uref_pic_flow_add_plane(flow_def, 2, 1, 2, "u10l"));
+    ubase_assert(uref_pic_flow_add_plane(flow_def, 2, 1, 2, "v10l"));
+    ubase_assert(uref_pic_flow_set_hsize(flow_def, WIDTH));
+    ubase_assert(uref_pic_flow_set_vsize(flow_def, HEIGHT));
+    ubase_assert(upipe_set_flow_def(v210enc, flow_def));
+    uref_free(flow_def);
+
+    /* a picture whose width is not a multiple of 6 pixels, with samples in
+     * the range preserved by v210 */
+    const char *chromas[] = { "y10l", "u10l", "v10l" };
+    struct uref *uref = uref_pic_alloc(uref_mgr, pic_mgr, WIDTH, HEIGHT);
+    assert(uref != NULL);
+    for (int i = 0; i < UBASE_ARRAY_SIZE(chromas); i++) {
+        uint8_t *buffer;
+        size_t stride;
+        uint8_t hsub;
+        ubase_assert(uref_pic_plane_write(uref, chromas[i], 0, 0, -1, -1,
+                                          &buffer));
+        ubase_assert(uref_pic_plane_size(uref, chromas[i], &stride, &hsub,
+                                         NULL, NULL));
+        for (int y = 0; y < HEIGHT; y++)
+            for (int x = 0; x < WIDTH / hsub; x++)
+                ((uint16_t *)(buffer + y * stride))[x] =
+                    4 + (y * 37 + x * 11 + i * 101) % 1016;
+        ubase_assert(uref_pic_plane_unmap(uref, chromas[i], 0, 0, -1, -1));
+    }
+    upipe_input(v210enc, uref_dup(uref), NULL);
+    assert(output != NULL);
+
+    size_t hsize, vsize;
+    ubase_assert(uref_pic_size(output, &hsize, &vsize, NULL));
+    assert(hsize == WIDTH);
+    assert(vsize == HEIGHT);
+    for (int i = 0; i < UBASE_ARRAY_SIZE(chromas); i++) {
+        const uint8_t *in, *out;
+        size_t in_stride, out_stride;
+        uint8_t hsub;
+        ubase_assert(uref_pic_plane_read(uref, chromas[i], 0, 0, -1, -1,
+                                         &in));
+        ubase_assert(uref_pic_plane_size(uref, chromas[i], &in_stride, &hsub,
+                                         NULL, NULL));
+        ubase_assert(uref_pic_plane_read(output, chromas[i], 0, 0, -1, -1,
+                                         &out));
+        ubase_assert(uref_pic_plane_size(output, chromas[i], &out_stride,
+                                         NULL, NULL, NULL));
+        for (int y = 0; y < HEIGHT; y++)
+            assert(!memcmp(in + y * in_stride, out + y * out_stride,
+                           WIDTH / hsub * sizeof (uint16_t)));
+        ubase_assert(uref_pic_plane_unmap(uref, chromas[i], 0, 0, -1, -1));
+        ubase_assert(uref_pic_plane_unmap(output, chromas[i], 0, 0, -1, -1));
+    }
+    uref_free(uref);
+    uref_free(output);
+
+    upipe_release(v210enc);
+    upipe_release(v210dec);
+    upipe_mgr_release(upipe_v210enc_mgr); // nop
+    upipe_mgr_release(upipe_v210dec_mgr); // nop
+    test_free(sink);
+
+    ubuf_mgr_release(pic_mgr);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+
+    return 0;
+}
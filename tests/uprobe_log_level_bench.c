@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short benchmark of log messages filtered by the probe hierarchy
+ *
+ * A pipe logs verbose and debug messages for every uref, like ts_demux or
+ * the framers, through the usual probe hierarchy of an application
+ * (prefix, uref manager, upump manager, ubuf manager, stdio at notice
+ * level). The cost per uref is compared with the same hierarchy ending with
+ * a probe which does not declare how it handles logs, which formats all
+ * messages as before.
+ */
+
+#undef NDEBUG
+
+#include <upipe/ubase.h>
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/uprobe_uref_mgr.h>
+#include <upipe/uprobe_upump_mgr.h>
+#include <upipe/uprobe_ubuf_mem.h>
+#include <upipe/upipe.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+#include <time.h>
+
+#define DEFAULT_UREFS 1000000
+
+/** returns the monotonic time in nanoseconds */
+static uint64_t now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * UINT64_C(1000000000) + ts.tv_nsec;
+}
+
+/** probe which does not declare how it handles logs */
+static int catch_unknown(struct uprobe *uprobe, struct upipe *upipe,
+                         int event, va_list args)
+{
+    return uprobe_throw_next(uprobe, upipe, event, args);
+}
+
+/** logs the messages of a uref */
+static void work(struct upipe *upipe, unsigned int i)
+{
+    upipe_verbose_va(upipe, "received PES of %u octets, pts %"PRIu64
+                     " dts %"PRIu64, 184 * (i % 16 + 1),
+                     (uint64_t)i * 3600, (uint64_t)i * 3600 - 1800);
+    upipe_verbose_va(upipe, "sending uref %u to output", i);
+    upipe_dbg_va(upipe, "buffer level %u/%u", i % 256, 256);
+    upipe_verbose(upipe, "sending uref to devnull");
+}
+
+/** runs the pipe and returns the cost per uref in nanoseconds */
+static double bench(struct uprobe *uprobe, unsigned int nb_urefs)
+{
+    struct upipe upipe;
+    memset(&upipe, 0, sizeof(upipe));
+    upipe.uprobe = uprobe_pfx_alloc(uprobe_use(uprobe), UPROBE_LOG_VERBOSE,
+                                    "ts demux");
+    assert(upipe.uprobe != NULL);
+
+    uint64_t start = now();
+    for (unsigned int i = 0; i < nb_urefs; i++)
+        work(&upipe, i);
+    uint64_t duration = now() - start;
+
+    uprobe_release(upipe.uprobe);
+    return (double)duration / nb_urefs;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stdout, "Usage: %s [-n <urefs>]\n", argv0);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int nb_urefs = DEFAULT_UREFS;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+            case 'n':
+                nb_urefs = strtoul(optarg, NULL, 10);
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+
+    FILE *null = fopen("/dev/null", "w");
+    assert(null != NULL);
+    struct uprobe *stdio = uprobe_stdio_alloc(NULL, null, UPROBE_LOG_NOTICE);
+    assert(stdio != NULL);
+
+    struct uprobe unknown;
+    uprobe_init(&unknown, catch_unknown, uprobe_use(stdio));
+
+    struct uprobe *gated = uprobe_use(stdio);
+    struct uprobe *ungated = &unknown;
+    for (int i = 0; i < 2; i++) {
+        struct uprobe **uprobe_p = i ? &ungated : &gated;
+        *uprobe_p = uprobe_ubuf_mem_alloc(*uprobe_p, NULL, 0, 0);
+        *uprobe_p = uprobe_upump_mgr_alloc(*uprobe_p, NULL);
+        *uprobe_p = uprobe_uref_mgr_alloc(*uprobe_p, NULL);
+        assert(*uprobe_p != NULL);
+    }
+
+    double ungated_cost = bench(ungated, nb_urefs);
+    double gated_cost = bench(gated, nb_urefs);
+    printf("4 filtered messages per uref, stdio at notice level\n");
+    printf("formatted: %8.1f ns per uref\n", ungated_cost);
+    printf("gated:     %8.1f ns per uref\n", gated_cost);
+
+    uprobe_release(gated);
+    uprobe_release(ungated);
+    uprobe_clean(&unknown);
+    uprobe_release(stdio);
+    fclose(null);
+    return 0;
+}
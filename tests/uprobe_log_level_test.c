@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for the minimum log level of probe hierarchies
+ */
+
+#undef NDEBUG
+
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/uprobe_loglevel.h>
+#include <upipe/uprobe_uref_mgr.h>
+#include <upipe/ulog.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+
+/** number of messages received by the sink */
+static unsigned int nb_logs = 0;
+/** true if the last message was deferred */
+static bool last_deferred = false;
+/** last message */
+static char last_msg[64];
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    if (event != UPROBE_LOG)
+        return uprobe_throw_next(uprobe, upipe, event, args);
+
+    struct ulog *ulog = va_arg(args, struct ulog *);
+    assert(ulog->level >= uprobe->log_level);
+    char buffer[ulog_msg_size(ulog)];
+    const char *msg = ulog_msg(ulog, buffer, sizeof(buffer));
+    last_deferred = ulog->msg == NULL;
+    snprintf(last_msg, sizeof(last_msg), "%s", msg);
+    nb_logs++;
+    return UBASE_ERR_NONE;
+}
+
+int main(int argc, char **argv)
+{
+    bool deferred;
+    struct uprobe sink;
+    uprobe_init(&sink, catch, NULL);
+
+    /* a probe of unknown kind receives all messages, formatted */
+    assert(uprobe_log_min_level(&sink, &deferred) == UPROBE_LOG_VERBOSE);
+    assert(!deferred);
+    uprobe_verbose_va(&sink, NULL, "verbose %d", 1);
+    assert(nb_logs == 1);
+    assert(!last_deferred);
+    assert(!strcmp(last_msg, "verbose 1"));
+
+    /* a sink only receives messages of its level, unformatted */
+    uprobe_set_log_mode(&sink, UPROBE_LOG_MODE_SINK, UPROBE_LOG_NOTICE);
+    assert(uprobe_log_min_level(&sink, &deferred) == UPROBE_LOG_NOTICE);
+    assert(deferred);
+    uprobe_verbose_va(&sink, NULL, "verbose %d", 2);
+    uprobe_dbg(&sink, NULL, "debug");
+    assert(nb_logs == 1);
+    uprobe_notice_va(&sink, NULL, "notice %d %s", 3, "deferred");
+    assert(nb_logs == 2);
+    assert(last_deferred);
+    assert(!strcmp(last_msg, "notice 3 deferred"));
+    uprobe_err(&sink, NULL, "error");
+    assert(nb_logs == 3);
+    assert(!last_deferred);
+    assert(!strcmp(last_msg, "error"));
+
+    /* forwarding probes */
+    struct uprobe *uprobe = uprobe_uref_mgr_alloc(&sink, NULL);
+    assert(uprobe != NULL);
+    uprobe = uprobe_pfx_alloc(uprobe, UPROBE_LOG_DEBUG, "pfx");
+    assert(uprobe != NULL);
+    assert(uprobe_log_min_level(uprobe, &deferred) == UPROBE_LOG_NOTICE);
+    assert(deferred);
+    uprobe_warn_va(uprobe, NULL, "warning %d", 4);
+    assert(nb_logs == 4);
+    assert(last_deferred);
+    assert(!strcmp(last_msg, "warning 4"));
+    uprobe_release(uprobe);
+
+    uprobe = uprobe_pfx_alloc(&sink, UPROBE_LOG_ERROR, "pfx");
+    assert(uprobe != NULL);
+    assert(uprobe_log_min_level(uprobe, NULL) == UPROBE_LOG_ERROR);
+    uprobe_warn_va(uprobe, NULL, "warning %d", 5);
+    assert(nb_logs == 4);
+    uprobe_release(uprobe);
+
+    /* patterns of uprobe_loglevel lower the level */
+    uprobe_set_log_mode(&sink, UPROBE_LOG_MODE_SINK, UPROBE_LOG_VERBOSE);
+    uprobe = uprobe_loglevel_alloc(&sink, UPROBE_LOG_ERROR);
+    assert(uprobe != NULL);
+    assert(uprobe_log_min_level(uprobe, NULL) == UPROBE_LOG_ERROR);
+    ubase_assert(uprobe_loglevel_set(uprobe, "^pfx$", UPROBE_LOG_DEBUG));
+    assert(uprobe_log_min_level(uprobe, NULL) == UPROBE_LOG_DEBUG);
+    struct uprobe *uprobe_pfx = uprobe_pfx_alloc(uprobe, UPROBE_LOG_VERBOSE,
+                                                 "pfx");
+    assert(uprobe_pfx != NULL);
+    uprobe_verbose_va(uprobe_pfx, NULL, "verbose %d", 6);
+    assert(nb_logs == 4);
+    uprobe_dbg_va(uprobe_pfx, NULL, "debug %d", 7);
+    assert(nb_logs == 5);
+    assert(last_deferred);
+    assert(!strcmp(last_msg, "debug 7"));
+    uprobe_release(uprobe_pfx);
+
+    /* nobody handles log messages */
+    assert(uprobe_log_min_level(NULL, &deferred) == UPROBE_LOG_ERROR);
+    assert(!deferred);
+
+    uprobe_clean(&sink);
+    return 0;
+}
@@ -29,6 +29,7 @@
 
 #undef NDEBUG
 
+#include <upipe/uclock.h>
 #include <upipe/upump.h>
 #include <upipe/upump_blocker.h>
 #include <upump-ev/upump_ev.h>
@@ -60,6 +61,10 @@ static struct upump *write_watcher;
 static struct upump *read_watcher;
 static struct upump_blocker *blocker = NULL;
 static ssize_t bytes_written = 0, bytes_read = 0;
+/* number of triggers of the repeating timer of the wheel */
+#define NB_REPEATS 5
+static unsigned int nb_repeats = 0;
+static bool oneshot_passed = false;
 
 static void blocker_cb(struct upump_blocker *blocker)
 {
@@ -108,6 +113,21 @@ static void read_watcher_cb(struct upump *unused)
     }
 }
 
+static void repeat_timer_cb(struct upump *upump)
+{
+    if (++nb_repeats == NB_REPEATS) {
+        printf("wheel repeat timer passed\n");
+        upump_stop(upump);
+    }
+}
+
+static void oneshot_timer_cb(struct upump *upump)
+{
+    printf("wheel one-shot timer passed\n");
+    assert(nb_repeats == NB_REPEATS);
+    oneshot_passed = true;
+}
+
 int main(int argc, char **argv)
 {
     long flags;
@@ -147,6 +167,29 @@ int main(int argc, char **argv)
     upump_free(read_watcher);
     upump_mgr_release(mgr);
 
+    /* Timer wheel */
+    mgr = upump_ev_mgr_alloc(loop, UPUMP_POOL, UPUMP_BLOCKER_POOL);
+    assert(mgr != NULL);
+    ubase_assert(upump_mgr_set_timer_slack(mgr, UCLOCK_FREQ / 1000));
+    struct upump *repeat_timer = upump_alloc_timer(mgr, repeat_timer_cb,
+            NULL, NULL, timeout / 100, timeout / 100);
+    assert(repeat_timer != NULL);
+    struct upump *oneshot_timer = upump_alloc_timer(mgr, oneshot_timer_cb,
+            NULL, NULL, timeout / 100 * (NB_REPEATS + 1), 0);
+    assert(oneshot_timer != NULL);
+    upump_start(repeat_timer);
+    upump_start(oneshot_timer);
+    ubase_nassert(upump_mgr_set_timer_slack(mgr, 0));
+    ev_tstamp start = ev_now(loop);
+    ev_loop(loop, 0);
+    assert(nb_repeats == NB_REPEATS);
+    assert(oneshot_passed);
+    assert(ev_now(loop) - start >= 0.01 * (NB_REPEATS + 1) - 1e-6);
+    upump_free(repeat_timer);
+    upump_free(oneshot_timer);
+    ubase_assert(upump_mgr_set_timer_slack(mgr, 0));
+    upump_mgr_release(mgr);
+
     ev_default_destroy();
     return 0;
 }
@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short benchmark of upump_ev timers, with and without a timer wheel
+ *
+ * Many concurrent timers are first started and stopped in a loop, to measure
+ * the cost of arming them. Then they are all started with short repeating
+ * periods, like the timers of udp sinks or rate limiters, and the event loop
+ * runs for a while to measure the cost of each expiry.
+ */
+
+#undef NDEBUG
+
+#include <upipe/uclock.h>
+#include <upipe/upump.h>
+#include <upump-ev/upump_ev.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <assert.h>
+#include <time.h>
+
+#include <ev.h>
+
+#define UPUMP_POOL 0
+#define UPUMP_BLOCKER_POOL 0
+/** default number of concurrent timers */
+#define DEFAULT_TIMERS 10000
+/** number of start/stop rounds */
+#define NB_ROUNDS 100
+/** duration of the run */
+#define DURATION UCLOCK_FREQ
+/** slack of the timer wheel */
+#define SLACK (UCLOCK_FREQ / 1000)
+
+static unsigned int nb_timers = DEFAULT_TIMERS;
+static struct upump **timers;
+static uint64_t nb_expired;
+
+/** returns the CPU time of the process in nanoseconds */
+static uint64_t cputime(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * UINT64_C(1000000000) + ts.tv_nsec;
+}
+
+static void timer_cb(struct upump *upump)
+{
+    nb_expired++;
+}
+
+static void stop_cb(struct upump *upump)
+{
+    for (unsigned int i = 0; i < nb_timers; i++)
+        upump_stop(timers[i]);
+}
+
+static void bench(const char *name, uint64_t slack)
+{
+    struct ev_loop *loop = ev_loop_new(0);
+    assert(loop != NULL);
+    struct upump_mgr *mgr = upump_ev_mgr_alloc(loop, UPUMP_POOL,
+                                               UPUMP_BLOCKER_POOL);
+    assert(mgr != NULL);
+    if (slack)
+        ubase_assert(upump_mgr_set_timer_slack(mgr, slack));
+
+    srand(0);
+    for (unsigned int i = 0; i < nb_timers; i++) {
+        /* periods between 1 and 20 ms */
+        uint64_t period = UCLOCK_FREQ / 1000 * (1 + rand() % 20);
+        timers[i] = upump_alloc_timer(mgr, timer_cb, NULL, NULL, period,
+                                      period);
+        assert(timers[i] != NULL);
+    }
+
+    uint64_t start = cputime();
+    for (unsigned int round = 0; round < NB_ROUNDS; round++) {
+        for (unsigned int i = 0; i < nb_timers; i++)
+            upump_start(timers[i]);
+        for (unsigned int i = 0; i < nb_timers; i++)
+            upump_stop(timers[i]);
+    }
+    uint64_t arm = cputime() - start;
+
+    for (unsigned int i = 0; i < nb_timers; i++)
+        upump_start(timers[i]);
+    struct upump *stop = upump_alloc_timer(mgr, stop_cb, NULL, NULL,
+                                           DURATION, 0);
+    assert(stop != NULL);
+    upump_start(stop);
+
+    nb_expired = 0;
+    start = cputime();
+    ev_run(loop, 0);
+    uint64_t run = cputime() - start;
+    assert(nb_expired);
+
+    printf("%-10s %14.1f %12"PRIu64" %12.1f\n", name,
+           (double)arm / (NB_ROUNDS * nb_timers), nb_expired,
+           (double)run / nb_expired);
+
+    upump_free(stop);
+    for (unsigned int i = 0; i < nb_timers; i++)
+        upump_free(timers[i]);
+    upump_mgr_release(mgr);
+    ev_loop_destroy(loop);
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stdout, "Usage: %s [-n <timers>]\n", argv0);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv)
+{
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+            case 'n':
+                nb_timers = strtoul(optarg, NULL, 10);
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+    if (!nb_timers)
+        usage(argv[0]);
+
+    timers = malloc(sizeof(struct upump *) * nb_timers);
+    assert(timers != NULL);
+
+    printf("%u timers\n", nb_timers);
+    printf("%-10s %14s %12s %12s\n", "timers in", "ns/start+stop", "expiries",
+           "ns/expiry");
+    bench("ev", 0);
+    bench("wheel", SLACK);
+
+    free(timers);
+    return 0;
+}
@@ -0,0 +1,428 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short scaling benchmark of upump managers run by a pool of threads
+ *
+ * K independent pipelines each demux a TS file, frame its elementary streams
+ * and mux them again. Every pipeline has its own upump manager, and the
+ * pipelines are run on pools of 1 to N threads.
+ */
+
+#undef NDEBUG
+
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/uprobe_uref_mgr.h>
+#include <upipe/uprobe_upump_mgr.h>
+#include <upipe/uprobe_ubuf_mem.h>
+#include <upipe/umem.h>
+#include <upipe/umem_alloc.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/uref.h>
+#include <upipe/uref_flow.h>
+#include <upipe/uref_std.h>
+#include <upipe/upump.h>
+#include <upump-tpool/upump_tpool.h>
+#include <upipe/upipe.h>
+#include <upipe-ts/upipe_ts_demux.h>
+#include <upipe-ts/upipe_ts_mux.h>
+#include <upipe-framers/upipe_mpgv_framer.h>
+#include <upipe-framers/upipe_h264_framer.h>
+#include <upipe-framers/upipe_h265_framer.h>
+#include <upipe-framers/upipe_mpga_framer.h>
+#include <upipe-framers/upipe_a52_framer.h>
+#include <upipe-modules/upipe_file_source.h>
+#include <upipe-modules/upipe_noclock.h>
+#include <upipe-modules/upipe_null.h>
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <time.h>
+#include <assert.h>
+
+#define UDICT_POOL_DEPTH 0
+#define UREF_POOL_DEPTH 0
+#define UBUF_POOL_DEPTH 0
+#define UPUMP_POOL 0
+#define UPUMP_BLOCKER_POOL 0
+#define READ_SIZE 4096
+#define DEFAULT_PROGRAMS 16
+#define UPROBE_LOG_LEVEL UPROBE_LOG_ERROR
+
+/** independent pipeline */
+struct program {
+    /** upump manager of the pipeline */
+    struct upump_mgr *upump_mgr;
+    /** probe hierarchy of the pipeline */
+    struct uprobe *logger;
+    /** probe catching the end of the file source */
+    struct uprobe uprobe_src_s;
+    /** probe of the demux */
+    struct uprobe uprobe_demux_s;
+    /** probe of the demux programs */
+    struct uprobe uprobe_demux_program_s;
+    /** probe of the demux outputs */
+    struct uprobe uprobe_demux_output_s;
+};
+
+static const char *src_file;
+static struct uprobe *logger;
+static struct upipe_mgr *upipe_fsrc_mgr;
+static struct upipe_mgr *upipe_ts_demux_mgr;
+static struct upipe_mgr *upipe_ts_mux_mgr;
+static struct upipe_mgr *upipe_noclock_mgr;
+static struct upipe_mgr *upipe_null_mgr;
+
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    assert(event != UPROBE_FATAL);
+    return UBASE_ERR_NONE;
+}
+
+static int catch_src(struct uprobe *uprobe, struct upipe *upipe,
+                     int event, va_list args)
+{
+    if (event == UPROBE_SOURCE_END) {
+        upipe_release(upipe);
+        return UBASE_ERR_NONE;
+    }
+    return uprobe_throw_next(uprobe, upipe, event, args);
+}
+
+static int catch_ts_demux_output(struct uprobe *uprobe, struct upipe *upipe,
+                                 int event, va_list args)
+{
+    if (event == UPROBE_SOURCE_END) {
+        upipe_release(upipe);
+        return UBASE_ERR_NONE;
+    }
+    return uprobe_throw_next(uprobe, upipe, event, args);
+}
+
+static int catch_ts_demux_program(struct uprobe *uprobe, struct upipe *upipe,
+                                  int event, va_list args)
+{
+    struct program *program =
+        container_of(uprobe, struct program, uprobe_demux_program_s);
+    switch (event) {
+        case UPROBE_SOURCE_END:
+            upipe_release(upipe);
+            return UBASE_ERR_NONE;
+
+        case UPROBE_SPLIT_UPDATE: {
+            struct uref *flow_def = NULL;
+            while (ubase_check(upipe_split_iterate(upipe, &flow_def)) &&
+                   flow_def != NULL) {
+                uint64_t flow_id;
+                ubase_assert(uref_flow_get_id(flow_def, &flow_id));
+
+                struct upipe *output = NULL;
+                bool found = false;
+                while (ubase_check(upipe_iterate_sub(upipe, &output)) &&
+                       output != NULL) {
+                    struct uref *flow_def2;
+                    uint64_t id2;
+                    if (ubase_check(upipe_get_flow_def(output, &flow_def2)) &&
+                        ubase_check(uref_flow_get_id(flow_def2, &id2)) &&
+                        flow_id == id2) {
+                        found = true;
+                        break;
+                    }
+                }
+                if (found)
+                    continue;
+
+                output = upipe_flow_alloc_sub(upipe,
+                    uprobe_pfx_alloc_va(
+                        uprobe_use(&program->uprobe_demux_output_s),
+                        UPROBE_LOG_LEVEL, "ts demux output %"PRIu64, flow_id),
+                    flow_def);
+                assert(output != NULL);
+                output = upipe_void_chain_output(output, upipe_noclock_mgr,
+                    uprobe_pfx_alloc_va(uprobe_use(program->logger),
+                                        UPROBE_LOG_LEVEL,
+                                        "noclock %"PRIu64, flow_id));
+                assert(output != NULL);
+
+                struct upipe *upipe_ts_mux_program;
+                ubase_assert(upipe_get_output(upipe, &upipe_ts_mux_program));
+                output = upipe_void_chain_output_sub(output,
+                        upipe_ts_mux_program,
+                        uprobe_pfx_alloc_va(uprobe_use(program->logger),
+                                            UPROBE_LOG_LEVEL,
+                                            "mux input %"PRIu64, flow_id));
+                assert(output != NULL);
+                upipe_release(output);
+            }
+            return UBASE_ERR_NONE;
+        }
+        default:
+            return uprobe_throw_next(uprobe, upipe, event, args);
+    }
+}
+
+static int catch_ts_demux(struct uprobe *uprobe, struct upipe *upipe,
+                          int event, va_list args)
+{
+    struct program *program =
+        container_of(uprobe, struct program, uprobe_demux_s);
+    if (event != UPROBE_SPLIT_UPDATE)
+        return uprobe_throw_next(uprobe, upipe, event, args);
+
+    struct uref *flow_def = NULL;
+    while (ubase_check(upipe_split_iterate(upipe, &flow_def)) &&
+           flow_def != NULL) {
+        uint64_t flow_id;
+        ubase_assert(uref_flow_get_id(flow_def, &flow_id));
+
+        struct upipe *sub = NULL;
+        bool found = false;
+        while (ubase_check(upipe_iterate_sub(upipe, &sub)) && sub != NULL) {
+            struct uref *flow_def2;
+            uint64_t id2;
+            if (ubase_check(upipe_get_flow_def(sub, &flow_def2)) &&
+                ubase_check(uref_flow_get_id(flow_def2, &id2)) &&
+                flow_id == id2) {
+                found = true;
+                break;
+            }
+        }
+        if (found)
+            continue;
+
+        sub = upipe_flow_alloc_sub(upipe,
+            uprobe_pfx_alloc_va(uprobe_use(&program->uprobe_demux_program_s),
+                                UPROBE_LOG_LEVEL,
+                                "ts demux program %"PRIu64, flow_id),
+            flow_def);
+        assert(sub != NULL);
+
+        struct upipe *upipe_ts_mux;
+        ubase_assert(upipe_get_output(upipe, &upipe_ts_mux));
+        assert(upipe_ts_mux != NULL);
+
+        sub = upipe_void_alloc_output_sub(sub, upipe_ts_mux,
+                uprobe_pfx_alloc_va(uprobe_use(program->logger),
+                                    UPROBE_LOG_LEVEL,
+                                    "ts mux program %"PRIu64, flow_id));
+        assert(sub != NULL);
+        ubase_assert(upipe_ts_mux_set_version(sub, 1));
+        upipe_release(sub);
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** builds the pipeline of a program on its own upump manager */
+static void program_init(struct program *program, struct upump_tpool *tpool)
+{
+    program->upump_mgr = upump_tpool_mgr_alloc(tpool, UPUMP_POOL,
+                                               UPUMP_BLOCKER_POOL);
+    assert(program->upump_mgr != NULL);
+    program->logger = uprobe_upump_mgr_alloc(uprobe_use(logger),
+                                             program->upump_mgr);
+    assert(program->logger != NULL);
+    uprobe_init(&program->uprobe_src_s, catch_src,
+                uprobe_use(program->logger));
+    uprobe_init(&program->uprobe_demux_s, catch_ts_demux,
+                uprobe_use(program->logger));
+    uprobe_init(&program->uprobe_demux_program_s, catch_ts_demux_program,
+                uprobe_use(program->logger));
+    uprobe_init(&program->uprobe_demux_output_s, catch_ts_demux_output,
+                uprobe_use(program->logger));
+
+    struct upipe *upipe_fsrc = upipe_void_alloc(upipe_fsrc_mgr,
+            uprobe_pfx_alloc(uprobe_use(&program->uprobe_src_s),
+                             UPROBE_LOG_LEVEL, "file source"));
+    assert(upipe_fsrc != NULL);
+    ubase_assert(upipe_set_output_size(upipe_fsrc, READ_SIZE));
+    ubase_assert(upipe_set_uri(upipe_fsrc, src_file));
+
+    struct upipe *upipe = upipe_void_alloc_output(upipe_fsrc,
+            upipe_ts_demux_mgr,
+            uprobe_pfx_alloc(uprobe_use(&program->uprobe_demux_s),
+                             UPROBE_LOG_LEVEL, "ts demux"));
+    assert(upipe != NULL);
+    ubase_assert(upipe_ts_demux_set_conformance(upipe,
+                                                UPIPE_TS_CONFORMANCE_ISO));
+
+    upipe = upipe_void_chain_output(upipe, upipe_ts_mux_mgr,
+            uprobe_pfx_alloc(uprobe_use(program->logger),
+                             UPROBE_LOG_LEVEL, "ts mux"));
+    assert(upipe != NULL);
+    ubase_assert(upipe_ts_mux_set_mode(upipe, UPIPE_TS_MUX_MODE_CAPPED));
+    ubase_assert(upipe_ts_mux_set_version(upipe, 1));
+    ubase_assert(upipe_ts_mux_set_cr_prog(upipe, 0));
+
+    upipe = upipe_void_chain_output(upipe, upipe_null_mgr,
+            uprobe_pfx_alloc(uprobe_use(program->logger),
+                             UPROBE_LOG_LEVEL, "null"));
+    assert(upipe != NULL);
+    upipe_release(upipe);
+}
+
+/** releases the probes and the upump manager of a program */
+static void program_clean(struct program *program)
+{
+    uprobe_clean(&program->uprobe_src_s);
+    uprobe_clean(&program->uprobe_demux_s);
+    uprobe_clean(&program->uprobe_demux_program_s);
+    uprobe_clean(&program->uprobe_demux_output_s);
+    uprobe_release(program->logger);
+    upump_mgr_release(program->upump_mgr);
+}
+
+/** returns the wall clock time, in microseconds */
+static uint64_t wall_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * UINT64_C(1000000) + ts.tv_nsec / 1000;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stdout, "Usage: %s [-k <programs>] [-n <max threads>] <ts file>\n",
+            argv0);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int nb_programs = DEFAULT_PROGRAMS;
+    long max_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    int opt;
+    while ((opt = getopt(argc, argv, "k:n:")) != -1) {
+        switch (opt) {
+            case 'k':
+                nb_programs = strtoul(optarg, NULL, 10);
+                break;
+            case 'n':
+                max_threads = strtol(optarg, NULL, 10);
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+    if (optind >= argc || !nb_programs || max_threads < 1)
+        usage(argv[0]);
+    src_file = argv[optind];
+
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH,
+                                                   udict_mgr, 0);
+    assert(uref_mgr != NULL);
+
+    struct uprobe uprobe_s;
+    uprobe_init(&uprobe_s, catch, NULL);
+    logger = uprobe_stdio_alloc(&uprobe_s, stdout, UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+    logger = uprobe_uref_mgr_alloc(logger, uref_mgr);
+    assert(logger != NULL);
+    logger = uprobe_ubuf_mem_alloc(logger, umem_mgr, UBUF_POOL_DEPTH,
+                                   UBUF_POOL_DEPTH);
+    assert(logger != NULL);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+
+    upipe_fsrc_mgr = upipe_fsrc_mgr_alloc();
+    assert(upipe_fsrc_mgr != NULL);
+    upipe_noclock_mgr = upipe_noclock_mgr_alloc();
+    assert(upipe_noclock_mgr != NULL);
+    upipe_null_mgr = upipe_null_mgr_alloc();
+    assert(upipe_null_mgr != NULL);
+    upipe_ts_mux_mgr = upipe_ts_mux_mgr_alloc();
+    assert(upipe_ts_mux_mgr != NULL);
+
+    struct upipe_mgr *upipe_mpgvf_mgr = upipe_mpgvf_mgr_alloc();
+    assert(upipe_mpgvf_mgr != NULL);
+    struct upipe_mgr *upipe_h264f_mgr = upipe_h264f_mgr_alloc();
+    assert(upipe_h264f_mgr != NULL);
+    struct upipe_mgr *upipe_h265f_mgr = upipe_h265f_mgr_alloc();
+    assert(upipe_h265f_mgr != NULL);
+    struct upipe_mgr *upipe_mpgaf_mgr = upipe_mpgaf_mgr_alloc();
+    assert(upipe_mpgaf_mgr != NULL);
+    struct upipe_mgr *upipe_a52f_mgr = upipe_a52f_mgr_alloc();
+    assert(upipe_a52f_mgr != NULL);
+    upipe_ts_demux_mgr = upipe_ts_demux_mgr_alloc();
+    assert(upipe_ts_demux_mgr != NULL);
+    ubase_assert(upipe_ts_demux_mgr_set_mpgvf_mgr(upipe_ts_demux_mgr,
+                                                  upipe_mpgvf_mgr));
+    ubase_assert(upipe_ts_demux_mgr_set_h264f_mgr(upipe_ts_demux_mgr,
+                                                  upipe_h264f_mgr));
+    ubase_assert(upipe_ts_demux_mgr_set_h265f_mgr(upipe_ts_demux_mgr,
+                                                  upipe_h265f_mgr));
+    ubase_assert(upipe_ts_demux_mgr_set_mpgaf_mgr(upipe_ts_demux_mgr,
+                                                  upipe_mpgaf_mgr));
+    ubase_assert(upipe_ts_demux_mgr_set_a52f_mgr(upipe_ts_demux_mgr,
+                                                 upipe_a52f_mgr));
+    upipe_mgr_release(upipe_mpgvf_mgr);
+    upipe_mgr_release(upipe_h264f_mgr);
+    upipe_mgr_release(upipe_h265f_mgr);
+    upipe_mgr_release(upipe_mpgaf_mgr);
+    upipe_mgr_release(upipe_a52f_mgr);
+
+    struct program programs[nb_programs];
+    uint64_t reference = 0;
+    printf("%u programs\n", nb_programs);
+    printf("%8s %10s %8s %8s\n", "threads", "wall (ms)", "speedup", "steals");
+    for (long nb_threads = 1; nb_threads <= max_threads; nb_threads++) {
+        struct upump_tpool *tpool = upump_tpool_alloc(nb_threads);
+        assert(tpool != NULL);
+        for (unsigned int i = 0; i < nb_programs; i++)
+            program_init(&programs[i], tpool);
+
+        uint64_t wall = wall_time();
+        ubase_assert(upump_tpool_run(tpool));
+        wall = wall_time() - wall;
+        if (nb_threads == 1)
+            reference = wall;
+        printf("%8ld %10"PRIu64" %8.2f %8"PRIu64"\n", nb_threads, wall / 1000,
+               wall ? (double)reference / wall : 0.,
+               upump_tpool_get_steals(tpool));
+
+        for (unsigned int i = 0; i < nb_programs; i++)
+            program_clean(&programs[i]);
+        upump_tpool_release(tpool);
+    }
+
+    upipe_mgr_release(upipe_ts_demux_mgr);
+    upipe_mgr_release(upipe_ts_mux_mgr);
+    upipe_mgr_release(upipe_null_mgr);
+    upipe_mgr_release(upipe_noclock_mgr);
+    upipe_mgr_release(upipe_fsrc_mgr);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe_s);
+    return 0;
+}
@@ -0,0 +1,278 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for upump managers run by a pool of threads
+ */
+
+#undef NDEBUG
+
+#include <upipe/uatomic.h>
+#include <upipe/upump.h>
+#include <upipe/upump_blocker.h>
+#include <upump-tpool/upump_tpool.h>
+
+#include <stdio.h>
+#include <inttypes.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <assert.h>
+
+#define UPUMP_POOL 1
+#define UPUMP_BLOCKER_POOL 1
+/* number of worker threads */
+#define NB_THREADS 4
+/* number of independent managers */
+#define NB_MGRS 16
+/* number of iterations of the idlers of each manager */
+#define NB_IDLES 2000
+/* number of triggers of the repeating timers */
+#define NB_REPEATS 5
+
+static uint64_t timeout = UINT64_C(27000000); /* 1 s */
+static const char *padding = "This is an initialized bit of space used to pad sufficiently !";
+/* This is an arbitrarily large number that is just supposed to be bigger than
+ * the buffer space of a pipe. */
+#define MIN_READ (128*1024)
+
+static int pipefd[2];
+static struct upump_mgr *mgr;
+static struct upump *write_idler;
+static struct upump *read_timer;
+static struct upump *write_watcher;
+static struct upump *read_watcher;
+static struct upump_blocker *blocker = NULL;
+static ssize_t bytes_written = 0, bytes_read = 0;
+
+/** independent pipeline */
+struct context {
+    /** manager of the pipeline */
+    struct upump_mgr *mgr;
+    /** set while a pump of the manager is dispatched */
+    uatomic_uint32_t busy;
+    /** pipe between the idlers and the reader */
+    int pipefd[2];
+    /** pumps */
+    struct upump *idlers[2];
+    struct upump *reader;
+    struct upump *timer;
+    /** counters */
+    unsigned int nb_idles;
+    unsigned int nb_repeats;
+    size_t nb_written;
+    size_t nb_read;
+};
+
+static struct context contexts[NB_MGRS];
+
+static void blocker_cb(struct upump_blocker *blocker)
+{
+    upump_blocker_free(blocker);
+}
+
+static void write_idler_cb(struct upump *upump)
+{
+    ssize_t ret = write(pipefd[1], padding, strlen(padding) + 1);
+    if (ret == -1 && (errno == EWOULDBLOCK || errno == EAGAIN)) {
+        printf("write idler blocked\n");
+        blocker = upump_blocker_alloc(write_idler, blocker_cb, NULL, NULL);
+        assert(blocker != NULL);
+        upump_start(write_watcher);
+        upump_start(read_timer);
+    } else {
+        assert(ret != -1);
+        bytes_written += ret;
+    }
+}
+
+static void write_watcher_cb(struct upump *unused)
+{
+    printf("write watcher passed\n");
+    upump_blocker_free(blocker);
+    upump_stop(write_watcher);
+}
+
+static void read_timer_cb(struct upump *unused)
+{
+    printf("read timer passed\n");
+    upump_start(read_watcher);
+    /* The timer is automatically stopped */
+}
+
+static void read_watcher_cb(struct upump *unused)
+{
+    char buffer[strlen(padding) + 1];
+    ssize_t ret = read(pipefd[0], buffer, strlen(padding) + 1);
+    assert(ret != -1);
+    bytes_read += ret;
+    if (bytes_read > MIN_READ) {
+        printf("read watcher passed\n");
+        upump_stop(write_idler);
+        upump_stop(read_watcher);
+    }
+}
+
+/* checks that the pumps of a manager are never dispatched concurrently */
+static void context_enter(struct context *context)
+{
+    uint32_t expected = 0;
+    assert(uatomic_compare_exchange(&context->busy, &expected, 1));
+}
+
+static void context_leave(struct context *context)
+{
+    uatomic_store(&context->busy, 0);
+}
+
+static void context_idler_cb(struct upump *upump)
+{
+    struct context *context = upump_get_opaque(upump, struct context *);
+    context_enter(context);
+    if (write(context->pipefd[1], "x", 1) == 1)
+        context->nb_written++;
+    if (++context->nb_idles >= NB_IDLES) {
+        upump_stop(context->idlers[0]);
+        upump_stop(context->idlers[1]);
+    }
+    context_leave(context);
+}
+
+static void context_reader_cb(struct upump *upump)
+{
+    struct context *context = upump_get_opaque(upump, struct context *);
+    context_enter(context);
+    char buffer[256];
+    ssize_t ret = read(context->pipefd[0], buffer, sizeof(buffer));
+    if (ret > 0)
+        context->nb_read += ret;
+    if (context->nb_idles >= NB_IDLES &&
+        context->nb_read == context->nb_written)
+        upump_stop(upump);
+    context_leave(context);
+}
+
+static void context_timer_cb(struct upump *upump)
+{
+    struct context *context = upump_get_opaque(upump, struct context *);
+    context_enter(context);
+    if (++context->nb_repeats == NB_REPEATS)
+        upump_stop(upump);
+    context_leave(context);
+}
+
+int main(int argc, char **argv)
+{
+    long flags;
+    struct upump_tpool *tpool = upump_tpool_alloc(NB_THREADS);
+    assert(tpool != NULL);
+    mgr = upump_tpool_mgr_alloc(tpool, UPUMP_POOL, UPUMP_BLOCKER_POOL);
+    assert(mgr != NULL);
+
+    /* Create a pipe with non-blocking write */
+    assert(pipe(pipefd) != -1);
+    flags = fcntl(pipefd[1], F_GETFL);
+    assert(flags != -1);
+    flags |= O_NONBLOCK;
+    assert(fcntl(pipefd[1], F_SETFL, flags) != -1);
+
+    /* Create watchers */
+    write_idler = upump_alloc_idler(mgr, write_idler_cb, NULL, NULL);
+    assert(write_idler != NULL);
+    write_watcher = upump_alloc_fd_write(mgr, write_watcher_cb, NULL, NULL,
+                                         pipefd[1]);
+    assert(write_watcher != NULL);
+    read_timer = upump_alloc_timer(mgr, read_timer_cb, NULL, NULL, timeout, 0);
+    assert(read_timer != NULL);
+    read_watcher = upump_alloc_fd_read(mgr, read_watcher_cb, NULL, NULL,
+                                       pipefd[0]);
+    assert(read_watcher != NULL);
+
+    /* Start tests */
+    upump_start(write_idler);
+    ubase_assert(upump_tpool_run(tpool));
+    assert(bytes_read);
+    assert(bytes_read == bytes_written);
+
+    upump_free(write_idler);
+    upump_free(write_watcher);
+    upump_free(read_timer);
+    upump_free(read_watcher);
+    upump_mgr_release(mgr);
+    close(pipefd[0]);
+    close(pipefd[1]);
+
+    /* Run independent managers in parallel */
+    for (int i = 0; i < NB_MGRS; i++) {
+        struct context *context = &contexts[i];
+        context->mgr = upump_tpool_mgr_alloc(tpool, UPUMP_POOL,
+                                             UPUMP_BLOCKER_POOL);
+        assert(context->mgr != NULL);
+        uatomic_init(&context->busy, 0);
+        assert(pipe(context->pipefd) != -1);
+        assert(fcntl(context->pipefd[0], F_SETFL, O_NONBLOCK) != -1);
+        assert(fcntl(context->pipefd[1], F_SETFL, O_NONBLOCK) != -1);
+
+        for (int j = 0; j < 2; j++) {
+            context->idlers[j] = upump_alloc_idler(context->mgr,
+                    context_idler_cb, context, NULL);
+            assert(context->idlers[j] != NULL);
+            upump_start(context->idlers[j]);
+        }
+        context->reader = upump_alloc_fd_read(context->mgr, context_reader_cb,
+                                              context, NULL,
+                                              context->pipefd[0]);
+        assert(context->reader != NULL);
+        upump_start(context->reader);
+        context->timer = upump_alloc_timer(context->mgr, context_timer_cb,
+                                           context, NULL, timeout / 1000,
+                                           timeout / 1000);
+        assert(context->timer != NULL);
+        upump_start(context->timer);
+    }
+
+    ubase_assert(upump_tpool_run(tpool));
+    printf("%"PRIu64" steals\n", upump_tpool_get_steals(tpool));
+
+    for (int i = 0; i < NB_MGRS; i++) {
+        struct context *context = &contexts[i];
+        assert(context->nb_idles == NB_IDLES);
+        assert(context->nb_repeats == NB_REPEATS);
+        assert(context->nb_written);
+        assert(context->nb_read == context->nb_written);
+
+        upump_free(context->idlers[0]);
+        upump_free(context->idlers[1]);
+        upump_free(context->reader);
+        upump_free(context->timer);
+        upump_mgr_release(context->mgr);
+        uatomic_clean(&context->busy);
+        close(context->pipefd[0]);
+        close(context->pipefd[1]);
+    }
+    printf("parallel managers passed\n");
+
+    upump_tpool_release(tpool);
+    return 0;
+}
@@ -0,0 +1,422 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short benchmark of the io_uring event loop against the libev event loop
+ *
+ * A file is copied with a file source and a file sink, then a child process
+ * sends datagrams of 7 TS packets on the loopback interface as fast as it
+ * can, and a udp source pipe reads them. With io_uring, the pipes let the
+ * event loop perform the reads and writes, whereas with libev they wait for
+ * readiness before performing them. The CPU time is only accounted for the
+ * process running the event loop.
+ */
+
+#undef NDEBUG
+
+#include <upipe/uprobe.h>
+#include <upipe/uprobe_stdio.h>
+#include <upipe/uprobe_prefix.h>
+#include <upipe/uprobe_uref_mgr.h>
+#include <upipe/uprobe_upump_mgr.h>
+#include <upipe/uprobe_ubuf_mem.h>
+#include <upipe/uclock.h>
+#include <upipe/umem.h>
+#include <upipe/umem_pool.h>
+#include <upipe/udict.h>
+#include <upipe/udict_inline.h>
+#include <upipe/uref.h>
+#include <upipe/uref_std.h>
+#include <upipe/upump.h>
+#include <upump-ev/upump_ev.h>
+#include <upump-uring/upump_uring.h>
+#include <upipe/upipe.h>
+#include <upipe-modules/upipe_file_source.h>
+#include <upipe-modules/upipe_file_sink.h>
+#include <upipe-modules/upipe_udp_source.h>
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <assert.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include <ev.h>
+
+#define UMEM_POOL 512
+#define UDICT_POOL_DEPTH 500
+#define UREF_POOL_DEPTH 500
+#define UBUF_POOL_DEPTH 1100
+#define UPUMP_POOL 10
+#define UPUMP_BLOCKER_POOL 10
+#define UPROBE_LOG_LEVEL UPROBE_LOG_WARNING
+#define DGRAM_SIZE (7 * 188)
+#define DEFAULT_PACKETS 1000000
+#define DEFAULT_FILE_SIZE 256
+#define FILE_BLOCK_SIZE 65536
+#define TIMER_PERIOD (UCLOCK_FREQ / 10)
+
+static struct ev_loop *loop = NULL;
+static struct upipe *upipe_udpsrc;
+static struct upump *timer;
+static uint64_t received = 0, last_received = 0;
+static pid_t child = -1;
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_NEW_FLOW_DEF:
+        case UPROBE_SOURCE_END:
+        case UPROBE_LOG:
+            break;
+        default:
+            assert(0);
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** helper phony pipe counting datagrams */
+static struct upipe *count_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                 uint32_t signature, va_list args)
+{
+    struct upipe *upipe = malloc(sizeof(struct upipe));
+    assert(upipe != NULL);
+    upipe_init(upipe, mgr, uprobe);
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** helper phony pipe counting datagrams */
+static void count_input(struct upipe *upipe, struct uref *uref,
+                        struct upump **upump_p)
+{
+    received++;
+    uref_free(uref);
+}
+
+/** helper phony pipe counting datagrams */
+static int count_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF:
+            return UBASE_ERR_NONE;
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *urequest = va_arg(args, struct urequest *);
+            return upipe_throw_provide_request(upipe, urequest);
+        }
+        case UPIPE_UNREGISTER_REQUEST:
+            return UBASE_ERR_NONE;
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe counting datagrams */
+static void count_free(struct upipe *upipe)
+{
+    upipe_throw_dead(upipe);
+    upipe_clean(upipe);
+    free(upipe);
+}
+
+/** helper phony pipe counting datagrams */
+static struct upipe_mgr count_mgr = {
+    .refcount = NULL,
+    .signature = 0,
+    .upipe_alloc = count_alloc,
+    .upipe_input = count_input,
+    .upipe_control = count_control
+};
+
+/** sends datagrams as fast as possible, in the child process */
+static void sender(int port, unsigned int packets)
+{
+    uint8_t buffer[DGRAM_SIZE];
+    struct sockaddr_in sin;
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    assert(fd != -1);
+    memset(&sin, 0, sizeof(sin));
+    sin.sin_family = AF_INET;
+    sin.sin_port = htons(port);
+    sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    memset(buffer, 0x47, sizeof(buffer));
+
+    for (unsigned int i = 0; i < packets; i++)
+        if (sendto(fd, buffer, sizeof(buffer), 0, (struct sockaddr *)&sin,
+                   sizeof(sin)) == -1)
+            i--;
+    close(fd);
+    _exit(0);
+}
+
+/** stops the source when the sender is done and the socket is drained */
+static void check_end(struct upump *upump)
+{
+    /* the default libev loop may have reaped the child already */
+    if (child != -1 && waitpid(child, NULL, WNOHANG) != 0)
+        child = -1;
+    if (child == -1 && received == last_received) {
+        upipe_set_uri(upipe_udpsrc, NULL);
+        upump_stop(timer);
+    }
+    last_received = received;
+}
+
+/** returns the CPU time used by the process, in microseconds */
+static uint64_t cpu_time(void)
+{
+    struct rusage rusage;
+    getrusage(RUSAGE_SELF, &rusage);
+    return (uint64_t)(rusage.ru_utime.tv_sec + rusage.ru_stime.tv_sec) *
+               UINT64_C(1000000) +
+           rusage.ru_utime.tv_usec + rusage.ru_stime.tv_usec;
+}
+
+/** returns the wall clock time, in microseconds */
+static uint64_t wall_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * UINT64_C(1000000) + ts.tv_nsec / 1000;
+}
+
+/** runs the event loop of the given manager until there is no pump left */
+static void run(struct upump_mgr *upump_mgr)
+{
+    if (loop != NULL)
+        ev_loop(loop, 0);
+    else
+        ubase_assert(upump_uring_mgr_run(upump_mgr));
+}
+
+/** copies a file with a file source and a file sink */
+static void bench_file(struct uprobe *logger, struct upump_mgr *upump_mgr,
+                       const char *name, const char *src, const char *dst,
+                       uint64_t size)
+{
+    struct upipe_mgr *upipe_fsrc_mgr = upipe_fsrc_mgr_alloc();
+    struct upipe *fsrc = upipe_void_alloc(upipe_fsrc_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "file source"));
+    assert(fsrc != NULL);
+    upipe_mgr_release(upipe_fsrc_mgr);
+    ubase_assert(upipe_set_output_size(fsrc, FILE_BLOCK_SIZE));
+
+    struct upipe_mgr *upipe_fsink_mgr = upipe_fsink_mgr_alloc();
+    struct upipe *fsink = upipe_void_alloc_output(fsrc, upipe_fsink_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "file sink"));
+    assert(fsink != NULL);
+    upipe_mgr_release(upipe_fsink_mgr);
+    ubase_assert(upipe_fsink_set_path(fsink, dst, UPIPE_FSINK_OVERWRITE));
+    ubase_assert(upipe_set_uri(fsrc, src));
+
+    uint64_t start = cpu_time(), wall = wall_time();
+    run(upump_mgr);
+    uint64_t cpu = cpu_time() - start;
+    wall = wall_time() - wall;
+
+    upipe_release(fsrc);
+    upipe_release(fsink);
+
+    struct stat st;
+    assert(stat(dst, &st) == 0);
+    assert(st.st_size == size);
+    printf("%8s %6s %12"PRIu64" %10"PRIu64" %10"PRIu64" %14"PRIu64"\n",
+           name, "file", size >> 20, cpu / 1000, wall / 1000,
+           cpu ? size * UINT64_C(1000000) / cpu >> 20 : 0);
+}
+
+/** receives datagrams with a udp source */
+static void bench_udp(struct uprobe *logger, struct upump_mgr *upump_mgr,
+                      const char *name, struct upipe *count,
+                      unsigned int packets)
+{
+    struct upipe_mgr *upipe_udpsrc_mgr = upipe_udpsrc_mgr_alloc();
+    upipe_udpsrc = upipe_void_alloc(upipe_udpsrc_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "udp source"));
+    assert(upipe_udpsrc != NULL);
+    upipe_mgr_release(upipe_udpsrc_mgr);
+    ubase_assert(upipe_set_output(upipe_udpsrc, count));
+    ubase_assert(upipe_set_output_size(upipe_udpsrc, DGRAM_SIZE));
+
+    char uri[64];
+    int port, i;
+    for (i = 0; i < 10; i++) {
+        port = (rand() % 40000) + 1024;
+        snprintf(uri, sizeof(uri), "@127.0.0.1:%d", port);
+        if (ubase_check(upipe_set_uri(upipe_udpsrc, uri)))
+            break;
+    }
+    assert(i < 10);
+
+    received = last_received = 0;
+    child = fork();
+    assert(child != -1);
+    if (child == 0)
+        sender(port, packets);
+
+    timer = upump_alloc_timer(upump_mgr, check_end, NULL, NULL,
+                              TIMER_PERIOD, TIMER_PERIOD);
+    assert(timer != NULL);
+    upump_start(timer);
+
+    uint64_t start = cpu_time(), wall = wall_time();
+    run(upump_mgr);
+    uint64_t cpu = cpu_time() - start;
+    wall = wall_time() - wall;
+
+    printf("%8s %6s %12"PRIu64" %10"PRIu64" %10"PRIu64" %14"PRIu64"\n",
+           name, "udp", received, cpu / 1000, wall / 1000,
+           cpu ? received * UINT64_C(1000000) / cpu : 0);
+
+    upump_free(timer);
+    upipe_release(upipe_udpsrc);
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stdout, "Usage: %s [-n <packets>] [-s <file size in MiB>]\n",
+            argv0);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int packets = DEFAULT_PACKETS;
+    uint64_t file_size = DEFAULT_FILE_SIZE;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+        switch (opt) {
+            case 'n':
+                packets = strtoul(optarg, NULL, 10);
+                break;
+            case 's':
+                file_size = strtoull(optarg, NULL, 10);
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+    file_size <<= 20;
+
+    /* create the file to copy, and warm up the page cache */
+    char src[] = "/tmp/upump_uring_bench_src_XXXXXX";
+    char dst[] = "/tmp/upump_uring_bench_dst_XXXXXX";
+    int fd = mkstemp(src);
+    assert(fd != -1);
+    uint8_t block[FILE_BLOCK_SIZE];
+    for (unsigned int i = 0; i < sizeof(block); i++)
+        block[i] = i * 7;
+    for (uint64_t i = 0; i < file_size; i += sizeof(block))
+        assert(write(fd, block, sizeof(block)) == sizeof(block));
+    close(fd);
+    fd = mkstemp(dst);
+    assert(fd != -1);
+    close(fd);
+
+    struct umem_mgr *umem_mgr = umem_pool_mgr_alloc_simple(UMEM_POOL);
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH,
+                                                   udict_mgr, 0);
+    assert(uref_mgr != NULL);
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+    logger = uprobe_uref_mgr_alloc(logger, uref_mgr);
+    assert(logger != NULL);
+    logger = uprobe_ubuf_mem_alloc(logger, umem_mgr, UBUF_POOL_DEPTH,
+                                   UBUF_POOL_DEPTH);
+    assert(logger != NULL);
+
+    struct upipe *count = upipe_void_alloc(&count_mgr, uprobe_use(logger));
+    assert(count != NULL);
+
+    printf("%8s %6s %12s %10s %10s %14s\n", "loop", "test", "MiB/dgrams",
+           "cpu (ms)", "wall (ms)", "per s per core");
+    srand(getpid());
+    for (int i = 0; i < 2; i++) {
+        const char *name;
+        struct upump_mgr *upump_mgr;
+        if (i == 0) {
+            name = "libev";
+            loop = ev_default_loop(0);
+            upump_mgr = upump_ev_mgr_alloc(loop, UPUMP_POOL,
+                                           UPUMP_BLOCKER_POOL);
+        } else {
+            name = "io_uring";
+            loop = NULL;
+            upump_mgr = upump_uring_mgr_alloc(0, UPUMP_POOL,
+                                              UPUMP_BLOCKER_POOL);
+            if (upump_mgr == NULL) {
+                printf("%8s not supported\n", name);
+                break;
+            }
+        }
+        assert(upump_mgr != NULL);
+        struct uprobe *uprobe_upump =
+            uprobe_upump_mgr_alloc(uprobe_use(logger), upump_mgr);
+        assert(uprobe_upump != NULL);
+
+        bench_file(uprobe_upump, upump_mgr, name, src, dst, file_size);
+        bench_udp(uprobe_upump, upump_mgr, name, count, packets);
+
+        uprobe_release(uprobe_upump);
+        upump_mgr_release(upump_mgr);
+    }
+
+    unlink(src);
+    unlink(dst);
+    count_free(count);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+
+    ev_default_destroy();
+    return 0;
+}
@@ -0,0 +1,275 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for upump manager with io_uring event loop
+ */
+
+#undef NDEBUG
+
+#include <upipe/upump.h>
+#include <upipe/upump_blocker.h>
+#include <upump-uring/upump_uring.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <assert.h>
+#include <sys/uio.h>
+
+#define UPUMP_POOL 1
+#define UPUMP_BLOCKER_POOL 1
+
+static uint64_t timeout = UINT64_C(27000000); /* 1 s */
+static const char *padding = "This is an initialized bit of space used to pad sufficiently !";
+/* This is an arbitrarily large number that is just supposed to be bigger than
+ * the buffer space of a pipe. */
+#define MIN_READ (128*1024)
+/* number of messages exchanged through I/O pumps */
+#define NB_MESSAGES 100
+
+static int pipefd[2];
+static struct upump_mgr *mgr;
+static struct upump *write_idler;
+static struct upump *read_timer;
+static struct upump *write_watcher;
+static struct upump *read_watcher;
+static struct upump_blocker *blocker = NULL;
+static ssize_t bytes_written = 0, bytes_read = 0;
+
+static struct upump *write_io;
+static struct upump *read_io;
+static struct upump *repeat_timer;
+static struct upump_io write_desc, read_desc;
+static struct iovec write_iovec, read_iovec;
+static char read_buffer[128];
+static unsigned int nb_written = 0, nb_read = 0, nb_repeats = 0;
+static struct upump *guard_timer;
+
+static void blocker_cb(struct upump_blocker *blocker)
+{
+    upump_blocker_free(blocker);
+}
+
+static void write_idler_cb(struct upump *upump)
+{
+    ssize_t ret = write(pipefd[1], padding, strlen(padding) + 1);
+    if (ret == -1 && (errno == EWOULDBLOCK || errno == EAGAIN)) {
+        printf("write idler blocked\n");
+        blocker = upump_blocker_alloc(write_idler, blocker_cb, NULL, NULL);
+        assert(blocker != NULL);
+        upump_start(write_watcher);
+        upump_start(read_timer);
+    } else {
+        assert(ret != -1);
+        bytes_written += ret;
+    }
+}
+
+static void write_watcher_cb(struct upump *unused)
+{
+    printf("write watcher passed\n");
+    upump_blocker_free(blocker);
+    upump_stop(write_watcher);
+}
+
+static void read_timer_cb(struct upump *unused)
+{
+    printf("read timer passed\n");
+    upump_start(read_watcher);
+    /* The timer is automatically stopped */
+}
+
+static void read_watcher_cb(struct upump *unused)
+{
+    char buffer[strlen(padding) + 1];
+    ssize_t ret = read(pipefd[0], buffer, strlen(padding) + 1);
+    assert(ret != -1);
+    bytes_read += ret;
+    if (bytes_read > MIN_READ) {
+        printf("read watcher passed\n");
+        upump_stop(write_idler);
+        upump_stop(read_watcher);
+    }
+}
+
+static void write_io_cb(struct upump *upump)
+{
+    assert(write_desc.ret == strlen(padding) + 1);
+    if (++nb_written == NB_MESSAGES)
+        printf("write I/O passed\n");
+    /* wait for the reader, so that messages are not merged */
+    upump_stop(upump);
+}
+
+static void read_io_cb(struct upump *upump)
+{
+    assert(read_desc.ret == strlen(padding) + 1);
+    assert(!strcmp(read_buffer, padding));
+    memset(read_buffer, 0, sizeof(read_buffer));
+    if (++nb_read == NB_MESSAGES) {
+        printf("read I/O passed\n");
+        upump_stop(upump);
+    } else
+        upump_start(write_io);
+}
+
+static void repeat_timer_cb(struct upump *upump)
+{
+    if (++nb_repeats == 3) {
+        printf("repeat timer passed\n");
+        upump_stop(upump);
+    }
+}
+
+static void free_timer_cb(struct upump *upump)
+{
+    /* nothing was written, the read is still in flight */
+    printf("free timer passed\n");
+    upump_free(read_io);
+    read_io = NULL;
+}
+
+static void reread_io_cb(struct upump *upump)
+{
+    /* the cancelled read did not steal the message */
+    assert(read_desc.ret == strlen(padding) + 1);
+    assert(!strcmp(read_buffer, padding));
+    printf("cancelled read passed\n");
+    nb_read++;
+    upump_stop(upump);
+    upump_stop(guard_timer);
+}
+
+static void guard_timer_cb(struct upump *upump)
+{
+    upump_stop(read_io);
+}
+
+int main(int argc, char **argv)
+{
+    long flags;
+    mgr = upump_uring_mgr_alloc(0, UPUMP_POOL, UPUMP_BLOCKER_POOL);
+    if (mgr == NULL) {
+        printf("io_uring is not supported\n");
+        return 77;
+    }
+
+    /* Create a pipe with non-blocking write */
+    assert(pipe(pipefd) != -1);
+    flags = fcntl(pipefd[1], F_GETFL);
+    assert(flags != -1);
+    flags |= O_NONBLOCK;
+    assert(fcntl(pipefd[1], F_SETFL, flags) != -1);
+
+    /* Create watchers */
+    write_idler = upump_alloc_idler(mgr, write_idler_cb, NULL, NULL);
+    assert(write_idler != NULL);
+    write_watcher = upump_alloc_fd_write(mgr, write_watcher_cb, NULL, NULL,
+                                         pipefd[1]);
+    assert(write_watcher != NULL);
+    read_timer = upump_alloc_timer(mgr, read_timer_cb, NULL, NULL, timeout, 0);
+    assert(read_timer != NULL);
+    read_watcher = upump_alloc_fd_read(mgr, read_watcher_cb, NULL, NULL,
+                                       pipefd[0]);
+    assert(read_watcher != NULL);
+
+    /* Start tests */
+    upump_start(write_idler);
+    ubase_assert(upump_uring_mgr_run(mgr));
+    assert(bytes_read);
+    assert(bytes_read == bytes_written);
+
+    /* Test I/O pumps performed by the event loop */
+    write_iovec.iov_base = (void *)padding;
+    write_iovec.iov_len = strlen(padding) + 1;
+    write_desc.type = UPUMP_IO_WRITE;
+    write_desc.fd = pipefd[1];
+    write_desc.iovecs = &write_iovec;
+    write_desc.iovec_count = 1;
+    write_desc.offset = -1;
+    write_io = upump_alloc_io(mgr, write_io_cb, NULL, NULL, &write_desc);
+    assert(write_io != NULL);
+
+    read_iovec.iov_base = read_buffer;
+    read_iovec.iov_len = sizeof(read_buffer);
+    read_desc.type = UPUMP_IO_READ;
+    read_desc.fd = pipefd[0];
+    read_desc.iovecs = &read_iovec;
+    read_desc.iovec_count = 1;
+    read_desc.offset = -1;
+    read_io = upump_alloc_io(mgr, read_io_cb, NULL, NULL, &read_desc);
+    assert(read_io != NULL);
+
+    repeat_timer = upump_alloc_timer(mgr, repeat_timer_cb, NULL, NULL,
+                                     timeout / 100, timeout / 100);
+    assert(repeat_timer != NULL);
+
+    upump_start(read_io);
+    upump_start(write_io);
+    upump_start(repeat_timer);
+    ubase_assert(upump_uring_mgr_run(mgr));
+    assert(nb_written == NB_MESSAGES);
+    assert(nb_read == NB_MESSAGES);
+    assert(nb_repeats == 3);
+
+    /* Free a pump while its operation is in flight */
+    struct upump *free_timer = upump_alloc_timer(mgr, free_timer_cb, NULL,
+                                                 NULL, timeout / 100, 0);
+    assert(free_timer != NULL);
+    upump_start(read_io);
+    upump_start(free_timer);
+    ubase_assert(upump_uring_mgr_run(mgr));
+    assert(read_io == NULL);
+    assert(nb_read == NB_MESSAGES);
+
+    /* The next read gets the next message */
+    read_io = upump_alloc_io(mgr, reread_io_cb, NULL, NULL, &read_desc);
+    assert(read_io != NULL);
+    guard_timer = upump_alloc_timer(mgr, guard_timer_cb, NULL, NULL,
+                                    timeout, 0);
+    assert(guard_timer != NULL);
+    assert(write(pipefd[1], padding, strlen(padding) + 1) ==
+           strlen(padding) + 1);
+    upump_start(read_io);
+    upump_start(guard_timer);
+    ubase_assert(upump_uring_mgr_run(mgr));
+    assert(nb_read == NB_MESSAGES + 1);
+
+    /* Clean up */
+    upump_free(write_idler);
+    upump_free(write_watcher);
+    upump_free(read_timer);
+    upump_free(read_watcher);
+    upump_free(write_io);
+    upump_free(repeat_timer);
+    upump_free(free_timer);
+    upump_free(read_io);
+    upump_free(guard_timer);
+    upump_mgr_release(mgr);
+    close(pipefd[0]);
+    close(pipefd[1]);
+    return 0;
+}
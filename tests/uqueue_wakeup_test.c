@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short unit tests for the coalescing of uqueue wakeups
+ *
+ * A producer thread hands off buffers of 7 TS packets at 40 Mbps to a
+ * consumer thread, which waits on the uqueue the way upipe_qsrc does, with
+ * a timer bounding the latency. The eventfd system calls are counted with
+ * and without a wakeup threshold.
+ */
+
+#undef NDEBUG
+
+#include <upipe/ubase.h>
+#include <upipe/uatomic.h>
+#include <upipe/uqueue.h>
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <poll.h>
+#include <time.h>
+
+#define UQUEUE_LENGTH 255
+#define NB_BUFFERS 1000
+/* 7 TS packets at 40 Mbps */
+#define BUFFER_PERIOD_NS (UINT64_C(1000000000) * 7 * 188 * 8 / 40000000)
+#define POP_BATCH 32
+#define THRESHOLD 32
+#define LATENCY_MS 20
+#define MAX_ATTEMPTS 5
+
+static uatomic_uint32_t syscalls;
+static struct uqueue uqueue;
+
+static void *push_thread(void *unused)
+{
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    for (uintptr_t i = 1; i <= NB_BUFFERS; i++) {
+        next.tv_nsec += BUFFER_PERIOD_NS;
+        if (next.tv_nsec >= 1000000000) {
+            next.tv_nsec -= 1000000000;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+        while (!uqueue_push(&uqueue, (void *)i))
+            sched_yield();
+    }
+    return NULL;
+}
+
+static unsigned int run(unsigned int threshold, int timeout)
+{
+    uint8_t extra[uqueue_sizeof(UQUEUE_LENGTH)];
+    assert(uqueue_init(&uqueue, UQUEUE_LENGTH, extra));
+    if (threshold > 1)
+        uqueue_set_threshold(&uqueue, threshold);
+    uatomic_store(&syscalls, 0);
+    ueventfd_set_syscalls(&uqueue.event_push, &syscalls);
+    ueventfd_set_syscalls(&uqueue.event_pop, &syscalls);
+
+    pthread_t id;
+    assert(pthread_create(&id, NULL, push_thread, NULL) == 0);
+
+    struct pollfd pollfd;
+    pollfd.fd = uqueue.event_pop.mode == UEVENTFD_MODE_EVENTFD ?
+                uqueue.event_pop.event_fd : uqueue.event_pop.pipe_fds[0];
+    pollfd.events = POLLIN;
+    uintptr_t expected = 1;
+    while (expected <= NB_BUFFERS) {
+        int ret = poll(&pollfd, 1, timeout);
+        assert(ret != -1);
+        /* like upipe_qsrc, do not touch an empty queue on timeouts */
+        if (!ret && !uqueue_length(&uqueue))
+            continue;
+
+        void *elements[POP_BATCH];
+        unsigned int nb = uqueue_pop_batch(&uqueue, elements, POP_BATCH);
+        for (unsigned int i = 0; i < nb; i++)
+            assert((uintptr_t)elements[i] == expected++);
+    }
+
+    assert(!pthread_join(id, NULL));
+    assert(uqueue_pop(&uqueue, void *) == NULL);
+    uqueue_clean(&uqueue);
+    return uatomic_load(&syscalls);
+}
+
+int main(int argc, char **argv)
+{
+    uatomic_init(&syscalls, 0);
+    /* the plain count drops when the consumer lags behind (on a loaded
+     * machine), so retry a few times */
+    unsigned int plain, coalesced;
+    for (int i = 0; i < MAX_ATTEMPTS; i++) {
+        plain = run(1, -1);
+        coalesced = run(THRESHOLD, LATENCY_MS);
+        printf("eventfd system calls for %u buffers: %u, %u coalesced\n",
+               NB_BUFFERS, plain, coalesced);
+        if (plain >= 5 * coalesced)
+            break;
+    }
+    uatomic_clean(&syscalls);
+
+    assert(plain >= 5 * coalesced);
+    return 0;
+}
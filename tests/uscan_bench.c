@@ -0,0 +1,200 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short benchmark of sync word and start code scanning functions
+ *
+ * The vectorised and portable implementations are run on synthetic
+ * buffers: a corrupted transport stream with stray sync words, and an
+ * elementary stream with a start code every few kilobytes. Elementary
+ * stream files given on the command line are also scanned for start codes.
+ */
+
+#undef NDEBUG
+
+#include <upipe/ubase.h>
+#include <upipe/uscan.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <assert.h>
+#include <time.h>
+
+#define BUFFER_SIZE (4 * 1024 * 1024)
+#define DEFAULT_LOOPS 50
+#define TS_SIZE 188
+#define TS_SYNC 0x47
+#define NB_SYNC 3
+#define SLICE_SIZE 4096
+
+/** returns the monotonic time in nanoseconds */
+static uint64_t now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * UINT64_C(1000000000) + ts.tv_nsec;
+}
+
+/** counts the start codes in a buffer */
+static unsigned int count_start_codes(const uint8_t *buffer, size_t size,
+        size_t (*scan)(const uint8_t *, size_t))
+{
+    unsigned int count = 0;
+    size_t offset = 0;
+    for ( ; ; ) {
+        offset += scan(buffer + offset, size - offset);
+        if (offset >= size)
+            break;
+        count++;
+        offset += 3;
+    }
+    return count;
+}
+
+/** prints the throughput of start code scanning on a buffer */
+static void bench_start_codes(const char *name, const uint8_t *buffer,
+                              size_t size, unsigned int loops)
+{
+    size_t (*scans[])(const uint8_t *, size_t) = {
+        uscan_start_code_c, uscan_start_code
+    };
+    uint64_t durations[2];
+    unsigned int counts[2];
+    for (int i = 0; i < 2; i++) {
+        uint64_t start = now();
+        for (unsigned int j = 0; j < loops; j++)
+            counts[i] = count_start_codes(buffer, size, scans[i]);
+        durations[i] = now() - start;
+    }
+    assert(counts[0] == counts[1]);
+    printf("%-24s %10u %12.2f %12.2f\n", name, counts[0],
+           (double)size * loops / durations[0],
+           (double)size * loops / durations[1]);
+}
+
+/** prints the throughput of periodic sync word scanning on a buffer */
+static void bench_sync(const char *name, const uint8_t *buffer, size_t size,
+                       unsigned int loops)
+{
+    size_t (*scans[])(const uint8_t *, size_t, uint8_t, size_t,
+                      unsigned int) = {
+        uscan_sync_c, uscan_sync
+    };
+    uint64_t durations[2];
+    size_t offsets[2];
+    for (int i = 0; i < 2; i++) {
+        uint64_t start = now();
+        for (unsigned int j = 0; j < loops; j++)
+            offsets[i] = scans[i](buffer, size, TS_SYNC, TS_SIZE, NB_SYNC);
+        durations[i] = now() - start;
+    }
+    assert(offsets[0] == offsets[1]);
+    printf("%-24s %10zu %12.2f %12.2f\n", name, offsets[0],
+           (double)size * loops / durations[0],
+           (double)size * loops / durations[1]);
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stdout, "Usage: %s [-n <loops>] [<file.es> ...]\n", argv0);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int loops = DEFAULT_LOOPS;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+            case 'n':
+                loops = strtoul(optarg, NULL, 10);
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+
+    uint8_t *buffer = malloc(BUFFER_SIZE);
+    assert(buffer != NULL);
+    srand(42);
+
+    printf("%-24s %10s %12s %12s\n", "buffer", "found", "C (GB/s)",
+           "SIMD (GB/s)");
+
+    /* corrupted transport streams with stray sync words */
+    unsigned int densities[] = { 256, 32, 4 };
+    for (int i = 0; i < UBASE_ARRAY_SIZE(densities); i++) {
+        for (size_t j = 0; j < BUFFER_SIZE; j++)
+            buffer[j] = rand() % densities[i] ? 0 : TS_SYNC;
+        for (size_t j = TS_SIZE; j < BUFFER_SIZE; j++)
+            if (buffer[j] == TS_SYNC && buffer[j - TS_SIZE] == TS_SYNC)
+                buffer[j] = 0;
+        char name[32];
+        snprintf(name, sizeof(name), "ts sync 1/%u", densities[i]);
+        bench_sync(name, buffer, BUFFER_SIZE, loops);
+    }
+
+    /* elementary streams with emulation prevention */
+    unsigned int zeros[] = { 256, 16 };
+    for (int i = 0; i < UBASE_ARRAY_SIZE(zeros); i++) {
+        for (size_t j = 0; j < BUFFER_SIZE; j++) {
+            buffer[j] = rand() % zeros[i] ? rand() : 0;
+            if (j >= 2 && !buffer[j - 1] && !buffer[j - 2] && buffer[j] <= 3)
+                buffer[j] = 3;
+        }
+        for (size_t j = 0; j + 4 <= BUFFER_SIZE; j += SLICE_SIZE) {
+            buffer[j] = buffer[j + 1] = 0;
+            buffer[j + 2] = 1;
+            buffer[j + 3] = 0x65;
+        }
+        char name[32];
+        snprintf(name, sizeof(name), "es zeros 1/%u", zeros[i]);
+        bench_start_codes(name, buffer, BUFFER_SIZE, loops);
+    }
+    free(buffer);
+
+    for (int i = optind; i < argc; i++) {
+        FILE *file = fopen(argv[i], "rb");
+        if (file == NULL) {
+            fprintf(stderr, "unable to open %s\n", argv[i]);
+            continue;
+        }
+        fseek(file, 0, SEEK_END);
+        long size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+        buffer = malloc(size);
+        assert(buffer != NULL);
+        assert(fread(buffer, 1, size, file) == size);
+        fclose(file);
+
+        const char *name = strrchr(argv[i], '/');
+        bench_start_codes(name != NULL ? name + 1 : argv[i], buffer, size,
+                          loops);
+        free(buffer);
+    }
+    return 0;
+}
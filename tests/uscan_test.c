@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for sync word and start code scanning functions
+ */
+
+#undef NDEBUG
+
+#include <upipe/uscan.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#define SYNC 0x47
+#define BUFFER_SIZE 8192
+#define NB_LOOPS 2000
+
+/** reference implementation, checking every offset */
+static size_t scan_ref(const uint8_t *buffer, size_t size, size_t stride,
+                       unsigned int count)
+{
+    for (size_t offset = 0; offset < size; offset++) {
+        unsigned int i;
+        for (i = 0; i < count && offset + i * stride < size; i++)
+            if (buffer[offset + i * stride] != SYNC)
+                break;
+        if (i == count || offset + i * stride >= size)
+            return offset;
+    }
+    return size;
+}
+
+/** reference implementation of start code scanning */
+static size_t start_code_ref(const uint8_t *buffer, size_t size)
+{
+    for (size_t offset = 0; offset + 3 <= size; offset++)
+        if (!buffer[offset] && !buffer[offset + 1] && buffer[offset + 2] == 1)
+            return offset;
+    return size;
+}
+
+static void check_start_code(const uint8_t *buffer, size_t size)
+{
+    size_t ref = start_code_ref(buffer, size);
+    assert(uscan_start_code_c(buffer, size) == ref);
+    assert(uscan_start_code(buffer, size) == ref);
+}
+
+static void check(const uint8_t *buffer, size_t size, size_t stride,
+                  unsigned int count)
+{
+    size_t ref = scan_ref(buffer, size, stride, count);
+    assert(uscan_sync_c(buffer, size, SYNC, stride, count) == ref);
+    assert(uscan_sync(buffer, size, SYNC, stride, count) == ref);
+}
+
+int main(int argc, char **argv)
+{
+    uint8_t *buffer = malloc(BUFFER_SIZE);
+    assert(buffer != NULL);
+
+    /* no sync word */
+    memset(buffer, 0, BUFFER_SIZE);
+    assert(uscan_sync(buffer, BUFFER_SIZE, SYNC, 188, 3) == BUFFER_SIZE);
+    assert(uscan_sync(buffer, BUFFER_SIZE, SYNC, 188, 1) == BUFFER_SIZE);
+
+    /* aligned stream */
+    for (size_t i = 0; i < BUFFER_SIZE; i += 188)
+        buffer[i + 5] = SYNC;
+    assert(uscan_sync(buffer, BUFFER_SIZE, SYNC, 188, 3) == 5);
+    assert(uscan_sync(buffer + 6, BUFFER_SIZE - 6, SYNC, 188, 3) == 187);
+    /* partially validated candidate */
+    assert(uscan_sync(buffer + 6, 188 * 2, SYNC, 188, 3) == 187);
+    assert(uscan_sync(buffer + 6, 181, SYNC, 188, 3) == 181);
+
+    /* spurious sync words before the stream */
+    memset(buffer, 0, BUFFER_SIZE);
+    for (size_t i = 0; i < 1000; i += 33)
+        buffer[i] = SYNC;
+    for (size_t i = 1001; i < BUFFER_SIZE; i += 204)
+        buffer[i] = SYNC;
+    check(buffer, BUFFER_SIZE, 204, 5);
+    assert(uscan_sync(buffer, BUFFER_SIZE, SYNC, 204, 5) == 1001);
+
+    /* random buffers with varying densities of sync words */
+    srand(42);
+    for (int loop = 0; loop < NB_LOOPS; loop++) {
+        size_t size = rand() % BUFFER_SIZE;
+        size_t stride = 1 + rand() % 300;
+        unsigned int count = 1 + rand() % 8;
+        int density = 1 + rand() % 4;
+        for (size_t i = 0; i < size; i++)
+            buffer[i] = rand() % density ? 0 : SYNC;
+        check(buffer, size, stride, count);
+        check(buffer + 1, size ? size - 1 : 0, stride, count);
+    }
+
+    /* start codes */
+    memset(buffer, 0xff, BUFFER_SIZE);
+    assert(uscan_start_code(buffer, BUFFER_SIZE) == BUFFER_SIZE);
+    buffer[1000] = buffer[1001] = 0;
+    buffer[1002] = 1;
+    assert(uscan_start_code(buffer, BUFFER_SIZE) == 1000);
+    assert(uscan_start_code(buffer, 1003) == 1000);
+    assert(uscan_start_code(buffer, 1002) == 1002);
+    assert(uscan_start_code(buffer + 1001, BUFFER_SIZE - 1001) ==
+           BUFFER_SIZE - 1001);
+
+    /* random buffers with varying densities of zeros and ones */
+    for (int loop = 0; loop < NB_LOOPS; loop++) {
+        size_t size = rand() % BUFFER_SIZE;
+        int density = 2 + rand() % 16;
+        for (size_t i = 0; i < size; i++) {
+            int r = rand() % density;
+            buffer[i] = r < 2 ? r : 0x80;
+        }
+        check_start_code(buffer, size);
+        check_start_code(buffer + 1, size ? size - 1 : 0);
+    }
+
+    free(buffer);
+    return 0;
+}
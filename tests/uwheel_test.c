@@ -0,0 +1,197 @@
+/*
+ * Copyright (C) 2026 Upipe contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for uwheel
+ */
+
+#undef NDEBUG
+
+#include <upipe/ubase.h>
+#include <upipe/uwheel.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#define RESOLUTION 1000
+#define NB_TIMERS 10000
+#define NB_STEPS 3000
+
+static struct uwheel wheel;
+static struct uwheel_timer timers[NB_TIMERS];
+static bool late[NB_TIMERS];
+static uint64_t now;
+static bool rearm = true;
+static unsigned int nb_fired = 0;
+
+/* returns the first date at which a deadline may expire */
+static uint64_t expiry(uint64_t deadline)
+{
+    return (deadline + RESOLUTION - 1) / RESOLUTION * RESOLUTION;
+}
+
+static uint64_t random_delay(void)
+{
+    switch (rand() % 4) {
+        case 0:
+            return rand() % (4 * RESOLUTION);
+        case 1:
+            return rand() % (4096 * RESOLUTION);
+        case 2:
+            return (uint64_t)rand() * RESOLUTION;
+        default:
+            /* beyond the last level */
+            return ((uint64_t)1 << 37) * RESOLUTION + rand();
+    }
+}
+
+/* arms a timer, which expires in the next tick if it is already late */
+static void arm(struct uwheel_timer *timer, uint64_t deadline)
+{
+    uwheel_arm(&wheel, timer, deadline);
+    late[timer - timers] = expiry(deadline) <= now;
+}
+
+static void timer_cb(struct uwheel_timer *timer)
+{
+    assert(!uwheel_timer_armed(timer));
+    assert(expiry(timer->deadline) <= now);
+    nb_fired++;
+    late[timer - timers] = false;
+    if (!rearm)
+        return;
+
+    /* re-arm some timers, possibly in the past, and cancel others */
+    switch (rand() % 4) {
+        case 0:
+            arm(timer, now + random_delay());
+            break;
+        case 1:
+            arm(timer, now - RESOLUTION);
+            break;
+        case 2:
+            uwheel_cancel(&wheel, &timers[rand() % NB_TIMERS]);
+            break;
+        default:
+            break;
+    }
+}
+
+static void check(void)
+{
+    unsigned int nb_armed = 0;
+    uint64_t first = UINT64_MAX;
+    for (unsigned int i = 0; i < NB_TIMERS; i++) {
+        if (!uwheel_timer_armed(&timers[i]))
+            continue;
+        nb_armed++;
+        /* no expired timer may be left behind */
+        uint64_t date = expiry(timers[i].deadline);
+        if (late[i]) {
+            assert(date <= now);
+            date = (now / RESOLUTION + 1) * RESOLUTION;
+        } else
+            assert(date > now);
+        if (date < first)
+            first = date;
+    }
+    assert(nb_armed == wheel.nb_timers);
+    uint64_t next = uwheel_next(&wheel);
+    if (!nb_armed)
+        assert(next == UINT64_MAX);
+    else
+        assert(next <= first);
+}
+
+int main(int argc, char **argv)
+{
+    now = (UINT64_C(1) << 30) * RESOLUTION;
+    uwheel_init(&wheel, RESOLUTION, now);
+    assert(uwheel_next(&wheel) == UINT64_MAX);
+
+    /* a deadline in the past expires at once, a deadline in the current
+     * tick at the end of the tick */
+    uwheel_timer_init(&timers[0], timer_cb);
+    uwheel_arm(&wheel, &timers[0], now - 1);
+    uwheel_timer_init(&timers[1], timer_cb);
+    uwheel_arm(&wheel, &timers[1], now + 1);
+    assert(uwheel_next(&wheel) == now);
+    srand(0);
+    assert(uwheel_expire(&wheel, now) == 1);
+    assert(uwheel_timer_armed(&timers[1]));
+    uwheel_cancel(&wheel, &timers[1]);
+    uwheel_cancel(&wheel, &timers[0]);
+    assert(!wheel.nb_timers);
+    now += RESOLUTION;
+    assert(!uwheel_expire(&wheel, now));
+
+    for (unsigned int i = 0; i < NB_TIMERS; i++) {
+        uwheel_timer_init(&timers[i], timer_cb);
+        arm(&timers[i], now + random_delay());
+    }
+    check();
+
+    for (unsigned int step = 0; step < NB_STEPS; step++) {
+        switch (rand() % 8) {
+            case 0:
+                now += (uint64_t)rand() % (1 << 20) * RESOLUTION;
+                break;
+            case 1:
+                now = uwheel_next(&wheel);
+                break;
+            default:
+                now += rand() % (3 * RESOLUTION);
+                break;
+        }
+        uwheel_expire(&wheel, now);
+        check();
+
+        unsigned int i = rand() % NB_TIMERS;
+        if (rand() % 2)
+            uwheel_cancel(&wheel, &timers[i]);
+        else
+            arm(&timers[i], now + random_delay());
+        check();
+    }
+    printf("%u timers expired\n", nb_fired);
+    assert(nb_fired > NB_TIMERS / 2);
+
+    /* following uwheel_next, every timer eventually expires */
+    rearm = false;
+    nb_fired = 0;
+    for (unsigned int i = 0; i < NB_TIMERS; i++)
+        arm(&timers[i], now + random_delay());
+    unsigned int nb_wakeups = 0;
+    while (wheel.nb_timers) {
+        now = uwheel_next(&wheel);
+        uwheel_expire(&wheel, now);
+        nb_wakeups++;
+    }
+    assert(nb_fired == NB_TIMERS);
+    assert(uwheel_next(&wheel) == UINT64_MAX);
+    printf("%u wake-ups\n", nb_wakeups);
+    return 0;
+}